@@ -37,6 +37,17 @@ def google_cloud_cpp_deps():
             sha256 = "8d9aa381a6885fe480b7d0ce8ef747a0b8c6ee92f99d74ab07e3503434007cb0",
         )
 
+    # Load Google Benchmark, used by the microbenchmarks.
+    if "com_github_google_benchmark" not in native.existing_rules():
+        http_archive(
+            name = "com_github_google_benchmark",
+            strip_prefix = "benchmark-1.5.0",
+            urls = [
+                "https://github.com/google/benchmark/archive/v1.5.0.tar.gz",
+            ],
+            sha256 = "3c6a165b6ecc948967a1ead710d4a181d7b0fbcaa183ef7ea84604994966221a",
+        )
+
     # Load the googleapis dependency.
     if "com_google_googleapis" not in native.existing_rules():
         http_archive(
@@ -41,6 +41,12 @@ cmake -H. -Bcmake-out \
 cmake --build cmake-out --target install
 ```
 
+The microbenchmarks use
+[Google Benchmark](https://github.com/google/benchmark), which is seldom
+installed. When it is not found the microbenchmarks are skipped, add
+`-DGOOGLE_CLOUD_CPP_BENCHMARK_PROVIDER=external` to download and compile it.
+The instructions below use this option.
+
 Unfortunately getting your system to this state may require multiple steps,
 the following sections describe how to install `google-cloud-cpp` on several
 platforms.
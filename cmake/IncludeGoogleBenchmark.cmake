@@ -0,0 +1,40 @@
+# ~~~
+# Copyright 2019 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ~~~
+
+# Google Benchmark always requires thread support.
+find_package(Threads REQUIRED)
+
+# Configure the Google Benchmark dependency, this can be found as an external
+# project or as a package. It is only used by the microbenchmarks, and few
+# systems have it installed: with the "package" provider the microbenchmarks are
+# skipped if the package is not found, instead of failing the configuration.
+set(GOOGLE_CLOUD_CPP_BENCHMARK_PROVIDER ${GOOGLE_CLOUD_CPP_DEPENDENCY_PROVIDER}
+    CACHE STRING "How to find the Google Benchmark library")
+set_property(CACHE GOOGLE_CLOUD_CPP_BENCHMARK_PROVIDER
+             PROPERTY STRINGS "external" "package")
+
+if (TARGET benchmark::benchmark)
+    # benchmark::benchmark is already defined, do not define it again.
+elseif("${GOOGLE_CLOUD_CPP_BENCHMARK_PROVIDER}" STREQUAL "external")
+    include(external/benchmark)
+elseif("${GOOGLE_CLOUD_CPP_BENCHMARK_PROVIDER}" STREQUAL "package")
+    find_package(benchmark CONFIG QUIET)
+    if (NOT benchmark_FOUND)
+        message(STATUS "Google Benchmark not found, the microbenchmarks are"
+                       " disabled. Set GOOGLE_CLOUD_CPP_BENCHMARK_PROVIDER to"
+                       " \"external\" to download and compile it.")
+    endif ()
+endif ()
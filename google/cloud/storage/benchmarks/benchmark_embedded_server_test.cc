@@ -0,0 +1,243 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/benchmarks/embedded_server.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include "google/cloud/testing_util/environment_variable_restore.h"
+#include <gmock/gmock.h>
+#include <thread>
+#if !_WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif  // !_WIN32
+
+namespace google {
+namespace cloud {
+namespace storage_benchmarks {
+namespace {
+
+namespace gcs = google::cloud::storage;
+using ::testing::ElementsAre;
+
+TEST(EmbeddedServer, WaitAndShutdown) {
+  auto server = CreateEmbeddedServer();
+  EXPECT_THAT(server->endpoint(), ::testing::StartsWith("http://127.0.0.1:"));
+
+  std::thread wait_thread([&server]() { server->Wait(); });
+  EXPECT_TRUE(wait_thread.joinable());
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_TRUE(wait_thread.joinable());
+  server->Shutdown();
+  wait_thread.join();
+}
+
+class EmbeddedServerTest : public ::testing::Test {
+ protected:
+  EmbeddedServerTest() : endpoint_("CLOUD_STORAGE_TESTBENCH_ENDPOINT") {}
+
+  void SetUp() override {
+    endpoint_.SetUp();
+    scoped_.reset(new ScopedEmbeddedServer);
+  }
+
+  void TearDown() override {
+    scoped_.reset();
+    endpoint_.TearDown();
+  }
+
+  EmbeddedServer& server() { return scoped_->server(); }
+
+  gcs::Client MakeClient() {
+    auto options = gcs::ClientOptions::CreateDefaultClientOptions();
+    EXPECT_STATUS_OK(options);
+    EXPECT_EQ(server().endpoint(), options->endpoint());
+    options->set_project_id("test-project");
+    // Small buffers force multiple chunks for resumable uploads.
+    options->SetUploadBufferSize(256 * 1024);
+    return gcs::Client(*std::move(options));
+  }
+
+  google::cloud::testing_util::EnvironmentVariableRestore endpoint_;
+  std::unique_ptr<ScopedEmbeddedServer> scoped_;
+};
+
+TEST_F(EmbeddedServerTest, Buckets) {
+  auto client = MakeClient();
+  auto bucket = client.CreateBucket(
+      "test-bucket", gcs::BucketMetadata().set_location("fake-region"));
+  ASSERT_STATUS_OK(bucket);
+  EXPECT_EQ("test-bucket", bucket->name());
+  EXPECT_EQ("fake-region", bucket->location());
+
+  auto get = client.GetBucketMetadata("test-bucket");
+  ASSERT_STATUS_OK(get);
+  EXPECT_EQ("test-bucket", get->name());
+
+  EXPECT_STATUS_OK(client.DeleteBucket("test-bucket"));
+  EXPECT_EQ(StatusCode::kNotFound,
+            client.GetBucketMetadata("test-bucket").status().code());
+}
+
+TEST_F(EmbeddedServerTest, InsertAndRead) {
+  auto client = MakeClient();
+  ASSERT_STATUS_OK(client.CreateBucket("test-bucket", gcs::BucketMetadata()));
+
+  std::string const contents = "The quick brown fox jumps over the lazy dog";
+  // Use the XML API, the JSON API with a multipart upload, and the JSON API
+  // with a simple upload.
+  ASSERT_STATUS_OK(client.InsertObject("test-bucket", "xml/object", contents,
+                                       gcs::Fields("")));
+  auto json = client.InsertObject("test-bucket", "json/object", contents,
+                                  gcs::ContentType("text/plain"));
+  ASSERT_STATUS_OK(json);
+  EXPECT_EQ("json/object", json->name());
+  EXPECT_EQ(contents.size(), json->size());
+  EXPECT_EQ(gcs::ComputeCrc32cChecksum(contents), json->crc32c());
+  EXPECT_EQ("text/plain", json->content_type());
+  ASSERT_STATUS_OK(client.InsertObject("test-bucket", "simple", contents,
+                                       gcs::DisableMD5Hash(true),
+                                       gcs::DisableCrc32cChecksum(true)));
+  EXPECT_EQ(3, server().insert_object_count());
+
+  for (auto const* name : {"xml/object", "json/object", "simple"}) {
+    auto xml = client.ReadObject("test-bucket", name);
+    EXPECT_EQ(contents, std::string(std::istreambuf_iterator<char>{xml}, {}));
+    EXPECT_STATUS_OK(xml.status());
+
+    auto media =
+        client.ReadObject("test-bucket", name, gcs::IfGenerationNotMatch(0));
+    EXPECT_EQ(contents,
+              std::string(std::istreambuf_iterator<char>{media}, {}));
+    EXPECT_STATUS_OK(media.status());
+
+    auto range = client.ReadObject("test-bucket", name, gcs::ReadRange(4, 9));
+    EXPECT_EQ("quick", std::string(std::istreambuf_iterator<char>{range}, {}));
+    EXPECT_STATUS_OK(range.status());
+  }
+  EXPECT_EQ(9, server().read_object_count());
+
+  auto missing = client.ReadObject("test-bucket", "missing");
+  EXPECT_EQ("", std::string(std::istreambuf_iterator<char>{missing}, {}));
+  EXPECT_EQ(StatusCode::kNotFound, missing.status().code());
+}
+
+TEST_F(EmbeddedServerTest, ResumableUpload) {
+  auto client = MakeClient();
+  ASSERT_STATUS_OK(client.CreateBucket("test-bucket", gcs::BucketMetadata()));
+
+  std::string const line(1023, 'x');
+  auto os = client.WriteObject("test-bucket", "large");
+  for (int i = 0; i != 1024; ++i) {
+    os << line << "\n";
+  }
+  os.Close();
+  ASSERT_STATUS_OK(os.metadata());
+  EXPECT_EQ(1024 * 1024U, os.metadata()->size());
+  EXPECT_LT(1, server().upload_chunk_count());
+
+  auto is = client.ReadObject("test-bucket", "large");
+  std::string actual(std::istreambuf_iterator<char>{is}, {});
+  EXPECT_STATUS_OK(is.status());
+  EXPECT_EQ(1024 * 1024U, actual.size());
+  EXPECT_EQ(line + "\n", actual.substr(0, 1024));
+}
+
+TEST_F(EmbeddedServerTest, ListAndDelete) {
+  auto client = MakeClient();
+  ASSERT_STATUS_OK(client.CreateBucket("test-bucket", gcs::BucketMetadata()));
+  for (auto const* name : {"a/1", "a/2", "b/1"}) {
+    ASSERT_STATUS_OK(client.InsertObject("test-bucket", name, "contents"));
+  }
+
+  std::vector<std::string> names;
+  for (auto& o : client.ListObjects("test-bucket", gcs::Prefix("a/"),
+                                    gcs::MaxResults(1))) {
+    ASSERT_STATUS_OK(o);
+    names.push_back(o->name());
+  }
+  EXPECT_THAT(names, ElementsAre("a/1", "a/2"));
+  EXPECT_EQ(2, server().list_objects_count());
+
+  EXPECT_EQ(StatusCode::kAborted, client.DeleteBucket("test-bucket").code());
+  for (auto& o : client.ListObjects("test-bucket")) {
+    ASSERT_STATUS_OK(o);
+    EXPECT_STATUS_OK(client.DeleteObject("test-bucket", o->name()));
+  }
+  EXPECT_EQ(3, server().delete_object_count());
+  EXPECT_STATUS_OK(client.DeleteBucket("test-bucket"));
+}
+
+#if !_WIN32
+/// Sends @p request on a new connection and returns the complete response.
+std::string SendRawRequest(std::string const& endpoint,
+                           std::string const& request) {
+  auto const port = std::stoi(endpoint.substr(endpoint.rfind(':') + 1));
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_LE(0, fd);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(static_cast<std::uint16_t>(port));
+  EXPECT_EQ(0, connect(fd, reinterpret_cast<sockaddr*>(&address),
+                       sizeof(address)));
+  EXPECT_EQ(static_cast<ssize_t>(request.size()),
+            send(fd, request.data(), request.size(), 0));
+  // Stop sending, so the server sees the end of the request stream.
+  shutdown(fd, SHUT_WR);
+  std::string response;
+  char buffer[4096];
+  for (ssize_t n; (n = recv(fd, buffer, sizeof(buffer), 0)) > 0;) {
+    response.append(buffer, static_cast<std::size_t>(n));
+  }
+  close(fd);
+  return response;
+}
+
+TEST_F(EmbeddedServerTest, MalformedRequests) {
+  auto client = MakeClient();
+  ASSERT_STATUS_OK(client.CreateBucket("test-bucket", gcs::BucketMetadata()));
+  ASSERT_STATUS_OK(client.InsertObject("test-bucket", "object", "contents"));
+
+  auto const read = std::string(
+      "GET /storage/v1/b/test-bucket/o/object?alt=media HTTP/1.1\r\n");
+  for (auto const* range : {"bytes=abc-", "bytes=0-xyz", "bytes=-",
+                            "bytes=99999999999999999999999-", "bytes=5-2"}) {
+    auto response = SendRawRequest(
+        server().endpoint(), read + "Range: " + range + "\r\n\r\n");
+    EXPECT_THAT(response, ::testing::StartsWith("HTTP/1.1 400 ")) << range;
+  }
+
+  auto const upload = std::string(
+      "POST /upload/storage/v1/b/test-bucket/o?uploadType=media&name=x "
+      "HTTP/1.1\r\n");
+  for (auto const* header :
+       {"Content-Length: 12x\r\n", "Content-Length: -1\r\n",
+        "Transfer-Encoding: chunked\r\n\r\nnot-a-size\r\n"}) {
+    auto response =
+        SendRawRequest(server().endpoint(), upload + header + "\r\n");
+    EXPECT_THAT(response, ::testing::StartsWith("HTTP/1.1 400 ")) << header;
+  }
+
+  // The server is still running.
+  EXPECT_STATUS_OK(client.GetObjectMetadata("test-bucket", "object"));
+}
+#endif  // !_WIN32
+
+}  // namespace
+}  // namespace storage_benchmarks
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,968 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/benchmarks/embedded_server.h"
+#include "google/cloud/internal/setenv.h"
+#include "google/cloud/internal/throw_delegate.h"
+#include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/storage/internal/nljson.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+#if !_WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif  // !_WIN32
+
+namespace google {
+namespace cloud {
+namespace storage_benchmarks {
+#if !_WIN32
+namespace {
+namespace nl = ::google::cloud::storage::internal::nl;
+
+struct HttpRequest {
+  std::string method;
+  /// The path segments, after percent-decoding each one.
+  std::vector<std::string> path;
+  std::map<std::string, std::string> query;
+  /// The header names are converted to lowercase.
+  std::map<std::string, std::string> headers;
+  std::string body;
+
+  std::string Query(std::string const& name) const {
+    auto i = query.find(name);
+    return i == query.end() ? std::string{} : i->second;
+  }
+  std::string Header(std::string const& name) const {
+    auto i = headers.find(name);
+    return i == headers.end() ? std::string{} : i->second;
+  }
+};
+
+struct HttpResponse {
+  int status_code = 200;
+  std::vector<std::pair<std::string, std::string>> headers;
+  std::string body;
+  // Downloads return a range of the object contents. The contents are shared
+  // with the object, so large downloads do not copy the data.
+  std::shared_ptr<std::string const> contents;
+  std::size_t offset = 0;
+  std::size_t length = 0;
+};
+
+HttpResponse JsonResponse(int status_code, nl::json const& json) {
+  HttpResponse response;
+  response.status_code = status_code;
+  response.headers.emplace_back("Content-Type",
+                                "application/json; charset=UTF-8");
+  response.body = json.dump();
+  return response;
+}
+
+HttpResponse ErrorResponse(int status_code, std::string const& message) {
+  return JsonResponse(
+      status_code,
+      nl::json{{"error", {{"code", status_code}, {"message", message}}}});
+}
+
+char const* ReasonPhrase(int status_code) {
+  switch (status_code) {
+    case 200:
+      return "OK";
+    case 204:
+      return "No Content";
+    case 206:
+      return "Partial Content";
+    case 308:
+      return "Resume Incomplete";
+    case 400:
+      return "Bad Request";
+    case 404:
+      return "Not Found";
+    case 409:
+      return "Conflict";
+    case 416:
+      return "Requested Range Not Satisfiable";
+    default:
+      break;
+  }
+  return "Unknown";
+}
+
+std::string PercentDecode(std::string const& str) {
+  std::string result;
+  result.reserve(str.size());
+  for (std::size_t i = 0; i < str.size(); ++i) {
+    if (str[i] == '%' && i + 2 < str.size() &&
+        std::isxdigit(static_cast<unsigned char>(str[i + 1])) != 0 &&
+        std::isxdigit(static_cast<unsigned char>(str[i + 2])) != 0) {
+      result.push_back(
+          static_cast<char>(std::stoi(str.substr(i + 1, 2), nullptr, 16)));
+      i += 2;
+      continue;
+    }
+    result.push_back(str[i]);
+  }
+  return result;
+}
+
+std::vector<std::string> Split(std::string const& str, char separator) {
+  std::vector<std::string> result;
+  std::size_t begin = 0;
+  for (auto end = str.find(separator); end != std::string::npos;
+       begin = end + 1, end = str.find(separator, begin)) {
+    result.push_back(str.substr(begin, end - begin));
+  }
+  result.push_back(str.substr(begin));
+  return result;
+}
+
+/**
+ * Parses @p str as an unsigned integer in @p base.
+ *
+ * Returns false if @p str is empty, has any invalid characters, or the value
+ * does not fit in @p value. Unlike `std::stoull()` this never throws, the
+ * connections run in detached threads where an exception terminates the
+ * program.
+ */
+bool ParseUnsigned(std::string const& str, std::uint64_t& value,
+                   int base = 10) {
+  auto valid = [base](char c) {
+    auto const u = static_cast<unsigned char>(c);
+    return base == 16 ? std::isxdigit(u) != 0 : std::isdigit(u) != 0;
+  };
+  if (str.empty() || !std::all_of(str.begin(), str.end(), valid)) {
+    return false;
+  }
+  errno = 0;
+  char* end = nullptr;
+  auto const v = std::strtoull(str.c_str(), &end, base);
+  if (errno == ERANGE || end != str.c_str() + str.size()) {
+    return false;
+  }
+  value = static_cast<std::uint64_t>(v);
+  return true;
+}
+
+struct Object {
+  std::string bucket;
+  std::string name;
+  std::int64_t generation;
+  std::string content_type;
+  std::string crc32c;
+  std::shared_ptr<std::string const> contents;
+};
+
+nl::json ObjectJson(Object const& o) {
+  auto const generation = std::to_string(o.generation);
+  return nl::json{
+      {"kind", "storage#object"},
+      {"id", o.bucket + "/" + o.name + "/" + generation},
+      {"bucket", o.bucket},
+      {"name", o.name},
+      {"generation", generation},
+      {"metageneration", "1"},
+      {"contentType", o.content_type},
+      {"storageClass", "STANDARD"},
+      {"size", std::to_string(o.contents->size())},
+      {"crc32c", o.crc32c},
+  };
+}
+
+struct Bucket {
+  nl::json metadata;
+  std::map<std::string, Object> objects;
+};
+
+struct UploadSession {
+  std::string bucket;
+  std::string name;
+  std::string content_type;
+  std::string contents;
+};
+
+/**
+ * The in-memory storage, and the handlers for each request.
+ *
+ * A single mutex protects all the data, but it is only held to update the
+ * maps. Uploads and downloads copy data outside the lock.
+ */
+class Service {
+ public:
+  explicit Service(std::string endpoint) : endpoint_(std::move(endpoint)) {}
+
+  HttpResponse Handle(HttpRequest const& request) {
+    auto const& p = request.path;
+    auto const& m = request.method;
+    // The paths look like (after the leading empty segment):
+    //   storage/v1/b[/{bucket}[/o[/{object}]]]
+    //   upload/storage/v1/b/{bucket}/o
+    //   xmlapi/{bucket}/{object}
+    if (p.size() >= 4 && p[1] == "storage" && p[3] == "b") {
+      if (p.size() == 4 && m == "POST") {
+        return CreateBucket(request);
+      }
+      if (p.size() == 5 && m == "GET") {
+        return GetBucket(p[4]);
+      }
+      if (p.size() == 5 && m == "DELETE") {
+        return DeleteBucket(p[4]);
+      }
+      if (p.size() == 6 && p[5] == "o" && m == "GET") {
+        return ListObjects(request, p[4]);
+      }
+      if (p.size() == 7 && p[5] == "o" && m == "GET") {
+        if (request.Query("alt") == "media") {
+          return ReadObject(request, p[4], p[6]);
+        }
+        return GetObject(p[4], p[6]);
+      }
+      if (p.size() == 7 && p[5] == "o" && m == "DELETE") {
+        return DeleteObject(p[4], p[6]);
+      }
+    }
+    if (p.size() == 7 && p[1] == "upload" && p[4] == "b" && p[6] == "o") {
+      auto const upload_type = request.Query("uploadType");
+      if (m == "PUT" && upload_type == "resumable") {
+        return UploadChunk(request);
+      }
+      if (m == "POST" && upload_type == "resumable") {
+        return CreateResumableSession(request, p[5]);
+      }
+      if (m == "POST" && upload_type == "multipart") {
+        return InsertObjectMultipart(request, p[5]);
+      }
+      if (m == "POST" && upload_type == "media") {
+        return InsertObject(p[5], request.Query("name"),
+                            request.Header("content-type"), request.body);
+      }
+    }
+    if (p.size() == 4 && p[1] == "xmlapi") {
+      if (m == "PUT") {
+        auto response = InsertObject(p[2], p[3], request.Header("content-type"),
+                                     request.body);
+        // The XML API returns an empty body, the client only checks the
+        // status code.
+        response.body.clear();
+        return response;
+      }
+      if (m == "GET") {
+        return ReadObject(request, p[2], p[3]);
+      }
+    }
+    if (p.size() == 2 && p[1].empty() && (m == "GET" || m == "HEAD")) {
+      // Used to pre-warm the connections.
+      return HttpResponse{};
+    }
+    return ErrorResponse(404, "unknown request " + m);
+  }
+
+  int insert_object_count() const { return insert_object_count_.load(); }
+  int upload_chunk_count() const { return upload_chunk_count_.load(); }
+  int read_object_count() const { return read_object_count_.load(); }
+  int list_objects_count() const { return list_objects_count_.load(); }
+  int delete_object_count() const { return delete_object_count_.load(); }
+
+ private:
+  HttpResponse CreateBucket(HttpRequest const& request) {
+    auto metadata = nl::json::parse(request.body, nullptr, false);
+    if (!metadata.is_object() || !metadata["name"].is_string()) {
+      return ErrorResponse(400, "missing bucket name");
+    }
+    auto const name = metadata.value("name", "");
+    metadata["kind"] = "storage#bucket";
+    metadata["id"] = name;
+    metadata["metageneration"] = "1";
+    metadata["projectNumber"] = "0";
+    std::lock_guard<std::mutex> lk(mu_);
+    auto inserted = buckets_.emplace(name, Bucket{metadata, {}});
+    if (!inserted.second) {
+      return ErrorResponse(409, "bucket " + name + " already exists");
+    }
+    return JsonResponse(200, metadata);
+  }
+
+  HttpResponse GetBucket(std::string const& bucket_name) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto b = buckets_.find(bucket_name);
+    if (b == buckets_.end()) {
+      return ErrorResponse(404, "bucket " + bucket_name + " not found");
+    }
+    return JsonResponse(200, b->second.metadata);
+  }
+
+  HttpResponse DeleteBucket(std::string const& bucket_name) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto b = buckets_.find(bucket_name);
+    if (b == buckets_.end()) {
+      return ErrorResponse(404, "bucket " + bucket_name + " not found");
+    }
+    if (!b->second.objects.empty()) {
+      return ErrorResponse(409, "bucket " + bucket_name + " is not empty");
+    }
+    buckets_.erase(b);
+    HttpResponse response;
+    response.status_code = 204;
+    return response;
+  }
+
+  HttpResponse ListObjects(HttpRequest const& request,
+                           std::string const& bucket_name) {
+    ++list_objects_count_;
+    auto const prefix = request.Query("prefix");
+    auto const page_token = request.Query("pageToken");
+    std::size_t max_results = 1000;
+    if (!request.Query("maxResults").empty()) {
+      max_results = std::stoul(request.Query("maxResults"));
+    }
+    nl::json items = nl::json::array();
+    std::lock_guard<std::mutex> lk(mu_);
+    auto b = buckets_.find(bucket_name);
+    if (b == buckets_.end()) {
+      return ErrorResponse(404, "bucket " + bucket_name + " not found");
+    }
+    auto const& objects = b->second.objects;
+    auto i = page_token.empty() ? objects.lower_bound(prefix)
+                                : objects.upper_bound(page_token);
+    for (; i != objects.end(); ++i) {
+      if (i->first.compare(0, prefix.size(), prefix) != 0) {
+        break;
+      }
+      if (items.size() == max_results) {
+        // The token is the last object returned, the next page starts after
+        // it.
+        auto token = std::prev(i)->first;
+        return JsonResponse(200, nl::json{{"kind", "storage#objects"},
+                                          {"items", std::move(items)},
+                                          {"nextPageToken", std::move(token)}});
+      }
+      items.push_back(ObjectJson(i->second));
+    }
+    return JsonResponse(200, nl::json{{"kind", "storage#objects"},
+                                      {"items", std::move(items)}});
+  }
+
+  HttpResponse GetObject(std::string const& bucket_name,
+                         std::string const& object_name) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto const* o = FindObject(bucket_name, object_name);
+    if (o == nullptr) {
+      return ErrorResponse(404, "object " + object_name + " not found");
+    }
+    return JsonResponse(200, ObjectJson(*o));
+  }
+
+  HttpResponse DeleteObject(std::string const& bucket_name,
+                            std::string const& object_name) {
+    ++delete_object_count_;
+    std::lock_guard<std::mutex> lk(mu_);
+    auto b = buckets_.find(bucket_name);
+    if (b == buckets_.end() || b->second.objects.erase(object_name) == 0) {
+      return ErrorResponse(404, "object " + object_name + " not found");
+    }
+    HttpResponse response;
+    response.status_code = 204;
+    return response;
+  }
+
+  HttpResponse ReadObject(HttpRequest const& request,
+                          std::string const& bucket_name,
+                          std::string const& object_name) {
+    ++read_object_count_;
+    Object object;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      auto const* o = FindObject(bucket_name, object_name);
+      if (o == nullptr) {
+        return ErrorResponse(404, "object " + object_name + " not found");
+      }
+      object = *o;
+    }
+    HttpResponse response;
+    response.contents = object.contents;
+    response.length = object.contents->size();
+    response.headers.emplace_back("Content-Type", object.content_type);
+    response.headers.emplace_back("x-goog-generation",
+                                  std::to_string(object.generation));
+    response.headers.emplace_back("x-goog-hash", "crc32c=" + object.crc32c);
+
+    // Only the `bytes=<begin>-[<end>]` format is used by the client library.
+    auto const range = request.Header("range");
+    if (range.compare(0, 6, "bytes=") != 0) {
+      return response;
+    }
+    auto const size = object.contents->size();
+    auto const dash = range.find('-', 6);
+    if (dash == std::string::npos) {
+      return ErrorResponse(400, "invalid range header " + range);
+    }
+    std::uint64_t first;
+    if (!ParseUnsigned(range.substr(6, dash - 6), first)) {
+      return ErrorResponse(400, "invalid range header " + range);
+    }
+    std::uint64_t end = size;
+    if (dash + 1 != range.size()) {
+      std::uint64_t last;
+      if (!ParseUnsigned(range.substr(dash + 1), last) || last < first) {
+        return ErrorResponse(400, "invalid range header " + range);
+      }
+      end = (std::min)(end, last + 1);
+    }
+    if (first >= size || first >= end) {
+      return ErrorResponse(416, "invalid range " + range);
+    }
+    auto const begin = static_cast<std::size_t>(first);
+    response.status_code = 206;
+    response.offset = begin;
+    response.length = static_cast<std::size_t>(end) - begin;
+    response.headers.emplace_back("Content-Range",
+                                  "bytes " + std::to_string(begin) + "-" +
+                                      std::to_string(end - 1) + "/" +
+                                      std::to_string(size));
+    return response;
+  }
+
+  HttpResponse InsertObject(std::string const& bucket_name,
+                            std::string const& object_name,
+                            std::string content_type, std::string contents) {
+    ++insert_object_count_;
+    if (object_name.empty()) {
+      return ErrorResponse(400, "missing object name");
+    }
+    if (content_type.empty()) {
+      content_type = "application/octet-stream";
+    }
+    // Compute the checksum outside the lock, it is the most expensive part
+    // of the upload.
+    auto crc32c = storage::ComputeCrc32cChecksum(contents);
+    std::lock_guard<std::mutex> lk(mu_);
+    auto b = buckets_.find(bucket_name);
+    if (b == buckets_.end()) {
+      return ErrorResponse(404, "bucket " + bucket_name + " not found");
+    }
+    auto& object = b->second.objects[object_name];
+    object = Object{bucket_name,
+                    object_name,
+                    ++generation_,
+                    std::move(content_type),
+                    std::move(crc32c),
+                    std::make_shared<std::string const>(std::move(contents))};
+    return JsonResponse(200, ObjectJson(object));
+  }
+
+  HttpResponse InsertObjectMultipart(HttpRequest const& request,
+                                     std::string const& bucket_name) {
+    auto const content_type = request.Header("content-type");
+    auto pos = content_type.find("boundary=");
+    if (pos == std::string::npos) {
+      return ErrorResponse(400, "missing multipart boundary");
+    }
+    auto const marker = "--" + content_type.substr(pos + 9);
+    // The body contains a metadata part and a media part:
+    //   --marker\r\n<headers>\r\n\r\n<json>\r\n
+    //   --marker\r\n<headers>\r\n\r\n<media>\r\n
+    //   --marker--\r\n
+    auto const& body = request.body;
+    auto const json_begin = body.find("\r\n\r\n");
+    auto const json_end = body.find("\r\n" + marker + "\r\n");
+    if (json_begin == std::string::npos || json_end == std::string::npos ||
+        json_end < json_begin) {
+      return ErrorResponse(400, "invalid multipart body");
+    }
+    auto const media_begin = body.find("\r\n\r\n", json_end + 2);
+    auto const media_end = body.rfind("\r\n" + marker + "--");
+    if (media_begin == std::string::npos || media_end == std::string::npos ||
+        media_end < media_begin + 4) {
+      return ErrorResponse(400, "invalid multipart body");
+    }
+    auto metadata = nl::json::parse(
+        body.substr(json_begin + 4, json_end - json_begin - 4), nullptr, false);
+    if (!metadata.is_object()) {
+      return ErrorResponse(400, "invalid object metadata");
+    }
+    auto name = request.Query("name");
+    if (name.empty()) {
+      name = metadata.value("name", "");
+    }
+    // The content type may be in the metadata or in the media part headers.
+    auto media_content_type = metadata.value("contentType", "");
+    auto const headers = body.substr(json_end, media_begin - json_end);
+    auto const header = std::string("\r\ncontent-type: ");
+    pos = headers.find(header);
+    if (media_content_type.empty() && pos != std::string::npos) {
+      auto const end = headers.find("\r\n", pos + header.size());
+      media_content_type = headers.substr(pos + header.size(),
+                                          end - pos - header.size());
+    }
+    return InsertObject(
+        bucket_name, name, std::move(media_content_type),
+        body.substr(media_begin + 4, media_end - media_begin - 4));
+  }
+
+  HttpResponse CreateResumableSession(HttpRequest const& request,
+                                      std::string const& bucket_name) {
+    UploadSession session{bucket_name, request.Query("name"), {}, {}};
+    if (!request.body.empty()) {
+      auto metadata = nl::json::parse(request.body, nullptr, false);
+      if (!metadata.is_object()) {
+        return ErrorResponse(400, "invalid object metadata");
+      }
+      if (session.name.empty()) {
+        session.name = metadata.value("name", "");
+      }
+      session.content_type = metadata.value("contentType", "");
+    }
+    if (session.name.empty()) {
+      return ErrorResponse(400, "missing object name");
+    }
+    std::string id;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (buckets_.count(bucket_name) == 0) {
+        return ErrorResponse(404, "bucket " + bucket_name + " not found");
+      }
+      id = "upload-" + std::to_string(++upload_id_);
+      uploads_.emplace(id, std::move(session));
+    }
+    HttpResponse response;
+    response.headers.emplace_back(
+        "Location", endpoint_ + "/upload/storage/v1/b/" + bucket_name +
+                        "/o?uploadType=resumable&upload_id=" + id);
+    return response;
+  }
+
+  HttpResponse UploadChunk(HttpRequest const& request) {
+    ++upload_chunk_count_;
+    // The Content-Range header is `bytes <begin>-<end>/<total>`, where either
+    // `<begin>-<end>` or `<total>` can be `*`.
+    auto const range = request.Header("content-range");
+    auto const slash = range.find('/');
+    if (range.compare(0, 6, "bytes ") != 0 || slash == std::string::npos) {
+      return ErrorResponse(400, "invalid content-range header " + range);
+    }
+    auto const dash = range.find('-', 6);
+    std::uint64_t begin = 0;
+    if (range[6] != '*' &&
+        (dash == std::string::npos || dash > slash ||
+         !ParseUnsigned(range.substr(6, dash - 6), begin))) {
+      return ErrorResponse(400, "invalid content-range header " + range);
+    }
+    auto const total = range.substr(slash + 1);
+    std::uint64_t total_size = 0;
+    if (total != "*" && !ParseUnsigned(total, total_size)) {
+      return ErrorResponse(400, "invalid content-range header " + range);
+    }
+    auto const id = request.Query("upload_id");
+    std::unique_lock<std::mutex> lk(mu_);
+    auto u = uploads_.find(id);
+    if (u == uploads_.end()) {
+      return ErrorResponse(404, "upload session " + id + " not found");
+    }
+    auto& contents = u->second.contents;
+    if (range[6] != '*') {
+      if (begin > contents.size()) {
+        return ErrorResponse(400, "gap in resumable upload");
+      }
+      // The client may send data that was already committed, ignore it.
+      auto const skip = contents.size() - static_cast<std::size_t>(begin);
+      if (skip < request.body.size()) {
+        contents.append(request.body, skip, std::string::npos);
+      }
+    }
+    if (total != "*" && total_size == contents.size()) {
+      auto session = std::move(u->second);
+      uploads_.erase(u);
+      lk.unlock();
+      return InsertObject(session.bucket, session.name,
+                          std::move(session.content_type),
+                          std::move(session.contents));
+    }
+    HttpResponse response;
+    response.status_code = 308;
+    if (!contents.empty()) {
+      response.headers.emplace_back(
+          "Range", "bytes=0-" + std::to_string(contents.size() - 1));
+    }
+    return response;
+  }
+
+  Object const* FindObject(std::string const& bucket_name,
+                           std::string const& object_name) const {
+    auto b = buckets_.find(bucket_name);
+    if (b == buckets_.end()) {
+      return nullptr;
+    }
+    auto o = b->second.objects.find(object_name);
+    if (o == b->second.objects.end()) {
+      return nullptr;
+    }
+    return &o->second;
+  }
+
+  std::string const endpoint_;
+  std::mutex mu_;
+  std::map<std::string, Bucket> buckets_;
+  std::map<std::string, UploadSession> uploads_;
+  std::int64_t generation_ = 0;
+  std::int64_t upload_id_ = 0;
+
+  std::atomic<int> insert_object_count_{0};
+  std::atomic<int> upload_chunk_count_{0};
+  std::atomic<int> read_object_count_{0};
+  std::atomic<int> list_objects_count_{0};
+  std::atomic<int> delete_object_count_{0};
+};
+
+/// Reads HTTP/1.1 requests from a connection, and writes the responses.
+class Connection {
+ public:
+  explicit Connection(int fd) : fd_(fd) {}
+
+  void Run(Service& service) {
+    for (HttpRequest request;; request = HttpRequest{}) {
+      auto const result = ReadRequest(request);
+      if (result == ReadResult::kClosed) return;
+      if (result == ReadResult::kMalformed) {
+        // The framing is lost, the connection cannot be used after this.
+        auto response = ErrorResponse(400, "malformed request");
+        response.headers.emplace_back("Connection", "close");
+        (void)WriteResponse(response);
+        return;
+      }
+      auto response = service.Handle(request);
+      if (request.method == "HEAD") {
+        response.body.clear();
+        response.contents.reset();
+        response.length = 0;
+      }
+      if (!WriteResponse(response)) return;
+      if (request.Header("connection") == "close") return;
+    }
+  }
+
+ private:
+  enum class ReadResult { kOk, kClosed, kMalformed };
+
+  bool Fill() {
+    char buffer[64 * 1024];
+    auto n = recv(fd_, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+      return false;
+    }
+    buffer_.append(buffer, static_cast<std::size_t>(n));
+    return true;
+  }
+
+  bool ReadLine(std::string& line) {
+    std::size_t pos;
+    while ((pos = buffer_.find("\r\n", offset_)) == std::string::npos) {
+      if (!Fill()) {
+        return false;
+      }
+    }
+    line = buffer_.substr(offset_, pos - offset_);
+    offset_ = pos + 2;
+    return true;
+  }
+
+  bool ReadBytes(std::size_t n, std::string& out) {
+    while (buffer_.size() - offset_ < n) {
+      if (!Fill()) {
+        return false;
+      }
+    }
+    out.append(buffer_, offset_, n);
+    offset_ += n;
+    return true;
+  }
+
+  ReadResult ReadRequest(HttpRequest& request) {
+    // Discard the data from the previous request.
+    buffer_.erase(0, offset_);
+    offset_ = 0;
+
+    std::string line;
+    if (!ReadLine(line)) {
+      return ReadResult::kClosed;
+    }
+    auto const fields = Split(line, ' ');
+    if (fields.size() != 3) {
+      return ReadResult::kMalformed;
+    }
+    request.method = fields[0];
+    auto const& target = fields[1];
+    auto const q = target.find('?');
+    for (auto const& s : Split(target.substr(0, q), '/')) {
+      request.path.push_back(PercentDecode(s));
+    }
+    if (q != std::string::npos) {
+      for (auto const& kv : Split(target.substr(q + 1), '&')) {
+        auto const eq = kv.find('=');
+        if (eq == std::string::npos) {
+          request.query[PercentDecode(kv)] = std::string{};
+          continue;
+        }
+        request.query[PercentDecode(kv.substr(0, eq))] =
+            PercentDecode(kv.substr(eq + 1));
+      }
+    }
+
+    while (ReadLine(line) && !line.empty()) {
+      auto const colon = line.find(':');
+      if (colon == std::string::npos) continue;
+      auto name = line.substr(0, colon);
+      std::transform(name.begin(), name.end(), name.begin(),
+                     [](char c) { return static_cast<char>(std::tolower(c)); });
+      auto value = line.substr(colon + 1);
+      value.erase(0, value.find_first_not_of(' '));
+      request.headers[std::move(name)] = std::move(value);
+    }
+    if (!line.empty()) {
+      return ReadResult::kClosed;
+    }
+
+    // libcurl sends `Expect: 100-continue` for large uploads, and waits for a
+    // while before sending the data unless it gets this interim response.
+    if (request.Header("expect") == "100-continue") {
+      if (!WriteAll("HTTP/1.1 100 Continue\r\n\r\n")) {
+        return ReadResult::kClosed;
+      }
+    }
+    if (request.Header("transfer-encoding") == "chunked") {
+      while (ReadLine(line)) {
+        // Ignore any chunk extensions, e.g. `1000;name=value`.
+        std::uint64_t size;
+        if (!ParseUnsigned(line.substr(0, line.find(';')), size, 16)) {
+          return ReadResult::kMalformed;
+        }
+        if (size == 0) {
+          // Skip any trailers and the final empty line.
+          while (ReadLine(line) && !line.empty()) {
+            continue;
+          }
+          return line.empty() ? ReadResult::kOk : ReadResult::kClosed;
+        }
+        if (!ReadBytes(static_cast<std::size_t>(size), request.body) ||
+            !ReadLine(line)) {
+          return ReadResult::kClosed;
+        }
+      }
+      return ReadResult::kClosed;
+    }
+    auto const header = request.Header("content-length");
+    if (header.empty()) {
+      return ReadResult::kOk;
+    }
+    std::uint64_t length;
+    if (!ParseUnsigned(header, length)) {
+      return ReadResult::kMalformed;
+    }
+    // Do not trust the header with the allocation, the body grows as needed.
+    auto constexpr kMaxReserve = std::uint64_t(64) * 1024 * 1024;
+    auto const reserve = (std::min)(length, kMaxReserve);
+    request.body.reserve(static_cast<std::size_t>(reserve));
+    return ReadBytes(static_cast<std::size_t>(length), request.body)
+               ? ReadResult::kOk
+               : ReadResult::kClosed;
+  }
+
+  bool WriteResponse(HttpResponse const& response) {
+    auto const length =
+        response.contents ? response.length : response.body.size();
+    std::ostringstream os;
+    os << "HTTP/1.1 " << response.status_code << " "
+       << ReasonPhrase(response.status_code) << "\r\n";
+    for (auto const& h : response.headers) {
+      os << h.first << ": " << h.second << "\r\n";
+    }
+    os << "Content-Length: " << length << "\r\n\r\n";
+    // Send small payloads with the headers, but avoid copying downloads.
+    if (!response.contents) {
+      os << response.body;
+      return WriteAll(os.str());
+    }
+    return WriteAll(os.str()) &&
+           WriteAll(response.contents->data() + response.offset,
+                    response.length);
+  }
+
+  bool WriteAll(std::string const& data) {
+    return WriteAll(data.data(), data.size());
+  }
+
+  bool WriteAll(char const* data, std::size_t size) {
+#ifdef MSG_NOSIGNAL
+    int const flags = MSG_NOSIGNAL;
+#else
+    int const flags = 0;
+#endif  // MSG_NOSIGNAL
+    while (size != 0) {
+      auto n = send(fd_, data, size, flags);
+      if (n <= 0) {
+        return false;
+      }
+      data += n;
+      size -= static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+
+  int fd_;
+  std::string buffer_;
+  std::size_t offset_ = 0;
+};
+
+class DefaultEmbeddedServer : public EmbeddedServer {
+ public:
+  DefaultEmbeddedServer() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+      google::cloud::internal::ThrowRuntimeError(
+          std::string("cannot create socket: ") + std::strerror(errno));
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+        listen(listen_fd_, SOMAXCONN) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+                    &length) != 0) {
+      auto const error = std::strerror(errno);
+      close(listen_fd_);
+      google::cloud::internal::ThrowRuntimeError(
+          std::string("cannot listen on localhost: ") + error);
+    }
+    endpoint_ = "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+    service_.reset(new Service(endpoint_));
+  }
+
+  ~DefaultEmbeddedServer() override { close(listen_fd_); }
+
+  std::string endpoint() const override { return endpoint_; }
+
+  void Shutdown() override {
+    std::lock_guard<std::mutex> lk(mu_);
+    shutdown_ = true;
+    // Wake up any connections blocked reading the next request.
+    for (auto fd : connections_) {
+      ::shutdown(fd, SHUT_RDWR);
+    }
+  }
+
+  void Wait() override {
+    while (true) {
+      pollfd p{listen_fd_, POLLIN, 0};
+      // Poll with a timeout, so the loop notices calls to Shutdown().
+      auto const ready = poll(&p, 1, 100);
+      std::unique_lock<std::mutex> lk(mu_);
+      if (shutdown_) break;
+      if (ready <= 0) continue;
+      lk.unlock();
+      auto fd = accept(listen_fd_, nullptr, nullptr);
+      if (fd < 0) continue;
+      int one = 1;
+      (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      lk.lock();
+      if (shutdown_) {
+        close(fd);
+        break;
+      }
+      connections_.insert(fd);
+      // Use detached threads, the benchmarks may create many thousands of
+      // short-lived connections.
+      std::thread([this, fd] {
+        Connection(fd).Run(*service_);
+        std::lock_guard<std::mutex> lk(mu_);
+        close(fd);
+        connections_.erase(fd);
+        cv_.notify_all();
+      }).detach();
+    }
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [this] { return connections_.empty(); });
+  }
+
+  int insert_object_count() const override {
+    return service_->insert_object_count();
+  }
+  int upload_chunk_count() const override {
+    return service_->upload_chunk_count();
+  }
+  int read_object_count() const override {
+    return service_->read_object_count();
+  }
+  int list_objects_count() const override {
+    return service_->list_objects_count();
+  }
+  int delete_object_count() const override {
+    return service_->delete_object_count();
+  }
+
+ private:
+  int listen_fd_;
+  std::string endpoint_;
+  std::unique_ptr<Service> service_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool shutdown_ = false;
+  std::set<int> connections_;
+};
+}  // namespace
+
+std::unique_ptr<EmbeddedServer> CreateEmbeddedServer() {
+  return std::unique_ptr<EmbeddedServer>(new DefaultEmbeddedServer);
+}
+#else
+std::unique_ptr<EmbeddedServer> CreateEmbeddedServer() {
+  google::cloud::internal::ThrowRuntimeError(
+      "the embedded server is not supported on Windows");
+}
+#endif  // !_WIN32
+
+ScopedEmbeddedServer::ScopedEmbeddedServer()
+    : server_(CreateEmbeddedServer()) {
+  thread_ = std::thread([this] { server_->Wait(); });
+  google::cloud::internal::SetEnv("CLOUD_STORAGE_TESTBENCH_ENDPOINT",
+                                  server_->endpoint().c_str());
+}
+
+ScopedEmbeddedServer::~ScopedEmbeddedServer() {
+  server_->Shutdown();
+  thread_.join();
+}
+
+}  // namespace storage_benchmarks
+}  // namespace cloud
+}  // namespace google
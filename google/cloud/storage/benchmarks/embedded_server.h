@@ -0,0 +1,91 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BENCHMARKS_EMBEDDED_SERVER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BENCHMARKS_EMBEDDED_SERVER_H_
+
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage_benchmarks {
+/**
+ * An abstract class to run and stop the embedded GCS server.
+ *
+ * The Python testbench is too slow to measure the performance of the client
+ * library, benchmarks running against it mostly measure the testbench. This
+ * class runs (using Wait()) and stops (using Shutdown()) an in-memory HTTP
+ * server that implements the subset of the JSON and XML APIs used by the
+ * benchmarks:
+ *
+ * - Creating, getting and deleting buckets.
+ * - Media, multipart, and resumable uploads, as well as XML API uploads.
+ * - Full and ranged downloads, using the JSON or XML APIs.
+ * - Getting, listing, and deleting objects.
+ *
+ * This is not a fake implementation of GCS: preconditions, ACLs, and most
+ * metadata fields are ignored. It is suitable for the benchmarks, but for
+ * nothing else.
+ *
+ * To use the server with the client library set the
+ * `CLOUD_STORAGE_TESTBENCH_ENDPOINT` environment variable to `endpoint()`
+ * before creating the `ClientOptions`. Only available on POSIX platforms.
+ */
+class EmbeddedServer {
+ public:
+  virtual ~EmbeddedServer() = default;
+
+  /// The endpoint, in `http://127.0.0.1:<port>` format.
+  virtual std::string endpoint() const = 0;
+  virtual void Shutdown() = 0;
+  virtual void Wait() = 0;
+
+  virtual int insert_object_count() const = 0;
+  virtual int upload_chunk_count() const = 0;
+  virtual int read_object_count() const = 0;
+  virtual int list_objects_count() const = 0;
+  virtual int delete_object_count() const = 0;
+};
+
+/// Create an embedded server listening on an ephemeral port on localhost.
+std::unique_ptr<EmbeddedServer> CreateEmbeddedServer();
+
+/**
+ * Runs an embedded server in a background thread until destroyed.
+ *
+ * The constructor sets the `CLOUD_STORAGE_TESTBENCH_ENDPOINT` environment
+ * variable, any `ClientOptions` created afterwards use the embedded server.
+ */
+class ScopedEmbeddedServer {
+ public:
+  ScopedEmbeddedServer();
+  ~ScopedEmbeddedServer();
+
+  ScopedEmbeddedServer(ScopedEmbeddedServer const&) = delete;
+  ScopedEmbeddedServer& operator=(ScopedEmbeddedServer const&) = delete;
+
+  EmbeddedServer& server() { return *server_; }
+
+ private:
+  std::unique_ptr<EmbeddedServer> server_;
+  std::thread thread_;
+};
+
+}  // namespace storage_benchmarks
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BENCHMARKS_EMBEDDED_SERVER_H_
@@ -65,6 +65,20 @@ run_example ./storage_throughput_benchmark \
       --object-size=10MiB \
       "${FAKE_REGION}"
 
+# The embedded server is fast enough to use more iterations. It keeps all the
+# objects in memory, so keep them small enough for the CI builds.
+run_example ./storage_latency_benchmark \
+      --embedded-server=true \
+      --duration=1 \
+      --object-count=100 \
+      "${FAKE_REGION}"
+run_example ./storage_throughput_benchmark \
+      --embedded-server=true \
+      --duration=1 \
+      --object-count=4 \
+      --object-size=16MiB \
+      "${FAKE_REGION}"
+
 run_example_usage ./storage_throughput_vs_cpu_benchmark \
       --help --description
 run_example ./storage_throughput_vs_cpu_benchmark \
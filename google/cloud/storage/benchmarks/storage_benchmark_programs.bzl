@@ -18,6 +18,8 @@
 
 storage_benchmark_programs = [
     "storage_file_transfer_benchmark.cc",
+    "storage_handle_pool_benchmark.cc",
+    "storage_http2_benchmark.cc",
     "storage_latency_benchmark.cc",
     "storage_throughput_benchmark.cc",
     "storage_throughput_vs_cpu_benchmark.cc",
@@ -18,8 +18,10 @@
 
 storage_benchmarks_hdrs = [
     "benchmark_utils.h",
+    "embedded_server.h",
 ]
 
 storage_benchmarks_srcs = [
     "benchmark_utils.cc",
+    "embedded_server.cc",
 ]
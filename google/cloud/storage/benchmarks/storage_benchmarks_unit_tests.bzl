@@ -20,4 +20,5 @@ storage_benchmarks_unit_tests = [
     "benchmark_parser_test.cc",
     "benchmark_make_random_test.cc",
     "benchmark_parse_args_test.cc",
+    "benchmark_embedded_server_test.cc",
 ]
@@ -0,0 +1,237 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/benchmarks/benchmark_utils.h"
+#include "google/cloud/storage/internal/curl_handle_factory.h"
+#include "google/cloud/storage/version.h"
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+namespace {
+namespace gcs = google::cloud::storage;
+namespace gcs_bm = google::cloud::storage_benchmarks;
+
+char const kDescription[] = R"""(
+A contention benchmark for the curl handle pools.
+
+This program measures the cost of getting a handle from a pool and returning it
+when many threads do so at the same time. This is the pattern used by a single
+`storage::Client` shared by many threads issuing small requests. The program
+does not contact any service, it only creates and releases handles.
+
+For each thread count in the configured range, the program starts that many
+threads. Each thread repeats the following loop for a prescribed number of
+iterations:
+
+- Get a handle from the pool.
+- Set a few options on the handle, simulating the work to prepare a request.
+- Return the handle to the pool.
+
+The program reports the elapsed time and the number of operations per second for
+each pool implementation:
+
+- `Pooled`: the `PooledCurlHandleFactory` used by the library.
+- `Mutex`: a reference pool protected by a single mutex.
+- `Default`: no pool, each iteration creates and destroys a handle.
+)""";
+
+struct Options {
+  int minimum_thread_count = 1;
+  int maximum_thread_count = 64;
+  long iteration_count = 100000;
+  std::size_t pool_size = 0;
+};
+
+Options ParseArgs(int argc, char* argv[]);
+
+/// A pool protected by a single mutex, used as the baseline in the benchmark.
+class MutexCurlHandleFactory : public gcs::internal::CurlHandleFactory {
+ public:
+  explicit MutexCurlHandleFactory(std::size_t maximum_size)
+      : maximum_size_(maximum_size) {}
+  ~MutexCurlHandleFactory() override {
+    for (auto* h : handles_) {
+      curl_easy_cleanup(h);
+    }
+  }
+
+  gcs::internal::CurlPtr CreateHandle() override {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!handles_.empty()) {
+      CURL* handle = handles_.back();
+      handles_.pop_back();
+      lk.unlock();
+      (void)curl_easy_reset(handle);
+      return gcs::internal::CurlPtr(handle, &curl_easy_cleanup);
+    }
+    lk.unlock();
+    return gcs::internal::CurlPtr(curl_easy_init(), &curl_easy_cleanup);
+  }
+
+  void CleanupHandle(gcs::internal::CurlPtr&& h) override {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (handles_.size() < maximum_size_) {
+      handles_.push_back(h.release());
+    }
+    lk.unlock();
+    h.reset();
+  }
+
+  gcs::internal::CurlMulti CreateMultiHandle() override {
+    return gcs::internal::CurlMulti(curl_multi_init(), &curl_multi_cleanup);
+  }
+  void CleanupMultiHandle(gcs::internal::CurlMulti&& m) override {
+    m.reset();
+  }
+
+  std::string LastClientIpAddress() const override { return {}; }
+
+ private:
+  std::size_t maximum_size_;
+  std::mutex mu_;
+  std::vector<CURL*> handles_;
+};
+
+void RunThread(gcs::internal::CurlHandleFactory& factory, long iterations) {
+  for (long i = 0; i != iterations; ++i) {
+    auto handle = factory.CreateHandle();
+    curl_easy_setopt(handle.get(), CURLOPT_URL, "https://localhost/");
+    curl_easy_setopt(handle.get(), CURLOPT_NOSIGNAL, 1L);
+    factory.CleanupHandle(std::move(handle));
+  }
+}
+
+void RunExperiment(std::string const& name,
+                   gcs::internal::CurlHandleFactory& factory,
+                   int thread_count, long iterations) {
+  gcs_bm::SimpleTimer timer;
+  timer.Start();
+  std::vector<std::future<void>> tasks;
+  for (int i = 0; i != thread_count; ++i) {
+    tasks.emplace_back(std::async(std::launch::async, RunThread,
+                                  std::ref(factory), iterations));
+  }
+  for (auto& t : tasks) {
+    t.get();
+  }
+  timer.Stop();
+
+  auto const operations = static_cast<double>(thread_count) * iterations;
+  auto const elapsed = timer.elapsed_time().count();
+  std::cout << name << ',' << thread_count << ',' << iterations << ','
+            << elapsed << ',' << timer.cpu_time().count() << ','
+            << (elapsed == 0 ? 0.0 : operations * 1.0E6 / elapsed) << ','
+            << gcs::version_string() << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) try {
+  Options options = ParseArgs(argc, argv);
+  curl_global_init(CURL_GLOBAL_ALL);
+
+  std::cout << "# Min Thread Count: " << options.minimum_thread_count
+            << "\n# Max Thread Count: " << options.maximum_thread_count
+            << "\n# Iterations: " << options.iteration_count
+            << "\n# Pool Size: " << options.pool_size
+            << "\n# Pool,ThreadCount,Iterations,ElapsedUs,CpuUs,OpsPerSecond"
+            << ",Version" << std::endl;
+
+  for (int thread_count = options.minimum_thread_count;
+       thread_count <= options.maximum_thread_count; thread_count *= 2) {
+    auto pool_size = options.pool_size == 0
+                         ? static_cast<std::size_t>(thread_count)
+                         : options.pool_size;
+    gcs::internal::PooledCurlHandleFactory pooled(pool_size);
+    RunExperiment("Pooled", pooled, thread_count, options.iteration_count);
+    MutexCurlHandleFactory mutex(pool_size);
+    RunExperiment("Mutex", mutex, thread_count, options.iteration_count);
+    gcs::internal::DefaultCurlHandleFactory unpooled;
+    RunExperiment("Default", unpooled, thread_count, options.iteration_count);
+  }
+  std::cout << "# DONE\n" << std::flush;
+
+  return 0;
+} catch (std::exception const& ex) {
+  std::cerr << "Standard exception raised: " << ex.what() << "\n";
+  return 1;
+}
+
+namespace {
+Options ParseArgs(int argc, char* argv[]) {
+  Options options;
+  bool wants_help = false;
+  bool wants_description = false;
+  std::vector<gcs_bm::OptionDescriptor> desc{
+      {"--help", "print usage information",
+       [&wants_help](std::string const&) { wants_help = true; }},
+      {"--description", "print benchmark description",
+       [&wants_description](std::string const&) { wants_description = true; }},
+      {"--minimum-thread-count", "the smallest number of threads tested",
+       [&options](std::string const& val) {
+         options.minimum_thread_count = std::stoi(val);
+       }},
+      {"--maximum-thread-count", "the largest number of threads tested",
+       [&options](std::string const& val) {
+         options.maximum_thread_count = std::stoi(val);
+       }},
+      {"--iteration-count", "the number of iterations in each thread",
+       [&options](std::string const& val) {
+         options.iteration_count = std::stol(val);
+       }},
+      {"--pool-size",
+       "the maximum number of handles in each pool, use 0 to match the number"
+       " of threads",
+       [&options](std::string const& val) {
+         options.pool_size = std::stoul(val);
+       }},
+  };
+  auto usage = gcs_bm::BuildUsage(desc, argv[0]);
+
+  auto unparsed = gcs_bm::OptionsParse(desc, {argv, argv + argc});
+  if (wants_help) {
+    std::cout << usage << "\n";
+  }
+
+  if (wants_description) {
+    std::cout << kDescription << "\n";
+  }
+
+  if (unparsed.size() != 1) {
+    std::ostringstream os;
+    os << "Unknown arguments or options\n" << usage << "\n";
+    throw std::runtime_error(std::move(os).str());
+  }
+  if (options.minimum_thread_count <= 0) {
+    std::ostringstream os;
+    os << "Invalid minimum thread count (" << options.minimum_thread_count
+       << "), it must be a positive number\n"
+       << usage << "\n";
+    throw std::runtime_error(std::move(os).str());
+  }
+  if (options.maximum_thread_count < options.minimum_thread_count) {
+    std::ostringstream os;
+    os << "Invalid maximum thread count (" << options.maximum_thread_count
+       << "), it must be greater than or equal to the minimum thread count ("
+       << options.minimum_thread_count << ")\n"
+       << usage << "\n";
+    throw std::runtime_error(std::move(os).str());
+  }
+
+  return options;
+}
+
+}  // namespace
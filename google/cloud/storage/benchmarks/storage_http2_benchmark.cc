@@ -0,0 +1,229 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/benchmarks/benchmark_utils.h"
+#include "google/cloud/storage/client.h"
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <sstream>
+
+namespace {
+namespace gcs = google::cloud::storage;
+namespace gcs_bm = google::cloud::storage_benchmarks;
+
+char const kDescription[] = R"""(
+Compare HTTP/1.1 and multiplexed HTTP/2 for many concurrent small requests.
+
+This program measures the latency and throughput of small requests issued
+concurrently by many threads sharing a single `storage::Client`. It runs the
+same experiment with HTTP/1.1, where each concurrent request needs its own
+connection, and with HTTP/2, where concurrent requests share a few multiplexed
+connections.
+
+In each experiment the program starts a number of threads, and each thread
+repeatedly fetches the metadata for the same object. The program reports the
+throughput, and the median and 99th percentile latency for each protocol.
+
+The program can run against production, or against a local stand-in server.
+Any HTTP/2-capable server that returns the object metadata at
+`/storage/v1/b/<bucket>/o/<object>` works. For example, using `nghttpd`:
+
+  mkdir -p htdocs/storage/v1/b/bucket/o
+  echo '{"bucket": "bucket", "name": "object", "generation": "1"}' \
+      >htdocs/storage/v1/b/bucket/o/object
+  nghttpd --htdocs=htdocs 8080 server.key server.crt &
+  storage_http2_benchmark --endpoint=https://localhost:8080 --protocols=http2 \
+      bucket object
+
+Note that `nghttpd` only supports HTTP/2, use `--protocols=http2` with it. The
+certificate in `server.crt` must be trusted by the system. Some versions of
+libcurl fail to reuse plain text (`--no-tls`) HTTP/2 connections, prefer TLS
+when comparing the protocols.
+)""";
+
+struct Options {
+  std::string endpoint;
+  std::string bucket_name;
+  std::string object_name;
+  int thread_count = 16;
+  long iteration_count = 1000;
+  std::size_t maximum_http2_connections = 4;
+  bool run_http1 = true;
+  bool run_http2 = true;
+};
+
+Options ParseArgs(int argc, char* argv[]);
+
+struct ThreadResult {
+  std::vector<std::chrono::microseconds> latencies;
+  long errors = 0;
+};
+
+ThreadResult RunThread(gcs::Client client, Options const& options) {
+  ThreadResult result;
+  result.latencies.reserve(options.iteration_count);
+  for (long i = 0; i != options.iteration_count; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    auto metadata =
+        client.GetObjectMetadata(options.bucket_name, options.object_name);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (!metadata) {
+      ++result.errors;
+      continue;
+    }
+    result.latencies.push_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed));
+  }
+  return result;
+}
+
+void RunExperiment(Options const& options, bool enable_http2) {
+  auto client_options = [&options]() -> gcs::ClientOptions {
+    if (options.endpoint.empty()) {
+      return gcs::ClientOptions::CreateDefaultClientOptions().value();
+    }
+    return gcs::ClientOptions(gcs::oauth2::CreateAnonymousCredentials())
+        .set_endpoint(options.endpoint);
+  }();
+  client_options.set_enable_http2(enable_http2)
+      .set_maximum_http2_connections(options.maximum_http2_connections);
+  gcs::Client client(std::move(client_options),
+                     gcs::LimitedErrorCountRetryPolicy(0));
+
+  gcs_bm::SimpleTimer timer;
+  timer.Start();
+  std::vector<std::future<ThreadResult>> tasks;
+  for (int i = 0; i != options.thread_count; ++i) {
+    tasks.emplace_back(
+        std::async(std::launch::async, RunThread, client, std::cref(options)));
+  }
+  std::vector<std::chrono::microseconds> latencies;
+  long errors = 0;
+  for (auto& t : tasks) {
+    auto r = t.get();
+    latencies.insert(latencies.end(), r.latencies.begin(), r.latencies.end());
+    errors += r.errors;
+  }
+  timer.Stop();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) -> long {
+    if (latencies.empty()) {
+      return 0;
+    }
+    auto index = static_cast<std::size_t>(p * (latencies.size() - 1));
+    return static_cast<long>(latencies[index].count());
+  };
+  auto const elapsed = timer.elapsed_time().count();
+  auto const throughput =
+      elapsed == 0 ? 0.0 : latencies.size() * 1.0E6 / elapsed;
+  std::cout << (enable_http2 ? "HTTP2" : "HTTP1") << ','
+            << options.thread_count << ',' << latencies.size() << ','
+            << errors << ',' << elapsed << ',' << throughput << ','
+            << percentile(0.5) << ',' << percentile(0.99) << ','
+            << gcs::version_string() << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) try {
+  Options options = ParseArgs(argc, argv);
+
+  std::cout << "# Endpoint: " << options.endpoint
+            << "\n# Bucket: " << options.bucket_name
+            << "\n# Object: " << options.object_name
+            << "\n# Thread Count: " << options.thread_count
+            << "\n# Iterations: " << options.iteration_count
+            << "\n# Maximum HTTP/2 Connections: "
+            << options.maximum_http2_connections
+            << "\n# Protocol,ThreadCount,Successes,Errors,ElapsedUs"
+            << ",OpsPerSecond,P50Us,P99Us,Version" << std::endl;
+
+  if (options.run_http1) {
+    RunExperiment(options, false);
+  }
+  if (options.run_http2) {
+    RunExperiment(options, true);
+  }
+  std::cout << "# DONE\n" << std::flush;
+
+  return 0;
+} catch (std::exception const& ex) {
+  std::cerr << "Standard exception raised: " << ex.what() << "\n";
+  return 1;
+}
+
+namespace {
+Options ParseArgs(int argc, char* argv[]) {
+  Options options;
+  bool wants_help = false;
+  bool wants_description = false;
+  std::vector<gcs_bm::OptionDescriptor> desc{
+      {"--help", "print usage information",
+       [&wants_help](std::string const&) { wants_help = true; }},
+      {"--description", "print benchmark description",
+       [&wants_description](std::string const&) { wants_description = true; }},
+      {"--endpoint", "use the given endpoint instead of production",
+       [&options](std::string const& val) { options.endpoint = val; }},
+      {"--thread-count", "set the number of threads in the benchmark",
+       [&options](std::string const& val) {
+         options.thread_count = std::stoi(val);
+       }},
+      {"--iteration-count", "the number of requests issued by each thread",
+       [&options](std::string const& val) {
+         options.iteration_count = std::stol(val);
+       }},
+      {"--maximum-http2-connections",
+       "the maximum number of HTTP/2 connections to each host",
+       [&options](std::string const& val) {
+         options.maximum_http2_connections = std::stoul(val);
+       }},
+      {"--protocols", "run the experiments for these protocols: http1,http2",
+       [&options](std::string const& val) {
+         options.run_http1 = val.find("http1") != std::string::npos;
+         options.run_http2 = val.find("http2") != std::string::npos;
+       }},
+  };
+  auto usage = gcs_bm::BuildUsage(desc, argv[0]) + " <bucket> <object>";
+
+  auto unparsed = gcs_bm::OptionsParse(desc, {argv, argv + argc});
+  if (wants_help) {
+    std::cout << usage << "\n";
+  }
+
+  if (wants_description) {
+    std::cout << kDescription << "\n";
+  }
+
+  if (unparsed.size() != 3) {
+    std::ostringstream os;
+    os << "Missing bucket or object name\n" << usage << "\n";
+    throw std::runtime_error(std::move(os).str());
+  }
+  options.bucket_name = unparsed[1];
+  options.object_name = unparsed[2];
+
+  if (options.thread_count <= 0) {
+    std::ostringstream os;
+    os << "Invalid thread count (" << options.thread_count
+       << "), it must be a positive number\n"
+       << usage << "\n";
+    throw std::runtime_error(std::move(os).str());
+  }
+
+  return options;
+}
+
+}  // namespace
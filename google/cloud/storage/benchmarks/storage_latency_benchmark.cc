@@ -18,6 +18,7 @@
 #include "google/cloud/internal/random.h"
 #include "google/cloud/internal/throw_delegate.h"
 #include "google/cloud/storage/benchmarks/benchmark_utils.h"
+#include "google/cloud/storage/benchmarks/embedded_server.h"
 #include "google/cloud/storage/client.h"
 #include <future>
 #include <iomanip>
@@ -73,6 +74,7 @@ struct Options {
   int thread_count = 1;
   bool enable_connection_pool = false;
   bool enable_xml_api = false;
+  bool embedded_server = false;
   std::string project_id;
 };
 
@@ -106,6 +108,15 @@ Options ParseArgs(int argc, char* argv[]);
 int main(int argc, char* argv[]) try {
   Options options = ParseArgs(argc, argv);
 
+  // The embedded server must be running before the ClientOptions are created.
+  std::unique_ptr<gcs_bm::ScopedEmbeddedServer> embedded_server;
+  if (options.embedded_server) {
+    embedded_server.reset(new gcs_bm::ScopedEmbeddedServer);
+    if (options.project_id.empty()) {
+      options.project_id = "embedded-server-project";
+    }
+  }
+
   google::cloud::StatusOr<gcs::ClientOptions> client_options =
       gcs::ClientOptions::CreateDefaultClientOptions();
   if (!client_options) {
@@ -150,6 +161,7 @@ int main(int argc, char* argv[]) try {
             << "\n# Thread Count: " << options.thread_count
             << "\n# Enable connection pool: " << options.enable_connection_pool
             << "\n# Enable XML API: " << options.enable_xml_api
+            << "\n# Embedded server: " << options.embedded_server
             << "\n# Build info: " << notes << "\n";
 
   std::vector<std::string> object_names =
@@ -425,6 +437,10 @@ Options ParseArgs(int argc, char* argv[]) {
        [&options](std::string const& val) {
          options.enable_xml_api = gcs_bm::ParseBoolean(val, true);
        }},
+      {"--embedded-server", "run the benchmark against an in-process server",
+       [&options](std::string const& val) {
+         options.embedded_server = gcs_bm::ParseBoolean(val, true);
+       }},
       {"--project-id", "use the given project id for the benchmark",
        [&options](std::string const& val) { options.project_id = val; }},
       {"--region", "use the given region for the benchmark",
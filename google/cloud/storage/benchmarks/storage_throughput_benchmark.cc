@@ -18,6 +18,7 @@
 #include "google/cloud/internal/random.h"
 #include "google/cloud/internal/throw_delegate.h"
 #include "google/cloud/storage/benchmarks/benchmark_utils.h"
+#include "google/cloud/storage/benchmarks/embedded_server.h"
 #include "google/cloud/storage/client.h"
 #include <future>
 #include <iomanip>
@@ -76,6 +77,9 @@ struct Options {
   std::int64_t object_size = 250 * gcs_bm::kMiB;
   bool enable_connection_pool = true;
   bool enable_xml_api = true;
+  bool embedded_server = false;
+  gcs::TransportTuning download_tuning;
+  gcs::TransportTuning upload_tuning;
 };
 
 enum OpType { OP_READ, OP_WRITE, OP_CREATE, OP_DELETE, OP_LAST };
@@ -108,6 +112,15 @@ Options ParseArgs(int argc, char* argv[]);
 int main(int argc, char* argv[]) try {
   Options options = ParseArgs(argc, argv);
 
+  // The embedded server must be running before the ClientOptions are created.
+  std::unique_ptr<gcs_bm::ScopedEmbeddedServer> embedded_server;
+  if (options.embedded_server) {
+    embedded_server.reset(new gcs_bm::ScopedEmbeddedServer);
+    if (options.project_id.empty()) {
+      options.project_id = "embedded-server-project";
+    }
+  }
+
   google::cloud::StatusOr<gcs::ClientOptions> client_options =
       gcs::ClientOptions::CreateDefaultClientOptions();
   if (!client_options) {
@@ -121,6 +134,8 @@ int main(int argc, char* argv[]) try {
   if (!options.project_id.empty()) {
     client_options->set_project_id(options.project_id);
   }
+  client_options->set_download_tuning(options.download_tuning);
+  client_options->set_upload_tuning(options.upload_tuning);
   gcs::Client client(*std::move(client_options));
 
   google::cloud::internal::DefaultPRNG generator =
@@ -154,6 +169,16 @@ int main(int argc, char* argv[]) try {
             << "\n# Thread Count: " << options.thread_count
             << "\n# Enable connection pool: " << options.enable_connection_pool
             << "\n# Enable XML API: " << options.enable_xml_api
+            << "\n# Embedded server: " << options.embedded_server
+            << "\n# Download curl buffer size: "
+            << options.download_tuning.curl_buffer_size
+            << "\n# Download socket buffer size: "
+            << options.download_tuning.socket_receive_buffer_size
+            << "\n# Upload curl buffer size: "
+            << options.upload_tuning.curl_buffer_size
+            << "\n# Upload socket buffer size: "
+            << options.upload_tuning.socket_send_buffer_size
+            << "\n# TCP_NODELAY: " << options.download_tuning.tcp_nodelay
             << "\n# Build info: " << notes << "\n";
 
   std::vector<std::string> object_names =
@@ -465,8 +490,40 @@ Options ParseArgs(int argc, char* argv[]) {
        [&options](std::string const& val) {
          options.enable_xml_api = gcs_bm::ParseBoolean(val, true);
        }},
+      {"--embedded-server", "run the benchmark against an in-process server",
+       [&options](std::string const& val) {
+         options.embedded_server = gcs_bm::ParseBoolean(val, true);
+       }},
       {"--project-id", "use the given project id for the benchmark",
        [&options](std::string const& val) { options.project_id = val; }},
+      {"--download-curl-buffer-size", "the libcurl buffer size for downloads",
+       [&options](std::string const& val) {
+         options.download_tuning.curl_buffer_size =
+             static_cast<std::size_t>(gcs_bm::ParseSize(val));
+       }},
+      {"--download-socket-buffer-size",
+       "the socket receive buffer size (SO_RCVBUF) for downloads",
+       [&options](std::string const& val) {
+         options.download_tuning.socket_receive_buffer_size =
+             static_cast<std::size_t>(gcs_bm::ParseSize(val));
+       }},
+      {"--upload-curl-buffer-size", "the libcurl buffer size for uploads",
+       [&options](std::string const& val) {
+         options.upload_tuning.curl_buffer_size =
+             static_cast<std::size_t>(gcs_bm::ParseSize(val));
+       }},
+      {"--upload-socket-buffer-size",
+       "the socket send buffer size (SO_SNDBUF) for uploads",
+       [&options](std::string const& val) {
+         options.upload_tuning.socket_send_buffer_size =
+             static_cast<std::size_t>(gcs_bm::ParseSize(val));
+       }},
+      {"--tcp-nodelay", "set TCP_NODELAY for uploads and downloads",
+       [&options](std::string const& val) {
+         auto const nodelay = gcs_bm::ParseBoolean(val, true);
+         options.download_tuning.tcp_nodelay = nodelay;
+         options.upload_tuning.tcp_nodelay = nodelay;
+       }},
       {"--region", "use the given region for the benchmark",
        [&options](std::string const& val) { options.region = val; }},
   };
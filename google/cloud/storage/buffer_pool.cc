@@ -0,0 +1,179 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/buffer_pool.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+/// Each size class retains at most this many bytes, but at least one buffer.
+constexpr std::size_t kMaximumBytesPerClass = 32 * 1024 * 1024;
+/// Each size class retains at most this many buffers.
+constexpr std::size_t kMaximumBuffersPerClass = 64;
+}  // namespace
+
+constexpr std::size_t BufferPool::kMinimumBufferSize;
+constexpr std::size_t BufferPool::kMaximumBufferSize;
+
+BufferPool::SizeClass::SizeClass(std::size_t buffer_size, std::size_t count)
+    : buffer_size_(buffer_size),
+      count_(count),
+      storage_(new char[(count + 1) * sizeof(Slot)]) {
+  // Before C++17 `new` does not honor the alignment of over-aligned types.
+  auto const address = reinterpret_cast<std::uintptr_t>(storage_.get());
+  auto const aligned = (address + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+  slots_ = reinterpret_cast<Slot*>(aligned);
+  for (std::size_t i = 0; i != count_; ++i) {
+    new (&slots_[i]) Slot;
+  }
+}
+
+BufferPool::SizeClass::~SizeClass() {
+  for (std::size_t i = 0; i != count_; ++i) {
+    slots_[i].~Slot();
+  }
+}
+
+std::ostream& operator<<(std::ostream& os, BufferPoolStatistics const& rhs) {
+  return os << "hits=" << rhs.hits << ", misses=" << rhs.misses
+            << ", returns=" << rhs.returns << ", discards=" << rhs.discards;
+}
+
+BufferPool::BufferPool() {
+  for (auto size = kMinimumBufferSize; size <= kMaximumBufferSize; size *= 2) {
+    auto const count = (std::max)(
+        std::size_t{1},
+        (std::min)(kMaximumBuffersPerClass, kMaximumBytesPerClass / size));
+    classes_.emplace_back(new SizeClass(size, count));
+  }
+}
+
+BufferPool::~BufferPool() = default;
+
+std::string BufferPool::Acquire(std::size_t size) {
+  auto c = std::find_if(classes_.begin(), classes_.end(),
+                        [size](std::unique_ptr<SizeClass> const& sc) {
+                          return size <= sc->buffer_size();
+                        });
+  if (c == classes_.end()) {
+    // Too large to pool, just allocate it.
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return std::string(size, '\0');
+  }
+  auto& slots = **c;
+  auto const n = slots.size();
+  auto const home = HomeSlot();
+  for (std::size_t i = 0; i != n; ++i) {
+    auto& slot = slots[(home + i) % n];
+    if (!Claim(slot, kFull)) {
+      continue;
+    }
+    std::string buffer = std::move(slot.buffer);
+    slot.buffer = std::string{};
+    slot.state.store(kEmpty, std::memory_order_release);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    // Only grows if the buffer was shrunk by its previous user, the capacity
+    // is unchanged.
+    buffer.resize(size);
+    return buffer;
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  std::string buffer;
+  buffer.reserve(slots.buffer_size());
+  buffer.resize(size);
+  return buffer;
+}
+
+void BufferPool::Release(std::string buffer) {
+  // Find the largest class that fits in the buffer capacity. Buffers smaller
+  // than the minimum class, typically buffers moved-from or never allocated,
+  // are not worth keeping.
+  auto const capacity = buffer.capacity();
+  auto c = std::find_if(classes_.rbegin(), classes_.rend(),
+                        [capacity](std::unique_ptr<SizeClass> const& sc) {
+                          return sc->buffer_size() <= capacity;
+                        });
+  if (c == classes_.rend()) {
+    return;
+  }
+  auto& slots = **c;
+  auto const n = slots.size();
+  auto const home = HomeSlot();
+  for (std::size_t i = 0; i != n; ++i) {
+    auto& slot = slots[(home + i) % n];
+    if (!Claim(slot, kEmpty)) {
+      continue;
+    }
+    slot.buffer = std::move(buffer);
+    slot.state.store(kFull, std::memory_order_release);
+    returns_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  discards_.fetch_add(1, std::memory_order_relaxed);
+}
+
+BufferPoolStatistics BufferPool::statistics() const {
+  BufferPoolStatistics result;
+  result.hits = hits_.load(std::memory_order_relaxed);
+  result.misses = misses_.load(std::memory_order_relaxed);
+  result.returns = returns_.load(std::memory_order_relaxed);
+  result.discards = discards_.load(std::memory_order_relaxed);
+  return result;
+}
+
+std::size_t BufferPool::HomeSlot() {
+  static thread_local std::size_t const home =
+      std::hash<std::thread::id>()(std::this_thread::get_id());
+  return home;
+}
+
+bool BufferPool::Claim(Slot& slot, int expected) {
+  // Check before the compare-and-swap, avoids taking the cache line in
+  // exclusive mode when the slot is not usable.
+  if (slot.state.load(std::memory_order_relaxed) != expected) {
+    return false;
+  }
+  return slot.state.compare_exchange_strong(expected, kBusy,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed);
+}
+
+namespace internal {
+std::string AcquireBuffer(BufferPool* pool, std::size_t size) {
+  if (pool == nullptr) {
+    return std::string(size, '\0');
+  }
+  return pool->Acquire(size);
+}
+
+void ReleaseBuffer(BufferPool* pool, std::string buffer) {
+  if (pool == nullptr) {
+    return;
+  }
+  pool->Release(std::move(buffer));
+}
+}  // namespace internal
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,151 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BUFFER_POOL_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BUFFER_POOL_H_
+
+#include "google/cloud/storage/version.h"
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/// The counters reported by `BufferPool::statistics()`.
+struct BufferPoolStatistics {
+  /// The number of buffers acquired from the pool.
+  std::uint64_t hits = 0;
+  /// The number of buffers allocated because the pool had none available.
+  std::uint64_t misses = 0;
+  /// The number of buffers returned to the pool.
+  std::uint64_t returns = 0;
+  /// The number of buffers released because the pool was full.
+  std::uint64_t discards = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, BufferPoolStatistics const& rhs);
+
+/**
+ * Reuses the I/O buffers for the streams and downloads created by a client.
+ *
+ * Each `ObjectReadStream`, `ObjectWriteStream`, and download request needs a
+ * buffer of a fixed size, for applications that open many short-lived streams
+ * allocating and releasing these buffers is a significant cost. The client
+ * gets these buffers from a pool instead.
+ *
+ * Buffers are grouped in size classes, each a power of two between 4KiB and
+ * 64MiB. Each size class caches a bounded number of buffers, so the pool
+ * retains at most about 32MiB per class, or one buffer for the largest
+ * classes. The buffers are kept until the pool is destroyed, applications that
+ * use the pool should size their streams with this in mind.
+ *
+ * Like the curl handle pool, getting and returning a buffer never blocks. All
+ * the slots are shared by all the threads, there are no per-thread caches: each
+ * thread starts its search at a slot derived from its id, so threads using
+ * different slots do not contend. Each slot is in its own cache line.
+ *
+ * @par Example
+ * @code
+ * auto options = gcs::ClientOptions::CreateDefaultClientOptions();
+ * auto pool = std::make_shared<gcs::BufferPool>();
+ * options->set_buffer_pool(pool);
+ * gcs::Client client(*std::move(options));
+ * // ... use `client` ...
+ * std::cout << pool->statistics() << "\n";
+ * @endcode
+ */
+class BufferPool {
+ public:
+  BufferPool();
+  ~BufferPool();
+
+  BufferPool(BufferPool const&) = delete;
+  BufferPool& operator=(BufferPool const&) = delete;
+
+  /**
+   * Gets a buffer with `size()` equal to @p size.
+   *
+   * The contents of the buffer are unspecified. The buffer capacity is
+   * rounded up to the size class, so it can be returned to the same class.
+   */
+  std::string Acquire(std::size_t size);
+
+  /// Returns @p buffer to the pool, or releases it if the pool is full.
+  void Release(std::string buffer);
+
+  BufferPoolStatistics statistics() const;
+
+  /// The smallest size class, smaller buffers are rounded up to this size.
+  static constexpr std::size_t kMinimumBufferSize = 4 * 1024;
+  /// The largest size class, larger buffers are never pooled.
+  static constexpr std::size_t kMaximumBufferSize = 64 * 1024 * 1024;
+
+ private:
+  enum State { kEmpty, kBusy, kFull };
+
+  static std::size_t constexpr kCacheLineSize = 64;
+
+  struct alignas(kCacheLineSize) Slot {
+    std::atomic<int> state{kEmpty};
+    std::string buffer;
+  };
+
+  class SizeClass {
+   public:
+    SizeClass(std::size_t buffer_size, std::size_t count);
+    ~SizeClass();
+
+    SizeClass(SizeClass const&) = delete;
+    SizeClass& operator=(SizeClass const&) = delete;
+
+    std::size_t buffer_size() const { return buffer_size_; }
+    std::size_t size() const { return count_; }
+    Slot& operator[](std::size_t i) { return slots_[i]; }
+
+   private:
+    std::size_t buffer_size_;
+    std::size_t count_;
+    std::unique_ptr<char[]> storage_;
+    Slot* slots_;
+  };
+
+  static std::size_t HomeSlot();
+  static bool Claim(Slot& slot, int expected);
+
+  std::vector<std::unique_ptr<SizeClass>> classes_;
+  std::atomic<std::uint64_t> hits_{0};
+  std::atomic<std::uint64_t> misses_{0};
+  std::atomic<std::uint64_t> returns_{0};
+  std::atomic<std::uint64_t> discards_{0};
+};
+
+namespace internal {
+/// Gets a buffer from @p pool, or allocates one if @p pool is null.
+std::string AcquireBuffer(BufferPool* pool, std::size_t size);
+
+/// Returns @p buffer to @p pool, or just releases it if @p pool is null.
+void ReleaseBuffer(BufferPool* pool, std::string buffer);
+}  // namespace internal
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BUFFER_POOL_H_
@@ -0,0 +1,154 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/buffer_pool.h"
+#include "google/cloud/storage/client_options.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include <gmock/gmock.h>
+#include <future>
+#include <sstream>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+TEST(BufferPoolTest, AcquireRoundsUpCapacity) {
+  BufferPool pool;
+  auto buffer = pool.Acquire(100);
+  EXPECT_EQ(100U, buffer.size());
+  EXPECT_LE(BufferPool::kMinimumBufferSize, buffer.capacity());
+
+  buffer = pool.Acquire(128 * 1024 + 1);
+  EXPECT_EQ(128 * 1024 + 1U, buffer.size());
+  EXPECT_LE(256 * 1024U, buffer.capacity());
+
+  auto stats = pool.statistics();
+  EXPECT_EQ(0U, stats.hits);
+  EXPECT_EQ(2U, stats.misses);
+}
+
+TEST(BufferPoolTest, ReusesBuffers) {
+  BufferPool pool;
+  auto buffer = pool.Acquire(128 * 1024);
+  char const* data = buffer.data();
+  pool.Release(std::move(buffer));
+
+  // A smaller request in the same size class gets the same buffer back.
+  auto reused = pool.Acquire(100 * 1024);
+  EXPECT_EQ(data, reused.data());
+  EXPECT_EQ(100 * 1024U, reused.size());
+
+  auto stats = pool.statistics();
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.returns);
+  EXPECT_EQ(0U, stats.discards);
+}
+
+TEST(BufferPoolTest, SizeClassesAreSeparate) {
+  BufferPool pool;
+  pool.Release(pool.Acquire(16 * 1024));
+  auto buffer = pool.Acquire(1024 * 1024);
+  EXPECT_EQ(1024 * 1024U, buffer.size());
+  EXPECT_EQ(0U, pool.statistics().hits);
+  EXPECT_EQ(2U, pool.statistics().misses);
+}
+
+TEST(BufferPoolTest, DiscardsWhenFull) {
+  BufferPool pool;
+  // The largest size class only keeps one buffer.
+  auto a = pool.Acquire(BufferPool::kMaximumBufferSize);
+  auto b = pool.Acquire(BufferPool::kMaximumBufferSize);
+  pool.Release(std::move(a));
+  pool.Release(std::move(b));
+  auto stats = pool.statistics();
+  EXPECT_EQ(1U, stats.returns);
+  EXPECT_EQ(1U, stats.discards);
+}
+
+TEST(BufferPoolTest, IgnoresSmallAndLargeBuffers) {
+  BufferPool pool;
+  pool.Release(std::string{});
+  EXPECT_EQ(0U, pool.statistics().returns);
+
+  auto large = pool.Acquire(BufferPool::kMaximumBufferSize + 1);
+  EXPECT_EQ(BufferPool::kMaximumBufferSize + 1, large.size());
+  EXPECT_EQ(1U, pool.statistics().misses);
+}
+
+TEST(BufferPoolTest, NullPool) {
+  auto buffer = internal::AcquireBuffer(nullptr, 1024);
+  EXPECT_EQ(1024U, buffer.size());
+  internal::ReleaseBuffer(nullptr, std::move(buffer));
+}
+
+TEST(BufferPoolTest, ManyThreads) {
+  BufferPool pool;
+  auto constexpr kThreads = 8U;
+  auto constexpr kIterations = 1000U;
+  auto worker = [&pool] {
+    for (auto i = 0U; i != kIterations; ++i) {
+      auto buffer = pool.Acquire(16 * 1024);
+      buffer[0] = 'a';
+      buffer[buffer.size() - 1] = 'z';
+      pool.Release(std::move(buffer));
+    }
+  };
+  std::vector<std::future<void>> tasks;
+  for (auto i = 0U; i != kThreads; ++i) {
+    tasks.push_back(std::async(std::launch::async, worker));
+  }
+  for (auto& t : tasks) {
+    t.get();
+  }
+  auto stats = pool.statistics();
+  EXPECT_EQ(kThreads * kIterations, stats.hits + stats.misses);
+  EXPECT_EQ(kThreads * kIterations, stats.returns + stats.discards);
+  // With at most kThreads buffers in use at a time, the pool has room for all
+  // of them.
+  EXPECT_GE(kThreads, stats.misses);
+  EXPECT_EQ(0U, stats.discards);
+}
+
+TEST(BufferPoolTest, Statistics) {
+  BufferPoolStatistics stats;
+  stats.hits = 1;
+  stats.misses = 2;
+  stats.returns = 3;
+  stats.discards = 4;
+  std::ostringstream os;
+  os << stats;
+  EXPECT_EQ("hits=1, misses=2, returns=3, discards=4", os.str());
+}
+
+TEST(BufferPoolTest, SharedByClientOptions) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  // The pool is opt-in.
+  EXPECT_FALSE(options.buffer_pool());
+  options.set_buffer_pool(std::make_shared<BufferPool>());
+  ASSERT_TRUE(options.buffer_pool());
+  ClientOptions copy = options;
+  EXPECT_EQ(options.buffer_pool(), copy.buffer_pool());
+  copy.set_buffer_pool({});
+  EXPECT_FALSE(copy.buffer_pool());
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
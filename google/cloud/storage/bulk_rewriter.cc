@@ -0,0 +1,308 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/bulk_rewriter.h"
+#include "google/cloud/log.h"
+#include "google/cloud/storage/internal/adaptive_concurrency_limiter.h"
+#include "google/cloud/storage/internal/nljson.h"
+#include "google/cloud/storage/object_rewriter.h"
+#include "google/cloud/storage/transfer_metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+Status SaveCheckpoint(std::string const& checkpoint_file,
+                      std::string const& contents) {
+  // Write to a temporary file and rename it, so an interrupted write does not
+  // destroy the previous checkpoint.
+  auto const tmp = checkpoint_file + ".tmp";
+  {
+    std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+    if (!os.is_open()) {
+      return Status(StatusCode::kFailedPrecondition,
+                    "cannot open checkpoint file " + tmp);
+    }
+    os << contents;
+    os.close();
+    if (!os.good()) {
+      return Status(StatusCode::kDataLoss,
+                    "error writing checkpoint file " + tmp);
+    }
+  }
+  if (std::rename(tmp.c_str(), checkpoint_file.c_str()) != 0) {
+    return Status(StatusCode::kFailedPrecondition,
+                  "cannot rename checkpoint file to " + checkpoint_file);
+  }
+  return Status();
+}
+}  // namespace
+
+BulkRewriter::BulkRewriter(std::shared_ptr<internal::RawClient> client,
+                           std::string source_bucket_name,
+                           std::string destination_bucket_name,
+                           std::vector<BulkRewriteObject> objects,
+                           ApplyOptions apply_options)
+    : client_(std::move(client)),
+      source_bucket_name_(std::move(source_bucket_name)),
+      destination_bucket_name_(std::move(destination_bucket_name)),
+      objects_(std::move(objects)),
+      apply_options_(std::move(apply_options)) {
+  ResetProgress();
+}
+
+StatusOr<BulkRewriter> BulkRewriter::Restore(
+    std::shared_ptr<internal::RawClient> client,
+    std::string const& checkpoint_file, ApplyOptions apply_options) {
+  std::ifstream is(checkpoint_file, std::ios::binary);
+  if (!is.is_open()) {
+    return Status(StatusCode::kNotFound,
+                  "cannot open checkpoint file " + checkpoint_file);
+  }
+  std::string contents{std::istreambuf_iterator<char>{is}, {}};
+  auto json = internal::nl::json::parse(contents, nullptr, false);
+  if (!json.is_object() || !json["objects"].is_array()) {
+    return Status(StatusCode::kInvalidArgument,
+                  "invalid checkpoint file " + checkpoint_file);
+  }
+  std::vector<BulkRewriteObject> objects;
+  for (auto const& o : json["objects"]) {
+    BulkRewriteObject object;
+    object.source_object = o.value("source", "");
+    object.destination_object = o.value("destination", "");
+    object.done = o.value("done", false);
+    object.total_bytes_rewritten =
+        o.value("total_bytes_rewritten", std::uint64_t(0));
+    object.object_size = o.value("object_size", std::uint64_t(0));
+    // Failed rewrites restart from the beginning, their token is not saved.
+    object.rewrite_token = o.value("rewrite_token", "");
+    objects.push_back(std::move(object));
+  }
+  BulkRewriter rewriter(std::move(client), json.value("source_bucket", ""),
+                        json.value("destination_bucket", ""),
+                        std::move(objects), std::move(apply_options));
+  rewriter.set_checkpoint_file(checkpoint_file);
+  return rewriter;
+}
+
+Status BulkRewriter::RunWithProgressCallback(ProgressCallback cb) {
+  std::deque<std::size_t> pending;
+  for (std::size_t i = 0; i != objects_.size(); ++i) {
+    if (!objects_[i].done) {
+      objects_[i].status = Status();
+      pending.push_back(i);
+    }
+  }
+  ResetProgress();
+
+  internal::AdaptiveConcurrencyLimiter limiter(initial_concurrency_,
+                                               max_concurrency_);
+  concurrency_limit_ = limiter.limit();
+  std::mutex mu;
+  auto last_checkpoint = std::chrono::steady_clock::now();
+  bool saving_checkpoint = false;
+  Status checkpoint_status;
+  // A `std::deque<>` so the workers can add threads while `Run()` joins them.
+  std::deque<std::thread> threads;
+
+  // Saves @p contents outside the lock, at most one thread writes at a time.
+  auto save_checkpoint = [&](std::unique_lock<std::mutex>& lk,
+                             std::string contents) {
+    saving_checkpoint = true;
+    lk.unlock();
+    auto status = SaveCheckpoint(checkpoint_file_, contents);
+    lk.lock();
+    saving_checkpoint = false;
+    if (!status.ok()) {
+      GCP_LOG(WARNING) << "cannot save checkpoint: " << status;
+      checkpoint_status = std::move(status);
+    }
+  };
+
+  std::function<void()> worker = [&] {
+    std::unique_lock<std::mutex> lk(mu);
+    while (!pending.empty()) {
+      auto const index = pending.front();
+      pending.pop_front();
+      internal::RewriteObjectRequest request(
+          source_bucket_name_, objects_[index].source_object,
+          destination_bucket_name_, objects_[index].destination_object,
+          objects_[index].rewrite_token);
+      lk.unlock();
+      if (apply_options_) {
+        apply_options_(request);
+      }
+      ObjectRewriter rewriter(client_, std::move(request));
+      for (bool done = false; !done;) {
+        // Each call takes its own slot, so large objects do not block other
+        // objects between calls.
+        auto permit = limiter.Acquire();
+        auto const overloads = internal::OverloadResponseCount();
+        auto progress = rewriter.Iterate();
+        if (internal::OverloadResponseCount() != overloads) {
+          // The client retried an overload error, the call was slowed down
+          // by the service even if it eventually succeeded.
+          limiter.Release(permit, Status(StatusCode::kUnavailable,
+                                         "service overloaded"),
+                          503);
+        } else {
+          limiter.Release(permit, progress.status(),
+                          internal::LastHttpStatusCode());
+        }
+
+        lk.lock();
+        auto& object = objects_[index];
+        total_bytes_rewritten_ -= object.total_bytes_rewritten;
+        total_bytes_ -= object.object_size;
+        if (!progress) {
+          object.status = std::move(progress).status();
+          object.rewrite_token.clear();
+          ++failed_objects_;
+          done = true;
+        } else {
+          object.total_bytes_rewritten = progress->total_bytes_rewritten;
+          object.object_size = progress->object_size;
+          object.rewrite_token = rewriter.token();
+          object.done = progress->done;
+          if (object.done) ++completed_objects_;
+          done = progress->done;
+        }
+        total_bytes_rewritten_ += object.total_bytes_rewritten;
+        total_bytes_ += object.object_size;
+        concurrency_limit_ = limiter.limit();
+        if (cb) {
+          cb(CurrentProgress());
+        }
+        // Add a thread when the limit has room for more concurrent calls.
+        if (!pending.empty() && threads.size() < max_concurrency_ &&
+            static_cast<double>(threads.size()) < concurrency_limit_) {
+          threads.emplace_back(worker);
+        }
+        auto const now = std::chrono::steady_clock::now();
+        if (!checkpoint_file_.empty() && !saving_checkpoint &&
+            now - last_checkpoint >= checkpoint_interval_) {
+          last_checkpoint = now;
+          save_checkpoint(lk, Checkpoint());
+        }
+        lk.unlock();
+      }
+      lk.lock();
+    }
+  };
+
+  std::unique_lock<std::mutex> lk(mu);
+  auto const initial_threads = (std::min)(
+      (std::min)(initial_concurrency_, max_concurrency_), pending.size());
+  for (std::size_t i = 0; i != initial_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  // Threads are only added by running threads, once all the threads seen so
+  // far have exited no more threads can be added.
+  for (std::size_t i = 0; i != threads.size(); ++i) {
+    auto& t = threads[i];
+    lk.unlock();
+    t.join();
+    lk.lock();
+  }
+
+  if (!checkpoint_file_.empty()) {
+    save_checkpoint(lk, Checkpoint());
+  }
+  lk.unlock();
+
+  std::size_t failed = 0;
+  Status first_failure;
+  std::string first_failure_name;
+  for (auto const& object : objects_) {
+    if (object.status.ok()) {
+      continue;
+    }
+    if (failed++ == 0) {
+      first_failure = object.status;
+      first_failure_name = object.source_object;
+    }
+  }
+  if (failed != 0) {
+    std::ostringstream os;
+    os << "bulk rewrite failed for " << failed << " of " << objects_.size()
+       << " objects, first failure for " << first_failure_name << ": "
+       << first_failure.message();
+    return Status(first_failure.code(), os.str());
+  }
+  return checkpoint_status;
+}
+
+BulkRewriteProgress BulkRewriter::CurrentProgress() const {
+  return BulkRewriteProgress{objects_.size(), completed_objects_,
+                             failed_objects_, total_bytes_rewritten_,
+                             total_bytes_,    concurrency_limit_};
+}
+
+void BulkRewriter::ResetProgress() {
+  completed_objects_ = 0;
+  failed_objects_ = 0;
+  total_bytes_rewritten_ = 0;
+  total_bytes_ = 0;
+  for (auto const& object : objects_) {
+    if (object.done) {
+      ++completed_objects_;
+    }
+    if (!object.status.ok()) {
+      ++failed_objects_;
+    }
+    total_bytes_rewritten_ += object.total_bytes_rewritten;
+    total_bytes_ += object.object_size;
+  }
+}
+
+std::string BulkRewriter::Checkpoint() const {
+  internal::nl::json objects = internal::nl::json::array();
+  for (auto const& object : objects_) {
+    internal::nl::json o{
+        {"source", object.source_object},
+        {"destination", object.destination_object},
+        {"done", object.done},
+        {"total_bytes_rewritten", object.total_bytes_rewritten},
+        {"object_size", object.object_size},
+    };
+    if (!object.rewrite_token.empty()) {
+      o["rewrite_token"] = object.rewrite_token;
+    }
+    if (!object.status.ok()) {
+      o["error"] = object.status.message();
+    }
+    objects.push_back(std::move(o));
+  }
+  internal::nl::json json{
+      {"source_bucket", source_bucket_name_},
+      {"destination_bucket", destination_bucket_name_},
+      {"objects", std::move(objects)},
+  };
+  return json.dump();
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
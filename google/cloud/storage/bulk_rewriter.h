@@ -0,0 +1,216 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BULK_REWRITER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BULK_REWRITER_H_
+
+#include "google/cloud/status_or.h"
+#include "google/cloud/storage/internal/raw_client.h"
+#include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/// The state of a single object copied by a `BulkRewriter`.
+struct BulkRewriteObject {
+  std::string source_object;
+  std::string destination_object;
+  /// The token to resume a partially completed rewrite, empty if not started.
+  std::string rewrite_token;
+  std::uint64_t total_bytes_rewritten = 0;
+  std::uint64_t object_size = 0;
+  bool done = false;
+  /// The error for objects that failed to copy, `OK` otherwise.
+  Status status;
+};
+
+/// The aggregate progress of a `BulkRewriter`.
+struct BulkRewriteProgress {
+  std::size_t total_objects;
+  std::size_t completed_objects;
+  std::size_t failed_objects;
+  std::uint64_t total_bytes_rewritten;
+  /// The total size of the objects whose size is known, i.e., started.
+  std::uint64_t total_bytes;
+  /// The current limit on concurrent rewrite calls.
+  double concurrency_limit;
+};
+
+/**
+ * Copies many objects between two buckets using concurrent rewrites.
+ *
+ * Each object is copied using an `ObjectRewriter`, but many objects are
+ * copied at the same time, and each rewrite resumes with its own rewrite
+ * token. Objects that require multiple calls release their slot between
+ * calls, so other objects make progress while large objects are copied.
+ *
+ * The number of concurrent calls adapts to the service: it grows while the
+ * calls succeed and is halved when the service reports it is overloaded, up to
+ * `max_concurrency()`. Overload errors that are retried by the client, and thus
+ * not visible to the application, also halve the limit. Each concurrent call
+ * runs in its own thread, the rewriter starts new threads as the limit grows.
+ *
+ * If a checkpoint file is configured the state of all the objects, including
+ * the rewrite tokens, is saved periodically. An interrupted copy can be
+ * resumed with `Client::ResumeBulkRewriter()`. Objects that failed are tried
+ * again when the copy is resumed.
+ *
+ * @par Example
+ * @code
+ * auto rewriter = client.CreateBulkRewriterForPrefix(
+ *     "source-bucket", "logs/", "destination-bucket", "archive/logs/");
+ * if (!rewriter) throw std::runtime_error(rewriter.status().message());
+ * rewriter->set_checkpoint_file("/var/tmp/logs-migration.json");
+ * auto status = rewriter->RunWithProgressCallback(
+ *     [](gcs::BulkRewriteProgress const& p) {
+ *       std::cout << p.completed_objects << "/" << p.total_objects << "\r";
+ *     });
+ * @endcode
+ */
+class BulkRewriter {
+ public:
+  using ProgressCallback = std::function<void(BulkRewriteProgress const&)>;
+  using ApplyOptions = std::function<void(internal::RewriteObjectRequest&)>;
+
+  /**
+   * Creates a bulk rewriter.
+   *
+   * @param client the client used to make the rewrite calls.
+   * @param source_bucket_name the bucket containing the source objects.
+   * @param destination_bucket_name the bucket for the new objects.
+   * @param objects the objects to copy, objects already marked as done are
+   *     skipped.
+   * @param apply_options sets the request options, such as encryption keys or
+   *     `UserProject`, on each rewrite request.
+   */
+  BulkRewriter(std::shared_ptr<internal::RawClient> client,
+               std::string source_bucket_name,
+               std::string destination_bucket_name,
+               std::vector<BulkRewriteObject> objects,
+               ApplyOptions apply_options = ApplyOptions{});
+
+  /**
+   * Creates a bulk rewriter from a checkpoint file.
+   *
+   * Objects that had failed when the checkpoint was saved are tried again. The
+   * request options are not saved in the checkpoint, the application must
+   * provide the same options used in the original copy.
+   */
+  static StatusOr<BulkRewriter> Restore(
+      std::shared_ptr<internal::RawClient> client,
+      std::string const& checkpoint_file,
+      ApplyOptions apply_options = ApplyOptions{});
+
+  /**
+   * The maximum number of concurrent rewrite calls.
+   *
+   * This is also the maximum number of threads created by the rewriter.
+   */
+  std::size_t max_concurrency() const { return max_concurrency_; }
+  BulkRewriter& set_max_concurrency(std::size_t v) {
+    max_concurrency_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /// The initial number of concurrent rewrite calls.
+  std::size_t initial_concurrency() const { return initial_concurrency_; }
+  BulkRewriter& set_initial_concurrency(std::size_t v) {
+    initial_concurrency_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /// Where to save the checkpoints, empty disables checkpoints.
+  std::string const& checkpoint_file() const { return checkpoint_file_; }
+  BulkRewriter& set_checkpoint_file(std::string v) {
+    checkpoint_file_ = std::move(v);
+    return *this;
+  }
+
+  /// How often to save the checkpoints.
+  std::chrono::milliseconds checkpoint_interval() const {
+    return checkpoint_interval_;
+  }
+  BulkRewriter& set_checkpoint_interval(std::chrono::milliseconds v) {
+    checkpoint_interval_ = v;
+    return *this;
+  }
+
+  /**
+   * Copies all the objects, blocking until all are done or have failed.
+   *
+   * @return `OK` if all the objects were copied, otherwise the status of the
+   *     first failure. Use `objects()` to examine the status of each object.
+   */
+  Status Run() { return RunWithProgressCallback(ProgressCallback{}); }
+
+  /**
+   * Copies all the objects reporting the progress after each rewrite call.
+   *
+   * The callback is invoked from the threads making the calls, but never
+   * concurrently.
+   */
+  Status RunWithProgressCallback(ProgressCallback cb);
+
+  /// The current state of each object.
+  std::vector<BulkRewriteObject> const& objects() const { return objects_; }
+
+  /// The aggregate progress, this is a constant time operation.
+  BulkRewriteProgress CurrentProgress() const;
+
+  /// Serializes the state of the rewriter, as saved in the checkpoint file.
+  std::string Checkpoint() const;
+
+ private:
+  /// Recomputes the aggregate progress from `objects_`.
+  void ResetProgress();
+
+  std::shared_ptr<internal::RawClient> client_;
+  std::string source_bucket_name_;
+  std::string destination_bucket_name_;
+  std::vector<BulkRewriteObject> objects_;
+  ApplyOptions apply_options_;
+  std::size_t max_concurrency_ = 64;
+  std::size_t initial_concurrency_ = 8;
+  std::string checkpoint_file_;
+  std::chrono::milliseconds checkpoint_interval_ = std::chrono::seconds(10);
+  double concurrency_limit_ = 0;
+  std::size_t completed_objects_ = 0;
+  std::size_t failed_objects_ = 0;
+  std::uint64_t total_bytes_rewritten_ = 0;
+  std::uint64_t total_bytes_ = 0;
+};
+
+namespace internal {
+/// Captures @p options to apply them to each request in a `BulkRewriter`.
+template <typename... Options>
+BulkRewriter::ApplyOptions MakeBulkRewriteOptions(Options&&... options) {
+  return [options...](RewriteObjectRequest& request) {
+    request.set_multiple_options(
+        typename std::decay<Options>::type(options)...);
+  };
+}
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_BULK_REWRITER_H_
@@ -0,0 +1,284 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/bulk_rewriter.h"
+#include "google/cloud/internal/random.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/internal/metadata_parser.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/storage/transfer_metrics.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::ReturnRef;
+
+StatusOr<internal::RewriteObjectResponse> MakeResponse(
+    std::uint64_t rewritten, std::uint64_t size, std::string token) {
+  internal::RewriteObjectResponse response;
+  response.total_bytes_rewritten = rewritten;
+  response.object_size = size;
+  response.done = token.empty();
+  response.rewrite_token = std::move(token);
+  return response;
+}
+
+class BulkRewriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mock_ = std::make_shared<testing::MockClient>();
+    EXPECT_CALL(*mock_, client_options())
+        .WillRepeatedly(ReturnRef(client_options_));
+    checkpoint_file_ = ::testing::TempDir() + "bulk-rewriter-" +
+                       google::cloud::internal::Sample(
+                           generator_, 8, "abcdefghijklmnopqrstuvwxyz") +
+                       ".json";
+  }
+
+  void TearDown() override { std::remove(checkpoint_file_.c_str()); }
+
+  std::shared_ptr<testing::MockClient> mock_;
+  ClientOptions client_options_ =
+      ClientOptions(oauth2::CreateAnonymousCredentials());
+  google::cloud::internal::DefaultPRNG generator_ =
+      google::cloud::internal::MakeDefaultPRNG();
+  std::string checkpoint_file_;
+};
+
+TEST_F(BulkRewriterTest, CopiesAllObjects) {
+  // Each object takes two calls, the second call resumes with the token from
+  // the first call.
+  EXPECT_CALL(*mock_, RewriteObject(_))
+      .Times(40)
+      .WillRepeatedly(Invoke([](internal::RewriteObjectRequest const& r) {
+        EXPECT_EQ("source-bucket", r.source_bucket());
+        EXPECT_EQ("destination-bucket", r.destination_bucket());
+        EXPECT_EQ("copy/" + r.source_object(), r.destination_object());
+        EXPECT_TRUE(r.HasOption<MaxBytesRewrittenPerCall>());
+        if (r.rewrite_token().empty()) {
+          return MakeResponse(512, 1024, "token-" + r.source_object());
+        }
+        EXPECT_EQ("token-" + r.source_object(), r.rewrite_token());
+        return MakeResponse(1024, 1024, "");
+      }));
+
+  std::vector<std::string> names;
+  for (int i = 0; i != 20; ++i) {
+    names.push_back("object-" + std::to_string(i));
+  }
+  Client client(std::shared_ptr<internal::RawClient>(mock_),
+                Client::NoDecorations{});
+  auto rewriter = client.CreateBulkRewriter("source-bucket", names,
+                                            "destination-bucket", "copy/",
+                                            MaxBytesRewrittenPerCall(512));
+  rewriter.set_max_concurrency(4).set_initial_concurrency(2);
+
+  std::atomic<int> callbacks(0);
+  auto status = rewriter.RunWithProgressCallback(
+      [&callbacks](BulkRewriteProgress const& p) {
+        EXPECT_EQ(20U, p.total_objects);
+        EXPECT_EQ(0U, p.failed_objects);
+        EXPECT_LE(p.concurrency_limit, 4.0);
+        ++callbacks;
+      });
+  EXPECT_STATUS_OK(status);
+  EXPECT_EQ(40, callbacks.load());
+
+  auto progress = rewriter.CurrentProgress();
+  EXPECT_EQ(20U, progress.completed_objects);
+  EXPECT_EQ(20U * 1024, progress.total_bytes_rewritten);
+  EXPECT_EQ(20U * 1024, progress.total_bytes);
+  for (auto const& o : rewriter.objects()) {
+    EXPECT_TRUE(o.done) << o.source_object;
+    EXPECT_TRUE(o.rewrite_token.empty());
+  }
+}
+
+TEST_F(BulkRewriterTest, CheckpointAndResume) {
+  EXPECT_CALL(*mock_, RewriteObject(_))
+      .WillRepeatedly(Invoke([](internal::RewriteObjectRequest const& r) {
+        if (r.source_object() == "b") {
+          return StatusOr<internal::RewriteObjectResponse>(PermanentError());
+        }
+        return MakeResponse(10, 10, "");
+      }));
+
+  std::vector<BulkRewriteObject> objects(3);
+  objects[0].source_object = objects[0].destination_object = "a";
+  objects[1].source_object = objects[1].destination_object = "b";
+  objects[2].source_object = objects[2].destination_object = "c";
+  BulkRewriter rewriter(mock_, "source-bucket", "destination-bucket",
+                        std::move(objects));
+  rewriter.set_checkpoint_file(checkpoint_file_);
+  auto status = rewriter.Run();
+  EXPECT_EQ(PermanentError().code(), status.code());
+  EXPECT_THAT(status.message(), HasSubstr("1 of 3"));
+  EXPECT_THAT(status.message(), HasSubstr("for b"));
+  EXPECT_EQ(1U, rewriter.CurrentProgress().failed_objects);
+
+  // Resume the copy, only the failed object is copied again.
+  ::testing::Mock::VerifyAndClearExpectations(mock_.get());
+  EXPECT_CALL(*mock_, RewriteObject(_))
+      .WillOnce(Invoke([](internal::RewriteObjectRequest const& r) {
+        EXPECT_EQ("b", r.source_object());
+        EXPECT_EQ("", r.rewrite_token());
+        return MakeResponse(10, 10, "");
+      }));
+  auto resumed = BulkRewriter::Restore(mock_, checkpoint_file_);
+  ASSERT_STATUS_OK(resumed);
+  EXPECT_EQ(checkpoint_file_, resumed->checkpoint_file());
+  ASSERT_EQ(3U, resumed->objects().size());
+  EXPECT_TRUE(resumed->objects()[0].done);
+  EXPECT_FALSE(resumed->objects()[1].done);
+  EXPECT_TRUE(resumed->objects()[2].done);
+  EXPECT_STATUS_OK(resumed->Run());
+  EXPECT_EQ(3U, resumed->CurrentProgress().completed_objects);
+}
+
+TEST_F(BulkRewriterTest, ResumeWithRewriteToken) {
+  {
+    std::ofstream os(checkpoint_file_);
+    os << R"""({"source_bucket": "source-bucket",
+      "destination_bucket": "destination-bucket",
+      "objects": [{"source": "large", "destination": "large-copy",
+                   "rewrite_token": "test-token", "done": false,
+                   "total_bytes_rewritten": 512, "object_size": 1024}]})""";
+  }
+  EXPECT_CALL(*mock_, RewriteObject(_))
+      .WillOnce(Invoke([](internal::RewriteObjectRequest const& r) {
+        EXPECT_EQ("source-bucket", r.source_bucket());
+        EXPECT_EQ("large", r.source_object());
+        EXPECT_EQ("destination-bucket", r.destination_bucket());
+        EXPECT_EQ("large-copy", r.destination_object());
+        EXPECT_EQ("test-token", r.rewrite_token());
+        return MakeResponse(1024, 1024, "");
+      }));
+
+  Client client(std::shared_ptr<internal::RawClient>(mock_),
+                Client::NoDecorations{});
+  auto rewriter = client.ResumeBulkRewriter(checkpoint_file_);
+  ASSERT_STATUS_OK(rewriter);
+  EXPECT_EQ(512U, rewriter->CurrentProgress().total_bytes_rewritten);
+  EXPECT_STATUS_OK(rewriter->Run());
+  EXPECT_EQ(1024U, rewriter->CurrentProgress().total_bytes_rewritten);
+
+  auto invalid = BulkRewriter::Restore(mock_, checkpoint_file_ + ".missing");
+  EXPECT_EQ(StatusCode::kNotFound, invalid.status().code());
+}
+
+TEST_F(BulkRewriterTest, RetriedOverloadErrorsDecreaseLimit) {
+  // Simulate a retry loop below the rewriter: the first attempt of each call
+  // gets a 503, the second attempt succeeds.
+  EXPECT_CALL(*mock_, RewriteObject(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([](internal::RewriteObjectRequest const& r) {
+        internal::SetLastHttpStatusCode(503);
+        internal::SetLastHttpStatusCode(200);
+        if (r.rewrite_token().empty()) {
+          return MakeResponse(512, 1024, "test-token");
+        }
+        return MakeResponse(1024, 1024, "");
+      }));
+
+  std::vector<BulkRewriteObject> objects(1);
+  objects[0].source_object = objects[0].destination_object = "a";
+  BulkRewriter rewriter(mock_, "source-bucket", "destination-bucket",
+                        std::move(objects));
+  rewriter.set_max_concurrency(4).set_initial_concurrency(4);
+  std::vector<double> limits;
+  EXPECT_STATUS_OK(rewriter.RunWithProgressCallback(
+      [&limits](BulkRewriteProgress const& p) {
+        limits.push_back(p.concurrency_limit);
+      }));
+  EXPECT_THAT(limits, ::testing::ElementsAre(2.0, 1.0));
+}
+
+TEST_F(BulkRewriterTest, AddsThreadsAsLimitGrows) {
+  std::atomic<int> in_flight(0);
+  std::atomic<int> max_in_flight(0);
+  EXPECT_CALL(*mock_, RewriteObject(_))
+      .Times(40)
+      .WillRepeatedly(Invoke([&](internal::RewriteObjectRequest const&) {
+        auto const current = ++in_flight;
+        for (auto m = max_in_flight.load(); m < current;) {
+          max_in_flight.compare_exchange_weak(m, current);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        --in_flight;
+        return MakeResponse(10, 10, "");
+      }));
+
+  std::vector<BulkRewriteObject> objects(40);
+  for (std::size_t i = 0; i != objects.size(); ++i) {
+    objects[i].source_object = "object-" + std::to_string(i);
+    objects[i].destination_object = objects[i].source_object;
+  }
+  BulkRewriter rewriter(mock_, "source-bucket", "destination-bucket",
+                        std::move(objects));
+  rewriter.set_max_concurrency(4).set_initial_concurrency(1);
+  EXPECT_STATUS_OK(rewriter.Run());
+  EXPECT_LT(1, max_in_flight.load());
+  EXPECT_GE(4, max_in_flight.load());
+  auto progress = rewriter.CurrentProgress();
+  EXPECT_EQ(40U, progress.completed_objects);
+  EXPECT_EQ(400U, progress.total_bytes_rewritten);
+}
+
+TEST_F(BulkRewriterTest, ForPrefix) {
+  EXPECT_CALL(*mock_, ListObjects(_))
+      .WillOnce(Invoke([](internal::ListObjectsRequest const& r) {
+        EXPECT_EQ("source-bucket", r.bucket_name());
+        EXPECT_EQ("logs/", r.GetOption<Prefix>().value());
+        internal::ListObjectsResponse response;
+        for (auto const* name : {"logs/a", "logs/b"}) {
+          response.items.push_back(
+              internal::ObjectMetadataParser::FromString(
+                  std::string(R"""({"name": ")""") + name + R"""("})""")
+                  .value());
+        }
+        return make_status_or(response);
+      }));
+
+  Client client(std::shared_ptr<internal::RawClient>(mock_),
+                Client::NoDecorations{});
+  auto rewriter = client.CreateBulkRewriterForPrefix(
+      "source-bucket", "logs/", "destination-bucket", "archive/");
+  ASSERT_STATUS_OK(rewriter);
+  ASSERT_EQ(2U, rewriter->objects().size());
+  EXPECT_EQ("logs/a", rewriter->objects()[0].source_object);
+  EXPECT_EQ("archive/a", rewriter->objects()[0].destination_object);
+  EXPECT_EQ("logs/b", rewriter->objects()[1].source_object);
+  EXPECT_EQ("archive/b", rewriter->objects()[1].destination_object);
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -16,8 +16,12 @@
 #include "google/cloud/internal/filesystem.h"
 #include "google/cloud/internal/make_unique.h"
 #include "google/cloud/log.h"
+#include "google/cloud/storage/internal/adaptive_concurrency_client.h"
+#include "google/cloud/storage/internal/caching_client.h"
+#include "google/cloud/storage/internal/coalescing_client.h"
 #include "google/cloud/storage/internal/curl_client.h"
 #include "google/cloud/storage/internal/curl_handle.h"
+#include "google/cloud/storage/internal/metrics_client.h"
 #include "google/cloud/storage/internal/openssl_util.h"
 #include "google/cloud/storage/oauth2/service_account_credentials.h"
 #include <openssl/md5.h>
@@ -35,7 +39,52 @@ static_assert(std::is_copy_assignable<storage::Client>::value,
 
 std::shared_ptr<internal::RawClient> Client::CreateDefaultInternalClient(
     ClientOptions options) {
-  return internal::CurlClient::Create(std::move(options));
+  auto const initial_limit = options.adaptive_concurrency_initial_limit();
+  auto const maximum_limit = options.adaptive_concurrency_maximum_limit();
+  auto const recorder = options.metrics_recorder();
+  std::shared_ptr<internal::RawClient> client =
+      internal::CurlClient::Create(std::move(options));
+  if (recorder) {
+    // Below the limiter, the latency does not include the time waiting for a
+    // slot.
+    client = std::make_shared<internal::MetricsClient>(std::move(client),
+                                                       recorder);
+  }
+  if (initial_limit == 0) {
+    return client;
+  }
+  // The limiter is installed below the retry loop, each attempt takes its own
+  // slot and the backoff between attempts does not hold one.
+  return std::make_shared<internal::AdaptiveConcurrencyClient>(
+      std::move(client), initial_limit, maximum_limit);
+}
+
+std::shared_ptr<internal::RawClient> Client::AddDiskCache(
+    std::shared_ptr<internal::RawClient> client, ClientOptions const& options) {
+  if (options.disk_cache_directory().empty()) {
+    return client;
+  }
+#if _WIN32
+  GCP_LOG(WARNING) << "the disk cache is not supported on this platform,"
+                   << " ignoring disk_cache_directory="
+                   << options.disk_cache_directory();
+  return client;
+#else
+  return std::make_shared<internal::CachingClient>(
+      std::move(client),
+      internal::ObjectDiskCache(options.disk_cache_directory(),
+                                options.disk_cache_max_size()));
+#endif  // _WIN32
+}
+
+std::shared_ptr<internal::RawClient> Client::AddReadCoalescing(
+    std::shared_ptr<internal::RawClient> client, ClientOptions const& options) {
+  if (!options.enable_read_coalescing()) {
+    return client;
+  }
+  // Installed above the retry loop and the disk cache, the readers share a
+  // single download, including any retries.
+  return std::make_shared<internal::CoalescingClient>(std::move(client));
 }
 
 StatusOr<Client> Client::CreateDefaultClient() {
@@ -48,7 +97,17 @@ StatusOr<Client> Client::CreateDefaultClient() {
 
 ObjectReadStream Client::ReadObjectImpl(
     internal::ReadObjectRangeRequest const& request) {
-  auto source = raw_client_->ReadObject(request);
+  StatusOr<std::unique_ptr<internal::ObjectReadSource>> source;
+  if (request.RequiresGzipDecompression() && request.RequiresRangeHeader()) {
+    // Ranges refer to the compressed data, which cannot be decompressed
+    // starting at an arbitrary offset.
+    std::ostringstream os;
+    os << __func__ << "(" << request
+       << "): ranged reads cannot be combined with gzip decompression";
+    source = Status(StatusCode::kInvalidArgument, std::move(os).str());
+  } else {
+    source = raw_client_->ReadObject(request);
+  }
   if (!source) {
     ObjectReadStream error_stream(
         google::cloud::internal::make_unique<internal::ObjectReadStreambuf>(
@@ -58,7 +117,8 @@ ObjectReadStream Client::ReadObjectImpl(
   }
   auto stream = ObjectReadStream(
       google::cloud::internal::make_unique<internal::ObjectReadStreambuf>(
-          request, *std::move(source)));
+          request, *std::move(source),
+          raw_client_->client_options().buffer_pool()));
   (void)stream.peek();
 #if !GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
   // Without exceptions the streambuf cannot report errors, so we have to
@@ -72,7 +132,24 @@ ObjectReadStream Client::ReadObjectImpl(
 
 ObjectWriteStream Client::WriteObjectImpl(
     internal::ResumableUploadRequest const& request) {
-  auto session = raw_client_->CreateResumableSession(request);
+  bool const gzip = request.HasOption<GzipCompression>() &&
+                    request.GetOption<GzipCompression>().value();
+  StatusOr<std::unique_ptr<internal::ResumableUploadSession>> session;
+  if (!gzip) {
+    session = raw_client_->CreateResumableSession(request);
+  } else if (request.HasOption<UseResumableUploadSession>() &&
+             !request.GetOption<UseResumableUploadSession>().value().empty()) {
+    // The state of the compressor is not part of the session, so compressed
+    // uploads cannot continue where a previous upload stopped.
+    std::ostringstream os;
+    os << __func__ << "(" << request
+       << "): cannot restore a resumable upload session with gzip compression";
+    session = Status(StatusCode::kInvalidArgument, std::move(os).str());
+  } else {
+    auto compressed_request = request;
+    compressed_request.set_option(ContentEncoding("gzip"));
+    session = raw_client_->CreateResumableSession(compressed_request);
+  }
   if (!session) {
     auto error = google::cloud::internal::make_unique<
         internal ::ResumableUploadSessionError>(std::move(session).status());
@@ -85,11 +162,17 @@ ObjectWriteStream Client::WriteObjectImpl(
     error_stream.Close();
     return error_stream;
   }
+  std::unique_ptr<internal::GzipCompressor> compressor;
+  if (gzip) {
+    compressor =
+        google::cloud::internal::make_unique<internal::GzipCompressor>();
+  }
   return ObjectWriteStream(
       google::cloud::internal::make_unique<internal::ObjectWriteStreambuf>(
           *std::move(session),
           raw_client_->client_options().upload_buffer_size(),
-          internal::CreateHashValidator(request)));
+          internal::CreateHashValidator(request),
+          raw_client_->client_options().buffer_pool(), std::move(compressor)));
 }
 
 bool Client::UseSimpleUpload(std::string const& file_name) const {
@@ -143,9 +226,36 @@ integrity checks using the DisableMD5Hash() and DisableCrc32cChecksum() options.
        << "): cannot open upload file source";
     return Status(StatusCode::kNotFound, std::move(os).str());
   }
+  if (request.HasOption<GzipCompression>() &&
+      request.GetOption<GzipCompression>().value()) {
+    return UploadStreamCompressed(source, request);
+  }
   return UploadStreamResumable(source, request);
 }
 
+StatusOr<ObjectMetadata> Client::UploadStreamCompressed(
+    std::istream& source, internal::ResumableUploadRequest const& request) {
+  // The compressed size is not known in advance, so we cannot restart the
+  // upload from the source file, reuse the streaming upload instead.
+  auto stream = WriteObjectImpl(request);
+  std::string buffer(internal::UploadChunkRequest::RoundUpToQuantum(
+                         raw_client()->client_options().upload_buffer_size()),
+                     '\0');
+  while (stream && source.read(&buffer[0], buffer.size()).gcount() != 0) {
+    stream.write(buffer.data(), source.gcount());
+  }
+  if (source.bad()) {
+    // Finalizing the upload would create a truncated object. Abandon the
+    // session instead, the service discards it once it expires.
+    std::move(stream).Suspend();
+    std::ostringstream os;
+    os << __func__ << "(" << request << "): error reading upload source";
+    return Status(StatusCode::kUnknown, std::move(os).str());
+  }
+  stream.Close();
+  return stream.metadata();
+}
+
 StatusOr<ObjectMetadata> Client::UploadStreamResumable(
     std::istream& source, internal::ResumableUploadRequest const& request) {
   StatusOr<std::unique_ptr<internal::ResumableUploadSession>> session_status =
@@ -250,7 +360,6 @@ StatusOr<Client::SignBlobResponseRaw> Client::SignBlobImpl(
     SigningAccount const& signing_account, std::string const& string_to_sign) {
   auto credentials = raw_client()->client_options().credentials();
 
-  std::string signing_account_email = SigningEmail(signing_account);
   // First try to sign locally.
   auto signed_blob = credentials->SignBlob(signing_account, string_to_sign);
   if (signed_blob) {
@@ -261,7 +370,8 @@ StatusOr<Client::SignBlobResponseRaw> Client::SignBlobImpl(
   // support signing, or because the signing account is different than the
   // credentials account. In either case, try to sign using the API.
   internal::SignBlobRequest sign_request(
-      signing_account_email, internal::Base64Encode(string_to_sign), {});
+      SigningEmail(signing_account), internal::Base64Encode(string_to_sign),
+      {});
   auto response = raw_client()->SignBlob(sign_request);
   if (!response) {
     return response.status();
@@ -320,19 +430,8 @@ StatusOr<std::string> Client::SignUrlV4(internal::V4SignUrlRequest request) {
 
 StatusOr<PolicyDocumentResult> Client::SignPolicyDocument(
     internal::PolicyDocumentRequest const& request) {
-  SigningAccount const& signing_account = request.signing_account();
-  auto signing_email = SigningEmail(signing_account);
-
-  auto string_to_sign = request.StringToSign();
-  auto base64_policy = internal::Base64Encode(string_to_sign);
-  auto signed_blob = SignBlobImpl(signing_account, base64_policy);
-  if (!signed_blob) {
-    return signed_blob.status();
-  }
-
-  return PolicyDocumentResult{
-      signing_email, request.policy_document().expiration, base64_policy,
-      internal::Base64Encode(signed_blob->signed_blob)};
+  return PolicyDocumentSigner(raw_client_, request.signing_account())
+      .Sign(request.policy_document());
 }
 
 }  // namespace STORAGE_CLIENT_NS
@@ -19,6 +19,7 @@
 #include "google/cloud/internal/throw_delegate.h"
 #include "google/cloud/status.h"
 #include "google/cloud/status_or.h"
+#include "google/cloud/storage/bulk_rewriter.h"
 #include "google/cloud/storage/hmac_key_metadata.h"
 #include "google/cloud/storage/internal/logging_client.h"
 #include "google/cloud/storage/internal/policy_document_request.h"
@@ -30,8 +31,11 @@
 #include "google/cloud/storage/notification_event_type.h"
 #include "google/cloud/storage/notification_payload_format.h"
 #include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/object_random_access_reader.h"
 #include "google/cloud/storage/object_rewriter.h"
 #include "google/cloud/storage/object_stream.h"
+#include "google/cloud/storage/parallel_object_reader.h"
+#include "google/cloud/storage/policy_document_signer.h"
 #include "google/cloud/storage/retry_policy.h"
 #include "google/cloud/storage/upload_options.h"
 #include "google/cloud/storage/version.h"
@@ -40,6 +44,10 @@ namespace google {
 namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+struct ClientImplDetails;
+}  // namespace internal
+
 /**
  * The Google Cloud Storage (GCS) Client.
  *
@@ -193,8 +201,12 @@ class Client {
    */
   template <typename... Policies>
   explicit Client(ClientOptions options, Policies&&... policies)
-      : Client(CreateDefaultInternalClient(std::move(options)),
-               std::forward<Policies>(policies)...) {}
+      : raw_client_(Decorate(CreateDefaultInternalClient(options),
+                             options.tracing_sampling(),
+                             std::forward<Policies>(policies)...)) {
+    raw_client_ = AddReadCoalescing(
+        AddDiskCache(std::move(raw_client_), options), options);
+  }
 
   /**
    * Creates the default client type given the credentials and policies.
@@ -222,8 +234,8 @@ class Client {
   template <typename... Policies>
   explicit Client(std::shared_ptr<internal::RawClient> client,
                   Policies&&... policies)
-      : raw_client_(
-            Decorate(std::move(client), std::forward<Policies>(policies)...)) {}
+      : raw_client_(Decorate(std::move(client), TracingSampling(),
+                             std::forward<Policies>(policies)...)) {}
 
   /// Define a tag to disable automatic decorations of the RawClient.
   struct NoDecorations {};
@@ -847,7 +859,7 @@ class Client {
    * @param bucket_name the bucket containing the object.
    * @param object_name the object name.
    * @param options a list of optional query parameters and/or request headers.
-   *     Valid types for this operation include `Generation`,
+   *     Valid types for this operation include `EncryptionKey`, `Generation`,
    *     `IfGenerationMatch`, `IfGenerationNotMatch`, `IfMetagenerationMatch`,
    *     `IfMetagenerationNotMatch`, `Projection`, and `UserProject`.
    *
@@ -893,6 +905,36 @@ class Client {
                              });
   }
 
+  /**
+   * Lists the objects in a bucket, returning only a summary for each object.
+   *
+   * This is more efficient than `ListObjects()` when listing large buckets
+   * and the application only needs the name, generation, size, and CRC32C
+   * checksum of each object. Only these fields are requested from the
+   * service (unless the application provides a `Fields` option), and the
+   * results are stored in a compact representation.
+   *
+   * @param bucket_name the name of the bucket to list.
+   * @param options a list of optional query parameters and/or request headers.
+   *     Valid types for this operation include
+   *     `IfMetagenerationMatch`, `IfMetagenerationNotMatch`, `UserProject`,
+   *     `Prefix`, and `Versions`.
+   *
+   * @par Idempotency
+   * This is a read-only operation and is always idempotent.
+   */
+  template <typename... Options>
+  ListObjectSummariesReader ListObjectSummaries(std::string const& bucket_name,
+                                                Options&&... options) {
+    internal::ListObjectsRequest request(bucket_name);
+    request.set_multiple_options(std::forward<Options>(options)...);
+    auto client = raw_client_;
+    return ListObjectSummariesReader(
+        request, [client](internal::ListObjectsRequest const& r) {
+          return client->ListObjectSummaries(r);
+        });
+  }
+
   /**
    * Reads the contents of an object.
    *
@@ -909,9 +951,9 @@ class Client {
    * @param options a list of optional query parameters and/or request headers.
    *     Valid types for this operation include `DisableCrc32cChecksum`,
    *     `DisableMD5Hash`, `IfGenerationMatch`, `EncryptionKey`, `Generation`,
-   *     `IfGenerationMatch`, `IfGenerationNotMatch`, `IfMetagenerationMatch`,
-   *     `IfMetagenerationNotMatch`, `ReadFromOffset`, `ReadRange`, and
-   *     `UserProject`.
+   *     `GzipDecompression`, `IfGenerationMatch`, `IfGenerationNotMatch`,
+   *     `IfMetagenerationMatch`, `IfMetagenerationNotMatch`, `ReadFromOffset`,
+   *     `ReadRange`, and `UserProject`.
    *
    * @par Idempotency
    * This is a read-only operation and is always idempotent.
@@ -934,6 +976,65 @@ class Client {
     return ReadObjectImpl(request);
   }
 
+  /**
+   * Creates a `ParallelObjectReader` to read many objects concurrently.
+   *
+   * The returned object downloads the full contents of each object, using a
+   * pool of up to `max_concurrency()` threads, and returns the contents in
+   * completion order. This is more efficient than calling `ReadObject()` in a
+   * loop when reading many small objects.
+   *
+   * @param bucket_name the name of the bucket that contains the objects.
+   * @param object_names the names of the objects to read.
+   * @param options a list of optional query parameters and/or request headers,
+   *     applied to each download. Valid types for this operation include
+   *     `DisableCrc32cChecksum`, `DisableMD5Hash`, `EncryptionKey`,
+   *     `IfMetagenerationMatch`, `IfMetagenerationNotMatch`, and
+   *     `UserProject`.
+   *
+   * @par Idempotency
+   * This is a read-only operation and is always idempotent.
+   */
+  template <typename... Options>
+  ParallelObjectReader ReadObjects(std::string bucket_name,
+                                   std::vector<std::string> object_names,
+                                   Options&&... options) {
+    return ParallelObjectReader(raw_client_, std::move(bucket_name),
+                                std::move(object_names),
+                                internal::MakeParallelObjectReadOptions(
+                                    std::forward<Options>(options)...));
+  }
+
+  /**
+   * Creates an `ObjectRandomAccessReader` to read ranges of an object.
+   *
+   * Applications that read many small ranges from the same object should
+   * prefer this function over multiple calls to `ReadObject()` with a
+   * `ReadRange` option. The reader serves the ranges from a block cache, and
+   * coalesces nearby ranges into a single download.
+   *
+   * @param bucket_name the name of the bucket that contains the object.
+   * @param object_name the name of the object to be read.
+   * @param reader_options configure the block size, cache size, coalescing and
+   *     prefetching behavior of the reader.
+   * @param options a list of optional query parameters and/or request headers.
+   *     Valid types for this operation include `EncryptionKey`, `Generation`,
+   *     `IfGenerationMatch`, `IfGenerationNotMatch`, `IfMetagenerationMatch`,
+   *     `IfMetagenerationNotMatch`, and `UserProject`.
+   *
+   * @par Idempotency
+   * This is a read-only operation and is always idempotent.
+   */
+  template <typename... Options>
+  ObjectRandomAccessReader CreateRandomAccessReader(
+      std::string const& bucket_name, std::string const& object_name,
+      RandomAccessReaderOptions reader_options, Options&&... options) {
+    internal::ReadObjectRangeRequest request(bucket_name, object_name);
+    request.set_multiple_options(std::forward<Options>(options)...);
+    return ObjectRandomAccessReader(raw_client_, std::move(request),
+                                    std::move(reader_options));
+  }
+
   /**
    * Writes contents into an object.
    *
@@ -970,10 +1071,11 @@ class Client {
    * @param options a list of optional query parameters and/or request headers.
    *   Valid types for this operation include `ContentEncoding`, `ContentType`,
    *   `Crc32cChecksumValue`, `DisableCrc32cChecksum`, `DisableMD5Hash`,
-   *   `EncryptionKey`, `IfGenerationMatch`, `IfGenerationNotMatch`,
-   *   `IfMetagenerationMatch`, `IfMetagenerationNotMatch`, `KmsKeyName`,
-   *   `MD5HashValue`, `PredefinedAcl`, `Projection`,
-   *   `UseResumableUploadSession`, `UserProject`, and `WithObjectMetadata`.
+   *   `EncryptionKey`, `GzipCompression`, `IfGenerationMatch`,
+   *   `IfGenerationNotMatch`, `IfMetagenerationMatch`,
+   *   `IfMetagenerationNotMatch`, `KmsKeyName`, `MD5HashValue`,
+   *   `PredefinedAcl`, `Projection`, `UseResumableUploadSession`,
+   *   `UserProject`, and `WithObjectMetadata`.
    *
    * @par Idempotency
    * This operation is only idempotent if restricted by pre-conditions, in this
@@ -1015,10 +1117,11 @@ class Client {
    * @param options a list of optional query parameters and/or request headers.
    *   Valid types for this operation include `ContentEncoding`, `ContentType`,
    *   `Crc32cChecksumValue`, `DisableCrc32cChecksum`, `DisableMD5Hash`,
-   *   `EncryptionKey`, `IfGenerationMatch`, `IfGenerationNotMatch`,
-   *   `IfMetagenerationMatch`, `IfMetagenerationNotMatch`, `KmsKeyName`,
-   *   `MD5HashValue`, `PredefinedAcl`, `Projection`, `UserProject`, and
-   *   `WithObjectMetadata`.
+   *   `EncryptionKey`, `GzipCompression`, `IfGenerationMatch`,
+   *   `IfGenerationNotMatch`, `IfMetagenerationMatch`,
+   *   `IfMetagenerationNotMatch`, `KmsKeyName`, `MD5HashValue`,
+   *   `PredefinedAcl`, `Projection`, `UserProject`, and `WithObjectMetadata`.
+   *   Uploads with `GzipCompression` always use resumable uploads.
    *
    * @par Idempotency
    * This operation is only idempotent if restricted by pre-conditions, in this
@@ -1038,9 +1141,10 @@ class Client {
     // Determine, at compile time, which version of UploadFileImpl we should
     // call. This needs to be done at compile time because ObjectInsertMedia
     // does not support (nor should it support) the UseResumableUploadSession
-    // option.
+    // or GzipCompression options.
     using HasUseResumableUpload = google::cloud::internal::disjunction<
-        std::is_same<UseResumableUploadSession, Options>...>;
+        std::is_same<UseResumableUploadSession, Options>...,
+        std::is_same<GzipCompression, Options>...>;
     return UploadFileImpl(file_name, bucket_name, object_name,
                           HasUseResumableUpload{},
                           std::forward<Options>(options)...);
@@ -1056,8 +1160,8 @@ class Client {
    * @param options a list of optional query parameters and/or request headers.
    *   Valid types for this operation include `IfGenerationMatch`,
    *   `IfGenerationNotMatch`, `IfMetagenerationMatch`,
-   *   `IfMetagenerationNotMatch`, `Generation`, `ReadFromOffset`, `ReadRange`,
-   *   and `UserProject`.
+   *   `IfMetagenerationNotMatch`, `Generation`, `GzipDecompression`,
+   *   `ReadFromOffset`, `ReadRange`, and `UserProject`.
    *
    * @par Idempotency
    * This is a read-only operation and is always idempotent.
@@ -1399,6 +1503,106 @@ class Client {
                                std::string{}, std::forward<Options>(options)...)
         .Result();
   }
+
+  /**
+   * Creates a `BulkRewriter` to copy many objects between two buckets.
+   *
+   * Applications use this function to copy or migrate many objects, the
+   * `BulkRewriter` makes many concurrent rewrite calls, adapting the
+   * concurrency to the service load, and can save checkpoints to resume an
+   * interrupted copy.
+   *
+   * @param source_bucket_name the name of the bucket containing the source
+   *     objects.
+   * @param source_object_names the names of the objects to copy.
+   * @param destination_bucket_name where the destination objects will be
+   *     located.
+   * @param destination_prefix the name of each destination object is this
+   *     prefix followed by the name of the source object.
+   * @param options a list of optional query parameters and/or request headers,
+   *     applied to each rewrite request. Valid types for this operation are the
+   *     same as in `RewriteObject()`.
+   *
+   * @par Idempotency
+   * This operation is only idempotent if restricted by pre-conditions, in this
+   * case, `IfGenerationMatch`.
+   */
+  template <typename... Options>
+  BulkRewriter CreateBulkRewriter(
+      std::string source_bucket_name,
+      std::vector<std::string> const& source_object_names,
+      std::string destination_bucket_name,
+      std::string const& destination_prefix, Options&&... options) {
+    std::vector<BulkRewriteObject> objects;
+    for (auto const& name : source_object_names) {
+      BulkRewriteObject object;
+      object.source_object = name;
+      object.destination_object = destination_prefix + name;
+      objects.push_back(std::move(object));
+    }
+    return BulkRewriter(
+        raw_client_, std::move(source_bucket_name),
+        std::move(destination_bucket_name), std::move(objects),
+        internal::MakeBulkRewriteOptions(std::forward<Options>(options)...));
+  }
+
+  /**
+   * Creates a `BulkRewriter` to copy all the objects with a given prefix.
+   *
+   * The name of each destination object is @p destination_prefix followed by
+   * the name of the source object without @p source_prefix.
+   *
+   * @param source_bucket_name the name of the bucket containing the source
+   *     objects.
+   * @param source_prefix copy the objects whose name starts with this prefix.
+   * @param destination_bucket_name where the destination objects will be
+   *     located.
+   * @param destination_prefix replaces @p source_prefix in the name of the
+   *     destination objects.
+   * @param options a list of optional query parameters and/or request headers,
+   *     applied to each rewrite request. Valid types for this operation are the
+   *     same as in `RewriteObject()`.
+   *
+   * @return the rewriter, or the error listing the source objects.
+   */
+  template <typename... Options>
+  StatusOr<BulkRewriter> CreateBulkRewriterForPrefix(
+      std::string source_bucket_name, std::string const& source_prefix,
+      std::string destination_bucket_name,
+      std::string const& destination_prefix, Options&&... options) {
+    std::vector<BulkRewriteObject> objects;
+    for (auto& o : ListObjects(source_bucket_name, Prefix(source_prefix))) {
+      if (!o) {
+        return std::move(o).status();
+      }
+      BulkRewriteObject object;
+      object.source_object = o->name();
+      object.destination_object =
+          destination_prefix + o->name().substr(source_prefix.size());
+      objects.push_back(std::move(object));
+    }
+    return BulkRewriter(
+        raw_client_, std::move(source_bucket_name),
+        std::move(destination_bucket_name), std::move(objects),
+        internal::MakeBulkRewriteOptions(std::forward<Options>(options)...));
+  }
+
+  /**
+   * Creates a `BulkRewriter` to resume a copy from its checkpoint file.
+   *
+   * @param checkpoint_file the checkpoint saved by a previous `BulkRewriter`.
+   * @param options a list of optional query parameters and/or request headers,
+   *     applied to each rewrite request. The checkpoint does not include these
+   *     options, the application must provide the same options used to create
+   *     the original `BulkRewriter`.
+   */
+  template <typename... Options>
+  StatusOr<BulkRewriter> ResumeBulkRewriter(std::string const& checkpoint_file,
+                                            Options&&... options) {
+    return BulkRewriter::Restore(
+        raw_client_, checkpoint_file,
+        internal::MakeBulkRewriteOptions(std::forward<Options>(options)...));
+  }
   //@}
 
   //@{
@@ -2659,6 +2863,31 @@ class Client {
     return SignPolicyDocument(request);
   }
 
+  /**
+   * Creates a signer for many policy documents.
+   *
+   * Applications that create many policy documents, for example, one for each
+   * request to a web application, can use this function to create a signer
+   * once, and then sign each document with it. The signer caches the values
+   * that do not change between documents, and can sign batches of documents
+   * using multiple threads.
+   *
+   * @param options a list of optional parameters, this includes:
+   *      `SigningAccount`, and `SigningAccountDelegates`.
+   *
+   * @par Example
+   * @code
+   * auto signer = client.CreatePolicyDocumentSigner();
+   * auto results = signer.SignBatch(documents, 4);
+   * @endcode
+   */
+  template <typename... Options>
+  PolicyDocumentSigner CreatePolicyDocumentSigner(Options&&... options) {
+    internal::PolicyDocumentRequest request;
+    request.set_multiple_options(std::forward<Options>(options)...);
+    return PolicyDocumentSigner(raw_client_, request.signing_account());
+  }
+
   //@{
   /**
    * @name Pub/Sub operations.
@@ -2814,19 +3043,34 @@ class Client {
   //@}
 
  private:
+  friend class PolicyDocumentSigner;
+  friend struct internal::ClientImplDetails;
+
   Client() = default;
   static std::shared_ptr<internal::RawClient> CreateDefaultInternalClient(
       ClientOptions options);
 
   template <typename... Policies>
   std::shared_ptr<internal::RawClient> Decorate(
-      std::shared_ptr<internal::RawClient> client, Policies&&... policies) {
-    auto logging = std::make_shared<internal::LoggingClient>(std::move(client));
+      std::shared_ptr<internal::RawClient> client, TracingSampling sampling,
+      Policies&&... policies) {
+    auto logging = std::make_shared<internal::LoggingClient>(std::move(client),
+                                                             sampling);
     auto retry = std::make_shared<internal::RetryClient>(
         std::move(logging), std::forward<Policies>(policies)...);
     return retry;
   }
 
+  /// Add the disk cache decorator to @p client if @p options enable it.
+  static std::shared_ptr<internal::RawClient> AddDiskCache(
+      std::shared_ptr<internal::RawClient> client,
+      ClientOptions const& options);
+
+  /// Add the read coalescing decorator to @p client if @p options enable it.
+  static std::shared_ptr<internal::RawClient> AddReadCoalescing(
+      std::shared_ptr<internal::RawClient> client,
+      ClientOptions const& options);
+
   ObjectReadStream ReadObjectImpl(
       internal::ReadObjectRangeRequest const& request);
 
@@ -2878,6 +3122,9 @@ class Client {
   StatusOr<ObjectMetadata> UploadStreamResumable(
       std::istream& source, internal::ResumableUploadRequest const& request);
 
+  StatusOr<ObjectMetadata> UploadStreamCompressed(
+      std::istream& source, internal::ResumableUploadRequest const& request);
+
   Status DownloadFileImpl(internal::ReadObjectRangeRequest const& request,
                           std::string const& file_name);
 
@@ -2904,6 +3151,17 @@ class Client {
   std::shared_ptr<internal::RawClient> raw_client_;
 };
 
+namespace internal {
+/// Exposes some private members of `Client` to the unit tests.
+struct ClientImplDetails {
+  static StatusOr<ObjectMetadata> UploadStreamCompressed(
+      Client& client, std::istream& source,
+      ResumableUploadRequest const& request) {
+    return client.UploadStreamCompressed(source, request);
+  }
+};
+}  // namespace internal
+
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
 }  // namespace cloud
@@ -17,7 +17,10 @@
 #include "google/cloud/log.h"
 #include "google/cloud/storage/oauth2/credentials.h"
 #include "google/cloud/storage/oauth2/google_credentials.h"
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <thread>
@@ -44,6 +47,27 @@ std::size_t DefaultConnectionPoolSize() {
   return 4 * nthreads;
 }
 
+/**
+ * Parses the value of a `name=value` token in CLOUD_STORAGE_ENABLE_TRACING.
+ *
+ * Returns false, and logs a warning, if @p value is not a decimal number
+ * between 0 and @p max.
+ */
+bool ParseTracingParameter(std::string const& token, char const* value,
+                           std::uint64_t max, std::uint64_t& result) {
+  char* end = nullptr;
+  errno = 0;
+  auto const v = std::strtoull(value, &end, 10);
+  if (*value < '0' || *value > '9' || *end != '\0' || errno == ERANGE ||
+      v > max) {
+    GCP_LOG(WARNING) << "Invalid CLOUD_STORAGE_ENABLE_TRACING setting <"
+                     << token << ">, using the default value";
+    return false;
+  }
+  result = v;
+  return true;
+}
+
 // There is nothing special about the buffer sizes here. They are relatively
 // small, because we do not want to consume too much memory from the
 // application. They are larger than the typical socket buffer size (64KiB), to
@@ -59,6 +83,13 @@ std::size_t DefaultConnectionPoolSize() {
   (5 * 1024 * 1024L)
 #endif  // GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_MAXIMUM_SIMPLE_UPLOAD_SIZE
 
+// The on-disk cache is disabled by default, this is just its default size once
+// the application enables it.
+#ifndef GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_DISK_CACHE_SIZE
+#define GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_DISK_CACHE_SIZE \
+  (1024 * 1024 * 1024LL)
+#endif  // GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_DISK_CACHE_SIZE
+
 }  // namespace
 
 StatusOr<ClientOptions> ClientOptions::CreateDefaultClientOptions() {
@@ -80,7 +111,8 @@ ClientOptions::ClientOptions(std::shared_ptr<oauth2::Credentials> credentials)
       download_buffer_size_(GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_BUFFER_SIZE),
       upload_buffer_size_(GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_BUFFER_SIZE),
       maximum_simple_upload_size_(
-          GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_MAXIMUM_SIMPLE_UPLOAD_SIZE) {
+          GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_MAXIMUM_SIMPLE_UPLOAD_SIZE),
+      disk_cache_max_size_(GOOGLE_CLOUD_CPP_STORAGE_DEFAULT_DISK_CACHE_SIZE) {
   auto emulator =
       google::cloud::internal::GetEnv("CLOUD_STORAGE_TESTBENCH_ENDPOINT");
   if (emulator.has_value()) {
@@ -105,9 +137,33 @@ void ClientOptions::SetupFromEnvironment() {
     std::set<std::string> enabled;
     std::istringstream is{*tracing};
     std::string token;
+    auto sampling = tracing_sampling();
+    // Return the value of a `name=value` token, or nullptr if the token does
+    // not have this name.
+    auto parameter = [&token](std::string const& name) -> char const* {
+      if (token.compare(0, name.size(), name) != 0) {
+        return nullptr;
+      }
+      return token.c_str() + name.size();
+    };
+    auto const max = (std::numeric_limits<std::uint32_t>::max)();
+    std::uint64_t value;
     while (std::getline(is, token, ',')) {
+      if (auto const* v = parameter("sample-period=")) {
+        if (ParseTracingParameter(token, v, max, value)) {
+          sampling.sample_period = static_cast<std::uint32_t>(value);
+        }
+        continue;
+      }
+      if (auto const* v = parameter("latency-threshold-ms=")) {
+        if (ParseTracingParameter(token, v, max, value)) {
+          sampling.latency_threshold = std::chrono::milliseconds(value);
+        }
+        continue;
+      }
       enabled.emplace(token);
     }
+    set_tracing_sampling(sampling);
     if (enabled.end() != enabled.find("http")) {
       GCP_LOG(INFO) << "Enabling logging for http";
       set_enable_http_tracing(true);
@@ -122,6 +178,12 @@ void ClientOptions::SetupFromEnvironment() {
   if (project_id.has_value()) {
     project_id_ = std::move(*project_id);
   }
+
+  auto disk_cache =
+      google::cloud::internal::GetEnv("CLOUD_STORAGE_DISK_CACHE_DIRECTORY");
+  if (disk_cache.has_value()) {
+    disk_cache_directory_ = std::move(*disk_cache);
+  }
 }
 
 ClientOptions& ClientOptions::SetDownloadBufferSize(std::size_t size) {
@@ -15,14 +15,24 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CLIENT_OPTIONS_H_
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_CLIENT_OPTIONS_H_
 
+#include "google/cloud/storage/buffer_pool.h"
 #include "google/cloud/storage/oauth2/credentials.h"
+#include "google/cloud/storage/tracing_sampling.h"
+#include "google/cloud/storage/transfer_metrics.h"
+#include "google/cloud/storage/transport_tuning.h"
 #include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstdint>
 #include <memory>
 
 namespace google {
 namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+class MetricsRecorder;
+}  // namespace internal
+
 /**
  * Describes the configuration for a `storage::Client` object.
  *
@@ -38,6 +48,13 @@ inline namespace STORAGE_CLIENT_NS {
  * - `CLOUD_STORAGE_ENABLE_TRACING`: if set, this is the list of components that
  *   will have logging enabled, the component this is:
  *   - `http`: trace all http request / responses.
+ *   - `raw-client`: trace all the `RawClient` operations.
+ *   - `sample-period=N`: only trace one in every N operations, see
+ *     `TracingSampling`.
+ *   - `latency-threshold-ms=N`: also trace operations slower than N
+ *     milliseconds.
+ *   Malformed `N` values are ignored with a warning, and the default value is
+ *   used instead.
  */
 class ClientOptions {
  public:
@@ -92,6 +109,17 @@ class ClientOptions {
     return *this;
   }
 
+  /**
+   * Select which operations are traced, when tracing is enabled.
+   *
+   * The default traces all the operations.
+   */
+  TracingSampling const& tracing_sampling() const { return tracing_sampling_; }
+  ClientOptions& set_tracing_sampling(TracingSampling v) {
+    tracing_sampling_ = v;
+    return *this;
+  }
+
   std::string const& project_id() const { return project_id_; }
   ClientOptions& set_project_id(std::string v) {
     project_id_ = std::move(v);
@@ -104,6 +132,186 @@ class ClientOptions {
     return *this;
   }
 
+  /**
+   * The number of connections opened when the client is created.
+   *
+   * The client opens (including the TLS handshake) this many connections to
+   * the service, so the first requests issued by the application do not pay
+   * for this setup. The value is capped by `connection_pool_size()`.
+   */
+  std::size_t connection_pool_prewarm_size() const {
+    return connection_pool_prewarm_size_;
+  }
+  ClientOptions& set_connection_pool_prewarm_size(std::size_t size) {
+    connection_pool_prewarm_size_ = size;
+    return *this;
+  }
+
+  /// Handles idle for longer than this time are released from the pool.
+  std::chrono::seconds connection_pool_max_idle_time() const {
+    return connection_pool_max_idle_time_;
+  }
+  ClientOptions& set_connection_pool_max_idle_time(std::chrono::seconds v) {
+    connection_pool_max_idle_time_ = v;
+    return *this;
+  }
+
+  /**
+   * Send TCP keepalive probes after the connection is idle for this time.
+   *
+   * Without keepalive probes idle connections may be silently dropped by
+   * the network, and the next request using them pays for a new connection.
+   * Set to zero to disable TCP keepalive.
+   */
+  std::chrono::seconds tcp_keepalive_idle_time() const {
+    return tcp_keepalive_idle_time_;
+  }
+  ClientOptions& set_tcp_keepalive_idle_time(std::chrono::seconds v) {
+    tcp_keepalive_idle_time_ = v;
+    return *this;
+  }
+
+  /**
+   * Socket and buffer settings for downloads.
+   *
+   * These settings apply to the requests that download object data, and to
+   * the other requests sharing their connections, such as metadata requests.
+   * Uploads use a separate set of connections, configured with
+   * `upload_tuning()`.
+   *
+   * @note With HTTP/2 enabled all the requests share the multiplexed
+   *     connections, and the socket options are those of the request that
+   *     created each connection.
+   */
+  TransportTuning const& download_tuning() const { return download_tuning_; }
+  ClientOptions& set_download_tuning(TransportTuning v) {
+    download_tuning_ = v;
+    return *this;
+  }
+
+  /**
+   * Socket and buffer settings for uploads.
+   *
+   * Uploads do not reuse the connections created for other requests, so these
+   * socket options apply to every upload connection.
+   */
+  TransportTuning const& upload_tuning() const { return upload_tuning_; }
+  ClientOptions& set_upload_tuning(TransportTuning v) {
+    upload_tuning_ = v;
+    return *this;
+  }
+
+  /**
+   * Use HTTP/2, and multiplex concurrent requests over a few connections.
+   *
+   * When enabled, the requests from all threads, except downloads, are
+   * performed using a single curl multi handle, where each HTTP/2 connection
+   * carries many concurrent requests. Requests to `https://` endpoints
+   * negotiate the protocol, and use HTTP/1.1 if the service does not support
+   * HTTP/2. Requests to `http://` endpoints, such as a local emulator, assume
+   * the endpoint supports HTTP/2. This option is ignored if libcurl was
+   * compiled without HTTP/2 support.
+   */
+  bool enable_http2() const { return enable_http2_; }
+  ClientOptions& set_enable_http2(bool v) {
+    enable_http2_ = v;
+    return *this;
+  }
+
+  /// The maximum number of connections to each host when using HTTP/2.
+  std::size_t maximum_http2_connections() const {
+    return maximum_http2_connections_;
+  }
+  ClientOptions& set_maximum_http2_connections(std::size_t v) {
+    maximum_http2_connections_ = v;
+    return *this;
+  }
+
+  /**
+   * Limits the bytes per second uploaded by all the requests from a client.
+   *
+   * Zero, the default, disables the limit. The limit is shared by every
+   * stream and request created by the client. Transfers that exceed the limit
+   * are paused in the libcurl callbacks, and resumed as soon as the limit
+   * allows, so a throttled transfer does not block the transfers in other
+   * threads.
+   *
+   * @note With a bandwidth limit, and without HTTP/2, all the requests other
+   *     than downloads run in a single libcurl multi handle, driven in turns
+   *     by the calling threads. This is needed to resume paused transfers,
+   *     but the requests no longer run fully in parallel, and the client
+   *     may be slower with many threads. Downloads use their own multi
+   *     handle and are not affected.
+   */
+  std::uint64_t maximum_upload_bandwidth() const {
+    return maximum_upload_bandwidth_;
+  }
+  ClientOptions& set_maximum_upload_bandwidth(std::uint64_t v) {
+    maximum_upload_bandwidth_ = v;
+    return *this;
+  }
+
+  /**
+   * Limits the bytes per second downloaded, zero disables the limit.
+   *
+   * @note Like `maximum_upload_bandwidth()`, without HTTP/2 this runs the
+   *     requests other than downloads in a single libcurl multi handle.
+   */
+  std::uint64_t maximum_download_bandwidth() const {
+    return maximum_download_bandwidth_;
+  }
+  ClientOptions& set_maximum_download_bandwidth(std::uint64_t v) {
+    maximum_download_bandwidth_ = v;
+    return *this;
+  }
+
+  /**
+   * Limits the HTTP requests per second, zero disables the limit.
+   *
+   * Each attempt, including retries, counts as a separate request. Requests
+   * over the limit start as soon as the limit allows, the calling thread
+   * blocks until the request completes, as usual. This limit alone does not
+   * change how the requests run, each one waits for its turn in the calling
+   * thread and then runs as without the limit.
+   */
+  double maximum_request_rate() const { return maximum_request_rate_; }
+  ClientOptions& set_maximum_request_rate(double v) {
+    maximum_request_rate_ = v;
+    return *this;
+  }
+
+  /**
+   * Adapts the number of concurrent requests for each bucket to the load.
+   *
+   * When enabled, the client starts with this limit on the concurrent
+   * requests for each bucket, increases it while requests succeed, and halves
+   * it when the service reports it is overloaded (HTTP 429 or 503). Requests
+   * over the limit wait in the calling thread. Zero, the default, disables the
+   * limit.
+   *
+   * For downloads only the request is limited: an `ObjectReadStream` takes a
+   * slot for its first read, until the response headers arrive, and then
+   * releases it. Open streams never hold a slot, so a thread can keep several
+   * streams open, or make other requests to the same bucket, without waiting
+   * for them.
+   */
+  std::size_t adaptive_concurrency_initial_limit() const {
+    return adaptive_concurrency_initial_limit_;
+  }
+  ClientOptions& set_adaptive_concurrency_initial_limit(std::size_t v) {
+    adaptive_concurrency_initial_limit_ = v;
+    return *this;
+  }
+
+  /// The adaptive concurrency limit for each bucket never exceeds this value.
+  std::size_t adaptive_concurrency_maximum_limit() const {
+    return adaptive_concurrency_maximum_limit_;
+  }
+  ClientOptions& set_adaptive_concurrency_maximum_limit(std::size_t v) {
+    adaptive_concurrency_maximum_limit_ = v;
+    return *this;
+  }
+
   std::size_t download_buffer_size() const { return download_buffer_size_; }
   ClientOptions& SetDownloadBufferSize(std::size_t size);
 
@@ -147,6 +355,102 @@ class ClientOptions {
     return *this;
   }
 
+  /**
+   * If not empty, cache downloaded objects in this directory.
+   *
+   * Objects are immutable once a generation is created, the cache stores
+   * complete objects keyed by bucket, object, and generation. Multiple
+   * processes on the same host can share the directory. The
+   * `CLOUD_STORAGE_DISK_CACHE_DIRECTORY` environment variable sets the
+   * default value.
+   *
+   * @note The cache is only supported on POSIX platforms. On other platforms
+   *   (e.g. Windows) this option is ignored, and the client logs a warning.
+   */
+  std::string const& disk_cache_directory() const {
+    return disk_cache_directory_;
+  }
+  ClientOptions& set_disk_cache_directory(std::string v) {
+    disk_cache_directory_ = std::move(v);
+    return *this;
+  }
+
+  /// The maximum size of the objects cached in `disk_cache_directory()`.
+  std::uint64_t disk_cache_max_size() const { return disk_cache_max_size_; }
+  ClientOptions& set_disk_cache_max_size(std::uint64_t v) {
+    disk_cache_max_size_ = v;
+    return *this;
+  }
+
+  /**
+   * Share identical concurrent downloads.
+   *
+   * When enabled, a `ReadObject()` call identical to a download already in
+   * progress (same bucket, object, generation, range and other options) does
+   * not start a new download. It receives the same data as the existing
+   * download, from the beginning of the object.
+   */
+  bool enable_read_coalescing() const { return enable_read_coalescing_; }
+  ClientOptions& set_enable_read_coalescing(bool v) {
+    enable_read_coalescing_ = v;
+    return *this;
+  }
+
+  /**
+   * If not null, receives the metrics for each HTTP request attempt.
+   *
+   * The metrics include the time spent in each phase of the request (name
+   * lookup, connect, TLS handshake, time to first byte), the number of bytes
+   * transferred, the retry attempt, and whether the request reused a handle
+   * and a connection. Use `TransferMetricsHistogram` to aggregate the
+   * metrics and report percentiles.
+   */
+  std::shared_ptr<TransferMetricsHook> const& transfer_metrics_hook() const {
+    return transfer_metrics_hook_;
+  }
+  ClientOptions& set_transfer_metrics_hook(
+      std::shared_ptr<TransferMetricsHook> v) {
+    transfer_metrics_hook_ = std::move(v);
+    return *this;
+  }
+
+  /**
+   * If not null, records the metrics for each `RawClient` operation.
+   *
+   * The client installs a `internal::MetricsClient` decorator below the retry
+   * loop, so each attempt is counted, and records the calls, errors, payload
+   * bytes, and latency of each operation in this object. Unlike the tracing
+   * options this is cheap enough to leave enabled in production.
+   */
+  std::shared_ptr<internal::MetricsRecorder> const& metrics_recorder() const {
+    return metrics_recorder_;
+  }
+  ClientOptions& set_metrics_recorder(
+      std::shared_ptr<internal::MetricsRecorder> v) {
+    metrics_recorder_ = std::move(v);
+    return *this;
+  }
+
+  /**
+   * The pool for the buffers used by streams and downloads.
+   *
+   * By default there is no pool, each stream allocates its own buffers and
+   * releases them when it is destroyed. Applications that open many
+   * short-lived streams can set a pool to reuse the buffers, at the cost of
+   * the memory retained by the pool, see `BufferPool` for details.
+   *
+   * Copies of a `ClientOptions` object share the same pool, and so do all the
+   * streams created by a client. Applications can use the pool statistics to
+   * verify the buffers are reused.
+   */
+  std::shared_ptr<BufferPool> const& buffer_pool() const {
+    return buffer_pool_;
+  }
+  ClientOptions& set_buffer_pool(std::shared_ptr<BufferPool> v) {
+    buffer_pool_ = std::move(v);
+    return *this;
+  }
+
  private:
   void SetupFromEnvironment();
 
@@ -157,14 +461,34 @@ class ClientOptions {
   std::string version_;
   bool enable_http_tracing_;
   bool enable_raw_client_tracing_;
+  TracingSampling tracing_sampling_;
   std::string project_id_;
   std::size_t connection_pool_size_;
+  std::size_t connection_pool_prewarm_size_ = 0;
+  std::chrono::seconds connection_pool_max_idle_time_ =
+      std::chrono::seconds(60);
+  std::chrono::seconds tcp_keepalive_idle_time_ = std::chrono::seconds(60);
+  TransportTuning download_tuning_;
+  TransportTuning upload_tuning_;
+  bool enable_http2_ = false;
+  std::size_t maximum_http2_connections_ = 4;
+  std::uint64_t maximum_upload_bandwidth_ = 0;
+  std::uint64_t maximum_download_bandwidth_ = 0;
+  double maximum_request_rate_ = 0;
+  std::size_t adaptive_concurrency_initial_limit_ = 0;
+  std::size_t adaptive_concurrency_maximum_limit_ = 256;
   std::size_t download_buffer_size_;
   std::size_t upload_buffer_size_;
   std::string user_agent_prefix_;
   std::size_t maximum_simple_upload_size_;
   bool enable_ssl_locking_callbacks_ = true;
   bool enable_sigpipe_handler_ = true;
+  std::string disk_cache_directory_;
+  std::uint64_t disk_cache_max_size_;
+  bool enable_read_coalescing_ = false;
+  std::shared_ptr<TransferMetricsHook> transfer_metrics_hook_;
+  std::shared_ptr<internal::MetricsRecorder> metrics_recorder_;
+  std::shared_ptr<BufferPool> buffer_pool_;
 };
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
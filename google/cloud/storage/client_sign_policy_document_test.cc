@@ -23,6 +23,7 @@
 #include "google/cloud/testing_util/environment_variable_restore.h"
 #include "google/cloud/testing_util/init_google_mock.h"
 #include <gmock/gmock.h>
+#include <atomic>
 
 namespace google {
 namespace cloud {
@@ -169,6 +170,106 @@ TEST_F(CreateSignedPolicyDocTest, SignPolicyPermanentFailure) {
       "SignBlob");
 }
 
+/// @test Verify that PolicyDocumentSigner produces the same results as
+/// CreateSignedPolicyDocument().
+TEST_F(CreateSignedPolicyDocTest, SignerMatchesCreateSignedPolicyDocument) {
+  auto creds = oauth2::CreateServiceAccountCredentialsFromJsonContents(
+      kJsonKeyfileContents);
+  ASSERT_STATUS_OK(creds);
+  Client client(*creds);
+
+  auto expected =
+      client.CreateSignedPolicyDocument(CreatePolicyDocumentForTest());
+  ASSERT_STATUS_OK(expected);
+
+  auto signer = client.CreatePolicyDocumentSigner();
+  EXPECT_EQ("foo-email@foo-project.iam.gserviceaccount.com",
+            signer.signing_email());
+  auto actual = signer.Sign(CreatePolicyDocumentForTest());
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(expected->access_id, actual->access_id);
+  EXPECT_EQ(expected->expiration, actual->expiration);
+  EXPECT_EQ(expected->policy, actual->policy);
+  EXPECT_EQ(expected->signature, actual->signature);
+}
+
+/// @test Verify that PolicyDocumentSigner::SignBatch() returns the results in
+/// order.
+TEST_F(CreateSignedPolicyDocTest, SignBatch) {
+  auto creds = oauth2::CreateServiceAccountCredentialsFromJsonContents(
+      kJsonKeyfileContents);
+  ASSERT_STATUS_OK(creds);
+  Client client(*creds);
+  auto signer = client.CreatePolicyDocumentSigner();
+
+  std::vector<PolicyDocument> documents;
+  for (int i = 0; i != 10; ++i) {
+    auto document = CreatePolicyDocumentForTest();
+    document.conditions.emplace_back(PolicyDocumentCondition::ExactMatchObject(
+        "key", "object-" + std::to_string(i)));
+    documents.push_back(std::move(document));
+  }
+
+  auto actual = signer.SignBatch(documents, 4);
+  ASSERT_EQ(documents.size(), actual.size());
+  for (std::size_t i = 0; i != documents.size(); ++i) {
+    SCOPED_TRACE("Testing document " + std::to_string(i));
+    ASSERT_STATUS_OK(actual[i]);
+    auto expected = signer.Sign(documents[i]);
+    ASSERT_STATUS_OK(expected);
+    EXPECT_EQ(expected->policy, actual[i]->policy);
+    EXPECT_EQ(expected->signature, actual[i]->signature);
+  }
+
+  EXPECT_TRUE(signer.SignBatch({}, 4).empty());
+}
+
+/// @test Verify that PolicyDocumentSigner::SignBatch() reports errors for each
+/// document.
+TEST_F(CreateSignedPolicyDocTest, SignBatchRemoteFailure) {
+  EXPECT_CALL(*mock, SignBlob(_))
+      .WillRepeatedly(
+          Return(StatusOr<internal::SignBlobResponse>(PermanentError())));
+  Client client{std::static_pointer_cast<internal::RawClient>(mock)};
+  auto signer = client.CreatePolicyDocumentSigner();
+
+  std::vector<PolicyDocument> documents(3, CreatePolicyDocumentForTest());
+  auto actual = signer.SignBatch(documents, 2);
+  ASSERT_EQ(documents.size(), actual.size());
+  for (auto const& r : actual) {
+    EXPECT_FALSE(r.ok());
+    EXPECT_EQ(PermanentError().code(), r.status().code());
+  }
+}
+
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+/// @test Verify that PolicyDocumentSigner::SignBatch() reports exceptions for
+/// each document.
+TEST_F(CreateSignedPolicyDocTest, SignBatchException) {
+  std::atomic<int> calls(0);
+  EXPECT_CALL(*mock, SignBlob(_))
+      .WillRepeatedly(Invoke([&calls](internal::SignBlobRequest const&) {
+        if (calls++ < 2) throw std::runtime_error("test-exception");
+        return make_status_or(
+            internal::SignBlobResponse{"test-key-id", "dGVzdA=="});
+      }));
+  Client client{std::static_pointer_cast<internal::RawClient>(mock)};
+  auto signer = client.CreatePolicyDocumentSigner();
+
+  std::vector<PolicyDocument> documents(5, CreatePolicyDocumentForTest());
+  auto actual = signer.SignBatch(documents, 3);
+  ASSERT_EQ(documents.size(), actual.size());
+  int failures = 0;
+  for (auto const& r : actual) {
+    if (r.ok()) continue;
+    ++failures;
+    EXPECT_EQ(StatusCode::kUnknown, r.status().code());
+    EXPECT_THAT(r.status().message(), HasSubstr("test-exception"));
+  }
+  EXPECT_EQ(2, failures);
+}
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+
 }  // namespace
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
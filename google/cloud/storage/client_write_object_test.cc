@@ -19,6 +19,7 @@
 #include "google/cloud/storage/testing/canonical_errors.h"
 #include "google/cloud/storage/testing/mock_client.h"
 #include <gmock/gmock.h>
+#include <stdexcept>
 
 namespace google {
 namespace cloud {
@@ -132,6 +133,101 @@ TEST_F(WriteObjectTest, WriteObjectPermanentFailure) {
       << ", status=" << stream.metadata().status();
 }
 
+TEST_F(WriteObjectTest, WriteObjectGzipCompression) {
+  std::string text = R"""({
+      "name": "test-bucket-name/test-object-name/1",
+      "contentEncoding": "gzip"
+})""";
+  auto expected = internal::ObjectMetadataParser::FromString(text).value();
+
+  EXPECT_CALL(*mock, CreateResumableSession(_))
+      .WillOnce(
+          Invoke([&text](internal::ResumableUploadRequest const& request) {
+            EXPECT_EQ("gzip", request.GetOption<ContentEncoding>().value());
+
+            auto mock = make_unique<testing::MockResumableUploadSession>();
+            using internal::ResumableUploadResponse;
+            EXPECT_CALL(*mock, done()).WillRepeatedly(Return(false));
+            EXPECT_CALL(*mock, next_expected_byte()).WillRepeatedly(Return(0));
+            EXPECT_CALL(*mock, UploadFinalChunk(_, _))
+                .WillOnce(Invoke([&text](std::string const& p, std::uint64_t) {
+                  // The payload starts with the gzip magic number.
+                  EXPECT_LE(2U, p.size());
+                  EXPECT_EQ('\x1f', p[0]);
+                  EXPECT_EQ('\x8b', p[1]);
+                  return make_status_or(ResumableUploadResponse{
+                      "fake-url", 0, text, ResumableUploadResponse::kDone});
+                }));
+
+            return make_status_or(
+                std::unique_ptr<internal ::ResumableUploadSession>(
+                    std::move(mock)));
+          }));
+
+  auto stream = client->WriteObject("test-bucket-name", "test-object-name",
+                                    GzipCompression(true));
+  stream << "Hello World!";
+  stream.Close();
+  ObjectMetadata actual = stream.metadata().value();
+  EXPECT_EQ(expected, actual);
+}
+
+TEST_F(WriteObjectTest, WriteObjectGzipCompressionRestoreSession) {
+  EXPECT_CALL(*mock, CreateResumableSession(_)).Times(0);
+  auto stream = client->WriteObject(
+      "test-bucket-name", "test-object-name", GzipCompression(true),
+      RestoreResumableUploadSession("test-session-id"));
+  EXPECT_TRUE(stream.bad());
+  EXPECT_EQ(StatusCode::kInvalidArgument, stream.metadata().status().code())
+      << ", status=" << stream.metadata().status();
+}
+
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+/// A streambuf that returns some data and then fails, as a bad disk would.
+class FailingStreambuf : public std::streambuf {
+ public:
+  FailingStreambuf() : data_("some data") {
+    setg(&data_[0], &data_[0], &data_[0] + data_.size());
+  }
+
+ protected:
+  int_type underflow() override {
+    throw std::runtime_error("simulated read error");
+  }
+
+ private:
+  std::string data_;
+};
+
+TEST_F(WriteObjectTest, UploadStreamCompressedSourceError) {
+  EXPECT_CALL(*mock, CreateResumableSession(_))
+      .WillOnce(Invoke([](internal::ResumableUploadRequest const&) {
+        auto mock = make_unique<testing::MockResumableUploadSession>();
+        EXPECT_CALL(*mock, done()).WillRepeatedly(Return(false));
+        EXPECT_CALL(*mock, next_expected_byte()).WillRepeatedly(Return(0));
+        // A read error must not finalize the upload, that would create a
+        // truncated object.
+        EXPECT_CALL(*mock, UploadChunk(_)).Times(0);
+        EXPECT_CALL(*mock, UploadFinalChunk(_, _)).Times(0);
+        return make_status_or(
+            std::unique_ptr<internal::ResumableUploadSession>(
+                std::move(mock)));
+      }));
+
+  FailingStreambuf buf;
+  std::istream source(&buf);
+  internal::ResumableUploadRequest request("test-bucket-name",
+                                           "test-object-name");
+  request.set_multiple_options(GzipCompression(true));
+  auto actual = internal::ClientImplDetails::UploadStreamCompressed(
+      *client, source, request);
+  EXPECT_TRUE(source.bad());
+  ASSERT_FALSE(actual.ok());
+  EXPECT_THAT(actual.status().message(),
+              HasSubstr("error reading upload source"));
+}
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+
 }  // namespace
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
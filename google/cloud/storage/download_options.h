@@ -57,6 +57,29 @@ struct ReadFromOffset
   static char const* name() { return "read-offset"; }
 };
 
+/**
+ * Download gzip-encoded objects in compressed form and decompress them locally.
+ *
+ * By default the service decompresses objects stored with
+ * `Content-Encoding: gzip` before sending them. When this option is set to
+ * `true` the client library asks for the compressed data instead, which
+ * reduces the number of bytes transferred, and decompresses it incrementally
+ * as the application reads the stream. Objects that are not gzip-encoded are
+ * returned unchanged.
+ *
+ * The CRC32C checksum and MD5 hash are validated using the compressed data, as
+ * those are the values stored by the service.
+ *
+ * @note Offsets in `ReadRange` and `ReadFromOffset` would refer to the
+ *   compressed data, which cannot be decompressed starting at an arbitrary
+ *   offset, so these options cannot be combined with `GzipDecompression`.
+ */
+struct GzipDecompression
+    : public internal::ComplexOption<GzipDecompression, bool> {
+  using ComplexOption<GzipDecompression, bool>::ComplexOption;
+  static char const* name() { return "gzip-decompression"; }
+};
+
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
 }  // namespace cloud
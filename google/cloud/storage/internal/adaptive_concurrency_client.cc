@@ -0,0 +1,528 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/adaptive_concurrency_client.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/storage/internal/raw_client_wrapper_utils.h"
+#include "google/cloud/storage/transfer_metrics.h"
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+namespace {
+
+using ::google::cloud::storage::internal::raw_client_wrapper_utils::Signature;
+
+// Limiters for buckets without any activity in this period are discarded.
+auto constexpr kIdleTimeout = std::chrono::minutes(5);
+
+/**
+ * Makes a call while holding a slot in @p limiter.
+ *
+ * @param limiter the limiter for the bucket used in the call.
+ * @param call the functor to make the call.
+ * @return the result of calling @p call.
+ */
+template <typename Functor>
+auto Limit(AdaptiveConcurrencyLimiter& limiter, Functor&& call)
+    -> decltype(call()) {
+  auto permit = limiter.Acquire();
+  SetLastHttpStatusCode(0);
+  auto result = call();
+  limiter.Release(permit, result.status(), LastHttpStatusCode());
+  return result;
+}
+
+/**
+ * Makes a `RawClient` call while holding a slot for @p bucket_name.
+ *
+ * @tparam MemberFunction the signature of the member function.
+ * @param decorator the client holding the limiters for each bucket.
+ * @param bucket_name the bucket used in the call.
+ * @param client the storage::RawClient object to make the call through.
+ * @param function the pointer to the member function to call.
+ * @param request an initialized request parameter for the call.
+ * @return the result from making the call;
+ */
+template <typename MemberFunction>
+typename Signature<MemberFunction>::ReturnType MakeCall(
+    AdaptiveConcurrencyClient& decorator, std::string const& bucket_name,
+    RawClient& client, MemberFunction function,
+    typename Signature<MemberFunction>::RequestType const& request) {
+  return Limit(*decorator.Limiter(bucket_name), [&client, function, &request] {
+    return (client.*function)(request);
+  });
+}
+
+/**
+ * Limits the first `Read()` of a download.
+ *
+ * The first `Read()` sends the request and waits for the response, this is
+ * the part of a download that loads the service. The slot is released as soon
+ * as that call returns, so a thread keeping downloads open (or idle) never
+ * holds a slot, and cannot block other requests, even its own.
+ */
+class AdaptiveConcurrencyReadSource : public ObjectReadSource {
+ public:
+  AdaptiveConcurrencyReadSource(
+      std::shared_ptr<AdaptiveConcurrencyLimiter> limiter,
+      std::unique_ptr<ObjectReadSource> source)
+      : limiter_(std::move(limiter)), source_(std::move(source)) {}
+
+  bool IsOpen() const override { return source_->IsOpen(); }
+  StatusOr<HttpResponse> Close() override { return source_->Close(); }
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override {
+    if (!limiter_) {
+      return source_->Read(buf, n);
+    }
+    auto limiter = std::move(limiter_);
+    auto const permit = limiter->Acquire();
+    auto result = source_->Read(buf, n);
+    if (!result) {
+      limiter->Release(permit, result.status());
+    } else if (result->response.status_code == 100) {
+      // The response headers arrived and the data is flowing.
+      limiter->Release(permit, Status());
+    } else {
+      limiter->Release(permit, AsStatus(result->response),
+                       result->response.status_code);
+    }
+    return result;
+  }
+
+ private:
+  std::shared_ptr<AdaptiveConcurrencyLimiter> limiter_;
+  std::unique_ptr<ObjectReadSource> source_;
+};
+
+/// Limits each chunk sent by a resumable upload.
+class AdaptiveConcurrencyResumableUploadSession
+    : public ResumableUploadSession {
+ public:
+  AdaptiveConcurrencyResumableUploadSession(
+      std::shared_ptr<AdaptiveConcurrencyLimiter> limiter,
+      std::unique_ptr<ResumableUploadSession> session)
+      : limiter_(std::move(limiter)), session_(std::move(session)) {}
+
+  StatusOr<ResumableUploadResponse> UploadChunk(
+      std::string const& buffer) override {
+    return Limit(*limiter_,
+                 [this, &buffer] { return session_->UploadChunk(buffer); });
+  }
+  StatusOr<ResumableUploadResponse> UploadFinalChunk(
+      std::string const& buffer, std::uint64_t upload_size) override {
+    return Limit(*limiter_, [this, &buffer, upload_size] {
+      return session_->UploadFinalChunk(buffer, upload_size);
+    });
+  }
+  StatusOr<ResumableUploadResponse> ResetSession() override {
+    return Limit(*limiter_, [this] { return session_->ResetSession(); });
+  }
+  std::uint64_t next_expected_byte() const override {
+    return session_->next_expected_byte();
+  }
+  std::string const& session_id() const override {
+    return session_->session_id();
+  }
+  StatusOr<ResumableUploadResponse> const& last_response() const override {
+    return session_->last_response();
+  }
+  bool done() const override { return session_->done(); }
+
+ private:
+  std::shared_ptr<AdaptiveConcurrencyLimiter> limiter_;
+  std::unique_ptr<ResumableUploadSession> session_;
+};
+}  // namespace
+
+AdaptiveConcurrencyClient::AdaptiveConcurrencyClient(
+    std::shared_ptr<RawClient> client, std::size_t initial_limit,
+    std::size_t maximum_limit, std::function<Clock::time_point()> clock)
+    : client_(std::move(client)),
+      initial_limit_(initial_limit),
+      maximum_limit_(maximum_limit),
+      clock_(std::move(clock)),
+      last_sweep_(clock_()) {}
+
+std::shared_ptr<AdaptiveConcurrencyLimiter> AdaptiveConcurrencyClient::Limiter(
+    std::string const& bucket_name) {
+  auto const now = clock_();
+  std::lock_guard<std::mutex> lk(mu_);
+  if (now - last_sweep_ >= kIdleTimeout) {
+    EvictIdle(now);
+  }
+  auto& entry = limiters_[bucket_name];
+  if (!entry.limiter) {
+    entry.limiter = std::make_shared<AdaptiveConcurrencyLimiter>(
+        initial_limit_, maximum_limit_);
+  }
+  entry.last_used = now;
+  return entry.limiter;
+}
+
+std::size_t AdaptiveConcurrencyClient::limiter_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return limiters_.size();
+}
+
+void AdaptiveConcurrencyClient::EvictIdle(Clock::time_point now) {
+  last_sweep_ = now;
+  for (auto i = limiters_.begin(); i != limiters_.end();) {
+    // Limiters referenced elsewhere have requests, downloads, or uploads in
+    // progress.
+    if (now - i->second.last_used >= kIdleTimeout &&
+        i->second.limiter.use_count() == 1) {
+      i = limiters_.erase(i);
+      continue;
+    }
+    ++i;
+  }
+}
+
+ClientOptions const& AdaptiveConcurrencyClient::client_options() const {
+  return client_->client_options();
+}
+
+StatusOr<ListBucketsResponse> AdaptiveConcurrencyClient::ListBuckets(
+    ListBucketsRequest const& request) {
+  return client_->ListBuckets(request);
+}
+
+StatusOr<BucketMetadata> AdaptiveConcurrencyClient::CreateBucket(
+    CreateBucketRequest const& request) {
+  return MakeCall(*this, request.metadata().name(), *client_,
+                  &RawClient::CreateBucket, request);
+}
+
+StatusOr<BucketMetadata> AdaptiveConcurrencyClient::GetBucketMetadata(
+    GetBucketMetadataRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::GetBucketMetadata, request);
+}
+
+StatusOr<EmptyResponse> AdaptiveConcurrencyClient::DeleteBucket(
+    DeleteBucketRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::DeleteBucket, request);
+}
+
+StatusOr<BucketMetadata> AdaptiveConcurrencyClient::UpdateBucket(
+    UpdateBucketRequest const& request) {
+  return MakeCall(*this, request.metadata().name(), *client_,
+                  &RawClient::UpdateBucket, request);
+}
+
+StatusOr<BucketMetadata> AdaptiveConcurrencyClient::PatchBucket(
+    PatchBucketRequest const& request) {
+  return MakeCall(*this, request.bucket(), *client_,
+                  &RawClient::PatchBucket, request);
+}
+
+StatusOr<IamPolicy> AdaptiveConcurrencyClient::GetBucketIamPolicy(
+    GetBucketIamPolicyRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::GetBucketIamPolicy, request);
+}
+
+StatusOr<IamPolicy> AdaptiveConcurrencyClient::SetBucketIamPolicy(
+    SetBucketIamPolicyRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::SetBucketIamPolicy, request);
+}
+
+StatusOr<TestBucketIamPermissionsResponse>
+AdaptiveConcurrencyClient::TestBucketIamPermissions(
+    TestBucketIamPermissionsRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::TestBucketIamPermissions, request);
+}
+
+StatusOr<BucketMetadata> AdaptiveConcurrencyClient::LockBucketRetentionPolicy(
+    LockBucketRetentionPolicyRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::LockBucketRetentionPolicy, request);
+}
+
+StatusOr<ObjectMetadata> AdaptiveConcurrencyClient::InsertObjectMedia(
+    InsertObjectMediaRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::InsertObjectMedia, request);
+}
+
+StatusOr<ObjectMetadata> AdaptiveConcurrencyClient::CopyObject(
+    CopyObjectRequest const& request) {
+  return MakeCall(*this, request.destination_bucket(), *client_,
+                  &RawClient::CopyObject, request);
+}
+
+StatusOr<ObjectMetadata> AdaptiveConcurrencyClient::GetObjectMetadata(
+    GetObjectMetadataRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::GetObjectMetadata, request);
+}
+
+StatusOr<std::unique_ptr<ObjectReadSource>>
+AdaptiveConcurrencyClient::ReadObject(ReadObjectRangeRequest const& request) {
+  // Creating the source does not send the request, the first `Read()` does,
+  // and only that call is limited.
+  auto source = client_->ReadObject(request);
+  if (!source) {
+    return source;
+  }
+  return std::unique_ptr<ObjectReadSource>(
+      google::cloud::internal::make_unique<AdaptiveConcurrencyReadSource>(
+          Limiter(request.bucket_name()), *std::move(source)));
+}
+
+StatusOr<ListObjectsResponse> AdaptiveConcurrencyClient::ListObjects(
+    ListObjectsRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::ListObjects, request);
+}
+
+StatusOr<ListObjectSummariesResponse>
+AdaptiveConcurrencyClient::ListObjectSummaries(
+    ListObjectsRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::ListObjectSummaries, request);
+}
+
+StatusOr<EmptyResponse> AdaptiveConcurrencyClient::DeleteObject(
+    DeleteObjectRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::DeleteObject, request);
+}
+
+StatusOr<ObjectMetadata> AdaptiveConcurrencyClient::UpdateObject(
+    UpdateObjectRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::UpdateObject, request);
+}
+
+StatusOr<ObjectMetadata> AdaptiveConcurrencyClient::PatchObject(
+    PatchObjectRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::PatchObject, request);
+}
+
+StatusOr<ObjectMetadata> AdaptiveConcurrencyClient::ComposeObject(
+    ComposeObjectRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::ComposeObject, request);
+}
+
+StatusOr<RewriteObjectResponse> AdaptiveConcurrencyClient::RewriteObject(
+    RewriteObjectRequest const& request) {
+  return MakeCall(*this, request.destination_bucket(), *client_,
+                  &RawClient::RewriteObject, request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+AdaptiveConcurrencyClient::CreateResumableSession(
+    ResumableUploadRequest const& request) {
+  auto limiter = Limiter(request.bucket_name());
+  auto session = Limit(*limiter, [this, &request] {
+    return client_->CreateResumableSession(request);
+  });
+  if (!session.ok()) {
+    return session;
+  }
+  return std::unique_ptr<ResumableUploadSession>(
+      google::cloud::internal::make_unique<
+          AdaptiveConcurrencyResumableUploadSession>(
+          std::move(limiter), std::move(session).value()));
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+AdaptiveConcurrencyClient::RestoreResumableSession(std::string const& request) {
+  return client_->RestoreResumableSession(request);
+}
+
+StatusOr<ListBucketAclResponse> AdaptiveConcurrencyClient::ListBucketAcl(
+    ListBucketAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::ListBucketAcl, request);
+}
+
+StatusOr<BucketAccessControl> AdaptiveConcurrencyClient::GetBucketAcl(
+    GetBucketAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::GetBucketAcl, request);
+}
+
+StatusOr<BucketAccessControl> AdaptiveConcurrencyClient::CreateBucketAcl(
+    CreateBucketAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::CreateBucketAcl, request);
+}
+
+StatusOr<EmptyResponse> AdaptiveConcurrencyClient::DeleteBucketAcl(
+    DeleteBucketAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::DeleteBucketAcl, request);
+}
+
+StatusOr<BucketAccessControl> AdaptiveConcurrencyClient::UpdateBucketAcl(
+    UpdateBucketAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::UpdateBucketAcl, request);
+}
+
+StatusOr<BucketAccessControl> AdaptiveConcurrencyClient::PatchBucketAcl(
+    PatchBucketAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::PatchBucketAcl, request);
+}
+
+StatusOr<ListObjectAclResponse> AdaptiveConcurrencyClient::ListObjectAcl(
+    ListObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::ListObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> AdaptiveConcurrencyClient::CreateObjectAcl(
+    CreateObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::CreateObjectAcl, request);
+}
+
+StatusOr<EmptyResponse> AdaptiveConcurrencyClient::DeleteObjectAcl(
+    DeleteObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::DeleteObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> AdaptiveConcurrencyClient::GetObjectAcl(
+    GetObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::GetObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> AdaptiveConcurrencyClient::UpdateObjectAcl(
+    UpdateObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::UpdateObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> AdaptiveConcurrencyClient::PatchObjectAcl(
+    PatchObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::PatchObjectAcl, request);
+}
+
+StatusOr<ListDefaultObjectAclResponse>
+AdaptiveConcurrencyClient::ListDefaultObjectAcl(
+    ListDefaultObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::ListDefaultObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> AdaptiveConcurrencyClient::CreateDefaultObjectAcl(
+    CreateDefaultObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::CreateDefaultObjectAcl, request);
+}
+
+StatusOr<EmptyResponse> AdaptiveConcurrencyClient::DeleteDefaultObjectAcl(
+    DeleteDefaultObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::DeleteDefaultObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> AdaptiveConcurrencyClient::GetDefaultObjectAcl(
+    GetDefaultObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::GetDefaultObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> AdaptiveConcurrencyClient::UpdateDefaultObjectAcl(
+    UpdateDefaultObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::UpdateDefaultObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> AdaptiveConcurrencyClient::PatchDefaultObjectAcl(
+    PatchDefaultObjectAclRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::PatchDefaultObjectAcl, request);
+}
+
+StatusOr<ServiceAccount> AdaptiveConcurrencyClient::GetServiceAccount(
+    GetProjectServiceAccountRequest const& request) {
+  return client_->GetServiceAccount(request);
+}
+
+StatusOr<ListHmacKeysResponse> AdaptiveConcurrencyClient::ListHmacKeys(
+    ListHmacKeysRequest const& request) {
+  return client_->ListHmacKeys(request);
+}
+
+StatusOr<CreateHmacKeyResponse> AdaptiveConcurrencyClient::CreateHmacKey(
+    CreateHmacKeyRequest const& request) {
+  return client_->CreateHmacKey(request);
+}
+
+StatusOr<EmptyResponse> AdaptiveConcurrencyClient::DeleteHmacKey(
+    DeleteHmacKeyRequest const& request) {
+  return client_->DeleteHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> AdaptiveConcurrencyClient::GetHmacKey(
+    GetHmacKeyRequest const& request) {
+  return client_->GetHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> AdaptiveConcurrencyClient::UpdateHmacKey(
+    UpdateHmacKeyRequest const& request) {
+  return client_->UpdateHmacKey(request);
+}
+
+StatusOr<SignBlobResponse> AdaptiveConcurrencyClient::SignBlob(
+    SignBlobRequest const& request) {
+  return client_->SignBlob(request);
+}
+
+StatusOr<ListNotificationsResponse>
+AdaptiveConcurrencyClient::ListNotifications(
+    ListNotificationsRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::ListNotifications, request);
+}
+
+StatusOr<NotificationMetadata> AdaptiveConcurrencyClient::CreateNotification(
+    CreateNotificationRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::CreateNotification, request);
+}
+
+StatusOr<NotificationMetadata> AdaptiveConcurrencyClient::GetNotification(
+    GetNotificationRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::GetNotification, request);
+}
+
+StatusOr<EmptyResponse> AdaptiveConcurrencyClient::DeleteNotification(
+    DeleteNotificationRequest const& request) {
+  return MakeCall(*this, request.bucket_name(), *client_,
+                  &RawClient::DeleteNotification, request);
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,245 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/adaptive_concurrency_client.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/storage/transfer_metrics.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <future>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::TransientError;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+
+TEST(AdaptiveConcurrencyClientTest, LimitsEachBucket) {
+  auto mock = std::make_shared<testing::MockClient>();
+  AdaptiveConcurrencyClient client(mock, 4, 16);
+
+  EXPECT_CALL(*mock, GetObjectMetadata(_))
+      .WillRepeatedly(Invoke([](GetObjectMetadataRequest const& r) {
+        if (r.bucket_name() == "overloaded-bucket") {
+          SetLastHttpStatusCode(503);
+          return StatusOr<ObjectMetadata>(TransientError());
+        }
+        SetLastHttpStatusCode(200);
+        return make_status_or(ObjectMetadata{});
+      }));
+
+  auto metadata = client.GetObjectMetadata(
+      GetObjectMetadataRequest("overloaded-bucket", "test-object"));
+  EXPECT_EQ(TransientError().code(), metadata.status().code());
+  metadata = client.GetObjectMetadata(
+      GetObjectMetadataRequest("test-bucket", "test-object"));
+  EXPECT_STATUS_OK(metadata);
+
+  EXPECT_EQ(2.0, client.Limiter("overloaded-bucket")->limit());
+  EXPECT_EQ(4.0, client.Limiter("test-bucket")->limit());
+}
+
+TEST(AdaptiveConcurrencyClientTest, NetworkErrorsDoNotDecrease) {
+  auto mock = std::make_shared<testing::MockClient>();
+  AdaptiveConcurrencyClient client(mock, 4, 16);
+
+  // A dropped connection is reported as `kUnavailable`, like HTTP 503, but
+  // there is no HTTP response.
+  EXPECT_CALL(*mock, GetObjectMetadata(_))
+      .WillOnce(Return(StatusOr<ObjectMetadata>(TransientError())));
+
+  auto metadata = client.GetObjectMetadata(
+      GetObjectMetadataRequest("test-bucket", "test-object"));
+  EXPECT_EQ(TransientError().code(), metadata.status().code());
+  EXPECT_EQ(4.0, client.Limiter("test-bucket")->limit());
+}
+
+TEST(AdaptiveConcurrencyClientTest, QueuesRequestsOverTheLimit) {
+  auto mock = std::make_shared<testing::MockClient>();
+  AdaptiveConcurrencyClient client(mock, 1, 1);
+  auto limiter = client.Limiter("test-bucket");
+
+  std::promise<void> started;
+  std::promise<void> unblock;
+  auto unblocked = unblock.get_future().share();
+  EXPECT_CALL(*mock, DeleteObject(_))
+      .WillOnce(Invoke([&started, unblocked](DeleteObjectRequest const&) {
+        started.set_value();
+        unblocked.wait();
+        return make_status_or(EmptyResponse{});
+      }))
+      .WillOnce(Return(make_status_or(EmptyResponse{})));
+
+  DeleteObjectRequest request("test-bucket", "test-object");
+  std::thread first([&] { EXPECT_STATUS_OK(client.DeleteObject(request)); });
+  started.get_future().wait();
+  std::thread second([&] { EXPECT_STATUS_OK(client.DeleteObject(request)); });
+  while (limiter->queued() != 1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(1U, limiter->in_flight());
+
+  unblock.set_value();
+  first.join();
+  second.join();
+  EXPECT_EQ(0U, limiter->in_flight());
+  EXPECT_EQ(0U, limiter->queued());
+}
+
+TEST(AdaptiveConcurrencyClientTest, LimitsUploadChunks) {
+  auto mock = std::make_shared<testing::MockClient>();
+  AdaptiveConcurrencyClient client(mock, 8, 16);
+
+  EXPECT_CALL(*mock, CreateResumableSession(_))
+      .WillOnce(Invoke([](ResumableUploadRequest const&) {
+        auto session = google::cloud::internal::make_unique<
+            testing::MockResumableUploadSession>();
+        EXPECT_CALL(*session, UploadChunk(_))
+            .WillOnce(Invoke([](std::string const&) {
+              SetLastHttpStatusCode(429);
+              return StatusOr<ResumableUploadResponse>(TransientError());
+            }));
+        return make_status_or(
+            std::unique_ptr<ResumableUploadSession>(std::move(session)));
+      }));
+
+  auto session = client.CreateResumableSession(
+      ResumableUploadRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(session);
+  auto response = (*session)->UploadChunk(std::string(1024, 'A'));
+  EXPECT_EQ(TransientError().code(), response.status().code());
+  EXPECT_EQ(4.0, client.Limiter("test-bucket")->limit());
+}
+
+std::unique_ptr<ObjectReadSource> MakeDownload(long first_status_code) {
+  auto source =
+      google::cloud::internal::make_unique<testing::MockObjectReadSource>();
+  EXPECT_CALL(*source, Read(_, _))
+      .WillOnce(
+          Return(ReadSourceResult{16, HttpResponse{first_status_code, {}, {}}}))
+      .WillRepeatedly(Return(ReadSourceResult{16, HttpResponse{200, {}, {}}}));
+  return std::unique_ptr<ObjectReadSource>(std::move(source));
+}
+
+TEST(AdaptiveConcurrencyClientTest, DownloadReleasesSlotAfterFirstRead) {
+  auto mock = std::make_shared<testing::MockClient>();
+  AdaptiveConcurrencyClient client(mock, 1, 1);
+  auto limiter = client.Limiter("test-bucket");
+
+  EXPECT_CALL(*mock, ReadObject(_))
+      .WillRepeatedly(Invoke([](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeDownload(100));
+      }));
+  EXPECT_CALL(*mock, GetObjectMetadata(_))
+      .WillOnce(Return(make_status_or(ObjectMetadata{})));
+
+  // With a limit of 1, a single thread opens two downloads, reads from both,
+  // and makes another request for the same bucket. None of them blocks.
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  auto first = client.ReadObject(request);
+  ASSERT_STATUS_OK(first);
+  auto second = client.ReadObject(request);
+  ASSERT_STATUS_OK(second);
+  EXPECT_EQ(0U, limiter->in_flight());
+
+  char buffer[16];
+  ASSERT_STATUS_OK((*first)->Read(buffer, sizeof(buffer)));
+  EXPECT_EQ(0U, limiter->in_flight());
+  ASSERT_STATUS_OK((*second)->Read(buffer, sizeof(buffer)));
+  EXPECT_EQ(0U, limiter->in_flight());
+  EXPECT_STATUS_OK(client.GetObjectMetadata(
+      GetObjectMetadataRequest("test-bucket", "test-object")));
+  ASSERT_STATUS_OK((*first)->Read(buffer, sizeof(buffer)));
+  ASSERT_STATUS_OK((*second)->Read(buffer, sizeof(buffer)));
+  EXPECT_EQ(0U, limiter->in_flight());
+  EXPECT_EQ(0U, limiter->queued());
+}
+
+TEST(AdaptiveConcurrencyClientTest, DownloadOverloadDecreasesLimit) {
+  auto mock = std::make_shared<testing::MockClient>();
+  AdaptiveConcurrencyClient client(mock, 4, 4);
+
+  EXPECT_CALL(*mock, ReadObject(_))
+      .WillOnce(Invoke([](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeDownload(503));
+      }));
+
+  auto source =
+      client.ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  char buffer[16];
+  auto result = (*source)->Read(buffer, sizeof(buffer));
+  ASSERT_STATUS_OK(result);
+  EXPECT_EQ(503, result->response.status_code);
+  EXPECT_EQ(2.0, client.Limiter("test-bucket")->limit());
+}
+
+TEST(AdaptiveConcurrencyClientTest, EvictsIdleLimiters) {
+  auto mock = std::make_shared<testing::MockClient>();
+  auto now = std::chrono::steady_clock::now();
+  AdaptiveConcurrencyClient client(mock, 4, 16, [&now] { return now; });
+
+  auto busy = client.Limiter("busy-bucket");
+  (void)client.Limiter("idle-bucket");
+  EXPECT_EQ(2U, client.limiter_count());
+
+  now += std::chrono::minutes(1);
+  (void)client.Limiter("new-bucket");
+  EXPECT_EQ(3U, client.limiter_count());
+
+  // Only limiters that are not in use, and have been idle long enough, are
+  // discarded.
+  now += std::chrono::minutes(5);
+  (void)client.Limiter("another-bucket");
+  EXPECT_EQ(2U, client.limiter_count());
+  EXPECT_EQ(busy, client.Limiter("busy-bucket"));
+}
+
+TEST(AdaptiveConcurrencyClientTest, ClientDecoration) {
+  auto options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  Client plain(options);
+  auto retry = std::dynamic_pointer_cast<RetryClient>(plain.raw_client());
+  ASSERT_NE(nullptr, retry);
+  auto logging = std::dynamic_pointer_cast<LoggingClient>(retry->client());
+  ASSERT_NE(nullptr, logging);
+  EXPECT_EQ(nullptr, dynamic_cast<AdaptiveConcurrencyClient*>(
+                         logging->client().get()));
+
+  options.set_adaptive_concurrency_initial_limit(4);
+  Client limited(options);
+  retry = std::dynamic_pointer_cast<RetryClient>(limited.raw_client());
+  ASSERT_NE(nullptr, retry);
+  logging = std::dynamic_pointer_cast<LoggingClient>(retry->client());
+  ASSERT_NE(nullptr, logging);
+  EXPECT_NE(nullptr, dynamic_cast<AdaptiveConcurrencyClient*>(
+                         logging->client().get()));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,96 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/adaptive_concurrency_limiter.h"
+#include <algorithm>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+AdaptiveConcurrencyLimiter::AdaptiveConcurrencyLimiter(
+    std::size_t initial_limit, std::size_t maximum_limit)
+    : maximum_limit_(static_cast<double>(
+          (std::max)({initial_limit, maximum_limit, std::size_t(1)}))),
+      limit_(static_cast<double>((std::max)(initial_limit, std::size_t(1)))) {
+}
+
+AdaptiveConcurrencyLimiter::Permit AdaptiveConcurrencyLimiter::Acquire() {
+  std::unique_lock<std::mutex> lk(mu_);
+  auto const ticket = next_ticket_++;
+  AdmitWaiters(lk);
+  // The request is saturating the limiter if it had to wait, or if it used
+  // the last available slot.
+  bool saturated = ticket >= admitted_;
+  cv_.wait(lk, [this, ticket] { return ticket < admitted_; });
+  saturated = saturated || static_cast<double>(in_flight_) + 1 > limit_;
+  return Permit{epoch_, saturated};
+}
+
+void AdaptiveConcurrencyLimiter::Release(Permit const& permit,
+                                         Status const& status,
+                                         long http_status_code) {
+  std::unique_lock<std::mutex> lk(mu_);
+  --in_flight_;
+  if (IsOverloaded(status, http_status_code)) {
+    if (permit.epoch == epoch_) {
+      limit_ = (std::max)(minimum_limit_, limit_ / 2);
+      ++epoch_;
+    }
+  } else if (status.ok() && permit.saturated) {
+    limit_ = (std::min)(maximum_limit_, limit_ + 1.0 / limit_);
+  }
+  AdmitWaiters(lk);
+}
+
+bool AdaptiveConcurrencyLimiter::IsOverloaded(Status const& status,
+                                              long http_status_code) {
+  // 429 - Too Many Requests, 503 - Service Unavailable
+  return !status.ok() && (http_status_code == 429 || http_status_code == 503);
+}
+
+double AdaptiveConcurrencyLimiter::limit() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return limit_;
+}
+
+std::size_t AdaptiveConcurrencyLimiter::in_flight() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return in_flight_;
+}
+
+std::size_t AdaptiveConcurrencyLimiter::queued() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return static_cast<std::size_t>(next_ticket_ - admitted_);
+}
+
+void AdaptiveConcurrencyLimiter::AdmitWaiters(std::unique_lock<std::mutex>&) {
+  bool admitted = false;
+  while (admitted_ != next_ticket_ &&
+         static_cast<double>(in_flight_) + 1 <= limit_) {
+    ++admitted_;
+    ++in_flight_;
+    admitted = true;
+  }
+  if (admitted) {
+    cv_.notify_all();
+  }
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,106 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_ADAPTIVE_CONCURRENCY_LIMITER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_ADAPTIVE_CONCURRENCY_LIMITER_H_
+
+#include "google/cloud/status.h"
+#include "google/cloud/storage/version.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Limits the number of concurrent requests, adapting the limit to the load.
+ *
+ * The limit follows an additive-increase/multiplicative-decrease (AIMD)
+ * policy: each successful request that found the limiter saturated increases
+ * the limit by `1 / limit`, that is, about one request per round-trip. A
+ * request that fails because the service is overloaded (HTTP 429 or 503)
+ * halves the limit. Other errors, including network errors reported as
+ * `kUnavailable`, do not change the limit.
+ *
+ * Requests sent before a decrease have not seen the new limit, their failures
+ * do not decrease the limit again. Without this rule a single burst of
+ * overload errors would collapse the limit to the minimum.
+ *
+ * Requests over the limit wait in the calling thread, and start in the order
+ * they arrived.
+ */
+class AdaptiveConcurrencyLimiter {
+ public:
+  /// Created by `Acquire()`, must be passed back to `Release()`.
+  struct Permit {
+    std::uint64_t epoch;
+    bool saturated;
+  };
+
+  /**
+   * Creates a limiter.
+   *
+   * @param initial_limit the initial number of concurrent requests.
+   * @param maximum_limit the limit never grows beyond this value, it is
+   *     increased to @p initial_limit if smaller.
+   */
+  AdaptiveConcurrencyLimiter(std::size_t initial_limit,
+                             std::size_t maximum_limit);
+
+  /// Blocks until the request can start.
+  Permit Acquire();
+
+  /**
+   * Reports the result of a request started with @p permit.
+   *
+   * @param http_status_code the HTTP status code of the response, zero if
+   *     there was no response.
+   */
+  void Release(Permit const& permit, Status const& status,
+               long http_status_code = 0);
+
+  /// Returns true if the request failed because the service is overloaded.
+  static bool IsOverloaded(Status const& status, long http_status_code);
+
+  double limit() const;
+  std::size_t in_flight() const;
+  std::size_t queued() const;
+
+ private:
+  /// Admit waiting requests while there is capacity.
+  void AdmitWaiters(std::unique_lock<std::mutex>& lk);
+
+  double const minimum_limit_ = 1.0;
+  double const maximum_limit_;
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  double limit_;                    // GUARDED_BY(mu_)
+  std::size_t in_flight_ = 0;       // GUARDED_BY(mu_)
+  std::uint64_t epoch_ = 0;         // GUARDED_BY(mu_)
+  // Requests get a ticket when they arrive, and start in ticket order.
+  std::uint64_t next_ticket_ = 0;   // GUARDED_BY(mu_)
+  std::uint64_t admitted_ = 0;      // GUARDED_BY(mu_)
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_ADAPTIVE_CONCURRENCY_LIMITER_H_
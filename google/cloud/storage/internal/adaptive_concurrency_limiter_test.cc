@@ -0,0 +1,160 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/adaptive_concurrency_limiter.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include <gmock/gmock.h>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::google::cloud::storage::testing::canonical_errors::TransientError;
+
+/// Wait until @p limiter has @p count queued requests.
+void WaitForQueued(AdaptiveConcurrencyLimiter const& limiter,
+                   std::size_t count) {
+  while (limiter.queued() != count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+TEST(AdaptiveConcurrencyLimiterTest, QueuesRequestsOverTheLimit) {
+  AdaptiveConcurrencyLimiter limiter(2, 8);
+  auto p1 = limiter.Acquire();
+  auto p2 = limiter.Acquire();
+  EXPECT_FALSE(p1.saturated);
+  EXPECT_TRUE(p2.saturated);
+  EXPECT_EQ(2U, limiter.in_flight());
+
+  std::thread t([&limiter] {
+    auto p3 = limiter.Acquire();
+    EXPECT_TRUE(p3.saturated);
+    limiter.Release(p3, PermanentError());
+  });
+  WaitForQueued(limiter, 1);
+  EXPECT_EQ(2U, limiter.in_flight());
+
+  limiter.Release(p1, PermanentError());
+  t.join();
+  EXPECT_EQ(0U, limiter.queued());
+  EXPECT_EQ(1U, limiter.in_flight());
+  limiter.Release(p2, PermanentError());
+  EXPECT_EQ(0U, limiter.in_flight());
+  // Errors that are not caused by overload do not change the limit.
+  EXPECT_EQ(2.0, limiter.limit());
+}
+
+TEST(AdaptiveConcurrencyLimiterTest, AdditiveIncrease) {
+  AdaptiveConcurrencyLimiter limiter(1, 3);
+  auto p = limiter.Acquire();
+  limiter.Release(p, Status());
+  EXPECT_EQ(2.0, limiter.limit());
+
+  // Requests that do not saturate the limiter do not increase the limit.
+  p = limiter.Acquire();
+  EXPECT_FALSE(p.saturated);
+  limiter.Release(p, Status());
+  EXPECT_EQ(2.0, limiter.limit());
+
+  auto p1 = limiter.Acquire();
+  auto p2 = limiter.Acquire();
+  limiter.Release(p1, Status());
+  limiter.Release(p2, Status());
+  EXPECT_EQ(2.5, limiter.limit());
+
+  // The limit never exceeds the maximum.
+  for (int i = 0; i != 10; ++i) {
+    p1 = limiter.Acquire();
+    p2 = limiter.Acquire();
+    limiter.Release(p1, Status());
+    limiter.Release(p2, Status());
+  }
+  EXPECT_EQ(3.0, limiter.limit());
+}
+
+TEST(AdaptiveConcurrencyLimiterTest, MultiplicativeDecrease) {
+  AdaptiveConcurrencyLimiter limiter(8, 8);
+  std::vector<AdaptiveConcurrencyLimiter::Permit> permits;
+  for (int i = 0; i != 4; ++i) {
+    permits.push_back(limiter.Acquire());
+  }
+  // All the requests started before the first failure, only one of them
+  // reduces the limit.
+  for (auto const& p : permits) {
+    limiter.Release(p, TransientError(), 503);
+  }
+  EXPECT_EQ(4.0, limiter.limit());
+
+  for (int i = 0; i != 4; ++i) {
+    auto p = limiter.Acquire();
+    limiter.Release(p, TransientError(), 429);
+  }
+  EXPECT_EQ(1.0, limiter.limit());
+}
+
+TEST(AdaptiveConcurrencyLimiterTest, OnlyOverloadErrorsDecrease) {
+  AdaptiveConcurrencyLimiter limiter(8, 8);
+  // Network errors are also `kUnavailable`, but there was no response.
+  auto p = limiter.Acquire();
+  limiter.Release(p, TransientError(), 0);
+  p = limiter.Acquire();
+  limiter.Release(p, TransientError(), 500);
+  p = limiter.Acquire();
+  limiter.Release(p, PermanentError(), 404);
+  EXPECT_EQ(8.0, limiter.limit());
+
+  EXPECT_TRUE(AdaptiveConcurrencyLimiter::IsOverloaded(TransientError(), 429));
+  EXPECT_TRUE(AdaptiveConcurrencyLimiter::IsOverloaded(TransientError(), 503));
+  EXPECT_FALSE(AdaptiveConcurrencyLimiter::IsOverloaded(TransientError(), 0));
+  EXPECT_FALSE(AdaptiveConcurrencyLimiter::IsOverloaded(Status(), 503));
+}
+
+TEST(AdaptiveConcurrencyLimiterTest, FifoOrder) {
+  AdaptiveConcurrencyLimiter limiter(1, 1);
+  auto first = limiter.Acquire();
+
+  std::mutex mu;
+  std::vector<int> order;
+  std::vector<std::thread> threads;
+  for (int i = 0; i != 4; ++i) {
+    threads.emplace_back([&, i] {
+      auto p = limiter.Acquire();
+      {
+        std::lock_guard<std::mutex> lk(mu);
+        order.push_back(i);
+      }
+      limiter.Release(p, Status());
+    });
+    WaitForQueued(limiter, i + 1);
+  }
+  limiter.Release(first, Status());
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), order);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,336 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/caching_client.h"
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+CachingClient::CachingClient(std::shared_ptr<RawClient> client,
+                             ObjectDiskCache cache)
+    : client_(std::move(client)), cache_(std::move(cache)) {}
+
+ClientOptions const& CachingClient::client_options() const {
+  return client_->client_options();
+}
+
+StatusOr<ListBucketsResponse> CachingClient::ListBuckets(
+    ListBucketsRequest const& request) {
+  return client_->ListBuckets(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::CreateBucket(
+    CreateBucketRequest const& request) {
+  return client_->CreateBucket(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::GetBucketMetadata(
+    GetBucketMetadataRequest const& request) {
+  return client_->GetBucketMetadata(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteBucket(
+    DeleteBucketRequest const& request) {
+  return client_->DeleteBucket(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::UpdateBucket(
+    UpdateBucketRequest const& request) {
+  return client_->UpdateBucket(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::PatchBucket(
+    PatchBucketRequest const& request) {
+  return client_->PatchBucket(request);
+}
+
+StatusOr<IamPolicy> CachingClient::GetBucketIamPolicy(
+    GetBucketIamPolicyRequest const& request) {
+  return client_->GetBucketIamPolicy(request);
+}
+
+StatusOr<IamPolicy> CachingClient::SetBucketIamPolicy(
+    SetBucketIamPolicyRequest const& request) {
+  return client_->SetBucketIamPolicy(request);
+}
+
+StatusOr<TestBucketIamPermissionsResponse>
+CachingClient::TestBucketIamPermissions(
+    TestBucketIamPermissionsRequest const& request) {
+  return client_->TestBucketIamPermissions(request);
+}
+
+StatusOr<BucketMetadata> CachingClient::LockBucketRetentionPolicy(
+    LockBucketRetentionPolicyRequest const& request) {
+  return client_->LockBucketRetentionPolicy(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::InsertObjectMedia(
+    InsertObjectMediaRequest const& request) {
+  return client_->InsertObjectMedia(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::CopyObject(
+    CopyObjectRequest const& request) {
+  return client_->CopyObject(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::GetObjectMetadata(
+    GetObjectMetadataRequest const& request) {
+  return client_->GetObjectMetadata(request);
+}
+
+StatusOr<std::unique_ptr<ObjectReadSource>> CachingClient::ReadObject(
+    ReadObjectRangeRequest const& request) {
+  // Downloads requesting the stored gzip bytes return different data, and
+  // different headers, than plain downloads of the same object. The cache
+  // stores neither the encoding nor the headers, so these are never cached.
+  if (request.HasOption<EncryptionKey>() ||
+      request.RequiresGzipDecompression()) {
+    return client_->ReadObject(request);
+  }
+  // Always fetch the metadata, even if the request pins a generation: the
+  // service checks that the caller can still read the object. The cache is
+  // shared by all the credentials using the same directory.
+  GetObjectMetadataRequest metadata_request(request.bucket_name(),
+                                            request.object_name());
+  metadata_request.set_multiple_options(
+      request.GetOption<Generation>(), request.GetOption<IfGenerationMatch>(),
+      request.GetOption<IfGenerationNotMatch>(),
+      request.GetOption<IfMetagenerationMatch>(),
+      request.GetOption<IfMetagenerationNotMatch>(),
+      request.GetOption<UserProject>());
+  auto metadata = client_->GetObjectMetadata(metadata_request);
+  if (!metadata) {
+    return std::move(metadata).status();
+  }
+  if (metadata->crc32c().empty() || !metadata->content_encoding().empty()) {
+    // Without a checksum we cannot validate the cached data. Objects with a
+    // content encoding may be transcoded by the service, and then the data
+    // does not match the checksum either.
+    return client_->ReadObject(request);
+  }
+  auto cached = cache_.Lookup(*metadata, request);
+  if (cached) {
+    return StatusOr<std::unique_ptr<ObjectReadSource>>(std::move(cached));
+  }
+
+  // Download the same generation we just looked up, otherwise the cache could
+  // associate the data for a newer generation with the older metadata.
+  ReadObjectRangeRequest pinned = request;
+  pinned.set_option(Generation(metadata->generation()));
+  auto source = client_->ReadObject(pinned);
+  if (!source || request.RequiresRangeHeader()) {
+    return source;
+  }
+  return cache_.Insert(*std::move(metadata), *std::move(source));
+}
+
+StatusOr<ListObjectsResponse> CachingClient::ListObjects(
+    ListObjectsRequest const& request) {
+  return client_->ListObjects(request);
+}
+
+StatusOr<ListObjectSummariesResponse> CachingClient::ListObjectSummaries(
+    ListObjectsRequest const& request) {
+  return client_->ListObjectSummaries(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteObject(
+    DeleteObjectRequest const& request) {
+  return client_->DeleteObject(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::UpdateObject(
+    UpdateObjectRequest const& request) {
+  return client_->UpdateObject(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::PatchObject(
+    PatchObjectRequest const& request) {
+  return client_->PatchObject(request);
+}
+
+StatusOr<ObjectMetadata> CachingClient::ComposeObject(
+    ComposeObjectRequest const& request) {
+  return client_->ComposeObject(request);
+}
+
+StatusOr<RewriteObjectResponse> CachingClient::RewriteObject(
+    RewriteObjectRequest const& request) {
+  return client_->RewriteObject(request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+CachingClient::CreateResumableSession(ResumableUploadRequest const& request) {
+  return client_->CreateResumableSession(request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+CachingClient::RestoreResumableSession(std::string const& request) {
+  return client_->RestoreResumableSession(request);
+}
+
+StatusOr<ListBucketAclResponse> CachingClient::ListBucketAcl(
+    ListBucketAclRequest const& request) {
+  return client_->ListBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CachingClient::CreateBucketAcl(
+    CreateBucketAclRequest const& request) {
+  return client_->CreateBucketAcl(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteBucketAcl(
+    DeleteBucketAclRequest const& request) {
+  return client_->DeleteBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CachingClient::GetBucketAcl(
+    GetBucketAclRequest const& request) {
+  return client_->GetBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CachingClient::UpdateBucketAcl(
+    UpdateBucketAclRequest const& request) {
+  return client_->UpdateBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CachingClient::PatchBucketAcl(
+    PatchBucketAclRequest const& request) {
+  return client_->PatchBucketAcl(request);
+}
+
+StatusOr<ListObjectAclResponse> CachingClient::ListObjectAcl(
+    ListObjectAclRequest const& request) {
+  return client_->ListObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::CreateObjectAcl(
+    CreateObjectAclRequest const& request) {
+  return client_->CreateObjectAcl(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteObjectAcl(
+    DeleteObjectAclRequest const& request) {
+  return client_->DeleteObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::GetObjectAcl(
+    GetObjectAclRequest const& request) {
+  return client_->GetObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::UpdateObjectAcl(
+    UpdateObjectAclRequest const& request) {
+  return client_->UpdateObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::PatchObjectAcl(
+    PatchObjectAclRequest const& request) {
+  return client_->PatchObjectAcl(request);
+}
+
+StatusOr<ListDefaultObjectAclResponse> CachingClient::ListDefaultObjectAcl(
+    ListDefaultObjectAclRequest const& request) {
+  return client_->ListDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::CreateDefaultObjectAcl(
+    CreateDefaultObjectAclRequest const& request) {
+  return client_->CreateDefaultObjectAcl(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteDefaultObjectAcl(
+    DeleteDefaultObjectAclRequest const& request) {
+  return client_->DeleteDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::GetDefaultObjectAcl(
+    GetDefaultObjectAclRequest const& request) {
+  return client_->GetDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::UpdateDefaultObjectAcl(
+    UpdateDefaultObjectAclRequest const& request) {
+  return client_->UpdateDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CachingClient::PatchDefaultObjectAcl(
+    PatchDefaultObjectAclRequest const& request) {
+  return client_->PatchDefaultObjectAcl(request);
+}
+
+StatusOr<ServiceAccount> CachingClient::GetServiceAccount(
+    GetProjectServiceAccountRequest const& request) {
+  return client_->GetServiceAccount(request);
+}
+
+StatusOr<ListHmacKeysResponse> CachingClient::ListHmacKeys(
+    ListHmacKeysRequest const& request) {
+  return client_->ListHmacKeys(request);
+}
+
+StatusOr<CreateHmacKeyResponse> CachingClient::CreateHmacKey(
+    CreateHmacKeyRequest const& request) {
+  return client_->CreateHmacKey(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteHmacKey(
+    DeleteHmacKeyRequest const& request) {
+  return client_->DeleteHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> CachingClient::GetHmacKey(
+    GetHmacKeyRequest const& request) {
+  return client_->GetHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> CachingClient::UpdateHmacKey(
+    UpdateHmacKeyRequest const& request) {
+  return client_->UpdateHmacKey(request);
+}
+
+StatusOr<SignBlobResponse> CachingClient::SignBlob(
+    SignBlobRequest const& request) {
+  return client_->SignBlob(request);
+}
+
+StatusOr<ListNotificationsResponse> CachingClient::ListNotifications(
+    ListNotificationsRequest const& request) {
+  return client_->ListNotifications(request);
+}
+
+StatusOr<NotificationMetadata> CachingClient::CreateNotification(
+    CreateNotificationRequest const& request) {
+  return client_->CreateNotification(request);
+}
+
+StatusOr<NotificationMetadata> CachingClient::GetNotification(
+    GetNotificationRequest const& request) {
+  return client_->GetNotification(request);
+}
+
+StatusOr<EmptyResponse> CachingClient::DeleteNotification(
+    DeleteNotificationRequest const& request) {
+  return client_->DeleteNotification(request);
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
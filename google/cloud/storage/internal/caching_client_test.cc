@@ -0,0 +1,287 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/caching_client.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/internal/random.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/storage/internal/metadata_parser.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <cstdio>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+std::string const kContents = "The quick brown fox jumps over the lazy dog";
+
+std::unique_ptr<ObjectReadSource> MakeSource(std::string contents) {
+  auto source = google::cloud::internal::make_unique<
+      ::testing::NiceMock<testing::MockObjectReadSource>>();
+  auto remaining = std::make_shared<std::string>(std::move(contents));
+  ON_CALL(*source, Read(_, _))
+      .WillByDefault(Invoke([remaining](char* buf, std::size_t n) {
+        auto count = (std::min)(n, remaining->size());
+        remaining->copy(buf, count);
+        remaining->erase(0, count);
+        long code = remaining->empty() ? 200 : 100;
+        return ReadSourceResult{count, HttpResponse{code, "", {}}};
+      }));
+  return std::unique_ptr<ObjectReadSource>(std::move(source));
+}
+
+class CachingClientTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = ::testing::TempDir() + "caching-client-" +
+                 google::cloud::internal::Sample(
+                     generator_, 8, "abcdefghijklmnopqrstuvwxyz0123456789");
+    mock_ = std::make_shared<testing::MockClient>();
+    EXPECT_CALL(*mock_, client_options())
+        .WillRepeatedly(ReturnRef(client_options_));
+
+    std::ostringstream os;
+    os << R"""({"bucket": "test-bucket", "name": "test-object",)"""
+       << R"""("generation": "1234", "size": ")""" << kContents.size()
+       << R"""(", "crc32c": ")""" << ComputeCrc32cChecksum(kContents)
+       << R"""("})""";
+    metadata_ = ObjectMetadataParser::FromString(os.str()).value();
+  }
+
+  void TearDown() override {
+    ObjectDiskCache cache(directory_, 0);
+    (void)cache.Evict();
+    std::remove((directory_ + "/cache.lock").c_str());
+    std::remove(directory_.c_str());
+  }
+
+  std::string ReadAll(CachingClient& client,
+                      ReadObjectRangeRequest const& request) {
+    auto source = client.ReadObject(request);
+    EXPECT_STATUS_OK(source);
+    if (!source) {
+      return std::string{};
+    }
+    std::string result;
+    char buffer[16];
+    for (;;) {
+      auto r = (*source)->Read(buffer, sizeof(buffer));
+      EXPECT_STATUS_OK(r);
+      if (!r) {
+        break;
+      }
+      result.append(buffer, r->bytes_received);
+      if (r->response.status_code != 100) {
+        break;
+      }
+    }
+    return result;
+  }
+
+  std::string directory_;
+  google::cloud::internal::DefaultPRNG generator_ =
+      google::cloud::internal::MakeDefaultPRNG();
+  std::shared_ptr<testing::MockClient> mock_;
+  ClientOptions client_options_ =
+      ClientOptions(oauth2::CreateAnonymousCredentials());
+  ObjectMetadata metadata_;
+};
+
+#if !_WIN32
+TEST_F(CachingClientTest, ReadObjectCachesDownload) {
+  CachingClient client(mock_, ObjectDiskCache(directory_, 1024 * 1024));
+
+  EXPECT_CALL(*mock_, GetObjectMetadata(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([this](GetObjectMetadataRequest const& r) {
+        EXPECT_EQ("test-bucket", r.bucket_name());
+        EXPECT_EQ("test-object", r.object_name());
+        return make_status_or(metadata_);
+      }));
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([](ReadObjectRangeRequest const& r) {
+        EXPECT_TRUE(r.HasOption<Generation>());
+        EXPECT_EQ(1234, r.GetOption<Generation>().value());
+        return make_status_or(MakeSource(kContents));
+      }));
+
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  EXPECT_EQ(kContents, ReadAll(client, request));
+  // The second read is served from the cache.
+  EXPECT_EQ(kContents, ReadAll(client, request));
+}
+
+TEST_F(CachingClientTest, PinnedGenerationChecksAccess) {
+  CachingClient client(mock_, ObjectDiskCache(directory_, 1024 * 1024));
+
+  // The cached data is only returned if the service still allows reading the
+  // object.
+  EXPECT_CALL(*mock_, GetObjectMetadata(_))
+      .WillOnce(Return(make_status_or(metadata_)))
+      .WillOnce(Return(StatusOr<ObjectMetadata>(
+          Status(StatusCode::kPermissionDenied, "test-message"))));
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource(kContents));
+      }));
+
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_option(Generation(1234));
+  EXPECT_EQ(kContents, ReadAll(client, request));
+  auto source = client.ReadObject(request);
+  ASSERT_FALSE(source.ok());
+  EXPECT_EQ(StatusCode::kPermissionDenied, source.status().code());
+}
+
+TEST_F(CachingClientTest, PinnedGenerationWithPreconditions) {
+  CachingClient client(mock_, ObjectDiskCache(directory_, 1024 * 1024));
+
+  // Metageneration preconditions require the current metadata.
+  EXPECT_CALL(*mock_, GetObjectMetadata(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([this](GetObjectMetadataRequest const& r) {
+        EXPECT_TRUE(r.HasOption<IfMetagenerationMatch>());
+        return make_status_or(metadata_);
+      }));
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource(kContents));
+      }));
+
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_multiple_options(Generation(1234), IfMetagenerationMatch(1));
+  EXPECT_EQ(kContents, ReadAll(client, request));
+  EXPECT_EQ(kContents, ReadAll(client, request));
+}
+#endif  // !_WIN32
+
+TEST_F(CachingClientTest, RangeReadsAreNotCached) {
+  CachingClient client(mock_, ObjectDiskCache(directory_, 1024 * 1024));
+
+  EXPECT_CALL(*mock_, GetObjectMetadata(_))
+      .Times(2)
+      .WillRepeatedly(Return(make_status_or(metadata_)));
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource(kContents.substr(4, 5)));
+      }));
+
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_option(ReadRange(4, 9));
+  EXPECT_EQ("quick", ReadAll(client, request));
+  EXPECT_EQ("quick", ReadAll(client, request));
+}
+
+TEST_F(CachingClientTest, EncryptedObjectsAreNotCached) {
+  CachingClient client(mock_, ObjectDiskCache(directory_, 1024 * 1024));
+
+  EXPECT_CALL(*mock_, GetObjectMetadata(_)).Times(0);
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([](ReadObjectRangeRequest const& r) {
+        EXPECT_TRUE(r.HasOption<EncryptionKey>());
+        return make_status_or(MakeSource(kContents));
+      }));
+
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_option(EncryptionKey::FromBinaryKey("01234567890123456789012"));
+  EXPECT_EQ(kContents, ReadAll(client, request));
+  EXPECT_EQ(kContents, ReadAll(client, request));
+}
+
+TEST_F(CachingClientTest, MixedGzipAndPlainReadsAreNotCached) {
+  CachingClient client(mock_, ObjectDiskCache(directory_, 1024 * 1024));
+  auto metadata = metadata_;
+  metadata.set_content_encoding("gzip");
+  std::string const compressed = "not really gzip-compressed data";
+
+  // Reads requesting the stored gzip bytes do not need the metadata.
+  EXPECT_CALL(*mock_, GetObjectMetadata(_))
+      .Times(2)
+      .WillRepeatedly(Return(make_status_or(metadata)));
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(4)
+      .WillRepeatedly(Invoke([&](ReadObjectRangeRequest const& r) {
+        return make_status_or(MakeSource(
+            r.RequiresGzipDecompression() ? compressed : kContents));
+      }));
+
+  ReadObjectRangeRequest gzip_request("test-bucket", "test-object");
+  gzip_request.set_option(GzipDecompression(true));
+  ReadObjectRangeRequest plain_request("test-bucket", "test-object");
+  EXPECT_EQ(compressed, ReadAll(client, gzip_request));
+  EXPECT_EQ(kContents, ReadAll(client, plain_request));
+  EXPECT_EQ(compressed, ReadAll(client, gzip_request));
+  EXPECT_EQ(kContents, ReadAll(client, plain_request));
+}
+
+TEST_F(CachingClientTest, MetadataError) {
+  CachingClient client(mock_, ObjectDiskCache(directory_, 1024 * 1024));
+
+  EXPECT_CALL(*mock_, GetObjectMetadata(_))
+      .WillOnce(Return(StatusOr<ObjectMetadata>(PermanentError())));
+  EXPECT_CALL(*mock_, ReadObject(_)).Times(0);
+
+  auto source =
+      client.ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  EXPECT_FALSE(source.ok());
+  EXPECT_EQ(PermanentError().code(), source.status().code());
+}
+
+TEST_F(CachingClientTest, ClientDecoration) {
+  auto options = ClientOptions(oauth2::CreateAnonymousCredentials());
+  options.set_disk_cache_directory("");
+  Client plain(options);
+  EXPECT_EQ(nullptr, dynamic_cast<CachingClient*>(plain.raw_client().get()));
+
+  options.set_disk_cache_directory(directory_).set_disk_cache_max_size(1024);
+  Client caching(options);
+  auto* raw = dynamic_cast<CachingClient*>(caching.raw_client().get());
+#if _WIN32
+  // The cache is not supported on Windows, the option is ignored.
+  EXPECT_EQ(nullptr, raw);
+#else
+  ASSERT_NE(nullptr, raw);
+  EXPECT_EQ(directory_, raw->cache().directory());
+  EXPECT_EQ(1024U, raw->cache().max_size());
+#endif  // _WIN32
+
+  // Clients created from a RawClient are decorated as-is.
+  Client from_raw(mock_);
+  EXPECT_EQ(nullptr,
+            dynamic_cast<CachingClient*>(from_raw.raw_client().get()));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,701 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/coalescing_client.h"
+#include "google/cloud/internal/make_unique.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+class SharedDownload;
+}  // namespace
+
+/// Tracks the downloads that new `ReadObject()` calls can join.
+class CoalescedReadRegistry {
+ public:
+  explicit CoalescedReadRegistry(std::size_t max_shared_bytes)
+      : max_shared_bytes_(max_shared_bytes) {}
+
+  std::size_t max_shared_bytes() const { return max_shared_bytes_; }
+
+  /// Removes @p download, if it is still the download registered for @p key.
+  void Remove(std::string const& key, SharedDownload const* download) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto i = downloads_.find(key);
+    if (i != downloads_.end() && i->second.first == download) {
+      downloads_.erase(i);
+    }
+  }
+
+  std::mutex mu_;
+  std::map<std::string,
+           std::pair<SharedDownload const*, std::weak_ptr<SharedDownload>>>
+      downloads_;  // GUARDED_BY(mu_)
+  std::uint64_t coalesced_count_ = 0;  // GUARDED_BY(mu_)
+
+ private:
+  std::size_t const max_shared_bytes_;
+};
+
+namespace {
+/**
+ * A download shared by one or more `CoalescedReadSource` objects.
+ *
+ * The data received so far is kept in `data_`, each reader consumes it at its
+ * own pace. When a reader needs more data, and no other reader is already
+ * reading from the underlying source, it reads the next block. Otherwise it
+ * waits until the block is available.
+ *
+ * Once the download stops accepting new readers, data more than
+ * `max_shared_bytes()` behind the newest block is released. Readers that fall
+ * that far behind lose their place in the shared download, `Read()` reports
+ * them as detached and they must continue on their own.
+ */
+class SharedDownload {
+ public:
+  SharedDownload(std::shared_ptr<CoalescedReadRegistry> registry,
+                 std::string key)
+      : registry_(std::move(registry)), key_(std::move(key)) {}
+
+  ~SharedDownload() { registry_->Remove(key_, this); }
+
+  /// Called by the first reader once the underlying download has started.
+  void Opened(StatusOr<std::unique_ptr<ObjectReadSource>> source) {
+    bool const failed = !source;
+    std::unique_lock<std::mutex> lk(mu_);
+    opened_ = true;
+    if (failed) {
+      open_status_ = std::move(source).status();
+      joinable_ = false;
+    } else {
+      source_ = *std::move(source);
+    }
+    lk.unlock();
+    cv_.notify_all();
+    if (failed) {
+      registry_->Remove(key_, this);
+    }
+  }
+
+  /// Wait until the download starts, return any errors starting it.
+  Status WaitOpened() {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [this] { return opened_; });
+    return open_status_;
+  }
+
+  /// Adds a reader if the download can still be joined. Requires the
+  /// registry mutex.
+  bool Join(std::size_t* id) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!joinable_) {
+      return false;
+    }
+    *id = next_reader_id_++;
+    readers_[*id] = 0;
+    return true;
+  }
+
+  void Leave(std::size_t id) {
+    std::lock_guard<std::mutex> lk(mu_);
+    readers_.erase(id);
+    Trim();
+  }
+
+  bool IsOpen(std::size_t id) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto i = readers_.find(id);
+    return i != readers_.end() &&
+           !(done_ && i->second == data_offset_ + data_.size());
+  }
+
+  StatusOr<HttpResponse> Close(std::size_t id) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (done_ && !status_.ok()) {
+      return status_;
+    }
+    auto code = done_ ? status_code_ : 200;
+    lk.unlock();
+    Leave(id);
+    return HttpResponse{code, std::string{}, {}};
+  }
+
+  /**
+   * Reads the next block for reader @p id.
+   *
+   * Sets @p detached and returns an empty block if the data for this reader
+   * was already released. The reader is removed from the download.
+   */
+  StatusOr<ReadSourceResult> Read(std::size_t id, std::size_t& headers_seen,
+                                  char* buf, std::size_t n, bool& detached);
+
+ private:
+  /// Releases the data consumed by all the readers, and any data older than
+  /// `max_shared_bytes()`, once no reader can join.
+  void Trim();
+
+  std::shared_ptr<CoalescedReadRegistry> registry_;
+  std::string const key_;
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  bool opened_ = false;          // GUARDED_BY(mu_)
+  Status open_status_;           // GUARDED_BY(mu_)
+  bool joinable_ = true;         // GUARDED_BY(mu_)
+  bool reading_ = false;         // GUARDED_BY(mu_)
+  bool done_ = false;            // GUARDED_BY(mu_)
+  Status status_;                // GUARDED_BY(mu_)
+  long status_code_ = 100;       // GUARDED_BY(mu_)
+  std::string payload_;          // GUARDED_BY(mu_)
+  // Only used by the reader currently reading from the source.
+  std::unique_ptr<ObjectReadSource> source_;
+  std::string block_;
+  // The offset of `data_[0]` within the download.
+  std::uint64_t data_offset_ = 0;  // GUARDED_BY(mu_)
+  std::string data_;               // GUARDED_BY(mu_)
+  // All the headers received so far, each reader tracks how many it has seen.
+  std::vector<std::pair<std::string, std::string>> headers_;
+  // The current offset for each reader.
+  std::size_t next_reader_id_ = 0;                // GUARDED_BY(mu_)
+  std::map<std::size_t, std::uint64_t> readers_;  // GUARDED_BY(mu_)
+};
+
+StatusOr<ReadSourceResult> SharedDownload::Read(std::size_t id,
+                                                std::size_t& headers_seen,
+                                                char* buf, std::size_t n,
+                                                bool& detached) {
+  if (n == 0) {
+    return Status(StatusCode::kInvalidArgument, "Empty buffer for Read()");
+  }
+  std::unique_lock<std::mutex> lk(mu_);
+  auto reader = readers_.find(id);
+  if (reader == readers_.end()) {
+    return Status(StatusCode::kFailedPrecondition,
+                  "Read() called on a closed download");
+  }
+  auto& offset = reader->second;
+  for (;;) {
+    if (offset < data_offset_) {
+      // The data for this reader was released because it fell too far behind
+      // the other readers.
+      readers_.erase(reader);
+      detached = true;
+      return ReadSourceResult{0, HttpResponse{100, std::string{}, {}}};
+    }
+    auto const end = data_offset_ + data_.size();
+    if (offset < end || done_) {
+      if (offset == end && !status_.ok()) {
+        return status_;
+      }
+      auto const count =
+          static_cast<std::size_t>((std::min<std::uint64_t>)(n, end - offset));
+      data_.copy(buf, count, static_cast<std::size_t>(offset - data_offset_));
+      offset += count;
+      ReadSourceResult result{count, HttpResponse{100, std::string{}, {}}};
+      for (; headers_seen != headers_.size(); ++headers_seen) {
+        auto const& kv = headers_[headers_seen];
+        result.response.headers.emplace(kv.first, kv.second);
+      }
+      if (done_ && offset == end && status_.ok()) {
+        result.response.status_code = status_code_;
+        result.response.payload = payload_;
+      }
+      Trim();
+      return result;
+    }
+    if (reading_) {
+      cv_.wait(lk);
+      continue;
+    }
+
+    // This reader takes its turn reading from the underlying source, the
+    // other readers wait for the data.
+    reading_ = true;
+    lk.unlock();
+    block_.resize(n);
+    auto read = source_->Read(&block_[0], block_.size());
+    bool remove = false;
+    lk.lock();
+    reading_ = false;
+    if (!read) {
+      status_ = std::move(read).status();
+      done_ = true;
+    } else {
+      data_.append(block_.data(), read->bytes_received);
+      for (auto const& kv : read->response.headers) {
+        headers_.emplace_back(kv.first, kv.second);
+      }
+      if (read->response.status_code != 100) {
+        status_code_ = read->response.status_code;
+        payload_ = std::move(read->response.payload);
+        done_ = true;
+      }
+    }
+    if (joinable_ && (done_ || data_.size() > registry_->max_shared_bytes())) {
+      // Readers joining now would miss the data already released, or would
+      // find the download completed.
+      joinable_ = false;
+      remove = true;
+    }
+    lk.unlock();
+    cv_.notify_all();
+    if (remove) {
+      registry_->Remove(key_, this);
+    }
+    lk.lock();
+  }
+}
+
+void SharedDownload::Trim() {
+  if (joinable_ || data_.empty()) {
+    return;
+  }
+  auto const end = data_offset_ + data_.size();
+  auto min_offset = end;
+  for (auto const& kv : readers_) {
+    min_offset = (std::min)(min_offset, kv.second);
+  }
+  // Do not let a slow reader hold more than `max_shared_bytes()` in memory,
+  // it detaches from the download on its next `Read()`.
+  auto const max_shared_bytes = registry_->max_shared_bytes();
+  if (end - min_offset > max_shared_bytes) {
+    min_offset = end - max_shared_bytes;
+  }
+  auto const consumed = static_cast<std::size_t>(min_offset - data_offset_);
+  // Avoid moving the data for small gains.
+  if (consumed == data_.size() || consumed >= data_.size() / 2) {
+    data_.erase(0, consumed);
+    data_offset_ = min_offset;
+  }
+}
+
+/**
+ * The `ObjectReadSource` returned for each (maybe coalesced) download.
+ *
+ * If the reader falls too far behind the shared download it continues with
+ * its own download, starting at the first byte it has not received yet.
+ */
+class CoalescedReadSource : public ObjectReadSource {
+ public:
+  CoalescedReadSource(std::shared_ptr<SharedDownload> download, std::size_t id,
+                      std::shared_ptr<RawClient> client,
+                      ReadObjectRangeRequest request)
+      : download_(std::move(download)),
+        id_(id),
+        client_(std::move(client)),
+        request_(std::move(request)) {}
+  ~CoalescedReadSource() override { download_->Leave(id_); }
+
+  bool IsOpen() const override {
+    if (detached_source_) {
+      return detached_source_->IsOpen();
+    }
+    return download_->IsOpen(id_);
+  }
+  StatusOr<HttpResponse> Close() override {
+    if (detached_source_) {
+      return detached_source_->Close();
+    }
+    return download_->Close(id_);
+  }
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override;
+
+ private:
+  StatusOr<ReadSourceResult> ReadDetached(char* buf, std::size_t n);
+
+  std::shared_ptr<SharedDownload> download_;
+  std::size_t id_;
+  std::shared_ptr<RawClient> client_;
+  ReadObjectRangeRequest request_;
+  std::size_t headers_seen_ = 0;
+  std::uint64_t offset_ = 0;
+  std::string generation_;
+  bool detached_ = false;
+  std::unique_ptr<ObjectReadSource> detached_source_;
+};
+
+StatusOr<ReadSourceResult> CoalescedReadSource::Read(char* buf,
+                                                     std::size_t n) {
+  if (detached_) {
+    return ReadDetached(buf, n);
+  }
+  auto result = download_->Read(id_, headers_seen_, buf, n, detached_);
+  if (detached_) {
+    return ReadDetached(buf, n);
+  }
+  if (result) {
+    offset_ += result->bytes_received;
+    auto g = result->response.headers.find("x-goog-generation");
+    if (g != result->response.headers.end()) {
+      generation_ = g->second;
+    }
+  }
+  return result;
+}
+
+StatusOr<ReadSourceResult> CoalescedReadSource::ReadDetached(char* buf,
+                                                             std::size_t n) {
+  if (!detached_source_) {
+    // Continue from the first byte not received, and pin the generation, so
+    // the data is not mixed with a newer version of the object.
+    ReadObjectRangeRequest request = request_;
+    request.set_option(ReadFromOffset(
+        request_.StartingByte() + static_cast<std::int64_t>(offset_)));
+    char* end = nullptr;
+    auto generation = std::strtoll(generation_.c_str(), &end, 10);
+    if (!request.HasOption<Generation>() && !generation_.empty() &&
+        *end == '\0') {
+      request.set_option(Generation(generation));
+    }
+    auto source = client_->ReadObject(request);
+    if (!source) {
+      return std::move(source).status();
+    }
+    detached_source_ = *std::move(source);
+  }
+  return detached_source_->Read(buf, n);
+}
+}  // namespace
+
+CoalescingClient::CoalescingClient(std::shared_ptr<RawClient> client,
+                                   std::size_t max_shared_bytes)
+    : client_(std::move(client)),
+      registry_(std::make_shared<CoalescedReadRegistry>(max_shared_bytes)) {}
+
+std::uint64_t CoalescingClient::coalesced_count() const {
+  std::lock_guard<std::mutex> lk(registry_->mu_);
+  return registry_->coalesced_count_;
+}
+
+ClientOptions const& CoalescingClient::client_options() const {
+  return client_->client_options();
+}
+
+StatusOr<ListBucketsResponse> CoalescingClient::ListBuckets(
+    ListBucketsRequest const& request) {
+  return client_->ListBuckets(request);
+}
+
+StatusOr<BucketMetadata> CoalescingClient::CreateBucket(
+    CreateBucketRequest const& request) {
+  return client_->CreateBucket(request);
+}
+
+StatusOr<BucketMetadata> CoalescingClient::GetBucketMetadata(
+    GetBucketMetadataRequest const& request) {
+  return client_->GetBucketMetadata(request);
+}
+
+StatusOr<EmptyResponse> CoalescingClient::DeleteBucket(
+    DeleteBucketRequest const& request) {
+  return client_->DeleteBucket(request);
+}
+
+StatusOr<BucketMetadata> CoalescingClient::UpdateBucket(
+    UpdateBucketRequest const& request) {
+  return client_->UpdateBucket(request);
+}
+
+StatusOr<BucketMetadata> CoalescingClient::PatchBucket(
+    PatchBucketRequest const& request) {
+  return client_->PatchBucket(request);
+}
+
+StatusOr<IamPolicy> CoalescingClient::GetBucketIamPolicy(
+    GetBucketIamPolicyRequest const& request) {
+  return client_->GetBucketIamPolicy(request);
+}
+
+StatusOr<IamPolicy> CoalescingClient::SetBucketIamPolicy(
+    SetBucketIamPolicyRequest const& request) {
+  return client_->SetBucketIamPolicy(request);
+}
+
+StatusOr<TestBucketIamPermissionsResponse>
+CoalescingClient::TestBucketIamPermissions(
+    TestBucketIamPermissionsRequest const& request) {
+  return client_->TestBucketIamPermissions(request);
+}
+
+StatusOr<BucketMetadata> CoalescingClient::LockBucketRetentionPolicy(
+    LockBucketRetentionPolicyRequest const& request) {
+  return client_->LockBucketRetentionPolicy(request);
+}
+
+StatusOr<ObjectMetadata> CoalescingClient::InsertObjectMedia(
+    InsertObjectMediaRequest const& request) {
+  return client_->InsertObjectMedia(request);
+}
+
+StatusOr<ObjectMetadata> CoalescingClient::CopyObject(
+    CopyObjectRequest const& request) {
+  return client_->CopyObject(request);
+}
+
+StatusOr<ObjectMetadata> CoalescingClient::GetObjectMetadata(
+    GetObjectMetadataRequest const& request) {
+  return client_->GetObjectMetadata(request);
+}
+
+StatusOr<std::unique_ptr<ObjectReadSource>> CoalescingClient::ReadObject(
+    ReadObjectRangeRequest const& request) {
+  // The key includes all the options, only identical requests are coalesced.
+  std::ostringstream os;
+  os << request;
+  auto key = std::move(os).str();
+
+  // Declared before the lock: if this is the last reference the destructor
+  // needs the registry mutex.
+  std::shared_ptr<SharedDownload> existing;
+  std::unique_lock<std::mutex> lk(registry_->mu_);
+  auto i = registry_->downloads_.find(key);
+  if (i != registry_->downloads_.end()) {
+    existing = i->second.second.lock();
+    std::size_t id;
+    if (existing && existing->Join(&id)) {
+      ++registry_->coalesced_count_;
+      lk.unlock();
+      std::unique_ptr<ObjectReadSource> source(
+          new CoalescedReadSource(existing, id, client_, request));
+      auto status = existing->WaitOpened();
+      if (!status.ok()) {
+        return status;
+      }
+      return source;
+    }
+  }
+  auto download = std::make_shared<SharedDownload>(registry_, key);
+  std::size_t id;
+  download->Join(&id);
+  registry_->downloads_[key] = std::make_pair(
+      download.get(), std::weak_ptr<SharedDownload>(download));
+  lk.unlock();
+
+  std::unique_ptr<ObjectReadSource> source(
+      new CoalescedReadSource(download, id, client_, request));
+  auto child = client_->ReadObject(request);
+  auto status = child.status();
+  download->Opened(std::move(child));
+  if (!status.ok()) {
+    return status;
+  }
+  return source;
+}
+
+StatusOr<ListObjectsResponse> CoalescingClient::ListObjects(
+    ListObjectsRequest const& request) {
+  return client_->ListObjects(request);
+}
+
+StatusOr<ListObjectSummariesResponse> CoalescingClient::ListObjectSummaries(
+    ListObjectsRequest const& request) {
+  return client_->ListObjectSummaries(request);
+}
+
+StatusOr<EmptyResponse> CoalescingClient::DeleteObject(
+    DeleteObjectRequest const& request) {
+  return client_->DeleteObject(request);
+}
+
+StatusOr<ObjectMetadata> CoalescingClient::UpdateObject(
+    UpdateObjectRequest const& request) {
+  return client_->UpdateObject(request);
+}
+
+StatusOr<ObjectMetadata> CoalescingClient::PatchObject(
+    PatchObjectRequest const& request) {
+  return client_->PatchObject(request);
+}
+
+StatusOr<ObjectMetadata> CoalescingClient::ComposeObject(
+    ComposeObjectRequest const& request) {
+  return client_->ComposeObject(request);
+}
+
+StatusOr<RewriteObjectResponse> CoalescingClient::RewriteObject(
+    RewriteObjectRequest const& request) {
+  return client_->RewriteObject(request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+CoalescingClient::CreateResumableSession(
+    ResumableUploadRequest const& request) {
+  return client_->CreateResumableSession(request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+CoalescingClient::RestoreResumableSession(std::string const& request) {
+  return client_->RestoreResumableSession(request);
+}
+
+StatusOr<ListBucketAclResponse> CoalescingClient::ListBucketAcl(
+    ListBucketAclRequest const& request) {
+  return client_->ListBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CoalescingClient::CreateBucketAcl(
+    CreateBucketAclRequest const& request) {
+  return client_->CreateBucketAcl(request);
+}
+
+StatusOr<EmptyResponse> CoalescingClient::DeleteBucketAcl(
+    DeleteBucketAclRequest const& request) {
+  return client_->DeleteBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CoalescingClient::GetBucketAcl(
+    GetBucketAclRequest const& request) {
+  return client_->GetBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CoalescingClient::UpdateBucketAcl(
+    UpdateBucketAclRequest const& request) {
+  return client_->UpdateBucketAcl(request);
+}
+
+StatusOr<BucketAccessControl> CoalescingClient::PatchBucketAcl(
+    PatchBucketAclRequest const& request) {
+  return client_->PatchBucketAcl(request);
+}
+
+StatusOr<ListObjectAclResponse> CoalescingClient::ListObjectAcl(
+    ListObjectAclRequest const& request) {
+  return client_->ListObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CoalescingClient::CreateObjectAcl(
+    CreateObjectAclRequest const& request) {
+  return client_->CreateObjectAcl(request);
+}
+
+StatusOr<EmptyResponse> CoalescingClient::DeleteObjectAcl(
+    DeleteObjectAclRequest const& request) {
+  return client_->DeleteObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CoalescingClient::GetObjectAcl(
+    GetObjectAclRequest const& request) {
+  return client_->GetObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CoalescingClient::UpdateObjectAcl(
+    UpdateObjectAclRequest const& request) {
+  return client_->UpdateObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CoalescingClient::PatchObjectAcl(
+    PatchObjectAclRequest const& request) {
+  return client_->PatchObjectAcl(request);
+}
+
+StatusOr<ListDefaultObjectAclResponse> CoalescingClient::ListDefaultObjectAcl(
+    ListDefaultObjectAclRequest const& request) {
+  return client_->ListDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CoalescingClient::CreateDefaultObjectAcl(
+    CreateDefaultObjectAclRequest const& request) {
+  return client_->CreateDefaultObjectAcl(request);
+}
+
+StatusOr<EmptyResponse> CoalescingClient::DeleteDefaultObjectAcl(
+    DeleteDefaultObjectAclRequest const& request) {
+  return client_->DeleteDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CoalescingClient::GetDefaultObjectAcl(
+    GetDefaultObjectAclRequest const& request) {
+  return client_->GetDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CoalescingClient::UpdateDefaultObjectAcl(
+    UpdateDefaultObjectAclRequest const& request) {
+  return client_->UpdateDefaultObjectAcl(request);
+}
+
+StatusOr<ObjectAccessControl> CoalescingClient::PatchDefaultObjectAcl(
+    PatchDefaultObjectAclRequest const& request) {
+  return client_->PatchDefaultObjectAcl(request);
+}
+
+StatusOr<ServiceAccount> CoalescingClient::GetServiceAccount(
+    GetProjectServiceAccountRequest const& request) {
+  return client_->GetServiceAccount(request);
+}
+
+StatusOr<ListHmacKeysResponse> CoalescingClient::ListHmacKeys(
+    ListHmacKeysRequest const& request) {
+  return client_->ListHmacKeys(request);
+}
+
+StatusOr<CreateHmacKeyResponse> CoalescingClient::CreateHmacKey(
+    CreateHmacKeyRequest const& request) {
+  return client_->CreateHmacKey(request);
+}
+
+StatusOr<EmptyResponse> CoalescingClient::DeleteHmacKey(
+    DeleteHmacKeyRequest const& request) {
+  return client_->DeleteHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> CoalescingClient::GetHmacKey(
+    GetHmacKeyRequest const& request) {
+  return client_->GetHmacKey(request);
+}
+
+StatusOr<HmacKeyMetadata> CoalescingClient::UpdateHmacKey(
+    UpdateHmacKeyRequest const& request) {
+  return client_->UpdateHmacKey(request);
+}
+
+StatusOr<SignBlobResponse> CoalescingClient::SignBlob(
+    SignBlobRequest const& request) {
+  return client_->SignBlob(request);
+}
+
+StatusOr<ListNotificationsResponse> CoalescingClient::ListNotifications(
+    ListNotificationsRequest const& request) {
+  return client_->ListNotifications(request);
+}
+
+StatusOr<NotificationMetadata> CoalescingClient::CreateNotification(
+    CreateNotificationRequest const& request) {
+  return client_->CreateNotification(request);
+}
+
+StatusOr<NotificationMetadata> CoalescingClient::GetNotification(
+    GetNotificationRequest const& request) {
+  return client_->GetNotification(request);
+}
+
+StatusOr<EmptyResponse> CoalescingClient::DeleteNotification(
+    DeleteNotificationRequest const& request) {
+  return client_->DeleteNotification(request);
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,334 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/coalescing_client.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <atomic>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+std::string MakeContents(std::size_t size) {
+  std::string contents;
+  for (std::size_t i = 0; i != size; ++i) {
+    contents.push_back(static_cast<char>('a' + i % 26));
+  }
+  return contents;
+}
+
+/// Create a read source that returns @p contents in blocks of 64 bytes.
+std::unique_ptr<ObjectReadSource> MakeSource(std::string contents) {
+  auto source = google::cloud::internal::make_unique<
+      ::testing::NiceMock<testing::MockObjectReadSource>>();
+  auto remaining = std::make_shared<std::string>(std::move(contents));
+  auto first = std::make_shared<bool>(true);
+  ON_CALL(*source, Read(_, _))
+      .WillByDefault(Invoke([remaining, first](char* buf, std::size_t n) {
+        auto count = (std::min)(n, (std::min)(std::size_t(64),
+                                              remaining->size()));
+        remaining->copy(buf, count);
+        remaining->erase(0, count);
+        long code = remaining->empty() ? 200 : 100;
+        ReadSourceResult result{count, HttpResponse{code, "", {}}};
+        if (*first) {
+          result.response.headers.emplace("x-goog-generation", "1234");
+          *first = false;
+        }
+        return result;
+      }));
+  return std::unique_ptr<ObjectReadSource>(std::move(source));
+}
+
+struct ReadResult {
+  std::string data;
+  std::multimap<std::string, std::string> headers;
+  long status_code = 0;
+};
+
+/// Read one block from @p source, accumulating the results in @p result.
+bool ReadBlock(ObjectReadSource& source, ReadResult& result) {
+  char buffer[40];
+  auto r = source.Read(buffer, sizeof(buffer));
+  EXPECT_STATUS_OK(r);
+  if (!r) {
+    return false;
+  }
+  result.data.append(buffer, r->bytes_received);
+  result.headers.insert(r->response.headers.begin(),
+                        r->response.headers.end());
+  result.status_code = r->response.status_code;
+  return r->response.status_code == 100;
+}
+
+ReadResult ReadAll(ObjectReadSource& source) {
+  ReadResult result;
+  while (ReadBlock(source, result)) {
+  }
+  return result;
+}
+
+class CoalescingClientTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mock_ = std::make_shared<testing::MockClient>();
+    EXPECT_CALL(*mock_, client_options())
+        .WillRepeatedly(ReturnRef(client_options_));
+  }
+
+  std::shared_ptr<testing::MockClient> mock_;
+  ClientOptions client_options_ =
+      ClientOptions(oauth2::CreateAnonymousCredentials());
+};
+
+TEST_F(CoalescingClientTest, IdenticalReadsShareDownload) {
+  auto const contents = MakeContents(1000);
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([&contents](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource(contents));
+      }));
+
+  CoalescingClient client(mock_);
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_multiple_options(Generation(1234));
+  auto s1 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s1);
+  auto s2 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s2);
+  EXPECT_EQ(1U, client.coalesced_count());
+
+  // Interleave the reads, each reader sees all the data and headers.
+  ReadResult r1;
+  ReadResult r2;
+  bool more1 = true;
+  bool more2 = true;
+  while (more1 || more2) {
+    // The second reader consumes the data faster than the first.
+    if (more1) {
+      more1 = ReadBlock(**s1, r1);
+    }
+    for (int i = 0; i != 2 && more2; ++i) {
+      more2 = ReadBlock(**s2, r2);
+    }
+  }
+  EXPECT_EQ(contents, r1.data);
+  EXPECT_EQ(contents, r2.data);
+  EXPECT_EQ(200, r1.status_code);
+  EXPECT_EQ(200, r2.status_code);
+  EXPECT_EQ(1U, r1.headers.count("x-goog-generation"));
+  EXPECT_EQ(1U, r2.headers.count("x-goog-generation"));
+  EXPECT_FALSE((*s1)->IsOpen());
+}
+
+TEST_F(CoalescingClientTest, DifferentRequestsDoNotShare) {
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([](ReadObjectRangeRequest const& r) {
+        return make_status_or(MakeSource(r.object_name()));
+      }));
+
+  CoalescingClient client(mock_);
+  ReadObjectRangeRequest r1("test-bucket", "test-object");
+  r1.set_multiple_options(Generation(1));
+  ReadObjectRangeRequest r2("test-bucket", "test-object");
+  r2.set_multiple_options(Generation(2));
+  ReadObjectRangeRequest r3("test-bucket", "test-object");
+  r3.set_multiple_options(Generation(1), ReadRange(0, 4));
+  auto s1 = client.ReadObject(r1);
+  auto s2 = client.ReadObject(r2);
+  auto s3 = client.ReadObject(r3);
+  ASSERT_STATUS_OK(s1);
+  ASSERT_STATUS_OK(s2);
+  ASSERT_STATUS_OK(s3);
+  EXPECT_EQ(0U, client.coalesced_count());
+}
+
+TEST_F(CoalescingClientTest, CompletedDownloadIsNotShared) {
+  auto const contents = MakeContents(100);
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&contents](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource(contents));
+      }));
+
+  CoalescingClient client(mock_);
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  auto s1 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s1);
+  EXPECT_EQ(contents, ReadAll(**s1).data);
+  auto s2 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s2);
+  EXPECT_EQ(contents, ReadAll(**s2).data);
+  EXPECT_EQ(0U, client.coalesced_count());
+}
+
+TEST_F(CoalescingClientTest, LargeDownloadStopsSharing) {
+  auto const contents = MakeContents(1000);
+  // The second reader falls behind and continues with its own download.
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&contents](ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource(contents));
+      }));
+
+  CoalescingClient client(mock_, 100);
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  auto s1 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s1);
+  auto s2 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s2);
+  EXPECT_EQ(1U, client.coalesced_count());
+
+  // After reading more than 100 bytes the download can no longer be joined.
+  ReadResult r1;
+  for (int i = 0; i != 4; ++i) {
+    ReadBlock(**s1, r1);
+  }
+  auto s3 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s3);
+  EXPECT_EQ(1U, client.coalesced_count());
+
+  EXPECT_EQ(contents.substr(160), ReadAll(**s1).data);
+  EXPECT_EQ(contents, ReadAll(**s2).data);
+  EXPECT_EQ(contents, ReadAll(**s3).data);
+}
+
+TEST_F(CoalescingClientTest, SlowReaderIsDetached) {
+  auto const contents = MakeContents(1000);
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([&contents](ReadObjectRangeRequest const& r) {
+        EXPECT_FALSE(r.HasOption<ReadFromOffset>());
+        return make_status_or(MakeSource(contents));
+      }))
+      .WillOnce(Invoke([&contents](ReadObjectRangeRequest const& r) {
+        // The detached reader continues where it left, from the same
+        // generation.
+        EXPECT_TRUE(r.HasOption<ReadFromOffset>());
+        EXPECT_EQ(40, r.GetOption<ReadFromOffset>().value());
+        EXPECT_TRUE(r.HasOption<Generation>());
+        EXPECT_EQ(1234, r.GetOption<Generation>().value());
+        return make_status_or(MakeSource(contents.substr(40)));
+      }));
+
+  CoalescingClient client(mock_, 100);
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  auto s1 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s1);
+  auto s2 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s2);
+  EXPECT_EQ(1U, client.coalesced_count());
+
+  // The second reader reads one block and then stops advancing, the first
+  // reader is not blocked by it.
+  ReadResult r2;
+  ASSERT_TRUE(ReadBlock(**s2, r2));
+  EXPECT_EQ(contents, ReadAll(**s1).data);
+
+  auto rest = ReadAll(**s2);
+  EXPECT_EQ(contents, r2.data + rest.data);
+  EXPECT_EQ(200, rest.status_code);
+}
+
+TEST_F(CoalescingClientTest, ReadError) {
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([](ReadObjectRangeRequest const&) {
+        auto source = google::cloud::internal::make_unique<
+            ::testing::NiceMock<testing::MockObjectReadSource>>();
+        EXPECT_CALL(*source, Read(_, _))
+            .WillOnce(Return(StatusOr<ReadSourceResult>(PermanentError())));
+        return make_status_or(
+            std::unique_ptr<ObjectReadSource>(std::move(source)));
+      }));
+
+  CoalescingClient client(mock_);
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  auto s1 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s1);
+  auto s2 = client.ReadObject(request);
+  ASSERT_STATUS_OK(s2);
+  char buffer[16];
+  auto r1 = (*s1)->Read(buffer, sizeof(buffer));
+  EXPECT_EQ(PermanentError().code(), r1.status().code());
+  auto r2 = (*s2)->Read(buffer, sizeof(buffer));
+  EXPECT_EQ(PermanentError().code(), r2.status().code());
+}
+
+TEST_F(CoalescingClientTest, OpenError) {
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([](ReadObjectRangeRequest const&) {
+        return StatusOr<std::unique_ptr<ObjectReadSource>>(PermanentError());
+      }));
+
+  CoalescingClient client(mock_);
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  auto s1 = client.ReadObject(request);
+  EXPECT_EQ(PermanentError().code(), s1.status().code());
+  // The failed download is not shared, the next call starts a new one.
+  auto s2 = client.ReadObject(request);
+  EXPECT_EQ(PermanentError().code(), s2.status().code());
+}
+
+TEST_F(CoalescingClientTest, ConcurrentReaders) {
+  auto const contents = MakeContents(64 * 1024);
+  std::atomic<int> download_count(0);
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillRepeatedly(Invoke([&](ReadObjectRangeRequest const&) {
+        ++download_count;
+        return make_status_or(MakeSource(contents));
+      }));
+
+  CoalescingClient client(mock_);
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  int const thread_count = 8;
+  std::vector<std::string> results(thread_count);
+  std::vector<std::thread> threads;
+  for (int i = 0; i != thread_count; ++i) {
+    threads.emplace_back([&, i] {
+      auto source = client.ReadObject(request);
+      ASSERT_STATUS_OK(source);
+      results[i] = ReadAll(**source).data;
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto const& r : results) {
+    EXPECT_EQ(contents, r);
+  }
+  EXPECT_EQ(thread_count,
+            download_count.load() + static_cast<int>(client.coalesced_count()));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -15,13 +15,18 @@
 #include "google/cloud/storage/internal/curl_client.h"
 #include "google/cloud/internal/getenv.h"
 #include "google/cloud/internal/make_unique.h"
+#include "google/cloud/log.h"
 #include "google/cloud/storage/internal/curl_request_builder.h"
 #include "google/cloud/storage/internal/curl_resumable_upload_session.h"
 #include "google/cloud/storage/internal/generate_message_boundary.h"
+#include "google/cloud/storage/internal/json_writer.h"
 #include "google/cloud/storage/internal/object_streambuf.h"
 #include "google/cloud/storage/object_stream.h"
 #include "google/cloud/storage/version.h"
 #include "google/cloud/terminate_handler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <sstream>
 
 namespace google {
@@ -49,7 +54,7 @@ std::shared_ptr<CurlHandleFactory> CreateHandleFactory(
     return std::make_shared<DefaultCurlHandleFactory>();
   }
   return std::make_shared<PooledCurlHandleFactory>(
-      options.connection_pool_size());
+      options.connection_pool_size(), options.connection_pool_max_idle_time());
 }
 
 std::string XmlMapPredefinedAcl(std::string const& acl) {
@@ -69,8 +74,44 @@ std::string XmlMapPredefinedAcl(std::string const& acl) {
 }
 
 std::string UrlEscapeString(std::string const& value) {
-  CurlHandle handle;
-  return std::string(handle.MakeEscapedString(value).get());
+  std::string result;
+  AppendUrlEscaped(result, value);
+  return result;
+}
+
+// Leave room for a few query parameters, `CurlRequestBuilder` appends them to
+// the URL.
+std::size_t constexpr kUrlQueryReserve = 64;
+
+/// Returns `<prefix><bucket_name><suffix>` using a single allocation.
+std::string BucketUrl(std::string const& prefix,
+                      std::string const& bucket_name, char const* suffix = "") {
+  auto const suffix_size = std::strlen(suffix);
+  std::string url;
+  url.reserve(prefix.size() + bucket_name.size() + suffix_size +
+              kUrlQueryReserve);
+  url.append(prefix).append(bucket_name).append(suffix, suffix_size);
+  return url;
+}
+
+/**
+ * Returns `<prefix><bucket_name><separator><object_name><suffix>`.
+ *
+ * The object name is URL-escaped directly into the result, the URL is built
+ * with a single allocation unless the name needs many escapes.
+ */
+std::string ObjectUrl(std::string const& prefix,
+                      std::string const& bucket_name, char const* separator,
+                      std::string const& object_name, char const* suffix = "") {
+  auto const separator_size = std::strlen(separator);
+  auto const suffix_size = std::strlen(suffix);
+  std::string url;
+  url.reserve(prefix.size() + bucket_name.size() + separator_size +
+              object_name.size() + suffix_size + kUrlQueryReserve);
+  url.append(prefix).append(bucket_name).append(separator, separator_size);
+  AppendUrlEscaped(url, object_name);
+  url.append(suffix, suffix_size);
+  return url;
 }
 
 template <typename ReturnType>
@@ -106,6 +147,20 @@ StatusOr<EmptyResponse> ReturnEmptyResponse(StatusOr<HttpResponse> response) {
   return EmptyResponse{};
 }
 
+/// Creates the payload for the `*AccessControls: insert` and `update` APIs.
+std::string AccessControlPayload(std::string const& entity,
+                                 std::string const& role) {
+  std::string payload;
+  JsonWriter(payload)
+      .StartObject()
+      .Key("entity")
+      .Value(entity)
+      .Key("role")
+      .Value(role)
+      .EndObject();
+  return payload;
+}
+
 template <typename ReturnType>
 StatusOr<ReturnType> ParseFromHttpResponse(StatusOr<HttpResponse> response) {
   if (!response.ok()) {
@@ -119,21 +174,53 @@ StatusOr<ReturnType> ParseFromHttpResponse(StatusOr<HttpResponse> response) {
 
 }  // namespace
 
+std::shared_ptr<curl_slist> CurlClient::CommonHeaders(
+    std::string const& authorization_header) {
+  // This header is the same for all requests, compute it only once.
+  static std::string const kApiClientHeader =
+      "x-goog-api-client: " + x_goog_api_client();
+  std::lock_guard<std::mutex> lk(headers_mu_);
+  if (!common_headers_ || authorization_header != common_headers_auth_) {
+    // The requests using the previous list keep it alive until they finish.
+    common_headers_ =
+        MakeSharedCurlHeaders({authorization_header, kApiClientHeader});
+    common_headers_auth_ = authorization_header;
+  }
+  return common_headers_;
+}
+
 Status CurlClient::SetupBuilderCommon(CurlRequestBuilder& builder,
                                       char const* method) {
   auto auth_header = AuthorizationHeader(options_.credentials());
   if (!auth_header.ok()) {
     return std::move(auth_header).status();
   }
+  if (http_sampler_) {
+    builder.SetTracingSampler(http_sampler_);
+  }
+  SetupBuilderConnection(builder);
   builder.SetMethod(method)
-      .SetDebugLogging(options_.enable_http_tracing())
-      .SetCurlShare(share_.get())
-      .AddUserAgentPrefix(options_.user_agent_prefix())
-      .AddHeader(auth_header.value())
-      .AddHeader("x-goog-api-client: " + x_goog_api_client());
+      .SetMultiplexer(multiplexer_)
+      .SetTransferMetricsHook(options_.transfer_metrics_hook())
+      .SetRateLimiters(limiters_)
+      .SetBufferPool(options_.buffer_pool())
+      .SetCommonHeaders(CommonHeaders(*auth_header));
   return Status();
 }
 
+void CurlClient::SetupBuilderConnection(CurlRequestBuilder& builder) {
+  builder.SetCurlShare(share_.get())
+      .SetTcpKeepAlive(options_.tcp_keepalive_idle_time())
+      .SetDownloadTuning(options_.download_tuning())
+      .SetMaximumConnections(options_.connection_pool_size())
+      .AddUserAgentPrefix(options_.user_agent_prefix());
+}
+
+void CurlClient::SetupBuilderUpload(CurlRequestBuilder& builder) {
+  builder.SetCurlShare(upload_share_.get())
+      .SetUploadTuning(options_.upload_tuning());
+}
+
 template <typename Request>
 void SetupBuilderUserIp(CurlRequestBuilder& builder, Request const& request) {
   if (request.template HasOption<UserIp>()) {
@@ -171,11 +258,13 @@ CurlClient::CreateResumableSessionGeneric(RequestType const& request) {
   }
 
   CurlRequestBuilder builder(
-      upload_endpoint_ + "/b/" + request.bucket_name() + "/o", upload_factory_);
+      BucketUrl(upload_bucket_url_prefix_, request.bucket_name(), "/o"),
+      upload_factory_);
   auto status = SetupBuilderCommon(builder, "POST");
   if (!status.ok()) {
     return status;
   }
+  SetupBuilderUpload(builder);
 
   // In most cases we use `SetupBuilder()` to setup all these options in the
   // request. But in this case we cannot because that might also set
@@ -201,35 +290,41 @@ CurlClient::CreateResumableSessionGeneric(RequestType const& request) {
 
   builder.AddQueryParameter("uploadType", "resumable");
   builder.AddHeader("Content-Type: application/json; charset=UTF-8");
-  nl::json resource;
-  if (request.template HasOption<WithObjectMetadata>()) {
-    resource = ObjectMetadataJsonForInsert(
-        request.template GetOption<WithObjectMetadata>().value());
-  }
+  ObjectMetadataOverrides overrides;
   if (request.template HasOption<ContentEncoding>()) {
-    resource["contentEncoding"] =
+    overrides.content_encoding =
         request.template GetOption<ContentEncoding>().value();
   }
   if (request.template HasOption<ContentType>()) {
-    resource["contentType"] = request.template GetOption<ContentType>().value();
+    overrides.content_type = request.template GetOption<ContentType>().value();
   }
   if (request.template HasOption<Crc32cChecksumValue>()) {
-    resource["crc32c"] =
+    overrides.crc32c =
         request.template GetOption<Crc32cChecksumValue>().value();
   }
   if (request.template HasOption<MD5HashValue>()) {
-    resource["md5Hash"] = request.template GetOption<MD5HashValue>().value();
-  }
-
-  if (resource.empty()) {
-    builder.AddQueryParameter("name", request.object_name());
-  } else {
-    resource["name"] = request.object_name();
+    overrides.md5_hash = request.template GetOption<MD5HashValue>().value();
   }
 
   std::string request_payload;
-  if (!resource.empty()) {
-    request_payload = resource.dump();
+  JsonWriter writer(request_payload);
+  writer.StartObject();
+  auto const has_fields =
+      request.template HasOption<WithObjectMetadata>()
+          ? WriteObjectMetadataFieldsForInsert(
+                writer,
+                request.template GetOption<WithObjectMetadata>().value(),
+                overrides)
+          : WriteObjectMetadataFieldsForInsert(writer, ObjectMetadata(),
+                                               overrides);
+  if (has_fields) {
+    writer.Key("name").Value(request.object_name());
+    writer.EndObject();
+  } else {
+    // Without any metadata the name is sent as a query parameter, and the
+    // payload is empty.
+    request_payload.clear();
+    builder.AddQueryParameter("name", request.object_name());
   }
   builder.AddHeader("Content-Length: " +
                     std::to_string(request_payload.size()));
@@ -258,11 +353,16 @@ CurlClient::CreateResumableSessionGeneric(RequestType const& request) {
 CurlClient::CurlClient(ClientOptions options)
     : options_(std::move(options)),
       share_(curl_share_init(), &curl_share_cleanup),
+      upload_share_(curl_share_init(), &curl_share_cleanup),
       generator_(google::cloud::internal::MakeDefaultPRNG()),
       storage_factory_(CreateHandleFactory(options_)),
       upload_factory_(CreateHandleFactory(options_)),
       xml_upload_factory_(CreateHandleFactory(options_)),
       xml_download_factory_(CreateHandleFactory(options_)) {
+  if (options_.enable_http_tracing()) {
+    http_sampler_ =
+        std::make_shared<TracingSampler>(options_.tracing_sampling());
+  }
   storage_endpoint_ = options_.endpoint() + "/storage/" + options_.version();
   upload_endpoint_ =
       options_.endpoint() + "/upload/storage/" + options_.version();
@@ -278,16 +378,146 @@ CurlClient::CurlClient(ClientOptions options)
     xml_upload_endpoint_ = "https://storage-upload.googleapis.com";
     xml_download_endpoint_ = "https://storage-download.googleapis.com";
   }
+  bucket_url_prefix_ = storage_endpoint_ + "/b/";
+  upload_bucket_url_prefix_ = upload_endpoint_ + "/b/";
+  xml_upload_url_prefix_ = xml_upload_endpoint_ + "/";
+  xml_download_url_prefix_ = xml_download_endpoint_ + "/";
 
-  curl_share_setopt(share_.get(), CURLSHOPT_LOCKFUNC, CurlShareLockCallback);
-  curl_share_setopt(share_.get(), CURLSHOPT_UNLOCKFUNC,
-                    CurlShareUnlockCallback);
-  curl_share_setopt(share_.get(), CURLSHOPT_USERDATA, this);
-  curl_share_setopt(share_.get(), CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
-  curl_share_setopt(share_.get(), CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
-  curl_share_setopt(share_.get(), CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  for (auto* share : {share_.get(), upload_share_.get()}) {
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, CurlShareLockCallback);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, CurlShareUnlockCallback);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  }
 
   CurlInitializeOnce(options);
+
+  if (options_.enable_http2()) {
+    auto const* info = curl_version_info(CURLVERSION_NOW);
+    if ((info->features & CURL_VERSION_HTTP2) == 0 ||
+        info->version_num < 0x073100) {
+      GCP_LOG(WARNING) << "HTTP/2 is not supported by libcurl ("
+                       << info->version << "), using HTTP/1.1";
+    } else {
+      multiplexer_ = std::make_shared<CurlMultiplexer>(
+          options_.maximum_http2_connections());
+    }
+  }
+
+  auto make_limiter = [](double rate) -> std::shared_ptr<TokenBucket> {
+    if (rate <= 0) {
+      return nullptr;
+    }
+    // Allow bursts of about 100ms, short enough to smooth the traffic, but
+    // always at least one token so a single request can proceed.
+    return std::make_shared<TokenBucket>(rate, (std::max)(rate / 10, 1.0));
+  };
+  limiters_.requests = make_limiter(options_.maximum_request_rate());
+  limiters_.upload_bytes = make_limiter(
+      static_cast<double>(options_.maximum_upload_bandwidth()));
+  limiters_.download_bytes = make_limiter(
+      static_cast<double>(options_.maximum_download_bandwidth()));
+  if (!multiplexer_ && (limiters_.upload_bytes || limiters_.download_bytes)) {
+    // Throttled requests pause in their callbacks, the multiplexer resumes
+    // them once the limiters have tokens. The request rate limit does not
+    // need it, requests wait for a token in the calling thread before they
+    // start.
+    multiplexer_ = std::make_shared<CurlMultiplexer>(0, false);
+  }
+
+  if (options_.connection_pool_size() != 0 &&
+      options_.connection_pool_prewarm_size() != 0) {
+    auto const count = (std::min)(options_.connection_pool_size(),
+                                  options_.connection_pool_prewarm_size());
+    prewarm_thread_ = std::thread([this, count] { PrewarmConnections(count); });
+  }
+}
+
+CurlClient::~CurlClient() {
+  if (prewarm_thread_.joinable()) {
+    prewarm_cancelled_.store(true);
+    prewarm_thread_.join();
+  }
+}
+
+void CurlClient::PrewarmConnections(std::size_t count) {
+  // Each concurrent transfer in a multi handle needs its own connection. Once
+  // the transfers complete the connections are returned to the connection
+  // cache in `share_`, or `upload_share_`, where other requests can use them.
+  // The transfers are `HEAD` requests to the endpoints, the response does not
+  // matter, only the connection (and the TLS session) are kept. The
+  // connections are spread over all the factories, and their endpoints, so
+  // each factory has handles ready for its first requests.
+  struct Target {
+    std::shared_ptr<CurlHandleFactory> factory;
+    std::string url;
+    bool upload;
+  };
+  std::vector<Target> const targets{
+      {storage_factory_, options_.endpoint() + "/", false},
+      {xml_download_factory_, xml_download_endpoint_ + "/", false},
+      {upload_factory_, options_.endpoint() + "/", true},
+      {xml_upload_factory_, xml_upload_endpoint_ + "/", true},
+  };
+
+  auto multi = storage_factory_->CreateMultiHandle();
+  (void)curl_multi_setopt(multi.get(), CURLMOPT_MAXCONNECTS,
+                          static_cast<long>(options_.connection_pool_size()));
+  std::vector<std::pair<CurlHandleFactory*, CurlHandle>> handles;
+  handles.reserve(count);
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+  // This runs in a background thread, errors configuring the handles must not
+  // terminate the application.
+  try {
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+    for (std::size_t i = 0; i != count; ++i) {
+      auto const& target = targets[i % targets.size()];
+      CurlRequestBuilder builder(target.url, target.factory);
+      SetupBuilderConnection(builder);
+      if (target.upload) {
+        SetupBuilderUpload(builder);
+      }
+      auto handle = builder.BuildPrewarmHandle();
+      if (curl_multi_add_handle(multi.get(), handle.handle_.get()) !=
+          CURLM_OK) {
+        target.factory->CleanupHandle(std::move(handle.handle_));
+        break;
+      }
+      handles.emplace_back(target.factory.get(), std::move(handle));
+    }
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+  } catch (std::exception const& ex) {
+    GCP_LOG(WARNING) << "Cannot pre-warm connections to "
+                     << options_.endpoint() << ": " << ex.what();
+  }
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+
+  // Pre-warming is best effort, give up after a few seconds.
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  int running = static_cast<int>(handles.size());
+  while (running != 0 && !prewarm_cancelled_.load() &&
+         std::chrono::steady_clock::now() < deadline) {
+    if (curl_multi_perform(multi.get(), &running) != CURLM_OK) {
+      break;
+    }
+    if (running != 0) {
+      (void)curl_multi_wait(multi.get(), nullptr, 0, 100, nullptr);
+    }
+  }
+  if (running != 0) {
+    GCP_LOG(INFO) << "Pre-warming connections to " << options_.endpoint()
+                  << " did not complete, " << running << " of "
+                  << handles.size() << " still pending";
+  }
+
+  for (auto& h : handles) {
+    (void)curl_multi_remove_handle(multi.get(), h.second.handle_.get());
+    h.first->CleanupHandle(std::move(h.second.handle_));
+  }
+  storage_factory_->CleanupMultiHandle(std::move(multi));
 }
 
 StatusOr<ResumableUploadResponse> CurlClient::UploadChunk(
@@ -297,6 +527,7 @@ StatusOr<ResumableUploadResponse> CurlClient::UploadChunk(
   if (!status.ok()) {
     return status;
   }
+  SetupBuilderUpload(builder);
   builder.AddHeader(request.RangeHeader());
   builder.AddHeader("Content-Type: application/octet-stream");
   builder.AddHeader("Content-Length: " +
@@ -318,6 +549,7 @@ StatusOr<ResumableUploadResponse> CurlClient::QueryResumableUpload(
   if (!status.ok()) {
     return status;
   }
+  SetupBuilderUpload(builder);
   builder.AddHeader("Content-Range: bytes */*");
   builder.AddHeader("Content-Type: application/octet-stream");
   builder.AddHeader("Content-Length: 0");
@@ -360,8 +592,8 @@ StatusOr<BucketMetadata> CurlClient::CreateBucket(
 StatusOr<BucketMetadata> CurlClient::GetBucketMetadata(
     GetBucketMetadataRequest const& request) {
   // Assume the bucket name is validated by the caller.
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name(),
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      BucketUrl(bucket_url_prefix_, request.bucket_name()), storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
     return status;
@@ -373,8 +605,8 @@ StatusOr<BucketMetadata> CurlClient::GetBucketMetadata(
 StatusOr<EmptyResponse> CurlClient::DeleteBucket(
     DeleteBucketRequest const& request) {
   // Assume the bucket name is validated by the caller.
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name(),
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      BucketUrl(bucket_url_prefix_, request.bucket_name()), storage_factory_);
   auto status = SetupBuilder(builder, request, "DELETE");
   if (!status.ok()) {
     return status;
@@ -399,8 +631,8 @@ StatusOr<BucketMetadata> CurlClient::UpdateBucket(
 StatusOr<BucketMetadata> CurlClient::PatchBucket(
     PatchBucketRequest const& request) {
   // Assume the bucket name is validated by the caller.
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket(),
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      BucketUrl(bucket_url_prefix_, request.bucket()), storage_factory_);
   auto status = SetupBuilder(builder, request, "PATCH");
   if (!status.ok()) {
     return status;
@@ -413,7 +645,7 @@ StatusOr<BucketMetadata> CurlClient::PatchBucket(
 StatusOr<IamPolicy> CurlClient::GetBucketIamPolicy(
     GetBucketIamPolicyRequest const& request) {
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/iam",
+      BucketUrl(bucket_url_prefix_, request.bucket_name(), "/iam"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
@@ -432,7 +664,7 @@ StatusOr<IamPolicy> CurlClient::GetBucketIamPolicy(
 StatusOr<IamPolicy> CurlClient::SetBucketIamPolicy(
     SetBucketIamPolicyRequest const& request) {
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/iam",
+      BucketUrl(bucket_url_prefix_, request.bucket_name(), "/iam"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "PUT");
   if (!status.ok()) {
@@ -473,9 +705,10 @@ StatusOr<TestBucketIamPermissionsResponse> CurlClient::TestBucketIamPermissions(
 
 StatusOr<BucketMetadata> CurlClient::LockBucketRetentionPolicy(
     LockBucketRetentionPolicyRequest const& request) {
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
-                                 "/lockRetentionPolicy",
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      BucketUrl(bucket_url_prefix_, request.bucket_name(),
+                "/lockRetentionPolicy"),
+      storage_factory_);
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
     return status;
@@ -527,21 +760,24 @@ StatusOr<ObjectMetadata> CurlClient::CopyObject(
     return status;
   }
   builder.AddHeader("Content-Type: application/json");
-  std::string json_payload("{}");
+  std::string json_payload;
+  JsonWriter writer(json_payload);
+  writer.StartObject();
   if (request.HasOption<WithObjectMetadata>()) {
-    json_payload = ObjectMetadataJsonForCopy(
-                       request.GetOption<WithObjectMetadata>().value())
-                       .dump();
+    WriteObjectMetadataFieldsForCompose(
+        writer, request.GetOption<WithObjectMetadata>().value());
   }
+  writer.EndObject();
   return CheckedFromString<ObjectMetadataParser>(
       builder.BuildRequest().MakeRequest(json_payload));
 }
 
 StatusOr<ObjectMetadata> CurlClient::GetObjectMetadata(
     GetObjectMetadataRequest const& request) {
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
-                                 "/o/" + UrlEscapeString(request.object_name()),
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      ObjectUrl(bucket_url_prefix_, request.bucket_name(), "/o/",
+                request.object_name()),
+      storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
     return status;
@@ -558,9 +794,10 @@ StatusOr<std::unique_ptr<ObjectReadSource>> CurlClient::ReadObject(
     return ReadObjectXml(request);
   }
   // Assume the bucket name is validated by the caller.
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
-                                 "/o/" + UrlEscapeString(request.object_name()),
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      ObjectUrl(bucket_url_prefix_, request.bucket_name(), "/o/",
+                request.object_name()),
+      storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
     return status;
@@ -572,6 +809,12 @@ StatusOr<std::unique_ptr<ObjectReadSource>> CurlClient::ReadObject(
   if (request.RequiresNoCache()) {
     builder.AddHeader("Cache-Control: no-transform");
   }
+  if (request.RequiresGzipDecompression()) {
+    // Ask for the stored (compressed) bytes, the data is decompressed by
+    // ObjectReadStreambuf. Note that we do not use CURLOPT_ACCEPT_ENCODING,
+    // the hashes must be computed over the compressed data.
+    builder.AddHeader("Accept-Encoding: gzip");
+  }
 
   return std::unique_ptr<ObjectReadSource>(
       new CurlDownloadRequest(builder.BuildDownloadRequest(std::string{})));
@@ -581,7 +824,7 @@ StatusOr<ListObjectsResponse> CurlClient::ListObjects(
     ListObjectsRequest const& request) {
   // Assume the bucket name is validated by the caller.
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/o",
+      BucketUrl(bucket_url_prefix_, request.bucket_name(), "/o"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
@@ -592,12 +835,34 @@ StatusOr<ListObjectsResponse> CurlClient::ListObjects(
       builder.BuildRequest().MakeRequest(std::string{}));
 }
 
+StatusOr<ListObjectSummariesResponse> CurlClient::ListObjectSummaries(
+    ListObjectsRequest const& request) {
+  // Only request the fields in the summary, unless the application asked for
+  // something different.
+  ListObjectsRequest projected = request;
+  if (!projected.HasOption<Fields>()) {
+    projected.set_option(Fields(ListObjectSummariesResponse::kFields));
+  }
+  // Assume the bucket name is validated by the caller.
+  CurlRequestBuilder builder(
+      BucketUrl(bucket_url_prefix_, projected.bucket_name(), "/o"),
+      storage_factory_);
+  auto status = SetupBuilder(builder, projected, "GET");
+  if (!status.ok()) {
+    return status;
+  }
+  builder.AddQueryParameter("pageToken", projected.page_token());
+  return ParseFromHttpResponse<ListObjectSummariesResponse>(
+      builder.BuildRequest().MakeRequest(std::string{}));
+}
+
 StatusOr<EmptyResponse> CurlClient::DeleteObject(
     DeleteObjectRequest const& request) {
   // Assume the bucket name is validated by the caller.
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
-                                 "/o/" + UrlEscapeString(request.object_name()),
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      ObjectUrl(bucket_url_prefix_, request.bucket_name(), "/o/",
+                request.object_name()),
+      storage_factory_);
   auto status = SetupBuilder(builder, request, "DELETE");
   if (!status.ok()) {
     return status;
@@ -607,9 +872,10 @@ StatusOr<EmptyResponse> CurlClient::DeleteObject(
 
 StatusOr<ObjectMetadata> CurlClient::UpdateObject(
     UpdateObjectRequest const& request) {
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
-                                 "/o/" + UrlEscapeString(request.object_name()),
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      ObjectUrl(bucket_url_prefix_, request.bucket_name(), "/o/",
+                request.object_name()),
+      storage_factory_);
   auto status = SetupBuilder(builder, request, "PUT");
   if (!status.ok()) {
     return status;
@@ -621,9 +887,10 @@ StatusOr<ObjectMetadata> CurlClient::UpdateObject(
 
 StatusOr<ObjectMetadata> CurlClient::PatchObject(
     PatchObjectRequest const& request) {
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
-                                 "/o/" + UrlEscapeString(request.object_name()),
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      ObjectUrl(bucket_url_prefix_, request.bucket_name(), "/o/",
+                request.object_name()),
+      storage_factory_);
   auto status = SetupBuilder(builder, request, "PATCH");
   if (!status.ok()) {
     return status;
@@ -636,8 +903,8 @@ StatusOr<ObjectMetadata> CurlClient::PatchObject(
 StatusOr<ObjectMetadata> CurlClient::ComposeObject(
     ComposeObjectRequest const& request) {
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/o/" +
-          UrlEscapeString(request.object_name()) + "/compose",
+      ObjectUrl(bucket_url_prefix_, request.bucket_name(), "/o/",
+                request.object_name(), "/compose"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
@@ -664,12 +931,14 @@ StatusOr<RewriteObjectResponse> CurlClient::RewriteObject(
     builder.AddQueryParameter("rewriteToken", request.rewrite_token());
   }
   builder.AddHeader("Content-Type: application/json");
-  std::string json_payload("{}");
+  std::string json_payload;
+  JsonWriter writer(json_payload);
+  writer.StartObject();
   if (request.HasOption<WithObjectMetadata>()) {
-    json_payload = ObjectMetadataJsonForRewrite(
-                       request.GetOption<WithObjectMetadata>().value())
-                       .dump();
+    WriteObjectMetadataFieldsForCompose(
+        writer, request.GetOption<WithObjectMetadata>().value());
   }
+  writer.EndObject();
   auto response = builder.BuildRequest().MakeRequest(json_payload);
   if (!response.ok()) {
     return std::move(response).status();
@@ -702,7 +971,7 @@ CurlClient::RestoreResumableSession(std::string const& session_id) {
 StatusOr<ListBucketAclResponse> CurlClient::ListBucketAcl(
     ListBucketAclRequest const& request) {
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/acl",
+      BucketUrl(bucket_url_prefix_, request.bucket_name(), "/acl"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
@@ -734,18 +1003,16 @@ StatusOr<BucketAccessControl> CurlClient::GetBucketAcl(
 StatusOr<BucketAccessControl> CurlClient::CreateBucketAcl(
     CreateBucketAclRequest const& request) {
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/acl",
+      BucketUrl(bucket_url_prefix_, request.bucket_name(), "/acl"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
     return status;
   }
   builder.AddHeader("Content-Type: application/json");
-  nl::json object;
-  object["entity"] = request.entity();
-  object["role"] = request.role();
   return CheckedFromString<internal::BucketAccessControlParser>(
-      builder.BuildRequest().MakeRequest(object.dump()));
+      builder.BuildRequest().MakeRequest(
+          AccessControlPayload(request.entity(), request.role())));
 }
 
 StatusOr<EmptyResponse> CurlClient::DeleteBucketAcl(
@@ -770,11 +1037,9 @@ StatusOr<BucketAccessControl> CurlClient::UpdateBucketAcl(
     return status;
   }
   builder.AddHeader("Content-Type: application/json");
-  nl::json patch;
-  patch["entity"] = request.entity();
-  patch["role"] = request.role();
   return CheckedFromString<internal::BucketAccessControlParser>(
-      builder.BuildRequest().MakeRequest(patch.dump()));
+      builder.BuildRequest().MakeRequest(
+          AccessControlPayload(request.entity(), request.role())));
 }
 
 StatusOr<BucketAccessControl> CurlClient::PatchBucketAcl(
@@ -795,8 +1060,8 @@ StatusOr<ListObjectAclResponse> CurlClient::ListObjectAcl(
     ListObjectAclRequest const& request) {
   // Assume the bucket name is validated by the caller.
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/o/" +
-          UrlEscapeString(request.object_name()) + "/acl",
+      ObjectUrl(bucket_url_prefix_, request.bucket_name(), "/o/",
+                request.object_name(), "/acl"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
@@ -809,19 +1074,17 @@ StatusOr<ListObjectAclResponse> CurlClient::ListObjectAcl(
 StatusOr<ObjectAccessControl> CurlClient::CreateObjectAcl(
     CreateObjectAclRequest const& request) {
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/o/" +
-          UrlEscapeString(request.object_name()) + "/acl",
+      ObjectUrl(bucket_url_prefix_, request.bucket_name(), "/o/",
+                request.object_name(), "/acl"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
     return status;
   }
   builder.AddHeader("Content-Type: application/json");
-  nl::json object;
-  object["entity"] = request.entity();
-  object["role"] = request.role();
   return CheckedFromString<ObjectAccessControlParser>(
-      builder.BuildRequest().MakeRequest(object.dump()));
+      builder.BuildRequest().MakeRequest(
+          AccessControlPayload(request.entity(), request.role())));
 }
 
 StatusOr<EmptyResponse> CurlClient::DeleteObjectAcl(
@@ -865,11 +1128,9 @@ StatusOr<ObjectAccessControl> CurlClient::UpdateObjectAcl(
     return status;
   }
   builder.AddHeader("Content-Type: application/json");
-  nl::json object;
-  object["entity"] = request.entity();
-  object["role"] = request.role();
   return CheckedFromString<ObjectAccessControlParser>(
-      builder.BuildRequest().MakeRequest(object.dump()));
+      builder.BuildRequest().MakeRequest(
+          AccessControlPayload(request.entity(), request.role())));
 }
 
 StatusOr<ObjectAccessControl> CurlClient::PatchObjectAcl(
@@ -892,7 +1153,7 @@ StatusOr<ListDefaultObjectAclResponse> CurlClient::ListDefaultObjectAcl(
     ListDefaultObjectAclRequest const& request) {
   // Assume the bucket name is validated by the caller.
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/defaultObjectAcl",
+      BucketUrl(bucket_url_prefix_, request.bucket_name(), "/defaultObjectAcl"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
@@ -905,18 +1166,16 @@ StatusOr<ListDefaultObjectAclResponse> CurlClient::ListDefaultObjectAcl(
 StatusOr<ObjectAccessControl> CurlClient::CreateDefaultObjectAcl(
     CreateDefaultObjectAclRequest const& request) {
   CurlRequestBuilder builder(
-      storage_endpoint_ + "/b/" + request.bucket_name() + "/defaultObjectAcl",
+      BucketUrl(bucket_url_prefix_, request.bucket_name(), "/defaultObjectAcl"),
       storage_factory_);
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
     return status;
   }
-  nl::json object;
-  object["entity"] = request.entity();
-  object["role"] = request.role();
   builder.AddHeader("Content-Type: application/json");
   return CheckedFromString<ObjectAccessControlParser>(
-      builder.BuildRequest().MakeRequest(object.dump()));
+      builder.BuildRequest().MakeRequest(
+          AccessControlPayload(request.entity(), request.role())));
 }
 
 StatusOr<EmptyResponse> CurlClient::DeleteDefaultObjectAcl(
@@ -957,11 +1216,9 @@ StatusOr<ObjectAccessControl> CurlClient::UpdateDefaultObjectAcl(
     return status;
   }
   builder.AddHeader("Content-Type: application/json");
-  nl::json object;
-  object["entity"] = request.entity();
-  object["role"] = request.role();
   return CheckedFromString<ObjectAccessControlParser>(
-      builder.BuildRequest().MakeRequest(object.dump()));
+      builder.BuildRequest().MakeRequest(
+          AccessControlPayload(request.entity(), request.role())));
 }
 
 StatusOr<ObjectAccessControl> CurlClient::PatchDefaultObjectAcl(
@@ -1091,9 +1348,10 @@ StatusOr<SignBlobResponse> CurlClient::SignBlob(
 StatusOr<ListNotificationsResponse> CurlClient::ListNotifications(
     ListNotificationsRequest const& request) {
   // Assume the bucket name is validated by the caller.
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
-                                 "/notificationConfigs",
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      BucketUrl(bucket_url_prefix_, request.bucket_name(),
+                "/notificationConfigs"),
+      storage_factory_);
   auto status = SetupBuilder(builder, request, "GET");
   if (!status.ok()) {
     return status;
@@ -1104,9 +1362,10 @@ StatusOr<ListNotificationsResponse> CurlClient::ListNotifications(
 
 StatusOr<NotificationMetadata> CurlClient::CreateNotification(
     CreateNotificationRequest const& request) {
-  CurlRequestBuilder builder(storage_endpoint_ + "/b/" + request.bucket_name() +
-                                 "/notificationConfigs",
-                             storage_factory_);
+  CurlRequestBuilder builder(
+      BucketUrl(bucket_url_prefix_, request.bucket_name(),
+                "/notificationConfigs"),
+      storage_factory_);
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
     return status;
@@ -1193,14 +1452,15 @@ void CurlClient::UnlockShared(curl_lock_data data) {
 
 StatusOr<ObjectMetadata> CurlClient::InsertObjectMediaXml(
     InsertObjectMediaRequest const& request) {
-  CurlRequestBuilder builder(xml_upload_endpoint_ + "/" +
-                                 request.bucket_name() + "/" +
-                                 UrlEscapeString(request.object_name()),
-                             xml_upload_factory_);
+  CurlRequestBuilder builder(
+      ObjectUrl(xml_upload_url_prefix_, request.bucket_name(), "/",
+                request.object_name()),
+      xml_upload_factory_);
   auto status = SetupBuilderCommon(builder, "PUT");
   if (!status.ok()) {
     return status;
   }
+  SetupBuilderUpload(builder);
   builder.AddHeader("Host: storage.googleapis.com");
 
   //
@@ -1280,10 +1540,10 @@ StatusOr<ObjectMetadata> CurlClient::InsertObjectMediaXml(
 
 StatusOr<std::unique_ptr<ObjectReadSource>> CurlClient::ReadObjectXml(
     ReadObjectRangeRequest const& request) {
-  CurlRequestBuilder builder(xml_download_endpoint_ + "/" +
-                                 request.bucket_name() + "/" +
-                                 UrlEscapeString(request.object_name()),
-                             xml_download_factory_);
+  CurlRequestBuilder builder(
+      ObjectUrl(xml_download_url_prefix_, request.bucket_name(), "/",
+                request.object_name()),
+      xml_download_factory_);
   auto status = SetupBuilderCommon(builder, "GET");
   if (!status.ok()) {
     return status;
@@ -1326,6 +1586,12 @@ StatusOr<std::unique_ptr<ObjectReadSource>> CurlClient::ReadObjectXml(
   if (request.RequiresNoCache()) {
     builder.AddHeader("Cache-Control: no-transform");
   }
+  if (request.RequiresGzipDecompression()) {
+    // Ask for the stored (compressed) bytes, the data is decompressed by
+    // ObjectReadStreambuf. Note that we do not use CURLOPT_ACCEPT_ENCODING,
+    // the hashes must be computed over the compressed data.
+    builder.AddHeader("Accept-Encoding: gzip");
+  }
 
   return std::unique_ptr<ObjectReadSource>(
       new CurlDownloadRequest(builder.BuildDownloadRequest(std::string{})));
@@ -1338,11 +1604,13 @@ StatusOr<ObjectMetadata> CurlClient::InsertObjectMediaMultipart(
   // This function is structured as follows:
   // 1. Create a request object, as we often do.
   CurlRequestBuilder builder(
-      upload_endpoint_ + "/b/" + request.bucket_name() + "/o", upload_factory_);
+      BucketUrl(upload_bucket_url_prefix_, request.bucket_name(), "/o"),
+      upload_factory_);
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
     return status;
   }
+  SetupBuilderUpload(builder);
 
   // 2. Pick a separator that does not conflict with the request contents.
   auto boundary = PickBoundary(request.contents());
@@ -1350,49 +1618,63 @@ StatusOr<ObjectMetadata> CurlClient::InsertObjectMediaMultipart(
   builder.AddQueryParameter("uploadType", "multipart");
   builder.AddQueryParameter("name", request.object_name());
 
-  // 3. Perform a streaming upload because computing the size upfront is more
-  //    complicated than it is worth.
-  std::ostringstream writer;
+  // 3. Format the complete body in a single buffer, the metadata is serialized
+  //    directly into it.
+  auto const metadata_option = request.GetOption<WithObjectMetadata>();
+  ObjectMetadata const no_metadata;
+  auto const& metadata =
+      metadata_option.has_value() ? metadata_option.value() : no_metadata;
 
-  nl::json metadata = nl::json::object();
-  if (request.HasOption<WithObjectMetadata>()) {
-    metadata = ObjectMetadataJsonForInsert(
-        request.GetOption<WithObjectMetadata>().value());
-  }
+  ObjectMetadataOverrides overrides;
   if (request.HasOption<MD5HashValue>()) {
-    metadata["md5Hash"] = request.GetOption<MD5HashValue>().value();
+    overrides.md5_hash = request.GetOption<MD5HashValue>().value();
   } else {
-    metadata["md5Hash"] = ComputeMD5Hash(request.contents());
+    overrides.md5_hash = ComputeMD5Hash(request.contents());
   }
-
   if (request.HasOption<Crc32cChecksumValue>()) {
-    metadata["crc32c"] = request.GetOption<Crc32cChecksumValue>().value();
+    overrides.crc32c = request.GetOption<Crc32cChecksumValue>().value();
   } else {
-    metadata["crc32c"] = ComputeCrc32cChecksum(request.contents());
+    overrides.crc32c = ComputeCrc32cChecksum(request.contents());
   }
 
-  std::string crlf = "\r\n";
-  std::string marker = "--" + boundary;
+  char const crlf[] = "\r\n";
+  std::string const marker = "--" + boundary;
+  std::string contents;
+  contents.reserve(request.contents().size() + 4 * marker.size() + 512);
 
   // 4. Format the first part, including the separators and the headers.
-  writer << marker << crlf << "content-type: application/json; charset=UTF-8"
-         << crlf << crlf << metadata.dump() << crlf << marker << crlf;
+  contents += marker;
+  contents += crlf;
+  contents += "content-type: application/json; charset=UTF-8";
+  contents += crlf;
+  contents += crlf;
+  JsonWriter writer(contents);
+  writer.StartObject();
+  WriteObjectMetadataFieldsForInsert(writer, metadata, overrides);
+  writer.EndObject();
+  contents += crlf;
+  contents += marker;
+  contents += crlf;
 
   // 5. Format the second part, which includes all the contents and a final
   //    separator.
+  contents += "content-type: ";
   if (request.HasOption<ContentType>()) {
-    writer << "content-type: " << request.GetOption<ContentType>().value()
-           << crlf;
-  } else if (metadata.count("contentType") != 0) {
-    writer << "content-type: "
-           << metadata.value("contentType", "application/octet-stream") << crlf;
+    contents += request.GetOption<ContentType>().value();
+  } else if (!metadata.content_type().empty()) {
+    contents += metadata.content_type();
   } else {
-    writer << "content-type: application/octet-stream" << crlf;
+    contents += "application/octet-stream";
   }
-  writer << crlf << request.contents() << crlf << marker << "--" << crlf;
+  contents += crlf;
+  contents += crlf;
+  contents += request.contents();
+  contents += crlf;
+  contents += marker;
+  contents += "--";
+  contents += crlf;
 
   // 6. Return the results as usual.
-  auto contents = std::move(writer).str();
   builder.AddHeader("Content-Length: " + std::to_string(contents.size()));
   return CheckedFromString<ObjectMetadataParser>(
       builder.BuildRequest().MakeRequest(contents));
@@ -1420,11 +1702,13 @@ std::string CurlClient::PickBoundary(std::string const& text_to_avoid) {
 StatusOr<ObjectMetadata> CurlClient::InsertObjectMediaSimple(
     InsertObjectMediaRequest const& request) {
   CurlRequestBuilder builder(
-      upload_endpoint_ + "/b/" + request.bucket_name() + "/o", upload_factory_);
+      BucketUrl(upload_bucket_url_prefix_, request.bucket_name(), "/o"),
+      upload_factory_);
   auto status = SetupBuilder(builder, request, "POST");
   if (!status.ok()) {
     return status;
   }
+  SetupBuilderUpload(builder);
   // Set the content type of a sensible value, the application can override this
   // in the options for the request.
   if (!request.HasOption<ContentType>()) {
@@ -17,11 +17,16 @@
 
 #include "google/cloud/internal/random.h"
 #include "google/cloud/storage/internal/curl_handle_factory.h"
+#include "google/cloud/storage/internal/curl_multiplexer.h"
 #include "google/cloud/storage/internal/raw_client.h"
 #include "google/cloud/storage/internal/resumable_upload_session.h"
+#include "google/cloud/storage/internal/token_bucket.h"
+#include "google/cloud/storage/internal/tracing_sampler.h"
 #include "google/cloud/storage/oauth2/credentials.h"
 #include "google/cloud/storage/version.h"
+#include <atomic>
 #include <mutex>
+#include <thread>
 
 namespace google {
 namespace cloud {
@@ -45,6 +50,8 @@ class CurlClient : public RawClient,
     return Create(ClientOptions(std::move(credentials)));
   }
 
+  ~CurlClient() override;
+
   CurlClient(CurlClient const& rhs) = delete;
   CurlClient(CurlClient&& rhs) = delete;
   CurlClient& operator=(CurlClient const& rhs) = delete;
@@ -97,6 +104,8 @@ class CurlClient : public RawClient,
       ReadObjectRangeRequest const&) override;
   StatusOr<ListObjectsResponse> ListObjects(
       ListObjectsRequest const& request) override;
+  StatusOr<ListObjectSummariesResponse> ListObjectSummaries(
+      ListObjectsRequest const& request) override;
   StatusOr<EmptyResponse> DeleteObject(
       DeleteObjectRequest const& request) override;
   StatusOr<ObjectMetadata> UpdateObject(
@@ -185,6 +194,35 @@ class CurlClient : public RawClient,
   explicit CurlClient(ClientOptions options);
 
  private:
+  /**
+   * Open @p count connections to the service endpoints.
+   *
+   * Runs in a background thread started by the constructor, and stops early
+   * if the client is destroyed.
+   */
+  void PrewarmConnections(std::size_t count);
+
+  /// Setup the options for the connections used by @p builder.
+  void SetupBuilderConnection(CurlRequestBuilder& builder);
+
+  /**
+   * Setup @p builder to use the upload connections.
+   *
+   * The socket options are set when a connection is created. Uploads use
+   * their own connection cache, otherwise they could reuse connections
+   * created with the download tuning, and vice versa.
+   */
+  void SetupBuilderUpload(CurlRequestBuilder& builder);
+
+  /**
+   * Returns the headers sent with every request.
+   *
+   * The list is built once, and rebuilt only when the credentials return a
+   * new @p authorization_header, e.g. after refreshing an access token.
+   */
+  std::shared_ptr<curl_slist> CommonHeaders(
+      std::string const& authorization_header);
+
   /// Setup the configuration parameters that do not depend on the request.
   Status SetupBuilderCommon(CurlRequestBuilder& builder, char const* method);
 
@@ -217,17 +255,39 @@ class CurlClient : public RawClient,
   std::string xml_upload_endpoint_;
   std::string xml_download_endpoint_;
   std::string iam_endpoint_;
+  // The URL prefixes of the bucket and object resources, computed once.
+  std::string bucket_url_prefix_;
+  std::string upload_bucket_url_prefix_;
+  std::string xml_upload_url_prefix_;
+  std::string xml_download_url_prefix_;
 
-  // These mutexes are used to protect different portions of `share_`.
+  // The headers sent with every request, see `CommonHeaders()`.
+  std::mutex headers_mu_;
+  std::shared_ptr<curl_slist> common_headers_;  // GUARDED_BY(headers_mu_)
+  std::string common_headers_auth_;             // GUARDED_BY(headers_mu_)
+
+  // These mutexes are used to protect different portions of `share_` and
+  // `upload_share_`.
   std::mutex mu_share_;
   std::mutex mu_dns_;
   std::mutex mu_ssl_session_;
   std::mutex mu_connect_;
   CurlShare share_;
+  // Used by the upload requests, see `SetupBuilderUpload()`.
+  CurlShare upload_share_;
 
   std::mutex mu_;
   google::cloud::internal::DefaultPRNG generator_;  // GUARDED_BY(mu_);
 
+  // Only created if HTTP/2 is enabled and supported.
+  std::shared_ptr<CurlMultiplexer> multiplexer_;
+
+  // Shared by all the requests, each limiter is null if there is no limit.
+  RateLimiters limiters_;
+
+  // Selects the requests traced when HTTP tracing is enabled.
+  std::shared_ptr<TracingSampler> http_sampler_;
+
   // The factories must be listed *after* the CurlShare. libcurl keeps a
   // usage count on each CURLSH* handle, which is only released once the CURL*
   // handle is *closed*. So we want the order of destruction to be (1)
@@ -237,6 +297,10 @@ class CurlClient : public RawClient,
   std::shared_ptr<CurlHandleFactory> upload_factory_;
   std::shared_ptr<CurlHandleFactory> xml_upload_factory_;
   std::shared_ptr<CurlHandleFactory> xml_download_factory_;
+
+  // Opens connections in the background, see `PrewarmConnections()`.
+  std::atomic<bool> prewarm_cancelled_{false};
+  std::thread prewarm_thread_;
 };
 
 }  // namespace internal
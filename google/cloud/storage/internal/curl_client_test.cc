@@ -15,14 +15,23 @@
 #include "google/cloud/storage/internal/curl_client.h"
 #include "google/cloud/internal/make_unique.h"
 #include "google/cloud/internal/setenv.h"
+#include "google/cloud/log.h"
 #include "google/cloud/storage/internal/curl_request_builder.h"
 #include "google/cloud/storage/oauth2/credentials.h"
 #include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/loopback_listener.h"
+#include "google/cloud/testing_util/assert_ok.h"
 #include "google/cloud/testing_util/environment_variable_restore.h"
 #include <gmock/gmock.h>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
+#if _WIN32
+#else
+#include <unistd.h>
+#endif  // _WIN32
 
 namespace google {
 namespace cloud {
@@ -491,6 +500,467 @@ INSTANTIATE_TEST_SUITE_P(CredentialsFailure, CurlClientTest,
 INSTANTIATE_TEST_SUITE_P(LibCurlFailure, CurlClientTest,
                          ::testing::Values("libcurl-failure"));
 
+#if !_WIN32
+TEST(CurlClientPrewarmTest, OpensConnections) {
+  testing::LoopbackListener listener;
+  ASSERT_TRUE(listener.ok());
+
+  // Accept the expected number of connections, responding to one request in
+  // each.
+  int const expected = 3;
+  auto server = std::async(std::launch::async, [&listener] {
+    std::vector<std::pair<int, std::string>> connections;
+    for (int i = 0; i != expected; ++i) {
+      int connection = listener.Accept();
+      char buffer[4096];
+      auto n = ::read(connection, buffer, sizeof(buffer));
+      std::string const response =
+          "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+      (void)::write(connection, response.data(), response.size());
+      auto request = n <= 0 ? std::string{}
+                            : std::string(buffer, static_cast<std::size_t>(n));
+      connections.emplace_back(connection,
+                               request.substr(0, request.find('\r')));
+    }
+    return connections;
+  });
+
+  // The XML API endpoints are only configurable through the testbench
+  // environment variable.
+  testing_util::EnvironmentVariableRestore restore(
+      "CLOUD_STORAGE_TESTBENCH_ENDPOINT");
+  restore.SetUp();
+  google::cloud::internal::SetEnv("CLOUD_STORAGE_TESTBENCH_ENDPOINT",
+                                  listener.endpoint().c_str());
+
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_endpoint(listener.endpoint())
+          .set_connection_pool_size(4)
+          .set_connection_pool_prewarm_size(expected));
+  auto connections = server.get();
+  ASSERT_EQ(expected, static_cast<int>(connections.size()));
+  std::vector<std::string> requests;
+  for (auto const& c : connections) {
+    requests.push_back(c.second);
+  }
+  // The connections are spread over the JSON and XML API endpoints.
+  EXPECT_THAT(requests, ::testing::UnorderedElementsAre(
+                            "HEAD / HTTP/1.1", "HEAD / HTTP/1.1",
+                            "HEAD /xmlapi/ HTTP/1.1"));
+  client.reset();
+  for (auto c : connections) {
+    ::close(c.first);
+  }
+  listener.Close();
+  restore.TearDown();
+}
+
+TEST(CurlClientPrewarmTest, DoesNotBlockConstructor) {
+  testing::LoopbackListener listener;
+  ASSERT_TRUE(listener.ok());
+
+  // The listener accepts connections (in the kernel backlog), but never
+  // responds, the client must not wait for the pre-warming to complete.
+  auto const start = std::chrono::steady_clock::now();
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_endpoint(listener.endpoint())
+          .set_connection_pool_size(2)
+          .set_connection_pool_prewarm_size(1));
+  client.reset();
+  EXPECT_GT(std::chrono::seconds(2), std::chrono::steady_clock::now() - start);
+  listener.Close();
+}
+
+TEST(CurlClientTransferMetricsTest, ReportsEachRequest) {
+  testing::LoopbackListener listener;
+  ASSERT_TRUE(listener.ok());
+
+  // Respond to two requests over the same connection.
+  std::string const payload =
+      R"""({"bucket": "test-bucket", "name": "test-object"})""";
+  auto server = std::async(std::launch::async, [&listener, payload] {
+    int connection = listener.Accept();
+    for (int i = 0; i != 2; ++i) {
+      char buffer[4096];
+      (void)::read(connection, buffer, sizeof(buffer));
+      std::string const response =
+          "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+          "Content-Length: " +
+          std::to_string(payload.size()) + "\r\n\r\n" + payload;
+      (void)::write(connection, response.data(), response.size());
+    }
+    return connection;
+  });
+
+  class RecordingHook : public TransferMetricsHook {
+   public:
+    void OnTransfer(TransferMetrics const& metrics) override {
+      std::lock_guard<std::mutex> lk(mu);
+      records.push_back(metrics);
+    }
+    std::mutex mu;
+    std::vector<TransferMetrics> records;
+  };
+  auto hook = std::make_shared<RecordingHook>();
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_endpoint(listener.endpoint())
+          .set_transfer_metrics_hook(hook));
+  for (int i = 0; i != 2; ++i) {
+    auto metadata = client->GetObjectMetadata(
+        GetObjectMetadataRequest("test-bucket", "test-object"));
+    ASSERT_STATUS_OK(metadata);
+  }
+  client.reset();
+  ::close(server.get());
+  listener.Close();
+
+  ASSERT_EQ(2U, hook->records.size());
+  for (auto const& r : hook->records) {
+    EXPECT_EQ("GET", r.method);
+    EXPECT_THAT(r.url, HasSubstr("/b/test-bucket/o/test-object"));
+    EXPECT_EQ(200, r.status_code);
+    EXPECT_STATUS_OK(r.status);
+    EXPECT_EQ(0, r.retry_attempt);
+    EXPECT_EQ(payload.size(), r.bytes_received);
+    EXPECT_LE(r.time_to_first_byte, r.total_time);
+  }
+  EXPECT_FALSE(hook->records[0].handle_reused);
+  EXPECT_FALSE(hook->records[0].connection_reused);
+  EXPECT_TRUE(hook->records[1].handle_reused);
+  EXPECT_TRUE(hook->records[1].connection_reused);
+}
+
+/// Reads a HTTP request, including its payload, and returns the headers.
+std::string ReadHttpRequest(int connection) {
+  std::string data;
+  char buffer[4096];
+  while (data.find("\r\n\r\n") == std::string::npos) {
+    auto n = ::read(connection, buffer, sizeof(buffer));
+    if (n <= 0) {
+      return data;
+    }
+    data.append(buffer, static_cast<std::size_t>(n));
+  }
+  auto const end = data.find("\r\n\r\n") + 4;
+  auto headers = data.substr(0, end);
+  if (headers.find("Expect: 100-continue") != std::string::npos) {
+    std::string const response = "HTTP/1.1 100 Continue\r\n\r\n";
+    (void)::write(connection, response.data(), response.size());
+  }
+  std::size_t length = 0;
+  auto const pos = headers.find("Content-Length: ");
+  if (pos != std::string::npos) {
+    length = std::stoul(headers.substr(pos + 16));
+  }
+  for (auto received = data.size() - end; received < length;) {
+    auto n = ::read(connection, buffer, sizeof(buffer));
+    if (n <= 0) {
+      break;
+    }
+    received += static_cast<std::size_t>(n);
+  }
+  return headers;
+}
+
+TEST(CurlClientRateLimitTest, ThrottlesUploadsAndDownloads) {
+  testing::LoopbackListener listener;
+  ASSERT_TRUE(listener.ok());
+
+  // Receive an upload, and then send a download. Uploads and downloads do
+  // not share connections.
+  std::size_t const size = 128 * 1024;
+  auto server = std::async(std::launch::async, [&listener, size] {
+    int upload = listener.Accept();
+    (void)ReadHttpRequest(upload);
+    std::string const payload =
+        R"""({"bucket": "test-bucket", "name": "test-object"})""";
+    std::string response =
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+        "Content-Length: " +
+        std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    (void)::write(upload, response.data(), response.size());
+
+    int download = listener.Accept();
+    (void)ReadHttpRequest(download);
+    response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(size) +
+               "\r\n\r\n" + std::string(size, 'x');
+    (void)::write(download, response.data(), response.size());
+    return std::make_pair(upload, download);
+  });
+
+  // Downloads use the XML API endpoint, which is only configurable through
+  // the testbench environment variable.
+  auto const endpoint = listener.endpoint();
+  testing_util::EnvironmentVariableRestore restore(
+      "CLOUD_STORAGE_TESTBENCH_ENDPOINT");
+  restore.SetUp();
+  google::cloud::internal::SetEnv("CLOUD_STORAGE_TESTBENCH_ENDPOINT",
+                                  endpoint.c_str());
+
+  // With a 100ms burst, transferring `size` bytes takes at least 150ms.
+  auto const rate = 512 * 1024;
+  std::chrono::milliseconds const expected(150);
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_endpoint(endpoint)
+          .set_maximum_upload_bandwidth(rate)
+          .set_maximum_download_bandwidth(rate));
+
+  auto start = std::chrono::steady_clock::now();
+  auto metadata = client->InsertObjectMedia(InsertObjectMediaRequest(
+      "test-bucket", "test-object", std::string(size, 'a')));
+  ASSERT_STATUS_OK(metadata);
+  EXPECT_EQ("test-object", metadata->name());
+  EXPECT_LE(expected, std::chrono::steady_clock::now() - start);
+
+  start = std::chrono::steady_clock::now();
+  auto source = client->ReadObject(
+      ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  std::vector<char> buffer(16 * 1024);
+  std::size_t received = 0;
+  for (;;) {
+    auto result = (*source)->Read(buffer.data(), buffer.size());
+    ASSERT_STATUS_OK(result);
+    received += result->bytes_received;
+    if (result->response.status_code != 100) {
+      EXPECT_EQ(200, result->response.status_code);
+      break;
+    }
+  }
+  EXPECT_EQ(size, received);
+  EXPECT_LE(expected, std::chrono::steady_clock::now() - start);
+  source->reset();
+
+  client.reset();
+  auto connections = server.get();
+  ::close(connections.first);
+  ::close(connections.second);
+  listener.Close();
+  restore.TearDown();
+}
+
+TEST(CurlClientDownloadTest, SmallReadsResumePausedTransfer) {
+  testing::LoopbackListener listener;
+  ASSERT_TRUE(listener.ok());
+
+  // Each block from libcurl fills many application buffers, so resuming the
+  // transfer in `Read()` immediately pauses it again.
+  std::string contents(256 * 1024, '\0');
+  for (std::size_t i = 0; i != contents.size(); ++i) {
+    contents[i] = static_cast<char>('a' + i % 26);
+  }
+  auto server = std::async(std::launch::async, [&listener, &contents] {
+    int connection = listener.Accept();
+    (void)ReadHttpRequest(connection);
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+                           std::to_string(contents.size()) + "\r\n\r\n";
+    response += contents;
+    (void)::write(connection, response.data(), response.size());
+    return connection;
+  });
+
+  auto const endpoint = listener.endpoint();
+  testing_util::EnvironmentVariableRestore restore(
+      "CLOUD_STORAGE_TESTBENCH_ENDPOINT");
+  restore.SetUp();
+  google::cloud::internal::SetEnv("CLOUD_STORAGE_TESTBENCH_ENDPOINT",
+                                  endpoint.c_str());
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_endpoint(endpoint));
+
+  auto source = client->ReadObject(
+      ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  std::vector<char> buffer(1024);
+  std::string received;
+  for (;;) {
+    auto result = (*source)->Read(buffer.data(), buffer.size());
+    ASSERT_STATUS_OK(result);
+    received.append(buffer.data(), result->bytes_received);
+    if (result->response.status_code != 100) {
+      EXPECT_EQ(200, result->response.status_code);
+      break;
+    }
+  }
+  EXPECT_EQ(contents.size(), received.size());
+  EXPECT_TRUE(contents == received);
+  source->reset();
+
+  client.reset();
+  ::close(server.get());
+  listener.Close();
+  restore.TearDown();
+}
+
+TEST(CurlClientTransportTuningTest, TunedUploadAndDownload) {
+  testing::LoopbackListener listener;
+  ASSERT_TRUE(listener.ok());
+
+  // The download is larger than the libcurl buffer, which is larger than the
+  // default, so libcurl passes large blocks to the write callback.
+  std::string contents(2 * 1024 * 1024, '\0');
+  for (std::size_t i = 0; i != contents.size(); ++i) {
+    contents[i] = static_cast<char>('a' + i % 26);
+  }
+  std::string const json =
+      R"""({"bucket": "test-bucket", "name": "test-object"})""";
+  auto server = std::async(std::launch::async, [&listener, json, contents] {
+    std::vector<int> connections;
+    for (int i = 0; i != 2; ++i) {
+      int connection = listener.Accept();
+      connections.push_back(connection);
+      (void)ReadHttpRequest(connection);
+      // The first request is the upload, the second is the download.
+      auto const& payload = i == 0 ? json : contents;
+      std::string response = "HTTP/1.1 200 OK\r\nConnection: close\r\n"
+                             "Content-Length: " +
+                             std::to_string(payload.size()) + "\r\n\r\n";
+      response += payload;
+      (void)::write(connection, response.data(), response.size());
+    }
+    return connections;
+  });
+
+  auto const endpoint = listener.endpoint();
+  testing_util::EnvironmentVariableRestore restore(
+      "CLOUD_STORAGE_TESTBENCH_ENDPOINT");
+  restore.SetUp();
+  google::cloud::internal::SetEnv("CLOUD_STORAGE_TESTBENCH_ENDPOINT",
+                                  endpoint.c_str());
+
+  TransportTuning download;
+  download.curl_buffer_size = 512 * 1024;
+  download.socket_receive_buffer_size = 4 * 1024 * 1024;
+  download.socket_send_buffer_size = 64 * 1024;
+  TransportTuning upload;
+  upload.curl_buffer_size = 1024 * 1024;
+  upload.socket_send_buffer_size = 4 * 1024 * 1024;
+  upload.tcp_nodelay = false;
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_endpoint(endpoint)
+          .set_download_tuning(download)
+          .set_upload_tuning(upload));
+
+  auto metadata = client->InsertObjectMedia(InsertObjectMediaRequest(
+      "test-bucket", "test-object", std::string(256 * 1024, 'a')));
+  ASSERT_STATUS_OK(metadata);
+  EXPECT_EQ("test-object", metadata->name());
+
+  auto source = client->ReadObject(
+      ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  std::vector<char> buffer(16 * 1024);
+  std::string received;
+  for (;;) {
+    auto result = (*source)->Read(buffer.data(), buffer.size());
+    ASSERT_STATUS_OK(result);
+    received.append(buffer.data(), result->bytes_received);
+    if (result->response.status_code != 100) {
+      EXPECT_EQ(200, result->response.status_code);
+      break;
+    }
+  }
+  EXPECT_EQ(contents.size(), received.size());
+  EXPECT_TRUE(contents == received);
+  source->reset();
+
+  client.reset();
+  for (auto c : server.get()) {
+    ::close(c);
+  }
+  listener.Close();
+  restore.TearDown();
+}
+
+/// Captures the messages logged while the test runs.
+class CaptureLogLines : public LogBackend {
+ public:
+  CaptureLogLines() = default;
+
+  void Process(LogRecord const& lr) override {
+    std::lock_guard<std::mutex> lk(mu_);
+    lines_.push_back(lr.message);
+  }
+  void ProcessWithOwnership(LogRecord lr) override { Process(lr); }
+
+  std::vector<std::string> ExtractLines() {
+    std::lock_guard<std::mutex> lk(mu_);
+    std::vector<std::string> result;
+    result.swap(lines_);
+    return result;
+  }
+
+ private:
+  std::mutex mu_;
+  std::vector<std::string> lines_;
+};
+
+TEST(CurlClientTracingTest, SampledHttpTracingLogsFailures) {
+  testing::LoopbackListener listener;
+  ASSERT_TRUE(listener.ok());
+
+  auto server = std::async(std::launch::async, [&listener] {
+    std::vector<int> connections;
+    for (int i = 0; i != 2; ++i) {
+      int connection = listener.Accept();
+      connections.push_back(connection);
+      (void)ReadHttpRequest(connection);
+      // The first request succeeds, the second fails.
+      std::string const payload =
+          i == 0 ? R"""({"name": "test-bucket"})""" : "not found";
+      std::string response = i == 0 ? "HTTP/1.1 200 OK\r\n"
+                                    : "HTTP/1.1 404 Not Found\r\n";
+      response += "Connection: close\r\nContent-Length: " +
+                  std::to_string(payload.size()) + "\r\n\r\n" + payload;
+      (void)::write(connection, response.data(), response.size());
+    }
+    return connections;
+  });
+
+  auto backend = std::make_shared<CaptureLogLines>();
+  auto backend_id = LogSink::Instance().AddBackend(backend);
+
+  auto const endpoint = listener.endpoint();
+  TracingSampling sampling;
+  sampling.sample_period = 0;
+  auto client = CurlClient::Create(
+      ClientOptions(oauth2::CreateAnonymousCredentials())
+          .set_endpoint(endpoint)
+          .set_enable_http_tracing(true)
+          .set_tracing_sampling(sampling));
+
+  auto success = client->GetBucketMetadata(
+      GetBucketMetadataRequest("test-bucket"));
+  EXPECT_STATUS_OK(success);
+  auto failure = client->GetBucketMetadata(
+      GetBucketMetadataRequest("test-bucket"));
+  EXPECT_FALSE(failure.ok());
+
+  LogSink::Instance().RemoveBackend(backend_id);
+  std::vector<std::string> traced;
+  for (auto const& line : backend->ExtractLines()) {
+    if (line.find("MakeRequest() >> ") != std::string::npos) {
+      traced.push_back(line);
+    }
+  }
+  ASSERT_EQ(1U, traced.size());
+  EXPECT_THAT(traced[0], HasSubstr("status_code=404"));
+  EXPECT_THAT(traced[0], HasSubstr("/b/test-bucket"));
+
+  client.reset();
+  for (auto c : server.get()) {
+    ::close(c);
+  }
+  listener.Close();
+}
+#endif  // !_WIN32
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
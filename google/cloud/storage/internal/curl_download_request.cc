@@ -38,12 +38,11 @@ namespace internal {
                  << ", spill_.size()=" << spill_.size()                     \
                  << ", spill_offset_=" << spill_offset_                     \
                  << ", closing=" << closing_ << ", closed=" << curl_closed_ \
-                 << ", paused=" << paused_ << ", in_multi=" << in_multi_
+                 << ", paused=" << paused_ << ", throttled=" << throttled_  \
+                 << ", deferred=" << deferred_ << ", in_multi=" << in_multi_
 
 CurlDownloadRequest::CurlDownloadRequest()
-    : headers_(nullptr, &curl_slist_free_all),
-      multi_(nullptr, &curl_multi_cleanup),
-      spill_(CURL_MAX_WRITE_SIZE) {}
+    : multi_(nullptr, &curl_multi_cleanup) {}
 
 template <typename Predicate>
 Status CurlDownloadRequest::Wait(Predicate predicate) {
@@ -54,6 +53,10 @@ Status CurlDownloadRequest::Wait(Predicate predicate) {
   while (!predicate()) {
     handle_.FlushDebug(__func__);
     TRACE_STATE() << ", repeats=" << repeats;
+    auto resume = StartOrResume();
+    if (!resume.ok()) {
+      return resume;
+    }
     auto running_handles = PerformWork();
     if (!running_handles.ok()) {
       return std::move(running_handles).status();
@@ -61,8 +64,8 @@ Status CurlDownloadRequest::Wait(Predicate predicate) {
     // Only wait if there are CURL handles with pending work *and* the
     // predicate is not satisfied. Note that if the predicate is ill-defined
     // it might continue to be unsatisfied even though the handles have
-    // completed their work.
-    if (*running_handles == 0 || predicate()) {
+    // completed their work. A deferred transfer has not started yet.
+    if ((*running_handles == 0 && !deferred_) || predicate()) {
       break;
     }
     auto status = WaitForHandles(repeats);
@@ -78,7 +81,15 @@ StatusOr<HttpResponse> CurlDownloadRequest::Close() {
   // Set the the closing_ flag to trigger a return 0 from the next read
   // callback, see the comments in the header file for more details.
   closing_ = true;
+  // Any data in the spill buffer is discarded.
+  spill_offset_ = 0;
+  if (deferred_) {
+    // The transfer never started, there is nothing to close.
+    deferred_ = false;
+    curl_closed_ = true;
+  }
 
+  throttled_ = false;
   (void)handle_.EasyPause(CURLPAUSE_RECV_CONT);
   paused_ = false;
   TRACE_STATE();
@@ -131,13 +142,17 @@ StatusOr<ReadSourceResult> CurlDownloadRequest::Read(char* buf, std::size_t n) {
   handle_.FlushDebug(__func__);
   TRACE_STATE();
 
-  if (!curl_closed_) {
+  // Only resume transfers paused because the buffer was full. Transfers
+  // paused by the bandwidth limiter resume in `Wait()`, and some versions of
+  // libcurl reject this call for transfers that have not started.
+  if (!curl_closed_ && paused_) {
+    // Resuming may call WriteCallback(), which can pause the transfer again.
+    paused_ = false;
     auto status = handle_.EasyPause(CURLPAUSE_RECV_CONT);
     if (!status.ok()) {
       TRACE_STATE() << ", status=" << status;
       return status;
     }
-    paused_ = false;
     TRACE_STATE();
   }
 
@@ -152,7 +167,9 @@ StatusOr<ReadSourceResult> CurlDownloadRequest::Read(char* buf, std::size_t n) {
   buffer_ = nullptr;
   buffer_offset_ = 0;
   buffer_size_ = 0;
-  if (curl_closed_) {
+  // The transfer may complete with more data in the spill buffer than fits in
+  // the application buffer, the next calls return that data.
+  if (curl_closed_ && spill_offset_ == 0) {
     // Retrieve the response code for a closed stream. Note the use of
     // `.value()`, this is equivalent to: assert(http_code.ok());
     // The only way the previous call can fail indicates a bug in our code (or
@@ -179,14 +196,28 @@ void CurlDownloadRequest::SetOptions() {
   if (in_multi_) {
     return;
   }
-  auto error = curl_multi_add_handle(multi_.get(), handle_.handle_.get());
-  if (error != CURLM_OK) {
+  // Over the request rate limit the transfer starts in `Wait()`, once the
+  // limiter has a token.
+  if (limiters_.requests && !limiters_.requests->TryConsume(1)) {
+    deferred_ = true;
+    return;
+  }
+  auto status = AddToMulti();
+  if (!status.ok()) {
     // This indicates that we are using the API incorrectly, the application
     // can not recover from these problems, raising an exception is the
     // "Right Thing"[tm] here.
-    google::cloud::internal::ThrowStatus(AsStatus(error, __func__));
+    google::cloud::internal::ThrowStatus(std::move(status));
+  }
+}
+
+Status CurlDownloadRequest::AddToMulti() {
+  auto error = curl_multi_add_handle(multi_.get(), handle_.handle_.get());
+  if (error != CURLM_OK) {
+    return AsStatus(error, __func__);
   }
   in_multi_ = true;
+  return Status();
 }
 
 void CurlDownloadRequest::ResetOptions() {
@@ -214,12 +245,24 @@ void CurlDownloadRequest::ResetOptions() {
   handle_.EnableLogging(logging_enabled_);
 }
 
+void CurlDownloadRequest::ReportTransferMetrics(Status const& status) {
+  if (!metrics_hook_) {
+    return;
+  }
+  TransferMetrics metrics = metrics_;
+  metrics.status = status;
+  auto code = handle_.GetResponseCode();
+  metrics.status_code = code.ok() ? *code : 0;
+  handle_.CollectTransferMetrics(metrics);
+  metrics_hook_->OnTransfer(metrics);
+}
+
 void CurlDownloadRequest::DrainSpillBuffer() {
   std::size_t free = buffer_size_ - buffer_offset_;
   auto copy_count = (std::min)(free, spill_offset_);
   std::memcpy(buffer_ + buffer_offset_, spill_.data(), copy_count);
   buffer_offset_ += copy_count;
-  std::memmove(spill_.data(), spill_.data() + copy_count,
+  std::memmove(&spill_[0], spill_.data() + copy_count,
                spill_.size() - copy_count);
   spill_offset_ -= copy_count;
 }
@@ -250,6 +293,12 @@ std::size_t CurlDownloadRequest::WriteCallback(void* ptr, std::size_t size,
     paused_ = true;
     return CURL_READFUNC_PAUSE;
   }
+  if (limiters_.download_bytes &&
+      !limiters_.download_bytes->TryConsume(size * nmemb)) {
+    TRACE_STATE() << " *** THROTTLING HANDLE ***";
+    throttled_ = true;
+    return CURL_WRITEFUNC_PAUSE;
+  }
   TRACE_STATE() << ", n=" << size * nmemb << ", free=" << free;
 
   // Copy the full contents of `ptr` into the application buffer.
@@ -264,7 +313,7 @@ std::size_t CurlDownloadRequest::WriteCallback(void* ptr, std::size_t size,
   buffer_offset_ += free;
   spill_offset_ = size * nmemb - free;
   // The rest goes into the spill buffer.
-  std::memcpy(spill_.data(), static_cast<char*>(ptr) + free, spill_offset_);
+  std::memcpy(&spill_[0], static_cast<char*>(ptr) + free, spill_offset_);
   TRACE_STATE() << ", n=" << size * nmemb << ", free=" << free;
   return size * nmemb;
 }
@@ -313,6 +362,9 @@ StatusOr<int> CurlDownloadRequest::PerformWork() {
       // Whatever the status is, the transfer is done, we need to remove it
       // from the CURLM* interface.
       curl_closed_ = true;
+      // Transfers interrupted by Close() report an error, but that is the
+      // expected result.
+      ReportTransferMetrics(closing_ ? Status() : status);
       Status multi_remove_status;
       if (in_multi_) {
         // In the extremely unlikely case that removing the handle from CURLM*
@@ -346,7 +398,7 @@ StatusOr<int> CurlDownloadRequest::PerformWork() {
 }
 
 Status CurlDownloadRequest::WaitForHandles(int& repeats) {
-  int const timeout_ms = 1;
+  int const timeout_ms = WaitTimeoutMs();
   std::chrono::milliseconds const timeout(timeout_ms);
   int numfds = 0;
   CURLMcode result =
@@ -370,6 +422,41 @@ Status CurlDownloadRequest::WaitForHandles(int& repeats) {
   return status;
 }
 
+Status CurlDownloadRequest::StartOrResume() {
+  if (deferred_) {
+    if (!limiters_.requests->TryConsume(1)) {
+      return Status();
+    }
+    TRACE_STATE() << " *** STARTING HANDLE ***";
+    deferred_ = false;
+    return AddToMulti();
+  }
+  if (!throttled_ || limiters_.download_bytes->WaitTime().count() != 0) {
+    return Status();
+  }
+  TRACE_STATE() << " *** RESUMING HANDLE ***";
+  // Resuming may call WriteCallback(), which can pause the transfer again.
+  throttled_ = false;
+  return handle_.EasyPause(CURLPAUSE_RECV_CONT);
+}
+
+int CurlDownloadRequest::WaitTimeoutMs() {
+  TokenBucket* limiter = nullptr;
+  if (deferred_) {
+    limiter = limiters_.requests.get();
+  } else if (throttled_) {
+    limiter = limiters_.download_bytes.get();
+  }
+  if (limiter == nullptr) {
+    return 1;
+  }
+  // Nothing happens until the limiter has tokens, round up to avoid waking up
+  // just before that.
+  auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+      limiter->WaitTime() + std::chrono::microseconds(999));
+  return (std::max)(1, static_cast<int>(wait.count()));
+}
+
 Status CurlDownloadRequest::AsStatus(CURLMcode result, char const* where) {
   if (result == CURLM_OK) {
     return Status();
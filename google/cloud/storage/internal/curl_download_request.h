@@ -15,9 +15,11 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_DOWNLOAD_REQUEST_H_
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_DOWNLOAD_REQUEST_H_
 
+#include "google/cloud/storage/buffer_pool.h"
 #include "google/cloud/storage/internal/curl_request.h"
 #include "google/cloud/storage/internal/http_response.h"
 #include "google/cloud/storage/internal/object_read_source.h"
+#include "google/cloud/storage/internal/token_bucket.h"
 #include "google/cloud/storage/version.h"
 
 namespace google {
@@ -40,6 +42,7 @@ class CurlDownloadRequest : public ObjectReadSource {
   explicit CurlDownloadRequest();
 
   ~CurlDownloadRequest() override {
+    ReleaseBuffer(buffer_pool_.get(), std::move(spill_));
     if (!factory_) {
       return;
     }
@@ -56,10 +59,16 @@ class CurlDownloadRequest : public ObjectReadSource {
         handle_(std::move(rhs.handle_)),
         multi_(std::move(rhs.multi_)),
         factory_(std::move(rhs.factory_)),
+        metrics_hook_(std::move(rhs.metrics_hook_)),
+        metrics_(std::move(rhs.metrics_)),
+        limiters_(std::move(rhs.limiters_)),
+        buffer_pool_(std::move(rhs.buffer_pool_)),
         closing_(rhs.closing_),
         curl_closed_(rhs.curl_closed_),
         in_multi_(rhs.in_multi_),
         paused_(rhs.paused_),
+        throttled_(rhs.throttled_),
+        deferred_(rhs.deferred_),
         buffer_(rhs.buffer_),
         buffer_size_(rhs.buffer_size_),
         buffer_offset_(rhs.buffer_offset_),
@@ -77,10 +86,16 @@ class CurlDownloadRequest : public ObjectReadSource {
     handle_ = std::move(rhs.handle_);
     multi_ = std::move(rhs.multi_);
     factory_ = std::move(rhs.factory_);
+    metrics_hook_ = std::move(rhs.metrics_hook_);
+    metrics_ = std::move(rhs.metrics_);
+    limiters_ = std::move(rhs.limiters_);
+    buffer_pool_ = std::move(rhs.buffer_pool_);
     closing_ = rhs.closing_;
     curl_closed_ = rhs.curl_closed_;
     in_multi_ = rhs.in_multi_;
     paused_ = rhs.paused_;
+    throttled_ = rhs.throttled_;
+    deferred_ = rhs.deferred_;
     buffer_ = rhs.buffer_;
     buffer_size_ = rhs.buffer_size_;
     buffer_offset_ = rhs.buffer_offset_;
@@ -90,7 +105,7 @@ class CurlDownloadRequest : public ObjectReadSource {
     return *this;
   }
 
-  bool IsOpen() const override { return !curl_closed_; }
+  bool IsOpen() const override { return !curl_closed_ || spill_offset_ != 0; }
   StatusOr<HttpResponse> Close() override;
 
   /**
@@ -110,6 +125,9 @@ class CurlDownloadRequest : public ObjectReadSource {
   /// Set the underlying CurlHandle options on a new CurlDownloadRequest.
   void SetOptions();
 
+  /// Add `handle_` to `multi_`, starting the transfer.
+  Status AddToMulti();
+
   /// Reset the underlying CurlHandle options after a move operation.
   void ResetOptions();
 
@@ -129,11 +147,23 @@ class CurlDownloadRequest : public ObjectReadSource {
   /// Use libcurl to wait until the underlying data can perform work.
   Status WaitForHandles(int& repeats);
 
+  /**
+   * Start a deferred transfer, or resume a transfer paused by the bandwidth
+   * limiter, if the corresponding limiter has tokens.
+   */
+  Status StartOrResume();
+
+  /// How long `WaitForHandles()` waits, until the limiters have tokens.
+  int WaitTimeoutMs();
+
   /// Simplify handling of errors in the curl_multi_* API.
   Status AsStatus(CURLMcode result, char const* where);
 
+  /// Report the metrics for the transfer, if there is a hook installed.
+  void ReportTransferMetrics(Status const& status);
+
   std::string url_;
-  CurlHeaders headers_;
+  CurlHeaderList headers_;
   std::string payload_;
   std::string user_agent_;
   CurlReceivedHeaders received_headers_;
@@ -141,6 +171,10 @@ class CurlDownloadRequest : public ObjectReadSource {
   CurlHandle handle_;
   CurlMulti multi_;
   std::shared_ptr<CurlHandleFactory> factory_;
+  std::shared_ptr<TransferMetricsHook> metrics_hook_;
+  TransferMetrics metrics_;
+  RateLimiters limiters_;
+  std::shared_ptr<BufferPool> buffer_pool_;
 
   // Explicitly closing the handle happens in two steps.
   // 1. First the application (or higher-level class), calls Close(). This class
@@ -166,6 +200,14 @@ class CurlDownloadRequest : public ObjectReadSource {
 
   bool paused_ = false;
 
+  // The transfer is paused because the download bandwidth limit was reached,
+  // it resumes once the limiter has tokens, without returning to the caller.
+  bool throttled_ = false;
+
+  // The transfer has not started because the request rate limit was reached,
+  // it starts once the limiter has a token.
+  bool deferred_ = false;
+
   char* buffer_ = nullptr;
   std::size_t buffer_size_ = 0;
   std::size_t buffer_offset_ = 0;
@@ -175,7 +217,7 @@ class CurlDownloadRequest : public ObjectReadSource {
   // less bytes read aborts the download (we do that on a Close(), but in
   // general we do not). The application may have requested less bytes in the
   // call to `Read()`, so we need a place to store the additional bytes.
-  std::vector<char> spill_;
+  std::string spill_;
   std::size_t spill_offset_ = 0;
 };
 
@@ -15,6 +15,10 @@
 #include "google/cloud/storage/internal/curl_handle.h"
 #include "google/cloud/log.h"
 #include "google/cloud/storage/internal/binary_data_as_debug_string.h"
+#if _WIN32
+#else
+#include <sys/socket.h>
+#endif  // _WIN32
 
 namespace google {
 namespace cloud {
@@ -80,6 +84,60 @@ extern "C" std::size_t CurlHandleHeaderCallback(char* contents,
   auto* callback = reinterpret_cast<CurlHandle::HeaderCallback*>(userdata);
   return callback->operator()(contents, size, nitems);
 }
+
+void SetSocketBufferSize(curl_socket_t fd, int option, std::size_t size) {
+  if (size == 0) {
+    return;
+  }
+  auto value = static_cast<int>(size);
+  // The tuning is best effort, the connection works (maybe slower) if the
+  // option cannot be set, so errors are ignored.
+  (void)setsockopt(fd, SOL_SOCKET, option,
+                   reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+extern "C" int CurlHandleSocketOptionsCallback(void* userdata,
+                                               curl_socket_t fd,
+                                               curlsocktype purpose) {
+  if (purpose != CURLSOCKTYPE_IPCXN) {
+    return CURL_SOCKOPT_OK;
+  }
+  auto* sizes = reinterpret_cast<CurlHandle::SocketBufferSizes*>(userdata);
+  SetSocketBufferSize(fd, SO_RCVBUF, sizes->receive_buffer_size);
+  SetSocketBufferSize(fd, SO_SNDBUF, sizes->send_buffer_size);
+  return CURL_SOCKOPT_OK;
+}
+
+/// Returns the value of a CURLINFO_*_TIME_T option, zero on errors.
+std::chrono::microseconds GetTime(CURL* handle, CURLINFO info) {
+#if LIBCURL_VERSION_NUM >= 0x073d00
+  curl_off_t value = 0;
+  if (curl_easy_getinfo(handle, info, &value) != CURLE_OK) {
+    return std::chrono::microseconds(0);
+  }
+  return std::chrono::microseconds(value);
+#else
+  double value = 0;
+  if (curl_easy_getinfo(handle, info, &value) != CURLE_OK) {
+    return std::chrono::microseconds(0);
+  }
+  return std::chrono::microseconds(static_cast<std::int64_t>(value * 1.0E6));
+#endif  // LIBCURL_VERSION_NUM >= 0x073d00
+}
+
+/// Returns the value of a CURLINFO_SIZE_* option, zero on errors.
+std::uint64_t GetSize(CURL* handle, CURLINFO info) {
+#if LIBCURL_VERSION_NUM >= 0x073700
+  curl_off_t value = 0;
+#else
+  double value = 0;
+#endif  // LIBCURL_VERSION_NUM >= 0x073700
+  if (curl_easy_getinfo(handle, info, &value) != CURLE_OK || value < 0) {
+    return 0;
+  }
+  return static_cast<std::uint64_t>(value);
+}
+
 }  // namespace
 
 CurlHandle::CurlHandle() : handle_(curl_easy_init(), &curl_easy_cleanup) {
@@ -126,6 +184,73 @@ void CurlHandle::ResetHeaderCallback() {
   header_callback_ = HeaderCallback();
 }
 
+void CurlHandle::SetSocketBufferSizes(std::size_t receive_buffer_size,
+                                      std::size_t send_buffer_size) {
+  socket_buffer_sizes_.receive_buffer_size = receive_buffer_size;
+  socket_buffer_sizes_.send_buffer_size = send_buffer_size;
+  if (receive_buffer_size == 0 && send_buffer_size == 0) {
+    SetOption(CURLOPT_SOCKOPTFUNCTION, nullptr);
+    SetOption(CURLOPT_SOCKOPTDATA, nullptr);
+    return;
+  }
+  SetOption(CURLOPT_SOCKOPTDATA, &socket_buffer_sizes_);
+  SetOption(CURLOPT_SOCKOPTFUNCTION, &CurlHandleSocketOptionsCallback);
+}
+
+void CurlHandle::UpdateSocketOptionsData() {
+  if (socket_buffer_sizes_.receive_buffer_size == 0 &&
+      socket_buffer_sizes_.send_buffer_size == 0) {
+    return;
+  }
+  SetOption(CURLOPT_SOCKOPTDATA, &socket_buffer_sizes_);
+}
+
+void CurlHandle::CollectTransferMetrics(TransferMetrics& metrics) {
+#if LIBCURL_VERSION_NUM >= 0x073d00
+  auto const name_lookup = GetTime(handle_.get(), CURLINFO_NAMELOOKUP_TIME_T);
+  auto const connect = GetTime(handle_.get(), CURLINFO_CONNECT_TIME_T);
+  auto const app_connect = GetTime(handle_.get(), CURLINFO_APPCONNECT_TIME_T);
+  auto const first_byte = GetTime(handle_.get(), CURLINFO_STARTTRANSFER_TIME_T);
+  auto const total = GetTime(handle_.get(), CURLINFO_TOTAL_TIME_T);
+#else
+  auto const name_lookup = GetTime(handle_.get(), CURLINFO_NAMELOOKUP_TIME);
+  auto const connect = GetTime(handle_.get(), CURLINFO_CONNECT_TIME);
+  auto const app_connect = GetTime(handle_.get(), CURLINFO_APPCONNECT_TIME);
+  auto const first_byte = GetTime(handle_.get(), CURLINFO_STARTTRANSFER_TIME);
+  auto const total = GetTime(handle_.get(), CURLINFO_TOTAL_TIME);
+#endif  // LIBCURL_VERSION_NUM >= 0x073d00
+#if LIBCURL_VERSION_NUM >= 0x073700
+  metrics.bytes_sent = GetSize(handle_.get(), CURLINFO_SIZE_UPLOAD_T);
+  metrics.bytes_received = GetSize(handle_.get(), CURLINFO_SIZE_DOWNLOAD_T);
+#else
+  metrics.bytes_sent = GetSize(handle_.get(), CURLINFO_SIZE_UPLOAD);
+  metrics.bytes_received = GetSize(handle_.get(), CURLINFO_SIZE_DOWNLOAD);
+#endif  // LIBCURL_VERSION_NUM >= 0x073700
+
+  // libcurl reports the time from the start of the request until the end of
+  // each phase, convert them to the duration of each phase. The timings are
+  // zero for the phases that did not happen, e.g. the TLS handshake for plain
+  // text requests.
+  auto phase = [](std::chrono::microseconds end,
+                  std::chrono::microseconds start) {
+    return end > start ? end - start : std::chrono::microseconds(0);
+  };
+  metrics.name_lookup_time = name_lookup;
+  metrics.connect_time = phase(connect, name_lookup);
+  metrics.tls_handshake_time = phase(app_connect, connect);
+  metrics.time_to_first_byte = first_byte;
+  metrics.total_time = total;
+
+  long connects = 0;
+  auto e = curl_easy_getinfo(handle_.get(), CURLINFO_NUM_CONNECTS, &connects);
+  metrics.connection_reused = e == CURLE_OK && connects == 0;
+  if (metrics.connection_reused) {
+    metrics.name_lookup_time = std::chrono::microseconds(0);
+    metrics.connect_time = std::chrono::microseconds(0);
+    metrics.tls_handshake_time = std::chrono::microseconds(0);
+  }
+}
+
 void CurlHandle::EnableLogging(bool enabled) {
   if (enabled) {
     SetOption(CURLOPT_DEBUGDATA, &debug_buffer_);
@@ -17,6 +17,7 @@
 
 #include "google/cloud/status_or.h"
 #include "google/cloud/storage/internal/curl_wrappers.h"
+#include "google/cloud/storage/transfer_metrics.h"
 #include "google/cloud/storage/version.h"
 #include <curl/curl.h>
 
@@ -41,17 +42,23 @@ class CurlHandle {
   CurlHandle(CurlHandle const&) = delete;
   CurlHandle& operator=(CurlHandle const&) = delete;
 
-  // Allow moves, they immediately disable callbacks.
-  CurlHandle(CurlHandle&& rhs) : handle_(std::move(rhs.handle_)) {
+  // Allow moves, they immediately disable callbacks. The socket buffer sizes
+  // do not refer to the owner of the handle, they move with it.
+  CurlHandle(CurlHandle&& rhs)
+      : handle_(std::move(rhs.handle_)),
+        socket_buffer_sizes_(rhs.socket_buffer_sizes_) {
     ResetHeaderCallback();
     ResetReaderCallback();
     ResetWriterCallback();
+    UpdateSocketOptionsData();
   }
   CurlHandle& operator=(CurlHandle&& rhs) {
     handle_ = std::move(rhs.handle_);
+    socket_buffer_sizes_ = rhs.socket_buffer_sizes_;
     ResetHeaderCallback();
     ResetReaderCallback();
     ResetWriterCallback();
+    UpdateSocketOptionsData();
     return *this;
   }
 
@@ -127,6 +134,21 @@ class CurlHandle {
   /// Resets the reader callback.
   void ResetHeaderCallback();
 
+  /**
+   * Sets the buffer sizes (`SO_RCVBUF` and `SO_SNDBUF`) for new sockets.
+   *
+   * The sizes are set on the sockets created for new connections, a value of
+   * zero keeps the operating system default.
+   */
+  void SetSocketBufferSizes(std::size_t receive_buffer_size,
+                            std::size_t send_buffer_size);
+
+  /// The socket buffer sizes, for the socket option callback.
+  struct SocketBufferSizes {
+    std::size_t receive_buffer_size = 0;
+    std::size_t send_buffer_size = 0;
+  };
+
   /// URL-escapes a string.
   CurlString MakeEscapedString(std::string const& s) {
     return CurlString(
@@ -162,6 +184,14 @@ class CurlHandle {
     return AsStatus(e, __func__);
   }
 
+  /**
+   * Fills the timings, byte counts, and connection reuse in @p metrics.
+   *
+   * Only meaningful after a transfer completes, the other fields in
+   * @p metrics are not modified.
+   */
+  void CollectTransferMetrics(TransferMetrics& metrics);
+
   void EnableLogging(bool enabled);
 
   /// Flushes any debug data using GCP_LOG().
@@ -173,10 +203,13 @@ class CurlHandle {
  private:
   explicit CurlHandle(CurlPtr ptr) : handle_(std::move(ptr)) {}
 
+  friend class CurlClient;
   friend class CurlDownloadRequest;
   friend class CurlRequest;
   friend class CurlRequestBuilder;
 
+  void UpdateSocketOptionsData();
+
   [[noreturn]] void ThrowSetOptionError(CURLcode e, CURLoption opt, long param);
   [[noreturn]] void ThrowSetOptionError(CURLcode e, CURLoption opt,
                                         char const* param);
@@ -196,6 +229,7 @@ class CurlHandle {
   ReaderCallback reader_callback_;
   WriterCallback writer_callback_;
   HeaderCallback header_callback_;
+  SocketBufferSizes socket_buffer_sizes_;
 };
 
 }  // namespace internal
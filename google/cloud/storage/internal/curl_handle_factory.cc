@@ -50,70 +50,117 @@ CurlMulti DefaultCurlHandleFactory::CreateMultiHandle() {
 
 void DefaultCurlHandleFactory::CleanupMultiHandle(CurlMulti&& m) { m.reset(); }
 
-PooledCurlHandleFactory::PooledCurlHandleFactory(std::size_t maximum_size)
-    : maximum_size_(maximum_size) {
-  handles_.reserve(maximum_size);
-  multi_handles_.reserve(maximum_size);
-}
+namespace {
+// The pool tags the handles it returns, see IsReusedHandle().
+char const kReusedHandleTag = 0;
 
-PooledCurlHandleFactory::~PooledCurlHandleFactory() {
-  for (auto* h : handles_) {
-    curl_easy_cleanup(h);
+void GetLocalIpAddress(CURL* handle, std::mutex& mu, std::string& address) {
+  char* ip;
+  auto res = curl_easy_getinfo(handle, CURLINFO_LOCAL_IP, &ip);
+  if (res != CURLE_OK || ip == nullptr) {
+    return;
   }
-  for (auto* m : multi_handles_) {
-    curl_multi_cleanup(m);
+  // The address is purely informational, do not wait for other threads.
+  std::unique_lock<std::mutex> lk(mu, std::try_to_lock);
+  if (lk && address != ip) {
+    address = ip;
   }
 }
+}  // namespace
+
+bool IsReusedHandle(CURL* handle) {
+  char* tag = nullptr;
+  auto res = curl_easy_getinfo(handle, CURLINFO_PRIVATE, &tag);
+  return res == CURLE_OK && tag == &kReusedHandleTag;
+}
+
+PooledCurlHandleFactory::PooledCurlHandleFactory(
+    std::size_t maximum_size,
+    std::chrono::steady_clock::duration maximum_idle_time)
+    : maximum_idle_time_(maximum_idle_time),
+      handles_(maximum_size),
+      multi_handles_(maximum_size),
+      next_eviction_(0) {}
+
+PooledCurlHandleFactory::~PooledCurlHandleFactory() {
+  auto const end = Clock::time_point::max();
+  handles_.EvictReleasedBefore(end, &curl_easy_cleanup);
+  multi_handles_.EvictReleasedBefore(end, &curl_multi_cleanup);
+}
 
 CurlPtr PooledCurlHandleFactory::CreateHandle() {
-  std::unique_lock<std::mutex> lk(mu_);
-  if (!handles_.empty()) {
-    CURL* handle = handles_.back();
+  auto const now = Clock::now();
+  Clock::time_point released;
+  while (CURL* handle = handles_.Pop(released)) {
+    if (released + maximum_idle_time_ < now) {
+      curl_easy_cleanup(handle);
+      continue;
+    }
     // Clear all the options in the handle so we do not leak its previous state.
     (void)curl_easy_reset(handle);
-    handles_.pop_back();
+    (void)curl_easy_setopt(handle, CURLOPT_PRIVATE,
+                           const_cast<char*>(&kReusedHandleTag));
     return CurlPtr(handle, &curl_easy_cleanup);
   }
   return CurlPtr(curl_easy_init(), &curl_easy_cleanup);
 }
 
 void PooledCurlHandleFactory::CleanupHandle(CurlPtr&& h) {
-  std::unique_lock<std::mutex> lk(mu_);
-  char* ip;
-  auto res = curl_easy_getinfo(h.get(), CURLINFO_LOCAL_IP, &ip);
-  if (res == CURLE_OK && ip != nullptr) {
-    last_client_ip_address_ = ip;
+  if (!h) {
+    return;
   }
-  if (handles_.size() >= maximum_size_) {
-    CURL* tmp = handles_.front();
-    handles_.erase(handles_.begin());
-    curl_easy_cleanup(tmp);
+  GetLocalIpAddress(h.get(), mu_, last_client_ip_address_);
+  auto const now = Clock::now();
+  // The pool now has ownership of the handle, and may return an older handle
+  // to release.
+  if (CURL* evicted = handles_.Push(h.release(), now)) {
+    curl_easy_cleanup(evicted);
   }
-  handles_.push_back(h.get());
-  // The handles_ vector now has ownership, so release it.
-  (void)h.release();
+  MaybeEvictIdleHandles(now);
 }
 
 CurlMulti PooledCurlHandleFactory::CreateMultiHandle() {
-  std::unique_lock<std::mutex> lk(mu_);
-  if (!multi_handles_.empty()) {
-    CURL* m = multi_handles_.back();
-    multi_handles_.pop_back();
+  auto const now = Clock::now();
+  Clock::time_point released;
+  while (CURLM* m = multi_handles_.Pop(released)) {
+    if (released + maximum_idle_time_ < now) {
+      curl_multi_cleanup(m);
+      continue;
+    }
     return CurlMulti(m, &curl_multi_cleanup);
   }
   return CurlMulti(curl_multi_init(), &curl_multi_cleanup);
 }
 
 void PooledCurlHandleFactory::CleanupMultiHandle(CurlMulti&& m) {
-  std::unique_lock<std::mutex> lk(mu_);
-  if (multi_handles_.size() >= maximum_size_) {
-    CURLM* tmp = multi_handles_.front();
-    multi_handles_.erase(multi_handles_.begin());
-    curl_multi_cleanup(tmp);
+  if (!m) {
+    return;
+  }
+  auto const now = Clock::now();
+  if (CURLM* evicted = multi_handles_.Push(m.release(), now)) {
+    curl_multi_cleanup(evicted);
+  }
+  MaybeEvictIdleHandles(now);
+}
+
+std::size_t PooledCurlHandleFactory::EvictIdleHandles() {
+  auto const deadline = Clock::now() - maximum_idle_time_;
+  return handles_.EvictReleasedBefore(deadline, &curl_easy_cleanup) +
+         multi_handles_.EvictReleasedBefore(deadline, &curl_multi_cleanup);
+}
+
+void PooledCurlHandleFactory::MaybeEvictIdleHandles(Clock::time_point now) {
+  // Most calls only read this atomic, which is cheap even when many threads
+  // do it. Only the thread that wins the compare-and-swap scans the pool.
+  auto next = next_eviction_.load(std::memory_order_relaxed);
+  if (now.time_since_epoch().count() < next) {
+    return;
+  }
+  auto const updated = (now + maximum_idle_time_).time_since_epoch().count();
+  if (!next_eviction_.compare_exchange_strong(next, updated)) {
+    return;
   }
-  multi_handles_.push_back(m.get());
-  // The multi_handles_ vector now has ownership, so release it.
-  (void)m.release();
+  (void)EvictIdleHandles();
 }
 
 }  // namespace internal
@@ -17,7 +17,13 @@
 
 #include "google/cloud/storage/internal/curl_wrappers.h"
 #include "google/cloud/storage/version.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 namespace google {
@@ -43,6 +49,14 @@ class CurlHandleFactory {
 
 std::shared_ptr<CurlHandleFactory> GetDefaultCurlHandleFactory();
 
+/**
+ * Returns true if @p handle was returned by a pool, instead of newly created.
+ *
+ * The pools use `CURLOPT_PRIVATE` to tag the handles they return, callers
+ * must not change that option.
+ */
+bool IsReusedHandle(CURL* handle);
+
 /**
  * Implements the default CurlHandleFactory.
  *
@@ -70,15 +84,214 @@ class DefaultCurlHandleFactory : public CurlHandleFactory {
   std::string last_client_ip_address_;
 };
 
+/**
+ * A fixed-size pool of curl handles that never blocks.
+ *
+ * Each slot in the pool holds at most one handle and is claimed with a single
+ * compare-and-swap, threads never wait on each other: if a slot is busy they
+ * move on to the next one. Each thread starts its search at a slot derived
+ * from a hash of its id, so in the common case a thread gets back the handle
+ * it released, after examining a single slot. Threads whose ids hash to the
+ * same slot share it, there are no per-thread caches. Each slot is in its own
+ * cache line, so threads using different slots do not interfere with each
+ * other. The rest of the slots act as the shared overflow for all threads.
+ *
+ * The pool has no shared counters, all its state is in the slots. Getting a
+ * handle from an empty pool, or returning one to a full pool, reads the state
+ * of every slot without modifying it. When the pool is full, returning a
+ * handle replaces the least recently released handle in the pool.
+ *
+ * The pool does not own the handles, the caller is responsible for releasing
+ * any handles left in the pool.
+ */
+template <typename Handle>
+class CurlHandlePool {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit CurlHandlePool(std::size_t size)
+      : storage_(new char[(size + 1) * sizeof(Slot)]), size_(size) {
+    // Before C++17 `new` does not honor the alignment of over-aligned types.
+    auto const address = reinterpret_cast<std::uintptr_t>(storage_.get());
+    auto const aligned = (address + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+    slots_ = reinterpret_cast<Slot*>(aligned);
+    for (std::size_t i = 0; i != size_; ++i) {
+      new (&slots_[i]) Slot;
+    }
+  }
+
+  ~CurlHandlePool() {
+    for (std::size_t i = 0; i != size_; ++i) {
+      slots_[i].~Slot();
+    }
+  }
+
+  CurlHandlePool(CurlHandlePool const&) = delete;
+  CurlHandlePool& operator=(CurlHandlePool const&) = delete;
+
+  std::size_t capacity() const { return size_; }
+
+  /**
+   * Store @p handle in the pool.
+   *
+   * @return the handle the caller must release: `nullptr` if the pool had
+   *     room for @p handle, otherwise the least recently released handle in
+   *     the pool, or @p handle if it could not be stored.
+   */
+  Handle* Push(Handle* handle, Clock::time_point now) {
+    auto const home = HomeSlot();
+    for (std::size_t i = 0; i != size_; ++i) {
+      auto& slot = slots_[(home + i) % size_];
+      if (!Claim(slot, kEmpty)) {
+        continue;
+      }
+      slot.handle = handle;
+      slot.released = now;
+      slot.state.store(kFull, std::memory_order_release);
+      return nullptr;
+    }
+    return ReplaceOldest(handle, now);
+  }
+
+  /**
+   * Get a handle from the pool, returns `nullptr` if the pool is empty.
+   *
+   * @param released set to the time when the handle was returned to the pool.
+   */
+  Handle* Pop(Clock::time_point& released) {
+    auto const home = HomeSlot();
+    for (std::size_t i = 0; i != size_; ++i) {
+      auto& slot = slots_[(home + i) % size_];
+      if (!Claim(slot, kFull)) {
+        continue;
+      }
+      return Take(slot, released);
+    }
+    return nullptr;
+  }
+
+  /**
+   * Remove the handles returned to the pool before @p deadline.
+   *
+   * @return the number of handles removed, each one is passed to @p cleanup.
+   */
+  template <typename Cleanup>
+  std::size_t EvictReleasedBefore(Clock::time_point deadline,
+                                  Cleanup&& cleanup) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i != size_; ++i) {
+      auto& slot = slots_[i];
+      if (!Claim(slot, kFull)) {
+        continue;
+      }
+      if (slot.released >= deadline) {
+        slot.state.store(kFull, std::memory_order_release);
+        continue;
+      }
+      Clock::time_point released;
+      cleanup(Take(slot, released));
+      ++count;
+    }
+    return count;
+  }
+
+  /// The number of handles in the pool, only approximate if in use.
+  std::size_t size() const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i != size_; ++i) {
+      if (slots_[i].state.load(std::memory_order_relaxed) != kEmpty) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+ private:
+  enum State { kEmpty, kBusy, kFull };
+
+  static std::size_t constexpr kCacheLineSize = 64;
+
+  struct alignas(kCacheLineSize) Slot {
+    std::atomic<int> state{kEmpty};
+    Handle* handle = nullptr;
+    Clock::time_point released;
+  };
+
+  static bool Claim(Slot& slot, int expected) {
+    // Check before the compare-and-swap, avoids taking the cache line in
+    // exclusive mode when the slot is not usable.
+    if (slot.state.load(std::memory_order_relaxed) != expected) {
+      return false;
+    }
+    return slot.state.compare_exchange_strong(expected, kBusy,
+                                              std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+  }
+
+  /// Empty a slot claimed by the caller.
+  Handle* Take(Slot& slot, Clock::time_point& released) {
+    Handle* handle = slot.handle;
+    released = slot.released;
+    slot.handle = nullptr;
+    slot.state.store(kEmpty, std::memory_order_release);
+    return handle;
+  }
+
+  Handle* ReplaceOldest(Handle* handle, Clock::time_point now) {
+    // Claim the oldest full slot seen so far, releasing any previous one.
+    // Other threads simply skip the claimed slots.
+    Slot* oldest = nullptr;
+    for (std::size_t i = 0; i != size_; ++i) {
+      auto& slot = slots_[i];
+      if (!Claim(slot, kFull)) {
+        continue;
+      }
+      if (oldest != nullptr && oldest->released <= slot.released) {
+        slot.state.store(kFull, std::memory_order_release);
+        continue;
+      }
+      if (oldest != nullptr) {
+        oldest->state.store(kFull, std::memory_order_release);
+      }
+      oldest = &slot;
+    }
+    if (oldest == nullptr) {
+      return handle;
+    }
+    Handle* evicted = oldest->handle;
+    oldest->handle = handle;
+    oldest->released = now;
+    oldest->state.store(kFull, std::memory_order_release);
+    return evicted;
+  }
+
+  static std::size_t HomeSlot() {
+    static thread_local std::size_t const home =
+        std::hash<std::thread::id>()(std::this_thread::get_id());
+    return home;
+  }
+
+  std::unique_ptr<char[]> storage_;
+  Slot* slots_;
+  std::size_t size_;
+};
+
 /**
  * Implements a CurlHandleFactory that pools handles.
  *
- * This implementation keeps up to N handles in memory, they are only released
- * when the factory is destructed.
+ * This implementation keeps up to N handles in memory, handles that remain
+ * unused for longer than the maximum idle time are released instead of reused.
+ * libcurl checks the connections in its cache before reusing them, so the
+ * pool does not check them. Creating and
+ * releasing handles does not acquire any locks, see `CurlHandlePool` for
+ * details.
  */
 class PooledCurlHandleFactory : public CurlHandleFactory {
  public:
-  explicit PooledCurlHandleFactory(std::size_t maximum_size);
+  explicit PooledCurlHandleFactory(
+      std::size_t maximum_size,
+      std::chrono::steady_clock::duration maximum_idle_time =
+          std::chrono::seconds(60));
   ~PooledCurlHandleFactory() override;
 
   CurlPtr CreateHandle() override;
@@ -92,11 +305,24 @@ class PooledCurlHandleFactory : public CurlHandleFactory {
     return last_client_ip_address_;
   }
 
+  /// Release the handles idle for longer than the maximum idle time.
+  std::size_t EvictIdleHandles();
+
+  std::size_t handle_count() const { return handles_.size(); }
+  std::size_t multi_handle_count() const { return multi_handles_.size(); }
+
  private:
-  std::size_t maximum_size_;
+  using Clock = std::chrono::steady_clock;
+
+  void MaybeEvictIdleHandles(Clock::time_point now);
+
+  std::chrono::steady_clock::duration maximum_idle_time_;
+  CurlHandlePool<CURL> handles_;
+  CurlHandlePool<CURLM> multi_handles_;
+  std::atomic<Clock::rep> next_eviction_;
+
+  // Only updated when the mutex is uncontended, the value is informational.
   mutable std::mutex mu_;
-  std::vector<CURL*> handles_;
-  std::vector<CURLM*> multi_handles_;
   std::string last_client_ip_address_;
 };
 
@@ -0,0 +1,209 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/curl_handle_factory.h"
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <future>
+#include <map>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+TEST(CurlHandlePoolTest, PushPop) {
+  CurlHandlePool<int> pool(2);
+  EXPECT_EQ(2U, pool.capacity());
+  EXPECT_EQ(0U, pool.size());
+
+  int a = 1;
+  int b = 2;
+  int c = 3;
+  auto const now = Clock::now();
+  EXPECT_EQ(nullptr, pool.Push(&a, now - std::chrono::seconds(2)));
+  EXPECT_EQ(nullptr, pool.Push(&b, now - std::chrono::seconds(1)));
+  // The pool is full, the oldest handle is replaced.
+  EXPECT_EQ(&a, pool.Push(&c, now));
+  EXPECT_EQ(2U, pool.size());
+
+  Clock::time_point released;
+  std::map<int*, Clock::time_point> actual;
+  auto* h = pool.Pop(released);
+  actual[h] = released;
+  h = pool.Pop(released);
+  actual[h] = released;
+  EXPECT_EQ(nullptr, pool.Pop(released));
+  EXPECT_EQ(0U, pool.size());
+  EXPECT_EQ((std::map<int*, Clock::time_point>{
+                {&b, now - std::chrono::seconds(1)}, {&c, now}}),
+            actual);
+}
+
+TEST(CurlHandlePoolTest, ReturnsLastReleasedFromSameThread) {
+  CurlHandlePool<int> pool(8);
+  int a = 1;
+  Clock::time_point released;
+  for (int i = 0; i != 3; ++i) {
+    ASSERT_EQ(nullptr, pool.Push(&a, Clock::now()));
+    EXPECT_EQ(&a, pool.Pop(released));
+  }
+}
+
+TEST(CurlHandlePoolTest, EvictReleasedBefore) {
+  CurlHandlePool<int> pool(4);
+  int old_handle = 1;
+  int new_handle = 2;
+  auto const now = Clock::now();
+  ASSERT_EQ(nullptr,
+            pool.Push(&old_handle, now - std::chrono::seconds(10)));
+  ASSERT_EQ(nullptr, pool.Push(&new_handle, now));
+
+  std::vector<int*> evicted;
+  auto count = pool.EvictReleasedBefore(
+      now - std::chrono::seconds(5),
+      [&evicted](int* h) { evicted.push_back(h); });
+  EXPECT_EQ(1U, count);
+  EXPECT_EQ(std::vector<int*>{&old_handle}, evicted);
+  EXPECT_EQ(1U, pool.size());
+  Clock::time_point released;
+  EXPECT_EQ(&new_handle, pool.Pop(released));
+}
+
+TEST(CurlHandlePoolTest, ConcurrentPushPop) {
+  int const thread_count = 8;
+  int const iterations = 1000;
+  CurlHandlePool<int> pool(thread_count / 2);
+  std::vector<int> values(thread_count * iterations);
+  std::atomic<int> in_use_errors{0};
+  std::vector<std::atomic<int>> in_use(values.size());
+
+  auto worker = [&](int id) {
+    for (int i = 0; i != iterations; ++i) {
+      Clock::time_point released;
+      int* h = pool.Pop(released);
+      if (h == nullptr) {
+        h = &values[id * iterations + i];
+      }
+      auto index = h - values.data();
+      if (in_use[index].fetch_add(1) != 0) {
+        ++in_use_errors;
+      }
+      in_use[index].fetch_sub(1);
+      (void)pool.Push(h, Clock::now());
+    }
+  };
+  std::vector<std::future<void>> tasks;
+  for (int i = 0; i != thread_count; ++i) {
+    tasks.push_back(std::async(std::launch::async, worker, i));
+  }
+  for (auto& t : tasks) {
+    t.get();
+  }
+  EXPECT_EQ(0, in_use_errors.load());
+  EXPECT_GE(pool.capacity(), pool.size());
+}
+
+TEST(PooledCurlHandleFactoryTest, ReusesHandles) {
+  PooledCurlHandleFactory factory(2);
+  auto handle = factory.CreateHandle();
+  ASSERT_NE(nullptr, handle.get());
+  auto* expected = handle.get();
+  factory.CleanupHandle(std::move(handle));
+  EXPECT_EQ(1U, factory.handle_count());
+
+  handle = factory.CreateHandle();
+  EXPECT_EQ(expected, handle.get());
+  EXPECT_EQ(0U, factory.handle_count());
+  factory.CleanupHandle(std::move(handle));
+
+  auto multi = factory.CreateMultiHandle();
+  ASSERT_NE(nullptr, multi.get());
+  auto* expected_multi = multi.get();
+  factory.CleanupMultiHandle(std::move(multi));
+  EXPECT_EQ(1U, factory.multi_handle_count());
+  multi = factory.CreateMultiHandle();
+  EXPECT_EQ(expected_multi, multi.get());
+}
+
+/// Create @p count handles and return them to @p factory.
+void Fill(PooledCurlHandleFactory& factory, int count) {
+  std::vector<CurlPtr> handles;
+  for (int i = 0; i != count; ++i) {
+    handles.push_back(factory.CreateHandle());
+  }
+  for (auto& h : handles) {
+    factory.CleanupHandle(std::move(h));
+  }
+}
+
+TEST(PooledCurlHandleFactoryTest, MaximumSize) {
+  PooledCurlHandleFactory factory(2);
+  std::vector<CurlPtr> handles;
+  for (int i = 0; i != 4; ++i) {
+    handles.push_back(factory.CreateHandle());
+  }
+  std::vector<CURL*> expected{handles[2].get(), handles[3].get()};
+  for (auto& h : handles) {
+    factory.CleanupHandle(std::move(h));
+    // Make sure the handles have different release times.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(2U, factory.handle_count());
+
+  // The pool keeps the most recently released handles.
+  std::vector<CURL*> actual;
+  for (int i = 0; i != 2; ++i) {
+    handles[i] = factory.CreateHandle();
+    actual.push_back(handles[i].get());
+  }
+  std::sort(expected.begin(), expected.end());
+  std::sort(actual.begin(), actual.end());
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(PooledCurlHandleFactoryTest, IdleHandlesAreNotReused) {
+  PooledCurlHandleFactory factory(4, std::chrono::seconds(0));
+  Fill(factory, 2);
+  // Any time passed since the handles were created makes them idle.
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  auto handle = factory.CreateHandle();
+  EXPECT_NE(nullptr, handle.get());
+  EXPECT_EQ(0U, factory.handle_count());
+}
+
+TEST(PooledCurlHandleFactoryTest, EvictIdleHandles) {
+  PooledCurlHandleFactory factory(4, std::chrono::milliseconds(50));
+  Fill(factory, 3);
+  EXPECT_EQ(3U, factory.handle_count());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(3U, factory.EvictIdleHandles());
+  EXPECT_EQ(0U, factory.handle_count());
+
+  PooledCurlHandleFactory long_idle(4, std::chrono::hours(1));
+  Fill(long_idle, 3);
+  EXPECT_EQ(0U, long_idle.EvictIdleHandles());
+  EXPECT_EQ(3U, long_idle.handle_count());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -22,6 +22,7 @@ inline namespace STORAGE_CLIENT_NS {
 namespace internal {
 namespace {
 
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 
 TEST(CurlHandleTest, AsStatus) {
@@ -55,6 +56,56 @@ TEST(CurlHandleTest, AsStatus) {
   }
 }
 
+TEST(CurlHandleTest, AppendUrlEscapedMatchesCurl) {
+  std::string all_bytes;
+  for (int c = 0; c != 256; ++c) {
+    all_bytes.push_back(static_cast<char>(c));
+  }
+  CurlHandle handle;
+  for (std::string const& input :
+       {std::string{}, std::string("abc-XYZ_0.9~"), std::string("a b/c?d=e&f"),
+        std::string("\xc3\xa9t\xc3\xa9"), all_bytes}) {
+    std::string actual = "prefix?";
+    AppendUrlEscaped(actual, input);
+    EXPECT_EQ("prefix?" + std::string(handle.MakeEscapedString(input).get()),
+              actual);
+  }
+}
+
+std::vector<std::string> HeaderValues(CurlHeaderList const& list) {
+  std::vector<std::string> values;
+  for (auto const* h = list.get(); h != nullptr; h = h->next) {
+    values.emplace_back(h->data);
+  }
+  return values;
+}
+
+TEST(CurlHandleTest, CurlHeaderListSharesCommonHeaders) {
+  auto common = MakeSharedCurlHeaders({"authorization: a", "x-common: c"});
+
+  CurlHeaderList first;
+  first.Append("x-first: 1");
+  first.SetShared(common);
+  first.Append("x-first: 2");
+  CurlHeaderList second;
+  second.SetShared(common);
+  EXPECT_EQ(common.get(), second.get());
+
+  EXPECT_THAT(HeaderValues(first), ElementsAre("x-first: 1", "x-first: 2",
+                                               "authorization: a",
+                                               "x-common: c"));
+  EXPECT_THAT(HeaderValues(second),
+              ElementsAre("authorization: a", "x-common: c"));
+
+  // Releasing a list does not release the shared headers.
+  CurlHeaderList moved(std::move(first));
+  first = CurlHeaderList{};
+  EXPECT_EQ(nullptr, first.get());
+  moved = CurlHeaderList{};
+  EXPECT_THAT(HeaderValues(second),
+              ElementsAre("authorization: a", "x-common: c"));
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
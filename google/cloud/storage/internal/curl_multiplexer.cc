@@ -0,0 +1,221 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/curl_multiplexer.h"
+#include "google/cloud/storage/internal/curl_handle.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+// `curl_multi_poll()` and `curl_multi_wakeup()` were introduced in libcurl
+// 7.68.0. With older versions the driving thread waits for shorter periods, so
+// new transfers are not delayed for too long.
+#if LIBCURL_VERSION_NUM >= 0x074400
+int const kWaitTimeoutMs = 1000;
+#else
+int const kWaitTimeoutMs = 5;
+#endif  // LIBCURL_VERSION_NUM >= 0x074400
+
+Status AsStatus(CURLMcode result, char const* where) {
+  if (result == CURLM_OK) {
+    return Status();
+  }
+  std::ostringstream os;
+  os << where << "(): unexpected error code in curl_multi_*, [" << result
+     << "]=" << curl_multi_strerror(result);
+  return Status(StatusCode::kUnknown, std::move(os).str());
+}
+}  // namespace
+
+CurlMultiplexer::CurlMultiplexer(std::size_t maximum_connections, bool http2)
+    : multi_(curl_multi_init(), &curl_multi_cleanup), http2_(http2) {
+  if (http2_) {
+    (void)curl_multi_setopt(multi_.get(), CURLMOPT_PIPELINING,
+                            CURLPIPE_MULTIPLEX);
+  }
+  if (maximum_connections != 0) {
+    (void)curl_multi_setopt(multi_.get(), CURLMOPT_MAX_HOST_CONNECTIONS,
+                            static_cast<long>(maximum_connections));
+  }
+}
+
+Status CurlMultiplexer::Perform(CURL* handle, TokenBucket* requests) {
+  std::unique_lock<std::mutex> lk(mu_);
+  pending_.emplace_back(handle, requests);
+  Wakeup();
+  for (;;) {
+    auto loc = completed_.find(handle);
+    if (loc != completed_.end()) {
+      auto status = std::move(loc->second);
+      completed_.erase(loc);
+      return status;
+    }
+    if (driving_) {
+      cv_.wait(lk);
+      continue;
+    }
+    driving_ = true;
+    std::vector<Limited> pending;
+    pending.swap(pending_);
+    lk.unlock();
+    auto done = DriveOnce(std::move(pending));
+    lk.lock();
+    driving_ = false;
+    completed_count_ += done.size();
+    for (auto& d : done) {
+      completed_[d.first] = std::move(d.second);
+    }
+    cv_.notify_all();
+  }
+}
+
+void CurlMultiplexer::Throttle(CURL* handle, TokenBucket* limiter) {
+  throttled_.emplace_back(handle, limiter);
+}
+
+CurlMultiplexer::Completed CurlMultiplexer::DriveOnce(
+    std::vector<Limited> pending) {
+  Completed done;
+  waiting_.insert(waiting_.end(), pending.begin(), pending.end());
+  StartWaiting(done);
+  ResumeThrottled(done);
+
+  auto collect = [this, &done] {
+    int remaining;
+    while (auto* msg = curl_multi_info_read(multi_.get(), &remaining)) {
+      if (msg->msg != CURLMSG_DONE) {
+        continue;
+      }
+      Abort(msg->easy_handle,
+            CurlHandle::AsStatus(msg->data.result, "Perform"), done);
+    }
+  };
+
+  int running;
+  auto e = curl_multi_perform(multi_.get(), &running);
+  if (e != CURLM_OK) {
+    // There is no way to tell which transfers are affected, fail all of them.
+    auto active = active_;
+    for (auto* h : active) {
+      Abort(h, AsStatus(e, __func__), done);
+    }
+    return done;
+  }
+  collect();
+  if (!done.empty()) {
+    return done;
+  }
+  if (running == 0 && waiting_.empty() && throttled_.empty()) {
+    return done;
+  }
+  auto const timeout_ms = WaitTimeoutMs();
+#if LIBCURL_VERSION_NUM >= 0x074400
+  (void)curl_multi_poll(multi_.get(), nullptr, 0, timeout_ms, nullptr);
+#else
+  // Without any transfers `curl_multi_wait()` returns immediately.
+  if (running == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+  } else {
+    (void)curl_multi_wait(multi_.get(), nullptr, 0, timeout_ms, nullptr);
+  }
+#endif  // LIBCURL_VERSION_NUM >= 0x074400
+  e = curl_multi_perform(multi_.get(), &running);
+  if (e == CURLM_OK) {
+    collect();
+  }
+  return done;
+}
+
+void CurlMultiplexer::StartWaiting(Completed& done) {
+  std::vector<Limited> waiting;
+  waiting.swap(waiting_);
+  for (auto const& w : waiting) {
+    if (w.second != nullptr && !w.second->TryConsume(1)) {
+      waiting_.push_back(w);
+      continue;
+    }
+    auto e = curl_multi_add_handle(multi_.get(), w.first);
+    if (e != CURLM_OK) {
+      done.emplace_back(w.first, AsStatus(e, __func__));
+      continue;
+    }
+    active_.push_back(w.first);
+  }
+}
+
+void CurlMultiplexer::ResumeThrottled(Completed& done) {
+  std::vector<Limited> throttled;
+  throttled.swap(throttled_);
+  for (auto const& t : throttled) {
+    if (t.second->WaitTime().count() != 0) {
+      throttled_.push_back(t);
+      continue;
+    }
+    // Resuming runs the transfer callbacks, which may call `Throttle()` again.
+    auto e = curl_easy_pause(t.first, CURLPAUSE_CONT);
+    if (e != CURLE_OK) {
+      Abort(t.first, CurlHandle::AsStatus(e, __func__), done);
+    }
+  }
+}
+
+void CurlMultiplexer::Abort(CURL* handle, Status status, Completed& done) {
+  (void)curl_multi_remove_handle(multi_.get(), handle);
+  active_.erase(std::remove(active_.begin(), active_.end(), handle),
+                active_.end());
+  throttled_.erase(
+      std::remove_if(throttled_.begin(), throttled_.end(),
+                     [handle](Limited const& t) { return t.first == handle; }),
+      throttled_.end());
+  done.emplace_back(handle, std::move(status));
+}
+
+int CurlMultiplexer::WaitTimeoutMs() const {
+  std::chrono::milliseconds timeout(kWaitTimeoutMs);
+  auto update = [&timeout](TokenBucket* limiter) {
+    if (limiter == nullptr) {
+      return;
+    }
+    // Round up, waking up before the limiter has tokens is wasted work.
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        limiter->WaitTime() + std::chrono::microseconds(999));
+    timeout = (std::min)(timeout, wait);
+  };
+  for (auto const& w : waiting_) {
+    update(w.second);
+  }
+  for (auto const& t : throttled_) {
+    update(t.second);
+  }
+  return static_cast<int>(timeout.count());
+}
+
+void CurlMultiplexer::Wakeup() {
+#if LIBCURL_VERSION_NUM >= 0x074400
+  (void)curl_multi_wakeup(multi_.get());
+#endif  // LIBCURL_VERSION_NUM >= 0x074400
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
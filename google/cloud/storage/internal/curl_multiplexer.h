@@ -0,0 +1,140 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_MULTIPLEXER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_MULTIPLEXER_H_
+
+#include "google/cloud/status.h"
+#include "google/cloud/storage/internal/curl_wrappers.h"
+#include "google/cloud/storage/internal/token_bucket.h"
+#include "google/cloud/storage/version.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Runs the transfers of many threads over a single multi handle.
+ *
+ * Transfers in the same multi handle can share HTTP/2 connections, each
+ * connection carries many concurrent requests as separate streams. With
+ * `curl_easy_perform()` each transfer uses a separate multi handle, and
+ * therefore a separate connection.
+ *
+ * Multi handles are not thread-safe. The threads waiting for their transfers
+ * take turns driving the multi handle: one thread at a time adds any new
+ * transfers, calls `curl_multi_perform()`, waits for activity, and records the
+ * completed transfers. The other threads wait on a condition variable until
+ * their transfer completes, or until they can drive the multi handle.
+ *
+ * The multiplexer also runs the transfers subject to a rate limit. A transfer
+ * over a bandwidth limit pauses itself from its callbacks, and the driving
+ * thread resumes it as soon as the limiter has tokens. The driving thread
+ * never sleeps waiting for tokens, it waits for activity in the other
+ * transfers, with a timeout to resume the throttled ones.
+ */
+class CurlMultiplexer {
+ public:
+  /**
+   * Creates a multiplexer.
+   *
+   * @param maximum_connections the maximum number of connections to each
+   *     host, zero for no limit.
+   * @param http2 if true, the transfers share HTTP/2 connections. Otherwise
+   *     the multiplexer is only used to run throttled transfers.
+   */
+  explicit CurlMultiplexer(std::size_t maximum_connections, bool http2 = true);
+  ~CurlMultiplexer() = default;
+
+  CurlMultiplexer(CurlMultiplexer const&) = delete;
+  CurlMultiplexer& operator=(CurlMultiplexer const&) = delete;
+
+  /// Returns true if the transfers share HTTP/2 connections.
+  bool http2() const { return http2_; }
+
+  /**
+   * Run the transfer configured in @p handle, blocks until it completes.
+   *
+   * @param requests if not null, the transfer starts once this limiter has a
+   *     token. The token is consumed when the transfer starts.
+   */
+  Status Perform(CURL* handle, TokenBucket* requests = nullptr);
+
+  /**
+   * Resume @p handle once @p limiter has tokens.
+   *
+   * Transfers call this from their libcurl callbacks, just before they pause
+   * themselves with `CURL_READFUNC_PAUSE` or `CURL_WRITEFUNC_PAUSE`. The
+   * callbacks run in the thread driving the multi handle, so no locking is
+   * needed.
+   */
+  void Throttle(CURL* handle, TokenBucket* limiter);
+
+  /// The number of transfers completed by this multiplexer.
+  std::size_t completed_count() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return completed_count_;
+  }
+
+ private:
+  using Limited = std::pair<CURL*, TokenBucket*>;
+  using Completed = std::vector<std::pair<CURL*, Status>>;
+
+  /// Add the pending transfers and make progress on all of them.
+  Completed DriveOnce(std::vector<Limited> pending);
+
+  /// Add the waiting transfers that are not over the request rate limit.
+  void StartWaiting(Completed& done);
+
+  /// Resume the throttled transfers whose limiters have tokens.
+  void ResumeThrottled(Completed& done);
+
+  /// Remove @p handle from the multi handle, and mark it as completed.
+  void Abort(CURL* handle, Status status, Completed& done);
+
+  /// How long to wait for activity before the next limiter has tokens.
+  int WaitTimeoutMs() const;
+
+  /// Interrupt the thread driving the multi handle, if it is waiting.
+  void Wakeup();
+
+  CurlMulti multi_;
+  bool const http2_;
+  // Only used by the thread driving the multi handle.
+  std::vector<CURL*> active_;
+  // The transfers over the request rate limit, not yet added to `multi_`.
+  std::vector<Limited> waiting_;
+  // The paused transfers and the limiter that paused each one.
+  std::vector<Limited> throttled_;
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  bool driving_ = false;               // GUARDED_BY(mu_)
+  std::vector<Limited> pending_;       // GUARDED_BY(mu_)
+  std::map<CURL*, Status> completed_;  // GUARDED_BY(mu_)
+  std::size_t completed_count_ = 0;    // GUARDED_BY(mu_)
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_MULTIPLEXER_H_
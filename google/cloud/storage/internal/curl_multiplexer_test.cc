@@ -0,0 +1,221 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/curl_multiplexer.h"
+#include "google/cloud/internal/random.h"
+#include "google/cloud/storage/testing/loopback_listener.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#if _WIN32
+#else
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+extern "C" std::size_t AppendToString(char* ptr, std::size_t size,
+                                      std::size_t nmemb, void* userdata) {
+  auto* buffer = static_cast<std::string*>(userdata);
+  buffer->append(ptr, size * nmemb);
+  return size * nmemb;
+}
+
+// The multiplexer works with any protocol, using `file://` URLs avoids the
+// need for a server in these tests.
+class CurlMultiplexerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    filename_ = ::testing::TempDir() + "curl-multiplexer-" +
+                google::cloud::internal::Sample(
+                    generator_, 8, "abcdefghijklmnopqrstuvwxyz0123456789");
+    std::ofstream(filename_) << kContents;
+  }
+
+  void TearDown() override { std::remove(filename_.c_str()); }
+
+  /// Create a handle that downloads @p path into @p buffer.
+  static CurlPtr MakeHandle(std::string const& path, std::string& buffer) {
+    CurlPtr handle(curl_easy_init(), &curl_easy_cleanup);
+    auto const url = "file://" + path;
+    (void)curl_easy_setopt(handle.get(), CURLOPT_URL, url.c_str());
+    (void)curl_easy_setopt(handle.get(), CURLOPT_WRITEFUNCTION,
+                           &AppendToString);
+    (void)curl_easy_setopt(handle.get(), CURLOPT_WRITEDATA, &buffer);
+    return handle;
+  }
+
+  std::string const kContents = "The quick brown fox jumps over the lazy dog";
+  std::string filename_;
+  google::cloud::internal::DefaultPRNG generator_ =
+      google::cloud::internal::MakeDefaultPRNG();
+};
+
+TEST_F(CurlMultiplexerTest, Simple) {
+  CurlMultiplexer multiplexer(2);
+  std::string buffer;
+  auto handle = MakeHandle(filename_, buffer);
+  ASSERT_STATUS_OK(multiplexer.Perform(handle.get()));
+  EXPECT_EQ(kContents, buffer);
+  EXPECT_EQ(1U, multiplexer.completed_count());
+
+  // The same handle can be used again.
+  buffer.clear();
+  ASSERT_STATUS_OK(multiplexer.Perform(handle.get()));
+  EXPECT_EQ(kContents, buffer);
+  EXPECT_EQ(2U, multiplexer.completed_count());
+}
+
+TEST_F(CurlMultiplexerTest, Error) {
+  CurlMultiplexer multiplexer(2);
+  std::string buffer;
+  auto handle = MakeHandle(filename_ + "-does-not-exist", buffer);
+  auto status = multiplexer.Perform(handle.get());
+  EXPECT_FALSE(status.ok());
+  EXPECT_THAT(status.message(), ::testing::HasSubstr("CURL error"));
+}
+
+TEST_F(CurlMultiplexerTest, ManyThreads) {
+  CurlMultiplexer multiplexer(2);
+  int const thread_count = 8;
+  int const iterations = 50;
+  auto worker = [&] {
+    int errors = 0;
+    for (int i = 0; i != iterations; ++i) {
+      std::string buffer;
+      auto handle = MakeHandle(filename_, buffer);
+      auto status = multiplexer.Perform(handle.get());
+      if (!status.ok() || buffer != kContents) {
+        ++errors;
+      }
+    }
+    return errors;
+  };
+  std::vector<std::future<int>> tasks;
+  for (int i = 0; i != thread_count; ++i) {
+    tasks.push_back(std::async(std::launch::async, worker));
+  }
+  for (auto& t : tasks) {
+    EXPECT_EQ(0, t.get());
+  }
+  EXPECT_EQ(static_cast<std::size_t>(thread_count * iterations),
+            multiplexer.completed_count());
+}
+
+TEST_F(CurlMultiplexerTest, RequestRateLimit) {
+  CurlMultiplexer multiplexer(0, false);
+  // The first two requests start immediately, and then one every 50ms.
+  TokenBucket requests(20, 1);
+  int const thread_count = 4;
+  auto start = std::chrono::steady_clock::now();
+  auto worker = [&] {
+    std::string buffer;
+    auto handle = MakeHandle(filename_, buffer);
+    auto status = multiplexer.Perform(handle.get(), &requests);
+    return status.ok() && buffer == kContents;
+  };
+  std::vector<std::future<bool>> tasks;
+  for (int i = 0; i != thread_count; ++i) {
+    tasks.push_back(std::async(std::launch::async, worker));
+  }
+  for (auto& t : tasks) {
+    EXPECT_TRUE(t.get());
+  }
+  EXPECT_LE(std::chrono::milliseconds(90),
+            std::chrono::steady_clock::now() - start);
+}
+
+#if !_WIN32
+/// The state for a transfer paused by a bandwidth limiter.
+struct ThrottledDownload {
+  CurlMultiplexer* multiplexer;
+  TokenBucket* limiter;
+  CURL* handle;
+  std::string buffer;
+  int throttled_count;
+};
+
+extern "C" std::size_t ThrottledAppend(char* ptr, std::size_t size,
+                                       std::size_t nmemb, void* userdata) {
+  auto* download = static_cast<ThrottledDownload*>(userdata);
+  if (!download->limiter->TryConsume(size * nmemb)) {
+    ++download->throttled_count;
+    download->multiplexer->Throttle(download->handle, download->limiter);
+    return CURL_WRITEFUNC_PAUSE;
+  }
+  download->buffer.append(ptr, size * nmemb);
+  return size * nmemb;
+}
+
+TEST_F(CurlMultiplexerTest, ResumesThrottledTransfers) {
+  // Local files cannot be paused, use a HTTP server.
+  testing::LoopbackListener listener;
+  ASSERT_TRUE(listener.ok());
+  std::string const contents(64 * 1024, 'x');
+  auto server = std::async(std::launch::async, [&listener, &contents] {
+    int connection = listener.Accept();
+    std::string request;
+    char buffer[4096];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+      auto n = ::read(connection, buffer, sizeof(buffer));
+      if (n <= 0) {
+        break;
+      }
+      request.append(buffer, static_cast<std::size_t>(n));
+    }
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+                           std::to_string(contents.size()) + "\r\n\r\n" +
+                           contents;
+    (void)::write(connection, response.data(), response.size());
+    return connection;
+  });
+
+  CurlMultiplexer multiplexer(0, false);
+  // Receiving the data after the first block takes at least 150ms.
+  TokenBucket limiter(320 * 1024, 1);
+  CurlPtr handle(curl_easy_init(), &curl_easy_cleanup);
+  ThrottledDownload download{&multiplexer, &limiter, handle.get(), {}, 0};
+  auto const url = listener.endpoint() + "/";
+  (void)curl_easy_setopt(handle.get(), CURLOPT_URL, url.c_str());
+  (void)curl_easy_setopt(handle.get(), CURLOPT_BUFFERSIZE, 16 * 1024L);
+  (void)curl_easy_setopt(handle.get(), CURLOPT_WRITEFUNCTION,
+                         &ThrottledAppend);
+  (void)curl_easy_setopt(handle.get(), CURLOPT_WRITEDATA, &download);
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_STATUS_OK(multiplexer.Perform(handle.get()));
+  EXPECT_LE(std::chrono::milliseconds(140),
+            std::chrono::steady_clock::now() - start);
+  EXPECT_EQ(contents, download.buffer);
+  EXPECT_LE(1, download.throttled_count);
+
+  handle.reset();
+  ::close(server.get());
+}
+#endif  // !_WIN32
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
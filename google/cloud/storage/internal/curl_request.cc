@@ -13,21 +13,59 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/curl_request.h"
+#include "google/cloud/log.h"
+#include "google/cloud/storage/transfer_metrics.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 namespace google {
 namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
-CurlRequest::CurlRequest() : headers_(nullptr, &curl_slist_free_all) {}
+CurlRequest::CurlRequest() = default;
 
 StatusOr<HttpResponse> CurlRequest::MakeRequest(std::string const& payload) {
-  if (!payload.empty()) {
+  bool const throttle_upload = limiters_.upload_bytes && multiplexer_;
+  std::size_t offset = 0;
+  if (!payload.empty() && throttle_upload) {
+    // Send the payload from a callback, which can pause the transfer.
+    handle_.SetOption(CURLOPT_POST, 1L);
+    handle_.SetOption(CURLOPT_POSTFIELDSIZE_LARGE,
+                      static_cast<curl_off_t>(payload.size()));
+    handle_.SetReaderCallback([this, &payload, &offset](
+                                  char* ptr, std::size_t size,
+                                  std::size_t nmemb) -> std::size_t {
+      auto n = (std::min)(size * nmemb, payload.size() - offset);
+      if (n == 0) {
+        return 0;
+      }
+      if (!AcquireTokens(limiters_.upload_bytes, n)) {
+        return CURL_READFUNC_PAUSE;
+      }
+      std::memcpy(ptr, payload.data() + offset, n);
+      offset += n;
+      return n;
+    });
+  } else if (!payload.empty()) {
     handle_.SetOption(CURLOPT_POSTFIELDSIZE, payload.length());
     handle_.SetOption(CURLOPT_POSTFIELDS, payload.c_str());
   }
-  auto status = handle_.EasyPerform();
+  if (!multiplexer_ && limiters_.requests) {
+    // Nothing else runs in this thread, wait for the request token here.
+    std::this_thread::sleep_for(limiters_.requests->Reserve(1));
+  }
+  auto status = multiplexer_ ? multiplexer_->Perform(handle_.handle_.get(),
+                                                     limiters_.requests.get())
+                             : handle_.EasyPerform();
+  if (!payload.empty() && throttle_upload) {
+    handle_.ResetReaderCallback();
+  }
+  ReportTransferMetrics(status);
+  TraceCompleted(status);
+  SetLastHttpStatusCode(0);
   if (!status.ok()) {
     return status;
   }
@@ -36,17 +74,60 @@ StatusOr<HttpResponse> CurlRequest::MakeRequest(std::string const& payload) {
   if (!code.ok()) {
     return std::move(code).status();
   }
+  SetLastHttpStatusCode(*code);
   return HttpResponse{code.value(), std::move(response_payload_),
                       std::move(received_headers_)};
 }
 
+void CurlRequest::ReportTransferMetrics(Status const& status) {
+  if (!metrics_hook_) {
+    return;
+  }
+  metrics_hook_->OnTransfer(CollectTransferMetrics(status));
+}
+
+void CurlRequest::TraceCompleted(Status const& status) {
+  // Sampled requests are already traced in full.
+  if (logging_enabled_ || !sampler_ || !sampler_->traces_completed()) {
+    return;
+  }
+  auto metrics = CollectTransferMetrics(status);
+  auto const failed = !status.ok() || metrics.status_code >= 400;
+  if (!sampler_->TraceCompleted(failed, metrics.total_time)) {
+    return;
+  }
+  GCP_LOG(INFO) << "MakeRequest() >> " << metrics;
+}
+
+TransferMetrics CurlRequest::CollectTransferMetrics(Status const& status) {
+  TransferMetrics metrics = metrics_;
+  metrics.status = status;
+  auto code = handle_.GetResponseCode();
+  metrics.status_code = code.ok() ? *code : 0;
+  handle_.CollectTransferMetrics(metrics);
+  return metrics;
+}
+
+bool CurlRequest::AcquireTokens(std::shared_ptr<TokenBucket> const& limiter,
+                                std::size_t count) {
+  // Without a multiplexer there is no way to resume a paused transfer.
+  if (!limiter || !multiplexer_ || limiter->TryConsume(count)) {
+    return true;
+  }
+  multiplexer_->Throttle(handle_.handle_.get(), limiter.get());
+  return false;
+}
+
 void CurlRequest::ResetOptions() {
   handle_.SetOption(CURLOPT_URL, url_.c_str());
   handle_.SetOption(CURLOPT_HTTPHEADER, headers_.get());
   handle_.SetOption(CURLOPT_USERAGENT, user_agent_.c_str());
   handle_.SetOption(CURLOPT_NOSIGNAL, 1);
   handle_.SetWriterCallback(
-      [this](void* ptr, std::size_t size, std::size_t nmemb) {
+      [this](void* ptr, std::size_t size, std::size_t nmemb) -> std::size_t {
+        if (!AcquireTokens(limiters_.download_bytes, size * nmemb)) {
+          return CURL_WRITEFUNC_PAUSE;
+        }
         response_payload_.append(static_cast<char*>(ptr), size * nmemb);
         return size * nmemb;
       });
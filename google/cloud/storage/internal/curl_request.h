@@ -17,7 +17,10 @@
 
 #include "google/cloud/storage/internal/curl_handle.h"
 #include "google/cloud/storage/internal/curl_handle_factory.h"
+#include "google/cloud/storage/internal/curl_multiplexer.h"
 #include "google/cloud/storage/internal/http_response.h"
+#include "google/cloud/storage/internal/token_bucket.h"
+#include "google/cloud/storage/internal/tracing_sampler.h"
 #include "google/cloud/storage/version.h"
 
 namespace google {
@@ -50,8 +53,13 @@ class CurlRequest {
         response_payload_(std::move(rhs.response_payload_)),
         received_headers_(std::move(rhs.received_headers_)),
         logging_enabled_(rhs.logging_enabled_),
+        sampler_(std::move(rhs.sampler_)),
         handle_(std::move(rhs.handle_)),
-        factory_(std::move(rhs.factory_)) {
+        factory_(std::move(rhs.factory_)),
+        multiplexer_(std::move(rhs.multiplexer_)),
+        metrics_hook_(std::move(rhs.metrics_hook_)),
+        metrics_(std::move(rhs.metrics_)),
+        limiters_(std::move(rhs.limiters_)) {
     ResetOptions();
   }
 
@@ -62,8 +70,13 @@ class CurlRequest {
     response_payload_ = std::move(rhs.response_payload_);
     received_headers_ = std::move(rhs.received_headers_);
     logging_enabled_ = rhs.logging_enabled_;
+    sampler_ = std::move(rhs.sampler_);
     handle_ = std::move(rhs.handle_);
     factory_ = std::move(rhs.factory_);
+    multiplexer_ = std::move(rhs.multiplexer_);
+    metrics_hook_ = std::move(rhs.metrics_hook_);
+    metrics_ = std::move(rhs.metrics_);
+    limiters_ = std::move(rhs.limiters_);
 
     ResetOptions();
     return *this;
@@ -84,14 +97,39 @@ class CurlRequest {
   friend class CurlRequestBuilder;
   void ResetOptions();
 
+  /// Report the metrics for the last attempt, if there is a hook installed.
+  void ReportTransferMetrics(Status const& status);
+
+  /// Log a summary of the last attempt, if `sampler_` selects it.
+  void TraceCompleted(Status const& status);
+
+  /// Collect the metrics for the last attempt.
+  TransferMetrics CollectTransferMetrics(Status const& status);
+
+  /**
+   * Consumes @p count tokens from @p limiter, if it is not null.
+   *
+   * @return false if the transfer must pause, the multiplexer resumes it
+   *     once @p limiter has tokens.
+   */
+  bool AcquireTokens(std::shared_ptr<TokenBucket> const& limiter,
+                     std::size_t count);
+
   std::string url_;
-  CurlHeaders headers_;
+  CurlHeaderList headers_;
   std::string user_agent_;
   std::string response_payload_;
   CurlReceivedHeaders received_headers_;
   bool logging_enabled_;
+  // Selects the requests traced after they complete, null if HTTP tracing is
+  // disabled. Only used if `logging_enabled_` is false.
+  std::shared_ptr<TracingSampler> sampler_;
   CurlHandle handle_;
   std::shared_ptr<CurlHandleFactory> factory_;
+  std::shared_ptr<CurlMultiplexer> multiplexer_;
+  std::shared_ptr<TransferMetricsHook> metrics_hook_;
+  TransferMetrics metrics_;
+  RateLimiters limiters_;
 };
 
 }  // namespace internal
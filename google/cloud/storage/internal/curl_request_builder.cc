@@ -15,6 +15,7 @@
 #include "google/cloud/storage/internal/curl_request_builder.h"
 #include "google/cloud/internal/build_info.h"
 #include "google/cloud/storage/version.h"
+#include <algorithm>
 
 namespace google {
 namespace cloud {
@@ -30,21 +31,31 @@ CurlRequestBuilder::CurlRequestBuilder(
     std::string base_url, std::shared_ptr<CurlHandleFactory> factory)
     : factory_(std::move(factory)),
       handle_(factory_->CreateHandle()),
-      headers_(nullptr, &curl_slist_free_all),
       url_(std::move(base_url)),
       query_parameter_separator_("?"),
       logging_enabled_(false),
-      initial_buffer_size_(GOOGLE_CLOUD_CPP_STORAGE_INITIAL_BUFFER_SIZE) {}
+      initial_buffer_size_(GOOGLE_CLOUD_CPP_STORAGE_INITIAL_BUFFER_SIZE),
+      max_write_size_(CURL_MAX_WRITE_SIZE),
+      maximum_connections_(0) {}
 
 CurlRequest CurlRequestBuilder::BuildRequest() {
   ValidateBuilderState(__func__);
   CurlRequest request;
   request.url_ = std::move(url_);
   request.headers_ = std::move(headers_);
-  request.user_agent_ = user_agent_prefix_ + UserAgentSuffix();
+  request.user_agent_ = MakeUserAgent();
   request.handle_ = std::move(handle_);
   request.factory_ = std::move(factory_);
+  request.multiplexer_ = std::move(multiplexer_);
+  request.metrics_hook_ = std::move(metrics_hook_);
+  request.metrics_ = std::move(metrics_);
+  if (request.metrics_hook_ || sampler_) {
+    // Only the metrics and the traces use a copy of the URL.
+    request.metrics_.url = request.url_;
+  }
+  request.limiters_ = std::move(limiters_);
   request.logging_enabled_ = logging_enabled_;
+  request.sampler_ = std::move(sampler_);
   request.ResetOptions();
   return request;
 }
@@ -55,46 +66,75 @@ CurlDownloadRequest CurlRequestBuilder::BuildDownloadRequest(
   CurlDownloadRequest request;
   request.url_ = std::move(url_);
   request.headers_ = std::move(headers_);
-  request.user_agent_ = user_agent_prefix_ + UserAgentSuffix();
+  request.user_agent_ = MakeUserAgent();
   request.payload_ = std::move(payload);
   request.handle_ = std::move(handle_);
   request.multi_ = factory_->CreateMultiHandle();
+  if (maximum_connections_ != 0) {
+    (void)curl_multi_setopt(request.multi_.get(), CURLMOPT_MAXCONNECTS,
+                            maximum_connections_);
+  }
   request.factory_ = factory_;
+  request.metrics_hook_ = std::move(metrics_hook_);
+  request.metrics_ = std::move(metrics_);
+  if (request.metrics_hook_) {
+    request.metrics_.url = request.url_;
+  }
+  request.limiters_ = std::move(limiters_);
+  request.spill_ = AcquireBuffer(buffer_pool_.get(), max_write_size_);
+  request.buffer_pool_ = std::move(buffer_pool_);
   request.logging_enabled_ = logging_enabled_;
   request.SetOptions();
   return request;
 }
 
+CurlHandle CurlRequestBuilder::BuildPrewarmHandle() {
+  ValidateBuilderState(__func__);
+  handle_.SetOption(CURLOPT_URL, url_.c_str());
+  handle_.SetOption(CURLOPT_USERAGENT, MakeUserAgent().c_str());
+  handle_.SetOption(CURLOPT_NOBODY, 1L);
+  handle_.SetOption(CURLOPT_NOSIGNAL, 1L);
+  return std::move(handle_);
+}
+
 CurlRequestBuilder& CurlRequestBuilder::AddUserAgentPrefix(
     std::string const& prefix) {
   ValidateBuilderState(__func__);
-  user_agent_prefix_ = prefix + user_agent_prefix_;
+  if (!prefix.empty()) {
+    user_agent_prefix_.insert(0, prefix);
+  }
   return *this;
 }
 
 CurlRequestBuilder& CurlRequestBuilder::AddHeader(std::string const& header) {
   ValidateBuilderState(__func__);
-  auto new_header = curl_slist_append(headers_.get(), header.c_str());
-  (void)headers_.release();
-  headers_.reset(new_header);
+  headers_.Append(header);
+  return *this;
+}
+
+CurlRequestBuilder& CurlRequestBuilder::SetCommonHeaders(
+    std::shared_ptr<curl_slist> headers) {
+  ValidateBuilderState(__func__);
+  headers_.SetShared(std::move(headers));
   return *this;
 }
 
 CurlRequestBuilder& CurlRequestBuilder::AddQueryParameter(
     std::string const& key, std::string const& value) {
   ValidateBuilderState(__func__);
-  std::string parameter = query_parameter_separator_;
-  parameter += handle_.MakeEscapedString(key).get();
-  parameter += "=";
-  parameter += handle_.MakeEscapedString(value).get();
+  // Escape directly into the URL, this avoids allocating temporary strings.
+  url_ += query_parameter_separator_;
+  AppendUrlEscaped(url_, key);
+  url_ += '=';
+  AppendUrlEscaped(url_, value);
   query_parameter_separator_ = "&";
-  url_.append(parameter);
   return *this;
 }
 
 CurlRequestBuilder& CurlRequestBuilder::SetMethod(std::string const& method) {
   ValidateBuilderState(__func__);
   handle_.SetOption(CURLOPT_CUSTOMREQUEST, method.c_str());
+  metrics_.method = method;
   return *this;
 }
 
@@ -109,13 +149,135 @@ CurlRequestBuilder& CurlRequestBuilder::SetDebugLogging(bool enabled) {
   return *this;
 }
 
+CurlRequestBuilder& CurlRequestBuilder::SetTracingSampler(
+    std::shared_ptr<TracingSampler> sampler) {
+  ValidateBuilderState(__func__);
+  logging_enabled_ = sampler->Sample();
+  sampler_ = std::move(sampler);
+  return *this;
+}
+
 CurlRequestBuilder& CurlRequestBuilder::SetInitialBufferSize(std::size_t size) {
   ValidateBuilderState(__func__);
   initial_buffer_size_ = size;
   return *this;
 }
 
-std::string CurlRequestBuilder::UserAgentSuffix() const {
+CurlRequestBuilder& CurlRequestBuilder::SetMultiplexer(
+    std::shared_ptr<CurlMultiplexer> multiplexer) {
+  ValidateBuilderState(__func__);
+  if (!multiplexer) {
+    return *this;
+  }
+  if (!multiplexer->http2()) {
+    multiplexer_ = std::move(multiplexer);
+    return *this;
+  }
+#if LIBCURL_VERSION_NUM >= 0x073100
+  // Without TLS there is no protocol negotiation, plain text endpoints are
+  // assumed to support HTTP/2.
+  if (url_.compare(0, 7, "http://") == 0) {
+    handle_.SetOption(CURLOPT_HTTP_VERSION,
+                      static_cast<long>(CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE));
+  } else {
+    handle_.SetOption(CURLOPT_HTTP_VERSION,
+                      static_cast<long>(CURL_HTTP_VERSION_2TLS));
+  }
+  // Wait for an existing connection to become available for multiplexing,
+  // instead of opening a new connection.
+  handle_.SetOption(CURLOPT_PIPEWAIT, 1L);
+  multiplexer_ = std::move(multiplexer);
+#endif  // LIBCURL_VERSION_NUM >= 0x073100
+  return *this;
+}
+
+CurlRequestBuilder& CurlRequestBuilder::SetTransferMetricsHook(
+    std::shared_ptr<TransferMetricsHook> hook) {
+  ValidateBuilderState(__func__);
+  if (!hook) {
+    return *this;
+  }
+  metrics_hook_ = std::move(hook);
+  metrics_.retry_attempt = CurrentRetryAttempt();
+  metrics_.handle_reused = IsReusedHandle(handle_.handle_.get());
+  return *this;
+}
+
+CurlRequestBuilder& CurlRequestBuilder::SetRateLimiters(RateLimiters limiters) {
+  ValidateBuilderState(__func__);
+  limiters_ = std::move(limiters);
+  return *this;
+}
+
+CurlRequestBuilder& CurlRequestBuilder::SetBufferPool(
+    std::shared_ptr<BufferPool> pool) {
+  ValidateBuilderState(__func__);
+  buffer_pool_ = std::move(pool);
+  return *this;
+}
+
+CurlRequestBuilder& CurlRequestBuilder::SetTcpKeepAlive(
+    std::chrono::seconds idle) {
+  ValidateBuilderState(__func__);
+  if (idle.count() == 0) {
+    handle_.SetOption(CURLOPT_TCP_KEEPALIVE, 0L);
+    return *this;
+  }
+  handle_.SetOption(CURLOPT_TCP_KEEPALIVE, 1L);
+  handle_.SetOption(CURLOPT_TCP_KEEPIDLE, static_cast<long>(idle.count()));
+  handle_.SetOption(CURLOPT_TCP_KEEPINTVL, static_cast<long>(idle.count()));
+  return *this;
+}
+
+CurlRequestBuilder& CurlRequestBuilder::SetDownloadTuning(
+    TransportTuning const& tuning) {
+  ValidateBuilderState(__func__);
+  if (tuning.curl_buffer_size != 0) {
+    // libcurl rejects sizes outside this range.
+    auto const size = (std::min)(
+        (std::max)(tuning.curl_buffer_size, std::size_t(1024)),
+        std::size_t(512 * 1024));
+    handle_.SetOption(CURLOPT_BUFFERSIZE, static_cast<long>(size));
+    // With a larger buffer libcurl passes larger blocks to the write callback.
+    max_write_size_ = (std::max)(size, std::size_t(CURL_MAX_WRITE_SIZE));
+  }
+  SetSocketTuning(tuning);
+  return *this;
+}
+
+CurlRequestBuilder& CurlRequestBuilder::SetUploadTuning(
+    TransportTuning const& tuning) {
+  ValidateBuilderState(__func__);
+  // Replaces any download tuning, uploads receive small responses.
+  if (max_write_size_ != CURL_MAX_WRITE_SIZE) {
+    handle_.SetOption(CURLOPT_BUFFERSIZE,
+                      static_cast<long>(CURL_MAX_WRITE_SIZE));
+    max_write_size_ = CURL_MAX_WRITE_SIZE;
+  }
+#if LIBCURL_VERSION_NUM >= 0x073e00
+  if (tuning.curl_buffer_size != 0) {
+    // libcurl rejects sizes outside this range.
+    auto const size = (std::min)(
+        (std::max)(tuning.curl_buffer_size, std::size_t(16 * 1024)),
+        std::size_t(2 * 1024 * 1024));
+    handle_.SetOption(CURLOPT_UPLOAD_BUFFERSIZE, static_cast<long>(size));
+  }
+#endif  // LIBCURL_VERSION_NUM >= 0x073e00
+  SetSocketTuning(tuning);
+  return *this;
+}
+
+CurlRequestBuilder& CurlRequestBuilder::SetMaximumConnections(
+    std::size_t count) {
+  ValidateBuilderState(__func__);
+  maximum_connections_ = static_cast<long>(count);
+  if (maximum_connections_ != 0) {
+    handle_.SetOption(CURLOPT_MAXCONNECTS, maximum_connections_);
+  }
+  return *this;
+}
+
+std::string const& CurlRequestBuilder::UserAgentSuffix() const {
   ValidateBuilderState(__func__);
   // Pre-compute and cache the user agent string:
   static std::string const kUserAgentSuffix = [] {
@@ -127,6 +289,24 @@ std::string CurlRequestBuilder::UserAgentSuffix() const {
   return kUserAgentSuffix;
 }
 
+std::string CurlRequestBuilder::MakeUserAgent() const {
+  auto const& suffix = UserAgentSuffix();
+  if (user_agent_prefix_.empty()) {
+    return suffix;
+  }
+  std::string agent;
+  agent.reserve(user_agent_prefix_.size() + suffix.size());
+  agent.append(user_agent_prefix_);
+  agent.append(suffix);
+  return agent;
+}
+
+void CurlRequestBuilder::SetSocketTuning(TransportTuning const& tuning) {
+  handle_.SetOption(CURLOPT_TCP_NODELAY, tuning.tcp_nodelay ? 1L : 0L);
+  handle_.SetSocketBufferSizes(tuning.socket_receive_buffer_size,
+                               tuning.socket_send_buffer_size);
+}
+
 void CurlRequestBuilder::ValidateBuilderState(char const* where) const {
   if (handle_.handle_.get() == nullptr) {
     std::string msg = "Attempt to use invalidated CurlRequest in ";
@@ -15,12 +15,18 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_REQUEST_BUILDER_H_
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_CURL_REQUEST_BUILDER_H_
 
+#include "google/cloud/storage/buffer_pool.h"
 #include "google/cloud/storage/internal/complex_option.h"
 #include "google/cloud/storage/internal/curl_download_request.h"
 #include "google/cloud/storage/internal/curl_handle_factory.h"
+#include "google/cloud/storage/internal/curl_multiplexer.h"
 #include "google/cloud/storage/internal/curl_request.h"
+#include "google/cloud/storage/internal/token_bucket.h"
+#include "google/cloud/storage/internal/tracing_sampler.h"
+#include "google/cloud/storage/transport_tuning.h"
 #include "google/cloud/storage/version.h"
 #include "google/cloud/storage/well_known_headers.h"
+#include <chrono>
 
 namespace google {
 namespace cloud {
@@ -53,6 +59,18 @@ class CurlRequestBuilder {
    */
   CurlDownloadRequest BuildDownloadRequest(std::string payload);
 
+  /**
+   * Creates a handle for a `HEAD` request, used only to open a connection.
+   *
+   * The handle has all the options set in the builder, so the connection is
+   * configured like the connections opened by other requests. The caller
+   * returns the handle to the factory used to create this builder.
+   *
+   * This function invalidates the builder. The application should not use this
+   * builder once this function is called.
+   */
+  CurlHandle BuildPrewarmHandle();
+
   /// Adds one of the well-known parameters as a query parameter
   template <typename P>
   CurlRequestBuilder& AddOption(WellKnownParameter<P, std::string> const& p) {
@@ -137,6 +155,14 @@ class CurlRequestBuilder {
   /// Adds request headers.
   CurlRequestBuilder& AddHeader(std::string const& header);
 
+  /**
+   * Sends the headers in @p headers after any headers added with `AddHeader()`.
+   *
+   * The list is shared with other requests, and must not be modified while
+   * any of them is alive. Use `MakeSharedCurlHeaders()` to create it.
+   */
+  CurlRequestBuilder& SetCommonHeaders(std::shared_ptr<curl_slist> headers);
+
   /// Adds a parameter for a request.
   CurlRequestBuilder& AddQueryParameter(std::string const& key,
                                         std::string const& value);
@@ -147,13 +173,86 @@ class CurlRequestBuilder {
   /// Enables (or disables) debug logging.
   CurlRequestBuilder& SetDebugLogging(bool enabled);
 
+  /**
+   * Enables debug logging for the requests selected by @p sampler.
+   *
+   * If the request is sampled it is traced in full, as with
+   * `SetDebugLogging(true)`. Otherwise `BuildRequest()` creates a request that
+   * logs a summary of any attempt that fails or is too slow. Download
+   * requests are only traced if they are sampled.
+   */
+  CurlRequestBuilder& SetTracingSampler(
+      std::shared_ptr<TracingSampler> sampler);
+
   /// Sets the CURLSH* handle to share resources.
   CurlRequestBuilder& SetCurlShare(CURLSH* share);
 
   CurlRequestBuilder& SetInitialBufferSize(std::size_t size);
 
+  /**
+   * Performs the request using @p multiplexer.
+   *
+   * The request uses HTTP/2 if `multiplexer->http2()` is true. Downloads use
+   * HTTP/2 in that case, but do not use the multiplexer. Does nothing if
+   * @p multiplexer is `nullptr`.
+   */
+  CurlRequestBuilder& SetMultiplexer(
+      std::shared_ptr<CurlMultiplexer> multiplexer);
+
+  /**
+   * Reports the metrics for each attempt of the request to @p hook.
+   *
+   * Captures the current retry attempt, see `CurrentRetryAttempt()`. Does
+   * nothing if @p hook is `nullptr`.
+   */
+  CurlRequestBuilder& SetTransferMetricsHook(
+      std::shared_ptr<TransferMetricsHook> hook);
+
+  /**
+   * Applies the rate limits in @p limiters to the request.
+   *
+   * The request starts once the request rate limiter has a token, and
+   * pauses the transfer while the bandwidth limiters are exhausted. Requests
+   * need a multiplexer to resume paused transfers, see `SetMultiplexer()`,
+   * without one only downloads are limited.
+   */
+  CurlRequestBuilder& SetRateLimiters(RateLimiters limiters);
+
+  /**
+   * Gets the download buffers from @p pool.
+   *
+   * Only download requests use a buffer. Allocates the buffers for each
+   * request if @p pool is `nullptr`.
+   */
+  CurlRequestBuilder& SetBufferPool(std::shared_ptr<BufferPool> pool);
+
+  /**
+   * Enables TCP keepalive probes after the connection is idle for @p idle.
+   *
+   * A zero value disables the keepalive probes.
+   */
+  CurlRequestBuilder& SetTcpKeepAlive(std::chrono::seconds idle);
+
+  /// Sets the socket and buffer options for a request that downloads data.
+  CurlRequestBuilder& SetDownloadTuning(TransportTuning const& tuning);
+
+  /**
+   * Sets the socket and buffer options for a request that uploads data.
+   *
+   * This replaces any options set by `SetDownloadTuning()`.
+   */
+  CurlRequestBuilder& SetUploadTuning(TransportTuning const& tuning);
+
+  /**
+   * Sets the maximum number of idle connections kept open by the request.
+   *
+   * With a shared connection cache this limits the total number of idle
+   * connections, libcurl closes connections beyond a small default otherwise.
+   */
+  CurlRequestBuilder& SetMaximumConnections(std::size_t count);
+
   /// Gets the user-agent suffix.
-  std::string UserAgentSuffix() const;
+  std::string const& UserAgentSuffix() const;
 
   /// URL-escapes a string.
   CurlString MakeEscapedString(std::string const& s) {
@@ -167,11 +266,13 @@ class CurlRequestBuilder {
 
  private:
   void ValidateBuilderState(char const* where) const;
+  std::string MakeUserAgent() const;
+  void SetSocketTuning(TransportTuning const& tuning);
 
   std::shared_ptr<CurlHandleFactory> factory_;
 
   CurlHandle handle_;
-  CurlHeaders headers_;
+  CurlHeaderList headers_;
 
   std::string url_;
   char const* query_parameter_separator_;
@@ -179,8 +280,22 @@ class CurlRequestBuilder {
   std::string user_agent_prefix_;
 
   bool logging_enabled_;
+  std::shared_ptr<TracingSampler> sampler_;
 
   std::size_t initial_buffer_size_;
+  // The largest block libcurl may pass to the write callback.
+  std::size_t max_write_size_;
+
+  long maximum_connections_;
+
+  std::shared_ptr<CurlMultiplexer> multiplexer_;
+
+  std::shared_ptr<TransferMetricsHook> metrics_hook_;
+  TransferMetrics metrics_;
+
+  RateLimiters limiters_;
+
+  std::shared_ptr<BufferPool> buffer_pool_;
 };
 
 }  // namespace internal
@@ -18,7 +18,6 @@
 #include <openssl/crypto.h>
 #include <openssl/opensslv.h>
 #include <algorithm>
-#include <cctype>
 #include <csignal>
 #include <iostream>
 #include <string>
@@ -212,6 +211,66 @@ bool SslLockingCallbacksInstalled() {
 #endif  // GOOGLE_CLOUD_CPP_SSL_REQUIRES_LOCKS
 }
 
+void CurlHeaderList::Append(std::string const& header) {
+  // Append a single node, there is no need to walk the list to find the end.
+  auto* node = curl_slist_append(nullptr, header.c_str());
+  if (node == nullptr) {
+    return;
+  }
+  node->next = shared_.get();
+  if (tail_ == nullptr) {
+    head_ = node;
+  } else {
+    tail_->next = node;
+  }
+  tail_ = node;
+}
+
+void CurlHeaderList::SetShared(std::shared_ptr<curl_slist> shared) {
+  shared_ = std::move(shared);
+  if (tail_ != nullptr) {
+    tail_->next = shared_.get();
+  }
+}
+
+void CurlHeaderList::Reset() {
+  if (tail_ != nullptr) {
+    // Unlink the shared nodes, they are released with `shared_`.
+    tail_->next = nullptr;
+  }
+  curl_slist_free_all(head_);
+  head_ = nullptr;
+  tail_ = nullptr;
+}
+
+std::shared_ptr<curl_slist> MakeSharedCurlHeaders(
+    std::vector<std::string> const& headers) {
+  curl_slist* list = nullptr;
+  for (auto const& h : headers) {
+    auto* appended = curl_slist_append(list, h.c_str());
+    if (appended != nullptr) {
+      list = appended;
+    }
+  }
+  return std::shared_ptr<curl_slist>(list, &curl_slist_free_all);
+}
+
+void AppendUrlEscaped(std::string& output, std::string const& input) {
+  static char const kHexDigits[] = "0123456789ABCDEF";
+  for (char c : input) {
+    auto const u = static_cast<unsigned char>(c);
+    if ((u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') ||
+        (u >= '0' && u <= '9') || u == '-' || u == '.' || u == '_' ||
+        u == '~') {
+      output.push_back(c);
+      continue;
+    }
+    output.push_back('%');
+    output.push_back(kHexDigits[u >> 4]);
+    output.push_back(kHexDigits[u & 0xF]);
+  }
+}
+
 std::size_t CurlAppendHeaderData(CurlReceivedHeaders& received_headers,
                                  char const* data, std::size_t size) {
   if (size <= 2) {
@@ -223,15 +282,16 @@ std::size_t CurlAppendHeaderData(CurlReceivedHeaders& received_headers,
     return size;
   }
   auto separator = std::find(data, data + size, ':');
-  std::string header_name = std::string(data, separator);
-  std::string header_value;
-  // If there is a value, capture it, but ignore the final \r\n.
-  if (static_cast<std::size_t>(separator - data) < size - 2) {
-    header_value = std::string(separator + 2, data + size - 2);
-  }
-  std::transform(header_name.begin(), header_name.end(), header_name.begin(),
-                 [](char x) { return std::tolower(x); });
-  received_headers.emplace(std::move(header_name), std::move(header_value));
+  auto const name_size = static_cast<std::size_t>(separator - data);
+  char const* value = separator;
+  std::size_t value_size = 0;
+  // If there is a value, capture it, but skip the ": " separator and ignore
+  // the final \r\n.
+  if (name_size + 2 < size - 2) {
+    value = separator + 2;
+    value_size = size - 2 - (name_size + 2);
+  }
+  received_headers.AppendLowercase(data, name_size, value, value_size);
   return size;
 }
 
@@ -23,6 +23,8 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace google {
 namespace cloud {
@@ -38,12 +40,72 @@ using CurlMulti = std::unique_ptr<CURLM, decltype(&curl_multi_cleanup)>;
 /// Hold a character string created by CURL use correct deleter.
 using CurlString = std::unique_ptr<char, decltype(&curl_free)>;
 
-using CurlHeaders = std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)>;
+/**
+ * The headers of a request, followed by headers shared with other requests.
+ *
+ * The headers common to all the requests from a client, such as the
+ * authorization header, are built once into a shared list. Each request keeps
+ * its own headers in a separate list, and links the last node of that list to
+ * the shared list, instead of copying the common headers. libcurl only reads
+ * the list set with `CURLOPT_HTTPHEADER`, the shared nodes are never modified,
+ * so many requests can use them concurrently.
+ */
+class CurlHeaderList {
+ public:
+  CurlHeaderList() = default;
+  ~CurlHeaderList() { Reset(); }
 
-using CurlReceivedHeaders = std::multimap<std::string, std::string>;
+  CurlHeaderList(CurlHeaderList&& rhs) noexcept
+      : head_(rhs.head_), tail_(rhs.tail_), shared_(std::move(rhs.shared_)) {
+    rhs.head_ = nullptr;
+    rhs.tail_ = nullptr;
+  }
+  CurlHeaderList& operator=(CurlHeaderList&& rhs) noexcept {
+    Reset();
+    head_ = rhs.head_;
+    tail_ = rhs.tail_;
+    shared_ = std::move(rhs.shared_);
+    rhs.head_ = nullptr;
+    rhs.tail_ = nullptr;
+    return *this;
+  }
+  CurlHeaderList(CurlHeaderList const&) = delete;
+  CurlHeaderList& operator=(CurlHeaderList const&) = delete;
+
+  /// Adds a header to this request, it is sent before the shared headers.
+  void Append(std::string const& header);
+
+  /// Sends the headers in @p shared after the headers of this request.
+  void SetShared(std::shared_ptr<curl_slist> shared);
+
+  /// The list to use with `CURLOPT_HTTPHEADER`.
+  curl_slist* get() const { return head_ != nullptr ? head_ : shared_.get(); }
+
+ private:
+  void Reset();
+
+  curl_slist* head_ = nullptr;
+  curl_slist* tail_ = nullptr;
+  std::shared_ptr<curl_slist> shared_;
+};
+
+/// Creates a list with @p headers, to be used with `CurlHeaderList::SetShared`.
+std::shared_ptr<curl_slist> MakeSharedCurlHeaders(
+    std::vector<std::string> const& headers);
+
+using CurlReceivedHeaders = HttpHeaders;
 std::size_t CurlAppendHeaderData(CurlReceivedHeaders& received_headers,
                                  char const* data, std::size_t size);
 
+/**
+ * Appends the URL-escaped version of @p input to @p output.
+ *
+ * This produces the same result as `curl_easy_escape()`, i.e., all characters
+ * except the RFC 3986 unreserved characters are percent-encoded, but it does
+ * not need a `CURL*` handle and does not allocate any temporary strings.
+ */
+void AppendUrlEscaped(std::string& output, std::string const& input);
+
 using CurlShare = std::unique_ptr<CURLSH, decltype(&curl_share_cleanup)>;
 
 /// Returns true if the SSL locking callbacks are installed.
@@ -0,0 +1,109 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/gzip_compressor.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+// Adding 16 to the window bits asks zlib for a gzip header and trailer instead
+// of the zlib format.
+int constexpr kGzipWindowBits = 16 + MAX_WBITS;
+int constexpr kDefaultMemLevel = 8;
+// zlib uses `uInt` for buffer sizes, feed it large buffers in smaller pieces.
+std::size_t constexpr kMaximumInputBlock = 1024 * 1024 * 1024;
+std::size_t constexpr kOutputIncrement = 64 * 1024;
+
+Status ZlibError(char const* where, int result, z_stream const& stream) {
+  std::ostringstream os;
+  os << where << "() - zlib error " << result;
+  if (stream.msg != nullptr) {
+    os << " (" << stream.msg << ")";
+  }
+  return Status(StatusCode::kInternal, std::move(os).str());
+}
+}  // namespace
+
+GzipCompressor::GzipCompressor() {
+  std::memset(&stream_, 0, sizeof(stream_));
+  auto result = deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                             kGzipWindowBits, kDefaultMemLevel,
+                             Z_DEFAULT_STRATEGY);
+  if (result != Z_OK) {
+    status_ = ZlibError("deflateInit2", result, stream_);
+  }
+}
+
+GzipCompressor::~GzipCompressor() {
+  if (status_.ok()) {
+    deflateEnd(&stream_);
+  }
+}
+
+Status GzipCompressor::Compress(char const* data, std::size_t size,
+                                bool finish, std::string* output) {
+  if (!status_.ok()) {
+    return status_;
+  }
+  if (finished_) {
+    return Status(StatusCode::kFailedPrecondition,
+                  "GzipCompressor::Compress() - stream already finished");
+  }
+  total_in_ += size;
+  auto const initial_output_size = output->size();
+  do {
+    auto const block = (std::min)(size, kMaximumInputBlock);
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream_.avail_in = static_cast<uInt>(block);
+    data += block;
+    size -= block;
+    int const flush = (finish && size == 0) ? Z_FINISH : Z_NO_FLUSH;
+    for (;;) {
+      auto const offset = output->size();
+      auto const available = (std::max)(kOutputIncrement, block / 2);
+      output->resize(offset + available);
+      stream_.next_out = reinterpret_cast<Bytef*>(&(*output)[offset]);
+      stream_.avail_out = static_cast<uInt>(available);
+      auto result = deflate(&stream_, flush);
+      output->resize(offset + available - stream_.avail_out);
+      if (result == Z_STREAM_END) {
+        finished_ = true;
+        break;
+      }
+      if (result != Z_OK && result != Z_BUF_ERROR) {
+        status_ = ZlibError("deflate", result, stream_);
+        return status_;
+      }
+      // With Z_FINISH we must keep going until zlib reports the end of the
+      // stream, otherwise stop once all the input has been consumed.
+      if (flush != Z_FINISH && stream_.avail_out != 0) {
+        break;
+      }
+    }
+  } while (size != 0);
+  total_out_ += output->size() - initial_output_size;
+  return Status();
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,76 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_GZIP_COMPRESSOR_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_GZIP_COMPRESSOR_H_
+
+#include "google/cloud/status.h"
+#include "google/cloud/storage/version.h"
+#include <zlib.h>
+#include <cstdint>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Compresses a stream of data into the gzip format.
+ *
+ * The data is compressed incrementally, each call to `Compress()` appends the
+ * compressed output available so far, and the last call (with `finish` set)
+ * appends the remaining output and the gzip trailer. The concatenation of all
+ * the outputs is a valid gzip stream.
+ *
+ * This class is not thread-safe, but it can be used from different threads as
+ * long as the calls are serialized.
+ */
+class GzipCompressor {
+ public:
+  GzipCompressor();
+  ~GzipCompressor();
+
+  GzipCompressor(GzipCompressor const&) = delete;
+  GzipCompressor& operator=(GzipCompressor const&) = delete;
+
+  /**
+   * Compresses @p size bytes starting at @p data and appends the result to
+   * @p output.
+   *
+   * @param finish if true, this is the last block of data in the stream.
+   */
+  Status Compress(char const* data, std::size_t size, bool finish,
+                  std::string* output);
+
+  /// The number of uncompressed bytes received so far.
+  std::uint64_t total_in() const { return total_in_; }
+  /// The number of compressed bytes produced so far.
+  std::uint64_t total_out() const { return total_out_; }
+
+ private:
+  z_stream stream_;
+  Status status_;
+  bool finished_ = false;
+  std::uint64_t total_in_ = 0;
+  std::uint64_t total_out_ = 0;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_GZIP_COMPRESSOR_H_
@@ -0,0 +1,120 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/gzip_compressor.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <cstring>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+/// Decompress a gzip stream using zlib directly.
+std::string Decompress(std::string const& compressed) {
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  EXPECT_EQ(Z_OK, inflateInit2(&stream, 16 + MAX_WBITS));
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(&compressed[0]));
+  stream.avail_in = static_cast<uInt>(compressed.size());
+  std::string result;
+  int status;
+  do {
+    char buffer[4096];
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = sizeof(buffer);
+    status = inflate(&stream, Z_NO_FLUSH);
+    result.append(buffer, sizeof(buffer) - stream.avail_out);
+  } while (status == Z_OK);
+  EXPECT_EQ(Z_STREAM_END, status);
+  inflateEnd(&stream);
+  return result;
+}
+
+std::string MakeText(std::size_t size) {
+  std::string const line =
+      "2019-07-01T00:00:00Z INFO request completed status=200\n";
+  std::string text;
+  while (text.size() < size) {
+    text += line;
+  }
+  text.resize(size);
+  return text;
+}
+
+TEST(GzipCompressorTest, Empty) {
+  GzipCompressor compressor;
+  std::string output;
+  EXPECT_STATUS_OK(compressor.Compress(nullptr, 0, true, &output));
+  EXPECT_FALSE(output.empty());
+  EXPECT_EQ("", Decompress(output));
+}
+
+TEST(GzipCompressorTest, SingleBlock) {
+  auto const text = MakeText(1024 * 1024);
+  GzipCompressor compressor;
+  std::string output;
+  EXPECT_STATUS_OK(
+      compressor.Compress(text.data(), text.size(), true, &output));
+  EXPECT_LT(output.size(), text.size() / 10);
+  EXPECT_EQ(text, Decompress(output));
+  EXPECT_EQ(text.size(), compressor.total_in());
+  EXPECT_EQ(output.size(), compressor.total_out());
+}
+
+TEST(GzipCompressorTest, MultipleBlocks) {
+  auto const text = MakeText(3 * 1024 * 1024 + 17);
+  GzipCompressor compressor;
+  std::string output;
+  std::size_t const block = 256 * 1024;
+  for (std::size_t offset = 0; offset < text.size(); offset += block) {
+    auto n = (std::min)(block, text.size() - offset);
+    bool finish = offset + n == text.size();
+    EXPECT_STATUS_OK(
+        compressor.Compress(text.data() + offset, n, finish, &output));
+  }
+  EXPECT_EQ(text, Decompress(output));
+}
+
+TEST(GzipCompressorTest, IncompressibleData) {
+  std::string data(512 * 1024, '\0');
+  std::uint32_t state = 12345;
+  for (auto& c : data) {
+    state = state * 1103515245U + 12345U;
+    c = static_cast<char>(state >> 24);
+  }
+  GzipCompressor compressor;
+  std::string output;
+  EXPECT_STATUS_OK(
+      compressor.Compress(data.data(), data.size(), true, &output));
+  EXPECT_EQ(data, Decompress(output));
+}
+
+TEST(GzipCompressorTest, CompressAfterFinish) {
+  GzipCompressor compressor;
+  std::string output;
+  EXPECT_STATUS_OK(compressor.Compress("abc", 3, true, &output));
+  auto status = compressor.Compress("abc", 3, true, &output);
+  EXPECT_EQ(StatusCode::kFailedPrecondition, status.code());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
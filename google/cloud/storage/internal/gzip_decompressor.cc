@@ -0,0 +1,110 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/gzip_decompressor.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+// Adding 16 to the window bits asks zlib to expect a gzip header and trailer.
+int constexpr kGzipWindowBits = 16 + MAX_WBITS;
+// zlib uses `uInt` for buffer sizes, feed it large buffers in smaller pieces.
+std::size_t constexpr kMaximumBlock = 1024 * 1024 * 1024;
+
+Status ZlibError(char const* where, int result, z_stream const& stream) {
+  std::ostringstream os;
+  os << where << "() - zlib error " << result;
+  if (stream.msg != nullptr) {
+    os << " (" << stream.msg << ")";
+  }
+  // Errors in the data are reported as data loss, as the downloaded data
+  // cannot be used.
+  auto code =
+      result == Z_DATA_ERROR ? StatusCode::kDataLoss : StatusCode::kInternal;
+  return Status(code, std::move(os).str());
+}
+}  // namespace
+
+GzipDecompressor::GzipDecompressor() {
+  std::memset(&stream_, 0, sizeof(stream_));
+  auto result = inflateInit2(&stream_, kGzipWindowBits);
+  if (result != Z_OK) {
+    status_ = ZlibError("inflateInit2", result, stream_);
+  }
+}
+
+GzipDecompressor::~GzipDecompressor() {
+  if (status_.ok()) {
+    inflateEnd(&stream_);
+  }
+}
+
+void GzipDecompressor::SetInput(char const* data, std::size_t size) {
+  input_ = data;
+  input_size_ = size;
+}
+
+StatusOr<std::size_t> GzipDecompressor::Decompress(char* output,
+                                                   std::size_t size) {
+  if (!status_.ok()) {
+    return status_;
+  }
+  size = (std::min)(size, kMaximumBlock);
+  for (;;) {
+    if (stream_.avail_in == 0 && input_size_ != 0) {
+      auto const block = (std::min)(input_size_, kMaximumBlock);
+      stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input_));
+      stream_.avail_in = static_cast<uInt>(block);
+      input_ += block;
+      input_size_ -= block;
+    }
+    if (finished_) {
+      // Any data after the end of a gzip member is the start of another
+      // member, as in objects composed from several gzip-encoded objects.
+      if (stream_.avail_in == 0) {
+        return 0;
+      }
+      finished_ = false;
+    }
+    stream_.next_out = reinterpret_cast<Bytef*>(output);
+    stream_.avail_out = static_cast<uInt>(size);
+    auto result = inflate(&stream_, Z_NO_FLUSH);
+    if (result == Z_STREAM_END) {
+      finished_ = true;
+      result = inflateReset(&stream_);
+    }
+    if (result != Z_OK && result != Z_BUF_ERROR) {
+      status_ = ZlibError("inflate", result, stream_);
+      return status_;
+    }
+    auto const produced = size - stream_.avail_out;
+    // zlib may consume some input (e.g. the gzip header) without producing
+    // any output, keep going until there is output or no input left.
+    if (produced != 0 || (stream_.avail_in == 0 && input_size_ == 0)) {
+      return produced;
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,75 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_GZIP_DECOMPRESSOR_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_GZIP_DECOMPRESSOR_H_
+
+#include "google/cloud/status_or.h"
+#include "google/cloud/storage/version.h"
+#include <zlib.h>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Decompresses a stream of data in the gzip format.
+ *
+ * The application provides blocks of compressed data with `SetInput()`, and
+ * then calls `Decompress()` until it returns 0, which indicates that the input
+ * has been consumed. The input block must remain valid until it is consumed.
+ *
+ * The data may contain several gzip members, these are decompressed as a single
+ * stream, as required by RFC 1952.
+ */
+class GzipDecompressor {
+ public:
+  GzipDecompressor();
+  ~GzipDecompressor();
+
+  GzipDecompressor(GzipDecompressor const&) = delete;
+  GzipDecompressor& operator=(GzipDecompressor const&) = delete;
+
+  /// Set the next block of compressed data.
+  void SetInput(char const* data, std::size_t size);
+
+  /**
+   * Decompresses data into @p output.
+   *
+   * @return the number of bytes written to @p output, 0 if more input is
+   *   needed.
+   */
+  StatusOr<std::size_t> Decompress(char* output, std::size_t size);
+
+  /// True if the input consumed so far ends with a complete gzip member.
+  bool finished() const { return finished_; }
+
+ private:
+  z_stream stream_;
+  Status status_;
+  bool finished_ = false;
+  // The part of the input block not given to zlib yet.
+  char const* input_ = nullptr;
+  std::size_t input_size_ = 0;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_GZIP_DECOMPRESSOR_H_
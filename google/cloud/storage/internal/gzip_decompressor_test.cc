@@ -0,0 +1,121 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/gzip_decompressor.h"
+#include "google/cloud/storage/internal/gzip_compressor.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+std::string MakeText(std::size_t size) {
+  std::string const line =
+      "2019-07-01T00:00:00Z INFO request completed status=200\n";
+  std::string text;
+  while (text.size() < size) {
+    text += line;
+  }
+  text.resize(size);
+  return text;
+}
+
+std::string Compress(std::string const& data) {
+  GzipCompressor compressor;
+  std::string output;
+  EXPECT_STATUS_OK(
+      compressor.Compress(data.data(), data.size(), true, &output));
+  return output;
+}
+
+/// Decompress @p compressed feeding the data in blocks of @p input_block bytes
+/// and reading it in blocks of @p output_block bytes.
+StatusOr<std::string> Decompress(std::string const& compressed,
+                                 std::size_t input_block,
+                                 std::size_t output_block) {
+  GzipDecompressor decompressor;
+  std::string result;
+  std::vector<char> buffer(output_block);
+  for (std::size_t offset = 0; offset < compressed.size();
+       offset += input_block) {
+    auto n = (std::min)(input_block, compressed.size() - offset);
+    decompressor.SetInput(compressed.data() + offset, n);
+    for (;;) {
+      auto r = decompressor.Decompress(buffer.data(), buffer.size());
+      if (!r) {
+        return std::move(r).status();
+      }
+      if (*r == 0) {
+        break;
+      }
+      result.append(buffer.data(), *r);
+    }
+  }
+  if (!decompressor.finished()) {
+    return Status(StatusCode::kDataLoss, "truncated");
+  }
+  return result;
+}
+
+TEST(GzipDecompressorTest, Simple) {
+  auto const text = MakeText(1024 * 1024);
+  auto actual = Decompress(Compress(text), 1024 * 1024, 128 * 1024);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(text, *actual);
+}
+
+TEST(GzipDecompressorTest, SmallBlocks) {
+  auto const text = MakeText(256 * 1024);
+  auto actual = Decompress(Compress(text), 7, 13);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(text, *actual);
+}
+
+TEST(GzipDecompressorTest, Empty) {
+  auto actual = Decompress(Compress(std::string{}), 1024, 1024);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("", *actual);
+}
+
+TEST(GzipDecompressorTest, MultipleMembers) {
+  auto const text_1 = MakeText(100 * 1024);
+  auto const text_2 = MakeText(3 * 1024);
+  auto actual = Decompress(Compress(text_1) + Compress(text_2), 4096, 4096);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(text_1 + text_2, *actual);
+}
+
+TEST(GzipDecompressorTest, Truncated) {
+  auto compressed = Compress(MakeText(64 * 1024));
+  compressed.resize(compressed.size() / 2);
+  auto actual = Decompress(compressed, 1024, 1024);
+  EXPECT_EQ(StatusCode::kDataLoss, actual.status().code());
+}
+
+TEST(GzipDecompressorTest, Corrupted) {
+  auto actual = Decompress("this is not a gzip stream", 1024, 1024);
+  EXPECT_EQ(StatusCode::kDataLoss, actual.status().code());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
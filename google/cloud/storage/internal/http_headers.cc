@@ -0,0 +1,154 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/http_headers.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+// Large enough for the headers in a typical response, so they are stored
+// without any reallocations.
+std::size_t constexpr kInitialBufferSize = 1024;
+std::size_t constexpr kInitialEntries = 16;
+}  // namespace
+
+HttpHeaders::HttpHeaders(std::initializer_list<value_type> headers) {
+  for (auto const& kv : headers) {
+    emplace(kv.first, kv.second);
+  }
+}
+
+HttpHeaders::HttpHeaders(
+    std::multimap<std::string, std::string> const& headers) {
+  for (auto const& kv : headers) {
+    emplace(kv.first, kv.second);
+  }
+}
+
+void HttpHeaders::clear() {
+  buffer_.clear();
+  entries_.clear();
+}
+
+HttpHeaders::const_iterator HttpHeaders::emplace(std::string const& name,
+                                                 std::string const& value) {
+  Append(name.data(), name.size(), value.data(), value.size(), false);
+  // Headers with the same name are kept in insertion order, so the new header
+  // is the last one with this name.
+  return const_iterator(this, UpperBound(name.data(), name.size()) - 1);
+}
+
+void HttpHeaders::AppendLowercase(char const* name, std::size_t name_size,
+                                  char const* value, std::size_t value_size) {
+  Append(name, name_size, value, value_size, true);
+}
+
+void HttpHeaders::merge(HttpHeaders const& rhs) {
+  buffer_.reserve(buffer_.size() + rhs.buffer_.size());
+  for (auto const& e : rhs.entries_) {
+    auto const* name = rhs.buffer_.data() + e.offset;
+    Append(name, e.name_size, name + e.name_size, e.value_size, false);
+  }
+}
+
+HttpHeaders::const_iterator HttpHeaders::find(std::string const& name) const {
+  auto index = LowerBound(name.data(), name.size());
+  if (index == entries_.size() ||
+      Compare(entries_[index], name.data(), name.size()) != 0) {
+    return end();
+  }
+  return const_iterator(this, index);
+}
+
+std::pair<HttpHeaders::const_iterator, HttpHeaders::const_iterator>
+HttpHeaders::equal_range(std::string const& name) const {
+  return {const_iterator(this, LowerBound(name.data(), name.size())),
+          const_iterator(this, UpperBound(name.data(), name.size()))};
+}
+
+std::size_t HttpHeaders::count(std::string const& name) const {
+  return UpperBound(name.data(), name.size()) -
+         LowerBound(name.data(), name.size());
+}
+
+void HttpHeaders::Append(char const* name, std::size_t name_size,
+                         char const* value, std::size_t value_size,
+                         bool lowercase) {
+  if (buffer_.capacity() == 0) {
+    buffer_.reserve(kInitialBufferSize);
+    entries_.reserve(kInitialEntries);
+  }
+  Entry entry{buffer_.size(), name_size, value_size};
+  buffer_.append(name, name_size);
+  if (lowercase) {
+    std::transform(buffer_.begin() + entry.offset, buffer_.end(),
+                   buffer_.begin() + entry.offset,
+                   [](char x) { return static_cast<char>(std::tolower(x)); });
+  }
+  buffer_.append(value, value_size);
+  // Compare using the copy in `buffer_`, which is already lowercase.
+  auto index = UpperBound(buffer_.data() + entry.offset, name_size);
+  entries_.insert(entries_.begin() + static_cast<std::ptrdiff_t>(index),
+                  entry);
+}
+
+HttpHeaders::value_type HttpHeaders::ValueAt(std::size_t index) const {
+  auto const& e = entries_[index];
+  auto const* name = buffer_.data() + e.offset;
+  return value_type(std::string(name, e.name_size),
+                    std::string(name + e.name_size, e.value_size));
+}
+
+int HttpHeaders::Compare(Entry const& entry, char const* name,
+                         std::size_t name_size) const {
+  auto const n = (std::min)(entry.name_size, name_size);
+  auto r = n == 0 ? 0 : std::memcmp(buffer_.data() + entry.offset, name, n);
+  if (r != 0) {
+    return r;
+  }
+  if (entry.name_size == name_size) {
+    return 0;
+  }
+  return entry.name_size < name_size ? -1 : 1;
+}
+
+std::size_t HttpHeaders::LowerBound(char const* name,
+                                    std::size_t name_size) const {
+  auto loc = std::lower_bound(entries_.begin(), entries_.end(), 0,
+                              [&](Entry const& e, int) {
+                                return Compare(e, name, name_size) < 0;
+                              });
+  return static_cast<std::size_t>(loc - entries_.begin());
+}
+
+std::size_t HttpHeaders::UpperBound(char const* name,
+                                    std::size_t name_size) const {
+  auto loc = std::upper_bound(entries_.begin(), entries_.end(), 0,
+                              [&](int, Entry const& e) {
+                                return Compare(e, name, name_size) > 0;
+                              });
+  return static_cast<std::size_t>(loc - entries_.begin());
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,167 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_HTTP_HEADERS_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_HTTP_HEADERS_H_
+
+#include "google/cloud/storage/version.h"
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * The headers in a HTTP response.
+ *
+ * A response typically contains a dozen or more headers, but the client only
+ * looks at a few of them (e.g. `x-goog-hash`, `x-goog-generation`, `location`,
+ * or `range`). Storing each header in a `std::multimap<>` entry requires
+ * several allocations per header, instead this class stores the names and
+ * values of all the headers in a single buffer, and only creates strings for
+ * the headers that are actually used.
+ *
+ * The class offers a subset of the `std::multimap<std::string, std::string>`
+ * interface: the headers are sorted by name, headers with the same name are
+ * kept in the order they were added, and the iterators return
+ * `std::pair<std::string, std::string>` values. Note that these values are
+ * created when the iterator is dereferenced, the application should copy them
+ * (and not keep references) if needed.
+ */
+class HttpHeaders {
+ public:
+  using value_type = std::pair<std::string, std::string>;
+
+  /// Iterate over the headers, creating a `value_type` for each one visited.
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = HttpHeaders::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type const*;
+    using reference = value_type;
+
+    /// Holds the value of a header for `operator->`.
+    class Proxy {
+     public:
+      explicit Proxy(value_type v) : value_(std::move(v)) {}
+      value_type const* operator->() const { return &value_; }
+
+     private:
+      value_type value_;
+    };
+
+    const_iterator() = default;
+
+    value_type operator*() const { return headers_->ValueAt(index_); }
+    Proxy operator->() const { return Proxy(**this); }
+
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto tmp = *this;
+      ++index_;
+      return tmp;
+    }
+
+    bool operator==(const_iterator const& rhs) const {
+      return headers_ == rhs.headers_ && index_ == rhs.index_;
+    }
+    bool operator!=(const_iterator const& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    friend class HttpHeaders;
+    const_iterator(HttpHeaders const* headers, std::size_t index)
+        : headers_(headers), index_(index) {}
+
+    HttpHeaders const* headers_ = nullptr;
+    std::size_t index_ = 0;
+  };
+  using iterator = const_iterator;
+
+  HttpHeaders() = default;
+  HttpHeaders(std::initializer_list<value_type> headers);
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  HttpHeaders(std::multimap<std::string, std::string> const& headers);
+
+  bool empty() const { return entries_.empty(); }
+  std::size_t size() const { return entries_.size(); }
+  void clear();
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, entries_.size()); }
+
+  /// Adds a header.
+  const_iterator emplace(std::string const& name, std::string const& value);
+
+  /**
+   * Adds a header received from the network.
+   *
+   * HTTP header names are case insensitive, the name is stored in lowercase,
+   * so the application can find the header using lowercase names.
+   */
+  void AppendLowercase(char const* name, std::size_t name_size,
+                       char const* value, std::size_t value_size);
+
+  /// Adds all the headers in @p rhs.
+  void merge(HttpHeaders const& rhs);
+
+  /// Returns the first header named @p name, or `end()` if there is none.
+  const_iterator find(std::string const& name) const;
+
+  /// Returns the range of headers named @p name.
+  std::pair<const_iterator, const_iterator> equal_range(
+      std::string const& name) const;
+
+  std::size_t count(std::string const& name) const;
+
+ private:
+  struct Entry {
+    std::size_t offset;
+    std::size_t name_size;
+    std::size_t value_size;
+  };
+
+  void Append(char const* name, std::size_t name_size, char const* value,
+              std::size_t value_size, bool lowercase);
+  value_type ValueAt(std::size_t index) const;
+  int Compare(Entry const& entry, char const* name,
+              std::size_t name_size) const;
+  std::size_t LowerBound(char const* name, std::size_t name_size) const;
+  std::size_t UpperBound(char const* name, std::size_t name_size) const;
+
+  // The names and values of all the headers, one after the other.
+  std::string buffer_;
+  // The location of each header in `buffer_`, sorted by name.
+  std::vector<Entry> entries_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_HTTP_HEADERS_H_
@@ -0,0 +1,141 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/http_headers.h"
+#include "google/cloud/storage/internal/curl_wrappers.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+std::vector<std::pair<std::string, std::string>> AsVector(
+    HttpHeaders const& headers) {
+  return {headers.begin(), headers.end()};
+}
+
+TEST(HttpHeadersTest, Empty) {
+  HttpHeaders headers;
+  EXPECT_TRUE(headers.empty());
+  EXPECT_EQ(0, headers.size());
+  EXPECT_EQ(headers.end(), headers.begin());
+  EXPECT_EQ(headers.end(), headers.find("x-goog-hash"));
+  EXPECT_EQ(0, headers.count("x-goog-hash"));
+}
+
+TEST(HttpHeadersTest, SortedLikeMultimap) {
+  HttpHeaders headers{{"x-goog-hash", "crc32c=AAAAAA=="},
+                      {"content-type", "text/plain"},
+                      {"x-goog-hash", "md5=1B2M2Y8AsgTpgAmY7PhCfg=="},
+                      {"content-length", "0"}};
+  EXPECT_FALSE(headers.empty());
+  EXPECT_EQ(4, headers.size());
+  EXPECT_THAT(AsVector(headers),
+              ElementsAre(Pair("content-length", "0"),
+                          Pair("content-type", "text/plain"),
+                          Pair("x-goog-hash", "crc32c=AAAAAA=="),
+                          Pair("x-goog-hash", "md5=1B2M2Y8AsgTpgAmY7PhCfg==")));
+
+  std::multimap<std::string, std::string> expected(headers.begin(),
+                                                   headers.end());
+  EXPECT_THAT(AsVector(HttpHeaders(expected)),
+              ElementsAre(Pair("content-length", "0"),
+                          Pair("content-type", "text/plain"),
+                          Pair("x-goog-hash", "crc32c=AAAAAA=="),
+                          Pair("x-goog-hash", "md5=1B2M2Y8AsgTpgAmY7PhCfg==")));
+}
+
+TEST(HttpHeadersTest, Find) {
+  HttpHeaders headers;
+  headers.emplace("x-goog-generation", "1234");
+  auto inserted = headers.emplace("x-goog-hash", "crc32c=AAAAAA==");
+  EXPECT_EQ("crc32c=AAAAAA==", inserted->second);
+  headers.emplace("x-goog-hash", "md5=1B2M2Y8AsgTpgAmY7PhCfg==");
+  headers.emplace("x-goog", "");
+
+  auto g = headers.find("x-goog-generation");
+  ASSERT_NE(headers.end(), g);
+  EXPECT_EQ("x-goog-generation", g->first);
+  EXPECT_EQ("1234", g->second);
+
+  auto h = headers.find("x-goog-hash");
+  ASSERT_NE(headers.end(), h);
+  EXPECT_EQ("crc32c=AAAAAA==", h->second);
+  EXPECT_EQ(2, headers.count("x-goog-hash"));
+
+  auto range = headers.equal_range("x-goog-hash");
+  std::vector<std::pair<std::string, std::string>> hashes(range.first,
+                                                          range.second);
+  EXPECT_THAT(hashes,
+              ElementsAre(Pair("x-goog-hash", "crc32c=AAAAAA=="),
+                          Pair("x-goog-hash", "md5=1B2M2Y8AsgTpgAmY7PhCfg==")));
+
+  auto e = headers.find("x-goog");
+  ASSERT_NE(headers.end(), e);
+  EXPECT_EQ("", e->second);
+
+  EXPECT_EQ(headers.end(), headers.find("x-goo"));
+  EXPECT_EQ(headers.end(), headers.find("x-goog-hashes"));
+  EXPECT_EQ(headers.end(), headers.find("X-Goog-Hash"));
+}
+
+TEST(HttpHeadersTest, Merge) {
+  HttpHeaders headers{{"b", "1"}, {"d", "2"}};
+  headers.merge(HttpHeaders{{"c", "3"}, {"a", "4"}, {"b", "5"}});
+  EXPECT_THAT(AsVector(headers),
+              ElementsAre(Pair("a", "4"), Pair("b", "1"), Pair("b", "5"),
+                          Pair("c", "3"), Pair("d", "2")));
+
+  headers.clear();
+  EXPECT_TRUE(headers.empty());
+  EXPECT_EQ(headers.end(), headers.find("a"));
+}
+
+TEST(HttpHeadersTest, CurlAppendHeaderData) {
+  std::vector<std::string> const lines = {
+      "HTTP/1.1 200 OK\r\n",
+      "Content-Type: application/octet-stream\r\n",
+      "x-goog-generation: 1568054186000000\r\n",
+      "X-Goog-Hash: crc32c=AAAAAA==\r\n",
+      "x-empty:\r\n",
+      "x-empty-with-space: \r\n",
+      "\r\n",
+      "invalid",
+  };
+  HttpHeaders headers;
+  for (auto const& line : lines) {
+    EXPECT_EQ(line.size(),
+              CurlAppendHeaderData(headers, line.data(), line.size()));
+  }
+  EXPECT_THAT(
+      AsVector(headers),
+      ElementsAre(Pair("content-type", "application/octet-stream"),
+                  Pair("http/1.1 200 ok\r\n", ""),
+                  Pair("x-empty", ""), Pair("x-empty-with-space", ""),
+                  Pair("x-goog-generation", "1568054186000000"),
+                  Pair("x-goog-hash", "crc32c=AAAAAA==")));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
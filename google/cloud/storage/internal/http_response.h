@@ -16,9 +16,9 @@
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_HTTP_RESPONSE_H_
 
 #include "google/cloud/status.h"
+#include "google/cloud/storage/internal/http_headers.h"
 #include "google/cloud/storage/version.h"
 #include <iosfwd>
-#include <map>
 #include <string>
 
 namespace google {
@@ -33,7 +33,7 @@ namespace internal {
 struct HttpResponse {
   long status_code;
   std::string payload;
-  std::multimap<std::string, std::string> headers;
+  HttpHeaders headers;
 };
 
 /**
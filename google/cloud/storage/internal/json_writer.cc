@@ -0,0 +1,119 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/json_writer.h"
+#include <cstring>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+JsonWriter& JsonWriter::Key(char const* name) {
+  Separator();
+  AppendEscaped(name, std::strlen(name));
+  buffer_ += ':';
+  need_separator_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Key(std::string const& name) {
+  Separator();
+  AppendEscaped(name.data(), name.size());
+  buffer_ += ':';
+  need_separator_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(std::string const& v) {
+  Separator();
+  AppendEscaped(v.data(), v.size());
+  need_separator_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(char const* v) {
+  Separator();
+  AppendEscaped(v, std::strlen(v));
+  need_separator_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(bool v) {
+  Separator();
+  buffer_ += v ? "true" : "false";
+  need_separator_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(std::nullptr_t) {
+  Separator();
+  buffer_ += "null";
+  need_separator_ = true;
+  return *this;
+}
+
+void JsonWriter::AppendEscaped(char const* data, std::size_t size) {
+  buffer_.reserve(buffer_.size() + size + 2);
+  buffer_ += '"';
+  // Copy the characters that do not need escaping in as few calls as possible,
+  // most strings (object names, header values, etc.) have no such characters.
+  char const* begin = data;
+  char const* const end = data + size;
+  for (char const* p = data; p != end; ++p) {
+    auto const c = static_cast<unsigned char>(*p);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    buffer_.append(begin, p);
+    begin = p + 1;
+    switch (c) {
+      case '"':
+        buffer_ += "\\\"";
+        break;
+      case '\\':
+        buffer_ += "\\\\";
+        break;
+      case '\b':
+        buffer_ += "\\b";
+        break;
+      case '\f':
+        buffer_ += "\\f";
+        break;
+      case '\n':
+        buffer_ += "\\n";
+        break;
+      case '\r':
+        buffer_ += "\\r";
+        break;
+      case '\t':
+        buffer_ += "\\t";
+        break;
+      default: {
+        static char const kHexDigits[] = "0123456789abcdef";
+        buffer_ += "\\u00";
+        buffer_ += kHexDigits[c >> 4U];
+        buffer_ += kHexDigits[c & 0xFU];
+        break;
+      }
+    }
+  }
+  buffer_.append(begin, end);
+  buffer_ += '"';
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
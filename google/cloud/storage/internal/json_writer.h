@@ -0,0 +1,135 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_JSON_WRITER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_JSON_WRITER_H_
+
+#include "google/cloud/storage/internal/nljson.h"
+#include "google/cloud/storage/version.h"
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Serializes JSON values directly into a string.
+ *
+ * Most request payloads are small JSON objects that are created once, sent,
+ * and discarded. Creating them as `nl::json` objects first requires several
+ * allocations for each field, and then the objects are serialized anyway. This
+ * class appends the serialized JSON to a buffer, typically the request payload,
+ * without creating any intermediate objects.
+ *
+ * The writer does not validate its input: the caller is responsible for
+ * closing any objects and arrays it opens, and for calling `Key()` before each
+ * value in an object. The output is compact, and strings are escaped the same
+ * way as `nl::json::dump()` escapes them.
+ *
+ * @par Example
+ * @code
+ * std::string payload;
+ * JsonWriter writer(payload);
+ * writer.StartObject().Key("entity").Value(entity).EndObject();
+ * @endcode
+ */
+class JsonWriter {
+ public:
+  /// Appends the serialized JSON to @p buffer.
+  explicit JsonWriter(std::string& buffer) : buffer_(buffer) {}
+
+  JsonWriter& StartObject() {
+    Separator();
+    buffer_ += '{';
+    need_separator_ = false;
+    return *this;
+  }
+  JsonWriter& EndObject() {
+    buffer_ += '}';
+    need_separator_ = true;
+    return *this;
+  }
+
+  JsonWriter& StartArray() {
+    Separator();
+    buffer_ += '[';
+    need_separator_ = false;
+    return *this;
+  }
+  JsonWriter& EndArray() {
+    buffer_ += ']';
+    need_separator_ = true;
+    return *this;
+  }
+
+  /// Writes the name of the next field in an object.
+  JsonWriter& Key(char const* name);
+  JsonWriter& Key(std::string const& name);
+
+  //@{
+  /// @name Write a value, in an array or after calling `Key()`.
+  JsonWriter& Value(std::string const& v);
+  JsonWriter& Value(char const* v);
+  JsonWriter& Value(bool v);
+  JsonWriter& Value(std::nullptr_t);
+
+  template <typename Integer,
+            typename std::enable_if<std::is_integral<Integer>::value,
+                                    int>::type = 0>
+  JsonWriter& Value(Integer v) {
+    return RawValue(std::to_string(v));
+  }
+
+  /// Writes a value already represented as a `nl::json` object.
+  JsonWriter& Value(nl::json const& v) { return RawValue(v.dump()); }
+
+  /// Writes @p v as an array, converting each element with `Value()`.
+  template <typename T>
+  JsonWriter& Value(std::vector<T> const& v) {
+    StartArray();
+    // The `static_cast<>` converts the `std::vector<bool>` proxies to `bool`.
+    for (auto const& e : v) Value(static_cast<T const&>(e));
+    return EndArray();
+  }
+
+  /// Writes a value that is already serialized as JSON.
+  JsonWriter& RawValue(std::string const& json) {
+    Separator();
+    buffer_ += json;
+    need_separator_ = true;
+    return *this;
+  }
+  //@}
+
+ private:
+  void Separator() {
+    if (need_separator_) buffer_ += ',';
+  }
+  void AppendEscaped(char const* data, std::size_t size);
+
+  std::string& buffer_;
+  bool need_separator_ = false;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_JSON_WRITER_H_
@@ -0,0 +1,150 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/json_writer.h"
+#include <gmock/gmock.h>
+#include <cstdint>
+#include <limits>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+TEST(JsonWriterTest, Empty) {
+  std::string actual;
+  JsonWriter(actual).StartObject().EndObject();
+  EXPECT_EQ("{}", actual);
+
+  actual.clear();
+  JsonWriter(actual).StartArray().EndArray();
+  EXPECT_EQ("[]", actual);
+}
+
+TEST(JsonWriterTest, AppendsToBuffer) {
+  std::string actual = "prefix:";
+  JsonWriter(actual).StartObject().Key("a").Value(1).EndObject();
+  EXPECT_EQ(R"""(prefix:{"a":1})""", actual);
+}
+
+TEST(JsonWriterTest, Scalars) {
+  std::string actual;
+  JsonWriter writer(actual);
+  writer.StartObject()
+      .Key("string")
+      .Value(std::string("value"))
+      .Key("literal")
+      .Value("literal-value")
+      .Key("true")
+      .Value(true)
+      .Key("false")
+      .Value(false)
+      .Key("null")
+      .Value(nullptr)
+      .Key("int32")
+      .Value(std::numeric_limits<std::int32_t>::min())
+      .Key("int64")
+      .Value(std::numeric_limits<std::int64_t>::min())
+      .Key("uint64")
+      .Value(std::numeric_limits<std::uint64_t>::max())
+      .EndObject();
+
+  nl::json expected{
+      {"string", "value"},
+      {"literal", "literal-value"},
+      {"true", true},
+      {"false", false},
+      {"null", nullptr},
+      {"int32", std::numeric_limits<std::int32_t>::min()},
+      {"int64", std::numeric_limits<std::int64_t>::min()},
+      {"uint64", std::numeric_limits<std::uint64_t>::max()},
+  };
+  EXPECT_EQ(expected, nl::json::parse(actual)) << actual;
+}
+
+TEST(JsonWriterTest, Nested) {
+  std::string actual;
+  JsonWriter writer(actual);
+  writer.StartObject()
+      .Key("a")
+      .StartArray()
+      .StartObject()
+      .Key("b")
+      .Value(1)
+      .EndObject()
+      .StartObject()
+      .EndObject()
+      .StartArray()
+      .Value(2)
+      .Value(3)
+      .EndArray()
+      .EndArray()
+      .Key("c")
+      .StartObject()
+      .Key("d")
+      .Value("e")
+      .EndObject()
+      .EndObject();
+  EXPECT_EQ(R"""({"a":[{"b":1},{},[2,3]],"c":{"d":"e"}})""", actual);
+}
+
+TEST(JsonWriterTest, Vectors) {
+  std::string actual;
+  JsonWriter writer(actual);
+  writer.StartArray()
+      .Value(std::vector<std::string>{"a", "b"})
+      .Value(std::vector<std::int32_t>{2, 3, 5})
+      .Value(std::vector<bool>{false, true})
+      .Value(std::vector<nl::json>{nl::json{{"k", "v"}}})
+      .EndArray();
+  EXPECT_EQ(R"""([["a","b"],[2,3,5],[false,true],[{"k":"v"}]])""", actual);
+}
+
+TEST(JsonWriterTest, RawValues) {
+  std::string actual;
+  JsonWriter writer(actual);
+  writer.StartObject()
+      .Key("raw")
+      .RawValue(R"""({"x":[1,2]})""")
+      .Key("json")
+      .Value(nl::json{{"y", true}})
+      .EndObject();
+  EXPECT_EQ(R"""({"raw":{"x":[1,2]},"json":{"y":true}})""", actual);
+}
+
+/// @test Verify that strings are escaped exactly as `nl::json::dump()` does.
+TEST(JsonWriterTest, EscapeMatchesNlJson) {
+  std::string all_ascii;
+  for (int c = 1; c != 128; ++c) {
+    all_ascii.push_back(static_cast<char>(c));
+  }
+  all_ascii.push_back('\0');
+  std::string const utf8 = "\xC3\xA1\xE2\x82\xAC\xF0\x9F\x98\x80";
+
+  for (auto const& value : {all_ascii, utf8, std::string{}}) {
+    std::string actual;
+    JsonWriter(actual).StartObject().Key(value).Value(value).EndObject();
+    nl::json expected{{value, value}};
+    EXPECT_EQ(expected.dump(), actual);
+  }
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
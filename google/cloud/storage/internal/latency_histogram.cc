@@ -0,0 +1,182 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+// Each power of two is split in 2^kSubBucketBits buckets.
+constexpr int kSubBucketBits = 5;
+constexpr std::int64_t kSubBucketCount = std::int64_t(1) << kSubBucketBits;
+// Values below this threshold are counted exactly.
+constexpr std::int64_t kExactLimit = 2 * kSubBucketCount;
+// Larger values (about 12 days in microseconds) are clamped.
+constexpr int kMaximumExponent = 40;
+constexpr std::int64_t kMaximumValue =
+    (std::int64_t(1) << kMaximumExponent) - 1;
+constexpr std::size_t kBucketCount =
+    (kMaximumExponent - kSubBucketBits + 1) * kSubBucketCount;
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() : buckets_(kBucketCount) {}
+
+void LatencyHistogram::Record(std::chrono::microseconds value) {
+  auto v = (std::min)((std::max)(std::int64_t(value.count()), std::int64_t(0)),
+                      kMaximumValue);
+  ++buckets_[BucketIndex(v)];
+  min_ = count_ == 0 ? v : (std::min)(min_, v);
+  max_ = count_ == 0 ? v : (std::max)(max_, v);
+  ++count_;
+  sum_ += v;
+}
+
+void LatencyHistogram::Merge(LatencyHistogram const& rhs) {
+  if (rhs.count_ == 0) {
+    return;
+  }
+  for (std::size_t i = 0; i != buckets_.size(); ++i) {
+    buckets_[i] += rhs.buckets_[i];
+  }
+  min_ = count_ == 0 ? rhs.min_ : (std::min)(min_, rhs.min_);
+  max_ = count_ == 0 ? rhs.max_ : (std::max)(max_, rhs.max_);
+  count_ += rhs.count_;
+  sum_ += rhs.sum_;
+}
+
+void LatencyHistogram::Clear() {
+  std::fill(buckets_.begin(), buckets_.end(), 0);
+  count_ = 0;
+  sum_ = 0;
+  min_ = 0;
+  max_ = 0;
+}
+
+std::chrono::microseconds LatencyHistogram::min() const {
+  return std::chrono::microseconds(min_);
+}
+
+std::chrono::microseconds LatencyHistogram::max() const {
+  return std::chrono::microseconds(max_);
+}
+
+std::chrono::microseconds LatencyHistogram::mean() const {
+  if (count_ == 0) {
+    return std::chrono::microseconds(0);
+  }
+  return std::chrono::microseconds(sum_ / static_cast<std::int64_t>(count_));
+}
+
+std::chrono::microseconds LatencyHistogram::Percentile(
+    double percentile) const {
+  if (count_ == 0) {
+    return std::chrono::microseconds(0);
+  }
+  percentile = (std::min)((std::max)(percentile, 0.0), 100.0);
+  // The rank of the value, in the [1, count_] range.
+  auto rank = static_cast<std::uint64_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(count_)));
+  rank = (std::max)(rank, std::uint64_t(1));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i != buckets_.size(); ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::chrono::microseconds(
+          (std::min)((std::max)(BucketUpperBound(i), min_), max_));
+    }
+  }
+  return std::chrono::microseconds(max_);
+}
+
+std::size_t LatencyHistogram::BucketIndex(std::int64_t value) {
+  if (value < kExactLimit) {
+    return static_cast<std::size_t>(value);
+  }
+  int exponent = 0;
+  for (auto v = value; v > 1; v >>= 1) {
+    ++exponent;
+  }
+  // The top kSubBucketBits + 1 bits of the value, in the
+  // [kSubBucketCount, 2 * kSubBucketCount) range.
+  auto mantissa = value >> (exponent - kSubBucketBits);
+  return static_cast<std::size_t>((exponent - kSubBucketBits + 1) *
+                                      kSubBucketCount +
+                                  (mantissa - kSubBucketCount));
+}
+
+std::int64_t LatencyHistogram::BucketUpperBound(std::size_t index) {
+  auto i = static_cast<std::int64_t>(index);
+  if (i < kExactLimit) {
+    return i;
+  }
+  auto exponent = i / kSubBucketCount + kSubBucketBits - 1;
+  auto mantissa = i % kSubBucketCount + kSubBucketCount;
+  return ((mantissa + 1) << (exponent - kSubBucketBits)) - 1;
+}
+
+ConcurrentLatencyHistogram::ConcurrentLatencyHistogram()
+    : buckets_(new std::atomic<std::uint64_t>[kBucketCount]),
+      sum_(0),
+      min_((std::numeric_limits<std::int64_t>::max)()),
+      max_(0) {
+  for (std::size_t i = 0; i != kBucketCount; ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void ConcurrentLatencyHistogram::Record(std::chrono::microseconds value) {
+  auto v = (std::min)((std::max)(std::int64_t(value.count()), std::int64_t(0)),
+                      kMaximumValue);
+  sum_.fetch_add(v, std::memory_order_relaxed);
+  auto current = min_.load(std::memory_order_relaxed);
+  while (v < current && !min_.compare_exchange_weak(
+                            current, v, std::memory_order_relaxed)) {
+  }
+  current = max_.load(std::memory_order_relaxed);
+  while (v > current && !max_.compare_exchange_weak(
+                            current, v, std::memory_order_relaxed)) {
+  }
+  // Publish the bucket last, any reader that sees this value in the bucket
+  // also sees the updates to the sum, the minimum, and the maximum.
+  buckets_[LatencyHistogram::BucketIndex(v)].fetch_add(
+      1, std::memory_order_release);
+}
+
+void ConcurrentLatencyHistogram::MergeInto(
+    LatencyHistogram& destination) const {
+  LatencyHistogram copy;
+  for (std::size_t i = 0; i != kBucketCount; ++i) {
+    copy.buckets_[i] = buckets_[i].load(std::memory_order_acquire);
+    copy.count_ += copy.buckets_[i];
+  }
+  if (copy.count_ == 0) {
+    return;
+  }
+  copy.sum_ = sum_.load(std::memory_order_relaxed);
+  copy.min_ = min_.load(std::memory_order_relaxed);
+  copy.max_ = max_.load(std::memory_order_relaxed);
+  destination.Merge(copy);
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
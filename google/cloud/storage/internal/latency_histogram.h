@@ -0,0 +1,114 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_LATENCY_HISTOGRAM_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_LATENCY_HISTOGRAM_H_
+
+#include "google/cloud/storage/version.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * A fixed-memory histogram of latencies with bounded relative error.
+ *
+ * Values are recorded in microseconds. Values below 64 are counted exactly,
+ * larger values are counted in buckets: each power of two is split into 32
+ * buckets of equal width, so the relative error of any percentile is below
+ * 1/32 (about 3%). The memory used is constant, recording a value is a few
+ * arithmetic operations, and histograms can be merged, which makes it
+ * possible to keep one histogram per thread and combine them to report.
+ *
+ * This class is not thread-safe, callers must provide any synchronization.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  /// Record a single value, negative values are recorded as zero.
+  void Record(std::chrono::microseconds value);
+
+  /// Add all the values recorded in @p rhs to this histogram.
+  void Merge(LatencyHistogram const& rhs);
+
+  /// Discard all the recorded values.
+  void Clear();
+
+  std::uint64_t count() const { return count_; }
+  std::chrono::microseconds min() const;
+  std::chrono::microseconds max() const;
+  std::chrono::microseconds mean() const;
+
+  /**
+   * Returns the value at the given percentile.
+   *
+   * @param percentile a number in the [0, 100] range, values outside the range
+   *     are clamped.
+   * @return the largest value in the bucket that contains the percentile,
+   *     clamped to the observed maximum. Zero if the histogram is empty.
+   */
+  std::chrono::microseconds Percentile(double percentile) const;
+
+ private:
+  friend class ConcurrentLatencyHistogram;
+  static std::size_t BucketIndex(std::int64_t value);
+  static std::int64_t BucketUpperBound(std::size_t index);
+
+  std::vector<std::uint64_t> buckets_;
+  std::uint64_t count_ = 0;
+  std::int64_t sum_ = 0;
+  std::int64_t min_ = 0;
+  std::int64_t max_ = 0;
+};
+
+/**
+ * A histogram with the same buckets as `LatencyHistogram`, safe to update
+ * from multiple threads without locks.
+ *
+ * `Record()` only uses atomic operations, and it never allocates. Readers
+ * call `MergeInto()` to get a consistent-enough copy: each value is either
+ * fully counted or not counted at all, but values recorded while the copy is
+ * made may be missed.
+ */
+class ConcurrentLatencyHistogram {
+ public:
+  ConcurrentLatencyHistogram();
+
+  /// Record a single value, negative values are recorded as zero.
+  void Record(std::chrono::microseconds value);
+
+  /// Add the values recorded so far to @p destination.
+  void MergeInto(LatencyHistogram& destination) const;
+
+ private:
+  std::unique_ptr<std::atomic<std::uint64_t>[]> buckets_;
+  std::atomic<std::int64_t> sum_;
+  std::atomic<std::int64_t> min_;
+  std::atomic<std::int64_t> max_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,129 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/latency_histogram.h"
+#include <gmock/gmock.h>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using us = std::chrono::microseconds;
+
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0U, histogram.count());
+  EXPECT_EQ(0, histogram.Percentile(50).count());
+  EXPECT_EQ(0, histogram.mean().count());
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 50; ++i) {
+    histogram.Record(us(i));
+  }
+  EXPECT_EQ(50U, histogram.count());
+  EXPECT_EQ(1, histogram.min().count());
+  EXPECT_EQ(50, histogram.max().count());
+  EXPECT_EQ(25, histogram.mean().count());
+  EXPECT_EQ(1, histogram.Percentile(0).count());
+  EXPECT_EQ(25, histogram.Percentile(50).count());
+  EXPECT_EQ(45, histogram.Percentile(90).count());
+  EXPECT_EQ(50, histogram.Percentile(100).count());
+}
+
+TEST(LatencyHistogramTest, BoundedRelativeError) {
+  LatencyHistogram histogram;
+  for (std::int64_t i = 1; i <= 100000; ++i) {
+    histogram.Record(us(i * 10));
+  }
+  for (double p : {10.0, 50.0, 90.0, 99.0, 99.9}) {
+    auto const expected = p / 100.0 * 1000000;
+    auto const actual = static_cast<double>(histogram.Percentile(p).count());
+    EXPECT_NEAR(expected, actual, expected / 32) << "p=" << p;
+  }
+  EXPECT_EQ(1000000, histogram.Percentile(100).count());
+}
+
+TEST(LatencyHistogramTest, NegativeAndLargeValues) {
+  LatencyHistogram histogram;
+  histogram.Record(us(-5));
+  EXPECT_EQ(0, histogram.max().count());
+  auto const large = std::chrono::hours(24 * 365);
+  histogram.Record(large);
+  EXPECT_LT(0, histogram.max().count());
+  EXPECT_GT(std::chrono::duration_cast<us>(large).count(),
+            histogram.max().count());
+}
+
+TEST(LatencyHistogramTest, Merge) {
+  LatencyHistogram a;
+  LatencyHistogram b;
+  for (int i = 0; i != 100; ++i) {
+    a.Record(us(1000));
+    b.Record(us(3000));
+  }
+  a.Merge(b);
+  EXPECT_EQ(200U, a.count());
+  EXPECT_EQ(1000, a.min().count());
+  EXPECT_EQ(3000, a.max().count());
+  EXPECT_EQ(2000, a.mean().count());
+  EXPECT_NEAR(1000, a.Percentile(25).count(), 1000 / 32);
+  EXPECT_NEAR(3000, a.Percentile(75).count(), 3000 / 32);
+
+  a.Clear();
+  EXPECT_EQ(0U, a.count());
+  EXPECT_EQ(0, a.Percentile(50).count());
+}
+
+TEST(ConcurrentLatencyHistogramTest, MergeInto) {
+  ConcurrentLatencyHistogram histogram;
+  LatencyHistogram empty;
+  histogram.MergeInto(empty);
+  EXPECT_EQ(0U, empty.count());
+
+  auto worker = [&histogram](std::int64_t value) {
+    for (int i = 0; i != 1000; ++i) {
+      histogram.Record(us(value));
+    }
+  };
+  std::vector<std::thread> threads;
+  for (std::int64_t value : {1000, 2000, 3000, 4000}) {
+    threads.emplace_back(worker, value);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  LatencyHistogram result;
+  result.Record(us(5000));
+  histogram.MergeInto(result);
+  EXPECT_EQ(4001U, result.count());
+  EXPECT_EQ(1000, result.min().count());
+  EXPECT_EQ(5000, result.max().count());
+  EXPECT_NEAR(1000, result.Percentile(20).count(), 1000 / 32);
+  EXPECT_NEAR(4000, result.Percentile(99).count(), 4000 / 32);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -16,6 +16,7 @@
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_LOGGING_CLIENT_H_
 
 #include "google/cloud/storage/internal/raw_client.h"
+#include "google/cloud/storage/internal/tracing_sampler.h"
 #include "google/cloud/storage/version.h"
 
 namespace google {
@@ -25,10 +26,14 @@ inline namespace STORAGE_CLIENT_NS {
 namespace internal {
 /**
  * A decorator for `RawClient` that logs each operation.
+ *
+ * Only the operations selected by the `TracingSampling` policy are logged, by
+ * default all of them.
  */
 class LoggingClient : public RawClient {
  public:
-  explicit LoggingClient(std::shared_ptr<RawClient> client);
+  explicit LoggingClient(std::shared_ptr<RawClient> client,
+                         TracingSampling sampling = TracingSampling());
   ~LoggingClient() override = default;
 
   ClientOptions const& client_options() const override;
@@ -62,6 +67,8 @@ class LoggingClient : public RawClient {
   StatusOr<std::unique_ptr<ObjectReadSource>> ReadObject(
       ReadObjectRangeRequest const&) override;
   StatusOr<ListObjectsResponse> ListObjects(ListObjectsRequest const&) override;
+  StatusOr<ListObjectSummariesResponse> ListObjectSummaries(
+      ListObjectsRequest const&) override;
   StatusOr<EmptyResponse> DeleteObject(DeleteObjectRequest const&) override;
   StatusOr<ObjectMetadata> UpdateObject(
       UpdateObjectRequest const& request) override;
@@ -139,6 +146,7 @@ class LoggingClient : public RawClient {
 
  private:
   std::shared_ptr<RawClient> client_;
+  TracingSampler sampler_;
 };
 
 }  // namespace internal
@@ -180,6 +180,50 @@ TEST_F(LoggingClientTest, ListObjects) {
   client.ListObjects(ListObjectsRequest("my-bucket"));
 }
 
+TEST_F(LoggingClientTest, SampledOnlyLogsSelectedCalls) {
+  auto mock = std::make_shared<testing::MockClient>();
+  EXPECT_CALL(*mock, GetBucketMetadata(_))
+      .Times(4)
+      .WillRepeatedly(Return(StatusOr<BucketMetadata>(BucketMetadata())));
+
+  // With a sample period of 2 only the first and third calls are logged, and
+  // each logs the request and the response.
+  EXPECT_CALL(*log_backend, ProcessWithOwnership(_)).Times(4);
+
+  TracingSampling sampling;
+  sampling.sample_period = 2;
+  LoggingClient client(mock, sampling);
+  for (int i = 0; i != 4; ++i) {
+    client.GetBucketMetadata(GetBucketMetadataRequest("my-bucket"));
+  }
+}
+
+TEST_F(LoggingClientTest, SampledLogsFailures) {
+  auto mock = std::make_shared<testing::MockClient>();
+  EXPECT_CALL(*mock, GetBucketMetadata(_))
+      .WillOnce(Return(StatusOr<BucketMetadata>(BucketMetadata())))
+      .WillOnce(Return(StatusOr<BucketMetadata>(TransientError())));
+
+  // Only the failed call is logged, once it completes.
+  EXPECT_CALL(*log_backend, ProcessWithOwnership(_))
+      .WillOnce(Invoke([](LogRecord lr) {
+        EXPECT_THAT(lr.message, HasSubstr(" << "));
+        EXPECT_THAT(lr.message, HasSubstr("GetBucketMetadataRequest={"));
+        EXPECT_THAT(lr.message, HasSubstr("my-bucket"));
+      }))
+      .WillOnce(Invoke([](LogRecord lr) {
+        EXPECT_THAT(lr.message, HasSubstr(" >> "));
+        EXPECT_THAT(lr.message, HasSubstr("elapsed="));
+        EXPECT_THAT(lr.message, HasSubstr("status={"));
+      }));
+
+  TracingSampling sampling;
+  sampling.sample_period = 0;
+  LoggingClient client(mock, sampling);
+  client.GetBucketMetadata(GetBucketMetadataRequest("my-bucket"));
+  client.GetBucketMetadata(GetBucketMetadataRequest("my-bucket"));
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
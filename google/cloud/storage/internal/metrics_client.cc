@@ -0,0 +1,754 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/metrics_client.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/storage/internal/raw_client_wrapper_utils.h"
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <type_traits>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+namespace {
+
+using ::google::cloud::storage::internal::raw_client_wrapper_utils::Signature;
+
+/// The operations measured by `MetricsClient`.
+enum Operation : std::size_t {
+  kListBuckets,
+  kCreateBucket,
+  kGetBucketMetadata,
+  kDeleteBucket,
+  kUpdateBucket,
+  kPatchBucket,
+  kGetBucketIamPolicy,
+  kSetBucketIamPolicy,
+  kTestBucketIamPermissions,
+  kLockBucketRetentionPolicy,
+  kInsertObjectMedia,
+  kCopyObject,
+  kGetObjectMetadata,
+  kReadObject,
+  kListObjects,
+  kListObjectSummaries,
+  kDeleteObject,
+  kUpdateObject,
+  kPatchObject,
+  kComposeObject,
+  kRewriteObject,
+  kCreateResumableSession,
+  kRestoreResumableSession,
+  kListBucketAcl,
+  kGetBucketAcl,
+  kCreateBucketAcl,
+  kDeleteBucketAcl,
+  kUpdateBucketAcl,
+  kPatchBucketAcl,
+  kListObjectAcl,
+  kCreateObjectAcl,
+  kDeleteObjectAcl,
+  kGetObjectAcl,
+  kUpdateObjectAcl,
+  kPatchObjectAcl,
+  kListDefaultObjectAcl,
+  kCreateDefaultObjectAcl,
+  kDeleteDefaultObjectAcl,
+  kGetDefaultObjectAcl,
+  kUpdateDefaultObjectAcl,
+  kPatchDefaultObjectAcl,
+  kGetServiceAccount,
+  kListHmacKeys,
+  kCreateHmacKey,
+  kDeleteHmacKey,
+  kGetHmacKey,
+  kUpdateHmacKey,
+  kSignBlob,
+  kListNotifications,
+  kCreateNotification,
+  kGetNotification,
+  kDeleteNotification,
+  kUploadChunk,
+  kUploadFinalChunk,
+  kResetSession,
+  kOperationCount
+};
+
+char const* const kOperationNames[kOperationCount] = {
+    "ListBuckets",
+    "CreateBucket",
+    "GetBucketMetadata",
+    "DeleteBucket",
+    "UpdateBucket",
+    "PatchBucket",
+    "GetBucketIamPolicy",
+    "SetBucketIamPolicy",
+    "TestBucketIamPermissions",
+    "LockBucketRetentionPolicy",
+    "InsertObjectMedia",
+    "CopyObject",
+    "GetObjectMetadata",
+    "ReadObject",
+    "ListObjects",
+    "ListObjectSummaries",
+    "DeleteObject",
+    "UpdateObject",
+    "PatchObject",
+    "ComposeObject",
+    "RewriteObject",
+    "CreateResumableSession",
+    "RestoreResumableSession",
+    "ListBucketAcl",
+    "GetBucketAcl",
+    "CreateBucketAcl",
+    "DeleteBucketAcl",
+    "UpdateBucketAcl",
+    "PatchBucketAcl",
+    "ListObjectAcl",
+    "CreateObjectAcl",
+    "DeleteObjectAcl",
+    "GetObjectAcl",
+    "UpdateObjectAcl",
+    "PatchObjectAcl",
+    "ListDefaultObjectAcl",
+    "CreateDefaultObjectAcl",
+    "DeleteDefaultObjectAcl",
+    "GetDefaultObjectAcl",
+    "UpdateDefaultObjectAcl",
+    "PatchDefaultObjectAcl",
+    "GetServiceAccount",
+    "ListHmacKeys",
+    "CreateHmacKey",
+    "DeleteHmacKey",
+    "GetHmacKey",
+    "UpdateHmacKey",
+    "SignBlob",
+    "ListNotifications",
+    "CreateNotification",
+    "GetNotification",
+    "DeleteNotification",
+    "UploadChunk",
+    "UploadFinalChunk",
+    "ResetSession",
+};
+
+// `StatusCode` values are in the [0, kStatusCodeCount) range.
+constexpr std::size_t kStatusCodeCount =
+    static_cast<std::underlying_type<StatusCode>::type>(
+        StatusCode::kUnauthenticated) +
+    1;
+
+// The number of shards for the counters. Threads are assigned to shards in
+// round-robin order, more shards reduce contention but use more memory.
+constexpr std::size_t kShardCount = 16;
+
+std::size_t CurrentShard() {
+  static std::atomic<std::size_t> next_shard(0);
+  static thread_local std::size_t const shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+  return shard;
+}
+}  // namespace
+
+/// Holds the counters for a `MetricsRecorder`.
+class MetricsRecorderImpl {
+ public:
+  MetricsRecorderImpl() : shards_(kShardCount) {
+    for (auto& s : shards_) {
+      s = google::cloud::internal::make_unique<Shard>();
+    }
+  }
+
+  void Record(Operation operation, Status const& status,
+              std::chrono::steady_clock::duration latency,
+              std::uint64_t bytes_sent) {
+    auto& counters = shards_[CurrentShard()]->operations[operation];
+    auto code = static_cast<std::size_t>(status.code());
+    if (code >= kStatusCodeCount) {
+      code = static_cast<std::size_t>(StatusCode::kUnknown);
+    }
+    counters.calls[code].fetch_add(1, std::memory_order_relaxed);
+    if (bytes_sent != 0) {
+      counters.bytes_sent.fetch_add(bytes_sent, std::memory_order_relaxed);
+    }
+    auto* histogram = counters.latency.load(std::memory_order_acquire);
+    if (histogram == nullptr) {
+      histogram = CreateHistogram(counters);
+    }
+    histogram->Record(
+        std::chrono::duration_cast<std::chrono::microseconds>(latency));
+  }
+
+  void AddBytesReceived(Operation operation, std::uint64_t bytes) {
+    shards_[CurrentShard()]->operations[operation].bytes_received.fetch_add(
+        bytes, std::memory_order_relaxed);
+  }
+
+  std::vector<OperationMetrics> Snapshot() const {
+    std::vector<OperationMetrics> result;
+    for (std::size_t op = 0; op != kOperationCount; ++op) {
+      OperationMetrics metrics;
+      metrics.name = kOperationNames[op];
+      std::uint64_t success_count = 0;
+      for (auto const& shard : shards_) {
+        auto const& counters = shard->operations[op];
+        success_count += counters.calls[0].load(std::memory_order_relaxed);
+        for (std::size_t code = 1; code != kStatusCodeCount; ++code) {
+          auto n = counters.calls[code].load(std::memory_order_relaxed);
+          if (n != 0) {
+            metrics.errors[static_cast<StatusCode>(code)] += n;
+            metrics.error_count += n;
+          }
+        }
+        metrics.bytes_sent +=
+            counters.bytes_sent.load(std::memory_order_relaxed);
+        metrics.bytes_received +=
+            counters.bytes_received.load(std::memory_order_relaxed);
+        auto* histogram = counters.latency.load(std::memory_order_acquire);
+        if (histogram != nullptr) {
+          histogram->MergeInto(metrics.latency);
+        }
+      }
+      metrics.count = success_count + metrics.error_count;
+      if (metrics.count != 0) {
+        result.push_back(std::move(metrics));
+      }
+    }
+    return result;
+  }
+
+ private:
+  struct Counters {
+    Counters() : bytes_sent(0), bytes_received(0), latency(nullptr) {
+      for (auto& c : calls) {
+        c.store(0, std::memory_order_relaxed);
+      }
+    }
+    ~Counters() { delete latency.load(); }
+
+    // The calls completed with each status code, the successful calls are
+    // counted in `calls[0]`.
+    std::atomic<std::uint64_t> calls[kStatusCodeCount];
+    std::atomic<std::uint64_t> bytes_sent;
+    std::atomic<std::uint64_t> bytes_received;
+    // Allocated on first use, most applications use only a few operations.
+    std::atomic<ConcurrentLatencyHistogram*> latency;
+  };
+
+  struct Shard {
+    Counters operations[kOperationCount];
+  };
+
+  static ConcurrentLatencyHistogram* CreateHistogram(Counters& counters) {
+    auto* histogram = new ConcurrentLatencyHistogram;
+    ConcurrentLatencyHistogram* expected = nullptr;
+    if (counters.latency.compare_exchange_strong(expected, histogram,
+                                                 std::memory_order_acq_rel)) {
+      return histogram;
+    }
+    // Another thread in the same shard won the race, use its histogram.
+    delete histogram;
+    return expected;
+  }
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+namespace {
+/**
+ * Measures a single call.
+ *
+ * @param recorder where the results are recorded.
+ * @param operation the operation to record the results under.
+ * @param bytes_sent the size of the payload sent in the call, if any.
+ * @param call the functor to make the call.
+ * @return the result of calling @p call.
+ */
+template <typename Functor>
+auto Measure(MetricsRecorderImpl& recorder, Operation operation,
+             std::uint64_t bytes_sent, Functor&& call) -> decltype(call()) {
+  auto const start = std::chrono::steady_clock::now();
+  auto result = call();
+  recorder.Record(operation, result.status(),
+                  std::chrono::steady_clock::now() - start, bytes_sent);
+  return result;
+}
+
+/**
+ * Measures a `RawClient` operation.
+ *
+ * @tparam MemberFunction the signature of the member function.
+ * @param recorder where the results are recorded.
+ * @param operation the operation to record the results under.
+ * @param client the storage::RawClient object to make the call through.
+ * @param function the pointer to the member function to call.
+ * @param request an initialized request parameter for the call.
+ * @param bytes_sent the size of the payload sent in the call, if any.
+ * @return the result from making the call;
+ */
+template <typename MemberFunction>
+typename Signature<MemberFunction>::ReturnType MakeCall(
+    MetricsRecorderImpl& recorder, Operation operation, RawClient& client,
+    MemberFunction function,
+    typename Signature<MemberFunction>::RequestType const& request,
+    std::uint64_t bytes_sent = 0) {
+  return Measure(recorder, operation, bytes_sent,
+                 [&client, function, &request] {
+                   return (client.*function)(request);
+                 });
+}
+
+/// Counts the bytes received by a download.
+class MetricsObjectReadSource : public ObjectReadSource {
+ public:
+  MetricsObjectReadSource(std::shared_ptr<MetricsRecorderImpl> recorder,
+                          std::unique_ptr<ObjectReadSource> source)
+      : recorder_(std::move(recorder)), source_(std::move(source)) {}
+
+  bool IsOpen() const override { return source_->IsOpen(); }
+  StatusOr<HttpResponse> Close() override { return source_->Close(); }
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override {
+    auto result = source_->Read(buf, n);
+    if (result.ok()) {
+      recorder_->AddBytesReceived(kReadObject, result->bytes_received);
+    }
+    return result;
+  }
+
+ private:
+  std::shared_ptr<MetricsRecorderImpl> recorder_;
+  std::unique_ptr<ObjectReadSource> source_;
+};
+
+/// Measures each chunk sent by a resumable upload.
+class MetricsResumableUploadSession : public ResumableUploadSession {
+ public:
+  MetricsResumableUploadSession(std::shared_ptr<MetricsRecorderImpl> recorder,
+                                std::unique_ptr<ResumableUploadSession> session)
+      : recorder_(std::move(recorder)), session_(std::move(session)) {}
+
+  StatusOr<ResumableUploadResponse> UploadChunk(
+      std::string const& buffer) override {
+    return Measure(*recorder_, kUploadChunk, buffer.size(), [this, &buffer] {
+      return session_->UploadChunk(buffer);
+    });
+  }
+  StatusOr<ResumableUploadResponse> UploadFinalChunk(
+      std::string const& buffer, std::uint64_t upload_size) override {
+    return Measure(*recorder_, kUploadFinalChunk, buffer.size(),
+                   [this, &buffer, upload_size] {
+                     return session_->UploadFinalChunk(buffer, upload_size);
+                   });
+  }
+  StatusOr<ResumableUploadResponse> ResetSession() override {
+    return Measure(*recorder_, kResetSession, 0,
+                   [this] { return session_->ResetSession(); });
+  }
+  std::uint64_t next_expected_byte() const override {
+    return session_->next_expected_byte();
+  }
+  std::string const& session_id() const override {
+    return session_->session_id();
+  }
+  StatusOr<ResumableUploadResponse> const& last_response() const override {
+    return session_->last_response();
+  }
+  bool done() const override { return session_->done(); }
+
+ private:
+  std::shared_ptr<MetricsRecorderImpl> recorder_;
+  std::unique_ptr<ResumableUploadSession> session_;
+};
+
+StatusOr<std::unique_ptr<ResumableUploadSession>> WrapSession(
+    std::shared_ptr<MetricsRecorderImpl> recorder,
+    StatusOr<std::unique_ptr<ResumableUploadSession>> session) {
+  if (!session.ok()) {
+    return session;
+  }
+  return std::unique_ptr<ResumableUploadSession>(
+      google::cloud::internal::make_unique<MetricsResumableUploadSession>(
+          std::move(recorder), std::move(session).value()));
+}
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, OperationMetrics const& rhs) {
+  os << rhs.name << "={count=" << rhs.count
+     << ", error_count=" << rhs.error_count << ", errors={";
+  char const* sep = "";
+  for (auto const& kv : rhs.errors) {
+    os << sep << StatusCodeToString(kv.first) << "=" << kv.second;
+    sep = ", ";
+  }
+  return os << "}, bytes_sent=" << rhs.bytes_sent
+            << ", bytes_received=" << rhs.bytes_received
+            << ", latency_p50=" << rhs.latency.Percentile(50).count()
+            << "us, latency_p99=" << rhs.latency.Percentile(99).count()
+            << "us, latency_max=" << rhs.latency.max().count() << "us}";
+}
+
+MetricsRecorder::MetricsRecorder()
+    : impl_(std::make_shared<MetricsRecorderImpl>()) {}
+
+std::vector<OperationMetrics> MetricsRecorder::Snapshot() const {
+  return impl_->Snapshot();
+}
+
+MetricsClient::MetricsClient(std::shared_ptr<RawClient> client)
+    : MetricsClient(std::move(client), std::make_shared<MetricsRecorder>()) {}
+
+MetricsClient::MetricsClient(std::shared_ptr<RawClient> client,
+                             std::shared_ptr<MetricsRecorder> const& recorder)
+    : client_(std::move(client)), recorder_(recorder->impl_) {}
+
+std::vector<OperationMetrics> MetricsClient::Snapshot() const {
+  return recorder_->Snapshot();
+}
+
+ClientOptions const& MetricsClient::client_options() const {
+  return client_->client_options();
+}
+
+StatusOr<ListBucketsResponse> MetricsClient::ListBuckets(
+    ListBucketsRequest const& request) {
+  return MakeCall(*recorder_, kListBuckets, *client_,
+                  &RawClient::ListBuckets, request);
+}
+
+StatusOr<BucketMetadata> MetricsClient::CreateBucket(
+    CreateBucketRequest const& request) {
+  return MakeCall(*recorder_, kCreateBucket, *client_,
+                  &RawClient::CreateBucket, request);
+}
+
+StatusOr<BucketMetadata> MetricsClient::GetBucketMetadata(
+    GetBucketMetadataRequest const& request) {
+  return MakeCall(*recorder_, kGetBucketMetadata, *client_,
+                  &RawClient::GetBucketMetadata, request);
+}
+
+StatusOr<EmptyResponse> MetricsClient::DeleteBucket(
+    DeleteBucketRequest const& request) {
+  return MakeCall(*recorder_, kDeleteBucket, *client_,
+                  &RawClient::DeleteBucket, request);
+}
+
+StatusOr<BucketMetadata> MetricsClient::UpdateBucket(
+    UpdateBucketRequest const& request) {
+  return MakeCall(*recorder_, kUpdateBucket, *client_,
+                  &RawClient::UpdateBucket, request);
+}
+
+StatusOr<BucketMetadata> MetricsClient::PatchBucket(
+    PatchBucketRequest const& request) {
+  return MakeCall(*recorder_, kPatchBucket, *client_,
+                  &RawClient::PatchBucket, request);
+}
+
+StatusOr<IamPolicy> MetricsClient::GetBucketIamPolicy(
+    GetBucketIamPolicyRequest const& request) {
+  return MakeCall(*recorder_, kGetBucketIamPolicy, *client_,
+                  &RawClient::GetBucketIamPolicy, request);
+}
+
+StatusOr<IamPolicy> MetricsClient::SetBucketIamPolicy(
+    SetBucketIamPolicyRequest const& request) {
+  return MakeCall(*recorder_, kSetBucketIamPolicy, *client_,
+                  &RawClient::SetBucketIamPolicy, request);
+}
+
+StatusOr<TestBucketIamPermissionsResponse>
+MetricsClient::TestBucketIamPermissions(
+    TestBucketIamPermissionsRequest const& request) {
+  return MakeCall(*recorder_, kTestBucketIamPermissions, *client_,
+                  &RawClient::TestBucketIamPermissions, request);
+}
+
+StatusOr<BucketMetadata> MetricsClient::LockBucketRetentionPolicy(
+    LockBucketRetentionPolicyRequest const& request) {
+  return MakeCall(*recorder_, kLockBucketRetentionPolicy, *client_,
+                  &RawClient::LockBucketRetentionPolicy, request);
+}
+
+StatusOr<ObjectMetadata> MetricsClient::InsertObjectMedia(
+    InsertObjectMediaRequest const& request) {
+  return MakeCall(*recorder_, kInsertObjectMedia, *client_,
+                  &RawClient::InsertObjectMedia, request,
+                  request.contents().size());
+}
+
+StatusOr<ObjectMetadata> MetricsClient::CopyObject(
+    CopyObjectRequest const& request) {
+  return MakeCall(*recorder_, kCopyObject, *client_,
+                  &RawClient::CopyObject, request);
+}
+
+StatusOr<ObjectMetadata> MetricsClient::GetObjectMetadata(
+    GetObjectMetadataRequest const& request) {
+  return MakeCall(*recorder_, kGetObjectMetadata, *client_,
+                  &RawClient::GetObjectMetadata, request);
+}
+
+StatusOr<std::unique_ptr<ObjectReadSource>> MetricsClient::ReadObject(
+    ReadObjectRangeRequest const& request) {
+  auto result = MakeCall(*recorder_, kReadObject, *client_,
+                         &RawClient::ReadObject, request);
+  if (!result.ok()) {
+    return result;
+  }
+  return std::unique_ptr<ObjectReadSource>(
+      google::cloud::internal::make_unique<MetricsObjectReadSource>(
+          recorder_, std::move(result).value()));
+}
+
+StatusOr<ListObjectsResponse> MetricsClient::ListObjects(
+    ListObjectsRequest const& request) {
+  return MakeCall(*recorder_, kListObjects, *client_,
+                  &RawClient::ListObjects, request);
+}
+
+StatusOr<ListObjectSummariesResponse> MetricsClient::ListObjectSummaries(
+    ListObjectsRequest const& request) {
+  return MakeCall(*recorder_, kListObjectSummaries, *client_,
+                  &RawClient::ListObjectSummaries, request);
+}
+
+StatusOr<EmptyResponse> MetricsClient::DeleteObject(
+    DeleteObjectRequest const& request) {
+  return MakeCall(*recorder_, kDeleteObject, *client_,
+                  &RawClient::DeleteObject, request);
+}
+
+StatusOr<ObjectMetadata> MetricsClient::UpdateObject(
+    UpdateObjectRequest const& request) {
+  return MakeCall(*recorder_, kUpdateObject, *client_,
+                  &RawClient::UpdateObject, request);
+}
+
+StatusOr<ObjectMetadata> MetricsClient::PatchObject(
+    PatchObjectRequest const& request) {
+  return MakeCall(*recorder_, kPatchObject, *client_,
+                  &RawClient::PatchObject, request);
+}
+
+StatusOr<ObjectMetadata> MetricsClient::ComposeObject(
+    ComposeObjectRequest const& request) {
+  return MakeCall(*recorder_, kComposeObject, *client_,
+                  &RawClient::ComposeObject, request);
+}
+
+StatusOr<RewriteObjectResponse> MetricsClient::RewriteObject(
+    RewriteObjectRequest const& request) {
+  return MakeCall(*recorder_, kRewriteObject, *client_,
+                  &RawClient::RewriteObject, request);
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+MetricsClient::CreateResumableSession(ResumableUploadRequest const& request) {
+  return WrapSession(recorder_,
+                     MakeCall(*recorder_, kCreateResumableSession, *client_,
+                              &RawClient::CreateResumableSession, request));
+}
+
+StatusOr<std::unique_ptr<ResumableUploadSession>>
+MetricsClient::RestoreResumableSession(std::string const& request) {
+  return WrapSession(recorder_,
+                     MakeCall(*recorder_, kRestoreResumableSession, *client_,
+                              &RawClient::RestoreResumableSession, request));
+}
+
+StatusOr<ListBucketAclResponse> MetricsClient::ListBucketAcl(
+    ListBucketAclRequest const& request) {
+  return MakeCall(*recorder_, kListBucketAcl, *client_,
+                  &RawClient::ListBucketAcl, request);
+}
+
+StatusOr<BucketAccessControl> MetricsClient::GetBucketAcl(
+    GetBucketAclRequest const& request) {
+  return MakeCall(*recorder_, kGetBucketAcl, *client_,
+                  &RawClient::GetBucketAcl, request);
+}
+
+StatusOr<BucketAccessControl> MetricsClient::CreateBucketAcl(
+    CreateBucketAclRequest const& request) {
+  return MakeCall(*recorder_, kCreateBucketAcl, *client_,
+                  &RawClient::CreateBucketAcl, request);
+}
+
+StatusOr<EmptyResponse> MetricsClient::DeleteBucketAcl(
+    DeleteBucketAclRequest const& request) {
+  return MakeCall(*recorder_, kDeleteBucketAcl, *client_,
+                  &RawClient::DeleteBucketAcl, request);
+}
+
+StatusOr<BucketAccessControl> MetricsClient::UpdateBucketAcl(
+    UpdateBucketAclRequest const& request) {
+  return MakeCall(*recorder_, kUpdateBucketAcl, *client_,
+                  &RawClient::UpdateBucketAcl, request);
+}
+
+StatusOr<BucketAccessControl> MetricsClient::PatchBucketAcl(
+    PatchBucketAclRequest const& request) {
+  return MakeCall(*recorder_, kPatchBucketAcl, *client_,
+                  &RawClient::PatchBucketAcl, request);
+}
+
+StatusOr<ListObjectAclResponse> MetricsClient::ListObjectAcl(
+    ListObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kListObjectAcl, *client_,
+                  &RawClient::ListObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> MetricsClient::CreateObjectAcl(
+    CreateObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kCreateObjectAcl, *client_,
+                  &RawClient::CreateObjectAcl, request);
+}
+
+StatusOr<EmptyResponse> MetricsClient::DeleteObjectAcl(
+    DeleteObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kDeleteObjectAcl, *client_,
+                  &RawClient::DeleteObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> MetricsClient::GetObjectAcl(
+    GetObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kGetObjectAcl, *client_,
+                  &RawClient::GetObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> MetricsClient::UpdateObjectAcl(
+    UpdateObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kUpdateObjectAcl, *client_,
+                  &RawClient::UpdateObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> MetricsClient::PatchObjectAcl(
+    PatchObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kPatchObjectAcl, *client_,
+                  &RawClient::PatchObjectAcl, request);
+}
+
+StatusOr<ListDefaultObjectAclResponse> MetricsClient::ListDefaultObjectAcl(
+    ListDefaultObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kListDefaultObjectAcl, *client_,
+                  &RawClient::ListDefaultObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> MetricsClient::CreateDefaultObjectAcl(
+    CreateDefaultObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kCreateDefaultObjectAcl, *client_,
+                  &RawClient::CreateDefaultObjectAcl, request);
+}
+
+StatusOr<EmptyResponse> MetricsClient::DeleteDefaultObjectAcl(
+    DeleteDefaultObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kDeleteDefaultObjectAcl, *client_,
+                  &RawClient::DeleteDefaultObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> MetricsClient::GetDefaultObjectAcl(
+    GetDefaultObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kGetDefaultObjectAcl, *client_,
+                  &RawClient::GetDefaultObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> MetricsClient::UpdateDefaultObjectAcl(
+    UpdateDefaultObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kUpdateDefaultObjectAcl, *client_,
+                  &RawClient::UpdateDefaultObjectAcl, request);
+}
+
+StatusOr<ObjectAccessControl> MetricsClient::PatchDefaultObjectAcl(
+    PatchDefaultObjectAclRequest const& request) {
+  return MakeCall(*recorder_, kPatchDefaultObjectAcl, *client_,
+                  &RawClient::PatchDefaultObjectAcl, request);
+}
+
+StatusOr<ServiceAccount> MetricsClient::GetServiceAccount(
+    GetProjectServiceAccountRequest const& request) {
+  return MakeCall(*recorder_, kGetServiceAccount, *client_,
+                  &RawClient::GetServiceAccount, request);
+}
+
+StatusOr<ListHmacKeysResponse> MetricsClient::ListHmacKeys(
+    ListHmacKeysRequest const& request) {
+  return MakeCall(*recorder_, kListHmacKeys, *client_,
+                  &RawClient::ListHmacKeys, request);
+}
+
+StatusOr<CreateHmacKeyResponse> MetricsClient::CreateHmacKey(
+    CreateHmacKeyRequest const& request) {
+  return MakeCall(*recorder_, kCreateHmacKey, *client_,
+                  &RawClient::CreateHmacKey, request);
+}
+
+StatusOr<EmptyResponse> MetricsClient::DeleteHmacKey(
+    DeleteHmacKeyRequest const& request) {
+  return MakeCall(*recorder_, kDeleteHmacKey, *client_,
+                  &RawClient::DeleteHmacKey, request);
+}
+
+StatusOr<HmacKeyMetadata> MetricsClient::GetHmacKey(
+    GetHmacKeyRequest const& request) {
+  return MakeCall(*recorder_, kGetHmacKey, *client_,
+                  &RawClient::GetHmacKey, request);
+}
+
+StatusOr<HmacKeyMetadata> MetricsClient::UpdateHmacKey(
+    UpdateHmacKeyRequest const& request) {
+  return MakeCall(*recorder_, kUpdateHmacKey, *client_,
+                  &RawClient::UpdateHmacKey, request);
+}
+
+StatusOr<SignBlobResponse> MetricsClient::SignBlob(
+    SignBlobRequest const& request) {
+  return MakeCall(*recorder_, kSignBlob, *client_,
+                  &RawClient::SignBlob, request);
+}
+
+StatusOr<ListNotificationsResponse> MetricsClient::ListNotifications(
+    ListNotificationsRequest const& request) {
+  return MakeCall(*recorder_, kListNotifications, *client_,
+                  &RawClient::ListNotifications, request);
+}
+
+StatusOr<NotificationMetadata> MetricsClient::CreateNotification(
+    CreateNotificationRequest const& request) {
+  return MakeCall(*recorder_, kCreateNotification, *client_,
+                  &RawClient::CreateNotification, request);
+}
+
+StatusOr<NotificationMetadata> MetricsClient::GetNotification(
+    GetNotificationRequest const& request) {
+  return MakeCall(*recorder_, kGetNotification, *client_,
+                  &RawClient::GetNotification, request);
+}
+
+StatusOr<EmptyResponse> MetricsClient::DeleteNotification(
+    DeleteNotificationRequest const& request) {
+  return MakeCall(*recorder_, kDeleteNotification, *client_,
+                  &RawClient::DeleteNotification, request);
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
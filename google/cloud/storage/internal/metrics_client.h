@@ -0,0 +1,239 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_METRICS_CLIENT_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_METRICS_CLIENT_H_
+
+#include "google/cloud/status.h"
+#include "google/cloud/storage/internal/latency_histogram.h"
+#include "google/cloud/storage/internal/raw_client.h"
+#include "google/cloud/storage/version.h"
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/// The metrics collected by `MetricsClient` for a single operation.
+struct OperationMetrics {
+  /// The name of the operation, e.g. `GetObjectMetadata`.
+  std::string name;
+  /// The number of calls, successful or not.
+  std::uint64_t count = 0;
+  /// The number of calls that returned an error.
+  std::uint64_t error_count = 0;
+  /// The number of errors for each status code, only non-zero entries.
+  std::map<StatusCode, std::uint64_t> errors;
+  /// The payload bytes sent and received, for operations that have a payload.
+  std::uint64_t bytes_sent = 0;
+  std::uint64_t bytes_received = 0;
+  /// The latency of each call.
+  LatencyHistogram latency;
+};
+
+std::ostream& operator<<(std::ostream& os, OperationMetrics const& rhs);
+
+class MetricsRecorderImpl;
+
+/**
+ * Collects the metrics recorded by one or more `MetricsClient` decorators.
+ *
+ * Applications enable the metrics for a `Client` by setting a recorder with
+ * `ClientOptions::set_metrics_recorder()`, and call `Snapshot()` periodically
+ * to export the results. Several clients can share the same recorder, their
+ * metrics are added together.
+ */
+class MetricsRecorder {
+ public:
+  MetricsRecorder();
+
+  /**
+   * Returns the metrics recorded since the recorder was created.
+   *
+   * Only the operations called at least once are included. Calls that are in
+   * progress while the snapshot is taken may or may not be included.
+   */
+  std::vector<OperationMetrics> Snapshot() const;
+
+ private:
+  friend class MetricsClient;
+  std::shared_ptr<MetricsRecorderImpl> impl_;
+};
+
+/**
+ * A decorator for `RawClient` that records metrics for each operation.
+ *
+ * For each operation the decorator counts the calls, the errors by status
+ * code, the payload bytes, and records the latency in a histogram. Unlike
+ * `LoggingClient` this is cheap enough to leave enabled in production: the
+ * counters are sharded by thread, and recording a call uses only atomic
+ * increments, without locks or memory allocations. The only exception is the
+ * first call of each operation in each shard, which allocates its histogram.
+ *
+ * Streaming operations are also measured. The bytes read from the sources
+ * returned by `ReadObject()` are counted as received by `ReadObject`, and the
+ * chunks sent through the sessions returned by `CreateResumableSession()` and
+ * `RestoreResumableSession()` are recorded as the `UploadChunk`,
+ * `UploadFinalChunk`, and `ResetSession` operations.
+ *
+ * `Client` installs this decorator below the retry loop, so each attempt is
+ * measured, when `ClientOptions::metrics_recorder()` is set:
+ *
+ * @code
+ * auto metrics = std::make_shared<gcs::internal::MetricsRecorder>();
+ * gcs::Client client(options.set_metrics_recorder(metrics));
+ * // ... later, in the monitoring thread ...
+ * for (auto const& op : metrics->Snapshot()) {
+ *   Export(op.name, op.count, op.latency.Percentile(99));
+ * }
+ * @endcode
+ */
+class MetricsClient : public RawClient {
+ public:
+  /// Records the metrics in a new `MetricsRecorder`, see `Snapshot()`.
+  explicit MetricsClient(std::shared_ptr<RawClient> client);
+  /// Records the metrics in @p recorder.
+  MetricsClient(std::shared_ptr<RawClient> client,
+                std::shared_ptr<MetricsRecorder> const& recorder);
+  ~MetricsClient() override = default;
+
+  /// Returns the metrics in the recorder, see `MetricsRecorder::Snapshot()`.
+  std::vector<OperationMetrics> Snapshot() const;
+
+  ClientOptions const& client_options() const override;
+
+  StatusOr<ListBucketsResponse> ListBuckets(
+      ListBucketsRequest const& request) override;
+  StatusOr<BucketMetadata> CreateBucket(
+      CreateBucketRequest const& request) override;
+  StatusOr<BucketMetadata> GetBucketMetadata(
+      GetBucketMetadataRequest const& request) override;
+  StatusOr<EmptyResponse> DeleteBucket(DeleteBucketRequest const&) override;
+  StatusOr<BucketMetadata> UpdateBucket(
+      UpdateBucketRequest const& request) override;
+  StatusOr<BucketMetadata> PatchBucket(
+      PatchBucketRequest const& request) override;
+  StatusOr<IamPolicy> GetBucketIamPolicy(
+      GetBucketIamPolicyRequest const& request) override;
+  StatusOr<IamPolicy> SetBucketIamPolicy(
+      SetBucketIamPolicyRequest const& request) override;
+  StatusOr<TestBucketIamPermissionsResponse> TestBucketIamPermissions(
+      TestBucketIamPermissionsRequest const& request) override;
+  StatusOr<BucketMetadata> LockBucketRetentionPolicy(
+      LockBucketRetentionPolicyRequest const& request) override;
+
+  StatusOr<ObjectMetadata> InsertObjectMedia(
+      InsertObjectMediaRequest const& request) override;
+  StatusOr<ObjectMetadata> CopyObject(
+      CopyObjectRequest const& request) override;
+  StatusOr<ObjectMetadata> GetObjectMetadata(
+      GetObjectMetadataRequest const& request) override;
+  StatusOr<std::unique_ptr<ObjectReadSource>> ReadObject(
+      ReadObjectRangeRequest const&) override;
+  StatusOr<ListObjectsResponse> ListObjects(ListObjectsRequest const&) override;
+  StatusOr<ListObjectSummariesResponse> ListObjectSummaries(
+      ListObjectsRequest const&) override;
+  StatusOr<EmptyResponse> DeleteObject(DeleteObjectRequest const&) override;
+  StatusOr<ObjectMetadata> UpdateObject(
+      UpdateObjectRequest const& request) override;
+  StatusOr<ObjectMetadata> PatchObject(
+      PatchObjectRequest const& request) override;
+  StatusOr<ObjectMetadata> ComposeObject(
+      ComposeObjectRequest const& request) override;
+  StatusOr<RewriteObjectResponse> RewriteObject(
+      RewriteObjectRequest const&) override;
+  StatusOr<std::unique_ptr<ResumableUploadSession>> CreateResumableSession(
+      ResumableUploadRequest const& request) override;
+  StatusOr<std::unique_ptr<ResumableUploadSession>> RestoreResumableSession(
+      std::string const& request) override;
+
+  StatusOr<ListBucketAclResponse> ListBucketAcl(
+      ListBucketAclRequest const& request) override;
+  StatusOr<BucketAccessControl> CreateBucketAcl(
+      CreateBucketAclRequest const&) override;
+  StatusOr<EmptyResponse> DeleteBucketAcl(
+      DeleteBucketAclRequest const&) override;
+  StatusOr<BucketAccessControl> GetBucketAcl(
+      GetBucketAclRequest const&) override;
+  StatusOr<BucketAccessControl> UpdateBucketAcl(
+      UpdateBucketAclRequest const&) override;
+  StatusOr<BucketAccessControl> PatchBucketAcl(
+      PatchBucketAclRequest const&) override;
+
+  StatusOr<ListObjectAclResponse> ListObjectAcl(
+      ListObjectAclRequest const& request) override;
+  StatusOr<ObjectAccessControl> CreateObjectAcl(
+      CreateObjectAclRequest const&) override;
+  StatusOr<EmptyResponse> DeleteObjectAcl(
+      DeleteObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> GetObjectAcl(
+      GetObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> UpdateObjectAcl(
+      UpdateObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> PatchObjectAcl(
+      PatchObjectAclRequest const&) override;
+
+  StatusOr<ListDefaultObjectAclResponse> ListDefaultObjectAcl(
+      ListDefaultObjectAclRequest const& request) override;
+  StatusOr<ObjectAccessControl> CreateDefaultObjectAcl(
+      CreateDefaultObjectAclRequest const&) override;
+  StatusOr<EmptyResponse> DeleteDefaultObjectAcl(
+      DeleteDefaultObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> GetDefaultObjectAcl(
+      GetDefaultObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> UpdateDefaultObjectAcl(
+      UpdateDefaultObjectAclRequest const&) override;
+  StatusOr<ObjectAccessControl> PatchDefaultObjectAcl(
+      PatchDefaultObjectAclRequest const&) override;
+
+  StatusOr<ServiceAccount> GetServiceAccount(
+      GetProjectServiceAccountRequest const&) override;
+  StatusOr<ListHmacKeysResponse> ListHmacKeys(
+      ListHmacKeysRequest const&) override;
+  StatusOr<CreateHmacKeyResponse> CreateHmacKey(
+      CreateHmacKeyRequest const&) override;
+  StatusOr<EmptyResponse> DeleteHmacKey(DeleteHmacKeyRequest const&) override;
+  StatusOr<HmacKeyMetadata> GetHmacKey(GetHmacKeyRequest const&) override;
+  StatusOr<HmacKeyMetadata> UpdateHmacKey(UpdateHmacKeyRequest const&) override;
+  StatusOr<SignBlobResponse> SignBlob(SignBlobRequest const&) override;
+
+  StatusOr<ListNotificationsResponse> ListNotifications(
+      ListNotificationsRequest const&) override;
+  StatusOr<NotificationMetadata> CreateNotification(
+      CreateNotificationRequest const&) override;
+  StatusOr<NotificationMetadata> GetNotification(
+      GetNotificationRequest const&) override;
+  StatusOr<EmptyResponse> DeleteNotification(
+      DeleteNotificationRequest const&) override;
+
+  std::shared_ptr<RawClient> client() const { return client_; }
+
+ private:
+  std::shared_ptr<RawClient> client_;
+  std::shared_ptr<MetricsRecorderImpl> recorder_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_METRICS_CLIENT_H_
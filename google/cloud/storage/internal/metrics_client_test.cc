@@ -0,0 +1,238 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/metrics_client.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <thread>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::google::cloud::storage::testing::canonical_errors::TransientError;
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::Return;
+
+OperationMetrics const* Find(std::vector<OperationMetrics> const& snapshot,
+                             std::string const& name) {
+  for (auto const& m : snapshot) {
+    if (m.name == name) {
+      return &m;
+    }
+  }
+  return nullptr;
+}
+
+TEST(MetricsClientTest, CountsCallsAndErrors) {
+  auto mock = std::make_shared<testing::MockClient>();
+  MetricsClient client(mock);
+  EXPECT_TRUE(client.Snapshot().empty());
+
+  EXPECT_CALL(*mock, GetObjectMetadata(_))
+      .WillOnce(Return(StatusOr<ObjectMetadata>(TransientError())))
+      .WillOnce(Return(StatusOr<ObjectMetadata>(PermanentError())))
+      .WillOnce(Return(StatusOr<ObjectMetadata>(PermanentError())))
+      .WillOnce(Return(make_status_or(ObjectMetadata{})));
+  EXPECT_CALL(*mock, InsertObjectMedia(_))
+      .WillOnce(Return(make_status_or(ObjectMetadata{})));
+
+  GetObjectMetadataRequest get("test-bucket", "test-object");
+  for (int i = 0; i != 4; ++i) {
+    (void)client.GetObjectMetadata(get);
+  }
+  auto insert = client.InsertObjectMedia(
+      InsertObjectMediaRequest("test-bucket", "test-object", "0123456789"));
+  EXPECT_STATUS_OK(insert);
+
+  auto snapshot = client.Snapshot();
+  ASSERT_EQ(2U, snapshot.size());
+  auto const* metadata = Find(snapshot, "GetObjectMetadata");
+  ASSERT_NE(nullptr, metadata);
+  EXPECT_EQ(4U, metadata->count);
+  EXPECT_EQ(3U, metadata->error_count);
+  EXPECT_EQ(1U, metadata->errors.at(TransientError().code()));
+  EXPECT_EQ(2U, metadata->errors.at(PermanentError().code()));
+  EXPECT_EQ(4U, metadata->latency.count());
+  EXPECT_EQ(0U, metadata->bytes_sent);
+
+  auto const* media = Find(snapshot, "InsertObjectMedia");
+  ASSERT_NE(nullptr, media);
+  EXPECT_EQ(1U, media->count);
+  EXPECT_EQ(0U, media->error_count);
+  EXPECT_TRUE(media->errors.empty());
+  EXPECT_EQ(10U, media->bytes_sent);
+
+  std::ostringstream os;
+  os << *metadata;
+  EXPECT_THAT(os.str(), HasSubstr("GetObjectMetadata={count=4"));
+  EXPECT_THAT(os.str(), HasSubstr("UNAVAILABLE=1"));
+}
+
+TEST(MetricsClientTest, ReadObjectCountsBytes) {
+  auto mock = std::make_shared<testing::MockClient>();
+  MetricsClient client(mock);
+
+  EXPECT_CALL(*mock, ReadObject(_))
+      .WillOnce(Invoke([](ReadObjectRangeRequest const&) {
+        auto source = google::cloud::internal::make_unique<
+            testing::MockObjectReadSource>();
+        EXPECT_CALL(*source, Read(_, _))
+            .WillOnce(Return(ReadSourceResult{1024, HttpResponse{100, "", {}}}))
+            .WillOnce(Return(ReadSourceResult{512, HttpResponse{200, "", {}}}));
+        return make_status_or(
+            std::unique_ptr<ObjectReadSource>(std::move(source)));
+      }));
+
+  auto source =
+      client.ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(source);
+  char buffer[1024];
+  ASSERT_STATUS_OK((*source)->Read(buffer, sizeof(buffer)));
+  ASSERT_STATUS_OK((*source)->Read(buffer, sizeof(buffer)));
+  source->reset();
+
+  auto snapshot = client.Snapshot();
+  ASSERT_EQ(1U, snapshot.size());
+  EXPECT_EQ("ReadObject", snapshot[0].name);
+  EXPECT_EQ(1U, snapshot[0].count);
+  EXPECT_EQ(1536U, snapshot[0].bytes_received);
+}
+
+TEST(MetricsClientTest, ResumableUploadChunks) {
+  auto mock = std::make_shared<testing::MockClient>();
+  MetricsClient client(mock);
+
+  EXPECT_CALL(*mock, CreateResumableSession(_))
+      .WillOnce(Invoke([](ResumableUploadRequest const&) {
+        auto session = google::cloud::internal::make_unique<
+            testing::MockResumableUploadSession>();
+        EXPECT_CALL(*session, UploadChunk(_))
+            .WillOnce(Return(StatusOr<ResumableUploadResponse>(
+                TransientError())))
+            .WillOnce(Return(make_status_or(ResumableUploadResponse{
+                "", 255, "", ResumableUploadResponse::kInProgress})));
+        EXPECT_CALL(*session, UploadFinalChunk(_, 384))
+            .WillOnce(Return(make_status_or(ResumableUploadResponse{
+                "", 383, "", ResumableUploadResponse::kDone})));
+        return make_status_or(
+            std::unique_ptr<ResumableUploadSession>(std::move(session)));
+      }));
+
+  auto session = client.CreateResumableSession(
+      ResumableUploadRequest("test-bucket", "test-object"));
+  ASSERT_STATUS_OK(session);
+  EXPECT_FALSE((*session)->UploadChunk(std::string(256, 'a')).ok());
+  EXPECT_STATUS_OK((*session)->UploadChunk(std::string(256, 'a')));
+  EXPECT_STATUS_OK((*session)->UploadFinalChunk(std::string(128, 'b'), 384));
+
+  auto snapshot = client.Snapshot();
+  ASSERT_EQ(3U, snapshot.size());
+  auto const* chunk = Find(snapshot, "UploadChunk");
+  ASSERT_NE(nullptr, chunk);
+  EXPECT_EQ(2U, chunk->count);
+  EXPECT_EQ(1U, chunk->error_count);
+  EXPECT_EQ(512U, chunk->bytes_sent);
+  auto const* final_chunk = Find(snapshot, "UploadFinalChunk");
+  ASSERT_NE(nullptr, final_chunk);
+  EXPECT_EQ(1U, final_chunk->count);
+  EXPECT_EQ(128U, final_chunk->bytes_sent);
+}
+
+TEST(MetricsClientTest, ConcurrentCalls) {
+  auto mock = std::make_shared<testing::MockClient>();
+  MetricsClient client(mock);
+
+  int const thread_count = 8;
+  int const iterations = 1000;
+  EXPECT_CALL(*mock, DeleteObject(_))
+      .Times(thread_count * iterations)
+      .WillRepeatedly(Return(make_status_or(EmptyResponse{})));
+
+  auto worker = [&client] {
+    DeleteObjectRequest request("test-bucket", "test-object");
+    for (int i = 0; i != iterations; ++i) {
+      (void)client.DeleteObject(request);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i != thread_count; ++i) {
+    threads.emplace_back(worker);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  auto snapshot = client.Snapshot();
+  ASSERT_EQ(1U, snapshot.size());
+  EXPECT_EQ("DeleteObject", snapshot[0].name);
+  EXPECT_EQ(std::uint64_t(thread_count * iterations), snapshot[0].count);
+  EXPECT_EQ(snapshot[0].count, snapshot[0].latency.count());
+}
+
+TEST(MetricsClientTest, SharedRecorder) {
+  auto recorder = std::make_shared<MetricsRecorder>();
+  auto mock = std::make_shared<testing::MockClient>();
+  MetricsClient a(mock, recorder);
+  MetricsClient b(mock, recorder);
+
+  EXPECT_CALL(*mock, DeleteObject(_))
+      .WillOnce(Return(make_status_or(EmptyResponse{})))
+      .WillOnce(Return(StatusOr<EmptyResponse>(
+          Status(StatusCode::kUnauthenticated, "test-message"))));
+
+  DeleteObjectRequest request("test-bucket", "test-object");
+  (void)a.DeleteObject(request);
+  (void)b.DeleteObject(request);
+
+  auto snapshot = recorder->Snapshot();
+  ASSERT_EQ(1U, snapshot.size());
+  EXPECT_EQ(2U, snapshot[0].count);
+  EXPECT_EQ(1U, snapshot[0].errors.at(StatusCode::kUnauthenticated));
+  EXPECT_EQ(2U, a.Snapshot()[0].count);
+}
+
+TEST(MetricsClientTest, InstalledByClientOptions) {
+  auto recorder = std::make_shared<MetricsRecorder>();
+  // Nothing listens on this port, the request fails without retries.
+  auto options = ClientOptions(oauth2::CreateAnonymousCredentials())
+                     .set_endpoint("http://127.0.0.1:1")
+                     .set_metrics_recorder(recorder);
+  Client client(options, LimitedErrorCountRetryPolicy(0));
+  auto metadata = client.GetObjectMetadata("test-bucket", "test-object");
+  EXPECT_FALSE(metadata.ok());
+
+  auto snapshot = recorder->Snapshot();
+  ASSERT_EQ(1U, snapshot.size());
+  EXPECT_EQ("GetObjectMetadata", snapshot[0].name);
+  EXPECT_EQ(1U, snapshot[0].error_count);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
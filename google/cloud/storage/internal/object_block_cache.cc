@@ -0,0 +1,97 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/object_block_cache.h"
+#include <iostream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+std::ostream& operator<<(std::ostream& os, ObjectBlockKey const& rhs) {
+  return os << "ObjectBlockKey={bucket_name=" << rhs.bucket_name
+            << ", object_name=" << rhs.object_name
+            << ", generation=" << rhs.generation
+            << ", block_index=" << rhs.block_index << "}";
+}
+
+ObjectBlockCache::Block ObjectBlockCache::Lookup(ObjectBlockKey const& key) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto loc = entries_.find(key);
+  if (loc == entries_.end()) {
+    ++miss_count_;
+    return nullptr;
+  }
+  ++hit_count_;
+  lru_.splice(lru_.begin(), lru_, loc->second.position);
+  return loc->second.block;
+}
+
+void ObjectBlockCache::Insert(ObjectBlockKey key, Block block) {
+  if (!block || block->size() > max_size_bytes_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(mu_);
+  auto loc = entries_.find(key);
+  if (loc != entries_.end()) {
+    size_bytes_ -= loc->second.block->size();
+    lru_.erase(loc->second.position);
+    entries_.erase(loc);
+  }
+  EvictUntil(max_size_bytes_ - block->size());
+  size_bytes_ += block->size();
+  lru_.push_front(key);
+  entries_.emplace(std::move(key), Entry{std::move(block), lru_.begin()});
+}
+
+bool ObjectBlockCache::Contains(ObjectBlockKey const& key) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return entries_.find(key) != entries_.end();
+}
+
+std::size_t ObjectBlockCache::size_bytes() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return size_bytes_;
+}
+
+std::size_t ObjectBlockCache::block_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return entries_.size();
+}
+
+std::uint64_t ObjectBlockCache::hit_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return hit_count_;
+}
+
+std::uint64_t ObjectBlockCache::miss_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return miss_count_;
+}
+
+void ObjectBlockCache::EvictUntil(std::size_t target_size_bytes) {
+  while (size_bytes_ > target_size_bytes && !lru_.empty()) {
+    auto loc = entries_.find(lru_.back());
+    size_bytes_ -= loc->second.block->size();
+    entries_.erase(loc);
+    lru_.pop_back();
+  }
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
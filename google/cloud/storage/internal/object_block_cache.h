@@ -0,0 +1,112 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_BLOCK_CACHE_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_BLOCK_CACHE_H_
+
+#include "google/cloud/storage/version.h"
+#include <cstdint>
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Identifies a block of data in the `ObjectBlockCache`.
+ *
+ * The key includes the object generation, objects in GCS are immutable once a
+ * generation is created, therefore a cached block can never become stale.
+ */
+struct ObjectBlockKey {
+  std::string bucket_name;
+  std::string object_name;
+  std::int64_t generation;
+  std::int64_t block_index;
+};
+
+inline bool operator<(ObjectBlockKey const& lhs, ObjectBlockKey const& rhs) {
+  return std::tie(lhs.bucket_name, lhs.object_name, lhs.generation,
+                  lhs.block_index) < std::tie(rhs.bucket_name, rhs.object_name,
+                                              rhs.generation, rhs.block_index);
+}
+
+inline bool operator==(ObjectBlockKey const& lhs, ObjectBlockKey const& rhs) {
+  return !(lhs < rhs) && !(rhs < lhs);
+}
+
+std::ostream& operator<<(std::ostream& os, ObjectBlockKey const& rhs);
+
+/**
+ * A bounded, thread-safe, LRU cache for blocks of object data.
+ *
+ * The cache is bounded by the total number of bytes in the cached blocks, when
+ * inserting a new block would exceed that bound the least recently used blocks
+ * are discarded. Blocks are returned as `std::shared_ptr<std::string const>`,
+ * so callers can keep using a block even after it has been evicted.
+ */
+class ObjectBlockCache {
+ public:
+  using Block = std::shared_ptr<std::string const>;
+
+  explicit ObjectBlockCache(std::size_t max_size_bytes)
+      : max_size_bytes_(max_size_bytes) {}
+
+  /// Returns the cached block, or `nullptr` if it is not in the cache.
+  Block Lookup(ObjectBlockKey const& key);
+
+  /// Inserts (or replaces) a block, evicting older blocks as needed.
+  void Insert(ObjectBlockKey key, Block block);
+
+  /// Returns true if @p key is in the cache, does not update the LRU order.
+  bool Contains(ObjectBlockKey const& key) const;
+
+  std::size_t max_size_bytes() const { return max_size_bytes_; }
+  std::size_t size_bytes() const;
+  std::size_t block_count() const;
+  std::uint64_t hit_count() const;
+  std::uint64_t miss_count() const;
+
+ private:
+  using LruList = std::list<ObjectBlockKey>;
+  struct Entry {
+    Block block;
+    LruList::iterator position;
+  };
+
+  void EvictUntil(std::size_t target_size_bytes);
+
+  std::size_t const max_size_bytes_;
+  mutable std::mutex mu_;
+  std::map<ObjectBlockKey, Entry> entries_;
+  LruList lru_;
+  std::size_t size_bytes_ = 0;
+  std::uint64_t hit_count_ = 0;
+  std::uint64_t miss_count_ = 0;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_BLOCK_CACHE_H_
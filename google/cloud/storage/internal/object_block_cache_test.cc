@@ -0,0 +1,102 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/object_block_cache.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+ObjectBlockKey MakeKey(std::int64_t block_index) {
+  return ObjectBlockKey{"test-bucket", "test-object", 1234, block_index};
+}
+
+ObjectBlockCache::Block MakeBlock(std::size_t size, char c) {
+  return std::make_shared<std::string const>(size, c);
+}
+
+TEST(ObjectBlockCacheTest, InsertAndLookup) {
+  ObjectBlockCache cache(1000);
+  EXPECT_EQ(nullptr, cache.Lookup(MakeKey(0)));
+  cache.Insert(MakeKey(0), MakeBlock(100, 'a'));
+  auto block = cache.Lookup(MakeKey(0));
+  ASSERT_NE(nullptr, block);
+  EXPECT_EQ(std::string(100, 'a'), *block);
+  EXPECT_EQ(100U, cache.size_bytes());
+  EXPECT_EQ(1U, cache.block_count());
+  EXPECT_EQ(1U, cache.hit_count());
+  EXPECT_EQ(1U, cache.miss_count());
+}
+
+TEST(ObjectBlockCacheTest, KeyIncludesGeneration) {
+  ObjectBlockCache cache(1000);
+  cache.Insert(MakeKey(0), MakeBlock(100, 'a'));
+  auto key = MakeKey(0);
+  key.generation = 2345;
+  EXPECT_FALSE(cache.Contains(key));
+  EXPECT_TRUE(cache.Contains(MakeKey(0)));
+}
+
+TEST(ObjectBlockCacheTest, EvictsLeastRecentlyUsed) {
+  ObjectBlockCache cache(300);
+  cache.Insert(MakeKey(0), MakeBlock(100, 'a'));
+  cache.Insert(MakeKey(1), MakeBlock(100, 'b'));
+  cache.Insert(MakeKey(2), MakeBlock(100, 'c'));
+  // Make block 0 the most recently used.
+  EXPECT_NE(nullptr, cache.Lookup(MakeKey(0)));
+  cache.Insert(MakeKey(3), MakeBlock(100, 'd'));
+  EXPECT_TRUE(cache.Contains(MakeKey(0)));
+  EXPECT_FALSE(cache.Contains(MakeKey(1)));
+  EXPECT_TRUE(cache.Contains(MakeKey(2)));
+  EXPECT_TRUE(cache.Contains(MakeKey(3)));
+  EXPECT_EQ(300U, cache.size_bytes());
+}
+
+TEST(ObjectBlockCacheTest, ReplaceBlock) {
+  ObjectBlockCache cache(300);
+  cache.Insert(MakeKey(0), MakeBlock(100, 'a'));
+  cache.Insert(MakeKey(0), MakeBlock(50, 'b'));
+  EXPECT_EQ(50U, cache.size_bytes());
+  EXPECT_EQ(1U, cache.block_count());
+  EXPECT_EQ(std::string(50, 'b'), *cache.Lookup(MakeKey(0)));
+}
+
+TEST(ObjectBlockCacheTest, BlockTooLarge) {
+  ObjectBlockCache cache(100);
+  cache.Insert(MakeKey(0), MakeBlock(50, 'a'));
+  cache.Insert(MakeKey(1), MakeBlock(200, 'b'));
+  EXPECT_TRUE(cache.Contains(MakeKey(0)));
+  EXPECT_FALSE(cache.Contains(MakeKey(1)));
+}
+
+TEST(ObjectBlockCacheTest, EvictedBlocksRemainValid) {
+  ObjectBlockCache cache(100);
+  cache.Insert(MakeKey(0), MakeBlock(100, 'a'));
+  auto block = cache.Lookup(MakeKey(0));
+  cache.Insert(MakeKey(1), MakeBlock(100, 'b'));
+  EXPECT_FALSE(cache.Contains(MakeKey(0)));
+  ASSERT_NE(nullptr, block);
+  EXPECT_EQ(std::string(100, 'a'), *block);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
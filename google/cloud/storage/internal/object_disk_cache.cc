@@ -0,0 +1,509 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/object_disk_cache.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/log.h"
+#include "google/cloud/storage/internal/hash_validator_impl.h"
+#include "google/cloud/storage/internal/sha256_hash.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <vector>
+#if _WIN32
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+char const kEntrySuffix[] = ".data";
+
+// Other processes may add or remove entries, rebuild the index from the
+// directory contents when it is older than this.
+auto constexpr kIndexMaxAge = std::chrono::seconds(10);
+
+#if !_WIN32
+char const kTemporaryInfix[] = ".tmp.";
+char const kLockFile[] = "/cache.lock";
+
+// Temporary files older than this are assumed to belong to a process that
+// crashed while downloading, and are removed during eviction.
+std::time_t const kStaleTemporaryAge = 3600;
+
+Status ErrnoStatus(char const* where, std::string const& path) {
+  std::string msg = where;
+  msg += "(";
+  msg += path;
+  msg += "): ";
+  msg += std::strerror(errno);
+  return Status(StatusCode::kUnknown, std::move(msg));
+}
+
+bool EndsWith(std::string const& s, std::string const& suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// Holds an advisory lock on the cache directory.
+class DirectoryLock {
+ public:
+  DirectoryLock(std::string const& directory, bool exclusive)
+      : fd_(::open((directory + kLockFile).c_str(), O_RDWR | O_CREAT, 0644)) {
+    if (fd_ < 0) {
+      return;
+    }
+    int r;
+    do {
+      r = ::flock(fd_, exclusive ? LOCK_EX : LOCK_SH);
+    } while (r != 0 && errno == EINTR);
+    if (r != 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+  ~DirectoryLock() {
+    if (fd_ >= 0) {
+      ::flock(fd_, LOCK_UN);
+      ::close(fd_);
+    }
+  }
+
+  DirectoryLock(DirectoryLock const&) = delete;
+  DirectoryLock& operator=(DirectoryLock const&) = delete;
+
+  bool ok() const { return fd_ >= 0; }
+
+ private:
+  int fd_;
+};
+
+/// Serves the data for a cached object from a memory-mapped file.
+class MappedFileSource : public ObjectReadSource {
+ public:
+  MappedFileSource(void* map, std::size_t map_size, std::size_t begin,
+                   std::size_t end, long status_code,
+                   std::multimap<std::string, std::string> headers)
+      : map_(map),
+        map_size_(map_size),
+        offset_(begin),
+        end_(end),
+        status_code_(status_code),
+        headers_(std::move(headers)),
+        is_open_(true) {}
+
+  ~MappedFileSource() override { Unmap(); }
+
+  bool IsOpen() const override { return is_open_; }
+
+  StatusOr<HttpResponse> Close() override {
+    Unmap();
+    return HttpResponse{status_code_, std::string{}, {}};
+  }
+
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override {
+    if (!is_open_) {
+      return Status(StatusCode::kFailedPrecondition,
+                    "MappedFileSource::Read() - source is closed");
+    }
+    auto count = (std::min)(n, end_ - offset_);
+    if (count != 0) {
+      std::memcpy(buf, static_cast<char const*>(map_) + offset_, count);
+    }
+    offset_ += count;
+    ReadSourceResult result{
+        count, HttpResponse{100, std::string{}, std::move(headers_)}};
+    headers_.clear();
+    if (offset_ == end_) {
+      result.response.status_code = status_code_;
+      Unmap();
+    }
+    return result;
+  }
+
+ private:
+  void Unmap() {
+    if (map_ != nullptr) {
+      ::munmap(map_, map_size_);
+      map_ = nullptr;
+    }
+    is_open_ = false;
+  }
+
+  void* map_;
+  std::size_t map_size_;
+  std::size_t offset_;
+  std::size_t end_;
+  long status_code_;
+  std::multimap<std::string, std::string> headers_;
+  bool is_open_;
+};
+
+/**
+ * Stores a copy of the data returned by a download in a temporary file.
+ *
+ * The temporary file becomes a cache entry once the download completes, and
+ * only if the data matches the CRC32C checksum in the object metadata.
+ */
+class CacheInsertSource : public ObjectReadSource {
+ public:
+  CacheInsertSource(ObjectDiskCache cache, ObjectMetadata metadata,
+                    std::unique_ptr<ObjectReadSource> source,
+                    std::string temporary, int fd)
+      : cache_(std::move(cache)),
+        metadata_(std::move(metadata)),
+        source_(std::move(source)),
+        temporary_(std::move(temporary)),
+        fd_(fd),
+        bytes_written_(0) {}
+
+  ~CacheInsertSource() override { Abandon(); }
+
+  bool IsOpen() const override { return source_->IsOpen(); }
+
+  StatusOr<HttpResponse> Close() override {
+    Abandon();
+    return source_->Close();
+  }
+
+  StatusOr<ReadSourceResult> Read(char* buf, std::size_t n) override {
+    auto result = source_->Read(buf, n);
+    if (!result || result->response.status_code >= 300) {
+      Abandon();
+      return result;
+    }
+    Write(buf, result->bytes_received);
+    if (result->response.status_code != 100) {
+      Finish();
+    }
+    return result;
+  }
+
+ private:
+  void Write(char const* buf, std::size_t n) {
+    if (fd_ < 0) {
+      return;
+    }
+    crc32c_.Update(buf, n);
+    bytes_written_ += n;
+    while (n != 0) {
+      auto r = ::write(fd_, buf, n);
+      if (r < 0 && errno == EINTR) {
+        continue;
+      }
+      if (r <= 0) {
+        GCP_LOG(WARNING) << ErrnoStatus("write", temporary_).message();
+        Abandon();
+        return;
+      }
+      buf += r;
+      n -= static_cast<std::size_t>(r);
+    }
+  }
+
+  void Finish() {
+    if (fd_ < 0) {
+      return;
+    }
+    int r = ::close(fd_);
+    fd_ = -1;
+    crc32c_.ProcessMetadata(metadata_);
+    auto validation = std::move(crc32c_).Finish();
+    if (r != 0 || validation.received.empty() || validation.is_mismatch ||
+        bytes_written_ != metadata_.size()) {
+      ::unlink(temporary_.c_str());
+      return;
+    }
+    auto status = cache_.Commit(temporary_, metadata_);
+    if (!status.ok()) {
+      GCP_LOG(WARNING) << "cannot commit cache entry: " << status.message();
+    }
+  }
+
+  void Abandon() {
+    if (fd_ < 0) {
+      return;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    ::unlink(temporary_.c_str());
+  }
+
+  ObjectDiskCache cache_;
+  ObjectMetadata metadata_;
+  std::unique_ptr<ObjectReadSource> source_;
+  std::string temporary_;
+  int fd_;
+  std::uint64_t bytes_written_;
+  Crc32cHashValidator crc32c_;
+};
+#endif  // !_WIN32
+
+}  // namespace
+
+/// The in-memory index of the cache entries, shared by all the copies.
+struct ObjectDiskCache::Index {
+  struct Entry {
+    std::time_t mtime;
+    std::uint64_t size;
+  };
+
+  void Add(std::string const& path, std::time_t mtime, std::uint64_t size) {
+    auto& e = entries[path];
+    total_size -= e.size;
+    e = Entry{mtime, size};
+    total_size += size;
+  }
+
+  void Touch(std::string const& path) {
+    auto i = entries.find(path);
+    if (i != entries.end()) {
+      i->second.mtime = std::time(nullptr);
+    }
+  }
+
+  bool IsFresh() const {
+    return loaded &&
+           std::chrono::steady_clock::now() - refreshed < kIndexMaxAge;
+  }
+
+  std::mutex mu;
+  std::map<std::string, Entry> entries;
+  std::uint64_t total_size = 0;
+  bool loaded = false;
+  std::chrono::steady_clock::time_point refreshed;
+};
+
+ObjectDiskCache::ObjectDiskCache(std::string directory, std::uint64_t max_size)
+    : directory_(std::move(directory)),
+      max_size_(max_size),
+      index_(std::make_shared<Index>()) {}
+
+std::string ObjectDiskCache::EntryPath(ObjectMetadata const& metadata) const {
+  // Object names can contain any character, including '/', use a hash of the
+  // full name to create valid file names.
+  auto key = HexEncode(Sha256Hash(metadata.bucket() + "/" + metadata.name()));
+  return directory_ + "/" + key + "." +
+         std::to_string(metadata.generation()) + kEntrySuffix;
+}
+
+#if _WIN32
+std::unique_ptr<ObjectReadSource> ObjectDiskCache::Lookup(
+    ObjectMetadata const&, ReadObjectRangeRequest const&) {
+  return nullptr;
+}
+
+std::unique_ptr<ObjectReadSource> ObjectDiskCache::Insert(
+    ObjectMetadata, std::unique_ptr<ObjectReadSource> source) {
+  return source;
+}
+
+Status ObjectDiskCache::Evict() { return Status(); }
+
+Status ObjectDiskCache::Commit(std::string const&, ObjectMetadata const&) {
+  return Status(StatusCode::kUnimplemented,
+                "ObjectDiskCache is not supported on this platform");
+}
+
+Status ObjectDiskCache::EvictLocked() { return Status(); }
+
+Status ObjectDiskCache::RebuildIndexLocked() { return Status(); }
+#else
+std::unique_ptr<ObjectReadSource> ObjectDiskCache::Lookup(
+    ObjectMetadata const& metadata, ReadObjectRangeRequest const& request) {
+  auto const path = EntryPath(metadata);
+  DirectoryLock lock(directory_, false);
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<std::uint64_t>(st.st_size) != metadata.size()) {
+    ::close(fd);
+    return nullptr;
+  }
+  auto const size = static_cast<std::size_t>(st.st_size);
+  void* map = nullptr;
+  if (size != 0) {
+    map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      ::close(fd);
+      return nullptr;
+    }
+  }
+  // Update the modification time, this is how we implement the LRU policy.
+  ::futimens(fd, nullptr);
+  ::close(fd);
+  {
+    std::lock_guard<std::mutex> guard(index_->mu);
+    index_->Touch(path);
+  }
+
+  std::size_t end = size;
+  if (request.HasOption<ReadRange>()) {
+    auto const range_end = request.GetOption<ReadRange>().value().end;
+    end = (std::min)(end, static_cast<std::size_t>(
+                              (std::max)(range_end, std::int64_t(0))));
+  }
+  auto begin =
+      (std::min)(end, static_cast<std::size_t>(request.StartingByte()));
+
+  std::multimap<std::string, std::string> headers;
+  headers.emplace("x-goog-generation", std::to_string(metadata.generation()));
+  long status_code = 206;
+  if (!request.RequiresRangeHeader()) {
+    status_code = 200;
+    std::string hashes = "crc32c=" + metadata.crc32c();
+    if (!metadata.md5_hash().empty()) {
+      hashes += ",md5=" + metadata.md5_hash();
+    }
+    headers.emplace("x-goog-hash", std::move(hashes));
+  }
+  return google::cloud::internal::make_unique<MappedFileSource>(
+      map, size, begin, end, status_code, std::move(headers));
+}
+
+std::unique_ptr<ObjectReadSource> ObjectDiskCache::Insert(
+    ObjectMetadata metadata, std::unique_ptr<ObjectReadSource> source) {
+  if (::mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+    GCP_LOG(WARNING) << ErrnoStatus("mkdir", directory_).message();
+    return source;
+  }
+  std::string path = EntryPath(metadata) + kTemporaryInfix + "XXXXXX";
+  std::vector<char> buffer(path.begin(), path.end());
+  buffer.push_back('\0');
+  int fd = ::mkstemp(buffer.data());
+  if (fd < 0) {
+    GCP_LOG(WARNING) << ErrnoStatus("mkstemp", path).message();
+    return source;
+  }
+  return google::cloud::internal::make_unique<CacheInsertSource>(
+      *this, std::move(metadata), std::move(source),
+      std::string(buffer.data()), fd);
+}
+
+Status ObjectDiskCache::Evict() {
+  DirectoryLock lock(directory_, true);
+  if (!lock.ok()) {
+    return ErrnoStatus("flock", directory_ + kLockFile);
+  }
+  std::lock_guard<std::mutex> guard(index_->mu);
+  return EvictLocked();
+}
+
+Status ObjectDiskCache::Commit(std::string const& temporary,
+                               ObjectMetadata const& metadata) {
+  DirectoryLock lock(directory_, true);
+  if (!lock.ok()) {
+    ::unlink(temporary.c_str());
+    return ErrnoStatus("flock", directory_ + kLockFile);
+  }
+  auto const path = EntryPath(metadata);
+  if (::rename(temporary.c_str(), path.c_str()) != 0) {
+    auto status = ErrnoStatus("rename", temporary);
+    ::unlink(temporary.c_str());
+    return status;
+  }
+  std::lock_guard<std::mutex> guard(index_->mu);
+  if (index_->IsFresh()) {
+    index_->Add(path, std::time(nullptr), metadata.size());
+    if (index_->total_size <= max_size_) {
+      return Status();
+    }
+  }
+  return EvictLocked();
+}
+
+Status ObjectDiskCache::EvictLocked() {
+  // The index may be missing entries created by other processes, or include
+  // entries they removed. Always use the directory contents to evict.
+  auto status = RebuildIndexLocked();
+  if (!status.ok() || index_->total_size <= max_size_) {
+    return status;
+  }
+  using Iterator = std::map<std::string, Index::Entry>::iterator;
+  std::vector<Iterator> entries;
+  entries.reserve(index_->entries.size());
+  for (auto i = index_->entries.begin(); i != index_->entries.end(); ++i) {
+    entries.push_back(i);
+  }
+  std::sort(entries.begin(), entries.end(), [](Iterator a, Iterator b) {
+    return a->second.mtime < b->second.mtime;
+  });
+  for (auto const& e : entries) {
+    if (index_->total_size <= max_size_) {
+      break;
+    }
+    if (::unlink(e->first.c_str()) == 0 || errno == ENOENT) {
+      index_->total_size -= e->second.size;
+      index_->entries.erase(e);
+    }
+  }
+  return Status();
+}
+
+Status ObjectDiskCache::RebuildIndexLocked() {
+  DIR* dir = ::opendir(directory_.c_str());
+  if (dir == nullptr) {
+    return ErrnoStatus("opendir", directory_);
+  }
+  auto const now = std::time(nullptr);
+  index_->entries.clear();
+  index_->total_size = 0;
+  for (auto* e = ::readdir(dir); e != nullptr; e = ::readdir(dir)) {
+    std::string name = e->d_name;
+    bool is_entry = EndsWith(name, kEntrySuffix);
+    bool is_temporary = name.find(kTemporaryInfix) != std::string::npos;
+    if (!is_entry && !is_temporary) {
+      continue;
+    }
+    auto path = directory_ + "/" + name;
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+      continue;
+    }
+    if (is_temporary) {
+      if (now - st.st_mtime > kStaleTemporaryAge) {
+        ::unlink(path.c_str());
+      }
+      continue;
+    }
+    index_->Add(path, st.st_mtime, static_cast<std::uint64_t>(st.st_size));
+  }
+  ::closedir(dir);
+  index_->loaded = true;
+  index_->refreshed = std::chrono::steady_clock::now();
+  return Status();
+}
+#endif  // _WIN32
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,113 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_DISK_CACHE_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_DISK_CACHE_H_
+
+#include "google/cloud/status.h"
+#include "google/cloud/storage/internal/object_read_source.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/storage/object_metadata.h"
+#include "google/cloud/storage/version.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * A persistent cache of complete objects in a local directory.
+ *
+ * Each entry holds the full contents of one object generation. Entries are
+ * only created after the downloaded data matches the CRC32C checksum in the
+ * object metadata, and they are published with an atomic `rename(2)`, so
+ * readers never observe partial entries. Cached entries are served from
+ * memory-mapped files.
+ *
+ * The cache is bounded by the total size of the entries. The modification time
+ * of each entry is updated when it is used, and the least recently used entries
+ * are removed first. Multiple processes can share the same directory, updates
+ * to the directory are serialized with an advisory lock (`flock(2)`) on a lock
+ * file in the directory.
+ *
+ * To avoid scanning the directory on each insertion, the cache keeps an index
+ * of the entries and their sizes in memory. Other processes may change the
+ * directory too, so the index is rebuilt from the directory contents when it
+ * exceeds the size limit, or when it is older than a few seconds. Copies of an
+ * `ObjectDiskCache` share the same index.
+ *
+ * @note The cache is only implemented on POSIX systems, on other platforms all
+ *   lookups miss and nothing is stored. `Client` does not install the cache on
+ *   those platforms, and logs a warning if it is configured.
+ */
+class ObjectDiskCache {
+ public:
+  ObjectDiskCache(std::string directory, std::uint64_t max_size);
+
+  std::string const& directory() const { return directory_; }
+  std::uint64_t max_size() const { return max_size_; }
+
+  /// The file used to store the given object generation.
+  std::string EntryPath(ObjectMetadata const& metadata) const;
+
+  /**
+   * Returns a source for @p request if @p metadata is in the cache.
+   *
+   * The source honors the `ReadRange` and `ReadFromOffset` options in
+   * @p request. Full reads include the `x-goog-hash` header so the usual
+   * checksum validation applies to cached data too.
+   *
+   * @return `nullptr` if the object is not cached.
+   */
+  std::unique_ptr<ObjectReadSource> Lookup(
+      ObjectMetadata const& metadata, ReadObjectRangeRequest const& request);
+
+  /**
+   * Wraps a download so its data is stored in the cache.
+   *
+   * The returned source forwards all the data from @p source, and stores a
+   * copy in a temporary file. Only if the download completes and the data
+   * matches the CRC32C checksum in @p metadata the temporary file becomes a
+   * cache entry.
+   */
+  std::unique_ptr<ObjectReadSource> Insert(
+      ObjectMetadata metadata, std::unique_ptr<ObjectReadSource> source);
+
+  /// Remove the least recently used entries until the cache fits `max_size()`.
+  Status Evict();
+
+  /// Publish a temporary file as the entry for @p metadata.
+  Status Commit(std::string const& temporary, ObjectMetadata const& metadata);
+
+ private:
+  struct Index;
+
+  Status EvictLocked();
+  Status RebuildIndexLocked();
+
+  std::string directory_;
+  std::uint64_t max_size_;
+  std::shared_ptr<Index> index_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_DISK_CACHE_H_
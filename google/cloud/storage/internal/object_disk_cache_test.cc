@@ -0,0 +1,287 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/object_disk_cache.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/internal/random.h"
+#include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/storage/internal/metadata_parser.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <cstdio>
+#include <sstream>
+#if _WIN32
+#else
+#include <sys/stat.h>
+#include <utime.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+#if !_WIN32
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+
+std::string const kContents = "The quick brown fox jumps over the lazy dog";
+
+ObjectMetadata MakeMetadata(std::string const& name, std::int64_t generation,
+                            std::string const& contents) {
+  std::ostringstream os;
+  os << R"""({"bucket": "test-bucket", "name": ")""" << name
+     << R"""(", "generation": ")""" << generation << R"""(", "size": ")"""
+     << contents.size() << R"""(", "crc32c": ")"""
+     << ComputeCrc32cChecksum(contents) << R"""(", "md5Hash": ")"""
+     << ComputeMD5Hash(contents) << R"""("})""";
+  return ObjectMetadataParser::FromString(os.str()).value();
+}
+
+/// Create a download source that returns @p contents in small chunks.
+std::unique_ptr<ObjectReadSource> MakeSource(std::string contents) {
+  auto source = google::cloud::internal::make_unique<
+      ::testing::NiceMock<testing::MockObjectReadSource>>();
+  auto remaining = std::make_shared<std::string>(std::move(contents));
+  ON_CALL(*source, Read(_, _))
+      .WillByDefault(Invoke([remaining](char* buf, std::size_t n) {
+        auto count = (std::min)(n, (std::min)(std::size_t(8),
+                                              remaining->size()));
+        remaining->copy(buf, count);
+        remaining->erase(0, count);
+        long code = remaining->empty() ? 200 : 100;
+        return ReadSourceResult{count, HttpResponse{code, "", {}}};
+      }));
+  ON_CALL(*source, IsOpen()).WillByDefault(Return(true));
+  ON_CALL(*source, Close()).WillByDefault(Return(HttpResponse{200, "", {}}));
+  return std::unique_ptr<ObjectReadSource>(std::move(source));
+}
+
+/// Read all the data from @p source, capturing any headers.
+std::string ReadAll(ObjectReadSource& source,
+                    std::multimap<std::string, std::string>& headers) {
+  std::string result;
+  char buffer[16];
+  for (;;) {
+    auto r = source.Read(buffer, sizeof(buffer));
+    EXPECT_STATUS_OK(r);
+    if (!r) {
+      break;
+    }
+    result.append(buffer, r->bytes_received);
+    headers.insert(r->response.headers.begin(), r->response.headers.end());
+    if (r->response.status_code != 100) {
+      break;
+    }
+  }
+  return result;
+}
+
+std::string ReadAll(ObjectReadSource& source) {
+  std::multimap<std::string, std::string> headers;
+  return ReadAll(source, headers);
+}
+
+class ObjectDiskCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = ::testing::TempDir() + "disk-cache-" +
+                 google::cloud::internal::Sample(
+                     generator_, 8, "abcdefghijklmnopqrstuvwxyz0123456789");
+  }
+
+  void TearDown() override {
+    ObjectDiskCache cache(directory_, 0);
+    // Evicting with a zero size removes all the entries.
+    (void)cache.Evict();
+    std::remove((directory_ + "/cache.lock").c_str());
+    std::remove(directory_.c_str());
+  }
+
+  ReadObjectRangeRequest FullRead() const {
+    return ReadObjectRangeRequest("test-bucket", "test-object");
+  }
+
+  std::string directory_;
+  google::cloud::internal::DefaultPRNG generator_ =
+      google::cloud::internal::MakeDefaultPRNG();
+};
+
+TEST_F(ObjectDiskCacheTest, InsertAndLookup) {
+  ObjectDiskCache cache(directory_, 1024 * 1024);
+  auto metadata = MakeMetadata("test-object", 1234, kContents);
+  EXPECT_EQ(nullptr, cache.Lookup(metadata, FullRead()));
+
+  auto source = cache.Insert(metadata, MakeSource(kContents));
+  EXPECT_EQ(kContents, ReadAll(*source));
+  source.reset();
+
+  auto cached = cache.Lookup(metadata, FullRead());
+  ASSERT_NE(nullptr, cached);
+  EXPECT_TRUE(cached->IsOpen());
+  std::multimap<std::string, std::string> headers;
+  EXPECT_EQ(kContents, ReadAll(*cached, headers));
+  EXPECT_FALSE(cached->IsOpen());
+
+  auto hash = headers.find("x-goog-hash");
+  ASSERT_NE(headers.end(), hash);
+  EXPECT_EQ("crc32c=" + metadata.crc32c() + ",md5=" + metadata.md5_hash(),
+            hash->second);
+  auto generation = headers.find("x-goog-generation");
+  ASSERT_NE(headers.end(), generation);
+  EXPECT_EQ("1234", generation->second);
+}
+
+TEST_F(ObjectDiskCacheTest, KeyIncludesGeneration) {
+  ObjectDiskCache cache(directory_, 1024 * 1024);
+  auto metadata = MakeMetadata("test-object", 1234, kContents);
+  auto source = cache.Insert(metadata, MakeSource(kContents));
+  EXPECT_EQ(kContents, ReadAll(*source));
+
+  std::string const newer_contents = "some other contents";
+  auto newer = MakeMetadata("test-object", 2345, newer_contents);
+  EXPECT_NE(cache.EntryPath(metadata), cache.EntryPath(newer));
+  EXPECT_EQ(nullptr, cache.Lookup(newer, FullRead()));
+}
+
+TEST_F(ObjectDiskCacheTest, LookupRange) {
+  ObjectDiskCache cache(directory_, 1024 * 1024);
+  auto metadata = MakeMetadata("test-object", 1234, kContents);
+  auto source = cache.Insert(metadata, MakeSource(kContents));
+  EXPECT_EQ(kContents, ReadAll(*source));
+
+  auto request = FullRead();
+  request.set_option(ReadRange(4, 9));
+  auto cached = cache.Lookup(metadata, request);
+  ASSERT_NE(nullptr, cached);
+  std::multimap<std::string, std::string> headers;
+  EXPECT_EQ("quick", ReadAll(*cached, headers));
+  EXPECT_EQ(headers.end(), headers.find("x-goog-hash"));
+
+  request = FullRead();
+  request.set_option(ReadFromOffset(40));
+  cached = cache.Lookup(metadata, request);
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ("dog", ReadAll(*cached));
+}
+
+TEST_F(ObjectDiskCacheTest, ChecksumMismatchIsNotCached) {
+  ObjectDiskCache cache(directory_, 1024 * 1024);
+  auto metadata = MakeMetadata("test-object", 1234, kContents);
+  std::string corrupted = kContents;
+  corrupted[4] = 'Q';
+  auto source = cache.Insert(metadata, MakeSource(corrupted));
+  // The data is returned unmodified, the streambuf reports the mismatch.
+  EXPECT_EQ(corrupted, ReadAll(*source));
+  EXPECT_EQ(nullptr, cache.Lookup(metadata, FullRead()));
+}
+
+TEST_F(ObjectDiskCacheTest, PartialDownloadIsNotCached) {
+  ObjectDiskCache cache(directory_, 1024 * 1024);
+  auto metadata = MakeMetadata("test-object", 1234, kContents);
+  auto source = cache.Insert(metadata, MakeSource(kContents));
+  char buffer[8];
+  ASSERT_STATUS_OK(source->Read(buffer, sizeof(buffer)));
+  ASSERT_STATUS_OK(source->Close());
+  EXPECT_EQ(nullptr, cache.Lookup(metadata, FullRead()));
+}
+
+TEST_F(ObjectDiskCacheTest, DownloadErrorIsNotCached) {
+  ObjectDiskCache cache(directory_, 1024 * 1024);
+  auto metadata = MakeMetadata("test-object", 1234, kContents);
+  auto mock = google::cloud::internal::make_unique<
+      ::testing::NiceMock<testing::MockObjectReadSource>>();
+  EXPECT_CALL(*mock, Read(_, _))
+      .WillOnce(Return(ReadSourceResult{0, HttpResponse{404, "", {}}}));
+  auto source = cache.Insert(metadata, std::move(mock));
+  char buffer[8];
+  auto r = source->Read(buffer, sizeof(buffer));
+  ASSERT_STATUS_OK(r);
+  EXPECT_EQ(404, r->response.status_code);
+  EXPECT_EQ(nullptr, cache.Lookup(metadata, FullRead()));
+}
+
+TEST_F(ObjectDiskCacheTest, EvictLeastRecentlyUsed) {
+  ObjectDiskCache cache(directory_, 1024 * 1024);
+  std::vector<ObjectMetadata> objects;
+  for (auto const* name : {"object-0", "object-1", "object-2"}) {
+    objects.push_back(MakeMetadata(name, 1234, kContents));
+    auto source = cache.Insert(objects.back(), MakeSource(kContents));
+    EXPECT_EQ(kContents, ReadAll(*source));
+  }
+  // Set the modification times explicitly, the tests run faster than the
+  // resolution of the filesystem timestamps.
+  auto set_mtime = [&](ObjectMetadata const& m, std::time_t t) {
+    struct utimbuf times = {t, t};
+    ASSERT_EQ(0, ::utime(cache.EntryPath(m).c_str(), &times));
+  };
+  auto const now = std::time(nullptr);
+  set_mtime(objects[0], now - 10);
+  set_mtime(objects[1], now - 30);
+  set_mtime(objects[2], now - 20);
+
+  ObjectDiskCache smaller(directory_, 2 * kContents.size());
+  ASSERT_STATUS_OK(smaller.Evict());
+  auto cached = [&](ObjectMetadata const& m) {
+    struct stat st;
+    return ::stat(cache.EntryPath(m).c_str(), &st) == 0;
+  };
+  EXPECT_TRUE(cached(objects[0]));
+  EXPECT_FALSE(cached(objects[1]));
+  EXPECT_TRUE(cached(objects[2]));
+}
+
+TEST_F(ObjectDiskCacheTest, CommitEvictsWithIndex) {
+  ObjectDiskCache cache(directory_, 2 * kContents.size());
+  std::vector<ObjectMetadata> objects;
+  for (auto const* name : {"object-0", "object-1", "object-2", "object-3"}) {
+    objects.push_back(MakeMetadata(name, 1234, kContents));
+    auto source = cache.Insert(objects.back(), MakeSource(kContents));
+    EXPECT_EQ(kContents, ReadAll(*source));
+  }
+  int count = 0;
+  for (auto const& m : objects) {
+    struct stat st;
+    if (::stat(cache.EntryPath(m).c_str(), &st) == 0) ++count;
+  }
+  EXPECT_EQ(2, count);
+}
+
+TEST_F(ObjectDiskCacheTest, LookupUpdatesModificationTime) {
+  ObjectDiskCache cache(directory_, 1024 * 1024);
+  auto metadata = MakeMetadata("test-object", 1234, kContents);
+  auto source = cache.Insert(metadata, MakeSource(kContents));
+  EXPECT_EQ(kContents, ReadAll(*source));
+
+  auto const path = cache.EntryPath(metadata);
+  auto const old_time = std::time(nullptr) - 3600;
+  struct utimbuf times = {old_time, old_time};
+  ASSERT_EQ(0, ::utime(path.c_str(), &times));
+  ASSERT_NE(nullptr, cache.Lookup(metadata, FullRead()));
+  struct stat st;
+  ASSERT_EQ(0, ::stat(path.c_str(), &st));
+  EXPECT_LT(old_time, st.st_mtime);
+}
+#endif  // !_WIN32
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -17,6 +17,7 @@
 #include "google/cloud/storage/internal/metadata_parser.h"
 #include "google/cloud/storage/internal/nljson.h"
 #include "google/cloud/storage/internal/object_acl_requests.h"
+#include "google/cloud/storage/internal/openssl_util.h"
 #include "google/cloud/storage/object_metadata.h"
 #include <sstream>
 
@@ -39,6 +40,84 @@ void SetIfNotEmpty(internal::nl::json& json, char const* key,
   }
   json[key] = value;
 }
+
+/// Writes the field @p key when @p value is not empty.
+bool WriteIfNotEmpty(JsonWriter& writer, char const* key,
+                     std::string const& value) {
+  if (value.empty()) {
+    return false;
+  }
+  writer.Key(key).Value(value);
+  return true;
+}
+
+/// Writes @p override_value if not empty, otherwise @p value if not empty.
+bool WriteIfNotEmpty(JsonWriter& writer, char const* key,
+                     std::string const& value,
+                     std::string const& override_value) {
+  return WriteIfNotEmpty(writer, key,
+                         override_value.empty() ? value : override_value);
+}
+
+/**
+ * Writes the object metadata fields, the hashes are only written for inserts.
+ *
+ * The fields are written in the same (alphabetical) order used by `nl::json`
+ * in the `ObjectMetadataJsonFor*()` functions.
+ */
+bool WriteObjectMetadataFields(JsonWriter& writer, ObjectMetadata const& meta,
+                               ObjectMetadataOverrides const& overrides,
+                               bool include_hashes) {
+  bool written = false;
+  if (!meta.acl().empty()) {
+    writer.Key("acl").StartArray();
+    for (ObjectAccessControl const& a : meta.acl()) {
+      writer.StartObject();
+      WriteIfNotEmpty(writer, "entity", a.entity());
+      WriteIfNotEmpty(writer, "role", a.role());
+      writer.EndObject();
+    }
+    writer.EndArray();
+    written = true;
+  }
+
+  written |= WriteIfNotEmpty(writer, "cacheControl", meta.cache_control());
+  written |= WriteIfNotEmpty(writer, "contentDisposition",
+                             meta.content_disposition());
+  written |= WriteIfNotEmpty(writer, "contentEncoding", meta.content_encoding(),
+                             overrides.content_encoding);
+  written |=
+      WriteIfNotEmpty(writer, "contentLanguage", meta.content_language());
+  written |= WriteIfNotEmpty(writer, "contentType", meta.content_type(),
+                             overrides.content_type);
+  if (include_hashes) {
+    written |=
+        WriteIfNotEmpty(writer, "crc32c", meta.crc32c(), overrides.crc32c);
+  }
+
+  if (meta.event_based_hold()) {
+    writer.Key("eventBasedHold").Value(true);
+    written = true;
+  }
+
+  if (include_hashes) {
+    written |= WriteIfNotEmpty(writer, "md5Hash", meta.md5_hash(),
+                               overrides.md5_hash);
+  }
+
+  if (!meta.metadata().empty()) {
+    writer.Key("metadata").StartObject();
+    for (auto const& kv : meta.metadata()) {
+      writer.Key(kv.first).Value(kv.second);
+    }
+    writer.EndObject();
+    written = true;
+  }
+
+  written |= WriteIfNotEmpty(writer, "name", meta.name());
+  written |= WriteIfNotEmpty(writer, "storageClass", meta.storage_class());
+  return written;
+}
 }  // namespace
 
 StatusOr<ObjectMetadata> ObjectMetadataParser::FromJson(
@@ -103,6 +182,61 @@ StatusOr<ObjectMetadata> ObjectMetadataParser::FromString(
   return FromJson(json);
 }
 
+StatusOr<std::vector<ObjectSummary>> ObjectSummaryParser::FromJsonArray(
+    internal::nl::json const& items) {
+  if (!items.is_array()) {
+    return Status(StatusCode::kInvalidArgument, __func__);
+  }
+  // Copy all the names into a single buffer, the summaries point into it.
+  std::size_t total_size = 0;
+  for (auto const& item : items) {
+    if (!item.is_object()) {
+      return Status(StatusCode::kInvalidArgument, __func__);
+    }
+    auto name = item.find("name");
+    if (name != item.end() && name->is_string()) {
+      total_size += name->get_ref<std::string const&>().size();
+    }
+  }
+  auto arena = std::make_shared<std::string>();
+  arena->reserve(total_size);
+
+  std::vector<ObjectSummary> result(items.size());
+  auto summary = result.begin();
+  for (auto const& item : items) {
+    auto name = item.find("name");
+    if (name != item.end() && name->is_string()) {
+      auto const& value = name->get_ref<std::string const&>();
+      auto offset = arena->size();
+      arena->append(value);
+      // The aliasing constructor shares ownership of the buffer. The buffer
+      // never reallocates because we reserved the space above.
+      summary->name_ =
+          std::shared_ptr<char const>(arena, arena->data() + offset);
+      summary->name_size_ = static_cast<std::uint32_t>(value.size());
+    }
+    summary->generation_ = ParseLongField(item, "generation");
+    summary->size_ = ParseUnsignedLongField(item, "size");
+    auto crc32c = item.find("crc32c");
+    if (crc32c != item.end() && crc32c->is_string()) {
+      auto bytes = Base64Decode(crc32c->get<std::string>());
+      if (bytes.size() != sizeof(std::uint32_t)) {
+        return Status(StatusCode::kInvalidArgument,
+                      std::string(__func__) + " - invalid crc32c value");
+      }
+      // The checksum is in big-endian order.
+      std::uint32_t value = 0;
+      for (auto b : bytes) {
+        value = (value << 8U) | b;
+      }
+      summary->has_crc32c_ = true;
+      summary->crc32c_ = value;
+    }
+    ++summary;
+  }
+  return result;
+}
+
 internal::nl::json ObjectMetadataJsonForCompose(ObjectMetadata const& meta) {
   using ::google::cloud::storage::internal::nl::json;
   json metadata_as_json({});
@@ -155,6 +289,18 @@ internal::nl::json ObjectMetadataJsonForRewrite(ObjectMetadata const& meta) {
   return ObjectMetadataJsonForCompose(meta);
 }
 
+bool WriteObjectMetadataFieldsForCompose(JsonWriter& writer,
+                                         ObjectMetadata const& meta) {
+  return WriteObjectMetadataFields(writer, meta, ObjectMetadataOverrides{},
+                                   false);
+}
+
+bool WriteObjectMetadataFieldsForInsert(
+    JsonWriter& writer, ObjectMetadata const& meta,
+    ObjectMetadataOverrides const& overrides) {
+  return WriteObjectMetadataFields(writer, meta, overrides, true);
+}
+
 internal::nl::json ObjectMetadataJsonForUpdate(ObjectMetadata const& meta) {
   using ::google::cloud::storage::internal::nl::json;
   json metadata_as_json({});
@@ -222,6 +368,39 @@ std::ostream& operator<<(std::ostream& os, ListObjectsResponse const& r) {
   return os << "}}";
 }
 
+char const* const ListObjectSummariesResponse::kFields =
+    "nextPageToken,items(name,generation,size,crc32c)";
+
+StatusOr<ListObjectSummariesResponse>
+ListObjectSummariesResponse::FromHttpResponse(std::string const& payload) {
+  auto json = storage::internal::nl::json::parse(payload, nullptr, false);
+  if (!json.is_object()) {
+    return Status(StatusCode::kInvalidArgument, __func__);
+  }
+
+  ListObjectSummariesResponse result;
+  result.next_page_token = json.value("nextPageToken", "");
+  auto items = json.find("items");
+  if (items == json.end()) {
+    return result;
+  }
+  auto parsed = ObjectSummaryParser::FromJsonArray(*items);
+  if (!parsed) {
+    return std::move(parsed).status();
+  }
+  result.items = *std::move(parsed);
+  return result;
+}
+
+std::ostream& operator<<(std::ostream& os,
+                         ListObjectSummariesResponse const& r) {
+  os << "ListObjectSummariesResponse={next_page_token=" << r.next_page_token
+     << ", items={";
+  std::copy(r.items.begin(), r.items.end(),
+            std::ostream_iterator<ObjectSummary>(os, "\n  "));
+  return os << "}}";
+}
+
 std::ostream& operator<<(std::ostream& os, GetObjectMetadataRequest const& r) {
   os << "GetObjectMetadataRequest={bucket_name=" << r.bucket_name()
      << ", object_name=" << r.object_name();
@@ -264,6 +443,11 @@ bool ReadObjectRangeRequest::RequiresRangeHeader() const {
   return RequiresNoCache();
 }
 
+bool ReadObjectRangeRequest::RequiresGzipDecompression() const {
+  return HasOption<GzipDecompression>() &&
+         GetOption<GzipDecompression>().value();
+}
+
 std::string ReadObjectRangeRequest::RangeHeader() const {
   if (HasOption<ReadRange>() && HasOption<ReadFromOffset>()) {
     auto range = GetOption<ReadRange>().value();
@@ -312,7 +496,7 @@ ReadObjectRangeResponse ReadObjectRangeResponse::FromHttpResponse(
         "invalid http response for ReadObjectRange");
   }
 
-  std::string const& content_range_value = loc->second;
+  auto const content_range_value = loc->second;
   auto function = __func__;  // capture this function name, not the lambda's
   auto raise_error = [&content_range_value, &function]() {
     std::ostringstream os;
@@ -388,33 +572,35 @@ ComposeObjectRequest::ComposeObjectRequest(
       source_objects_(std::move(source_objects)) {}
 
 std::string ComposeObjectRequest::JsonPayload() const {
-  using ::google::cloud::storage::internal::nl::json;
-  json compose_object_payload_json;
-  compose_object_payload_json["kind"] = "storage#composeRequest";
-  json destination_metadata_payload;
+  std::string payload;
+  // Most of the payload is the list of source objects, reserve enough space
+  // for the typical case.
+  payload.reserve(64 + source_objects_.size() * 96);
+  JsonWriter writer(payload);
+  writer.StartObject();
   if (HasOption<WithObjectMetadata>()) {
-    destination_metadata_payload =
-        ObjectMetadataJsonForCompose(GetOption<WithObjectMetadata>().value());
+    writer.Key("destination").StartObject();
+    WriteObjectMetadataFieldsForCompose(
+        writer, GetOption<WithObjectMetadata>().value());
+    writer.EndObject();
   }
-  if (!destination_metadata_payload.is_null()) {
-    compose_object_payload_json["destination"] = destination_metadata_payload;
-  }
-  json source_object_list;
+  writer.Key("kind").Value("storage#composeRequest");
+  writer.Key("sourceObjects").StartArray();
   for (auto const& source_object : source_objects_) {
-    json source_object_json;
-    source_object_json["name"] = source_object.object_name;
+    writer.StartObject();
     if (source_object.generation.has_value()) {
-      source_object_json["generation"] = source_object.generation.value();
+      writer.Key("generation").Value(source_object.generation.value());
     }
     if (source_object.if_generation_match.has_value()) {
-      source_object_json["ifGenerationMatch"] =
-          source_object.if_generation_match.value();
+      writer.Key("ifGenerationMatch")
+          .Value(source_object.if_generation_match.value());
     }
-    source_object_list.emplace_back(std::move(source_object_json));
+    writer.Key("name").Value(source_object.object_name);
+    writer.EndObject();
   }
-  compose_object_payload_json["sourceObjects"] = source_object_list;
-
-  return compose_object_payload_json.dump();
+  writer.EndArray();
+  writer.EndObject();
+  return payload;
 }
 
 std::ostream& operator<<(std::ostream& os, ComposeObjectRequest const& r) {
@@ -19,7 +19,9 @@
 #include "google/cloud/storage/hashing_options.h"
 #include "google/cloud/storage/internal/generic_object_request.h"
 #include "google/cloud/storage/internal/http_response.h"
+#include "google/cloud/storage/internal/json_writer.h"
 #include "google/cloud/storage/object_metadata.h"
+#include "google/cloud/storage/object_summary.h"
 #include "google/cloud/storage/upload_options.h"
 #include "google/cloud/storage/version.h"
 #include "google/cloud/storage/well_known_parameters.h"
@@ -34,6 +36,17 @@ struct ObjectMetadataParser {
   static StatusOr<ObjectMetadata> FromString(std::string const& payload);
 };
 
+struct ObjectSummaryParser {
+  /**
+   * Parses the `items` field in a `Objects: list` response.
+   *
+   * The names for all the objects are stored in a single buffer, shared by all
+   * the returned values.
+   */
+  static StatusOr<std::vector<ObjectSummary>> FromJsonArray(
+      internal::nl::json const& items);
+};
+
 //@{
 /**
  * @name Create the correct JSON payload depending on the operation.
@@ -50,6 +63,39 @@ internal::nl::json ObjectMetadataJsonForRewrite(ObjectMetadata const& meta);
 internal::nl::json ObjectMetadataJsonForUpdate(ObjectMetadata const& meta);
 //@}
 
+/**
+ * Request options that replace fields of the object metadata in insert
+ * requests.
+ *
+ * Some fields can be set both with a request option (e.g. `ContentType`) and
+ * with the `WithObjectMetadata` option, the request option takes precedence.
+ * Empty values do not replace the metadata fields.
+ */
+struct ObjectMetadataOverrides {
+  std::string content_encoding;
+  std::string content_type;
+  std::string crc32c;
+  std::string md5_hash;
+};
+
+//@{
+/**
+ * @name Write the JSON payload fields directly into a request payload.
+ *
+ * These functions write the same fields as `ObjectMetadataJsonForCompose()`
+ * and `ObjectMetadataJsonForInsert()`, but without creating a `nl::json`
+ * object. They only write the fields, the caller must start and end the JSON
+ * object. The compose fields are also used in copy and rewrite requests.
+ *
+ * @return true if any fields were written.
+ */
+bool WriteObjectMetadataFieldsForCompose(JsonWriter& writer,
+                                         ObjectMetadata const& meta);
+bool WriteObjectMetadataFieldsForInsert(
+    JsonWriter& writer, ObjectMetadata const& meta,
+    ObjectMetadataOverrides const& overrides = {});
+//@}
+
 /**
  * Represents a request to the `Objects: list` API.
  */
@@ -85,14 +131,34 @@ struct ListObjectsResponse {
 
 std::ostream& operator<<(std::ostream& os, ListObjectsResponse const& r);
 
+/**
+ * The response for `Client::ListObjectSummaries()`.
+ *
+ * This uses the same `Objects: list` API as `ListObjectsResponse`, but only
+ * the fields in `kFields` are requested and parsed.
+ */
+struct ListObjectSummariesResponse {
+  static StatusOr<ListObjectSummariesResponse> FromHttpResponse(
+      std::string const& payload);
+
+  /// The value for the `fields` query parameter, unless set by the caller.
+  static char const* const kFields;
+
+  std::string next_page_token;
+  std::vector<ObjectSummary> items;
+};
+
+std::ostream& operator<<(std::ostream& os,
+                         ListObjectSummariesResponse const& r);
+
 /**
  * Represents a request to the `Objects: get` API.
  */
 class GetObjectMetadataRequest
     : public GenericObjectRequest<
-          GetObjectMetadataRequest, Generation, IfGenerationMatch,
-          IfGenerationNotMatch, IfMetagenerationMatch, IfMetagenerationNotMatch,
-          Projection, UserProject> {
+          GetObjectMetadataRequest, EncryptionKey, Generation,
+          IfGenerationMatch, IfGenerationNotMatch, IfMetagenerationMatch,
+          IfMetagenerationNotMatch, Projection, UserProject> {
  public:
   using GenericObjectRequest::GenericObjectRequest;
 };
@@ -177,14 +243,15 @@ std::ostream& operator<<(std::ostream& os, CopyObjectRequest const& r);
 class ReadObjectRangeRequest
     : public GenericObjectRequest<
           ReadObjectRangeRequest, DisableCrc32cChecksum, DisableMD5Hash,
-          EncryptionKey, Generation, IfGenerationMatch, IfGenerationNotMatch,
-          IfMetagenerationMatch, IfMetagenerationNotMatch, ReadFromOffset,
-          ReadRange, UserProject> {
+          EncryptionKey, Generation, GzipDecompression, IfGenerationMatch,
+          IfGenerationNotMatch, IfMetagenerationMatch,
+          IfMetagenerationNotMatch, ReadFromOffset, ReadRange, UserProject> {
  public:
   using GenericObjectRequest::GenericObjectRequest;
 
   bool RequiresNoCache() const;
   bool RequiresRangeHeader() const;
+  bool RequiresGzipDecompression() const;
   std::string RangeHeader() const;
   std::int64_t StartingByte() const;
 };
@@ -358,10 +425,11 @@ class ResumableUploadRequest
     : public GenericObjectRequest<
           ResumableUploadRequest, ContentEncoding, ContentType,
           Crc32cChecksumValue, DisableCrc32cChecksum, DisableMD5Hash,
-          EncryptionKey, IfGenerationMatch, IfGenerationNotMatch,
-          IfMetagenerationMatch, IfMetagenerationNotMatch, KmsKeyName,
-          MD5HashValue, PredefinedAcl, Projection, UseResumableUploadSession,
-          UserProject, WithObjectMetadata> {
+          EncryptionKey, GzipCompression, IfGenerationMatch,
+          IfGenerationNotMatch, IfMetagenerationMatch,
+          IfMetagenerationNotMatch, KmsKeyName, MD5HashValue, PredefinedAcl,
+          Projection, UseResumableUploadSession, UserProject,
+          WithObjectMetadata> {
  public:
   ResumableUploadRequest() = default;
 
@@ -130,6 +130,59 @@ TEST(ObjectRequestsTest, ParseListResponseFailureInItems) {
   EXPECT_FALSE(actual.ok());
 }
 
+TEST(ObjectRequestsTest, ParseListSummariesResponse) {
+  std::string text = R"""({
+      "nextPageToken": "some-token-42",
+      "items": [{
+        "name": "foo-bar-baz",
+        "generation": "7",
+        "size": "1024",
+        "crc32c": "ImIEBA=="
+      }, {
+        "name": "qux",
+        "generation": 3,
+        "size": 0,
+        "bucket": "ignored-field"
+      }]
+})""";
+
+  auto actual = ListObjectSummariesResponse::FromHttpResponse(text);
+  ASSERT_TRUE(actual.ok()) << "status=" << actual.status();
+  EXPECT_EQ("some-token-42", actual->next_page_token);
+  ASSERT_EQ(2U, actual->items.size());
+  auto const& o1 = actual->items[0];
+  EXPECT_EQ("foo-bar-baz", o1.name());
+  EXPECT_EQ(7, o1.generation());
+  EXPECT_EQ(1024U, o1.size());
+  EXPECT_TRUE(o1.has_crc32c());
+  EXPECT_EQ(0x22620404U, o1.crc32c());
+  auto const& o2 = actual->items[1];
+  EXPECT_EQ("qux", o2.name());
+  EXPECT_EQ(3, o2.generation());
+  EXPECT_EQ(0U, o2.size());
+  EXPECT_FALSE(o2.has_crc32c());
+
+  // The names are stored in a single buffer.
+  EXPECT_EQ(o1.name_data() + o1.name_size(), o2.name_data());
+}
+
+TEST(ObjectRequestsTest, ParseListSummariesResponseEmpty) {
+  auto actual = ListObjectSummariesResponse::FromHttpResponse("{}");
+  ASSERT_TRUE(actual.ok()) << "status=" << actual.status();
+  EXPECT_EQ("", actual->next_page_token);
+  EXPECT_TRUE(actual->items.empty());
+}
+
+TEST(ObjectRequestsTest, ParseListSummariesResponseFailure) {
+  EXPECT_FALSE(ListObjectSummariesResponse::FromHttpResponse("{123").ok());
+  EXPECT_FALSE(
+      ListObjectSummariesResponse::FromHttpResponse(R"""({"items": [ 1 ]})""")
+          .ok());
+  EXPECT_FALSE(ListObjectSummariesResponse::FromHttpResponse(
+                   R"""({"items": [ {"name": "a", "crc32c": "AA=="} ]})""")
+                   .ok());
+}
+
 TEST(ObjectRequestsTest, Get) {
   GetObjectMetadataRequest request("my-bucket", "my-object");
   request.set_multiple_options(Generation(1), IfMetagenerationMatch(3));
@@ -879,6 +932,26 @@ TEST(ComposeObjectRequestTest, SimpleCompose) {
   EXPECT_THAT(actual, HasSubstr("\"ifGenerationMatch\":2"));
 }
 
+TEST(ComposeObjectRequestTest, JsonPayload) {
+  std::vector<ComposeSourceObject> source_objects = {
+      {"object1", 1L, {}}, {"object2", {}, 2L}, {"object\"3", {}, {}}};
+  ComposeObjectRequest request("test-bucket", source_objects, "test-object");
+  request.set_multiple_options(WithObjectMetadata(
+      ObjectMetadata().set_content_type("text/plain").upsert_metadata("k",
+                                                                     "v")));
+
+  nl::json expected{
+      {"kind", "storage#composeRequest"},
+      {"destination",
+       {{"contentType", "text/plain"}, {"metadata", {{"k", "v"}}}}},
+      {"sourceObjects",
+       {{{"name", "object1"}, {"generation", 1}},
+        {{"name", "object2"}, {"ifGenerationMatch", 2}},
+        {{"name", "object\"3"}}}},
+  };
+  EXPECT_EQ(expected.dump(), request.JsonPayload());
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
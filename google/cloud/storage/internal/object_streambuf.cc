@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/object_streambuf.h"
+#include "google/cloud/internal/make_unique.h"
 #include "google/cloud/log.h"
 #include "google/cloud/storage/internal/object_requests.h"
 #include "google/cloud/storage/object_stream.h"
@@ -23,10 +24,18 @@ namespace cloud {
 namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace internal {
+namespace {
+// The size of the buffer used by ObjectReadStreambuf.
+constexpr std::size_t kReadBufferSize = 128 * 1024;
+}  // namespace
+
 ObjectReadStreambuf::ObjectReadStreambuf(
     ReadObjectRangeRequest const& request,
-    std::unique_ptr<ObjectReadSource> source)
-    : source_(std::move(source)) {
+    std::unique_ptr<ObjectReadSource> source,
+    std::shared_ptr<BufferPool> buffer_pool)
+    : source_(std::move(source)),
+      buffer_pool_(std::move(buffer_pool)),
+      gzip_requested_(request.RequiresGzipDecompression()) {
   hash_validator_ = CreateHashValidator(request);
 }
 
@@ -38,6 +47,11 @@ ObjectReadStreambuf::ObjectReadStreambuf(ReadObjectRangeRequest const& request,
   status_ = std::move(status);
 }
 
+ObjectReadStreambuf::~ObjectReadStreambuf() {
+  ReleaseBuffer(buffer_pool_.get(), std::move(current_ios_buffer_));
+  ReleaseBuffer(buffer_pool_.get(), std::move(compressed_buffer_));
+}
+
 bool ObjectReadStreambuf::IsOpen() const { return source_->IsOpen(); }
 
 void ObjectReadStreambuf::Close() {
@@ -48,6 +62,9 @@ void ObjectReadStreambuf::Close() {
 }
 
 StatusOr<ObjectReadStreambuf::int_type> ObjectReadStreambuf::Peek() {
+  if (decompressor_) {
+    return PeekDecompressed();
+  }
   if (!IsOpen()) {
     // The stream is closed, reading from a closed stream can happen if there is
     // no object to read from, or the object is empty. In that case just setup
@@ -56,28 +73,42 @@ StatusOr<ObjectReadStreambuf::int_type> ObjectReadStreambuf::Peek() {
     return traits_type::eof();
   }
 
-  current_ios_buffer_.resize(128 * 1024);
-  std::size_t n = current_ios_buffer_.size();
+  // Get the buffer on the first read, streams that fail before reading any
+  // data do not need it.
+  if (current_ios_buffer_.capacity() < kReadBufferSize) {
+    current_ios_buffer_ = AcquireBuffer(buffer_pool_.get(), kReadBufferSize);
+  }
+  current_ios_buffer_.resize(kReadBufferSize);
+  char* data = &current_ios_buffer_[0];
   StatusOr<ReadSourceResult> read_result =
-      source_->Read(current_ios_buffer_.data(), n);
+      source_->Read(data, current_ios_buffer_.size());
   if (!read_result.ok()) {
     return std::move(read_result).status();
   }
   // assert(n <= current_ios_buffer_.size())
-  current_ios_buffer_.resize(read_result->bytes_received);
+  auto const n = read_result->bytes_received;
 
-  for (auto const& kv : read_result->response.headers) {
-    hash_validator_->ProcessHeader(kv.first, kv.second);
-    headers_.emplace(kv.first, kv.second);
-  }
+  ProcessHeaders(read_result->response.headers);
   if (read_result->response.status_code >= 300) {
     return AsStatus(read_result->response);
   }
 
-  if (!current_ios_buffer_.empty()) {
-    char* data = current_ios_buffer_.data();
-    hash_validator_->Update(data, current_ios_buffer_.size());
-    setg(data, data, data + current_ios_buffer_.size());
+  if (n != 0) {
+    hash_validator_->Update(data, n);
+    if (gzip_requested_) {
+      gzip_requested_ = false;
+      auto encoding = headers_.find("content-encoding");
+      if (encoding != headers_.end() && encoding->second == "gzip") {
+        // This is the first block of a gzip-encoded object, from now on the
+        // data read from `source_` is decompressed.
+        decompressor_ =
+            google::cloud::internal::make_unique<GzipDecompressor>();
+        compressed_buffer_.swap(current_ios_buffer_);
+        decompressor_->SetInput(compressed_buffer_.data(), n);
+        return PeekDecompressed();
+      }
+    }
+    setg(data, data, data + n);
     return traits_type::to_int_type(*data);
   }
 
@@ -87,13 +118,67 @@ StatusOr<ObjectReadStreambuf::int_type> ObjectReadStreambuf::Peek() {
   return traits_type::eof();
 }
 
+StatusOr<ObjectReadStreambuf::int_type>
+ObjectReadStreambuf::PeekDecompressed() {
+  if (current_ios_buffer_.capacity() < kReadBufferSize) {
+    current_ios_buffer_ = AcquireBuffer(buffer_pool_.get(), kReadBufferSize);
+  }
+  current_ios_buffer_.resize(kReadBufferSize);
+  char* data = &current_ios_buffer_[0];
+  for (;;) {
+    auto decompressed = decompressor_->Decompress(data, kReadBufferSize);
+    if (!decompressed) {
+      return std::move(decompressed).status();
+    }
+    if (*decompressed != 0) {
+      setg(data, data, data + *decompressed);
+      return traits_type::to_int_type(*data);
+    }
+    if (!IsOpen()) {
+      break;
+    }
+    // All the compressed data has been consumed, read some more. The hashes
+    // are computed over the compressed data.
+    if (compressed_buffer_.capacity() < kReadBufferSize) {
+      compressed_buffer_ = AcquireBuffer(buffer_pool_.get(), kReadBufferSize);
+    }
+    compressed_buffer_.resize(kReadBufferSize);
+    StatusOr<ReadSourceResult> read_result =
+        source_->Read(&compressed_buffer_[0], compressed_buffer_.size());
+    if (!read_result.ok()) {
+      return std::move(read_result).status();
+    }
+    ProcessHeaders(read_result->response.headers);
+    if (read_result->response.status_code >= 300) {
+      return AsStatus(read_result->response);
+    }
+    auto const n = read_result->bytes_received;
+    if (n == 0) {
+      break;
+    }
+    hash_validator_->Update(compressed_buffer_.data(), n);
+    decompressor_->SetInput(compressed_buffer_.data(), n);
+  }
+
+  if (!decompressor_->finished()) {
+    return Status(StatusCode::kDataLoss,
+                  "ObjectReadStreambuf::PeekDecompressed() - the download "
+                  "ended in the middle of a gzip stream");
+  }
+  SetEmptyRegion();
+  return traits_type::eof();
+}
+
 ObjectReadStreambuf::int_type ObjectReadStreambuf::underflow() {
   auto next_char = Peek();
   if (!next_char) {
     return ReportError(next_char.status());
   }
 
-  if (*next_char == traits_type::eof()) {
+  if (*next_char == traits_type::eof() && !hash_validator_finished_) {
+    // Reading past the end of the stream calls this function again, the
+    // hashes must be computed only once.
+    hash_validator_finished_ = true;
     hash_validator_result_ = std::move(*hash_validator_).Finish();
     if (hash_validator_result_.is_mismatch) {
       std::string msg;
@@ -121,6 +206,11 @@ std::streamsize ObjectReadStreambuf::xsgetn(char* s, std::streamsize count) {
                 << ", in_avail=" << in_avail() << ", status=" << status_;
   // This function optimizes stream.read(), the data is copied directly from the
   // data source (typically libcurl) into a buffer provided by the application.
+  // That does not work when the data needs to be decompressed, in that case
+  // use the default implementation, which reads via `underflow()`.
+  if (gzip_requested_ || decompressor_) {
+    return std::basic_streambuf<char>::xsgetn(s, count);
+  }
   std::streamsize offset = 0;
   if (!status_.ok()) {
     return 0;
@@ -157,10 +247,7 @@ std::streamsize ObjectReadStreambuf::xsgetn(char* s, std::streamsize count) {
   hash_validator_->Update(s + offset, read_result->bytes_received);
   offset += read_result->bytes_received;
 
-  for (auto const& kv : read_result->response.headers) {
-    hash_validator_->ProcessHeader(kv.first, kv.second);
-    headers_.emplace(kv.first, kv.second);
-  }
+  ProcessHeaders(read_result->response.headers);
   if (read_result->response.status_code >= 300) {
     status_ = AsStatus(read_result->response);
   }
@@ -168,6 +255,33 @@ std::streamsize ObjectReadStreambuf::xsgetn(char* s, std::streamsize count) {
   return offset;
 }
 
+void ObjectReadStreambuf::ProcessHeaders(HttpHeaders const& headers) {
+  // Only the hash headers are of interest to the validators, avoid creating
+  // strings for all the other headers.
+  auto hashes = headers.equal_range("x-goog-hash");
+  for (auto h = hashes.first; h != hashes.second; ++h) {
+    auto kv = *h;
+    hash_validator_->ProcessHeader(kv.first, kv.second);
+  }
+  // The headers are usually received only with the first block.
+  if (!headers.empty()) {
+    std::lock_guard<std::mutex> lk(headers_mu_);
+    headers_.merge(headers);
+    headers_map_valid_ = false;
+  }
+}
+
+std::multimap<std::string, std::string> const& ObjectReadStreambuf::headers()
+    const {
+  std::lock_guard<std::mutex> lk(headers_mu_);
+  if (!headers_map_valid_) {
+    headers_map_.clear();
+    headers_map_.insert(headers_.begin(), headers_.end());
+    headers_map_valid_ = true;
+  }
+  return headers_map_;
+}
+
 ObjectReadStreambuf::int_type ObjectReadStreambuf::ReportError(Status status) {
   // The only way to report errors from a std::basic_streambuf<> (which this
   // class derives from) is to throw exceptions:
@@ -189,20 +303,29 @@ ObjectReadStreambuf::int_type ObjectReadStreambuf::ReportError(Status status) {
 }
 
 void ObjectReadStreambuf::SetEmptyRegion() {
-  current_ios_buffer_.clear();
-  current_ios_buffer_.push_back('\0');
+  // There is no more data, return the buffers to the pool now, the stream may
+  // live for a while after the download completes.
+  ReleaseBuffer(buffer_pool_.get(), std::move(compressed_buffer_));
+  compressed_buffer_ = std::string{};
+  ReleaseBuffer(buffer_pool_.get(), std::move(current_ios_buffer_));
+  current_ios_buffer_.assign(1, '\0');
   char* data = &current_ios_buffer_[0];
   setg(data, data + 1, data + 1);
 }
 
 ObjectWriteStreambuf::ObjectWriteStreambuf(
     std::unique_ptr<ResumableUploadSession> upload_session,
-    std::size_t max_buffer_size, std::unique_ptr<HashValidator> hash_validator)
+    std::size_t max_buffer_size, std::unique_ptr<HashValidator> hash_validator,
+    std::shared_ptr<BufferPool> buffer_pool,
+    std::unique_ptr<GzipCompressor> compressor)
     : upload_session_(std::move(upload_session)),
+      buffer_pool_(std::move(buffer_pool)),
       max_buffer_size_(UploadChunkRequest::RoundUpToQuantum(max_buffer_size)),
       hash_validator_(std::move(hash_validator)),
+      compressor_(std::move(compressor)),
       last_response_{HttpResponse{400, {}, {}}} {
-  current_ios_buffer_.reserve(max_buffer_size_);
+  current_ios_buffer_ = AcquireBuffer(buffer_pool_.get(), max_buffer_size_);
+  current_ios_buffer_.clear();
   auto pbeg = &current_ios_buffer_[0];
   auto pend = pbeg + current_ios_buffer_.size();
   setp(pbeg, pend);
@@ -220,6 +343,13 @@ ObjectWriteStreambuf::ObjectWriteStreambuf(
   }
 }
 
+ObjectWriteStreambuf::~ObjectWriteStreambuf() {
+  if (pending_compression_.valid()) {
+    pending_compression_.wait();
+  }
+  ReleaseBuffer(buffer_pool_.get(), std::move(current_ios_buffer_));
+}
+
 StatusOr<HttpResponse> ObjectWriteStreambuf::Close() {
   pubsync();
   GCP_LOG(INFO) << __func__ << "()";
@@ -288,8 +418,25 @@ StatusOr<HttpResponse> ObjectWriteStreambuf::FlushFinal() {
   }
   // Shorten the buffer to the actual used size.
   auto actual_size = static_cast<std::size_t>(pptr() - pbase());
-  std::size_t upload_size = upload_session_->next_expected_byte() + actual_size;
   current_ios_buffer_.resize(actual_size);
+  if (compressor_) {
+    // Compress the last buffer in this thread, and then upload all the
+    // compressed data that is left.
+    auto status = AwaitCompression();
+    if (!status.ok()) {
+      return status;
+    }
+    pending_compression_ =
+        std::async(std::launch::deferred, &ObjectWriteStreambuf::CompressBuffer,
+                   this, std::move(current_ios_buffer_), true);
+    status = AwaitCompression();
+    if (!status.ok()) {
+      return status;
+    }
+    current_ios_buffer_.swap(compressed_);
+  }
+  std::size_t upload_size =
+      upload_session_->next_expected_byte() + current_ios_buffer_.size();
   hash_validator_->Update(current_ios_buffer_.data(),
                           current_ios_buffer_.size());
 
@@ -321,6 +468,9 @@ StatusOr<HttpResponse> ObjectWriteStreambuf::Flush() {
   if (actual_size < max_buffer_size_) {
     return last_response_;
   }
+  if (compressor_) {
+    return FlushCompressed();
+  }
 
   auto chunk_count = actual_size / UploadChunkRequest::kChunkSizeQuantum;
   auto chunk_size = chunk_count * UploadChunkRequest::kChunkSizeQuantum;
@@ -350,6 +500,60 @@ StatusOr<HttpResponse> ObjectWriteStreambuf::Flush() {
   return last_response_;
 }
 
+StatusOr<HttpResponse> ObjectWriteStreambuf::FlushCompressed() {
+  // Collect the output for the previous buffer, and start compressing the
+  // current one in the background while that output is uploaded.
+  auto status = AwaitCompression();
+  if (!status.ok()) {
+    return status;
+  }
+  current_ios_buffer_.resize(static_cast<std::size_t>(pptr() - pbase()));
+  pending_compression_ =
+      std::async(std::launch::async, &ObjectWriteStreambuf::CompressBuffer,
+                 this, std::move(current_ios_buffer_), false);
+  current_ios_buffer_ = AcquireBuffer(buffer_pool_.get(), max_buffer_size_);
+  current_ios_buffer_.clear();
+  auto pbeg = &current_ios_buffer_[0];
+  setp(pbeg, pbeg);
+
+  auto chunk_count = compressed_.size() / UploadChunkRequest::kChunkSizeQuantum;
+  auto chunk_size = chunk_count * UploadChunkRequest::kChunkSizeQuantum;
+  if (chunk_size == 0) {
+    return last_response_;
+  }
+  std::string chunk;
+  chunk.swap(compressed_);
+  compressed_.assign(chunk, chunk_size, std::string::npos);
+  chunk.resize(chunk_size);
+  hash_validator_->Update(chunk.data(), chunk.size());
+
+  StatusOr<ResumableUploadResponse> result =
+      upload_session_->UploadChunk(chunk);
+  if (!result) {
+    // This was an unrecoverable error, time to signal an error.
+    return std::move(result).status();
+  }
+  last_response_ = HttpResponse{200, std::move(result).value().payload, {}};
+  return last_response_;
+}
+
+Status ObjectWriteStreambuf::AwaitCompression() {
+  if (!pending_compression_.valid()) {
+    return Status();
+  }
+  auto status = pending_compression_.get();
+  compressed_.append(compressor_output_);
+  compressor_output_.clear();
+  return status;
+}
+
+Status ObjectWriteStreambuf::CompressBuffer(std::string input, bool finish) {
+  auto status = compressor_->Compress(input.data(), input.size(), finish,
+                                      &compressor_output_);
+  ReleaseBuffer(buffer_pool_.get(), std::move(input));
+  return status;
+}
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
@@ -16,13 +16,18 @@
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_OBJECT_STREAMBUF_H_
 
 #include "google/cloud/status_or.h"
+#include "google/cloud/storage/buffer_pool.h"
+#include "google/cloud/storage/internal/gzip_compressor.h"
+#include "google/cloud/storage/internal/gzip_decompressor.h"
 #include "google/cloud/storage/internal/hash_validator.h"
 #include "google/cloud/storage/internal/http_response.h"
 #include "google/cloud/storage/internal/object_read_source.h"
 #include "google/cloud/storage/internal/resumable_upload_session.h"
 #include "google/cloud/storage/version.h"
+#include <future>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace google {
@@ -41,12 +46,13 @@ namespace internal {
 class ObjectReadStreambuf : public std::basic_streambuf<char> {
  public:
   ObjectReadStreambuf(ReadObjectRangeRequest const& request,
-                      std::unique_ptr<ObjectReadSource> source);
+                      std::unique_ptr<ObjectReadSource> source,
+                      std::shared_ptr<BufferPool> buffer_pool = {});
 
   /// Create a streambuf in a permanent error status.
   ObjectReadStreambuf(ReadObjectRangeRequest const& request, Status status);
 
-  ~ObjectReadStreambuf() override = default;
+  ~ObjectReadStreambuf() override;
 
   ObjectReadStreambuf(ObjectReadStreambuf&&) noexcept = delete;
   ObjectReadStreambuf& operator=(ObjectReadStreambuf&&) noexcept = delete;
@@ -62,24 +68,44 @@ class ObjectReadStreambuf : public std::basic_streambuf<char> {
   std::string const& computed_hash() const {
     return hash_validator_result_.computed;
   }
-  std::multimap<std::string, std::string> const& headers() const {
-    return headers_;
-  }
+  /**
+   * The headers received so far.
+   *
+   * The map is only created when this function is called, most applications
+   * never use it. It is safe to call this function from multiple threads.
+   */
+  std::multimap<std::string, std::string> const& headers() const;
 
  private:
+  void ProcessHeaders(HttpHeaders const& headers);
   int_type ReportError(Status status);
   void SetEmptyRegion();
   StatusOr<int_type> Peek();
+  StatusOr<int_type> PeekDecompressed();
 
   int_type underflow() override;
   std::streamsize xsgetn(char* s, std::streamsize count) override;
 
   std::unique_ptr<ObjectReadSource> source_;
-  std::vector<char> current_ios_buffer_;
+  std::shared_ptr<BufferPool> buffer_pool_;
+  std::string current_ios_buffer_;
   std::unique_ptr<HashValidator> hash_validator_;
   HashValidator::Result hash_validator_result_;
+  bool hash_validator_finished_ = false;
   Status status_;
-  std::multimap<std::string, std::string> headers_;
+  // The headers are only updated as the responses arrive, `headers_map_` is
+  // created from them on demand. `headers_mu_` protects both, as `headers()`
+  // may be called from multiple threads.
+  mutable std::mutex headers_mu_;
+  HttpHeaders headers_;
+  mutable std::multimap<std::string, std::string> headers_map_;
+  mutable bool headers_map_valid_ = true;
+
+  // Set until the first response is received if the request asked for gzip
+  // decompression, `decompressor_` is only created for gzip-encoded objects.
+  bool gzip_requested_ = false;
+  std::unique_ptr<GzipDecompressor> decompressor_;
+  std::string compressed_buffer_;
 };
 
 /**
@@ -88,6 +114,11 @@ class ObjectReadStreambuf : public std::basic_streambuf<char> {
  * We do not want to expose the libcurl objects through `ObjectWriteStream`,
  * this class abstracts away the implementation so applications are not impacted
  * by the implementation details.
+ *
+ * If a `GzipCompressor` is provided the data is compressed before it is
+ * uploaded. Each full buffer is compressed in a background thread while the
+ * compressed data from the previous buffer is uploaded. The hash validator
+ * receives the compressed data, as that is what the service stores.
  */
 class ObjectWriteStreambuf : public std::basic_streambuf<char> {
  public:
@@ -95,9 +126,11 @@ class ObjectWriteStreambuf : public std::basic_streambuf<char> {
 
   ObjectWriteStreambuf(std::unique_ptr<ResumableUploadSession> upload_session,
                        std::size_t max_buffer_size,
-                       std::unique_ptr<HashValidator> hash_validator);
+                       std::unique_ptr<HashValidator> hash_validator,
+                       std::shared_ptr<BufferPool> buffer_pool = {},
+                       std::unique_ptr<GzipCompressor> compressor = {});
 
-  ~ObjectWriteStreambuf() override = default;
+  ~ObjectWriteStreambuf() override;
 
   ObjectWriteStreambuf(ObjectWriteStreambuf&& rhs) noexcept = delete;
   ObjectWriteStreambuf& operator=(ObjectWriteStreambuf&& rhs) noexcept = delete;
@@ -137,14 +170,32 @@ class ObjectWriteStreambuf : public std::basic_streambuf<char> {
   /// Flush any remaining data and commit the upload.
   StatusOr<HttpResponse> FlushFinal();
 
+  /// Start compressing the full buffer and upload any compressed data.
+  StatusOr<HttpResponse> FlushCompressed();
+
+  /// Wait for any pending compression and collect its output.
+  Status AwaitCompression();
+
+  /// Compress @p input, runs in the background for all but the last buffer.
+  Status CompressBuffer(std::string input, bool finish);
+
   std::unique_ptr<ResumableUploadSession> upload_session_;
 
+  std::shared_ptr<BufferPool> buffer_pool_;
   std::string current_ios_buffer_;
   std::size_t max_buffer_size_;
 
   std::unique_ptr<HashValidator> hash_validator_;
   HashValidator::Result hash_validator_result_;
 
+  std::unique_ptr<GzipCompressor> compressor_;
+  // The output of `compressor_` owned by the background thread, only valid
+  // while `pending_compression_` is running.
+  std::string compressor_output_;
+  // The compressed data not uploaded yet.
+  std::string compressed_;
+  std::future<Status> pending_compression_;
+
   StatusOr<HttpResponse> last_response_;
 };
 
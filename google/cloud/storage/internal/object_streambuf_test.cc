@@ -14,11 +14,15 @@
 
 #include "google/cloud/storage/internal/object_streambuf.h"
 #include "google/cloud/internal/make_unique.h"
+#include "google/cloud/storage/hashing_options.h"
+#include "google/cloud/storage/internal/hash_validator_impl.h"
 #include "google/cloud/storage/object_metadata.h"
 #include "google/cloud/storage/testing/canonical_errors.h"
 #include "google/cloud/storage/testing/mock_client.h"
 #include "google/cloud/testing_util/assert_ok.h"
 #include <gmock/gmock.h>
+#include <cstring>
+#include <thread>
 
 namespace google {
 namespace cloud {
@@ -341,6 +345,317 @@ TEST(ObjectWriteStreambufTest, CreatedForFinalizedUpload) {
   EXPECT_EQ(close_result.value().payload, payload);
 }
 
+/// @test Verify that the write buffer is obtained from and returned to a pool.
+TEST(ObjectWriteStreambufTest, UsesBufferPool) {
+  auto pool = std::make_shared<BufferPool>();
+  auto const quantum = UploadChunkRequest::kChunkSizeQuantum;
+  for (int i = 0; i != 2; ++i) {
+    auto mock = google::cloud::internal::make_unique<
+        testing::MockResumableUploadSession>();
+    EXPECT_CALL(*mock, done).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mock, UploadFinalChunk(_, _))
+        .WillOnce(Return(make_status_or(ResumableUploadResponse{
+            "{}", 0, {}, ResumableUploadResponse::kInProgress})));
+    EXPECT_CALL(*mock, next_expected_byte()).WillOnce(Return(0));
+
+    ObjectWriteStreambuf streambuf(
+        std::move(mock), quantum,
+        google::cloud::internal::make_unique<NullHashValidator>(), pool);
+    streambuf.sputn("x", 1);
+    EXPECT_STATUS_OK(streambuf.Close());
+  }
+  auto stats = pool->statistics();
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(2U, stats.returns);
+}
+
+/// Decompress a gzip stream using zlib directly.
+std::string GzipDecompress(std::string const& compressed) {
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  EXPECT_EQ(Z_OK, inflateInit2(&stream, 16 + MAX_WBITS));
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(&compressed[0]));
+  stream.avail_in = static_cast<uInt>(compressed.size());
+  std::string result;
+  int status;
+  do {
+    char buffer[4096];
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = sizeof(buffer);
+    status = inflate(&stream, Z_NO_FLUSH);
+    result.append(buffer, sizeof(buffer) - stream.avail_out);
+  } while (status == Z_OK);
+  EXPECT_EQ(Z_STREAM_END, status);
+  inflateEnd(&stream);
+  return result;
+}
+
+/// @test Verify that a compressed stream uploads (and hashes) gzip data.
+TEST(ObjectWriteStreambufTest, GzipCompression) {
+  auto const quantum = UploadChunkRequest::kChunkSizeQuantum;
+  // Use data that does not compress well, so several chunks are uploaded.
+  std::string payload(5 * quantum + 1000, '\0');
+  std::uint32_t state = 12345;
+  for (auto& c : payload) {
+    state = state * 1103515245U + 12345U;
+    c = static_cast<char>(state >> 24);
+  }
+
+  std::string uploaded;
+  auto mock = google::cloud::internal::make_unique<
+      testing::MockResumableUploadSession>();
+  EXPECT_CALL(*mock, done).WillRepeatedly(Return(false));
+  EXPECT_CALL(*mock, UploadChunk(_))
+      .WillRepeatedly(Invoke([&](std::string const& p) {
+        EXPECT_EQ(0U, p.size() % quantum);
+        uploaded += p;
+        return make_status_or(ResumableUploadResponse{
+            "", uploaded.size() - 1, {}, ResumableUploadResponse::kInProgress});
+      }));
+  EXPECT_CALL(*mock, UploadFinalChunk(_, _))
+      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
+        uploaded += p;
+        EXPECT_EQ(uploaded.size(), s);
+        return make_status_or(ResumableUploadResponse{
+            "{}", uploaded.size() - 1, {}, ResumableUploadResponse::kDone});
+      }));
+  EXPECT_CALL(*mock, next_expected_byte()).WillRepeatedly(Invoke([&] {
+    return static_cast<std::uint64_t>(uploaded.size());
+  }));
+
+  ObjectWriteStreambuf streambuf(
+      std::move(mock), quantum,
+      google::cloud::internal::make_unique<Crc32cHashValidator>(),
+      std::make_shared<BufferPool>(),
+      google::cloud::internal::make_unique<GzipCompressor>());
+  for (std::size_t offset = 0; offset < payload.size(); offset += 1000) {
+    auto n = (std::min<std::size_t>)(1000, payload.size() - offset);
+    streambuf.sputn(payload.data() + offset, static_cast<std::streamsize>(n));
+  }
+  EXPECT_STATUS_OK(streambuf.Close());
+
+  EXPECT_LT(quantum, uploaded.size());
+  EXPECT_EQ(payload, GzipDecompress(uploaded));
+
+  auto const expected = ComputeCrc32cChecksum(uploaded);
+  auto meta = ObjectMetadataParser::FromString(
+      R"""({"crc32c": ")""" + expected + R"""("})""");
+  ASSERT_STATUS_OK(meta);
+  EXPECT_TRUE(streambuf.ValidateHash(*meta));
+  EXPECT_EQ(expected, streambuf.computed_hash());
+}
+
+/// @test Verify that compressing an empty stream uploads a valid gzip stream.
+TEST(ObjectWriteStreambufTest, GzipCompressionEmpty) {
+  auto mock = google::cloud::internal::make_unique<
+      testing::MockResumableUploadSession>();
+  EXPECT_CALL(*mock, done).WillRepeatedly(Return(false));
+  std::string uploaded;
+  EXPECT_CALL(*mock, UploadFinalChunk(_, _))
+      .WillOnce(Invoke([&](std::string const& p, std::uint64_t s) {
+        uploaded = p;
+        EXPECT_EQ(p.size(), s);
+        return make_status_or(ResumableUploadResponse{
+            "{}", 0, {}, ResumableUploadResponse::kDone});
+      }));
+  EXPECT_CALL(*mock, next_expected_byte()).WillOnce(Return(0));
+
+  ObjectWriteStreambuf streambuf(
+      std::move(mock), UploadChunkRequest::kChunkSizeQuantum,
+      google::cloud::internal::make_unique<NullHashValidator>(), nullptr,
+      google::cloud::internal::make_unique<GzipCompressor>());
+  EXPECT_STATUS_OK(streambuf.Close());
+  EXPECT_FALSE(uploaded.empty());
+  EXPECT_EQ("", GzipDecompress(uploaded));
+}
+
+/// @test Verify that the read buffer is obtained from, and returned to, a pool.
+TEST(ObjectReadStreambufTest, UsesBufferPool) {
+  auto pool = std::make_shared<BufferPool>();
+  for (int i = 0; i != 2; ++i) {
+    auto mock =
+        google::cloud::internal::make_unique<testing::MockObjectReadSource>();
+    EXPECT_CALL(*mock, IsOpen).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mock, Read(_, _))
+        .WillOnce(Invoke([](char* buf, std::size_t n) {
+          EXPECT_LE(4U, n);
+          std::memcpy(buf, "abcd", 4);
+          return make_status_or(ReadSourceResult{4, HttpResponse{100, {}, {}}});
+        }));
+
+    ObjectReadStreambuf streambuf(ReadObjectRangeRequest("test-bucket", "obj"),
+                                  std::move(mock), pool);
+    EXPECT_EQ('a', streambuf.sbumpc());
+    EXPECT_EQ(3, streambuf.in_avail());
+  }
+  auto stats = pool->statistics();
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(2U, stats.returns);
+}
+
+/// Create a mock source that returns @p data in blocks of @p block bytes.
+std::unique_ptr<testing::MockObjectReadSource> MockSource(
+    std::string const& data, std::size_t block,
+    std::multimap<std::string, std::string> const& headers) {
+  struct State {
+    std::string data;
+    std::size_t offset;
+  };
+  auto state = std::make_shared<State>(State{data, 0});
+  auto mock =
+      google::cloud::internal::make_unique<testing::MockObjectReadSource>();
+  EXPECT_CALL(*mock, IsOpen).WillRepeatedly(Invoke([state] {
+    return state->offset < state->data.size();
+  }));
+  EXPECT_CALL(*mock, Read(_, _))
+      .WillRepeatedly(Invoke([state, block, headers](char* buf, std::size_t n) {
+        auto count = (std::min)(
+            {n, block, state->data.size() - state->offset});
+        std::memcpy(buf, state->data.data() + state->offset, count);
+        ReadSourceResult result{count, HttpResponse{100, {}, {}}};
+        if (state->offset == 0) {
+          result.response.headers = headers;
+        }
+        state->offset += count;
+        if (state->offset == state->data.size()) {
+          result.response.status_code = 200;
+        }
+        return make_status_or(std::move(result));
+      }));
+  return mock;
+}
+
+std::string GzipCompress(std::string const& data) {
+  GzipCompressor compressor;
+  std::string output;
+  EXPECT_STATUS_OK(
+      compressor.Compress(data.data(), data.size(), true, &output));
+  return output;
+}
+
+/// @test Verify that gzip-encoded downloads are decompressed.
+TEST(ObjectReadStreambufTest, GzipDecompression) {
+  std::string text;
+  for (int i = 0; i != 20000; ++i) {
+    text += "line " + std::to_string(i) + "\n";
+  }
+  auto const compressed = GzipCompress(text);
+  auto const crc32c = ComputeCrc32cChecksum(compressed);
+
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_multiple_options(GzipDecompression(true), DisableMD5Hash(true));
+  ObjectReadStreambuf streambuf(
+      request,
+      MockSource(compressed, 1000,
+                 {{"content-encoding", "gzip"},
+                  {"x-goog-hash", "crc32c=" + crc32c}}),
+      std::make_shared<BufferPool>());
+
+  std::string actual;
+  std::vector<char> buffer(4096);
+  for (;;) {
+    auto n = streambuf.sgetn(buffer.data(),
+                             static_cast<std::streamsize>(buffer.size()));
+    if (n == 0) {
+      break;
+    }
+    actual.append(buffer.data(), static_cast<std::size_t>(n));
+  }
+  EXPECT_STATUS_OK(streambuf.status());
+  EXPECT_EQ(text, actual);
+  EXPECT_EQ(crc32c, streambuf.received_hash());
+  EXPECT_EQ(crc32c, streambuf.computed_hash());
+}
+
+/// @test Verify that both buffers of a gzip download return to the pool.
+TEST(ObjectReadStreambufTest, GzipDecompressionReturnsBuffers) {
+  std::string const text(200000, 'x');
+  auto const compressed = GzipCompress(text);
+
+  auto pool = std::make_shared<BufferPool>();
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_multiple_options(GzipDecompression(true), DisableMD5Hash(true),
+                               DisableCrc32cChecksum(true));
+  ObjectReadStreambuf streambuf(
+      request, MockSource(compressed, 1000, {{"content-encoding", "gzip"}}),
+      pool);
+
+  std::string actual(text.size() + 1, '\0');
+  auto n = streambuf.sgetn(&actual[0],
+                           static_cast<std::streamsize>(actual.size()));
+  EXPECT_EQ(text.size(), static_cast<std::size_t>(n));
+  EXPECT_STATUS_OK(streambuf.status());
+
+  // The buffers are returned when the download completes, before the
+  // streambuf is destroyed.
+  auto stats = pool->statistics();
+  EXPECT_EQ(2U, stats.misses);
+  EXPECT_EQ(2U, stats.returns);
+}
+
+/// @test Verify that objects without gzip encoding are returned unchanged.
+TEST(ObjectReadStreambufTest, GzipDecompressionNotEncoded) {
+  std::string const text(10000, 'x');
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_multiple_options(GzipDecompression(true));
+  ObjectReadStreambuf streambuf(request, MockSource(text, 1000, {}));
+
+  std::string actual(text.size() + 1, '\0');
+  auto n = streambuf.sgetn(&actual[0],
+                           static_cast<std::streamsize>(actual.size()));
+  actual.resize(static_cast<std::size_t>(n));
+  EXPECT_EQ(text, actual);
+}
+
+/// @test Verify that truncated gzip downloads are reported as errors.
+TEST(ObjectReadStreambufTest, GzipDecompressionTruncated) {
+  auto compressed = GzipCompress(std::string(100000, 'x'));
+  compressed.resize(compressed.size() / 2);
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  request.set_multiple_options(GzipDecompression(true), DisableMD5Hash(true),
+                               DisableCrc32cChecksum(true));
+  ObjectReadStreambuf streambuf(
+      request, MockSource(compressed, 10, {{"content-encoding", "gzip"}}));
+
+  std::string actual(200000, '\0');
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+  EXPECT_THROW(streambuf.sgetn(&actual[0],
+                               static_cast<std::streamsize>(actual.size())),
+               std::exception);
+#else
+  streambuf.sgetn(&actual[0], static_cast<std::streamsize>(actual.size()));
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+  EXPECT_EQ(StatusCode::kDataLoss, streambuf.status().code());
+}
+
+/// @test Verify that the headers can be read concurrently.
+TEST(ObjectReadStreambufTest, HeadersConcurrentAccess) {
+  std::string const text(10000, 'x');
+  ReadObjectRangeRequest request("test-bucket", "test-object");
+  ObjectReadStreambuf streambuf(
+      request, MockSource(text, 1000,
+                          {{"x-goog-generation", "1234"},
+                           {"x-goog-metageneration", "1"}}));
+  // The headers are available as soon as the first block is received.
+  EXPECT_EQ('x', streambuf.sgetc());
+
+  std::multimap<std::string, std::string> const expected{
+      {"x-goog-generation", "1234"}, {"x-goog-metageneration", "1"}};
+  std::vector<std::thread> threads;
+  for (int i = 0; i != 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j != 100; ++j) {
+        EXPECT_EQ(expected, streambuf.headers());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
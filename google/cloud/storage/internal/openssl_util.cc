@@ -15,7 +15,6 @@
 #include "google/cloud/storage/internal/openssl_util.h"
 #include "google/cloud/internal/throw_delegate.h"
 #include <openssl/bio.h>
-#include <openssl/buffer.h>
 #include <openssl/evp.h>
 #include <openssl/opensslv.h>
 #include <openssl/pem.h>
@@ -46,6 +45,14 @@ inline std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> GetDigestCtx() {
 };
 #endif
 
+[[noreturn]] void HandleSignFailure(char const* where, char const* error_msg) {
+  std::ostringstream err_builder;
+  err_builder << "Permanent error in " << where
+              << " (failed to sign string with PEM key):\n"
+              << error_msg;
+  google::cloud::internal::ThrowRuntimeError(err_builder.str());
+}
+
 #ifndef OPENSSL_IS_BORINGSSL
 /**
  * Build a BIO chain for Base 64 encoding and decoding.
@@ -90,37 +97,15 @@ std::string Base64Encode(std::uint8_t const* bytes, std::size_t bytes_size) {
   result.resize(out_size);
   return {result.begin(), result.end()};
 #else
-  auto mem_io = std::unique_ptr<BIO, decltype(&BIO_free)>(BIO_new(BIO_s_mem()),
-                                                          &BIO_free);
-  auto bio_chain = PushBase64Transcoding(std::move(mem_io));
-
-  // These BIO_*() operations are guaranteed not to block, consult the NOTES in:
-  //   https://www.openssl.org/docs/man1.1.1/man3/BIO_s_mem.html
-  // for details.
-  int retval = BIO_write(bio_chain.get(), bytes, static_cast<int>(bytes_size));
-  if (retval <= 0) {
-    std::ostringstream err_builder;
-    err_builder << "Permanent error in " << __func__ << ": "
-                << "BIO_write returned non-retryable value of " << retval;
-    google::cloud::internal::ThrowRuntimeError(err_builder.str());
-  }
-
-  // Tell the b64 encoder that we're done writing data, thus prompting it to
-  // add trailing '=' characters for padding if needed.
-  retval = BIO_flush(bio_chain.get());
-  if (retval <= 0) {
-    std::ostringstream err_builder;
-    err_builder << "Permanent error in " << __func__ << ": "
-                << "BIO_flush returned non-retryable value of " << retval;
-    google::cloud::internal::ThrowRuntimeError(err_builder.str());
-  }
-
-  // This buffer belongs to the BIO chain and is freed upon its destruction.
-  BUF_MEM* buf_mem;
-  BIO_get_mem_ptr(bio_chain.get(), &buf_mem);
-  // Return a string copy of the buffer's bytes, as the buffer will be freed
-  // upon this method's exit.
-  return std::string(buf_mem->data, buf_mem->length);
+  // EVP_EncodeBlock() writes 4 characters for each 3 bytes (or fraction) of
+  // input, followed by a NUL terminator. Encoding directly into the result
+  // avoids the allocations of a BIO chain.
+  std::string result(4 * ((bytes_size + 2) / 3) + 1, '\0');
+  auto const out_size =
+      EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&result[0]), bytes,
+                      static_cast<int>(bytes_size));
+  result.resize(static_cast<std::size_t>(out_size));
+  return result;
 #endif  // OPENSSL_IS_BORINGSSL
 }
 }  // namespace
@@ -176,32 +161,28 @@ std::string Base64Encode(std::vector<std::uint8_t> const& bytes) {
 std::vector<std::uint8_t> SignStringWithPem(
     std::string const& str, std::string const& pem_contents,
     storage::oauth2::JwtSigningAlgorithms alg) {
-  using ::google::cloud::storage::oauth2::JwtSigningAlgorithms;
-
-  // We check for failures several times, so we shorten this into a lambda
-  // to avoid bloating the code with alloc/init checks.
-  const char* func_name = __func__;  // Avoid using the lambda name instead.
-  auto handle_openssl_failure = [&func_name](const char* error_msg) -> void {
-    std::ostringstream err_builder;
-    err_builder << "Permanent error in " << func_name
-                << " (failed to sign string with PEM key):\n"
-                << error_msg;
-    google::cloud::internal::ThrowRuntimeError(err_builder.str());
-  };
+  return PemSigner(pem_contents, alg).Sign(str);
+}
 
-  auto digest_ctx = GetDigestCtx();
-  if (!digest_ctx) {
-    handle_openssl_failure("Could not create context for OpenSSL digest.");
-  }
+struct PemSigner::Impl {
+  Impl() : private_key(nullptr, &EVP_PKEY_free) {}
 
+  std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> private_key;
   EVP_MD const* digest_type = nullptr;
+};
+
+PemSigner::PemSigner(std::string const& pem_contents,
+                     storage::oauth2::JwtSigningAlgorithms alg) {
+  using ::google::cloud::storage::oauth2::JwtSigningAlgorithms;
+
+  auto impl = std::make_shared<Impl>();
   switch (alg) {
     case JwtSigningAlgorithms::RS256:
-      digest_type = EVP_sha256();
+      impl->digest_type = EVP_sha256();
       break;
   }
-  if (digest_type == nullptr) {
-    handle_openssl_failure("Could not find specified digest in OpenSSL.");
+  if (impl->digest_type == nullptr) {
+    HandleSignFailure(__func__, "Could not find specified digest in OpenSSL.");
   }
 
   auto pem_buffer = std::unique_ptr<BIO, decltype(&BIO_free)>(
@@ -209,36 +190,42 @@ std::vector<std::uint8_t> SignStringWithPem(
                       static_cast<int>(pem_contents.length())),
       &BIO_free);
   if (!pem_buffer) {
-    handle_openssl_failure("Could not create PEM buffer.");
+    HandleSignFailure(__func__, "Could not create PEM buffer.");
+  }
+
+  impl->private_key.reset(PEM_read_bio_PrivateKey(
+      pem_buffer.get(),
+      nullptr,  // EVP_PKEY **x
+      nullptr,  // pem_password_cb *cb -- a custom callback.
+      // void *u -- this represents the password for the PEM (only
+      // applicable for formats such as PKCS12 (.p12 files) that use
+      // a password, which we don't currently support.
+      nullptr));
+  if (!impl->private_key) {
+    HandleSignFailure(__func__, "Could not parse PEM to get private key.");
   }
+  impl_ = std::move(impl);
+}
 
-  auto private_key = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>(
-      PEM_read_bio_PrivateKey(
-          pem_buffer.get(),
-          nullptr,  // EVP_PKEY **x
-          nullptr,  // pem_password_cb *cb -- a custom callback.
-          // void *u -- this represents the password for the PEM (only
-          // applicable for formats such as PKCS12 (.p12 files) that use
-          // a password, which we don't currently support.
-          nullptr),
-      &EVP_PKEY_free);
-  if (!private_key) {
-    handle_openssl_failure("Could not parse PEM to get private key.");
+std::vector<std::uint8_t> PemSigner::Sign(std::string const& str) const {
+  auto digest_ctx = GetDigestCtx();
+  if (!digest_ctx) {
+    HandleSignFailure(__func__, "Could not create context for OpenSSL digest.");
   }
 
   int const digest_sign_success_code = 1;
   if (digest_sign_success_code !=
       EVP_DigestSignInit(digest_ctx.get(),
                          nullptr,  // EVP_PKEY_CTX **pctx
-                         digest_type,
+                         impl_->digest_type,
                          nullptr,  // ENGINE *e
-                         private_key.get())) {
-    handle_openssl_failure("Could not initialize PEM digest.");
+                         impl_->private_key.get())) {
+    HandleSignFailure(__func__, "Could not initialize PEM digest.");
   }
 
   if (digest_sign_success_code !=
       EVP_DigestSignUpdate(digest_ctx.get(), str.data(), str.length())) {
-    handle_openssl_failure("Could not update PEM digest.");
+    HandleSignFailure(__func__, "Could not update PEM digest.");
   }
 
   std::size_t signed_str_size = 0;
@@ -249,17 +236,17 @@ std::vector<std::uint8_t> SignStringWithPem(
       EVP_DigestSignFinal(digest_ctx.get(),
                           nullptr,  // unsigned char *sig
                           &signed_str_size)) {
-    handle_openssl_failure("Could not finalize PEM digest (1/2).");
+    HandleSignFailure(__func__, "Could not finalize PEM digest (1/2).");
   }
 
-  std::vector<unsigned char> signed_str(signed_str_size);
+  std::vector<std::uint8_t> signed_str(signed_str_size);
   if (digest_sign_success_code != EVP_DigestSignFinal(digest_ctx.get(),
                                                       signed_str.data(),
                                                       &signed_str_size)) {
-    handle_openssl_failure("Could not finalize PEM digest (2/2).");
+    HandleSignFailure(__func__, "Could not finalize PEM digest (2/2).");
   }
-
-  return {signed_str.begin(), signed_str.end()};
+  signed_str.resize(signed_str_size);
+  return signed_str;
 }
 
 std::vector<std::uint8_t> UrlsafeBase64Decode(std::string const& str) {
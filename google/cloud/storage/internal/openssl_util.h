@@ -18,6 +18,8 @@
 #include "google/cloud/storage/oauth2/credential_constants.h"
 #include "google/cloud/storage/version.h"
 #include <algorithm>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace google {
@@ -52,6 +54,32 @@ std::vector<std::uint8_t> SignStringWithPem(
     std::string const& str, std::string const& pem_contents,
     storage::oauth2::JwtSigningAlgorithms alg);
 
+/**
+ * Signs strings with a private key parsed once from a PEM container.
+ *
+ * Parsing the PEM container is a significant fraction of the cost of
+ * `SignStringWithPem()`. Callers that sign many strings with the same key
+ * should create one of these objects and reuse it. The object is immutable,
+ * and can be used from multiple threads at the same time.
+ */
+class PemSigner {
+ public:
+  /**
+   * Parses the private key in @p pem_contents.
+   *
+   * @throw std::runtime_error if the key cannot be parsed.
+   */
+  PemSigner(std::string const& pem_contents,
+            storage::oauth2::JwtSigningAlgorithms alg);
+
+  /// Signs @p str, returns the *unencoded* signature.
+  std::vector<std::uint8_t> Sign(std::string const& str) const;
+
+ private:
+  struct Impl;
+  std::shared_ptr<Impl const> impl_;
+};
+
 /**
  * Returns a Base64-encoded version of @p bytes. Using the URL- and
  * filesystem-safe alphabet, making these adjustments:
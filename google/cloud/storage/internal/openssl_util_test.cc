@@ -68,6 +68,14 @@ TEST(OpensslUtilTest, Base64DecodePadding) {
   EXPECT_THAT(UrlsafeBase64Decode("QUJDRA=="), ElementsAre('A', 'B', 'C', 'D'));
 }
 
+TEST(OpensslUtilTest, Base64EncodePadding) {
+  EXPECT_EQ("", Base64Encode(""));
+  EXPECT_EQ("QQ==", Base64Encode("A"));
+  EXPECT_EQ("QUI=", Base64Encode("AB"));
+  EXPECT_EQ("QUJD", Base64Encode("ABC"));
+  EXPECT_EQ("QUJDRA==", Base64Encode("ABCD"));
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
@@ -16,9 +16,10 @@
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_PATCH_BUILDER_H_
 
 #include "google/cloud/optional.h"
-#include "google/cloud/storage/internal/nljson.h"
+#include "google/cloud/storage/internal/json_writer.h"
 #include "google/cloud/storage/version.h"
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -38,6 +39,10 @@ namespace internal {
  *
  * At a high level: fields present in the patch are set to their new values,
  * unless the field has value `null`, in which case the field is removed.
+ *
+ * The builder keeps each field already serialized as JSON, sorted by name, so
+ * creating the payload for a patch with many fields (e.g. a large number of
+ * custom metadata keys) only concatenates the fields.
  */
 class PatchBuilder {
  public:
@@ -45,14 +50,18 @@ class PatchBuilder {
 
   /// Return the patch as a string.
   std::string ToString() const {
-    if (empty()) {
-      return "{}";
+    std::string result;
+    JsonWriter writer(result);
+    writer.StartObject();
+    for (auto const& kv : fields_) {
+      writer.Key(kv.first).RawValue(kv.second);
     }
-    return patch_.dump();
+    writer.EndObject();
+    return result;
   }
 
-  bool empty() const { return patch_.empty(); }
-  void clear() { patch_.clear(); }
+  bool empty() const { return fields_.empty(); }
+  void clear() { fields_.clear(); }
 
   //@{
   /// @name Calculate the delta between the original (`lhs`) and the new (`rhs`)
@@ -63,10 +72,10 @@ class PatchBuilder {
                                std::string const& rhs) {
     if (lhs == rhs) return *this;
     if (rhs.empty()) {
-      patch_[field_name] = nullptr;
+      SetField(field_name, nullptr);
       return *this;
     }
-    patch_[field_name] = rhs;
+    SetField(field_name, rhs);
     return *this;
   }
 
@@ -78,7 +87,7 @@ class PatchBuilder {
    */
   PatchBuilder& AddBoolField(char const* field_name, bool lhs, bool rhs) {
     if (lhs == rhs) return *this;
-    patch_[field_name] = rhs;
+    SetField(field_name, rhs);
     return *this;
   }
 
@@ -116,10 +125,10 @@ class PatchBuilder {
                                  google::cloud::optional<T> const& rhs) {
     if (lhs == rhs) return *this;
     if (!rhs.has_value()) {
-      patch_[field_name] = nullptr;
+      SetField(field_name, nullptr);
       return *this;
     }
-    patch_[field_name] = *rhs;
+    SetField(field_name, *rhs);
     return *this;
   }
 
@@ -140,10 +149,10 @@ class PatchBuilder {
                               std::vector<T> const& rhs) {
     if (lhs == rhs) return *this;
     if (rhs.empty()) {
-      patch_[field_name] = nullptr;
+      SetField(field_name, nullptr);
       return *this;
     }
-    patch_[field_name] = rhs;
+    SetField(field_name, rhs);
     return *this;
   }
   //@}
@@ -151,51 +160,55 @@ class PatchBuilder {
   /// Add a patch for @p field_name.
   PatchBuilder& AddSubPatch(char const* field_name,
                             PatchBuilder const& builder) {
-    patch_[field_name] = builder.patch_;
+    // An empty sub-patch removes the field.
+    if (builder.empty()) {
+      return SetField(field_name, nullptr);
+    }
+    fields_[field_name] = builder.ToString();
     return *this;
   }
 
   /// Create a patch that removes @p field_name
   PatchBuilder& RemoveField(char const* field_name) {
-    patch_[field_name] = nullptr;
+    SetField(field_name, nullptr);
     return *this;
   }
 
   //@{
   /// @name Create a patch that sets fields to the given value.
   PatchBuilder& SetStringField(char const* field_name, std::string const& v) {
-    patch_[field_name] = v;
+    SetField(field_name, v);
     return *this;
   }
 
   PatchBuilder& SetBoolField(char const* field_name, bool v) {
-    patch_[field_name] = v;
+    SetField(field_name, v);
     return *this;
   }
 
   PatchBuilder& SetIntField(char const* field_name, std::int32_t v) {
-    patch_[field_name] = v;
+    SetField(field_name, v);
     return *this;
   }
 
   PatchBuilder& SetIntField(char const* field_name, std::uint32_t v) {
-    patch_[field_name] = v;
+    SetField(field_name, v);
     return *this;
   }
 
   PatchBuilder& SetIntField(char const* field_name, std::int64_t v) {
-    patch_[field_name] = v;
+    SetField(field_name, v);
     return *this;
   }
 
   PatchBuilder& SetIntField(char const* field_name, std::uint64_t v) {
-    patch_[field_name] = v;
+    SetField(field_name, v);
     return *this;
   }
 
   template <typename T>
   PatchBuilder& SetArrayField(char const* field_name, std::vector<T> const& v) {
-    patch_[field_name] = v;
+    SetField(field_name, v);
     return *this;
   }
   //@}
@@ -207,14 +220,23 @@ class PatchBuilder {
                                 Integer rhs, Integer null_value) {
     if (lhs == rhs) return *this;
     if (rhs == null_value) {
-      patch_[field_name] = nullptr;
+      SetField(field_name, nullptr);
       return *this;
     }
-    patch_[field_name] = rhs;
+    SetField(field_name, rhs);
+    return *this;
+  }
+
+  /// Replace the value of @p field_name with the serialized @p v.
+  template <typename T>
+  PatchBuilder& SetField(char const* field_name, T const& v) {
+    std::string& field = fields_[field_name];
+    field.clear();
+    JsonWriter(field).Value(v);
     return *this;
   }
 
-  nl::json patch_;
+  std::map<std::string, std::string> fields_;
 };
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
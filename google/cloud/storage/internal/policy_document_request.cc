@@ -25,14 +25,21 @@ inline namespace STORAGE_CLIENT_NS {
 namespace internal {
 
 std::string PolicyDocumentRequest::StringToSign() const {
+  return PolicyDocumentStringToSign(policy_document());
+}
+
+std::ostream& operator<<(std::ostream& os, PolicyDocumentRequest const& r) {
+  return os << "PolicyDocumentRequest={" << r.StringToSign() << "}";
+}
+
+std::string PolicyDocumentStringToSign(PolicyDocument const& document) {
   using internal::nl::json;
-  auto document = policy_document();
 
   json j;
   j["expiration"] = google::cloud::internal::FormatRfc3339(document.expiration);
 
   for (auto const& kv : document.conditions) {
-    std::vector<std::string> elements = kv.elements();
+    auto const& elements = kv.elements();
 
     /**
      * If the elements is of size 2, we've encountered an exact match in
@@ -54,10 +61,6 @@ std::string PolicyDocumentRequest::StringToSign() const {
   return std::move(j).dump();
 }
 
-std::ostream& operator<<(std::ostream& os, PolicyDocumentRequest const& r) {
-  return os << "PolicyDocumentRequest={" << r.StringToSign() << "}";
-}
-
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
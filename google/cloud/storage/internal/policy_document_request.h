@@ -70,6 +70,9 @@ class PolicyDocumentRequest {
 
 std::ostream& operator<<(std::ostream& os, PolicyDocumentRequest const& r);
 
+/// Creates the string to be signed for @p document.
+std::string PolicyDocumentStringToSign(PolicyDocument const& document);
+
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
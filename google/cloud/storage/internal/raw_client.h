@@ -85,6 +85,8 @@ class RawClient {
       ReadObjectRangeRequest const&) = 0;
   virtual StatusOr<ListObjectsResponse> ListObjects(
       ListObjectsRequest const&) = 0;
+  virtual StatusOr<ListObjectSummariesResponse> ListObjectSummaries(
+      ListObjectsRequest const&) = 0;
   virtual StatusOr<EmptyResponse> DeleteObject(DeleteObjectRequest const&) = 0;
   virtual StatusOr<ObjectMetadata> UpdateObject(UpdateObjectRequest const&) = 0;
   virtual StatusOr<ObjectMetadata> PatchObject(PatchObjectRequest const&) = 0;
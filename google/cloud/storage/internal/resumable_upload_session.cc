@@ -40,7 +40,7 @@ StatusOr<ResumableUploadResponse> ResumableUploadResponse::FromHttpResponse(
   // We expect a `Range:` header in the format described here:
   //    https://cloud.google.com/storage/docs/json_api/v1/how-tos/resumable-upload
   // that is the value should match `bytes=0-[0-9]+`:
-  std::string const& range = response.headers.find("range")->second;
+  auto const range = response.headers.find("range")->second;
 
   if (range.rfind("bytes=0-", 0) != 0) {
     return result;
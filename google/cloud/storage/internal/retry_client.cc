@@ -17,6 +17,7 @@
 #include "google/cloud/storage/internal/raw_client_wrapper_utils.h"
 #include "google/cloud/storage/internal/retry_object_read_source.h"
 #include "google/cloud/storage/internal/retry_resumable_upload_session.h"
+#include "google/cloud/storage/transfer_metrics.h"
 #include <sstream>
 #include <thread>
 
@@ -61,6 +62,8 @@ using ::google::cloud::storage::internal::raw_client_wrapper_utils::Signature;
  * @param function the pointer to the member function to call.
  * @param request an initialized request parameter for the call.
  * @param error_message include this message in any exception or error log.
+ * @param attempts if not null, the number of attempts already made for this
+ *     operation on input, updated with the attempts made by this call.
  * @return the result from making the call;
  * @throw std::exception with a description of the last error.
  */
@@ -69,13 +72,16 @@ typename Signature<MemberFunction>::ReturnType MakeCall(
     RetryPolicy& retry_policy, BackoffPolicy& backoff_policy,
     bool is_idempotent, RawClient& client, MemberFunction function,
     typename Signature<MemberFunction>::RequestType const& request,
-    char const* error_message) {
+    char const* error_message, int* attempts = nullptr) {
   Status last_status;
   auto error = [&last_status](std::string const& msg) {
     return Status(last_status.code(), msg);
   };
 
-  while (!retry_policy.IsExhausted()) {
+  int attempt = attempts == nullptr ? 0 : *attempts;
+  for (; !retry_policy.IsExhausted(); ++attempt) {
+    ScopedRetryAttempt scoped_attempt(attempt);
+    if (attempts != nullptr) *attempts = attempt + 1;
     auto result = (client.*function)(request);
     if (result.ok()) {
       return result;
@@ -244,23 +250,24 @@ StatusOr<ObjectMetadata> RetryClient::GetObjectMetadata(
 }
 
 StatusOr<std::unique_ptr<ObjectReadSource>> RetryClient::ReadObjectNotWrapped(
-    ReadObjectRangeRequest const& request) {
+    ReadObjectRangeRequest const& request, int* attempts) {
   auto retry_policy = retry_policy_->clone();
   auto backoff_policy = backoff_policy_->clone();
   auto is_idempotent = idempotency_policy_->IsIdempotent(request);
   return MakeCall(*retry_policy, *backoff_policy, is_idempotent, *client_,
-                  &RawClient::ReadObject, request, __func__);
+                  &RawClient::ReadObject, request, __func__, attempts);
 }
 
 StatusOr<std::unique_ptr<ObjectReadSource>> RetryClient::ReadObject(
     ReadObjectRangeRequest const& request) {
-  auto child = ReadObjectNotWrapped(request);
+  int attempts = 0;
+  auto child = ReadObjectNotWrapped(request, &attempts);
   if (!child) {
     return child;
   }
   auto self = shared_from_this();
   return std::unique_ptr<ObjectReadSource>(
-      new RetryObjectReadSource(self, request, *std::move(child)));
+      new RetryObjectReadSource(self, request, *std::move(child), attempts));
 }
 
 StatusOr<ListObjectsResponse> RetryClient::ListObjects(
@@ -272,6 +279,15 @@ StatusOr<ListObjectsResponse> RetryClient::ListObjects(
                   &RawClient::ListObjects, request, __func__);
 }
 
+StatusOr<ListObjectSummariesResponse> RetryClient::ListObjectSummaries(
+    ListObjectsRequest const& request) {
+  auto retry_policy = retry_policy_->clone();
+  auto backoff_policy = backoff_policy_->clone();
+  auto is_idempotent = idempotency_policy_->IsIdempotent(request);
+  return MakeCall(*retry_policy, *backoff_policy, is_idempotent, *client_,
+                  &RawClient::ListObjectSummaries, request, __func__);
+}
+
 StatusOr<EmptyResponse> RetryClient::DeleteObject(
     DeleteObjectRequest const& request) {
   auto retry_policy = retry_policy_->clone();
@@ -75,13 +75,20 @@ class RetryClient : public RawClient,
   StatusOr<ObjectMetadata> GetObjectMetadata(
       GetObjectMetadataRequest const& request) override;
 
-  /// Call ReadObject() but do not wrap the result in a RetryObjectReadSource.
+  /**
+   * Call ReadObject() but do not wrap the result in a RetryObjectReadSource.
+   *
+   * If @p attempts is not null the retry attempts are numbered starting at
+   * `*attempts`, and `*attempts` is updated with the attempts made.
+   */
   StatusOr<std::unique_ptr<ObjectReadSource>> ReadObjectNotWrapped(
-      ReadObjectRangeRequest const&);
+      ReadObjectRangeRequest const&, int* attempts = nullptr);
   StatusOr<std::unique_ptr<ObjectReadSource>> ReadObject(
       ReadObjectRangeRequest const&) override;
 
   StatusOr<ListObjectsResponse> ListObjects(ListObjectsRequest const&) override;
+  StatusOr<ListObjectSummariesResponse> ListObjectSummaries(
+      ListObjectsRequest const&) override;
   StatusOr<EmptyResponse> DeleteObject(DeleteObjectRequest const&) override;
   StatusOr<ObjectMetadata> UpdateObject(
       UpdateObjectRequest const& request) override;
@@ -13,8 +13,10 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/retry_client.h"
+#include "google/cloud/internal/make_unique.h"
 #include "google/cloud/storage/testing/canonical_errors.h"
 #include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/storage/transfer_metrics.h"
 #include "google/cloud/testing_util/chrono_literals.h"
 #include <gmock/gmock.h>
 
@@ -30,6 +32,7 @@ using ::google::cloud::storage::testing::canonical_errors::PermanentError;
 using ::google::cloud::storage::testing::canonical_errors::TransientError;
 using ::testing::_;
 using ::testing::HasSubstr;
+using ::testing::Invoke;
 using ::testing::Return;
 
 class RetryClientTest : public ::testing::Test {
@@ -90,6 +93,57 @@ TEST_F(RetryClientTest, TooManyTransientsHandling) {
   EXPECT_EQ(TransientError().code(), result.status().code());
 }
 
+/// @test Verify that resumed downloads continue numbering the retry attempts.
+TEST_F(RetryClientTest, ReadObjectResumePropagatesAttempt) {
+  auto client = std::make_shared<RetryClient>(
+      std::shared_ptr<internal::RawClient>(mock),
+      LimitedErrorCountRetryPolicy(3),
+      // Make the tests faster.
+      ExponentialBackoffPolicy(1_us, 2_us, 2));
+
+  std::vector<int> attempts;
+  auto broken_source = [&attempts](ReadObjectRangeRequest const&) {
+    attempts.push_back(CurrentRetryAttempt());
+    auto source = google::cloud::internal::make_unique<
+        testing::MockObjectReadSource>();
+    EXPECT_CALL(*source, Read(_, _))
+        .WillOnce(Return(StatusOr<ReadSourceResult>(TransientError())));
+    return StatusOr<std::unique_ptr<ObjectReadSource>>(std::move(source));
+  };
+  std::vector<int> read_attempts;
+  auto good_source = [&attempts,
+                      &read_attempts](ReadObjectRangeRequest const&) {
+    attempts.push_back(CurrentRetryAttempt());
+    auto source = google::cloud::internal::make_unique<
+        testing::MockObjectReadSource>();
+    EXPECT_CALL(*source, Read(_, _))
+        .WillOnce(Invoke([&read_attempts](char*, std::size_t) {
+          read_attempts.push_back(CurrentRetryAttempt());
+          return ReadSourceResult{0, HttpResponse{200, {}, {}}};
+        }));
+    return StatusOr<std::unique_ptr<ObjectReadSource>>(std::move(source));
+  };
+  auto transient = [&attempts](ReadObjectRangeRequest const&) {
+    attempts.push_back(CurrentRetryAttempt());
+    return StatusOr<std::unique_ptr<ObjectReadSource>>(TransientError());
+  };
+  EXPECT_CALL(*mock, ReadObject(_))
+      .WillOnce(Invoke(transient))
+      .WillOnce(Invoke(broken_source))
+      .WillOnce(Invoke(transient))
+      .WillOnce(Invoke(good_source));
+
+  auto source =
+      client->ReadObject(ReadObjectRangeRequest("test-bucket", "test-object"));
+  ASSERT_TRUE(source.ok()) << source.status();
+  char buf[16];
+  auto result = (*source)->Read(buf, sizeof(buf));
+  ASSERT_TRUE(result.ok()) << result.status();
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), attempts);
+  EXPECT_EQ(std::vector<int>({3}), read_attempts);
+  EXPECT_EQ(0, CurrentRetryAttempt());
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace STORAGE_CLIENT_NS
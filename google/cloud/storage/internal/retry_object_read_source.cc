@@ -14,6 +14,7 @@
 
 #include "google/cloud/storage/internal/retry_object_read_source.h"
 #include "google/cloud/log.h"
+#include "google/cloud/storage/transfer_metrics.h"
 
 namespace google {
 namespace cloud {
@@ -22,11 +23,12 @@ inline namespace STORAGE_CLIENT_NS {
 namespace internal {
 RetryObjectReadSource::RetryObjectReadSource(
     std::shared_ptr<RetryClient> client, ReadObjectRangeRequest request,
-    std::unique_ptr<ObjectReadSource> child)
+    std::unique_ptr<ObjectReadSource> child, int attempts)
     : client_(std::move(client)),
       request_(std::move(request)),
       child_(std::move(child)),
-      current_offset_(request_.StartingByte()) {}
+      current_offset_(request_.StartingByte()),
+      attempts_(attempts) {}
 
 StatusOr<ReadSourceResult> RetryObjectReadSource::Read(char* buf,
                                                        std::size_t n) {
@@ -45,13 +47,14 @@ StatusOr<ReadSourceResult> RetryObjectReadSource::Read(char* buf,
     if (generation_) {
       request_.set_option(Generation(*generation_));
     }
-    auto new_child = client_->ReadObjectNotWrapped(request_);
+    auto new_child = client_->ReadObjectNotWrapped(request_, &attempts_);
     if (!new_child) {
       // Failing to create a new child is an unrecoverable error: the
       // ReadObjectNotWrapped() function already retried multiple times.
       return new_child.status();
     }
-    // Repeat the Read() request on the new child.
+    // Repeat the Read() request on the new child, as part of the same attempt.
+    ScopedRetryAttempt scoped_attempt(attempts_ - 1);
     result = (*new_child)->Read(buf, n);
     if (!result) {
       // This is a permanent failure, we created a new child but it turned out
@@ -36,7 +36,8 @@ class RetryObjectReadSource : public ObjectReadSource {
  public:
   RetryObjectReadSource(std::shared_ptr<RetryClient> client,
                         ReadObjectRangeRequest request,
-                        std::unique_ptr<ObjectReadSource> child);
+                        std::unique_ptr<ObjectReadSource> child,
+                        int attempts = 1);
 
   bool IsOpen() const override { return child_ && child_->IsOpen(); }
   StatusOr<HttpResponse> Close() override { return child_->Close(); }
@@ -48,6 +49,9 @@ class RetryObjectReadSource : public ObjectReadSource {
   std::unique_ptr<ObjectReadSource> child_;
   std::int64_t current_offset_;
   optional<std::int64_t> generation_;
+  // The number of attempts made to download the object, resumed reads continue
+  // numbering the retry attempts from here.
+  int attempts_;
 };
 
 }  // namespace internal
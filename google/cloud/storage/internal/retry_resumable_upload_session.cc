@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "google/cloud/storage/internal/retry_resumable_upload_session.h"
+#include "google/cloud/storage/transfer_metrics.h"
 #include <sstream>
 #include <thread>
 
@@ -39,7 +40,8 @@ StatusOr<ResumableUploadResponse> ReturnError(Status&& last_status,
 StatusOr<ResumableUploadResponse> RetryResumableUploadSession::UploadChunk(
     std::string const& buffer) {
   Status last_status;
-  while (!retry_policy_->IsExhausted()) {
+  for (int attempt = 0; !retry_policy_->IsExhausted(); ++attempt) {
+    ScopedRetryAttempt scoped_attempt(attempt);
     auto result = session_->UploadChunk(buffer);
     if (result.ok()) {
       return result;
@@ -64,7 +66,8 @@ StatusOr<ResumableUploadResponse> RetryResumableUploadSession::UploadChunk(
 StatusOr<ResumableUploadResponse> RetryResumableUploadSession::UploadFinalChunk(
     std::string const& buffer, std::uint64_t upload_size) {
   Status last_status;
-  while (!retry_policy_->IsExhausted()) {
+  for (int attempt = 0; !retry_policy_->IsExhausted(); ++attempt) {
+    ScopedRetryAttempt scoped_attempt(attempt);
     auto result = session_->UploadFinalChunk(buffer, upload_size);
     if (result.ok()) {
       return result;
@@ -88,7 +91,8 @@ StatusOr<ResumableUploadResponse> RetryResumableUploadSession::UploadFinalChunk(
 
 StatusOr<ResumableUploadResponse> RetryResumableUploadSession::ResetSession() {
   Status last_status;
-  while (!retry_policy_->IsExhausted()) {
+  for (int attempt = 0; !retry_policy_->IsExhausted(); ++attempt) {
+    ScopedRetryAttempt scoped_attempt(attempt);
     auto result = session_->ResetSession();
     if (result.ok()) {
       return result;
@@ -0,0 +1,80 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/token_bucket.h"
+#include <algorithm>
+#include <cmath>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+TokenBucket::TokenBucket(double rate, double burst,
+                         std::function<Clock::time_point()> clock)
+    : rate_(rate),
+      burst_(burst),
+      clock_(std::move(clock)),
+      tokens_(burst),
+      last_fill_(clock_()) {}
+
+bool TokenBucket::TryConsume(std::uint64_t count) {
+  std::lock_guard<std::mutex> lk(mu_);
+  Refill();
+  if (tokens_ <= 0) {
+    return false;
+  }
+  tokens_ -= static_cast<double>(count);
+  return true;
+}
+
+std::chrono::microseconds TokenBucket::Reserve(std::uint64_t count) {
+  std::lock_guard<std::mutex> lk(mu_);
+  Refill();
+  tokens_ -= static_cast<double>(count);
+  return tokens_ >= 0 ? std::chrono::microseconds(0) : TimeFor(-tokens_);
+}
+
+std::chrono::microseconds TokenBucket::WaitTime() {
+  std::lock_guard<std::mutex> lk(mu_);
+  Refill();
+  if (tokens_ > 0) {
+    return std::chrono::microseconds(0);
+  }
+  // Round up, after this time the balance is positive, not just zero.
+  return TimeFor(-tokens_) + std::chrono::microseconds(1);
+}
+
+void TokenBucket::Refill() {
+  auto const now = clock_();
+  if (now <= last_fill_) {
+    return;
+  }
+  auto const elapsed =
+      std::chrono::duration_cast<std::chrono::duration<double>>(now -
+                                                                last_fill_);
+  tokens_ = (std::min)(burst_, tokens_ + elapsed.count() * rate_);
+  last_fill_ = now;
+}
+
+std::chrono::microseconds TokenBucket::TimeFor(double tokens) const {
+  return std::chrono::microseconds(
+      static_cast<std::int64_t>(std::ceil(tokens / rate_ * 1.0E6)));
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,110 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TOKEN_BUCKET_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TOKEN_BUCKET_H_
+
+#include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * A thread-safe token bucket to limit the rate of requests or bytes.
+ *
+ * Tokens are added at a constant rate, up to a maximum (the burst size). Any
+ * positive balance allows a caller to proceed, and the caller then consumes
+ * as many tokens as it needs, possibly leaving a negative balance. This
+ * "debt" is repaid before any other caller can proceed, so the long-term
+ * rate is respected even though the callers cannot split their work in
+ * arbitrary units. For example, libcurl delivers data in blocks of up to
+ * `CURL_MAX_WRITE_SIZE` bytes, and the write callbacks must consume the full
+ * block or pause the transfer.
+ */
+class TokenBucket {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Creates a bucket with @p burst tokens.
+   *
+   * @param rate the number of tokens added each second.
+   * @param burst the maximum number of tokens in the bucket.
+   * @param clock returns the current time, the tests use this to simulate
+   *     the passage of time.
+   */
+  TokenBucket(double rate, double burst,
+              std::function<Clock::time_point()> clock = &Clock::now);
+
+  /**
+   * Consumes @p count tokens if the balance is positive.
+   *
+   * @return true if the tokens were consumed, the caller can proceed.
+   */
+  bool TryConsume(std::uint64_t count);
+
+  /**
+   * Consumes @p count tokens, even if the balance becomes negative.
+   *
+   * @return how long the caller must wait before using the tokens, that is,
+   *     until the balance is no longer negative.
+   */
+  std::chrono::microseconds Reserve(std::uint64_t count);
+
+  /// How long until `TryConsume()` can succeed, zero if it can succeed now.
+  std::chrono::microseconds WaitTime();
+
+  double rate() const { return rate_; }
+  double burst() const { return burst_; }
+
+ private:
+  /// Add the tokens accumulated since the last refill.
+  void Refill();
+
+  /// The time to accumulate @p tokens tokens.
+  std::chrono::microseconds TimeFor(double tokens) const;
+
+  double const rate_;
+  double const burst_;
+  std::function<Clock::time_point()> clock_;
+
+  std::mutex mu_;
+  double tokens_;                // GUARDED_BY(mu_)
+  Clock::time_point last_fill_;  // GUARDED_BY(mu_)
+};
+
+/// The rate limits shared by all the requests created by a client.
+struct RateLimiters {
+  /// Limits the number of requests per second, null for no limit.
+  std::shared_ptr<TokenBucket> requests;
+  /// Limits the number of bytes sent per second, null for no limit.
+  std::shared_ptr<TokenBucket> upload_bytes;
+  /// Limits the number of bytes received per second, null for no limit.
+  std::shared_ptr<TokenBucket> download_bytes;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TOKEN_BUCKET_H_
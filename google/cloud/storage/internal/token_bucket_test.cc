@@ -0,0 +1,89 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/token_bucket.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using us = std::chrono::microseconds;
+
+class TokenBucketTest : public ::testing::Test {
+ protected:
+  std::function<TokenBucket::Clock::time_point()> FakeClock() {
+    return [this] { return now_; };
+  }
+  void Advance(us d) { now_ += d; }
+
+  TokenBucket::Clock::time_point now_ = TokenBucket::Clock::now();
+};
+
+TEST_F(TokenBucketTest, StartsFull) {
+  TokenBucket bucket(1000, 100, FakeClock());
+  EXPECT_EQ(0, bucket.WaitTime().count());
+  EXPECT_TRUE(bucket.TryConsume(60));
+  EXPECT_TRUE(bucket.TryConsume(60));
+  // The balance is now -20, that takes 20ms to repay at 1000 tokens/s.
+  EXPECT_FALSE(bucket.TryConsume(1));
+  EXPECT_EQ(20001, bucket.WaitTime().count());
+}
+
+TEST_F(TokenBucketTest, Refill) {
+  TokenBucket bucket(1000, 100, FakeClock());
+  EXPECT_TRUE(bucket.TryConsume(150));
+  Advance(us(40000));
+  EXPECT_FALSE(bucket.TryConsume(1));
+  Advance(us(10001));
+  EXPECT_EQ(0, bucket.WaitTime().count());
+  EXPECT_TRUE(bucket.TryConsume(1));
+
+  // The bucket never holds more than the burst size.
+  Advance(us(10 * 1000 * 1000));
+  EXPECT_TRUE(bucket.TryConsume(100));
+  EXPECT_FALSE(bucket.TryConsume(1));
+}
+
+TEST_F(TokenBucketTest, Reserve) {
+  TokenBucket bucket(10, 1, FakeClock());
+  EXPECT_EQ(0, bucket.Reserve(1).count());
+  EXPECT_EQ(100000, bucket.Reserve(1).count());
+  EXPECT_EQ(200000, bucket.Reserve(1).count());
+  Advance(us(300000));
+  EXPECT_EQ(0, bucket.Reserve(1).count());
+}
+
+TEST_F(TokenBucketTest, LongTermRate) {
+  TokenBucket bucket(1000, 10, FakeClock());
+  // Consume in blocks much larger than the burst size, for 10 seconds.
+  std::uint64_t consumed = 0;
+  for (int i = 0; i != 10000; ++i) {
+    if (bucket.TryConsume(250)) {
+      consumed += 250;
+    }
+    Advance(us(1000));
+  }
+  EXPECT_NEAR(10000, consumed, 260);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,72 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/tracing_sampler.h"
+#include "google/cloud/log.h"
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+
+TracingSampler::TracingSampler(
+    TracingSampling sampling,
+    std::function<TokenBucket::Clock::time_point()> clock)
+    : sampling_(sampling), counter_(0), suppressed_(0), suppressed_total_(0) {
+  auto const rate = sampling_.max_completed_traces_per_second;
+  if (rate != 0) {
+    completed_limiter_.reset(new TokenBucket(rate, rate, std::move(clock)));
+  }
+}
+
+bool TracingSampler::Sample() {
+  auto const period = sampling_.sample_period;
+  if (period <= 1) {
+    // Avoid contention on the counter for the common "all or nothing" cases.
+    return period == 1;
+  }
+  return counter_.fetch_add(1, std::memory_order_relaxed) % period == 0;
+}
+
+bool TracingSampler::TraceCompleted(bool failed,
+                                    std::chrono::microseconds elapsed) {
+  auto const threshold = sampling_.latency_threshold;
+  if (!(failed && sampling_.trace_failures) &&
+      !(threshold.count() > 0 && elapsed >= threshold)) {
+    return false;
+  }
+  if (!completed_limiter_) {
+    return true;
+  }
+  if (!completed_limiter_->TryConsume(1)) {
+    ++suppressed_;
+    ++suppressed_total_;
+    return false;
+  }
+  auto const suppressed = suppressed_.exchange(0);
+  if (suppressed != 0) {
+    GCP_LOG(INFO) << "Dropped " << suppressed
+                  << " traces of failed or slow operations, the limit is "
+                  << sampling_.max_completed_traces_per_second
+                  << " per second";
+  }
+  return true;
+}
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,91 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TRACING_SAMPLER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TRACING_SAMPLER_H_
+
+#include "google/cloud/storage/internal/token_bucket.h"
+#include "google/cloud/storage/tracing_sampling.h"
+#include "google/cloud/storage/version.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+/**
+ * Implements the `TracingSampling` policy.
+ *
+ * Callers use `Sample()` before starting an operation, to decide if the
+ * operation is traced in full. Operations that are not sampled may still be
+ * traced once they complete, if `TraceCompleted()` returns true.
+ *
+ * This class is thread-safe, many threads can share the same sampler.
+ */
+class TracingSampler {
+ public:
+  /**
+   * Creates a sampler implementing @p sampling.
+   *
+   * @param clock returns the current time, the tests use this to simulate the
+   *     passage of time.
+   */
+  explicit TracingSampler(
+      TracingSampling sampling,
+      std::function<TokenBucket::Clock::time_point()> clock =
+          &TokenBucket::Clock::now);
+
+  TracingSampling const& sampling() const { return sampling_; }
+
+  /// Returns true if the next operation should be traced in full.
+  bool Sample();
+
+  /// Returns true if `TraceCompleted()` can return true for any operation.
+  bool traces_completed() const {
+    return sampling_.trace_failures || sampling_.latency_threshold.count() > 0;
+  }
+
+  /**
+   * Returns true if an operation that was not sampled should be traced.
+   *
+   * The result is false for operations that fail or are slow if tracing them
+   * would exceed `max_completed_traces_per_second`.
+   */
+  bool TraceCompleted(bool failed, std::chrono::microseconds elapsed);
+
+  /// The number of traces dropped by `max_completed_traces_per_second`.
+  std::uint64_t suppressed_count() const { return suppressed_total_.load(); }
+
+ private:
+  TracingSampling const sampling_;
+  std::atomic<std::uint64_t> counter_;
+  // Null if the completed traces are not rate limited.
+  std::unique_ptr<TokenBucket> completed_limiter_;
+  // Reported, and reset, with the next trace that is not dropped.
+  std::atomic<std::uint64_t> suppressed_;
+  std::atomic<std::uint64_t> suppressed_total_;
+};
+
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_INTERNAL_TRACING_SAMPLER_H_
@@ -0,0 +1,115 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/internal/tracing_sampler.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+namespace {
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+TEST(TracingSamplerTest, DefaultSamplesAll) {
+  TracingSampler sampler{TracingSampling()};
+  for (int i = 0; i != 10; ++i) {
+    EXPECT_TRUE(sampler.Sample());
+  }
+  EXPECT_TRUE(sampler.traces_completed());
+  EXPECT_TRUE(sampler.TraceCompleted(true, microseconds(0)));
+  EXPECT_FALSE(sampler.TraceCompleted(false, milliseconds(10000)));
+}
+
+TEST(TracingSamplerTest, SamplePeriod) {
+  TracingSampling sampling;
+  sampling.sample_period = 4;
+  TracingSampler sampler(sampling);
+  int count = 0;
+  for (int i = 0; i != 100; ++i) {
+    count += sampler.Sample() ? 1 : 0;
+  }
+  EXPECT_EQ(25, count);
+
+  sampling.sample_period = 0;
+  TracingSampler none(sampling);
+  for (int i = 0; i != 10; ++i) {
+    EXPECT_FALSE(none.Sample());
+  }
+}
+
+TEST(TracingSamplerTest, TraceCompleted) {
+  TracingSampling sampling;
+  sampling.sample_period = 0;
+  sampling.trace_failures = false;
+  EXPECT_FALSE(TracingSampler(sampling).traces_completed());
+  EXPECT_FALSE(TracingSampler(sampling).TraceCompleted(true, microseconds(0)));
+
+  sampling.latency_threshold = milliseconds(100);
+  TracingSampler slow(sampling);
+  EXPECT_TRUE(slow.traces_completed());
+  EXPECT_FALSE(slow.TraceCompleted(true, milliseconds(99)));
+  EXPECT_TRUE(slow.TraceCompleted(false, milliseconds(100)));
+
+  sampling.trace_failures = true;
+  TracingSampler failures(sampling);
+  EXPECT_TRUE(failures.TraceCompleted(true, milliseconds(1)));
+  EXPECT_FALSE(failures.TraceCompleted(false, milliseconds(1)));
+}
+
+TEST(TracingSamplerTest, CompletedTracesAreRateLimited) {
+  TracingSampling sampling;
+  sampling.sample_period = 0;
+  sampling.latency_threshold = milliseconds(100);
+  sampling.max_completed_traces_per_second = 5;
+  auto now = TokenBucket::Clock::now();
+  TracingSampler sampler(sampling, [&now] { return now; });
+
+  int count = 0;
+  for (int i = 0; i != 100; ++i) {
+    count += sampler.TraceCompleted(true, microseconds(0)) ? 1 : 0;
+  }
+  EXPECT_EQ(5, count);
+  EXPECT_EQ(95U, sampler.suppressed_count());
+  // Operations that are neither slow nor failed do not use the budget.
+  EXPECT_FALSE(sampler.TraceCompleted(false, milliseconds(1)));
+  EXPECT_EQ(95U, sampler.suppressed_count());
+
+  now += std::chrono::seconds(1);
+  count = 0;
+  for (int i = 0; i != 100; ++i) {
+    count += sampler.TraceCompleted(false, milliseconds(200)) ? 1 : 0;
+  }
+  EXPECT_EQ(5, count);
+}
+
+TEST(TracingSamplerTest, CompletedTracesUnlimited) {
+  TracingSampling sampling;
+  sampling.max_completed_traces_per_second = 0;
+  TracingSampler sampler(sampling);
+  for (int i = 0; i != 100; ++i) {
+    EXPECT_TRUE(sampler.TraceCompleted(true, microseconds(0)));
+  }
+  EXPECT_EQ(0U, sampler.suppressed_count());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -32,6 +32,12 @@ using ListObjectsReader =
 
 using ListObjectsIterator = ListObjectsReader::iterator;
 
+using ListObjectSummariesReader =
+    internal::PaginationRange<ObjectSummary, internal::ListObjectsRequest,
+                              internal::ListObjectSummariesResponse>;
+
+using ListObjectSummariesIterator = ListObjectSummariesReader::iterator;
+
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
 }  // namespace cloud
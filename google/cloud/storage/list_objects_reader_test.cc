@@ -25,6 +25,7 @@ namespace storage {
 inline namespace STORAGE_CLIENT_NS {
 namespace {
 
+using ::google::cloud::storage::internal::ListObjectSummariesResponse;
 using ::google::cloud::storage::internal::ListObjectsRequest;
 using ::google::cloud::storage::internal::ListObjectsResponse;
 using ::google::cloud::storage::testing::MockClient;
@@ -207,6 +208,41 @@ TEST(ListObjectsReaderTest, IteratorCompare) {
   EXPECT_NE(a1, a2);
 }
 
+TEST(ListObjectsReaderTest, Summaries) {
+  auto create_response = [](std::string const& payload) {
+    return [payload](ListObjectsRequest const&) {
+      return ListObjectSummariesResponse::FromHttpResponse(payload);
+    };
+  };
+
+  auto mock = std::make_shared<MockClient>();
+  EXPECT_CALL(*mock, ListObjectSummaries(_))
+      .WillOnce(Invoke(create_response(R"""({
+          "nextPageToken": "page-1",
+          "items": [{"name": "object-0", "generation": "1", "size": "10"},
+                    {"name": "object-1", "generation": "2", "size": "20"}]
+      })""")))
+      .WillOnce(Invoke(create_response(R"""({
+          "items": [{"name": "object-2", "generation": "3", "size": "30"}]
+      })""")));
+
+  ListObjectSummariesReader reader(
+      ListObjectsRequest("foo-bar-baz").set_multiple_options(Prefix("dir/")),
+      [mock](ListObjectsRequest const& r) {
+        return mock->ListObjectSummaries(r);
+      });
+  std::vector<std::string> names;
+  std::uint64_t total_size = 0;
+  for (auto&& object : reader) {
+    ASSERT_STATUS_OK(object);
+    names.emplace_back(object->name());
+    total_size += object->size();
+  }
+  EXPECT_THAT(names,
+              ::testing::ElementsAre("object-0", "object-1", "object-2"));
+  EXPECT_EQ(60U, total_size);
+}
+
 }  // namespace
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
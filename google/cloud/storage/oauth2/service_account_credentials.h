@@ -15,6 +15,7 @@
 #ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_OAUTH2_SERVICE_ACCOUNT_CREDENTIALS_H_
 #define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_OAUTH2_SERVICE_ACCOUNT_CREDENTIALS_H_
 
+#include "google/cloud/internal/make_unique.h"
 #include "google/cloud/optional.h"
 #include "google/cloud/storage/internal/curl_request_builder.h"
 #include "google/cloud/storage/internal/nljson.h"
@@ -24,6 +25,7 @@
 #include "google/cloud/storage/oauth2/credentials.h"
 #include "google/cloud/storage/oauth2/refreshing_credentials_wrapper.h"
 #include "google/cloud/storage/version.h"
+#include <atomic>
 #include <condition_variable>
 #include <ctime>
 #include <iostream>
@@ -138,8 +140,7 @@ class ServiceAccountCredentials : public Credentials {
                     "The current_credentials cannot sign blobs for " +
                         signing_account.value());
     }
-    return internal::SignStringWithPem(blob, info_.private_key,
-                                       JwtSigningAlgorithms::RS256);
+    return Signer().Sign(blob);
   }
 
   std::string AccountEmail() const override { return info_.client_email; }
@@ -196,18 +197,18 @@ class ServiceAccountCredentials : public Credentials {
   }
 
   /**
-   * Given a key and a JSON header and payload, creates a JWT assertion string.
+   * Given a JSON header and payload, creates a JWT assertion string signed
+   * with the service account key.
    *
    * @see https://tools.ietf.org/html/rfc7519
    */
-  std::string MakeJWTAssertion(storage::internal::nl::json const& header,
-                               storage::internal::nl::json const& payload,
-                               std::string const& pem_contents) const {
+  std::string MakeJWTAssertion(
+      storage::internal::nl::json const& header,
+      storage::internal::nl::json const& payload) const {
     std::string encoded_header = internal::UrlsafeBase64Encode(header.dump());
     std::string encoded_payload = internal::UrlsafeBase64Encode(payload.dump());
     std::string encoded_signature = internal::UrlsafeBase64Encode(
-        internal::SignStringWithPem(encoded_header + '.' + encoded_payload,
-                                    pem_contents, JwtSigningAlgorithms::RS256));
+        Signer().Sign(encoded_header + '.' + encoded_payload));
     return encoded_header + '.' + encoded_payload + '.' + encoded_signature;
   }
 
@@ -216,7 +217,7 @@ class ServiceAccountCredentials : public Credentials {
     std::string payload = grant_type_;
     payload += "&assertion=";
     payload += MakeJWTAssertion(assertion_components.first,
-                                assertion_components.second, info_.private_key);
+                                assertion_components.second);
 
     auto response = request_.MakeRequest(payload);
     if (!response) {
@@ -250,10 +251,29 @@ class ServiceAccountCredentials : public Credentials {
                                                         new_expiration};
   }
 
+  /// Returns the signer for the private key, parsing the key only once.
+  internal::PemSigner const& Signer() const {
+    // Once the signer exists only the atomic load is needed. If parsing the
+    // key throws, `signer_` remains unset and the next call tries again.
+    if (auto const* signer = signer_ptr_.load(std::memory_order_acquire)) {
+      return *signer;
+    }
+    std::lock_guard<std::mutex> lk(signer_mu_);
+    if (!signer_) {
+      signer_ = google::cloud::internal::make_unique<internal::PemSigner>(
+          info_.private_key, JwtSigningAlgorithms::RS256);
+      signer_ptr_.store(signer_.get(), std::memory_order_release);
+    }
+    return *signer_;
+  }
+
   typename HttpRequestBuilderType::RequestType request_;
   std::string grant_type_;
   ServiceAccountCredentialsInfo info_;
   mutable std::mutex mu_;
+  mutable std::mutex signer_mu_;
+  mutable std::unique_ptr<internal::PemSigner const> signer_;
+  mutable std::atomic<internal::PemSigner const*> signer_ptr_{nullptr};
   RefreshingCredentialsWrapper refreshing_creds_;
   ClockType clock_;
 };
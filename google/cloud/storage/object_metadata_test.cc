@@ -325,6 +325,56 @@ TEST(ObjectMetadataTest, JsonForRewrite) {
       << "diff=" << internal::nl::json::diff(expected, actual);
 }
 
+/// @test Verify that WriteObjectMetadataFieldsFor*() match the nl::json
+/// versions.
+TEST(ObjectMetadataTest, WriteFieldsMatchesJson) {
+  auto const meta = CreateObjectMetadataForTest();
+
+  std::string compose;
+  internal::JsonWriter compose_writer(compose);
+  compose_writer.StartObject();
+  EXPECT_TRUE(internal::WriteObjectMetadataFieldsForCompose(compose_writer,
+                                                            meta));
+  compose_writer.EndObject();
+  EXPECT_EQ(ObjectMetadataJsonForCompose(meta).dump(), compose);
+
+  std::string insert;
+  internal::JsonWriter insert_writer(insert);
+  insert_writer.StartObject();
+  EXPECT_TRUE(
+      internal::WriteObjectMetadataFieldsForInsert(insert_writer, meta));
+  insert_writer.EndObject();
+  EXPECT_EQ(ObjectMetadataJsonForInsert(meta).dump(), insert);
+}
+
+/// @test Verify that WriteObjectMetadataFieldsForInsert() uses the overrides.
+TEST(ObjectMetadataTest, WriteFieldsForInsertOverrides) {
+  std::string empty;
+  internal::JsonWriter empty_writer(empty);
+  EXPECT_FALSE(internal::WriteObjectMetadataFieldsForInsert(empty_writer,
+                                                            ObjectMetadata()));
+  EXPECT_EQ("", empty);
+
+  internal::ObjectMetadataOverrides overrides;
+  overrides.content_encoding = "gzip";
+  overrides.content_type = "text/plain";
+  overrides.crc32c = "new-crc32c";
+  overrides.md5_hash = "new-md5";
+  std::string actual;
+  internal::JsonWriter writer(actual);
+  writer.StartObject();
+  EXPECT_TRUE(internal::WriteObjectMetadataFieldsForInsert(
+      writer, CreateObjectMetadataForTest(), overrides));
+  writer.EndObject();
+
+  auto expected = ObjectMetadataJsonForInsert(CreateObjectMetadataForTest());
+  expected["contentEncoding"] = "gzip";
+  expected["contentType"] = "text/plain";
+  expected["crc32c"] = "new-crc32c";
+  expected["md5Hash"] = "new-md5";
+  EXPECT_EQ(expected.dump(), actual);
+}
+
 /// @test Verify that ObjectMetadataJsonForUpdate works as expected.
 TEST(ObjectMetadataTest, JsonForUpdateEmpty) {
   internal::nl::json actual = ObjectMetadataJsonForUpdate(ObjectMetadata());
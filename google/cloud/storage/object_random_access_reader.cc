@@ -0,0 +1,259 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/object_random_access_reader.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+std::size_t const kDefaultBlockSize = 256 * 1024;
+std::size_t const kDefaultCacheSize = 32 * 1024 * 1024;
+std::size_t const kDefaultMaxCoalesceGap = 1024 * 1024;
+std::size_t const kDefaultPrefetchBlocks = 4;
+}  // namespace
+
+RandomAccessReaderOptions::RandomAccessReaderOptions()
+    : block_size_(kDefaultBlockSize),
+      cache_size_(kDefaultCacheSize),
+      max_coalesce_gap_(kDefaultMaxCoalesceGap),
+      prefetch_blocks_(kDefaultPrefetchBlocks) {}
+
+RandomAccessReaderOptions& RandomAccessReaderOptions::set_block_size(
+    std::size_t v) {
+  // A zero block size would make every computation below meaningless.
+  block_size_ = (std::max)(v, std::size_t(1));
+  return *this;
+}
+
+ObjectRandomAccessReader::ObjectRandomAccessReader(
+    std::shared_ptr<internal::RawClient> client,
+    internal::ReadObjectRangeRequest request, RandomAccessReaderOptions options)
+    : client_(std::move(client)),
+      request_(std::move(request)),
+      options_(std::move(options)),
+      cache_(options_.block_cache().has_value()
+                 ? *options_.block_cache()
+                 : RandomAccessReaderCache(options_.cache_size())),
+      initialized_(false),
+      object_size_(0),
+      generation_(0),
+      next_sequential_offset_(-1),
+      download_count_(0) {}
+
+StatusOr<std::string> ObjectRandomAccessReader::ReadAt(std::int64_t offset,
+                                                       std::size_t n) {
+  auto result = ReadRanges(
+      {ReadRangeData{offset, offset + static_cast<std::int64_t>(n)}});
+  if (!result) {
+    return std::move(result).status();
+  }
+  return std::move(result->front());
+}
+
+StatusOr<std::vector<std::string>> ObjectRandomAccessReader::ReadRanges(
+    std::vector<ReadRangeData> const& ranges) {
+  Status status = Initialize();
+  if (!status.ok()) {
+    return status;
+  }
+  auto const block_size = static_cast<std::int64_t>(options_.block_size());
+  auto const last_object_block = (object_size_ - 1) / block_size;
+
+  std::set<std::int64_t> needed;
+  for (auto const& r : ranges) {
+    if (r.begin < 0 || r.end < r.begin) {
+      std::ostringstream os;
+      os << __func__ << ": invalid range [" << r.begin << "," << r.end << ")";
+      return Status(StatusCode::kInvalidArgument, std::move(os).str());
+    }
+    auto end = (std::min)(r.end, object_size_);
+    for (auto b = r.begin / block_size; b * block_size < end; ++b) {
+      needed.insert(b);
+    }
+  }
+  if (needed.empty()) {
+    return std::vector<std::string>(ranges.size());
+  }
+
+  // Sequential reads are likely to continue, fetch the next few blocks as part
+  // of the same download.
+  if (ranges.front().begin == next_sequential_offset_) {
+    auto const last_needed = *needed.rbegin();
+    auto const prefetch_end = (std::min)(
+        last_needed + static_cast<std::int64_t>(options_.prefetch_blocks()),
+        last_object_block);
+    for (auto b = last_needed + 1; b <= prefetch_end; ++b) {
+      needed.insert(b);
+    }
+  }
+  next_sequential_offset_ = (std::min)(ranges.back().end, object_size_);
+
+  // Keep references to all the blocks used in this call, they may be evicted
+  // from the cache before we copy the data out.
+  BlockMap blocks;
+  std::vector<std::int64_t> missing;
+  for (auto b : needed) {
+    auto block = cache_.impl_->Lookup(MakeKey(b));
+    if (block) {
+      blocks.emplace(b, std::move(block));
+      continue;
+    }
+    missing.push_back(b);
+  }
+
+  auto const max_gap_blocks =
+      static_cast<std::int64_t>(options_.max_coalesce_gap()) / block_size;
+  for (std::size_t i = 0; i != missing.size();) {
+    auto j = i;
+    while (j + 1 != missing.size() &&
+           missing[j + 1] - missing[j] - 1 <= max_gap_blocks) {
+      ++j;
+    }
+    status = Download(missing[i], missing[j], blocks);
+    if (!status.ok()) {
+      return status;
+    }
+    i = j + 1;
+  }
+
+  std::vector<std::string> result;
+  result.reserve(ranges.size());
+  for (auto const& r : ranges) {
+    std::string data;
+    auto const end = (std::min)(r.end, object_size_);
+    for (auto offset = r.begin; offset < end;) {
+      auto const& block = *blocks[offset / block_size];
+      auto const block_offset = offset % block_size;
+      auto const count = (std::min)(
+          end - offset,
+          static_cast<std::int64_t>(block.size()) - block_offset);
+      data.append(block, static_cast<std::size_t>(block_offset),
+                  static_cast<std::size_t>(count));
+      offset += count;
+    }
+    result.push_back(std::move(data));
+  }
+  return result;
+}
+
+StatusOr<std::int64_t> ObjectRandomAccessReader::size() {
+  Status status = Initialize();
+  if (!status.ok()) {
+    return status;
+  }
+  return object_size_;
+}
+
+StatusOr<std::int64_t> ObjectRandomAccessReader::generation() {
+  Status status = Initialize();
+  if (!status.ok()) {
+    return status;
+  }
+  return generation_;
+}
+
+Status ObjectRandomAccessReader::Initialize() {
+  if (initialized_) {
+    return Status();
+  }
+  internal::GetObjectMetadataRequest request(request_.bucket_name(),
+                                             request_.object_name());
+  request.set_multiple_options(
+      request_.GetOption<EncryptionKey>(), request_.GetOption<Generation>(),
+      request_.GetOption<IfGenerationMatch>(),
+      request_.GetOption<IfGenerationNotMatch>(),
+      request_.GetOption<IfMetagenerationMatch>(),
+      request_.GetOption<IfMetagenerationNotMatch>(),
+      request_.GetOption<UserProject>());
+  auto metadata = client_->GetObjectMetadata(request);
+  if (!metadata) {
+    return std::move(metadata).status();
+  }
+  object_size_ = static_cast<std::int64_t>(metadata->size());
+  generation_ = metadata->generation();
+  initialized_ = true;
+  return Status();
+}
+
+internal::ObjectBlockKey ObjectRandomAccessReader::MakeKey(
+    std::int64_t block_index) const {
+  return internal::ObjectBlockKey{request_.bucket_name(),
+                                  request_.object_name(), generation_,
+                                  block_index};
+}
+
+Status ObjectRandomAccessReader::Download(std::int64_t first_block,
+                                          std::int64_t last_block,
+                                          BlockMap& blocks) {
+  auto const block_size = static_cast<std::int64_t>(options_.block_size());
+  auto const begin = first_block * block_size;
+  auto const end = (std::min)((last_block + 1) * block_size, object_size_);
+
+  internal::ReadObjectRangeRequest request(request_.bucket_name(),
+                                           request_.object_name());
+  request.set_multiple_options(
+      Generation(generation_), ReadRange(begin, end),
+      request_.GetOption<EncryptionKey>(), request_.GetOption<UserProject>());
+  ++download_count_;
+  auto source = client_->ReadObject(request);
+  if (!source) {
+    return std::move(source).status();
+  }
+
+  std::string buffer(static_cast<std::size_t>(end - begin), '\0');
+  std::size_t offset = 0;
+  while (offset < buffer.size()) {
+    auto read = (*source)->Read(&buffer[offset], buffer.size() - offset);
+    if (!read) {
+      return std::move(read).status();
+    }
+    if (read->response.status_code >= 300) {
+      return AsStatus(read->response);
+    }
+    offset += read->bytes_received;
+    if (read->response.status_code != 100) {
+      break;
+    }
+  }
+  if ((*source)->IsOpen()) {
+    (*source)->Close();
+  }
+  if (offset != buffer.size()) {
+    std::ostringstream os;
+    os << __func__ << ": short read for " << request << ", expected "
+       << buffer.size() << " bytes, got " << offset;
+    return Status(StatusCode::kDataLoss, std::move(os).str());
+  }
+
+  for (auto b = first_block; b <= last_block; ++b) {
+    auto const block_begin =
+        static_cast<std::size_t>((b - first_block) * block_size);
+    auto block = std::make_shared<std::string const>(
+        buffer.substr(block_begin, static_cast<std::size_t>(block_size)));
+    cache_.impl_->Insert(MakeKey(b), block);
+    blocks[b] = std::move(block);
+  }
+  return Status();
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,195 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_OBJECT_RANDOM_ACCESS_READER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_OBJECT_RANDOM_ACCESS_READER_H_
+
+#include "google/cloud/optional.h"
+#include "google/cloud/status_or.h"
+#include "google/cloud/storage/download_options.h"
+#include "google/cloud/storage/internal/object_block_cache.h"
+#include "google/cloud/storage/internal/raw_client.h"
+#include "google/cloud/storage/version.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/**
+ * A block cache that can be shared by multiple `ObjectRandomAccessReader`s.
+ *
+ * The cache is bounded by the total size of the cached blocks, and discards the
+ * least recently used blocks when full. Blocks are keyed by bucket, object and
+ * generation, so a cache can be safely shared by readers for different
+ * objects. This class is a handle: copies refer to the same cache, and they can
+ * be used from multiple threads.
+ */
+class RandomAccessReaderCache {
+ public:
+  explicit RandomAccessReaderCache(std::size_t max_size_bytes)
+      : impl_(std::make_shared<internal::ObjectBlockCache>(max_size_bytes)) {}
+
+  std::size_t max_size_bytes() const { return impl_->max_size_bytes(); }
+  std::size_t size_bytes() const { return impl_->size_bytes(); }
+  std::size_t block_count() const { return impl_->block_count(); }
+  std::uint64_t hit_count() const { return impl_->hit_count(); }
+  std::uint64_t miss_count() const { return impl_->miss_count(); }
+
+ private:
+  friend class ObjectRandomAccessReader;
+  std::shared_ptr<internal::ObjectBlockCache> impl_;
+};
+
+/**
+ * Configure the block cache used by `ObjectRandomAccessReader`.
+ *
+ * The reader downloads data in fixed size blocks. Reads that need several
+ * missing blocks are coalesced into a single download, and missing blocks
+ * separated by at most `max_coalesce_gap()` bytes of already cached data are
+ * downloaded together too. When the application reads sequentially the reader
+ * fetches up to `prefetch_blocks()` additional blocks in the same download.
+ */
+class RandomAccessReaderOptions {
+ public:
+  RandomAccessReaderOptions();
+
+  std::size_t block_size() const { return block_size_; }
+  RandomAccessReaderOptions& set_block_size(std::size_t v);
+
+  std::size_t cache_size() const { return cache_size_; }
+  RandomAccessReaderOptions& set_cache_size(std::size_t v) {
+    cache_size_ = v;
+    return *this;
+  }
+
+  std::size_t max_coalesce_gap() const { return max_coalesce_gap_; }
+  RandomAccessReaderOptions& set_max_coalesce_gap(std::size_t v) {
+    max_coalesce_gap_ = v;
+    return *this;
+  }
+
+  std::size_t prefetch_blocks() const { return prefetch_blocks_; }
+  RandomAccessReaderOptions& set_prefetch_blocks(std::size_t v) {
+    prefetch_blocks_ = v;
+    return *this;
+  }
+
+  /**
+   * Share a block cache between multiple readers.
+   *
+   * By default each reader creates its own cache of `cache_size()` bytes.
+   * Applications reading the same objects from multiple readers, or many
+   * objects from a bounded memory budget, can share a single cache. The cache
+   * is keyed by bucket, object and generation, so sharing it is always safe.
+   */
+  google::cloud::optional<RandomAccessReaderCache> const& block_cache() const {
+    return block_cache_;
+  }
+  RandomAccessReaderOptions& set_block_cache(RandomAccessReaderCache v) {
+    block_cache_ = std::move(v);
+    return *this;
+  }
+
+ private:
+  std::size_t block_size_;
+  std::size_t cache_size_;
+  std::size_t max_coalesce_gap_;
+  std::size_t prefetch_blocks_;
+  google::cloud::optional<RandomAccessReaderCache> block_cache_;
+};
+
+/**
+ * Read arbitrary ranges of a GCS object through a block cache.
+ *
+ * Applications that read many small ranges from the same object (for example,
+ * readers for columnar file formats that read a footer and then several column
+ * chunks) would issue a separate download for each range with
+ * `Client::ReadObject()`. This class serves those reads from a bounded LRU
+ * cache of fixed size blocks, coalescing nearby misses into a single download.
+ *
+ * The first read fetches the object metadata to discover its size and
+ * generation (unless the `Generation` option was provided). All downloads are
+ * pinned to that generation, if the object is replaced the reader returns an
+ * error instead of mixing data from different generations.
+ *
+ * @note This class is not thread-safe, applications should use a different
+ *   reader on each thread. The `RandomAccessReaderCache` is thread-safe and
+ *   can be shared via `RandomAccessReaderOptions::set_block_cache()`.
+ */
+class ObjectRandomAccessReader {
+ public:
+  ObjectRandomAccessReader(std::shared_ptr<internal::RawClient> client,
+                           internal::ReadObjectRangeRequest request,
+                           RandomAccessReaderOptions options);
+
+  /**
+   * Read up to @p n bytes starting at @p offset.
+   *
+   * @return the data, which is shorter than @p n bytes only if the range
+   *   extends past the end of the object.
+   */
+  StatusOr<std::string> ReadAt(std::int64_t offset, std::size_t n);
+
+  /**
+   * Read several ranges, coalescing the downloads for any missing blocks.
+   *
+   * @param ranges the ranges to read, each range is right-open, as in
+   *   `ReadRange`.
+   * @return the data for each range, in the same order as @p ranges.
+   */
+  StatusOr<std::vector<std::string>> ReadRanges(
+      std::vector<ReadRangeData> const& ranges);
+
+  /// The size of the object, fetching its metadata if needed.
+  StatusOr<std::int64_t> size();
+
+  /// The generation used for all the downloads.
+  StatusOr<std::int64_t> generation();
+
+  /// The number of downloads started by this reader.
+  std::uint64_t download_count() const { return download_count_; }
+
+  /// The block cache used by this reader.
+  RandomAccessReaderCache const& block_cache() const { return cache_; }
+
+ private:
+  using BlockMap = std::map<std::int64_t, internal::ObjectBlockCache::Block>;
+
+  Status Initialize();
+  internal::ObjectBlockKey MakeKey(std::int64_t block_index) const;
+  Status Download(std::int64_t first_block, std::int64_t last_block,
+                  BlockMap& blocks);
+
+  std::shared_ptr<internal::RawClient> client_;
+  internal::ReadObjectRangeRequest request_;
+  RandomAccessReaderOptions options_;
+  RandomAccessReaderCache cache_;
+  bool initialized_;
+  std::int64_t object_size_;
+  std::int64_t generation_;
+  std::int64_t next_sequential_offset_;
+  std::uint64_t download_count_;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_OBJECT_RANDOM_ACCESS_READER_H_
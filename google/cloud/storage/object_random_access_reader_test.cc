@@ -0,0 +1,330 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/object_random_access_reader.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+std::string MakeContents(std::size_t size) {
+  std::string contents;
+  for (std::size_t i = 0; i != size; ++i) {
+    contents.push_back(static_cast<char>('a' + i % 26));
+  }
+  return contents;
+}
+
+/// Create a read source that returns @p data in small chunks.
+std::unique_ptr<internal::ObjectReadSource> MakeSource(std::string data) {
+  auto source = google::cloud::internal::make_unique<
+      ::testing::NiceMock<testing::MockObjectReadSource>>();
+  auto remaining = std::make_shared<std::string>(std::move(data));
+  ON_CALL(*source, Read(_, _))
+      .WillByDefault(Invoke([remaining](char* buf, std::size_t n) {
+        auto count = (std::min)(n, (std::min)(std::size_t(64),
+                                              remaining->size()));
+        remaining->copy(buf, count);
+        remaining->erase(0, count);
+        int code = remaining->empty() ? 200 : 100;
+        return internal::ReadSourceResult{count,
+                                          internal::HttpResponse{code, "", {}}};
+      }));
+  ON_CALL(*source, IsOpen()).WillByDefault(Return(false));
+  return std::unique_ptr<internal::ObjectReadSource>(std::move(source));
+}
+
+class ObjectRandomAccessReaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mock = std::make_shared<testing::MockClient>();
+    EXPECT_CALL(*mock, client_options())
+        .WillRepeatedly(ReturnRef(client_options));
+    contents = MakeContents(1000);
+  }
+
+  void ExpectMetadata(std::int64_t generation) {
+    EXPECT_CALL(*mock, GetObjectMetadata(_))
+        .WillOnce(Invoke(
+            [generation](internal::GetObjectMetadataRequest const& r) {
+              EXPECT_EQ("test-bucket", r.bucket_name());
+              EXPECT_EQ("test-object", r.object_name());
+              std::string text = R"""({
+                  "bucket": "test-bucket",
+                  "name": "test-object",
+                  "generation": ")""" +
+                                 std::to_string(generation) + R"""(",
+                  "size": "1000"
+              })""";
+              return internal::ObjectMetadataParser::FromString(text);
+            }));
+  }
+
+  /// Serve `ReadObject()` calls and record the requested ranges.
+  void ExpectDownloads(std::int64_t generation) {
+    using ReadResult = StatusOr<std::unique_ptr<internal::ObjectReadSource>>;
+    EXPECT_CALL(*mock, ReadObject(_))
+        .WillRepeatedly(Invoke(
+            [this, generation](internal::ReadObjectRangeRequest const& r) {
+              EXPECT_EQ(generation, r.GetOption<Generation>().value());
+              auto range = r.GetOption<ReadRange>().value();
+              downloads.push_back(range);
+              return ReadResult(MakeSource(contents.substr(
+                  static_cast<std::size_t>(range.begin),
+                  static_cast<std::size_t>(range.end - range.begin))));
+            }));
+  }
+
+  ObjectRandomAccessReader MakeReader(RandomAccessReaderOptions options) {
+    return Client(std::shared_ptr<internal::RawClient>(mock))
+        .CreateRandomAccessReader("test-bucket", "test-object",
+                                  std::move(options));
+  }
+
+  static RandomAccessReaderOptions TestOptions() {
+    return RandomAccessReaderOptions()
+        .set_block_size(100)
+        .set_cache_size(10 * 100)
+        .set_max_coalesce_gap(0)
+        .set_prefetch_blocks(0);
+  }
+
+  std::shared_ptr<testing::MockClient> mock;
+  ClientOptions client_options =
+      ClientOptions(oauth2::CreateAnonymousCredentials());
+  std::string contents;
+  std::vector<ReadRangeData> downloads;
+};
+
+TEST_F(ObjectRandomAccessReaderTest, ReadAtUsesCache) {
+  ExpectMetadata(1234);
+  ExpectDownloads(1234);
+
+  auto reader = MakeReader(TestOptions());
+  auto actual = reader.ReadAt(150, 20);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(contents.substr(150, 20), *actual);
+  ASSERT_EQ(1U, downloads.size());
+  EXPECT_EQ(100, downloads[0].begin);
+  EXPECT_EQ(200, downloads[0].end);
+
+  actual = reader.ReadAt(160, 30);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(contents.substr(160, 30), *actual);
+  EXPECT_EQ(1U, reader.download_count());
+
+  auto generation = reader.generation();
+  ASSERT_STATUS_OK(generation);
+  EXPECT_EQ(1234, *generation);
+  auto size = reader.size();
+  ASSERT_STATUS_OK(size);
+  EXPECT_EQ(1000, *size);
+}
+
+TEST_F(ObjectRandomAccessReaderTest, ReadPastEnd) {
+  ExpectMetadata(1234);
+  ExpectDownloads(1234);
+
+  auto reader = MakeReader(TestOptions());
+  auto actual = reader.ReadAt(950, 100);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(contents.substr(950), *actual);
+
+  actual = reader.ReadAt(2000, 100);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ("", *actual);
+  EXPECT_EQ(1U, reader.download_count());
+}
+
+TEST_F(ObjectRandomAccessReaderTest, CoalesceAdjacentBlocks) {
+  ExpectMetadata(1234);
+  ExpectDownloads(1234);
+
+  auto reader = MakeReader(TestOptions());
+  auto actual = reader.ReadRanges({{50, 150}, {150, 320}});
+  ASSERT_STATUS_OK(actual);
+  ASSERT_EQ(2U, actual->size());
+  EXPECT_EQ(contents.substr(50, 100), (*actual)[0]);
+  EXPECT_EQ(contents.substr(150, 170), (*actual)[1]);
+  ASSERT_EQ(1U, downloads.size());
+  EXPECT_EQ(0, downloads[0].begin);
+  EXPECT_EQ(400, downloads[0].end);
+}
+
+TEST_F(ObjectRandomAccessReaderTest, CoalesceNearbyBlocks) {
+  ExpectMetadata(1234);
+  ExpectDownloads(1234);
+
+  auto reader = MakeReader(TestOptions().set_max_coalesce_gap(200));
+  auto actual = reader.ReadRanges({{0, 10}, {350, 360}, {900, 910}});
+  ASSERT_STATUS_OK(actual);
+  ASSERT_EQ(3U, actual->size());
+  EXPECT_EQ(contents.substr(0, 10), (*actual)[0]);
+  EXPECT_EQ(contents.substr(350, 10), (*actual)[1]);
+  EXPECT_EQ(contents.substr(900, 10), (*actual)[2]);
+  ASSERT_EQ(2U, downloads.size());
+  EXPECT_EQ(0, downloads[0].begin);
+  EXPECT_EQ(400, downloads[0].end);
+  EXPECT_EQ(900, downloads[1].begin);
+  EXPECT_EQ(1000, downloads[1].end);
+}
+
+TEST_F(ObjectRandomAccessReaderTest, PrefetchOnSequentialReads) {
+  ExpectMetadata(1234);
+  ExpectDownloads(1234);
+
+  auto reader = MakeReader(TestOptions().set_prefetch_blocks(2));
+  ASSERT_STATUS_OK(reader.ReadAt(0, 100));
+  ASSERT_STATUS_OK(reader.ReadAt(100, 100));
+  ASSERT_EQ(2U, downloads.size());
+  EXPECT_EQ(0, downloads[0].begin);
+  EXPECT_EQ(100, downloads[0].end);
+  EXPECT_EQ(100, downloads[1].begin);
+  EXPECT_EQ(400, downloads[1].end);
+
+  // This is not a sequential read, but the data was prefetched.
+  auto actual = reader.ReadAt(250, 150);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(contents.substr(250, 150), *actual);
+  EXPECT_EQ(2U, reader.download_count());
+}
+
+TEST_F(ObjectRandomAccessReaderTest, ReadLargerThanCache) {
+  ExpectMetadata(1234);
+  ExpectDownloads(1234);
+
+  auto reader = MakeReader(TestOptions().set_cache_size(200));
+  auto actual = reader.ReadAt(0, 1000);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(contents, *actual);
+  EXPECT_EQ(2U, reader.block_cache().block_count());
+}
+
+TEST_F(ObjectRandomAccessReaderTest, SharedCacheUsesGeneration) {
+  RandomAccessReaderCache cache(1000);
+  ExpectMetadata(1234);
+  ExpectDownloads(1234);
+  auto reader = MakeReader(TestOptions().set_block_cache(cache));
+  ASSERT_STATUS_OK(reader.ReadAt(0, 100));
+  EXPECT_EQ(1U, cache.block_count());
+
+  ::testing::Mock::VerifyAndClearExpectations(mock.get());
+  EXPECT_CALL(*mock, client_options())
+      .WillRepeatedly(ReturnRef(client_options));
+  ExpectMetadata(1234);
+  auto same = MakeReader(TestOptions().set_block_cache(cache));
+  auto actual = same.ReadAt(0, 100);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(0U, same.download_count());
+
+  ::testing::Mock::VerifyAndClearExpectations(mock.get());
+  EXPECT_CALL(*mock, client_options())
+      .WillRepeatedly(ReturnRef(client_options));
+  ExpectMetadata(2345);
+  ExpectDownloads(2345);
+  auto newer = MakeReader(TestOptions().set_block_cache(cache));
+  actual = newer.ReadAt(0, 100);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(1U, newer.download_count());
+  EXPECT_EQ(2U, cache.block_count());
+}
+
+TEST_F(ObjectRandomAccessReaderTest, MetadataError) {
+  EXPECT_CALL(*mock, GetObjectMetadata(_))
+      .WillOnce(Return(StatusOr<ObjectMetadata>(PermanentError())));
+  EXPECT_CALL(*mock, ReadObject(_)).Times(0);
+
+  auto reader = MakeReader(TestOptions());
+  auto actual = reader.ReadAt(0, 100);
+  EXPECT_FALSE(actual.ok());
+  EXPECT_EQ(PermanentError().code(), actual.status().code());
+}
+
+TEST_F(ObjectRandomAccessReaderTest, DownloadError) {
+  ExpectMetadata(1234);
+  EXPECT_CALL(*mock, ReadObject(_))
+      .WillOnce(Invoke([](internal::ReadObjectRangeRequest const&) {
+        return StatusOr<std::unique_ptr<internal::ObjectReadSource>>(
+            PermanentError());
+      }));
+
+  auto reader = MakeReader(TestOptions());
+  auto actual = reader.ReadAt(0, 100);
+  EXPECT_FALSE(actual.ok());
+  EXPECT_EQ(PermanentError().code(), actual.status().code());
+  EXPECT_EQ(0U, reader.block_cache().block_count());
+}
+
+/// @test Verify that the encryption key is used for metadata and block reads.
+TEST_F(ObjectRandomAccessReaderTest, ForwardsEncryptionKey) {
+  auto const key =
+      EncryptionDataFromBinaryKey("01234567890123456789012345678901");
+  EXPECT_CALL(*mock, GetObjectMetadata(_))
+      .WillOnce(Invoke([&key](internal::GetObjectMetadataRequest const& r) {
+        EXPECT_TRUE(r.HasOption<EncryptionKey>());
+        EXPECT_EQ(key.key, r.GetOption<EncryptionKey>().value().key);
+        return internal::ObjectMetadataParser::FromString(R"""({
+            "bucket": "test-bucket",
+            "name": "test-object",
+            "generation": "1234",
+            "size": "1000"
+        })""");
+      }));
+  using ReadResult = StatusOr<std::unique_ptr<internal::ObjectReadSource>>;
+  EXPECT_CALL(*mock, ReadObject(_))
+      .WillOnce(Invoke([this, &key](internal::ReadObjectRangeRequest const& r) {
+        EXPECT_TRUE(r.HasOption<EncryptionKey>());
+        EXPECT_EQ(key.key, r.GetOption<EncryptionKey>().value().key);
+        return ReadResult(MakeSource(contents.substr(0, 100)));
+      }));
+
+  auto reader =
+      Client(std::shared_ptr<internal::RawClient>(mock))
+          .CreateRandomAccessReader("test-bucket", "test-object",
+                                    TestOptions(), EncryptionKey(key));
+  auto actual = reader.ReadAt(0, 100);
+  ASSERT_STATUS_OK(actual);
+  EXPECT_EQ(contents.substr(0, 100), *actual);
+}
+
+TEST_F(ObjectRandomAccessReaderTest, InvalidRange) {
+  ExpectMetadata(1234);
+  EXPECT_CALL(*mock, ReadObject(_)).Times(0);
+
+  auto reader = MakeReader(TestOptions());
+  auto actual = reader.ReadRanges({{200, 100}});
+  EXPECT_FALSE(actual.ok());
+  EXPECT_EQ(StatusCode::kInvalidArgument, actual.status().code());
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -95,7 +95,8 @@ void ObjectWriteStream::CloseBuf() {
     setstate(std::ios_base::badbit);
     return;
   }
-  headers_ = std::move(response->headers);
+  headers_.clear();
+  headers_.insert(response->headers.begin(), response->headers.end());
   payload_ = std::move(response->payload);
   if (payload_.empty()) {
     // With the XML transport the response includes an empty payload, in that
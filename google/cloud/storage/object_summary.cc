@@ -0,0 +1,45 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/object_summary.h"
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+bool operator==(ObjectSummary const& lhs, ObjectSummary const& rhs) {
+  return lhs.name_size() == rhs.name_size() &&
+         std::memcmp(lhs.name_data(), rhs.name_data(), lhs.name_size()) == 0 &&
+         lhs.generation() == rhs.generation() && lhs.size() == rhs.size() &&
+         lhs.has_crc32c() == rhs.has_crc32c() && lhs.crc32c() == rhs.crc32c();
+}
+
+std::ostream& operator<<(std::ostream& os, ObjectSummary const& rhs) {
+  os << "ObjectSummary={name=";
+  os.write(rhs.name_data(), rhs.name_size());
+  os << ", generation=" << rhs.generation() << ", size=" << rhs.size();
+  if (rhs.has_crc32c()) {
+    os << ", crc32c=0x" << std::hex << std::setw(8) << std::setfill('0')
+       << rhs.crc32c() << std::dec << std::setfill(' ');
+  }
+  return os << "}";
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,88 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_OBJECT_SUMMARY_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_OBJECT_SUMMARY_H_
+
+#include "google/cloud/storage/version.h"
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace internal {
+struct ObjectSummaryParser;
+}  // namespace internal
+
+/**
+ * A compact summary of a Google Cloud Storage object.
+ *
+ * `ObjectMetadata` holds all the attributes of an object, and is relatively
+ * expensive to create and store. Applications that list many objects, but only
+ * need their names, sizes, generations, and checksums should use
+ * `Client::ListObjectSummaries()`, which returns objects of this class.
+ *
+ * The names of all the objects in a page of results are stored in a single
+ * buffer, shared by the summaries for that page. The buffer is released when
+ * the last of these summaries is destroyed.
+ */
+class ObjectSummary {
+ public:
+  ObjectSummary() = default;
+
+  /// The object name.
+  std::string name() const { return std::string(name_data(), name_size_); }
+
+  /// The object name, without making a copy, this is *not* null-terminated.
+  char const* name_data() const { return name_ ? name_.get() : ""; }
+  std::size_t name_size() const { return name_size_; }
+
+  std::int64_t generation() const { return generation_; }
+  std::uint64_t size() const { return size_; }
+
+  /// True if the listing included the CRC32C checksum of the object.
+  bool has_crc32c() const { return has_crc32c_; }
+  /// The CRC32C checksum of the object, only valid if `has_crc32c()` is true.
+  std::uint32_t crc32c() const { return crc32c_; }
+
+ private:
+  friend struct internal::ObjectSummaryParser;
+
+  std::shared_ptr<char const> name_;
+  std::uint32_t name_size_ = 0;
+  bool has_crc32c_ = false;
+  std::uint32_t crc32c_ = 0;
+  std::int64_t generation_ = 0;
+  std::uint64_t size_ = 0;
+};
+
+bool operator==(ObjectSummary const& lhs, ObjectSummary const& rhs);
+
+inline bool operator!=(ObjectSummary const& lhs, ObjectSummary const& rhs) {
+  return std::rel_ops::operator!=(lhs, rhs);
+}
+
+std::ostream& operator<<(std::ostream& os, ObjectSummary const& rhs);
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_OBJECT_SUMMARY_H_
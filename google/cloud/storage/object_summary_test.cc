@@ -0,0 +1,80 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/object_summary.h"
+#include "google/cloud/storage/internal/nljson.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ::testing::HasSubstr;
+
+std::vector<ObjectSummary> CreatePage() {
+  internal::nl::json items = internal::nl::json::array({
+      {{"name", "foo"}, {"generation", "1"}, {"size", "10"}},
+      {{"name", "bar"}, {"generation", "2"}, {"crc32c", "ImIEBA=="}},
+  });
+  return internal::ObjectSummaryParser::FromJsonArray(items).value();
+}
+
+TEST(ObjectSummaryTest, Default) {
+  ObjectSummary summary;
+  EXPECT_EQ("", summary.name());
+  EXPECT_EQ(0U, summary.name_size());
+  EXPECT_EQ(0, summary.generation());
+  EXPECT_EQ(0U, summary.size());
+  EXPECT_FALSE(summary.has_crc32c());
+}
+
+TEST(ObjectSummaryTest, Compare) {
+  auto page1 = CreatePage();
+  auto page2 = CreatePage();
+  EXPECT_EQ(page1[0], page2[0]);
+  EXPECT_EQ(page1[1], page2[1]);
+  EXPECT_NE(page1[0], page1[1]);
+  EXPECT_NE(page1[0], ObjectSummary{});
+}
+
+TEST(ObjectSummaryTest, OutlivesPage) {
+  ObjectSummary summary;
+  {
+    auto page = CreatePage();
+    summary = page[1];
+  }
+  EXPECT_EQ("bar", summary.name());
+  EXPECT_EQ(2, summary.generation());
+}
+
+TEST(ObjectSummaryTest, IOStream) {
+  auto page = CreatePage();
+  std::ostringstream os;
+  os << page[1];
+  auto actual = os.str();
+  EXPECT_THAT(actual, HasSubstr("name=bar"));
+  EXPECT_THAT(actual, HasSubstr("generation=2"));
+  EXPECT_THAT(actual, HasSubstr("crc32c=0x22620404"));
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -440,6 +440,16 @@ TEST_F(ObjectTest, ReadObjectPermanentFailure) {
   EXPECT_THAT(status.message(), HasSubstr("ReadObject"));
 }
 
+TEST_F(ObjectTest, ReadObjectGzipDecompressionWithRange) {
+  EXPECT_CALL(*mock, ReadObject(_)).Times(0);
+
+  Status status = client->ReadObject("test-bucket-name", "test-object-name",
+                                     GzipDecompression(true), ReadRange(10, 20))
+                      .status();
+  EXPECT_EQ(StatusCode::kInvalidArgument, status.code());
+  EXPECT_THAT(status.message(), HasSubstr("gzip"));
+}
+
 }  // namespace
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
@@ -0,0 +1,184 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/parallel_object_reader.h"
+#include "google/cloud/storage/internal/hash_validator.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+// Large enough to read most small objects in a single call, the buffer is
+// reused for all the downloads in a thread.
+std::size_t constexpr kReadBufferSize = 128 * 1024;
+}  // namespace
+
+ParallelObjectReader::ParallelObjectReader(
+    std::shared_ptr<internal::RawClient> client, std::string bucket_name,
+    std::vector<std::string> object_names, ApplyOptions apply_options)
+    : client_(std::move(client)),
+      bucket_name_(std::move(bucket_name)),
+      object_names_(std::move(object_names)),
+      apply_options_(std::move(apply_options)) {}
+
+std::vector<ReadObjectsResult> ParallelObjectReader::Run() {
+  std::vector<ReadObjectsResult> results;
+  results.reserve(object_names_.size());
+  RunWithCallback([&results](ReadObjectsResult r) {
+    results.push_back(std::move(r));
+  });
+  return results;
+}
+
+void ParallelObjectReader::RunWithCallback(Callback cb) {
+  std::mutex mu;
+  std::size_t next = 0;
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+  std::exception_ptr callback_exception;
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+
+  auto worker = [&] {
+    std::string buffer(kReadBufferSize, '\0');
+    std::unique_lock<std::mutex> lk(mu);
+    while (next != object_names_.size()) {
+      auto const& name = object_names_[next++];
+      lk.unlock();
+      auto result = ReadOneNoExcept(name, buffer);
+      lk.lock();
+      if (!cb) {
+        continue;
+      }
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+      // An exception escaping the thread would terminate the program, stop
+      // starting new downloads and report it from RunWithCallback() instead.
+      try {
+        cb(std::move(result));
+      } catch (...) {
+        if (!callback_exception) {
+          callback_exception = std::current_exception();
+        }
+        next = object_names_.size();
+      }
+#else
+      cb(std::move(result));
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+    }
+  };
+
+  auto const thread_count = (std::min)(max_concurrency_, object_names_.size());
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i != thread_count; ++i) {
+    threads.emplace_back(worker);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+  if (callback_exception) {
+    std::rethrow_exception(callback_exception);
+  }
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+}
+
+ReadObjectsResult ParallelObjectReader::ReadOneNoExcept(
+    std::string const& object_name, std::string& buffer) {
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+  // Report any exceptions as the status for this object, the other downloads
+  // are not affected.
+  try {
+    return ReadOne(object_name, buffer);
+  } catch (std::exception const& ex) {
+    return ReadObjectsResult{
+        object_name,
+        Status(StatusCode::kUnknown,
+               std::string("exception reading object: ") + ex.what())};
+  } catch (...) {
+    return ReadObjectsResult{
+        object_name, Status(StatusCode::kUnknown,
+                            "unknown exception reading object")};
+  }
+#else
+  return ReadOne(object_name, buffer);
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+}
+
+ReadObjectsResult ParallelObjectReader::ReadOne(std::string object_name,
+                                             std::string& buffer) {
+  internal::ReadObjectRangeRequest request(bucket_name_, object_name);
+  if (apply_options_) {
+    apply_options_(request);
+  }
+  if (request.RequiresGzipDecompression()) {
+    std::ostringstream os;
+    os << __func__ << ": GzipDecompression is not supported, request="
+       << request;
+    return ReadObjectsResult{
+        std::move(object_name),
+        Status(StatusCode::kInvalidArgument, std::move(os).str())};
+  }
+  auto source = client_->ReadObject(request);
+  if (!source) {
+    return ReadObjectsResult{std::move(object_name),
+                             std::move(source).status()};
+  }
+
+  auto hash_validator = internal::CreateHashValidator(request);
+  std::string contents;
+  for (;;) {
+    auto read = (*source)->Read(&buffer[0], buffer.size());
+    if (!read) {
+      return ReadObjectsResult{std::move(object_name),
+                               std::move(read).status()};
+    }
+    if (read->response.status_code >= 300) {
+      return ReadObjectsResult{std::move(object_name),
+                               AsStatus(read->response)};
+    }
+    auto hashes = read->response.headers.equal_range("x-goog-hash");
+    for (auto h = hashes.first; h != hashes.second; ++h) {
+      auto kv = *h;
+      hash_validator->ProcessHeader(kv.first, kv.second);
+    }
+    hash_validator->Update(buffer.data(), read->bytes_received);
+    contents.append(buffer.data(), read->bytes_received);
+    if (read->response.status_code != 100) {
+      break;
+    }
+  }
+  if ((*source)->IsOpen()) {
+    (*source)->Close();
+  }
+
+  auto hashes = std::move(*hash_validator).Finish();
+  if (hashes.is_mismatch) {
+    std::ostringstream os;
+    os << __func__ << ": mismatched hashes in download for " << request
+       << ", expected=" << hashes.computed << ", received=" << hashes.received;
+    return ReadObjectsResult{
+        std::move(object_name),
+        Status(StatusCode::kDataLoss, std::move(os).str())};
+  }
+  return ReadObjectsResult{std::move(object_name), std::move(contents)};
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
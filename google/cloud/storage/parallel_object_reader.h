@@ -0,0 +1,134 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_OBJECT_READER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_OBJECT_READER_H_
+
+#include "google/cloud/status_or.h"
+#include "google/cloud/storage/internal/raw_client.h"
+#include "google/cloud/storage/version.h"
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/// The result of reading a single object with a `ParallelObjectReader`.
+struct ReadObjectsResult {
+  std::string object_name;
+  /// The full contents of the object, or the error reading it.
+  StatusOr<std::string> contents;
+};
+
+/**
+ * Reads the full contents of many objects using a pool of threads.
+ *
+ * Reading many small objects one at a time is dominated by the latency of
+ * each request. This class starts up to `max_concurrency()` threads, each
+ * making one blocking download at a time, and delivers each object as soon as
+ * its download completes, that is, the results are in completion order and
+ * not in the order of the object names. The downloads do not share a
+ * `CURLM` multi handle, each thread uses its own connection from the client.
+ *
+ * The downloads are made through the same `RawClient` as any other request,
+ * so they share the client's connections, and are subject to its retry,
+ * logging, and rate limiting policies. The downloaded data is validated using
+ * the same hashes as `Client::ReadObject()`.
+ *
+ * @par Example
+ * @code
+ * auto results = client.ReadObjects("my-bucket", names)
+ *                    .set_max_concurrency(64)
+ *                    .Run();
+ * for (auto& r : results) {
+ *   if (!r.contents) throw std::runtime_error(r.contents.status().message());
+ *   Process(r.object_name, *r.contents);
+ * }
+ * @endcode
+ */
+class ParallelObjectReader {
+ public:
+  using Callback = std::function<void(ReadObjectsResult)>;
+  using ApplyOptions = std::function<void(internal::ReadObjectRangeRequest&)>;
+
+  /**
+   * Creates a reader for @p object_names in @p bucket_name.
+   *
+   * @param apply_options sets the request options, such as `Generation` or
+   *     `UserProject`, on each download request. The reader does not
+   *     decompress the data, downloads requesting `GzipDecompression` fail
+   *     with `StatusCode::kInvalidArgument`.
+   */
+  ParallelObjectReader(std::shared_ptr<internal::RawClient> client,
+                       std::string bucket_name,
+                       std::vector<std::string> object_names,
+                       ApplyOptions apply_options = ApplyOptions{});
+
+  /// The maximum number of concurrent downloads.
+  std::size_t max_concurrency() const { return max_concurrency_; }
+  ParallelObjectReader& set_max_concurrency(std::size_t v) {
+    max_concurrency_ = v == 0 ? 1 : v;
+    return *this;
+  }
+
+  /**
+   * Reads all the objects, blocking until all the downloads complete.
+   *
+   * @return the results in completion order. The status of each result
+   *     reports any errors for that object.
+   */
+  std::vector<ReadObjectsResult> Run();
+
+  /**
+   * Reads all the objects, calling @p cb as each download completes.
+   *
+   * The callback is invoked from the threads making the downloads, but never
+   * concurrently. Other downloads continue while the callback runs. If the
+   * callback throws, no new downloads are started, and the exception is
+   * rethrown once the downloads in progress complete.
+   */
+  void RunWithCallback(Callback cb);
+
+ private:
+  ReadObjectsResult ReadOneNoExcept(std::string const& object_name,
+                                    std::string& buffer);
+  ReadObjectsResult ReadOne(std::string object_name, std::string& buffer);
+
+  std::shared_ptr<internal::RawClient> client_;
+  std::string bucket_name_;
+  std::vector<std::string> object_names_;
+  ApplyOptions apply_options_;
+  std::size_t max_concurrency_ = 32;
+};
+
+namespace internal {
+/// Captures @p options to apply them to each request of a parallel reader.
+template <typename... Options>
+ParallelObjectReader::ApplyOptions MakeParallelObjectReadOptions(
+    Options&&... options) {
+  return [options...](ReadObjectRangeRequest& request) {
+    request.set_multiple_options(
+        typename std::decay<Options>::type(options)...);
+  };
+}
+}  // namespace internal
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_PARALLEL_OBJECT_READER_H_
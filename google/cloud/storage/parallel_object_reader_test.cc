@@ -0,0 +1,243 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/parallel_object_reader.h"
+#include "google/cloud/internal/make_unique.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/internal/object_requests.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/canonical_errors.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ::google::cloud::storage::testing::canonical_errors::PermanentError;
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+/// Create a read source that returns @p data in small chunks.
+std::unique_ptr<internal::ObjectReadSource> MakeSource(
+    std::string data, std::multimap<std::string, std::string> headers = {}) {
+  auto source = google::cloud::internal::make_unique<
+      ::testing::NiceMock<testing::MockObjectReadSource>>();
+  auto remaining = std::make_shared<std::string>(std::move(data));
+  ON_CALL(*source, Read(_, _))
+      .WillByDefault(Invoke([remaining, headers](char* buf, std::size_t n) {
+        auto count = (std::min)(n, (std::min)(std::size_t(64),
+                                              remaining->size()));
+        remaining->copy(buf, count);
+        remaining->erase(0, count);
+        int code = remaining->empty() ? 200 : 100;
+        return internal::ReadSourceResult{
+            count, internal::HttpResponse{code, "", headers}};
+      }));
+  ON_CALL(*source, IsOpen()).WillByDefault(Return(false));
+  return std::unique_ptr<internal::ObjectReadSource>(std::move(source));
+}
+
+class ParallelObjectReaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mock_ = std::make_shared<testing::MockClient>();
+    EXPECT_CALL(*mock_, client_options())
+        .WillRepeatedly(ReturnRef(client_options_));
+  }
+
+  std::shared_ptr<testing::MockClient> mock_;
+  ClientOptions client_options_ =
+      ClientOptions(oauth2::CreateAnonymousCredentials());
+};
+
+TEST_F(ParallelObjectReaderTest, ReadsAllObjects) {
+  std::atomic<int> active(0);
+  std::atomic<int> max_active(0);
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(100)
+      .WillRepeatedly(Invoke([&](internal::ReadObjectRangeRequest const& r) {
+        EXPECT_EQ("test-bucket", r.bucket_name());
+        EXPECT_EQ("test-project", r.GetOption<UserProject>().value());
+        auto current = ++active;
+        for (auto m = max_active.load(); m < current;) {
+          max_active.compare_exchange_weak(m, current);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        --active;
+        return make_status_or(MakeSource(
+            "contents of " + r.object_name() + std::string(200, 'x'),
+            {{"x-goog-hash", "crc32c=invalid"}}));
+      }));
+
+  std::vector<std::string> names;
+  for (int i = 0; i != 100; ++i) {
+    names.push_back("object-" + std::to_string(i));
+  }
+  Client client(std::shared_ptr<internal::RawClient>(mock_),
+                Client::NoDecorations{});
+  auto results =
+      client
+          .ReadObjects("test-bucket", names, DisableCrc32cChecksum(true),
+                       DisableMD5Hash(true), UserProject("test-project"))
+          .set_max_concurrency(8)
+          .Run();
+  ASSERT_EQ(names.size(), results.size());
+  std::set<std::string> actual;
+  for (auto const& r : results) {
+    ASSERT_STATUS_OK(r.contents);
+    EXPECT_EQ("contents of " + r.object_name + std::string(200, 'x'),
+              *r.contents);
+    actual.insert(r.object_name);
+  }
+  EXPECT_EQ(std::set<std::string>(names.begin(), names.end()), actual);
+  EXPECT_LE(max_active.load(), 8);
+}
+
+TEST_F(ParallelObjectReaderTest, ReportsErrorsPerObject) {
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([](internal::ReadObjectRangeRequest const& r)
+                                 -> StatusOr<std::unique_ptr<
+                                     internal::ObjectReadSource>> {
+        if (r.object_name() == "missing") {
+          return PermanentError();
+        }
+        return MakeSource("data for " + r.object_name());
+      }));
+
+  ParallelObjectReader reader(mock_, "test-bucket", {"a", "missing", "b"});
+  std::map<std::string, StatusOr<std::string>> results;
+  reader.set_max_concurrency(2).RunWithCallback([&](ReadObjectsResult r) {
+    results.emplace(r.object_name, std::move(r.contents));
+  });
+  ASSERT_EQ(3U, results.size());
+  ASSERT_STATUS_OK(results.at("a"));
+  EXPECT_EQ("data for a", *results.at("a"));
+  ASSERT_STATUS_OK(results.at("b"));
+  EXPECT_EQ("data for b", *results.at("b"));
+  EXPECT_EQ(PermanentError().code(), results.at("missing").status().code());
+}
+
+TEST_F(ParallelObjectReaderTest, HttpError) {
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([](internal::ReadObjectRangeRequest const&) {
+        auto source = google::cloud::internal::make_unique<
+            ::testing::NiceMock<testing::MockObjectReadSource>>();
+        EXPECT_CALL(*source, Read(_, _))
+            .WillOnce(Return(internal::ReadSourceResult{
+                0, internal::HttpResponse{404, "not found", {}}}));
+        return make_status_or(
+            std::unique_ptr<internal::ObjectReadSource>(std::move(source)));
+      }));
+
+  ParallelObjectReader reader(mock_, "test-bucket", {"a"});
+  auto results = reader.Run();
+  ASSERT_EQ(1U, results.size());
+  EXPECT_EQ(StatusCode::kNotFound, results[0].contents.status().code());
+}
+
+TEST_F(ParallelObjectReaderTest, HashMismatch) {
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([](internal::ReadObjectRangeRequest const&) {
+        return make_status_or(MakeSource(
+            "some data", {{"x-goog-hash", "crc32c=AAAAAA=="}}));
+      }));
+
+  ParallelObjectReader reader(mock_, "test-bucket", {"a"},
+                              internal::MakeParallelObjectReadOptions(
+                                  DisableMD5Hash(true)));
+  auto results = reader.Run();
+  ASSERT_EQ(1U, results.size());
+  EXPECT_EQ(StatusCode::kDataLoss, results[0].contents.status().code());
+}
+
+TEST_F(ParallelObjectReaderTest, GzipDecompressionIsRejected) {
+  EXPECT_CALL(*mock_, ReadObject(_)).Times(0);
+
+  ParallelObjectReader reader(mock_, "test-bucket", {"a", "b"},
+                              internal::MakeParallelObjectReadOptions(
+                                  GzipDecompression(true)));
+  auto results = reader.Run();
+  ASSERT_EQ(2U, results.size());
+  for (auto const& r : results) {
+    EXPECT_EQ(StatusCode::kInvalidArgument, r.contents.status().code());
+  }
+}
+
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+TEST_F(ParallelObjectReaderTest, ReportsExceptionsPerObject) {
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([](internal::ReadObjectRangeRequest const& r)
+                                 -> StatusOr<std::unique_ptr<
+                                     internal::ObjectReadSource>> {
+        if (r.object_name() == "throws") {
+          throw std::runtime_error("simulated error");
+        }
+        return MakeSource("data for " + r.object_name());
+      }));
+
+  ParallelObjectReader reader(mock_, "test-bucket", {"a", "throws", "b"});
+  std::map<std::string, StatusOr<std::string>> results;
+  reader.set_max_concurrency(2).RunWithCallback([&](ReadObjectsResult r) {
+    results.emplace(r.object_name, std::move(r.contents));
+  });
+  ASSERT_EQ(3U, results.size());
+  ASSERT_STATUS_OK(results.at("a"));
+  ASSERT_STATUS_OK(results.at("b"));
+  auto const& failed = results.at("throws");
+  EXPECT_EQ(StatusCode::kUnknown, failed.status().code());
+  EXPECT_THAT(failed.status().message(), HasSubstr("simulated error"));
+}
+
+TEST_F(ParallelObjectReaderTest, CallbackExceptionIsRethrown) {
+  EXPECT_CALL(*mock_, ReadObject(_))
+      .WillOnce(Invoke([](internal::ReadObjectRangeRequest const& r) {
+        return make_status_or(MakeSource("data for " + r.object_name()));
+      }));
+
+  // With a single thread the first exception stops all the other downloads.
+  ParallelObjectReader reader(mock_, "test-bucket", {"a", "b", "c"});
+  reader.set_max_concurrency(1);
+  auto callback = [](ReadObjectsResult const&) {
+    throw std::runtime_error("callback error");
+  };
+  EXPECT_THROW(reader.RunWithCallback(callback), std::runtime_error);
+}
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+
+TEST_F(ParallelObjectReaderTest, Empty) {
+  EXPECT_CALL(*mock_, ReadObject(_)).Times(0);
+  ParallelObjectReader reader(mock_, "test-bucket", {});
+  EXPECT_TRUE(reader.Run().empty());
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,106 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/policy_document_signer.h"
+#include "google/cloud/internal/port_platform.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/internal/openssl_util.h"
+#include "google/cloud/storage/internal/policy_document_request.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+
+PolicyDocumentSigner::PolicyDocumentSigner(
+    std::shared_ptr<internal::RawClient> client, SigningAccount signing_account)
+    : client_(std::move(client)),
+      signing_account_(std::move(signing_account)) {
+  signing_email_ = Client(client_, Client::NoDecorations{})
+                       .SigningEmail(signing_account_);
+}
+
+StatusOr<PolicyDocumentResult> PolicyDocumentSigner::Sign(
+    PolicyDocument const& document) const {
+  auto base64_policy =
+      internal::Base64Encode(internal::PolicyDocumentStringToSign(document));
+  auto signed_blob = Client(client_, Client::NoDecorations{})
+                         .SignBlobImpl(signing_account_, base64_policy);
+  if (!signed_blob) {
+    return signed_blob.status();
+  }
+
+  return PolicyDocumentResult{
+      signing_email_, document.expiration, std::move(base64_policy),
+      internal::Base64Encode(signed_blob->signed_blob)};
+}
+
+std::vector<StatusOr<PolicyDocumentResult>> PolicyDocumentSigner::SignBatch(
+    std::vector<PolicyDocument> const& documents,
+    std::size_t thread_count) const {
+  std::vector<StatusOr<PolicyDocumentResult>> results(documents.size());
+  if (documents.empty()) {
+    return results;
+  }
+  // Signing the first document in this thread loads any state cached by the
+  // credentials (such as the parsed private key) before the workers start.
+  results[0] = SignNoExcept(documents[0]);
+
+  std::atomic<std::size_t> next(1);
+  auto worker = [this, &documents, &results, &next] {
+    for (auto i = next++; i < documents.size(); i = next++) {
+      results[i] = SignNoExcept(documents[i]);
+    }
+  };
+  auto const count = (std::min)(thread_count, documents.size() - 1);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < count; ++i) {
+    threads.emplace_back(worker);
+  }
+  // The calling thread is one of the workers.
+  worker();
+  for (auto& t : threads) {
+    t.join();
+  }
+  return results;
+}
+
+StatusOr<PolicyDocumentResult> PolicyDocumentSigner::SignNoExcept(
+    PolicyDocument const& document) const {
+#if GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+  // An exception escaping a worker thread would terminate the program, report
+  // it as the status for this document, the other documents are not affected.
+  try {
+    return Sign(document);
+  } catch (std::exception const& ex) {
+    return Status(StatusCode::kUnknown,
+                  std::string("exception signing policy document: ") +
+                      ex.what());
+  } catch (...) {
+    return Status(StatusCode::kUnknown,
+                  "unknown exception signing policy document");
+  }
+#else
+  return Sign(document);
+#endif  // GOOGLE_CLOUD_CPP_HAVE_EXCEPTIONS
+}
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,84 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_POLICY_DOCUMENT_SIGNER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_POLICY_DOCUMENT_SIGNER_H_
+
+#include "google/cloud/status_or.h"
+#include "google/cloud/storage/internal/raw_client.h"
+#include "google/cloud/storage/policy_document.h"
+#include "google/cloud/storage/signed_url_options.h"
+#include "google/cloud/storage/version.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/**
+ * Signs many policy documents with the same account.
+ *
+ * `Client::CreateSignedPolicyDocument()` finds the signing account and its
+ * key for each document. Applications that sign a policy document for each
+ * request they receive should create a signer with
+ * `Client::CreatePolicyDocumentSigner()` instead. The signer finds the signing
+ * account once, and the service account credentials parse their private key
+ * only once, so signing a document only serializes, encodes, and signs it.
+ *
+ * The signer is cheap to copy, and can be used from multiple threads at the
+ * same time.
+ */
+class PolicyDocumentSigner {
+ public:
+  PolicyDocumentSigner(std::shared_ptr<internal::RawClient> client,
+                       SigningAccount signing_account);
+
+  /// The email of the account that signs the documents.
+  std::string const& signing_email() const { return signing_email_; }
+
+  /// Signs a single policy document.
+  StatusOr<PolicyDocumentResult> Sign(PolicyDocument const& document) const;
+
+  /**
+   * Signs a batch of policy documents using up to @p thread_count threads.
+   *
+   * The first document is signed in the calling thread, the remaining
+   * documents are distributed across the threads. Documents that cannot be
+   * signed do not stop the batch, their entries in the result contain the
+   * error. Exceptions raised while signing a document are also reported as
+   * the error for that document.
+   *
+   * @return the results, in the same order as @p documents.
+   */
+  std::vector<StatusOr<PolicyDocumentResult>> SignBatch(
+      std::vector<PolicyDocument> const& documents,
+      std::size_t thread_count) const;
+
+ private:
+  StatusOr<PolicyDocumentResult> SignNoExcept(
+      PolicyDocument const& document) const;
+
+  std::shared_ptr<internal::RawClient> client_;
+  SigningAccount signing_account_;
+  std::string signing_email_;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_POLICY_DOCUMENT_SIGNER_H_
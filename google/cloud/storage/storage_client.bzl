@@ -19,6 +19,8 @@
 storage_client_hdrs = [
     "bucket_access_control.h",
     "bucket_metadata.h",
+    "buffer_pool.h",
+    "bulk_rewriter.h",
     "client.h",
     "client_options.h",
     "download_options.h",
@@ -27,14 +29,19 @@ storage_client_hdrs = [
     "iam_policy.h",
     "idempotency_policy.h",
     "internal/access_control_common.h",
+    "internal/adaptive_concurrency_client.h",
+    "internal/adaptive_concurrency_limiter.h",
     "internal/binary_data_as_debug_string.h",
     "internal/bucket_acl_requests.h",
     "internal/bucket_requests.h",
+    "internal/caching_client.h",
+    "internal/coalescing_client.h",
     "internal/complex_option.h",
     "internal/common_metadata.h",
     "internal/compute_engine_util.h",
     "internal/curl_handle.h",
     "internal/curl_handle_factory.h",
+    "internal/curl_multiplexer.h",
     "internal/curl_download_request.h",
     "internal/curl_request.h",
     "internal/curl_request_builder.h",
@@ -46,17 +53,25 @@ storage_client_hdrs = [
     "internal/generate_message_boundary.h",
     "internal/generic_object_request.h",
     "internal/generic_request.h",
+    "internal/gzip_compressor.h",
+    "internal/gzip_decompressor.h",
     "internal/hash_validator.h",
     "internal/hash_validator_impl.h",
     "internal/hmac_key_requests.h",
+    "internal/http_headers.h",
     "internal/http_response.h",
+    "internal/json_writer.h",
+    "internal/latency_histogram.h",
     "internal/logging_client.h",
     "internal/logging_resumable_upload_session.h",
     "internal/metadata_parser.h",
+    "internal/metrics_client.h",
     "internal/nljson.h",
     "internal/notification_requests.h",
     "internal/openssl_util.h",
     "internal/object_acl_requests.h",
+    "internal/object_block_cache.h",
+    "internal/object_disk_cache.h",
     "internal/object_requests.h",
     "internal/object_streambuf.h",
     "internal/object_read_source.h",
@@ -73,6 +88,8 @@ storage_client_hdrs = [
     "internal/sha256_hash.h",
     "internal/sign_blob_requests.h",
     "internal/signed_url_requests.h",
+    "internal/token_bucket.h",
+    "internal/tracing_sampler.h",
     "lifecycle_rule.h",
     "list_buckets_reader.h",
     "list_hmac_keys_reader.h",
@@ -91,14 +108,21 @@ storage_client_hdrs = [
     "oauth2/service_account_credentials.h",
     "object_access_control.h",
     "object_metadata.h",
+    "object_random_access_reader.h",
     "object_rewriter.h",
     "object_stream.h",
+    "object_summary.h",
+    "parallel_object_reader.h",
     "policy_document.h",
+    "policy_document_signer.h",
     "override_default_project.h",
     "retry_policy.h",
     "service_account.h",
     "signed_url_options.h",
     "storage_class.h",
+    "tracing_sampling.h",
+    "transfer_metrics.h",
+    "transport_tuning.h",
     "upload_options.h",
     "version.h",
     "version_info.h",
@@ -109,6 +133,8 @@ storage_client_hdrs = [
 storage_client_srcs = [
     "bucket_access_control.cc",
     "bucket_metadata.cc",
+    "buffer_pool.cc",
+    "bulk_rewriter.cc",
     "client.cc",
     "client_options.cc",
     "hashing_options.cc",
@@ -116,12 +142,17 @@ storage_client_srcs = [
     "iam_policy.cc",
     "idempotency_policy.cc",
     "internal/access_control_common.cc",
+    "internal/adaptive_concurrency_client.cc",
+    "internal/adaptive_concurrency_limiter.cc",
     "internal/binary_data_as_debug_string.cc",
     "internal/bucket_acl_requests.cc",
     "internal/bucket_requests.cc",
+    "internal/caching_client.cc",
+    "internal/coalescing_client.cc",
     "internal/compute_engine_util.cc",
     "internal/curl_handle.cc",
     "internal/curl_handle_factory.cc",
+    "internal/curl_multiplexer.cc",
     "internal/curl_download_request.cc",
     "internal/curl_request.cc",
     "internal/curl_request_builder.cc",
@@ -130,16 +161,24 @@ storage_client_srcs = [
     "internal/curl_resumable_upload_session.cc",
     "internal/default_object_acl_requests.cc",
     "internal/empty_response.cc",
+    "internal/gzip_compressor.cc",
+    "internal/gzip_decompressor.cc",
     "internal/hash_validator.cc",
     "internal/hash_validator_impl.cc",
     "internal/hmac_key_requests.cc",
+    "internal/http_headers.cc",
     "internal/http_response.cc",
+    "internal/json_writer.cc",
+    "internal/latency_histogram.cc",
     "internal/logging_client.cc",
     "internal/logging_resumable_upload_session.cc",
     "internal/metadata_parser.cc",
+    "internal/metrics_client.cc",
     "internal/notification_requests.cc",
     "internal/openssl_util.cc",
     "internal/object_acl_requests.cc",
+    "internal/object_block_cache.cc",
+    "internal/object_disk_cache.cc",
     "internal/object_requests.cc",
     "internal/object_streambuf.cc",
     "internal/policy_document_request.cc",
@@ -151,6 +190,8 @@ storage_client_srcs = [
     "internal/sha256_hash.cc",
     "internal/sign_blob_requests.cc",
     "internal/signed_url_requests.cc",
+    "internal/token_bucket.cc",
+    "internal/tracing_sampler.cc",
     "lifecycle_rule.cc",
     "list_buckets_reader.cc",
     "list_hmac_keys_reader.cc",
@@ -165,10 +206,15 @@ storage_client_srcs = [
     "oauth2/service_account_credentials.cc",
     "object_access_control.cc",
     "object_metadata.cc",
+    "object_random_access_reader.cc",
     "object_rewriter.cc",
     "object_stream.cc",
+    "object_summary.cc",
+    "parallel_object_reader.cc",
     "policy_document.cc",
+    "policy_document_signer.cc",
     "service_account.cc",
+    "transfer_metrics.cc",
     "version.cc",
     "well_known_headers.cc",
 ]
@@ -14,6 +14,7 @@
 
 #include "google/cloud/internal/setenv.h"
 #include "google/cloud/storage/client_options.h"
+#include "google/cloud/storage/internal/metrics_client.h"
 #include "google/cloud/storage/oauth2/google_credentials.h"
 #include "google/cloud/testing_util/assert_ok.h"
 #include "google/cloud/testing_util/environment_variable_restore.h"
@@ -28,15 +29,23 @@ class ClientOptionsTest : public ::testing::Test {
  public:
   ClientOptionsTest()
       : enable_tracing_("CLOUD_STORAGE_ENABLE_TRACING"),
-        endpoint_("CLOUD_STORAGE_TESTBENCH_ENDPOINT") {}
+        endpoint_("CLOUD_STORAGE_TESTBENCH_ENDPOINT"),
+        disk_cache_("CLOUD_STORAGE_DISK_CACHE_DIRECTORY") {}
 
  protected:
-  void SetUp() override { enable_tracing_.SetUp(); }
-  void TearDown() override { enable_tracing_.TearDown(); }
+  void SetUp() override {
+    enable_tracing_.SetUp();
+    disk_cache_.SetUp();
+  }
+  void TearDown() override {
+    enable_tracing_.TearDown();
+    disk_cache_.TearDown();
+  }
 
  protected:
   testing_util::EnvironmentVariableRestore enable_tracing_;
   testing_util::EnvironmentVariableRestore endpoint_;
+  testing_util::EnvironmentVariableRestore disk_cache_;
 };
 
 TEST_F(ClientOptionsTest, Default) {
@@ -68,6 +77,48 @@ TEST_F(ClientOptionsTest, EnableHttp) {
   EXPECT_TRUE(options.enable_http_tracing());
 }
 
+TEST_F(ClientOptionsTest, TracingSamplingFromEnvironment) {
+  google::cloud::internal::SetEnv(
+      "CLOUD_STORAGE_ENABLE_TRACING",
+      "raw-client,sample-period=100,latency-threshold-ms=250");
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_TRUE(options.enable_raw_client_tracing());
+  EXPECT_EQ(100U, options.tracing_sampling().sample_period);
+  EXPECT_EQ(std::chrono::milliseconds(250),
+            options.tracing_sampling().latency_threshold);
+  EXPECT_TRUE(options.tracing_sampling().trace_failures);
+}
+
+TEST_F(ClientOptionsTest, TracingSamplingFromEnvironmentMalformed) {
+  for (auto const* setting :
+       {"raw-client,sample-period=,latency-threshold-ms=",
+        "raw-client,sample-period=abc,latency-threshold-ms=10ms",
+        "raw-client,sample-period=-1,latency-threshold-ms=+5",
+        "raw-client,sample-period=99999999999,latency-threshold-ms= 5"}) {
+    google::cloud::internal::SetEnv("CLOUD_STORAGE_ENABLE_TRACING", setting);
+    ClientOptions options(oauth2::CreateAnonymousCredentials());
+    EXPECT_TRUE(options.enable_raw_client_tracing());
+    // Invalid values are ignored, the defaults are used instead.
+    EXPECT_EQ(1U, options.tracing_sampling().sample_period) << setting;
+    EXPECT_EQ(0, options.tracing_sampling().latency_threshold.count())
+        << setting;
+  }
+}
+
+TEST_F(ClientOptionsTest, SetTracingSampling) {
+  google::cloud::internal::SetEnv("CLOUD_STORAGE_ENABLE_TRACING", nullptr);
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(1U, options.tracing_sampling().sample_period);
+  EXPECT_EQ(0, options.tracing_sampling().latency_threshold.count());
+
+  TracingSampling sampling;
+  sampling.sample_period = 1000;
+  sampling.trace_failures = false;
+  options.set_tracing_sampling(sampling);
+  EXPECT_EQ(1000U, options.tracing_sampling().sample_period);
+  EXPECT_FALSE(options.tracing_sampling().trace_failures);
+}
+
 TEST_F(ClientOptionsTest, EndpointFromEnvironment) {
   google::cloud::internal::SetEnv("CLOUD_STORAGE_TESTBENCH_ENDPOINT",
                                   "http://localhost:1234");
@@ -177,6 +228,118 @@ TEST_F(ClientOptionsTest, SetEnableLockingCallbacks) {
   EXPECT_TRUE(client_options.enable_ssl_locking_callbacks());
 }
 
+TEST_F(ClientOptionsTest, SetConnectionPoolPrewarmAndIdleTime) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(0U, options.connection_pool_prewarm_size());
+  EXPECT_NE(0, options.connection_pool_max_idle_time().count());
+  options.set_connection_pool_prewarm_size(8).set_connection_pool_max_idle_time(
+      std::chrono::seconds(5));
+  EXPECT_EQ(8U, options.connection_pool_prewarm_size());
+  EXPECT_EQ(5, options.connection_pool_max_idle_time().count());
+}
+
+TEST_F(ClientOptionsTest, SetTcpKeepAliveIdleTime) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_NE(0, options.tcp_keepalive_idle_time().count());
+  options.set_tcp_keepalive_idle_time(std::chrono::seconds(0));
+  EXPECT_EQ(0, options.tcp_keepalive_idle_time().count());
+}
+
+TEST_F(ClientOptionsTest, SetTransportTuning) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(0U, options.download_tuning().curl_buffer_size);
+  EXPECT_EQ(0U, options.download_tuning().socket_receive_buffer_size);
+  EXPECT_TRUE(options.download_tuning().tcp_nodelay);
+  EXPECT_EQ(0U, options.upload_tuning().socket_send_buffer_size);
+
+  TransportTuning download;
+  download.curl_buffer_size = 512 * 1024;
+  download.socket_receive_buffer_size = 8 * 1024 * 1024;
+  TransportTuning upload;
+  upload.socket_send_buffer_size = 4 * 1024 * 1024;
+  upload.tcp_nodelay = false;
+  options.set_download_tuning(download).set_upload_tuning(upload);
+  EXPECT_EQ(512 * 1024U, options.download_tuning().curl_buffer_size);
+  EXPECT_EQ(8 * 1024 * 1024U,
+            options.download_tuning().socket_receive_buffer_size);
+  EXPECT_EQ(0U, options.download_tuning().socket_send_buffer_size);
+  EXPECT_EQ(4 * 1024 * 1024U, options.upload_tuning().socket_send_buffer_size);
+  EXPECT_FALSE(options.upload_tuning().tcp_nodelay);
+}
+
+TEST_F(ClientOptionsTest, SetEnableHttp2) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_FALSE(options.enable_http2());
+  EXPECT_NE(0U, options.maximum_http2_connections());
+  options.set_enable_http2(true).set_maximum_http2_connections(2);
+  EXPECT_TRUE(options.enable_http2());
+  EXPECT_EQ(2U, options.maximum_http2_connections());
+}
+
+TEST_F(ClientOptionsTest, SetRateLimits) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(0U, options.maximum_upload_bandwidth());
+  EXPECT_EQ(0U, options.maximum_download_bandwidth());
+  EXPECT_EQ(0, options.maximum_request_rate());
+  options.set_maximum_upload_bandwidth(1024)
+      .set_maximum_download_bandwidth(2048)
+      .set_maximum_request_rate(10);
+  EXPECT_EQ(1024U, options.maximum_upload_bandwidth());
+  EXPECT_EQ(2048U, options.maximum_download_bandwidth());
+  EXPECT_EQ(10, options.maximum_request_rate());
+}
+
+TEST_F(ClientOptionsTest, SetAdaptiveConcurrency) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(0U, options.adaptive_concurrency_initial_limit());
+  EXPECT_NE(0U, options.adaptive_concurrency_maximum_limit());
+  options.set_adaptive_concurrency_initial_limit(4)
+      .set_adaptive_concurrency_maximum_limit(64);
+  EXPECT_EQ(4U, options.adaptive_concurrency_initial_limit());
+  EXPECT_EQ(64U, options.adaptive_concurrency_maximum_limit());
+}
+
+TEST_F(ClientOptionsTest, SetTransferMetricsHook) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(nullptr, options.transfer_metrics_hook());
+  auto hook = std::make_shared<TransferMetricsHistogram>();
+  options.set_transfer_metrics_hook(hook);
+  EXPECT_EQ(hook, options.transfer_metrics_hook());
+}
+
+TEST_F(ClientOptionsTest, SetMetricsRecorder) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ(nullptr, options.metrics_recorder());
+  auto recorder = std::make_shared<internal::MetricsRecorder>();
+  options.set_metrics_recorder(recorder);
+  EXPECT_EQ(recorder, options.metrics_recorder());
+}
+
+TEST_F(ClientOptionsTest, DiskCacheDirectoryFromEnvironment) {
+  google::cloud::internal::SetEnv("CLOUD_STORAGE_DISK_CACHE_DIRECTORY",
+                                  "/var/tmp/test-cache");
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ("/var/tmp/test-cache", options.disk_cache_directory());
+}
+
+TEST_F(ClientOptionsTest, SetDiskCache) {
+  google::cloud::internal::UnsetEnv("CLOUD_STORAGE_DISK_CACHE_DIRECTORY");
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_EQ("", options.disk_cache_directory());
+  EXPECT_NE(0U, options.disk_cache_max_size());
+  options.set_disk_cache_directory("/var/tmp/test-cache")
+      .set_disk_cache_max_size(1024);
+  EXPECT_EQ("/var/tmp/test-cache", options.disk_cache_directory());
+  EXPECT_EQ(1024U, options.disk_cache_max_size());
+}
+
+TEST_F(ClientOptionsTest, SetReadCoalescing) {
+  ClientOptions options(oauth2::CreateAnonymousCredentials());
+  EXPECT_FALSE(options.enable_read_coalescing());
+  options.set_enable_read_coalescing(true);
+  EXPECT_TRUE(options.enable_read_coalescing());
+}
+
 }  // namespace
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
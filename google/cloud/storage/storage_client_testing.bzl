@@ -18,6 +18,7 @@
 
 storage_client_testing_hdrs = [
     "testing/canonical_errors.h",
+    "testing/loopback_listener.h",
     "testing/mock_client.h",
     "testing/mock_http_request.h",
     "testing/retry_tests.h",
@@ -25,6 +26,7 @@ storage_client_testing_hdrs = [
 ]
 
 storage_client_testing_srcs = [
+    "testing/loopback_listener.cc",
     "testing/mock_http_request.cc",
     "testing/storage_integration_test.cc",
 ]
@@ -20,6 +20,8 @@ storage_client_unit_tests = [
     "bucket_access_control_test.cc",
     "bucket_metadata_test.cc",
     "bucket_test.cc",
+    "buffer_pool_test.cc",
+    "bulk_rewriter_test.cc",
     "client_bucket_acl_test.cc",
     "client_default_object_acl_test.cc",
     "client_object_acl_test.cc",
@@ -35,12 +37,18 @@ storage_client_unit_tests = [
     "storage_iam_policy_test.cc",
     "idempotency_policy_test.cc",
     "internal/access_control_common_test.cc",
+    "internal/adaptive_concurrency_client_test.cc",
+    "internal/adaptive_concurrency_limiter_test.cc",
     "internal/binary_data_as_debug_string_test.cc",
     "internal/bucket_acl_requests_test.cc",
     "internal/bucket_requests_test.cc",
+    "internal/caching_client_test.cc",
+    "internal/coalescing_client_test.cc",
     "internal/compute_engine_util_test.cc",
     "internal/curl_client_test.cc",
+    "internal/curl_handle_factory_test.cc",
     "internal/curl_handle_test.cc",
+    "internal/curl_multiplexer_test.cc",
     "internal/curl_resumable_upload_session_test.cc",
     "internal/curl_wrappers_locking_already_present_test.cc",
     "internal/curl_wrappers_locking_enabled_test.cc",
@@ -49,16 +57,24 @@ storage_client_unit_tests = [
     "internal/curl_wrappers_enable_sigpipe_handler_test.cc",
     "internal/default_object_acl_requests_test.cc",
     "internal/generate_message_boundary_test.cc",
+    "internal/gzip_compressor_test.cc",
+    "internal/gzip_decompressor_test.cc",
     "internal/hash_validator_test.cc",
     "internal/hmac_key_requests_test.cc",
+    "internal/http_headers_test.cc",
     "internal/http_response_test.cc",
+    "internal/json_writer_test.cc",
+    "internal/latency_histogram_test.cc",
     "internal/logging_client_test.cc",
     "internal/logging_resumable_upload_session_test.cc",
     "internal/metadata_parser_test.cc",
+    "internal/metrics_client_test.cc",
     "internal/nljson_use_after_third_party_test.cc",
     "internal/nljson_use_third_party_test.cc",
     "internal/notification_requests_test.cc",
     "internal/object_acl_requests_test.cc",
+    "internal/object_block_cache_test.cc",
+    "internal/object_disk_cache_test.cc",
     "internal/object_requests_test.cc",
     "internal/object_streambuf_test.cc",
     "internal/openssl_util_test.cc",
@@ -71,6 +87,8 @@ storage_client_unit_tests = [
     "internal/sha256_hash_test.cc",
     "internal/sign_blob_requests_test.cc",
     "internal/signed_url_requests_test.cc",
+    "internal/token_bucket_test.cc",
+    "internal/tracing_sampler_test.cc",
     "lifecycle_rule_test.cc",
     "list_buckets_reader_test.cc",
     "list_hmac_keys_reader_test.cc",
@@ -83,14 +101,18 @@ storage_client_unit_tests = [
     "oauth2/service_account_credentials_test.cc",
     "object_access_control_test.cc",
     "object_metadata_test.cc",
+    "object_random_access_reader_test.cc",
     "object_stream_test.cc",
+    "object_summary_test.cc",
     "object_test.cc",
+    "parallel_object_reader_test.cc",
     "policy_document_test.cc",
     "notification_metadata_test.cc",
     "retry_policy_test.cc",
     "service_account_test.cc",
     "signed_url_options_test.cc",
     "storage_class_test.cc",
+    "transfer_metrics_test.cc",
     "storage_client_options_test.cc",
     "storage_version_test.cc",
     "well_known_headers_test.cc",
@@ -0,0 +1,69 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/testing/loopback_listener.h"
+#if _WIN32
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace google {
+namespace cloud {
+namespace storage {
+namespace testing {
+#if _WIN32
+LoopbackListener::LoopbackListener(int) : fd_(-1), port_(0) {}
+
+int LoopbackListener::Accept() const { return -1; }
+
+void LoopbackListener::Close() {}
+#else
+LoopbackListener::LoopbackListener(int backlog)
+    : fd_(::socket(AF_INET, SOCK_STREAM, 0)), port_(0) {
+  if (fd_ < 0) {
+    return;
+  }
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(address);
+  if (::bind(fd_, reinterpret_cast<struct sockaddr*>(&address), length) != 0 ||
+      ::listen(fd_, backlog) != 0 ||
+      ::getsockname(fd_, reinterpret_cast<struct sockaddr*>(&address),
+                    &length) != 0) {
+    Close();
+    return;
+  }
+  port_ = ntohs(address.sin_port);
+}
+
+int LoopbackListener::Accept() const {
+  return ::accept(fd_, nullptr, nullptr);
+}
+
+void LoopbackListener::Close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+#endif  // _WIN32
+
+}  // namespace testing
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,67 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TESTING_LOOPBACK_LISTENER_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TESTING_LOOPBACK_LISTENER_H_
+
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+namespace testing {
+/**
+ * A TCP socket listening on a random port of the loopback interface.
+ *
+ * Some tests need to observe the connections opened by the library, or
+ * control the exact bytes returned by a server. They accept connections from
+ * this listener and implement just enough of HTTP/1.1 to run the test.
+ *
+ * @note Only implemented on POSIX systems, on other platforms `ok()` is always
+ *   false.
+ */
+class LoopbackListener {
+ public:
+  explicit LoopbackListener(int backlog = 4);
+  ~LoopbackListener() { Close(); }
+
+  LoopbackListener(LoopbackListener const&) = delete;
+  LoopbackListener& operator=(LoopbackListener const&) = delete;
+
+  /// Returns true if the socket is listening.
+  bool ok() const { return fd_ >= 0; }
+
+  int port() const { return port_; }
+
+  /// The endpoint for this listener, e.g. `http://127.0.0.1:12345`.
+  std::string endpoint() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+  }
+
+  /// Wait for the next connection, returns its socket, or -1 on errors.
+  int Accept() const;
+
+  void Close();
+
+ private:
+  int fd_;
+  int port_;
+};
+
+}  // namespace testing
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TESTING_LOOPBACK_LISTENER_H_
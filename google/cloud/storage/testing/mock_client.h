@@ -64,6 +64,9 @@ class MockClient : public google::cloud::storage::internal::RawClient {
                    internal::ReadObjectRangeRequest const&));
   MOCK_METHOD1(ListObjects, StatusOr<internal::ListObjectsResponse>(
                                 internal::ListObjectsRequest const&));
+  MOCK_METHOD1(ListObjectSummaries,
+               StatusOr<internal::ListObjectSummariesResponse>(
+                   internal::ListObjectsRequest const&));
   MOCK_METHOD1(DeleteObject, StatusOr<internal::EmptyResponse>(
                                  internal::DeleteObjectRequest const&));
   MOCK_METHOD1(UpdateObject, StatusOr<storage::ObjectMetadata>(
@@ -0,0 +1,562 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/tools/directory_sync.h"
+#include "google/cloud/internal/random.h"
+#include "google/cloud/storage/internal/hash_validator_impl.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+// The tools are not built on Windows, they use POSIX APIs to list and write
+// local files.
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace google {
+namespace cloud {
+namespace storage_tools {
+namespace gcs = ::google::cloud::storage;
+
+namespace {
+char const kSlicePartInfix[] = ".sync-part-";
+// Set on each part when it is uploaded, objects created by someone else are
+// never treated as parts, even if their name matches.
+char const kSlicePartMetadataKey[] = "goog-sync-part";
+std::size_t constexpr kSlicePartPrefixLength = 8;
+// Parts younger than this may belong to a sliced upload still in progress.
+auto constexpr kStaleSlicePartAge = std::chrono::hours(24);
+
+Status ErrnoStatus(std::string const& what, std::string const& path) {
+  return Status(StatusCode::kUnknown,
+                what + "(" + path + "): " + std::strerror(errno));
+}
+
+Status ListDirectory(std::string const& root, std::string const& relative,
+                     std::vector<SyncEntry>& entries) {
+  auto const path = relative.empty() ? root : root + "/" + relative;
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    if (errno == ENOENT) {
+      return Status(StatusCode::kNotFound, "cannot open directory " + path);
+    }
+    return ErrnoStatus("opendir", path);
+  }
+  Status status;
+  std::vector<std::string> subdirectories;
+  for (auto* e = readdir(dir); e != nullptr; e = readdir(dir)) {
+    std::string name = e->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    auto const child = relative.empty() ? name : relative + "/" + name;
+    struct stat st;
+    // Use lstat(), following symbolic links could loop forever.
+    if (lstat((root + "/" + child).c_str(), &st) != 0) {
+      status = ErrnoStatus("lstat", root + "/" + child);
+      break;
+    }
+    if (S_ISDIR(st.st_mode)) {
+      subdirectories.push_back(child);
+    } else if (S_ISREG(st.st_mode)) {
+      entries.push_back(
+          SyncEntry{child, static_cast<std::uint64_t>(st.st_size), {}});
+    }
+  }
+  closedir(dir);
+  if (!status.ok()) {
+    return status;
+  }
+  for (auto const& d : subdirectories) {
+    status = ListDirectory(root, d, entries);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return status;
+}
+
+/// Creates all the parent directories of @p path.
+Status MakeParentDirectories(std::string const& path) {
+  for (auto pos = path.find('/', 1); pos != std::string::npos;
+       pos = path.find('/', pos + 1)) {
+    auto const dir = path.substr(0, pos);
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+      return ErrnoStatus("mkdir", dir);
+    }
+  }
+  return Status();
+}
+
+/// Runs @p transfer for each entry using @p thread_count threads.
+SyncResult RunTransfers(std::vector<SyncEntry> const& entries,
+                        std::size_t thread_count,
+                        std::function<Status(SyncEntry const&)> transfer) {
+  SyncResult result;
+  std::mutex mu;
+  std::atomic<std::size_t> next(0);
+  auto worker = [&] {
+    for (auto i = next++; i < entries.size(); i = next++) {
+      auto status = transfer(entries[i]);
+      std::lock_guard<std::mutex> lk(mu);
+      if (status.ok()) {
+        result.transferred.push_back(entries[i]);
+      } else {
+        result.failed.emplace_back(entries[i], std::move(status));
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  thread_count = (std::max)(std::size_t(1),
+                            (std::min)(thread_count, entries.size()));
+  for (std::size_t i = 0; i != thread_count; ++i) {
+    threads.emplace_back(worker);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return result;
+}
+
+/// Returns the [begin, end) range of each slice in a sliced transfer.
+std::vector<std::pair<std::uint64_t, std::uint64_t>> Slices(
+    std::uint64_t size, std::size_t slice_count) {
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> slices;
+  auto const slice_size = (size + slice_count - 1) / slice_count;
+  for (std::uint64_t offset = 0; offset < size; offset += slice_size) {
+    slices.emplace_back(offset, (std::min)(size, offset + slice_size));
+  }
+  return slices;
+}
+
+// Sliced uploads write each slice to a temporary object and then compose the
+// final object. The service computes the CRC32C checksum of the composed
+// object, so later syncs can still compare checksums. The temporary objects
+// have a random prefix, concurrent uploads of the same file do not overwrite
+// each other's parts, and carry a custom metadata mark, see `IsSlicePart()`.
+Status UploadSliced(gcs::Client client, std::string const& path,
+                    std::string const& bucket_name,
+                    std::string const& object_name, std::uint64_t size,
+                    std::size_t slice_count) {
+  auto const slices = Slices(size, slice_count);
+  auto generator = google::cloud::internal::MakeDefaultPRNG();
+  auto const random = google::cloud::internal::Sample(
+      generator, static_cast<int>(kSlicePartPrefixLength),
+      "abcdefghijklmnopqrstuvwxyz0123456789");
+  auto const prefix = object_name + kSlicePartInfix + random + "-";
+  auto part_name = [&prefix](std::size_t i) {
+    return prefix + std::to_string(i);
+  };
+  std::vector<std::future<Status>> tasks;
+  for (std::size_t i = 0; i != slices.size(); ++i) {
+    auto const range = slices[i];
+    tasks.push_back(std::async(std::launch::async, [&, i, range]() -> Status {
+      std::ifstream is(path, std::ios::binary);
+      is.seekg(static_cast<std::streamoff>(range.first));
+      auto os = client.WriteObject(
+          bucket_name, part_name(i),
+          gcs::WithObjectMetadata(gcs::ObjectMetadata().upsert_metadata(
+              kSlicePartMetadataKey, "true")));
+      std::vector<char> buffer(1024 * 1024);
+      for (auto remaining = range.second - range.first; remaining != 0;) {
+        auto n = (std::min)(remaining, std::uint64_t(buffer.size()));
+        is.read(buffer.data(), static_cast<std::streamsize>(n));
+        if (!is) {
+          return Status(StatusCode::kDataLoss, "short read from " + path);
+        }
+        os.write(buffer.data(), static_cast<std::streamsize>(n));
+        remaining -= n;
+      }
+      os.Close();
+      return os.metadata().status();
+    }));
+  }
+  Status status;
+  std::vector<gcs::ComposeSourceObject> sources;
+  for (std::size_t i = 0; i != tasks.size(); ++i) {
+    auto s = tasks[i].get();
+    if (!s.ok() && status.ok()) {
+      status = std::move(s);
+    }
+    sources.push_back(gcs::ComposeSourceObject{part_name(i), {}, {}});
+  }
+  if (status.ok()) {
+    status = client.ComposeObject(bucket_name, sources, object_name).status();
+  }
+  for (auto const& s : sources) {
+    (void)client.DeleteObject(bucket_name, s.object_name);
+  }
+  return status;
+}
+
+// Sliced downloads read each slice with a ranged read, and write it at the
+// right offset of a pre-sized file. Ranged reads are not validated by the
+// client library, the checksum of the complete file is verified instead.
+Status DownloadSliced(gcs::Client client, std::string const& bucket_name,
+                      std::string const& object_name, std::string const& path,
+                      std::uint64_t size, std::size_t slice_count) {
+  { std::ofstream create(path, std::ios::binary | std::ios::trunc); }
+  if (truncate(path.c_str(), static_cast<off_t>(size)) != 0) {
+    return ErrnoStatus("truncate", path);
+  }
+  std::vector<std::future<Status>> tasks;
+  for (auto const& range : Slices(size, slice_count)) {
+    tasks.push_back(std::async(std::launch::async, [&, range]() -> Status {
+      std::fstream os(path, std::ios::binary | std::ios::in | std::ios::out);
+      os.seekp(static_cast<std::streamoff>(range.first));
+      auto is = client.ReadObject(
+          bucket_name, object_name,
+          gcs::ReadRange(static_cast<std::int64_t>(range.first),
+                         static_cast<std::int64_t>(range.second)));
+      std::vector<char> buffer(1024 * 1024);
+      while (is.read(buffer.data(), buffer.size()), is.gcount() > 0) {
+        os.write(buffer.data(), is.gcount());
+      }
+      if (!is.status().ok()) {
+        return is.status();
+      }
+      os.close();
+      if (!os) {
+        return Status(StatusCode::kDataLoss, "error writing to " + path);
+      }
+      return Status();
+    }));
+  }
+  Status status;
+  for (auto& t : tasks) {
+    auto s = t.get();
+    if (!s.ok() && status.ok()) {
+      status = std::move(s);
+    }
+  }
+  return status;
+}
+}  // namespace
+
+StatusOr<GcsLocation> ParseGcsUrl(std::string const& url) {
+  std::string const scheme = "gs://";
+  if (url.compare(0, scheme.size(), scheme) != 0) {
+    return Status(StatusCode::kInvalidArgument,
+                  "expected a gs://bucket/prefix URL, got " + url);
+  }
+  auto const path = url.substr(scheme.size());
+  auto const pos = path.find('/');
+  GcsLocation location;
+  location.bucket_name = path.substr(0, pos);
+  if (pos != std::string::npos) {
+    location.prefix = path.substr(pos + 1);
+  }
+  if (location.bucket_name.empty()) {
+    return Status(StatusCode::kInvalidArgument, "missing bucket in " + url);
+  }
+  if (!location.prefix.empty() && location.prefix.back() != '/') {
+    location.prefix.push_back('/');
+  }
+  return location;
+}
+
+bool IsSlicePart(gcs::ObjectMetadata const& object) {
+  if (!object.has_metadata(kSlicePartMetadataKey)) {
+    return false;
+  }
+  auto const& name = object.name();
+  auto const pos = name.rfind(kSlicePartInfix);
+  if (pos == std::string::npos) {
+    return false;
+  }
+  auto const suffix = name.substr(pos + sizeof(kSlicePartInfix) - 1);
+  if (suffix.size() <= kSlicePartPrefixLength + 1 ||
+      suffix[kSlicePartPrefixLength] != '-') {
+    return false;
+  }
+  return std::all_of(suffix.begin() + kSlicePartPrefixLength + 1, suffix.end(),
+                     [](char c) { return std::isdigit(c) != 0; });
+}
+
+StatusOr<std::vector<SyncEntry>> ListLocalFiles(std::string const& directory) {
+  std::vector<SyncEntry> entries;
+  auto status = ListDirectory(directory, std::string{}, entries);
+  if (!status.ok()) {
+    return status;
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](SyncEntry const& a, SyncEntry const& b) {
+              return a.name < b.name;
+            });
+  return entries;
+}
+
+StatusOr<std::vector<SyncEntry>> ListObjects(
+    gcs::Client client, GcsLocation const& location,
+    std::vector<std::string>* stale_parts) {
+  auto const cutoff = std::chrono::system_clock::now() - kStaleSlicePartAge;
+  std::vector<SyncEntry> entries;
+  for (auto& o : client.ListObjects(location.bucket_name,
+                                    gcs::Prefix(location.prefix))) {
+    if (!o) {
+      return std::move(o).status();
+    }
+    auto const& name = o->name();
+    if (name.size() <= location.prefix.size() || name.back() == '/') {
+      continue;
+    }
+    if (IsSlicePart(*o)) {
+      if (stale_parts != nullptr && o->time_created() < cutoff) {
+        stale_parts->push_back(name);
+      }
+      continue;
+    }
+    entries.push_back(SyncEntry{name.substr(location.prefix.size()),
+                                o->size(), o->crc32c()});
+  }
+  return entries;
+}
+
+StatusOr<std::string> ComputeFileCrc32c(std::string const& path) {
+  gcs::internal::Crc32cHashValidator validator;
+  // Map the file instead of reading it, this avoids copying the data and the
+  // kernel can read ahead aggressively.
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return ErrnoStatus("open", path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    auto status = ErrnoStatus("fstat", path);
+    close(fd);
+    return status;
+  }
+  auto const size = static_cast<std::size_t>(st.st_size);
+  if (size != 0) {
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      auto status = ErrnoStatus("mmap", path);
+      close(fd);
+      return status;
+    }
+    (void)madvise(data, size, MADV_SEQUENTIAL);
+    validator.Update(static_cast<char const*>(data), size);
+    munmap(data, size);
+  }
+  close(fd);
+  return std::move(validator).Finish().computed;
+}
+
+Status ComputeLocalChecksums(std::string const& directory,
+                             std::vector<SyncEntry>& local,
+                             std::vector<SyncEntry> const& remote,
+                             std::size_t thread_count) {
+  std::map<std::string, std::uint64_t> remote_sizes;
+  for (auto const& r : remote) {
+    remote_sizes.emplace(r.name, r.size);
+  }
+  std::vector<SyncEntry*> pending;
+  for (auto& l : local) {
+    auto r = remote_sizes.find(l.name);
+    if (r != remote_sizes.end() && r->second == l.size) {
+      pending.push_back(&l);
+    }
+  }
+
+  std::mutex mu;
+  Status status;
+  std::atomic<std::size_t> next(0);
+  auto worker = [&] {
+    for (auto i = next++; i < pending.size(); i = next++) {
+      auto crc32c = ComputeFileCrc32c(directory + "/" + pending[i]->name);
+      if (!crc32c) {
+        std::lock_guard<std::mutex> lk(mu);
+        if (status.ok()) {
+          status = std::move(crc32c).status();
+        }
+        // Stop all the workers, the sync fails anyway.
+        next = pending.size();
+        return;
+      }
+      pending[i]->crc32c = *std::move(crc32c);
+    }
+  };
+  std::vector<std::thread> threads;
+  thread_count = (std::max)(std::size_t(1),
+                            (std::min)(thread_count, pending.size()));
+  for (std::size_t i = 0; i != thread_count; ++i) {
+    threads.emplace_back(worker);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return status;
+}
+
+std::vector<SyncEntry> ComputeTransfers(
+    std::vector<SyncEntry> const& source,
+    std::vector<SyncEntry> const& destination) {
+  std::map<std::string, SyncEntry const*> index;
+  for (auto const& d : destination) {
+    index.emplace(d.name, &d);
+  }
+  std::vector<SyncEntry> transfers;
+  for (auto const& s : source) {
+    auto d = index.find(s.name);
+    if (d != index.end() && d->second->size == s.size &&
+        !s.crc32c.empty() && d->second->crc32c == s.crc32c) {
+      continue;
+    }
+    transfers.push_back(s);
+  }
+  return transfers;
+}
+
+StatusOr<SyncResult> SyncDirectoryToBucket(gcs::Client client,
+                                           std::string const& directory,
+                                           GcsLocation const& location,
+                                           SyncOptions const& options) {
+  // List both sides in parallel, listing a large bucket can take a while.
+  std::vector<std::string> stale_parts;
+  auto remote_future =
+      std::async(std::launch::async, [&client, &location, &stale_parts] {
+        return ListObjects(client, location, &stale_parts);
+      });
+  auto local = ListLocalFiles(directory);
+  auto remote = remote_future.get();
+  if (!local) {
+    return std::move(local).status();
+  }
+  if (!remote) {
+    return std::move(remote).status();
+  }
+  auto status =
+      ComputeLocalChecksums(directory, *local, *remote, options.thread_count);
+  if (!status.ok()) {
+    return status;
+  }
+
+  auto transfers = ComputeTransfers(*local, *remote);
+  auto const unchanged = local->size() - transfers.size();
+  if (options.dry_run) {
+    SyncResult result;
+    result.transferred = std::move(transfers);
+    result.unchanged = unchanged;
+    return result;
+  }
+  // Remove the parts left behind by interrupted sliced uploads, a failure
+  // leaves them for the next sync.
+  for (auto const& name : stale_parts) {
+    (void)client.DeleteObject(location.bucket_name, name);
+  }
+  auto result = RunTransfers(
+      transfers, options.thread_count, [&](SyncEntry const& entry) -> Status {
+        auto const path = directory + "/" + entry.name;
+        auto const object_name = location.prefix + entry.name;
+        if (entry.size >= options.sliced_transfer_threshold &&
+            options.slice_count > 1) {
+          return UploadSliced(client, path, location.bucket_name, object_name,
+                              entry.size, (std::min)(options.slice_count,
+                                                     std::size_t(32)));
+        }
+        return client.UploadFile(path, location.bucket_name, object_name)
+            .status();
+      });
+  result.unchanged = unchanged;
+  return result;
+}
+
+StatusOr<SyncResult> SyncBucketToDirectory(gcs::Client client,
+                                           GcsLocation const& location,
+                                           std::string const& directory,
+                                           SyncOptions const& options) {
+  auto remote_future = std::async(std::launch::async, [&client, &location] {
+    return ListObjects(client, location);
+  });
+  auto local = ListLocalFiles(directory);
+  auto remote = remote_future.get();
+  if (!local && local.status().code() == StatusCode::kNotFound) {
+    local = std::vector<SyncEntry>{};
+  }
+  if (!local) {
+    return std::move(local).status();
+  }
+  if (!remote) {
+    return std::move(remote).status();
+  }
+  auto status =
+      ComputeLocalChecksums(directory, *local, *remote, options.thread_count);
+  if (!status.ok()) {
+    return status;
+  }
+
+  auto transfers = ComputeTransfers(*remote, *local);
+  auto const unchanged = remote->size() - transfers.size();
+  if (options.dry_run) {
+    SyncResult result;
+    result.transferred = std::move(transfers);
+    result.unchanged = unchanged;
+    return result;
+  }
+  auto result = RunTransfers(
+      transfers, options.thread_count, [&](SyncEntry const& entry) -> Status {
+        auto const path = directory + "/" + entry.name;
+        auto const object_name = location.prefix + entry.name;
+        auto status = MakeParentDirectories(path);
+        if (!status.ok()) {
+          return status;
+        }
+        // Download to a temporary file, a failed download must not leave a
+        // partial file with the right name.
+        auto const tmp = path + ".sync-tmp";
+        if (entry.size >= options.sliced_transfer_threshold &&
+            options.slice_count > 1) {
+          status = DownloadSliced(client, location.bucket_name, object_name,
+                                  tmp, entry.size, options.slice_count);
+          if (status.ok() && !entry.crc32c.empty()) {
+            auto crc32c = ComputeFileCrc32c(tmp);
+            if (!crc32c) {
+              status = std::move(crc32c).status();
+            } else if (*crc32c != entry.crc32c) {
+              status = Status(StatusCode::kDataLoss,
+                              "checksum mismatch downloading " + object_name);
+            }
+          }
+        } else {
+          status =
+              client.DownloadToFile(location.bucket_name, object_name, tmp);
+        }
+        if (status.ok() && std::rename(tmp.c_str(), path.c_str()) != 0) {
+          status = ErrnoStatus("rename", tmp);
+        }
+        if (!status.ok()) {
+          std::remove(tmp.c_str());
+        }
+        return status;
+      });
+  result.unchanged = unchanged;
+  return result;
+}
+
+}  // namespace storage_tools
+}  // namespace cloud
+}  // namespace google
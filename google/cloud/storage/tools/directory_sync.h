@@ -0,0 +1,149 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TOOLS_DIRECTORY_SYNC_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TOOLS_DIRECTORY_SYNC_H_
+
+#include "google/cloud/status_or.h"
+#include "google/cloud/storage/client.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace cloud {
+namespace storage_tools {
+/**
+ * A file in a local directory or an object under a bucket prefix.
+ *
+ * The name is relative to the directory or prefix, and always uses `/` as the
+ * separator.
+ */
+struct SyncEntry {
+  std::string name;
+  std::uint64_t size;
+  /// The base64-encoded CRC32C checksum, empty if not known.
+  std::string crc32c;
+};
+
+/// The location of objects in GCS, parsed from a `gs://bucket/prefix` URL.
+struct GcsLocation {
+  std::string bucket_name;
+  /// Empty, or ends with `/`.
+  std::string prefix;
+};
+
+/// Parses @p url as a `gs://bucket[/prefix]` location.
+StatusOr<GcsLocation> ParseGcsUrl(std::string const& url);
+
+/// Configures how a directory is synchronized.
+struct SyncOptions {
+  /// The number of threads to compute checksums and transfer files.
+  std::size_t thread_count = 16;
+  /// Files at least this large are transferred in slices.
+  std::uint64_t sliced_transfer_threshold = 256 * 1024 * 1024LL;
+  /// The number of slices for large files, at most 32.
+  std::size_t slice_count = 8;
+  /// Compute the transfers, but do not perform them.
+  bool dry_run = false;
+};
+
+/// The outcome of a synchronization.
+struct SyncResult {
+  /// The entries transferred, or that would be transferred in a dry run.
+  std::vector<SyncEntry> transferred;
+  /// The entries that failed to transfer.
+  std::vector<std::pair<SyncEntry, Status>> failed;
+  /// The number of entries that were already up to date.
+  std::size_t unchanged = 0;
+};
+
+/**
+ * Lists the regular files in @p directory and its subdirectories.
+ *
+ * The checksums are not computed, listing a large tree only requires the file
+ * metadata.
+ */
+StatusOr<std::vector<SyncEntry>> ListLocalFiles(std::string const& directory);
+
+/**
+ * Returns true if @p object is a temporary object created by a sliced upload.
+ *
+ * Sliced uploads name their parts `<object>.sync-part-<random>-<index>`, the
+ * random prefix is unique to each upload, and set the `goog-sync-part` custom
+ * metadata key on each part. Both must match, the name alone could belong to
+ * an object created by the user.
+ */
+bool IsSlicePart(storage::ObjectMetadata const& object);
+
+/**
+ * Lists the objects under @p location.
+ *
+ * Skips directory placeholders and the parts of sliced uploads. The parts
+ * created more than a day ago, which are left behind by interrupted uploads,
+ * are returned in @p stale_parts if not null.
+ */
+StatusOr<std::vector<SyncEntry>> ListObjects(
+    storage::Client client, GcsLocation const& location,
+    std::vector<std::string>* stale_parts = nullptr);
+
+/// Computes the base64-encoded CRC32C checksum of a local file.
+StatusOr<std::string> ComputeFileCrc32c(std::string const& path);
+
+/**
+ * Computes the checksum of each local file with a matching destination entry.
+ *
+ * Files with a different size (or without a destination entry) must be
+ * transferred anyway, their checksum is not needed. The remaining files are
+ * read in parallel using @p thread_count threads, stopping at the first error.
+ *
+ * @return the first error, the sync cannot proceed without all the checksums.
+ */
+Status ComputeLocalChecksums(std::string const& directory,
+                             std::vector<SyncEntry>& local,
+                             std::vector<SyncEntry> const& remote,
+                             std::size_t thread_count);
+
+/**
+ * Returns the source entries that differ from the destination.
+ *
+ * An entry is transferred if it is missing in the destination, if the sizes
+ * differ, or if the checksums are not known or differ.
+ */
+std::vector<SyncEntry> ComputeTransfers(
+    std::vector<SyncEntry> const& source,
+    std::vector<SyncEntry> const& destination);
+
+/**
+ * Mirrors the files in @p directory to the objects under @p location.
+ *
+ * Also deletes the stale parts of sliced uploads, see `ListObjects()`.
+ */
+StatusOr<SyncResult> SyncDirectoryToBucket(storage::Client client,
+                                           std::string const& directory,
+                                           GcsLocation const& location,
+                                           SyncOptions const& options);
+
+/// Mirrors the objects under @p location to the files in @p directory.
+StatusOr<SyncResult> SyncBucketToDirectory(storage::Client client,
+                                           GcsLocation const& location,
+                                           std::string const& directory,
+                                           SyncOptions const& options);
+
+}  // namespace storage_tools
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TOOLS_DIRECTORY_SYNC_H_
@@ -0,0 +1,264 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/tools/directory_sync.h"
+#include "google/cloud/internal/format_time_point.h"
+#include "google/cloud/internal/random.h"
+#include "google/cloud/storage/internal/metadata_parser.h"
+#include "google/cloud/storage/oauth2/google_credentials.h"
+#include "google/cloud/storage/testing/mock_client.h"
+#include "google/cloud/testing_util/assert_ok.h"
+#include <gmock/gmock.h>
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+
+namespace google {
+namespace cloud {
+namespace storage_tools {
+namespace {
+
+namespace gcs = ::google::cloud::storage;
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+using ::testing::ReturnRef;
+
+TEST(DirectorySyncTest, ParseGcsUrl) {
+  auto location = ParseGcsUrl("gs://my-bucket/some/prefix");
+  ASSERT_STATUS_OK(location);
+  EXPECT_EQ("my-bucket", location->bucket_name);
+  EXPECT_EQ("some/prefix/", location->prefix);
+
+  location = ParseGcsUrl("gs://my-bucket");
+  ASSERT_STATUS_OK(location);
+  EXPECT_EQ("my-bucket", location->bucket_name);
+  EXPECT_EQ("", location->prefix);
+
+  location = ParseGcsUrl("gs://my-bucket/");
+  ASSERT_STATUS_OK(location);
+  EXPECT_EQ("", location->prefix);
+
+  EXPECT_FALSE(ParseGcsUrl("/tmp/some/directory").ok());
+  EXPECT_FALSE(ParseGcsUrl("gs:///prefix").ok());
+}
+
+std::vector<std::string> Names(std::vector<SyncEntry> const& entries) {
+  std::vector<std::string> names;
+  for (auto const& e : entries) {
+    names.push_back(e.name);
+  }
+  return names;
+}
+
+TEST(DirectorySyncTest, ComputeTransfers) {
+  std::vector<SyncEntry> source{
+      {"missing", 10, "AAAAAA=="},     {"resized", 10, "AAAAAA=="},
+      {"changed", 10, "AAAAAA=="},     {"unchanged", 10, "AAAAAA=="},
+      {"no-checksum", 10, std::string{}},
+  };
+  std::vector<SyncEntry> destination{
+      {"resized", 20, "AAAAAA=="},     {"changed", 10, "BBBBBB=="},
+      {"unchanged", 10, "AAAAAA=="},   {"no-checksum", 10, std::string{}},
+      {"extraneous", 10, "AAAAAA=="},
+  };
+  EXPECT_THAT(Names(ComputeTransfers(source, destination)),
+              ElementsAre("missing", "resized", "changed", "no-checksum"));
+}
+
+gcs::ObjectMetadata MakeObject(std::string const& name, bool marked) {
+  auto object = gcs::internal::ObjectMetadataParser::FromString(
+                    R"""({"name": ")""" + name + R"""("})""")
+                    .value();
+  if (marked) {
+    object.upsert_metadata("goog-sync-part", "true");
+  }
+  return object;
+}
+
+TEST(DirectorySyncTest, IsSlicePart) {
+  EXPECT_TRUE(
+      IsSlicePart(MakeObject("b/large.bin.sync-part-abcd1234-0", true)));
+  EXPECT_TRUE(
+      IsSlicePart(MakeObject("b/large.bin.sync-part-abcd1234-31", true)));
+  EXPECT_FALSE(IsSlicePart(MakeObject("b/large.bin", true)));
+  EXPECT_FALSE(IsSlicePart(MakeObject("b/large.bin.sync-part-0", true)));
+  EXPECT_FALSE(
+      IsSlicePart(MakeObject("b/large.bin.sync-part-abcd1234-", true)));
+  EXPECT_FALSE(
+      IsSlicePart(MakeObject("b/large.bin.sync-part-abcd1234-x", true)));
+  // Objects created by the user are not parts, even if the name matches.
+  EXPECT_FALSE(
+      IsSlicePart(MakeObject("b/large.bin.sync-part-abcd1234-0", false)));
+}
+
+class DirectorySyncFilesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto generator = google::cloud::internal::MakeDefaultPRNG();
+    root_ = ::testing::TempDir() + "directory-sync-" +
+            google::cloud::internal::Sample(generator, 8,
+                                            "abcdefghijklmnopqrstuvwxyz");
+    ASSERT_EQ(0, mkdir(root_.c_str(), 0755));
+    ASSERT_EQ(0, mkdir((root_ + "/sub").c_str(), 0755));
+    WriteFile("a.txt", "The quick brown fox");
+    WriteFile("sub/b.txt", "jumps over the lazy dog");
+  }
+
+  void TearDown() override {
+    std::remove((root_ + "/sub/b.txt").c_str());
+    std::remove((root_ + "/a.txt").c_str());
+    std::remove((root_ + "/sub").c_str());
+    std::remove(root_.c_str());
+  }
+
+  void WriteFile(std::string const& name, std::string const& contents) {
+    std::ofstream(root_ + "/" + name, std::ios::binary) << contents;
+  }
+
+  std::string root_;
+};
+
+TEST_F(DirectorySyncFilesTest, ListLocalFiles) {
+  auto entries = ListLocalFiles(root_);
+  ASSERT_STATUS_OK(entries);
+  EXPECT_THAT(Names(*entries), ElementsAre("a.txt", "sub/b.txt"));
+  EXPECT_EQ(19U, (*entries)[0].size);
+  EXPECT_EQ(23U, (*entries)[1].size);
+  EXPECT_TRUE((*entries)[0].crc32c.empty());
+
+  EXPECT_EQ(StatusCode::kNotFound,
+            ListLocalFiles(root_ + "/missing").status().code());
+}
+
+TEST_F(DirectorySyncFilesTest, ComputeFileCrc32c) {
+  auto crc32c = ComputeFileCrc32c(root_ + "/a.txt");
+  ASSERT_STATUS_OK(crc32c);
+  EXPECT_EQ(gcs::ComputeCrc32cChecksum("The quick brown fox"), *crc32c);
+
+  WriteFile("empty", "");
+  crc32c = ComputeFileCrc32c(root_ + "/empty");
+  std::remove((root_ + "/empty").c_str());
+  ASSERT_STATUS_OK(crc32c);
+  EXPECT_EQ(gcs::ComputeCrc32cChecksum(""), *crc32c);
+}
+
+TEST_F(DirectorySyncFilesTest, SyncDirectoryToBucketDryRun) {
+  auto mock = std::make_shared<gcs::testing::MockClient>();
+  auto client_options =
+      gcs::ClientOptions(gcs::oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*mock, client_options())
+      .WillRepeatedly(ReturnRef(client_options));
+  EXPECT_CALL(*mock, ListObjects(_))
+      .WillOnce(Invoke([](gcs::internal::ListObjectsRequest const& r) {
+        EXPECT_EQ("test-bucket", r.bucket_name());
+        EXPECT_EQ("backup/", r.GetOption<gcs::Prefix>().value());
+        gcs::internal::ListObjectsResponse response;
+        auto const crc32c = gcs::ComputeCrc32cChecksum("The quick brown fox");
+        response.items.push_back(
+            gcs::internal::ObjectMetadataParser::FromString(
+                R"""({"name": "backup/a.txt", "size": "19", "crc32c": ")""" +
+                crc32c + R"""("})""")
+                .value());
+        // The sizes match, but the contents are different.
+        response.items.push_back(
+            gcs::internal::ObjectMetadataParser::FromString(
+                R"""({"name": "backup/sub/b.txt", "size": "23",
+                      "crc32c": "AAAAAA=="})""")
+                .value());
+        return make_status_or(response);
+      }));
+
+  gcs::Client client(std::shared_ptr<gcs::internal::RawClient>(mock),
+                     gcs::Client::NoDecorations{});
+  SyncOptions options;
+  options.dry_run = true;
+  auto result = SyncDirectoryToBucket(
+      client, root_, GcsLocation{"test-bucket", "backup/"}, options);
+  ASSERT_STATUS_OK(result);
+  EXPECT_THAT(Names(result->transferred), ElementsAre("sub/b.txt"));
+  EXPECT_TRUE(result->failed.empty());
+  EXPECT_EQ(1U, result->unchanged);
+}
+
+TEST_F(DirectorySyncFilesTest, ComputeLocalChecksumsStopsOnError) {
+  std::vector<SyncEntry> local{
+      {"a.txt", 19, {}}, {"missing", 10, {}}, {"sub/b.txt", 23, {}}};
+  auto const remote = local;
+  auto status = ComputeLocalChecksums(root_, local, remote, 1);
+  EXPECT_FALSE(status.ok());
+  EXPECT_THAT(status.message(), ::testing::HasSubstr("missing"));
+  EXPECT_EQ(gcs::ComputeCrc32cChecksum("The quick brown fox"), local[0].crc32c);
+  EXPECT_TRUE(local[2].crc32c.empty());
+}
+
+TEST_F(DirectorySyncFilesTest, SyncDirectoryToBucketDeletesStaleParts) {
+  auto mock = std::make_shared<gcs::testing::MockClient>();
+  auto client_options =
+      gcs::ClientOptions(gcs::oauth2::CreateAnonymousCredentials());
+  EXPECT_CALL(*mock, client_options())
+      .WillRepeatedly(ReturnRef(client_options));
+  EXPECT_CALL(*mock, ListObjects(_))
+      .WillOnce(Invoke([](gcs::internal::ListObjectsRequest const&) {
+        gcs::internal::ListObjectsResponse response;
+        auto add = [&response](std::string const& name,
+                               std::string const& contents,
+                               std::string const& created,
+                               bool marked = false) {
+          response.items.push_back(
+              gcs::internal::ObjectMetadataParser::FromString(
+                  R"""({"name": "backup/)""" + name + R"""(", "size": ")""" +
+                  std::to_string(contents.size()) + R"""(", "crc32c": ")""" +
+                  gcs::ComputeCrc32cChecksum(contents) +
+                  R"""(", "timeCreated": ")""" + created + R"""(")""" +
+                  (marked ? R"""(, "metadata": {"goog-sync-part": "true"})"""
+                          : "") +
+                  "}")
+                  .value());
+        };
+        auto const now = google::cloud::internal::FormatRfc3339(
+            std::chrono::system_clock::now());
+        add("a.txt", "The quick brown fox", now);
+        add("sub/b.txt", "jumps over the lazy dog", now);
+        // A part left behind by an interrupted upload, and a part from an
+        // upload that may still be running.
+        add("large.bin.sync-part-abcd1234-0", "stale", "2019-01-01T00:00:00Z",
+            true);
+        add("large.bin.sync-part-efgh5678-0", "recent", now, true);
+        // An object created by the user, with a name that looks like a part.
+        // It is not deleted.
+        add("user.sync-part-abcd1234-0", "user", "2019-01-01T00:00:00Z");
+        return make_status_or(response);
+      }));
+  EXPECT_CALL(*mock, DeleteObject(_))
+      .WillOnce(Invoke([](gcs::internal::DeleteObjectRequest const& r) {
+        EXPECT_EQ("test-bucket", r.bucket_name());
+        EXPECT_EQ("backup/large.bin.sync-part-abcd1234-0", r.object_name());
+        return make_status_or(gcs::internal::EmptyResponse{});
+      }));
+
+  gcs::Client client(std::shared_ptr<gcs::internal::RawClient>(mock),
+                     gcs::Client::NoDecorations{});
+  auto result = SyncDirectoryToBucket(
+      client, root_, GcsLocation{"test-bucket", "backup/"}, SyncOptions{});
+  ASSERT_STATUS_OK(result);
+  EXPECT_TRUE(result->transferred.empty());
+  EXPECT_TRUE(result->failed.empty());
+  EXPECT_EQ(2U, result->unchanged);
+}
+
+}  // namespace
+}  // namespace storage_tools
+}  // namespace cloud
+}  // namespace google
@@ -0,0 +1,165 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/benchmarks/benchmark_utils.h"
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/tools/directory_sync.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+namespace gcs = google::cloud::storage;
+namespace gcs_bm = google::cloud::storage_benchmarks;
+namespace gcs_tools = google::cloud::storage_tools;
+
+char const kDescription[] = R"""(
+Mirror a local directory to a GCS bucket prefix, or a bucket prefix to a local
+directory.
+
+Usage: storage_sync_directory [options] <source> <destination>
+
+One of <source> or <destination> must be a gs://bucket/prefix URL, the other a
+local directory. The program lists both sides in parallel, and transfers only
+the files that are missing in the destination, or whose size or CRC32C checksum
+differ. Files and objects that only exist in the destination are not removed.
+
+The checksums of local files are computed in parallel, and only for files with
+a matching object of the same size. Large files are transferred in slices: the
+slices of an upload are composed into the final object, and the slices of a
+download are written in place and the complete file is validated.
+)""";
+
+struct Options {
+  std::string source;
+  std::string destination;
+  gcs_tools::SyncOptions sync;
+};
+
+Options ParseArgs(int& argc, char* argv[]);
+
+}  // namespace
+
+int main(int argc, char* argv[]) try {
+  Options options = ParseArgs(argc, argv);
+
+  google::cloud::StatusOr<gcs::ClientOptions> client_options =
+      gcs::ClientOptions::CreateDefaultClientOptions();
+  if (!client_options) {
+    std::cerr << "Could not create ClientOptions, status="
+              << client_options.status() << "\n";
+    return 1;
+  }
+  client_options->set_connection_pool_size(options.sync.thread_count);
+  gcs::Client client(*std::move(client_options));
+
+  auto const start = std::chrono::steady_clock::now();
+  google::cloud::StatusOr<gcs_tools::SyncResult> result;
+  auto source = gcs_tools::ParseGcsUrl(options.source);
+  auto destination = gcs_tools::ParseGcsUrl(options.destination);
+  if (source && !destination) {
+    result = gcs_tools::SyncBucketToDirectory(
+        client, *source, options.destination, options.sync);
+  } else if (!source && destination) {
+    result = gcs_tools::SyncDirectoryToBucket(client, options.source,
+                                              *destination, options.sync);
+  } else {
+    std::cerr << "Exactly one of the source and destination must be a"
+              << " gs://bucket/prefix URL\n";
+    return 1;
+  }
+  if (!result) {
+    std::cerr << "Error synchronizing " << options.source << " to "
+              << options.destination << ": " << result.status() << "\n";
+    return 1;
+  }
+
+  std::uint64_t bytes = 0;
+  for (auto const& e : result->transferred) {
+    std::cout << (options.sync.dry_run ? "would copy " : "copied ") << e.name
+              << " (" << e.size << " bytes)\n";
+    bytes += e.size;
+  }
+  for (auto const& f : result->failed) {
+    std::cout << "FAILED " << f.first.name << ": " << f.second << "\n";
+  }
+  auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "# Transferred: " << result->transferred.size()
+            << "\n# Failed: " << result->failed.size()
+            << "\n# Unchanged: " << result->unchanged
+            << "\n# Bytes: " << bytes
+            << "\n# Elapsed (ms): " << elapsed.count() << "\n";
+  return result->failed.empty() ? 0 : 1;
+} catch (std::exception const& ex) {
+  std::cerr << "Standard exception raised: " << ex.what() << "\n";
+  return 1;
+}
+
+namespace {
+
+Options ParseArgs(int& argc, char* argv[]) {
+  Options options;
+
+  bool wants_help = false;
+  bool wants_description = false;
+  std::vector<gcs_bm::OptionDescriptor> descriptors{
+      {"--help", "print the usage message",
+       [&wants_help](std::string const&) { wants_help = true; }},
+      {"--description", "print a description of the program",
+       [&wants_description](std::string const&) { wants_description = true; }},
+      {"--thread-count", "the number of concurrent checksums and transfers",
+       [&options](std::string const& val) {
+         options.sync.thread_count = std::stoi(val);
+       }},
+      {"--sliced-transfer-threshold", "transfer larger files in slices",
+       [&options](std::string const& val) {
+         options.sync.sliced_transfer_threshold = gcs_bm::ParseSize(val);
+       }},
+      {"--slice-count", "the number of slices for large files",
+       [&options](std::string const& val) {
+         options.sync.slice_count = std::stoi(val);
+       }},
+      {"--dry-run", "only print the files that would be transferred",
+       [&options](std::string const& val) {
+         options.sync.dry_run = gcs_bm::ParseBoolean(val, true);
+       }},
+  };
+  auto usage = gcs_bm::BuildUsage(descriptors, argv[0]);
+
+  auto unparsed = gcs_bm::OptionsParse(descriptors, {argv, argv + argc});
+  if (wants_help) {
+    std::cout << usage << "\n";
+  }
+
+  if (wants_description) {
+    std::cout << kDescription << "\n";
+  }
+
+  if (unparsed.size() != 3) {
+    std::ostringstream os;
+    os << "Missing or unknown arguments\n" << usage << "\n";
+    throw std::runtime_error(std::move(os).str());
+  }
+  options.source = unparsed[1];
+  options.destination = unparsed[2];
+  if (options.sync.thread_count == 0 || options.sync.slice_count == 0) {
+    throw std::runtime_error("--thread-count and --slice-count must be > 0");
+  }
+
+  return options;
+}
+
+}  // namespace
@@ -0,0 +1,69 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRACING_SAMPLING_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRACING_SAMPLING_H_
+
+#include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstdint>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/**
+ * Selects which operations are traced when tracing is enabled.
+ *
+ * By default every operation is traced, which is useful while debugging a
+ * problem, but too expensive for applications under load. Applications can
+ * trace one in every `sample_period` operations instead, and also trace the
+ * operations that fail or are slower than `latency_threshold`. The traces are
+ * only formatted for the operations selected, the other operations only pay
+ * for a counter increment and reading the clock.
+ *
+ * Operations selected by `sample_period` are traced in full, as they execute.
+ * Operations selected because they failed or were slow are traced once they
+ * complete. For HTTP tracing these are traced as a one line summary, with the
+ * URL, the result, and the timing of the request.
+ *
+ * @see `ClientOptions::set_tracing_sampling()`.
+ */
+struct TracingSampling {
+  /// Trace one in every `sample_period` operations, zero disables sampling.
+  std::uint32_t sample_period = 1;
+
+  /// Also trace operations slower than this, zero disables this trigger.
+  std::chrono::milliseconds latency_threshold{0};
+
+  /// Also trace operations that fail.
+  bool trace_failures = true;
+
+  /**
+   * Limits the traces for operations that fail or are slow.
+   *
+   * When the service is unavailable, or overloaded, most operations fail or
+   * are slow, and tracing all of them would only add to the load. At most
+   * this many of these traces are logged each second, zero disables the
+   * limit. The traces selected by `sample_period` are not limited.
+   */
+  std::uint32_t max_completed_traces_per_second = 10;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRACING_SAMPLING_H_
@@ -0,0 +1,187 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/transfer_metrics.h"
+#include <iostream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+std::ostream& operator<<(std::ostream& os, TransferMetrics const& rhs) {
+  return os << "TransferMetrics={method=" << rhs.method << ", url=" << rhs.url
+            << ", status_code=" << rhs.status_code << ", status=" << rhs.status
+            << ", retry_attempt=" << rhs.retry_attempt
+            << ", handle_reused=" << std::boolalpha << rhs.handle_reused
+            << ", connection_reused=" << rhs.connection_reused
+            << ", bytes_sent=" << rhs.bytes_sent
+            << ", bytes_received=" << rhs.bytes_received
+            << ", name_lookup_time=" << rhs.name_lookup_time.count()
+            << "us, connect_time=" << rhs.connect_time.count()
+            << "us, tls_handshake_time=" << rhs.tls_handshake_time.count()
+            << "us, time_to_first_byte=" << rhs.time_to_first_byte.count()
+            << "us, total_time=" << rhs.total_time.count() << "us}";
+}
+
+void TransferMetricsHistogram::OnTransfer(TransferMetrics const& metrics) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!metrics.status.ok() || metrics.status_code >= 300) {
+    ++error_count_;
+  }
+  if (metrics.handle_reused) {
+    ++reused_handle_count_;
+  }
+  if (metrics.retry_attempt != 0) {
+    ++retry_count_;
+  }
+  bytes_sent_ += metrics.bytes_sent;
+  bytes_received_ += metrics.bytes_received;
+  if (metrics.connection_reused) {
+    ++reused_connection_count_;
+  } else {
+    // The setup phases are always zero for reused connections, including them
+    // would only hide the cost of creating new connections.
+    name_lookup_.Record(metrics.name_lookup_time);
+    connect_.Record(metrics.connect_time);
+    tls_handshake_.Record(metrics.tls_handshake_time);
+  }
+  first_byte_.Record(metrics.time_to_first_byte);
+  total_.Record(metrics.total_time);
+}
+
+void TransferMetricsHistogram::Dump(std::ostream& os) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  os << "# Requests: " << total_.count() << "\n# Errors: " << error_count_
+     << "\n# Retries: " << retry_count_
+     << "\n# Reused Handles: " << reused_handle_count_
+     << "\n# Reused Connections: " << reused_connection_count_
+     << "\n# Bytes Sent: " << bytes_sent_
+     << "\n# Bytes Received: " << bytes_received_
+     << "\nPhase,Count,MinUs,P50Us,P90Us,P99Us,P999Us,MaxUs\n";
+  auto dump = [&os](char const* name, internal::LatencyHistogram const& h) {
+    os << name << ',' << h.count() << ',' << h.min().count() << ','
+       << h.Percentile(50).count() << ',' << h.Percentile(90).count() << ','
+       << h.Percentile(99).count() << ',' << h.Percentile(99.9).count() << ','
+       << h.max().count() << "\n";
+  };
+  dump("NameLookup", name_lookup_);
+  dump("Connect", connect_);
+  dump("TlsHandshake", tls_handshake_);
+  dump("FirstByte", first_byte_);
+  dump("Total", total_);
+}
+
+void TransferMetricsHistogram::Clear() {
+  std::lock_guard<std::mutex> lk(mu_);
+  error_count_ = 0;
+  reused_handle_count_ = 0;
+  reused_connection_count_ = 0;
+  retry_count_ = 0;
+  bytes_sent_ = 0;
+  bytes_received_ = 0;
+  name_lookup_.Clear();
+  connect_.Clear();
+  tls_handshake_.Clear();
+  first_byte_.Clear();
+  total_.Clear();
+}
+
+std::uint64_t TransferMetricsHistogram::request_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return total_.count();
+}
+
+std::uint64_t TransferMetricsHistogram::error_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return error_count_;
+}
+
+std::uint64_t TransferMetricsHistogram::reused_handle_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return reused_handle_count_;
+}
+
+std::uint64_t TransferMetricsHistogram::reused_connection_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return reused_connection_count_;
+}
+
+std::uint64_t TransferMetricsHistogram::retry_count() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return retry_count_;
+}
+
+std::uint64_t TransferMetricsHistogram::bytes_sent() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return bytes_sent_;
+}
+
+std::uint64_t TransferMetricsHistogram::bytes_received() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return bytes_received_;
+}
+
+std::chrono::microseconds TransferMetricsHistogram::TotalTimePercentile(
+    double percentile) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return total_.Percentile(percentile);
+}
+
+std::chrono::microseconds TransferMetricsHistogram::TimeToFirstBytePercentile(
+    double percentile) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return first_byte_.Percentile(percentile);
+}
+
+namespace internal {
+namespace {
+int& RetryAttempt() {
+  static thread_local int attempt = 0;
+  return attempt;
+}
+
+long& HttpStatusCode() {
+  static thread_local long code = 0;
+  return code;
+}
+
+std::uint64_t& OverloadResponses() {
+  static thread_local std::uint64_t count = 0;
+  return count;
+}
+}  // namespace
+
+int CurrentRetryAttempt() { return RetryAttempt(); }
+
+ScopedRetryAttempt::ScopedRetryAttempt(int attempt)
+    : previous_(RetryAttempt()) {
+  RetryAttempt() = attempt;
+}
+
+ScopedRetryAttempt::~ScopedRetryAttempt() { RetryAttempt() = previous_; }
+
+long LastHttpStatusCode() { return HttpStatusCode(); }
+
+void SetLastHttpStatusCode(long code) {
+  HttpStatusCode() = code;
+  if (code == 429 || code == 503) ++OverloadResponses();
+}
+
+std::uint64_t OverloadResponseCount() { return OverloadResponses(); }
+}  // namespace internal
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
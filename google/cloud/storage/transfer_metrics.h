@@ -0,0 +1,197 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSFER_METRICS_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSFER_METRICS_H_
+
+#include "google/cloud/status.h"
+#include "google/cloud/storage/internal/latency_histogram.h"
+#include "google/cloud/storage/version.h"
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/**
+ * The metrics collected for a single HTTP request attempt.
+ *
+ * Each attempt to send a HTTP request produces one of these records, including
+ * each retry of a failed request, and each chunk of a resumable upload.
+ *
+ * The timings of the connection setup phases are durations of each phase, and
+ * are zero if the request reused an existing connection. The
+ * `time_to_first_byte` and `total_time` values are measured from the start of
+ * the request.
+ */
+struct TransferMetrics {
+  /// The HTTP method, e.g. "GET" or "POST".
+  std::string method;
+  /// The URL of the request, including any query parameters.
+  std::string url;
+  /// The HTTP status code, zero if no response was received.
+  long status_code = 0;
+  /// The result of the transfer, as reported by the HTTP library.
+  Status status;
+  /// The attempt number for this request, zero for the first attempt.
+  int retry_attempt = 0;
+  /// If true the request used a handle from the pool instead of a new handle.
+  bool handle_reused = false;
+  /// If true the request used an existing connection.
+  bool connection_reused = false;
+  /// The number of payload bytes uploaded.
+  std::uint64_t bytes_sent = 0;
+  /// The number of payload bytes downloaded.
+  std::uint64_t bytes_received = 0;
+
+  /// The time spent resolving the name of the host.
+  std::chrono::microseconds name_lookup_time{0};
+  /// The time spent establishing the TCP connection.
+  std::chrono::microseconds connect_time{0};
+  /// The time spent in the TLS handshake.
+  std::chrono::microseconds tls_handshake_time{0};
+  /// The time until the first byte of the response was received.
+  std::chrono::microseconds time_to_first_byte{0};
+  /// The total time for the request.
+  std::chrono::microseconds total_time{0};
+};
+
+std::ostream& operator<<(std::ostream& os, TransferMetrics const& rhs);
+
+/**
+ * Receives the metrics for each HTTP request attempt.
+ *
+ * Applications install an implementation of this interface using
+ * `ClientOptions::set_transfer_metrics_hook()`. The library calls
+ * `OnTransfer()` once for each request attempt, from the thread that
+ * completed the attempt, and possibly from many threads at the same time.
+ * Implementations must be thread-safe and should return quickly, as the
+ * request is not completed until `OnTransfer()` returns.
+ */
+class TransferMetricsHook {
+ public:
+  virtual ~TransferMetricsHook() = default;
+
+  virtual void OnTransfer(TransferMetrics const& metrics) = 0;
+};
+
+/**
+ * A `TransferMetricsHook` that aggregates the metrics in histograms.
+ *
+ * @par Example
+ * @code
+ * auto histogram = std::make_shared<gcs::TransferMetricsHistogram>();
+ * auto options = gcs::ClientOptions::CreateDefaultClientOptions();
+ * options->set_transfer_metrics_hook(histogram);
+ * gcs::Client client(*std::move(options));
+ * // ... use `client` ...
+ * histogram->Dump(std::cout);
+ * @endcode
+ */
+class TransferMetricsHistogram : public TransferMetricsHook {
+ public:
+  TransferMetricsHistogram() = default;
+
+  void OnTransfer(TransferMetrics const& metrics) override;
+
+  /// Print the number of requests, and the percentiles for each phase.
+  void Dump(std::ostream& os) const;
+
+  /// Discard all the metrics collected so far.
+  void Clear();
+
+  std::uint64_t request_count() const;
+  std::uint64_t error_count() const;
+  std::uint64_t reused_handle_count() const;
+  std::uint64_t reused_connection_count() const;
+  std::uint64_t retry_count() const;
+  std::uint64_t bytes_sent() const;
+  std::uint64_t bytes_received() const;
+
+  /// Returns the given @p percentile of the total request time.
+  std::chrono::microseconds TotalTimePercentile(double percentile) const;
+
+  /// Returns the given @p percentile of the time to the first byte.
+  std::chrono::microseconds TimeToFirstBytePercentile(double percentile) const;
+
+ private:
+  mutable std::mutex mu_;
+  std::uint64_t error_count_ = 0;              // GUARDED_BY(mu_)
+  std::uint64_t reused_handle_count_ = 0;      // GUARDED_BY(mu_)
+  std::uint64_t reused_connection_count_ = 0;  // GUARDED_BY(mu_)
+  std::uint64_t retry_count_ = 0;              // GUARDED_BY(mu_)
+  std::uint64_t bytes_sent_ = 0;               // GUARDED_BY(mu_)
+  std::uint64_t bytes_received_ = 0;           // GUARDED_BY(mu_)
+  internal::LatencyHistogram name_lookup_;     // GUARDED_BY(mu_)
+  internal::LatencyHistogram connect_;         // GUARDED_BY(mu_)
+  internal::LatencyHistogram tls_handshake_;   // GUARDED_BY(mu_)
+  internal::LatencyHistogram first_byte_;      // GUARDED_BY(mu_)
+  internal::LatencyHistogram total_;           // GUARDED_BY(mu_)
+};
+
+namespace internal {
+/**
+ * Returns the attempt number of the operation retried by the current thread.
+ *
+ * The retry loops set this value so the metrics for each request attempt can
+ * report it, zero outside any retry loop.
+ */
+int CurrentRetryAttempt();
+
+/// Sets the value returned by `CurrentRetryAttempt()` during its lifetime.
+class ScopedRetryAttempt {
+ public:
+  explicit ScopedRetryAttempt(int attempt);
+  ~ScopedRetryAttempt();
+
+  ScopedRetryAttempt(ScopedRetryAttempt const&) = delete;
+  ScopedRetryAttempt& operator=(ScopedRetryAttempt const&) = delete;
+
+ private:
+  int previous_;
+};
+
+/**
+ * Returns the HTTP status code of the last request made by the current thread.
+ *
+ * The libcurl transport sets this value after each request, zero if the
+ * request did not receive a response. Decorators use it to tell apart errors
+ * with the same `StatusCode`, for example, HTTP 503 and a dropped connection
+ * are both reported as `kUnavailable`.
+ */
+long LastHttpStatusCode();
+
+/// Sets the value returned by `LastHttpStatusCode()`.
+void SetLastHttpStatusCode(long code);
+
+/**
+ * Returns the number of overload responses received by the current thread.
+ *
+ * Counts the HTTP 429 and 503 responses passed to `SetLastHttpStatusCode()`.
+ * The retry loops hide these errors when a later attempt succeeds, callers
+ * compare the value before and after an operation to detect them.
+ */
+std::uint64_t OverloadResponseCount();
+}  // namespace internal
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSFER_METRICS_H_
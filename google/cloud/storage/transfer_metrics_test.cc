@@ -0,0 +1,113 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "google/cloud/storage/transfer_metrics.h"
+#include <gmock/gmock.h>
+#include <sstream>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+namespace {
+
+using ::testing::HasSubstr;
+using us = std::chrono::microseconds;
+
+TransferMetrics MakeMetrics(std::chrono::microseconds total,
+                            bool connection_reused) {
+  TransferMetrics metrics;
+  metrics.method = "GET";
+  metrics.url = "https://storage.googleapis.com/storage/v1/b/test-bucket";
+  metrics.status_code = 200;
+  metrics.connection_reused = connection_reused;
+  metrics.handle_reused = connection_reused;
+  metrics.bytes_sent = 10;
+  metrics.bytes_received = 100;
+  if (!connection_reused) {
+    metrics.name_lookup_time = us(100);
+    metrics.connect_time = us(200);
+    metrics.tls_handshake_time = us(300);
+  }
+  metrics.time_to_first_byte = total / 2;
+  metrics.total_time = total;
+  return metrics;
+}
+
+TEST(TransferMetricsTest, OutputStream) {
+  std::ostringstream os;
+  os << MakeMetrics(us(1000), false);
+  auto actual = os.str();
+  EXPECT_THAT(actual, HasSubstr("method=GET"));
+  EXPECT_THAT(actual, HasSubstr("status_code=200"));
+  EXPECT_THAT(actual, HasSubstr("connection_reused=false"));
+  EXPECT_THAT(actual, HasSubstr("total_time=1000us"));
+}
+
+TEST(TransferMetricsHistogramTest, Aggregates) {
+  TransferMetricsHistogram histogram;
+  for (int i = 1; i <= 10; ++i) {
+    histogram.OnTransfer(MakeMetrics(us(i * 1000), i % 2 == 0));
+  }
+  auto failed = MakeMetrics(us(20000), true);
+  failed.status_code = 503;
+  failed.retry_attempt = 1;
+  histogram.OnTransfer(failed);
+
+  EXPECT_EQ(11U, histogram.request_count());
+  EXPECT_EQ(1U, histogram.error_count());
+  EXPECT_EQ(1U, histogram.retry_count());
+  EXPECT_EQ(6U, histogram.reused_handle_count());
+  EXPECT_EQ(6U, histogram.reused_connection_count());
+  EXPECT_EQ(110U, histogram.bytes_sent());
+  EXPECT_EQ(1100U, histogram.bytes_received());
+  EXPECT_NEAR(6000, histogram.TotalTimePercentile(50).count(), 6000 / 32);
+  EXPECT_EQ(20000, histogram.TotalTimePercentile(100).count());
+  EXPECT_NEAR(3000, histogram.TimeToFirstBytePercentile(50).count(),
+              3000 / 32);
+
+  std::ostringstream os;
+  histogram.Dump(os);
+  auto dump = os.str();
+  EXPECT_THAT(dump, HasSubstr("# Requests: 11"));
+  EXPECT_THAT(dump, HasSubstr("# Errors: 1"));
+  // Only the requests that created a connection contribute to the setup
+  // phases.
+  EXPECT_THAT(dump, HasSubstr("NameLookup,5,100,100"));
+  EXPECT_THAT(dump, HasSubstr("Total,11,"));
+
+  histogram.Clear();
+  EXPECT_EQ(0U, histogram.request_count());
+  EXPECT_EQ(0U, histogram.bytes_received());
+}
+
+TEST(TransferMetricsTest, ScopedRetryAttempt) {
+  EXPECT_EQ(0, internal::CurrentRetryAttempt());
+  {
+    internal::ScopedRetryAttempt outer(2);
+    EXPECT_EQ(2, internal::CurrentRetryAttempt());
+    {
+      internal::ScopedRetryAttempt inner(0);
+      EXPECT_EQ(0, internal::CurrentRetryAttempt());
+    }
+    EXPECT_EQ(2, internal::CurrentRetryAttempt());
+  }
+  EXPECT_EQ(0, internal::CurrentRetryAttempt());
+}
+
+}  // namespace
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
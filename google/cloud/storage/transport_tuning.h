@@ -0,0 +1,65 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSPORT_TUNING_H_
+#define GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSPORT_TUNING_H_
+
+#include "google/cloud/storage/version.h"
+#include <cstddef>
+
+namespace google {
+namespace cloud {
+namespace storage {
+inline namespace STORAGE_CLIENT_NS {
+/**
+ * Tuning parameters for the sockets and buffers used in HTTP transfers.
+ *
+ * The defaults of the operating system and libcurl work well for most
+ * applications. On links with a large bandwidth-delay product, such as
+ * cross-region transfers, larger socket buffers may be needed to reach the
+ * link speed. A value of zero keeps the default.
+ *
+ * The socket options are set when a new connection is created, connections
+ * already in the pool keep the values they were created with.
+ *
+ * @see `ClientOptions::set_download_tuning()` and
+ *     `ClientOptions::set_upload_tuning()`.
+ */
+struct TransportTuning {
+  /**
+   * The size of the libcurl buffer for the transfer.
+   *
+   * For downloads this is `CURLOPT_BUFFERSIZE`, limited by libcurl to the
+   * [1 KiB, 512 KiB] range. For uploads this is `CURLOPT_UPLOAD_BUFFERSIZE`,
+   * limited to the [16 KiB, 2 MiB] range, and ignored with libcurl versions
+   * before 7.62.0.
+   */
+  std::size_t curl_buffer_size = 0;
+
+  /// The socket receive buffer size (`SO_RCVBUF`).
+  std::size_t socket_receive_buffer_size = 0;
+
+  /// The socket send buffer size (`SO_SNDBUF`).
+  std::size_t socket_send_buffer_size = 0;
+
+  /// Disable Nagle's algorithm (`TCP_NODELAY`), this is the libcurl default.
+  bool tcp_nodelay = true;
+};
+
+}  // namespace STORAGE_CLIENT_NS
+}  // namespace storage
+}  // namespace cloud
+}  // namespace google
+
+#endif  // GOOGLE_CLOUD_CPP_GOOGLE_CLOUD_STORAGE_TRANSPORT_TUNING_H_
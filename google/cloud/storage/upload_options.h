@@ -50,6 +50,28 @@ inline UseResumableUploadSession NewResumableUploadSession() {
   return UseResumableUploadSession("");
 }
 
+/**
+ * Compress the data with gzip while it is uploaded.
+ *
+ * When this option is set to `true` the client library compresses the data in
+ * the gzip format as it is written, and sets the object `contentEncoding` to
+ * `gzip`. The compression runs on a separate thread, so the compression of
+ * each chunk overlaps with the upload of the previous one. This is useful for
+ * large, highly compressible, objects such as text logs.
+ *
+ * The MD5 hash and CRC32C checksum of the object are computed over the
+ * compressed data, because that is what the service stores. Any pre-computed
+ * `MD5HashValue` or `Crc32cChecksumValue` must also refer to the compressed
+ * data.
+ *
+ * @note Compressed uploads always use resumable upload sessions, but they
+ *   cannot be restored from a previous session.
+ */
+struct GzipCompression : public internal::ComplexOption<GzipCompression, bool> {
+  using ComplexOption<GzipCompression, bool>::ComplexOption;
+  static char const* name() { return "gzip-compression"; }
+};
+
 }  // namespace STORAGE_CLIENT_NS
 }  // namespace storage
 }  // namespace cloud